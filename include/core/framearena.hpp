@@ -0,0 +1,155 @@
+/*
+Copyright 2009-2021 Nicolas Colombe
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <core/corelibexp.hpp>
+#include <core/coredef.hpp>
+#include <core/containers.hpp>
+
+#include <atomic>
+#include <mutex>
+
+namespace eXl
+{
+  //Linear allocator for temporaries that do not outlive a frame. Allocations are a bump of an offset,
+  //nothing is freed until Reset(). Alloc can be called from several threads, Reset cannot.
+  class EXL_CORE_API FrameArena
+  {
+  public:
+
+    FrameArena(size_t iBlockSize = 1 << 20);
+    ~FrameArena();
+
+    FrameArena(FrameArena const&) = delete;
+    FrameArena& operator=(FrameArena const&) = delete;
+
+    void* Alloc(size_t iSize, size_t iAlignment = 16);
+
+    //Invalidates everything allocated since the last Reset. When the frame needed several blocks,
+    //they are merged so that the next frame fits in one. In debug, the released memory is poisoned.
+    void Reset();
+
+    //Incremented by Reset, allocators check it to catch containers kept past their frame.
+    uint32_t GetGeneration() const { return m_Generation; }
+
+    size_t GetAllocatedBytes() const;
+    size_t GetCapacity() const;
+
+  protected:
+
+    struct alignas(16) Block
+    {
+      char* GetData() { return reinterpret_cast<char*>(this + 1); }
+
+      Block* m_Prev;
+      size_t m_Size;
+      std::atomic<size_t> m_Offset;
+    };
+
+    Block* Grow(Block* iFull, size_t iMinSize);
+    static Block* AllocBlock(size_t iSize, Block* iPrev);
+
+    std::atomic<Block*> m_Current;
+    std::mutex m_GrowLock;
+    size_t const m_BlockSize;
+    uint32_t m_Generation = 0;
+  };
+
+  //Allocator for containers living in a FrameArena. Deallocation does nothing, the memory comes back on Reset.
+  template<typename T>
+  class FrameAllocator
+  {
+  public:
+    typedef T value_type;
+    typedef value_type* pointer;
+    typedef const value_type* const_pointer;
+    typedef value_type& reference;
+    typedef const value_type& const_reference;
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef std::integral_constant<bool, true> propagate_on_container_copy_assignment;
+    typedef std::integral_constant<bool, true> propagate_on_container_move_assignment;
+    typedef std::integral_constant<bool, true> propagate_on_container_swap;
+    typedef std::integral_constant<bool, false> is_always_equal;
+
+    template<typename U>
+    struct rebind
+    {
+      typedef FrameAllocator<U> other;
+    };
+
+    inline FrameAllocator(FrameArena& iArena)
+      : m_Arena(&iArena)
+#ifdef _DEBUG
+      , m_Generation(iArena.GetGeneration())
+#endif
+    {}
+
+    template<typename U>
+    inline FrameAllocator(FrameAllocator<U> const& iOther)
+      : m_Arena(iOther.m_Arena)
+#ifdef _DEBUG
+      , m_Generation(iOther.m_Generation)
+#endif
+    {}
+
+    inline pointer allocate(size_type cnt)
+    {
+      CheckGeneration();
+      size_t const alignment = alignof(T) > 16 ? alignof(T) : 16;
+      return reinterpret_cast<pointer>(m_Arena->Alloc(sizeof(T) * cnt, alignment));
+    }
+
+    inline void deallocate(pointer, size_type)
+    {
+      CheckGeneration();
+    }
+
+    inline size_type max_size() const
+    {
+      return std::numeric_limits<size_type>::max() / sizeof(T);
+    }
+
+    template <typename... U>
+    inline void construct(pointer p, U&&... u) { new(p) T(std::forward<U>(u)...); }
+    inline void destroy(pointer p) { p->~T(); }
+
+    template<typename U>
+    friend bool operator==(FrameAllocator const& iA, FrameAllocator<U> const& iB) { return iA.m_Arena == iB.m_Arena; }
+    template<typename U>
+    friend bool operator!=(FrameAllocator const& iA, FrameAllocator<U> const& iB) { return iA.m_Arena != iB.m_Arena; }
+
+  protected:
+    template<typename U>
+    friend class FrameAllocator;
+
+    inline void CheckGeneration() const
+    {
+#ifdef _DEBUG
+      eXl_ASSERT_MSG(m_Generation == m_Arena->GetGeneration(), "Frame container used after the end of its frame");
+#endif
+    }
+
+    FrameArena* m_Arena;
+#ifdef _DEBUG
+    uint32_t m_Generation;
+#endif
+  };
+
+  template <class T>
+  using FrameVector = std::vector<T, FrameAllocator<T>>;
+
+  template <class Key, class Value, class Cmp = std::less<Key> >
+  using FrameMap = std::map<Key, Value, Cmp, FrameAllocator<std::pair<const Key, Value>>>;
+
+  template <class Key, class Value, class Hash = boost::hash<Key>, class Pred = std::equal_to<Key>>
+  using FrameUnorderedMap = boost::unordered_map<Key, Value, Hash, Pred, FrameAllocator<std::pair<const Key, Value>>>;
+}
@@ -15,6 +15,8 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 namespace eXl
 {
+  class JobSystem;
+
   class EXL_CORE_API Image : public HeapObject
   {
   public:
@@ -64,8 +66,17 @@ namespace eXl
     }
     ~Image();
 
-    //iFilter must be a Float:R image
-    void Convolve(Image const& iFilter, Vec2i const& iFilterOffset);
+    //iFilter must be a Float:R image, applied to every channel. Pixels the filter does not fully cover are left as is.
+    //Separable filters are detected and applied as a row pass then a column pass. Rows are split among iJobs when given.
+    void Convolve(Image const& iFilter, Vec2i const& iFilterOffset, JobSystem* iJobs = nullptr);
+    //Same as Convolve with the outer product of iColFilter and iRowFilter.
+    void ConvolveSeparable(float const* iRowFilter, unsigned int iRowSize, int iRowOffset,
+                           float const* iColFilter, unsigned int iColSize, int iColOffset, JobSystem* iJobs = nullptr);
+
+    //Channels are swizzled, missing ones are 0 and alpha is 1. Values are rescaled to the destination format's range, Float being [0, 1].
+    Image Convert(Components iComp, Format iFormat, JobSystem* iJobs = nullptr) const;
+    //Multiplies the color channels by alpha, only RGBA and BGRA images are affected.
+    void Premultiply(JobSystem* iJobs = nullptr);
 
     size_t GetByteSize() const;
     size_t GetPixelSize() const;
@@ -41,6 +41,8 @@ namespace eXl
 {  
   /**
      Class registering every allocation done with eXl_ALLOC,eXl_NEW to trace memory leaks.
+     Blocks up to 16KB come from size classes, served by per-thread caches refilled from a shared depot.
+     Bigger blocks go directly to the function set with SetAllocFn.
   **********************************************************************/
   class EXL_CORE_API MemoryManager
   {
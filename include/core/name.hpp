@@ -44,6 +44,25 @@ MAKE_NAME_TYPE(NameType)
 
 namespace eXl
 {
+  // Interned strings are stored right after this header, which lets a KString coming
+  // from a NameAllocHolder give back its hash without reading the characters again.
+  struct NameHeader
+  {
+    size_t m_Hash;
+    size_t m_Size;
+  };
+
+  // FNV-1a, usable at compile time for name literals.
+  constexpr size_t HashNameString(Char const* iStr, size_t iSize)
+  {
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < iSize; ++i)
+    {
+      hash = (hash ^ uint8_t(iStr[i])) * 1099511628211ull;
+    }
+    return size_t(hash);
+  }
+
   struct EXL_CORE_API NameAllocHolder
   {
     NameAllocHolder();
@@ -73,6 +92,8 @@ namespace eXl
 
     Optional<KString> GetExistingString(KString iStr);
     KString InsertString(KString iStr);
+    // Copies the string and its header in the pages, without indexing it.
+    KString AllocString(KString iStr, size_t iHash);
 
     UnorderedSet<KString> m_Strings;
     Vector<Page> m_Pages;
@@ -156,6 +177,19 @@ namespace eXl
 
 namespace eXl
 {
+  // String literal hashed at compile time.
+  struct NameLiteral
+  {
+    template <size_t N>
+    constexpr NameLiteral(Char const (&iStr)[N])
+      : m_Str(iStr, N - 1)
+      , m_Hash(HashNameString(iStr, N - 1))
+    {}
+
+    KString m_Str;
+    size_t m_Hash;
+  };
+
   struct EXL_CORE_API Name
   {
     Name();
@@ -164,6 +198,7 @@ namespace eXl
     {}
     Name(String const& iStr);
     Name(Char const* iStr);
+    explicit Name(NameLiteral const& iLiteral);
     Name& operator=(Char const* iStr);
     bool operator == (Name const& iOther) const { return c_str() == iOther.c_str(); }
     bool operator != (Name const& iOther) const { return !(*this == iOther); }
@@ -179,14 +214,44 @@ namespace eXl
       return m_Str.data();
     }
 
+    size_t GetHash() const
+    {
+      return m_Str.data() ? (reinterpret_cast<NameHeader const*>(m_Str.data()) - 1)->m_Hash : 0;
+    }
+
+    // Interns a batch of strings, eg. the names gathered when baking assets, growing the table once.
+    static void PreIntern(Vector<KString> const& iStrings);
+    static Vector<KString> GetInternedStrings();
+
   private:
     KString m_Str;
   };
 
   inline size_t hash_value(Name const& iName)
   {
-    return boost::hash_value((void*)iName.c_str());
+    return iName.GetHash();
   }
+
+  // Name built from a literal, interned at startup (or on construction once names are initialized).
+  class EXL_CORE_API StaticName
+  {
+  public:
+    StaticName(NameLiteral const& iLiteral);
+    ~StaticName();
+    StaticName(StaticName const&) = delete;
+    StaticName& operator=(StaticName const&) = delete;
+
+    Name const& Get() const { return m_Name; }
+    operator Name const& () const { return m_Name; }
+
+    static void RegisterAll();
+    static void UnregisterAll();
+
+  private:
+    NameLiteral m_Literal;
+    Name m_Name;
+    StaticName* m_Next;
+  };
 }
 
 #endif
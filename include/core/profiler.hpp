@@ -0,0 +1,120 @@
+/*
+Copyright 2009-2021 Nicolas Colombe
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <core/corelibexp.hpp>
+#include <core/containers.hpp>
+#include <core/path.hpp>
+
+#include <iosfwd>
+
+namespace eXl
+{
+  //Frame profiler. Zones and counters are recorded lock-free into a ring buffer owned by the
+  //recording thread, and gathered into frames by NextFrame().
+  //Names are not copied, they must outlive the recorded frames (literals, or InternName()).
+  class EXL_CORE_API Profiler
+  {
+  public:
+
+    struct Event
+    {
+      enum Kind : uint8_t
+      {
+        Zone,
+        Counter
+      };
+
+      char const* m_Name;
+      //Clock timestamps, m_End is only meaningful for zones.
+      uint64_t m_Start;
+      uint64_t m_End;
+      int64_t m_Value;
+      uint32_t m_Thread;
+      uint16_t m_Depth;
+      Kind m_Kind;
+    };
+
+    struct Frame
+    {
+      uint64_t m_Start;
+      uint64_t m_End;
+      Vector<Event> m_Events;
+    };
+
+    static void Enable(bool iEnabled);
+    static bool IsEnabled();
+
+    static void BeginZone(char const* iName);
+    static void EndZone();
+    static void SetCounter(char const* iName, int64_t iValue);
+
+    //Names the calling thread in the traces.
+    static void SetThreadName(KString iName);
+    static Vector<String> GetThreadNames();
+
+    //Returns a pointer which stays valid until the end of the program.
+    static char const* InternName(KString iName);
+
+    //Closes the current frame with everything recorded since the previous call.
+    //Must be called from a single thread.
+    static void NextFrame();
+
+    //Last closed frames, oldest first.
+    static Vector<Frame> const& GetFrames();
+    static void SetMaxFrames(uint32_t iNumFrames);
+
+    //Events dropped because a thread filled its buffer between two frames.
+    static uint32_t GetNumDroppedEvents();
+
+    //Chrome trace event format, for about:tracing or Perfetto.
+    static void WriteChromeTrace(Vector<Frame> const& iFrames, std::ostream& oStream);
+    static Err WriteChromeTrace(Vector<Frame> const& iFrames, Path const& iPath);
+
+    //Records the next iNumFrames frames and writes them to iPath. Enables the profiler.
+    static void CaptureFrames(uint32_t iNumFrames, Path const& iPath);
+    static bool IsCapturing();
+  };
+
+  class ProfileZone
+  {
+  public:
+    ProfileZone(char const* iName)
+      : m_Active(Profiler::IsEnabled())
+    {
+      if (m_Active)
+      {
+        Profiler::BeginZone(iName);
+      }
+    }
+    ~ProfileZone()
+    {
+      if (m_Active)
+      {
+        Profiler::EndZone();
+      }
+    }
+    ProfileZone(ProfileZone const&) = delete;
+    ProfileZone& operator=(ProfileZone const&) = delete;
+  private:
+    bool m_Active;
+  };
+}
+
+#ifndef EXL_NO_PROFILER
+#define eXl_PROFILE_CONCAT_IMPL(a, b) a##b
+#define eXl_PROFILE_CONCAT(a, b) eXl_PROFILE_CONCAT_IMPL(a, b)
+#define eXl_PROFILE_ZONE(Name) eXl::ProfileZone eXl_PROFILE_CONCAT(eXl_profileZone_, __LINE__)(Name)
+#define eXl_PROFILE_COUNTER(Name, Value) do { if (eXl::Profiler::IsEnabled()) { eXl::Profiler::SetCounter(Name, Value); } } while(false)
+#else
+#define eXl_PROFILE_ZONE(Name)
+#define eXl_PROFILE_COUNTER(Name, Value) do {} while(false)
+#endif
@@ -90,6 +90,7 @@ namespace eXl
       LockPathDirectory = 1 << 0,
       BakedResource = 1 << 1,
       SystemResource = 1 << 2,
+      BinaryResource = 1 << 3,
     };
 
     struct Header
@@ -68,7 +68,8 @@ namespace eXl
     EXL_CORE_API Err SetPath(Resource* iRsc, Path const& iPath);
     EXL_CORE_API Err SaveTo(Resource* iRsc, Path const& iPath);
     EXL_CORE_API Err Save(Resource* iRsc);
-    EXL_CORE_API void Bake(Path const& iDest);
+    //iBinary : write the assets with BinaryStreamer, the manifest stays in JSON.
+    EXL_CORE_API void Bake(Path const& iDest, bool iBinary = false);
     template <typename T>
     T* Load(Path const& iPath)
     {
@@ -0,0 +1,96 @@
+/*
+Copyright 2009-2021 Nicolas Colombe
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <core/stream/streamer.hpp>
+
+#include <ostream>
+
+namespace eXl
+{
+  //Compact binary counterpart of JSONStreamer.
+  //Keys are interned in a table written in front of the data, and referenced by index.
+  //Structs and sequences are prefixed with their byte size and element count, so that a reader can skip them.
+  //The output is buffered and only written to the stream by End().
+  class EXL_CORE_API BinaryStreamer : public Streamer
+  {
+  public:
+
+    static constexpr uint8_t s_Magic[4] = {'e', 'X', 'l', 'B'};
+    static constexpr uint8_t s_Version = 1;
+
+    enum Tag : uint8_t
+    {
+      BoolFalseTag,
+      BoolTrueTag,
+      IntTag,
+      UIntTag,
+      FloatTag,
+      DoubleTag,
+      StringTag,
+      BinaryTag,
+      StructTag,
+      SequenceTag,
+    };
+
+    BinaryStreamer(std::ostream* iOutStream);
+
+    Err Begin() override;
+    Err End() override;
+
+    Err PushKey(KString iKey) override;
+    Err PopKey() override;
+
+    Err BeginSequence() override;
+    Err EndSequence() override;
+
+    Err BeginStruct() override;
+    Err EndStruct() override;
+
+    Err WriteBool(bool const* iBoolean) override;
+    Err WriteInt(int const* iInt) override;
+    Err WriteUInt(unsigned int const* iUInt) override;
+    Err WriteUInt64(uint64_t const* iUInt) override;
+    Err WriteFloat(float const* iFloat) override;
+    Err WriteDouble(double const* iDouble) override;
+    Err WriteString(Char const* iStr) override;
+    Err WriteString(KString const& iStr) override;
+    Err WriteBinary(uint8_t const* iData, size_t iSize) override;
+    Err WriteBinary(std::istream* iStream, Optional<size_t> iLen) override;
+
+  protected:
+
+    struct Container
+    {
+      uint32_t m_Offset;
+      uint32_t m_Count;
+      bool m_Sequence;
+    };
+
+    Err ElementPrologue();
+    Err BeginContainer(bool iSequence);
+    Err EndContainer(bool iSequence);
+
+    void WriteVarUInt(uint64_t iValue);
+    void WriteRaw(void const* iData, size_t iSize);
+
+    Vector<uint8_t> m_Body;
+    Vector<Container> m_Containers;
+    Vector<String> m_Keys;
+    UnorderedMap<String, uint32_t> m_KeysIdx;
+    //Offset of the last pushed key, until its value is written.
+    Optional<size_t> m_PendingKey;
+    bool m_RootWritten = false;
+    bool m_StreamFailed = false;
+
+    std::ostream* m_OutStream;
+  };
+}
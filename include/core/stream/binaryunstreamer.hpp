@@ -0,0 +1,84 @@
+/*
+Copyright 2009-2021 Nicolas Colombe
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <core/stream/unstreamer.hpp>
+
+namespace eXl
+{
+  //Reads the output of BinaryStreamer from a memory range, which must outlive the unstreamer.
+  //Numeric values can be read as any numeric type, like with JSONUnstreamer.
+  class EXL_CORE_API BinaryUnstreamer : public Unstreamer
+  {
+  public:
+
+    BinaryUnstreamer(uint8_t const* iData, size_t iSize);
+
+    //Checks the format magic.
+    static bool IsBinary(void const* iData, size_t iSize);
+
+    Err Begin() override;
+    Err End() override;
+
+    Err PushKey(KString iKey) override;
+    Err PopKey() override;
+
+    Err BeginStruct() override;
+    Err EndStruct() override;
+
+    Err BeginSequence() override;
+    Err NextSequenceElement() override;
+
+    Err ReadBool(bool* oBoolean) override;
+    Err ReadInt(int * oInt) override;
+    Err ReadUInt(unsigned int * oUInt) override;
+    Err ReadUInt64(uint64_t * oUInt) override;
+    Err ReadFloat(float * oFloat) override;
+    Err ReadDouble(double * oDouble) override;
+    Err ReadString(String* oStr) override;
+    Err ReadBinary(Vector<uint8_t>* oData) override;
+
+  protected:
+
+    struct Cursor
+    {
+      Cursor(size_t iOffset) : m_Offset(iOffset) {}
+      size_t m_Offset;
+      int    m_SeqIdx = -1;
+    };
+
+    struct Container
+    {
+      size_t   m_Content;
+      size_t   m_End;
+      uint32_t m_Count;
+    };
+
+    bool ReadVarUInt(size_t& ioOffset, uint64_t& oValue);
+    bool ReadFixed(size_t& ioOffset, uint32_t iSize, uint64_t& oValue);
+    bool GetContainer(size_t iOffset, uint8_t iTag, Container& oContainer);
+    bool SkipElement(size_t& ioOffset);
+    uint8_t CurrentTag();
+
+    //Numeric value of the current element, with the tag it was written with.
+    bool ReadNumber(uint8_t& oTag, uint64_t& oBits);
+
+    Err Fail();
+
+    uint8_t const* m_Data;
+    size_t m_Size;
+
+    UnorderedMap<KString, uint32_t> m_KeysIdx;
+    Vector<Cursor> m_Stack;
+
+    bool m_FailStatus = false;
+  };
+}
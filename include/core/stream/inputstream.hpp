@@ -101,12 +101,15 @@ namespace eXl
     Char peek() override;
     size_t getPos() override;
     void setPos(size_t) override;
+    //Reads the whole stream on the first call.
+    KString GetView() const override;
 
   protected:
 
     void EnsureBuffer(size_t iDesiredOffset);
 
     std::unique_ptr<InputStream> m_Stream;
+    mutable Vector<char> m_Content;
     size_t m_CurOffset = 0;
     size_t m_BufferedOffset = -1;
     static constexpr size_t s_BufferSize = 256;
@@ -36,6 +36,8 @@ namespace eXl
     virtual Char peek() = 0;
     virtual size_t getPos() = 0;
     virtual void setPos(size_t) = 0;
+    //Whole content, when it is available in memory.
+    virtual KString GetView() const { return KString(); }
     bool eof() const { return m_IsEof; };
     bool good() const { return m_isGood; }
   protected:
@@ -59,6 +61,7 @@ namespace eXl
     Char peek() override;
     size_t getPos() override;
     void setPos(size_t) override;
+    KString GetView() const override { return KString(m_FileBegin, m_FileEnd - m_FileBegin); }
 
   protected:
 
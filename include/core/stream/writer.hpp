@@ -30,4 +30,14 @@ namespace eXl
 
     std::ostream& m_Stream;
   };
+
+  //Requests the binary format from the loaders that support it.
+  class EXL_CORE_API BinaryWriter : public StdOutWriter
+  {
+    DECLARE_RTTI(BinaryWriter, StdOutWriter);
+  public:
+    BinaryWriter(std::ostream& stream)
+      : StdOutWriter(stream)
+    {}
+  };
 }
\ No newline at end of file
@@ -0,0 +1,105 @@
+/*
+Copyright 2009-2021 Nicolas Colombe
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <core/corelibexp.hpp>
+#include <core/containers.hpp>
+
+#include <atomic>
+#include <functional>
+
+namespace eXl
+{
+  class JobSystem;
+  class JobSystem_Impl;
+  struct Job;
+
+  using JobFunction = std::function<void()>;
+
+  //Counts the jobs that still have to complete.
+  //Jobs can be made dependent on a counter, they are scheduled once it reaches 0.
+  class EXL_CORE_API JobCounter
+  {
+    friend JobSystem;
+    friend JobSystem_Impl;
+  public:
+
+    JobCounter() = default;
+    JobCounter(JobCounter const&) = delete;
+    JobCounter& operator=(JobCounter const&) = delete;
+    ~JobCounter();
+
+    bool IsDone() const { return m_Pending.load(std::memory_order_acquire) == 0; }
+
+  protected:
+
+    void Increment();
+    void Decrement();
+
+    //The waiting list is guarded by the high bit of m_Pending, so that the last decrement
+    //releases the lock and publishes completion with a single atomic operation.
+    //Once IsDone() returns true, no job touches the counter anymore and it can be destroyed.
+    static constexpr uint32_t s_LockBit = 1u << 31;
+    uint32_t LockWaitingList();
+
+    std::atomic<uint32_t> m_Pending = {0};
+    Vector<Job*> m_WaitingJobs;
+  };
+
+  //Fixed pool of workers, each one owning a deque of jobs.
+  //Workers pop from the back of their own deque and steal from the front of the others.
+  //A thread waiting on a counter executes jobs until the counter is done.
+  class EXL_CORE_API JobSystem
+  {
+  public:
+
+    //iNumWorkers == 0 -> GetHardwareConcurrency() - 1 workers, the calling thread being the last one.
+    JobSystem(uint32_t iNumWorkers = 0);
+    ~JobSystem();
+
+    JobSystem(JobSystem const&) = delete;
+    JobSystem& operator=(JobSystem const&) = delete;
+
+    //Process-wide instance, created on first use.
+    static JobSystem& GetDefault();
+
+    //Number of threads that can execute jobs, including the thread waiting on them.
+    uint32_t GetNumThreads() const;
+
+    //Index of the current thread, in [0, GetNumThreads()[. Threads outside of the pool get 0.
+    uint32_t GetCurrentThreadIndex() const;
+
+    //iCounter (optional) is incremented now and decremented once the job has run.
+    //iDependency (optional) must reach 0 before the job is scheduled.
+    void Submit(JobFunction&& iJob, JobCounter* iCounter = nullptr, JobCounter* iDependency = nullptr);
+
+    //Runs jobs on the calling thread until iCounter is done.
+    void Wait(JobCounter& iCounter);
+
+    //Splits [iBegin, iEnd[ in chunks of at most iGrainSize elements and waits for all of them.
+    //iFunction receives the chunk's [begin, end[ and the chunk index.
+    void ParallelFor(uint32_t iBegin, uint32_t iEnd, uint32_t iGrainSize, std::function<void(uint32_t, uint32_t, uint32_t)> const& iFunction);
+
+    //Number of chunks ParallelFor will produce for this range.
+    static uint32_t GetNumChunks(uint32_t iBegin, uint32_t iEnd, uint32_t iGrainSize)
+    {
+      iGrainSize = iGrainSize == 0 ? 1 : iGrainSize;
+      return iEnd > iBegin ? (iEnd - iBegin + iGrainSize - 1) / iGrainSize : 0;
+    }
+
+  protected:
+    friend JobCounter;
+
+    void Schedule(Job* iJob);
+
+    JobSystem_Impl* m_Impl;
+  };
+}
@@ -0,0 +1,165 @@
+/*
+Copyright 2009-2021 Nicolas Colombe
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <core/utils/mphf.hpp>
+
+namespace eXl
+{
+  // Read-only map indexed by a minimal perfect hash function. Entries are stored contiguously
+  // in hash order, so a lookup is one hash, a few table reads and a single key comparison.
+  // The keys' hash_value is used as the base hash, it should not collide on the key set.
+  template <typename K, typename V, typename Hasher = boost::hash<K>>
+  class FrozenMap
+  {
+  public:
+    using value_type = std::pair<K, V>;
+    using iterator = typename Vector<value_type>::iterator;
+    using const_iterator = typename Vector<value_type>::const_iterator;
+
+    // Builds from a range of unique key/value pairs.
+    template <typename Iter>
+    Err Build(Iter const& iBegin, Iter const& iEnd);
+
+    template <typename Map>
+    Err Freeze(Map const& iMap)
+    {
+      return Build(iMap.begin(), iMap.end());
+    }
+
+    void Clear()
+    {
+      m_Hash.GetData().Clear();
+      m_Entries.clear();
+    }
+
+    V const* Find(K const& iKey) const
+    {
+      uint32_t const idx = FindIndex(iKey);
+      return idx < m_Entries.size() ? &m_Entries[idx].second : nullptr;
+    }
+
+    V* Find(K const& iKey)
+    {
+      uint32_t const idx = FindIndex(iKey);
+      return idx < m_Entries.size() ? &m_Entries[idx].second : nullptr;
+    }
+
+    const_iterator find(K const& iKey) const
+    {
+      return m_Entries.begin() + std::min<size_t>(FindIndex(iKey), m_Entries.size());
+    }
+
+    size_t count(K const& iKey) const { return Find(iKey) != nullptr ? 1 : 0; }
+
+    const_iterator begin() const { return m_Entries.begin(); }
+    const_iterator end() const { return m_Entries.end(); }
+    iterator begin() { return m_Entries.begin(); }
+    iterator end() { return m_Entries.end(); }
+    size_t size() const { return m_Entries.size(); }
+    bool empty() const { return m_Entries.empty(); }
+
+  private:
+
+    uint32_t FindIndex(K const& iKey) const
+    {
+      uint32_t const idx = m_Hash.Compute(iKey);
+      if (idx < m_Entries.size() && m_Entries[idx].first == iKey)
+      {
+        return idx;
+      }
+      return UINT32_MAX;
+    }
+
+    class KeyHash : public MPHF_Base<K, KeyHash>
+    {
+    public:
+      template <typename Iter>
+      Err Build(Iter const& iBegin, Iter const& iEnd)
+      {
+        // Deterministic seeds, so that a given key set always gives the same layout.
+        for (uint32_t i = 0; i < 64; ++i)
+        {
+          m_Seed = i * 0x9E3779B97F4A7C15ull;
+          if (this->_Build(iBegin, iEnd))
+          {
+            return Err::Success;
+          }
+        }
+
+        eXl_FAIL_MSG_RET("Failed to build a perfect hashing function in 64 tries", Err::Failure);
+      }
+
+      void Hash(K const& iKey, uint32_t(&oHashes)[3]) const
+      {
+        uint64_t value = uint64_t(Hasher()(iKey)) ^ m_Seed;
+        value = Mix(value);
+        oHashes[0] = uint32_t(value);
+        oHashes[1] = uint32_t(value >> 32);
+        oHashes[2] = uint32_t(Mix(value));
+      }
+
+    private:
+      // splitmix64 finalizer.
+      static uint64_t Mix(uint64_t iValue)
+      {
+        iValue += 0x9E3779B97F4A7C15ull;
+        iValue = (iValue ^ (iValue >> 30)) * 0xBF58476D1CE4E5B9ull;
+        iValue = (iValue ^ (iValue >> 27)) * 0x94D049BB133111EBull;
+        return iValue ^ (iValue >> 31);
+      }
+
+      uint64_t m_Seed = 0;
+    };
+
+    KeyHash m_Hash;
+    Vector<value_type> m_Entries;
+  };
+
+  template <typename K, typename V, typename Hasher>
+  template <typename Iter>
+  Err FrozenMap<K, V, Hasher>::Build(Iter const& iBegin, Iter const& iEnd)
+  {
+    Clear();
+
+    Vector<K> keys;
+    for (Iter it = iBegin; it != iEnd; ++it)
+    {
+      keys.push_back(it->first);
+    }
+    if (keys.empty())
+    {
+      return Err::Success;
+    }
+
+    if (!m_Hash.Build(keys.begin(), keys.end()))
+    {
+      Clear();
+      return Err::Failure;
+    }
+
+    Vector<Iter> slots(keys.size(), iEnd);
+    for (Iter it = iBegin; it != iEnd; ++it)
+    {
+      uint32_t const idx = m_Hash.Compute(it->first);
+      eXl_ASSERT(idx < slots.size() && slots[idx] == iEnd);
+      slots[idx] = it;
+    }
+
+    m_Entries.reserve(keys.size());
+    for (Iter const& it : slots)
+    {
+      m_Entries.emplace_back(it->first, it->second);
+    }
+
+    return Err::Success;
+  }
+}
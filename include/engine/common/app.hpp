@@ -25,6 +25,7 @@ namespace eXl
   class InputSystem;
   class World;
   class WorldState;
+  class JobSystem;
   struct CameraState;
 
   class EXL_ENGINE_API Scenario : public RttiObject
@@ -79,7 +80,8 @@ namespace eXl
     WorldState(WorldState&&);
     WorldState& operator=(WorldState&&);
 
-    WorldState& Init(PropertiesManifest const& iProperties);
+    // iJobs runs the independent tick stages, the world ticks on the calling thread without one.
+    WorldState& Init(PropertiesManifest const& iProperties, JobSystem* iJobs = nullptr);
 
     WorldState& WithGfx();
 
@@ -156,12 +158,38 @@ namespace eXl
       return m_BakeDir ? &(*m_BakeDir) : nullptr;
     }
 
+    bool IsBakeBinary() const
+    {
+      return m_BakeBinary;
+    }
+
+    //Chrome trace requested with --profile, written after GetProfileFrames() frames.
+    Path const* GetProfileOutput()
+    {
+      return m_ProfileOutput ? &(*m_ProfileOutput) : nullptr;
+    }
+
+    uint32_t GetProfileFrames() const
+    {
+      return m_ProfileFrames;
+    }
+
+    //Run the world without window nor renderer.
+    bool IsHeadless() const
+    {
+      return m_Headless;
+    }
+
   private:
     std::unique_ptr<Scenario> m_Scenario;
     std::unique_ptr<Impl> m_Impl;
     Path m_ProjectPath;
     Path m_MapPath;
     Optional<Path> m_BakeDir;
+    bool m_BakeBinary = false;
+    Optional<Path> m_ProfileOutput;
+    uint32_t m_ProfileFrames = 300;
+    bool m_Headless = false;
   };
 
   inline World& Scenario::GetWorld()
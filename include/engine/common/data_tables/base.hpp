@@ -15,10 +15,19 @@ namespace eXl
 {
   class Type;
 
+  // Slot of each object, indexed by object id so that joins between tables do not hash.
+  // A stale entry is told apart by checking the object stored in m_WorldObjects.
   struct EXL_ENGINE_API ObjectDataIndex
   {
-    UnorderedMap<ObjectHandle, uint32_t> m_ObjectToSlot;
+    uint32_t FindSlot(ObjectHandle iObject) const;
+    void SetSlot(ObjectHandle iObject, uint32_t iSlot);
+    void MoveSlot(ObjectHandle iObject, uint32_t iFrom, uint32_t iTo);
+    void ClearSlot(ObjectHandle iObject, uint32_t iSlot);
+    void Clear();
+
+    Vector<uint32_t> m_IdToSlot;
     Vector<ObjectHandle> m_WorldObjects;
+    uint32_t m_NumObjects = 0;
   };
 
   struct EXL_ENGINE_API GameDataAllocatorBase
@@ -52,6 +61,9 @@ namespace eXl
   template <typename T>
   class StridedGameDataView;
 
+  template <typename T>
+  struct QueryTable;
+
   template <typename T>
   class GameDataView
   {
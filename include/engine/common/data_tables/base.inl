@@ -34,8 +34,53 @@ void GameDataView<T>::Iterate(Functor const& iFn) const
   //}
 }
 
+inline uint32_t ObjectDataIndex::FindSlot(ObjectHandle iObject) const
+{
+  uint32_t const id = iObject.GetId();
+  if (id >= m_IdToSlot.size())
+  {
+    return UINT32_MAX;
+  }
+  uint32_t const slot = m_IdToSlot[id];
+  return slot < m_WorldObjects.size() && m_WorldObjects[slot] == iObject ? slot : UINT32_MAX;
+}
+
+inline void ObjectDataIndex::SetSlot(ObjectHandle iObject, uint32_t iSlot)
+{
+  uint32_t const id = iObject.GetId();
+  if (id >= m_IdToSlot.size())
+  {
+    m_IdToSlot.resize(id + 1, UINT32_MAX);
+  }
+  m_IdToSlot[id] = iSlot;
+  ++m_NumObjects;
+}
+
+// An id can be reused while the previous object's data is still waiting for garbage collection,
+// entries are only touched when they still point to the slot that is moved or released.
+inline void ObjectDataIndex::MoveSlot(ObjectHandle iObject, uint32_t iFrom, uint32_t iTo)
+{
+  uint32_t const id = iObject.GetId();
+  if (id < m_IdToSlot.size() && m_IdToSlot[id] == iFrom)
+  {
+    m_IdToSlot[id] = iTo;
+  }
+}
+
+inline void ObjectDataIndex::ClearSlot(ObjectHandle iObject, uint32_t iSlot)
+{
+  MoveSlot(iObject, iSlot, UINT32_MAX);
+  --m_NumObjects;
+}
+
+inline void ObjectDataIndex::Clear()
+{
+  m_IdToSlot.clear();
+  m_WorldObjects.clear();
+  m_NumObjects = 0;
+}
+
 inline uint32_t GameDataAllocatorBase::GetSlot(ObjectHandle iHandle) const
 {
-  auto iter = m_IndexRef.m_ObjectToSlot.find(iHandle);
-  return m_IndexRef.m_ObjectToSlot.end() != iter ? iter->second : -1;
+  return m_IndexRef.FindSlot(iHandle);
 }
@@ -56,6 +56,8 @@ namespace eXl
     inline void Iterate(Functor const& iFn) const;
 
   protected:
+    template <typename> friend struct QueryTable;
+
     DenseGameDataAllocator& m_Alloc;
     ObjectTable<T>& m_ObjectSpec;
   };
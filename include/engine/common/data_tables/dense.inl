@@ -13,7 +13,7 @@ inline uint32_t DenseGameDataAllocator::AllocateSlot_Inl(ObjectHandle iObject)
     m_IndexRef.m_WorldObjects.push_back(ObjectHandle());
   }
   m_IndexRef.m_WorldObjects[newSlot] = iObject;
-  m_IndexRef.m_ObjectToSlot.insert(std::make_pair(iObject, newSlot));
+  m_IndexRef.SetSlot(iObject, newSlot);
   return newSlot;
 }
 
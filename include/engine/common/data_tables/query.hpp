@@ -0,0 +1,202 @@
+/*
+Copyright 2009-2021 Nicolas Colombe
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <engine/common/data_tables/dense.hpp>
+#include <engine/common/data_tables/sparse.hpp>
+#include <core/thread/jobsystem.hpp>
+
+#include <tuple>
+
+namespace eXl
+{
+  // Storage behind a GameDataView, resolved once so that per entity accesses are inlined.
+  template <typename T>
+  struct QueryTable
+  {
+    using Data = typename std::remove_const<T>::type;
+    using Handle = typename ObjectTable<Data>::Handle;
+    static constexpr bool s_Mutable = !std::is_const<T>::value;
+
+    QueryTable(GameDataView<Data> const& iView)
+    {
+      GameDataView<Data>& view = const_cast<GameDataView<Data>&>(iView);
+      if (DenseGameDataView<Data>* denseView = view.GetDenseView())
+      {
+        m_DenseAlloc = &denseView->m_Alloc;
+        m_Table = &denseView->m_ObjectSpec;
+        m_Index = &denseView->m_Alloc.m_IndexRef;
+      }
+      else if (SparseGameDataView<Data>* sparseView = view.GetSparseView())
+      {
+        m_SparseAlloc = &sparseView->m_Alloc;
+        m_Table = &sparseView->m_ObjectSpec;
+        m_Index = &sparseView->m_Alloc.m_IndexRef;
+      }
+      eXl_ASSERT_MSG(m_Table != nullptr, "Only dense and sparse views can be queried");
+    }
+
+    bool IsMutableSparse() const
+    {
+      return s_Mutable && m_SparseAlloc != nullptr;
+    }
+
+    uint32_t FindSlot(ObjectHandle iObject) const
+    {
+      return m_Index->FindSlot(iObject);
+    }
+
+    T* GetFromSlot(uint32_t iSlot) const
+    {
+      if (m_DenseAlloc)
+      {
+        return &m_Table->Get(Handle(m_DenseAlloc->GetDataFromSlot_Inl(iSlot)));
+      }
+      if constexpr (s_Mutable)
+      {
+        // Copies the archetype's data on write, like SparseGameDataView::Get.
+        return m_Table->TryGet(Handle(m_SparseAlloc->SparseGameDataAllocator::GetDataFromSlot(iSlot)));
+      }
+      else
+      {
+        return m_Table->TryGet(Handle(m_SparseAlloc->GetDataFromSlot_Inl(iSlot)));
+      }
+    }
+
+    ObjectDataIndex const* m_Index = nullptr;
+    ObjectTable<Data>* m_Table = nullptr;
+    DenseGameDataAllocator* m_DenseAlloc = nullptr;
+    SparseGameDataAllocator* m_SparseAlloc = nullptr;
+  };
+
+  template <typename T>
+  using QueryView = typename std::conditional<std::is_const<T>::value,
+    GameDataView<typename std::remove_const<T>::type> const,
+    GameDataView<T>>::type;
+
+  // Joins several property sheets : Query<A, B, C const> calls iFn(ObjectHandle, A&, B&, C const&)
+  // for every valid object holding all of them.
+  // The table with the fewest entries drives the iteration, the others are looked up by object id.
+  template <typename... Components>
+  class Query
+  {
+  public:
+    static constexpr size_t s_NumComponents = sizeof...(Components);
+
+    Query(QueryView<Components>&... iViews)
+      : m_World(std::get<0>(std::tie(iViews...)).GetWorld())
+      , m_Tables(QueryTable<Components>(iViews)...)
+    {
+      InitIndices(std::index_sequence_for<Components...>());
+    }
+
+    // Number of slots of the driver table, ie. the range that Iterate splits in chunks.
+    uint32_t GetNumSlots() const
+    {
+      return m_Indices[GetDriver()]->m_WorldObjects.size();
+    }
+
+    template <typename Functor>
+    void Iterate(Functor const& iFn)
+    {
+      uint32_t const driver = GetDriver();
+      IterateSlots(driver, 0, m_Indices[driver]->m_WorldObjects.size(), iFn, std::index_sequence_for<Components...>());
+    }
+
+    // Splits the driver table in chunks of iChunkSize slots and runs them on iJobs, or serially without a job system.
+    template <typename Functor>
+    void ParallelIterate(JobSystem* iJobs, uint32_t iChunkSize, Functor const& iFn)
+    {
+      if (iJobs == nullptr)
+      {
+        Iterate(iFn);
+        return;
+      }
+      eXl_ASSERT_MSG(!HasMutableSparse(), "Writing sparse data can copy it, which is not thread safe");
+
+      uint32_t const driver = GetDriver();
+      iJobs->ParallelFor(0, m_Indices[driver]->m_WorldObjects.size(), iChunkSize, [&](uint32_t iBegin, uint32_t iEnd, uint32_t)
+      {
+        IterateSlots(driver, iBegin, iEnd, iFn, std::index_sequence_for<Components...>());
+      });
+    }
+
+  private:
+
+    template <size_t... I>
+    void InitIndices(std::index_sequence<I...>)
+    {
+      ((m_Indices[I] = std::get<I>(m_Tables).m_Index), ...);
+    }
+
+    uint32_t GetDriver() const
+    {
+      uint32_t driver = 0;
+      for (uint32_t i = 1; i < s_NumComponents; ++i)
+      {
+        if (m_Indices[i]->m_NumObjects < m_Indices[driver]->m_NumObjects)
+        {
+          driver = i;
+        }
+      }
+      return driver;
+    }
+
+    bool HasMutableSparse() const
+    {
+      return HasMutableSparse(std::index_sequence_for<Components...>());
+    }
+
+    template <size_t... I>
+    bool HasMutableSparse(std::index_sequence<I...>) const
+    {
+      return (std::get<I>(m_Tables).IsMutableSparse() || ...);
+    }
+
+    template <size_t I>
+    bool FindSlot(uint32_t iDriver, uint32_t iDriverSlot, ObjectHandle iObject, uint32_t& oSlot) const
+    {
+      oSlot = I == iDriver ? iDriverSlot : std::get<I>(m_Tables).FindSlot(iObject);
+      return oSlot != UINT32_MAX;
+    }
+
+    template <typename Functor, size_t... I>
+    void IterateSlots(uint32_t iDriver, uint32_t iBegin, uint32_t iEnd, Functor const& iFn, std::index_sequence<I...>)
+    {
+      Vector<ObjectHandle> const& objects = m_Indices[iDriver]->m_WorldObjects;
+      for (uint32_t slot = iBegin; slot < iEnd; ++slot)
+      {
+        ObjectHandle object = objects[slot];
+        if (!object.IsAssigned() || !m_World.IsObjectValid(object))
+        {
+          continue;
+        }
+
+        // Every table is checked before any data is fetched, so that sparse data is only copied for matches.
+        uint32_t slots[s_NumComponents];
+        if (!(FindSlot<I>(iDriver, slot, object, slots[I]) && ...))
+        {
+          continue;
+        }
+
+        std::tuple<Components*...> data(std::get<I>(m_Tables).GetFromSlot(slots[I])...);
+        if (((std::get<I>(data) != nullptr) && ...))
+        {
+          iFn(object, *std::get<I>(data)...);
+        }
+      }
+    }
+
+    World& m_World;
+    std::tuple<QueryTable<Components>...> m_Tables;
+    ObjectDataIndex const* m_Indices[s_NumComponents];
+  };
+}
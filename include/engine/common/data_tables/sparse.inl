@@ -9,7 +9,7 @@ inline uint32_t SparseGameDataAllocator::AllocateSlot_Inl(ObjectHandle iObject)
   uint32_t newSlot = m_ObjectHandles.size();
   m_ArchetypeHandle.push_back(ObjectTableHandle_Base());
   m_ObjectHandles.push_back(ObjectTableHandle_Base());
-  m_IndexRef.m_ObjectToSlot.insert(std::make_pair(iObject, newSlot));
+  m_IndexRef.SetSlot(iObject, newSlot);
   m_IndexRef.m_WorldObjects.push_back(iObject);
   return newSlot;
 }
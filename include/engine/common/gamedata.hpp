@@ -12,6 +12,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <engine/common/world.hpp>
 #include <engine/common/data_tables/dense.hpp>
 #include <engine/common/data_tables/sparse.hpp>
+#include <engine/common/data_tables/query.hpp>
 
 namespace eXl
 {
@@ -30,11 +30,32 @@ namespace eXl
       PositionRotation
     };
 
-    Transforms();
+    // Rotation around Z and translation, enough for most 2D objects.
+    struct Transform2D
+    {
+      // Cosine and sine of the rotation angle.
+      Vec2 m_Rotation = UnitX<Vec2>();
+      Vec3 m_Translation = Zero<Vec3>();
+
+      // Drops scale, shear and any rotation which is not around Z.
+      static inline Transform2D FromMatrix(Mat4 const& iMat);
+      inline Mat4 ToMatrix() const;
+      inline Transform2D operator*(Transform2D const& iLocal) const;
+    };
+
+    enum Storage
+    {
+      MatrixStorage,
+      // Hierarchies are computed on Transform2D, world matrices are expanded when read.
+      Compact2DStorage
+    };
+
+    Transforms(Storage iStorage = MatrixStorage);
     ~Transforms();
 
     Err AddTransform(ObjectHandle iObj, Optional<Mat4> const& iTrans = {});
     void UpdateTransform(ObjectHandle, Mat4 const& iTransform);
+    void UpdateTransform(ObjectHandle, Transform2D const& iTransform);
     void DeleteComponent(ObjectHandle) override;
 
     void Attach(ObjectHandle iChild, ObjectHandle iParent, AttachType iAttach = PositionRotation);
@@ -45,6 +66,12 @@ namespace eXl
 
     // Caution : can do some computation if the transform is out of date
     Mat4 const& GetWorldTransform(ObjectHandle);
+    Transform2D GetWorldTransform2D(ObjectHandle);
+
+    Storage GetStorage() const { return m_Storage; }
+
+    // Recomputes every out of date world transform, parents first.
+    void UpdateDirty();
 
     //void Update();
     void NextFrame();
@@ -54,6 +81,7 @@ namespace eXl
     {
       if(m_DirtyStart < m_TotAlloc)
       {
+        const_cast<Transforms*>(this)->UpdateDirty();
         uint32_t curPageIdx = m_DirtyStart / s_PageSize;
         Entry curEntry;
         curEntry.m_Page = const_cast<TransformPage*>(&m_Pages[curPageIdx]);
@@ -62,13 +90,9 @@ namespace eXl
         {
           for(; curEntry.m_LocalPos < curEntry.m_Page->m_Used; ++curEntry.m_LocalPos)
           {
-            if (curEntry.Timestamp() & s_NeedUpdateMask)
-            {
-              IterationUpdate(curEntry);
-            }
             if(curEntry.Timestamp() == m_TimeStamp)
             {
-              iFn(curEntry.WorldTransform(), curEntry.Owner());
+              iFn(ResolveWorld(curEntry), curEntry.Owner());
             }
           }
           ++curPageIdx;
@@ -112,7 +136,7 @@ namespace eXl
 
     struct TransformPage : public HeapObject
     {
-      TransformPage();
+      TransformPage(Storage iStorage);
 
       uint32_t m_Used = 0;
       void* m_Buffer;
@@ -123,6 +147,10 @@ namespace eXl
       uint32_t* m_Timestamps;
       uint32_t* m_GlobId;
       HierarchyInfo* m_Hierarchy;
+      // Only allocated with Compact2DStorage.
+      Transform2D* m_LocalCompact = nullptr;
+      Transform2D* m_WorldCompact = nullptr;
+      uint8_t* m_StaleMatrix = nullptr;
     };
 
     struct Entry
@@ -133,6 +161,9 @@ namespace eXl
       inline uint32_t& Timestamp();
       inline uint32_t& GlobId();
       inline HierarchyInfo& Hierarchy();
+      inline Transform2D& LocalCompact();
+      inline Transform2D& WorldCompact();
+      inline uint8_t& StaleMatrix();
 
       void Copy(Entry& iOther);
 
@@ -144,9 +175,11 @@ namespace eXl
 
     Entry GetEntry(uint32_t) const;
     void Detach_Impl(Entry& iParent, Entry& iChild);
-    void Remap(HierarchyInfo const& iInfo, uint32_t iOld, uint32_t iNew);
-    void IterationUpdate(Entry& iEntry) const;
+    // Queues every link to or from the entry.
+    void Remap(HierarchyInfo& iInfo);
+    void ComputeWorld(Entry& iEntry);
     void UpdateTrans(Entry& iEntry);
+    inline Mat4& ResolveWorld(Entry& iEntry) const;
     void Touch(Entry& iEntry);
 
     Vector<TransformPage> m_Pages;
@@ -165,11 +198,18 @@ namespace eXl
     Vector<PendingModif> m_ModifQueue;
 
     void PushModif(uint32_t* iDest, uint32_t iValue);
-    void ApplyModif();
+    // Exchanges iPos1 and iPos2 in the queued links.
+    void ApplyModif(uint32_t iPos1, uint32_t iPos2);
 
     uint32_t m_TimeStamp = 0;
     uint32_t m_DirtyStart = 0;
     uint32_t m_TotAlloc = 0;
+    Storage m_Storage;
+
+    // UpdateDirty scratch, indexed by position - m_DirtyStart.
+    Vector<uint32_t> m_DirtyDepth;
+    Vector<uint32_t> m_DepthOffset;
+    Vector<uint32_t> m_UpdateOrder;
   };
 
   Mat4& Transforms::Entry::WorldTransform()
@@ -196,6 +236,63 @@ namespace eXl
   {
     return m_Page->m_Hierarchy[m_LocalPos];
   }
+  Transforms::Transform2D& Transforms::Entry::LocalCompact()
+  {
+    return m_Page->m_LocalCompact[m_LocalPos];
+  }
+  Transforms::Transform2D& Transforms::Entry::WorldCompact()
+  {
+    return m_Page->m_WorldCompact[m_LocalPos];
+  }
+  uint8_t& Transforms::Entry::StaleMatrix()
+  {
+    return m_Page->m_StaleMatrix[m_LocalPos];
+  }
+
+  Mat4& Transforms::ResolveWorld(Entry& iEntry) const
+  {
+    if (m_Storage == Compact2DStorage && iEntry.StaleMatrix())
+    {
+      iEntry.WorldTransform() = iEntry.WorldCompact().ToMatrix();
+      iEntry.StaleMatrix() = 0;
+    }
+    return iEntry.WorldTransform();
+  }
+
+  Transforms::Transform2D Transforms::Transform2D::FromMatrix(Mat4 const& iMat)
+  {
+    Transform2D res;
+    Vec2 const xAxis(iMat[0]);
+    float const axisLen = length(xAxis);
+    if (axisLen > Mathf::ZeroTolerance())
+    {
+      res.m_Rotation = xAxis / axisLen;
+    }
+    res.m_Translation = Vec3(iMat[3]);
+    return res;
+  }
+
+  Mat4 Transforms::Transform2D::ToMatrix() const
+  {
+    Mat4 res = Identity<Mat4>();
+    res[0][0] = m_Rotation.x;
+    res[0][1] = m_Rotation.y;
+    res[1][0] = -m_Rotation.y;
+    res[1][1] = m_Rotation.x;
+    res[3] = Vec4(m_Translation, 1.0);
+    return res;
+  }
+
+  Transforms::Transform2D Transforms::Transform2D::operator*(Transform2D const& iLocal) const
+  {
+    Transform2D res;
+    res.m_Rotation = Vec2(m_Rotation.x * iLocal.m_Rotation.x - m_Rotation.y * iLocal.m_Rotation.y,
+      m_Rotation.y * iLocal.m_Rotation.x + m_Rotation.x * iLocal.m_Rotation.y);
+    res.m_Translation = m_Translation + Vec3(m_Rotation.x * iLocal.m_Translation.x - m_Rotation.y * iLocal.m_Translation.y,
+      m_Rotation.y * iLocal.m_Translation.x + m_Rotation.x * iLocal.m_Translation.y,
+      iLocal.m_Translation.z);
+    return res;
+  }
 
   EXL_REFLECT_ENUM(Transforms::AttachType, eXl__Transforms__AttachType, EXL_ENGINE_API);
 }
\ No newline at end of file
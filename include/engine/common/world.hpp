@@ -15,6 +15,8 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <engine/enginelib.hpp>
 #include <core/type/typetraits.hpp>
 #include <core/stream/serializer.hpp>
+#include <core/framearena.hpp>
+#include <core/utils/frozenmap.hpp>
 #include <functional>
 
 namespace eXl
@@ -130,6 +132,25 @@ namespace eXl
 
   using TickDelegate = std::function<void(World&, float)>;
 
+  //Systems read and written by a tick delegate.
+  //Delegates of the same stage whose accesses do not conflict may run concurrently.
+  struct EXL_ENGINE_API TickAccess
+  {
+    template <typename T>
+    TickAccess& Read() { return Read(T::StaticRtti()); }
+
+    template <typename T>
+    TickAccess& Write() { return Write(T::StaticRtti()); }
+
+    TickAccess& Read(Rtti const& iSystem) { m_Reads.push_back(&iSystem); return *this; }
+    TickAccess& Write(Rtti const& iSystem) { m_Writes.push_back(&iSystem); return *this; }
+
+    bool ConflictsWith(TickAccess const& iOther) const;
+
+    Vector<Rtti const*> m_Reads;
+    Vector<Rtti const*> m_Writes;
+  };
+
   struct TimerDesc
   {
     std::function<void(World&)> timerDelegate;
@@ -168,6 +189,7 @@ namespace eXl
     uint32_t m_SysIdx;
   };
 
+  class JobSystem;
   class PhysicsSystem;
   class AbilitySystem;
   class Transforms;
@@ -196,14 +218,21 @@ namespace eXl
     void RegisterComponent(ComponentName iName, ComponentFactory iFactory, std::initializer_list<PropertySheetName> iReqData);
 
   protected:
+    ComponentEntry const* FindEntry(ComponentName iName) const;
+
     UnorderedMap<ComponentName, ComponentEntry> m_Components;
+    // Refrozen on registration, which only happens at startup.
+    // Lookups go through m_Components when the freeze fails.
+    FrozenMap<ComponentName, ComponentEntry> m_FrozenComponents;
+    bool m_ComponentsFrozen = false;
   };
 
   class EXL_ENGINE_API World
   {
   public:
 
-    World(ComponentManifest const& iManifest);
+    //iJobs runs independent tick delegates, nullptr runs everything on the calling thread.
+    World(ComponentManifest const& iManifest, JobSystem* iJobs = nullptr);
     World(World const&) = delete;
     ~World();
     World& operator=(World const&) = delete;
@@ -226,6 +255,8 @@ namespace eXl
 
     bool IsObjectBeingDestroyed(ObjectHandle iHandle) const;
 
+    uint32_t GetNumObjects() const { return m_NumObjects; }
+
     template <typename T>
     T* AddSystem(std::unique_ptr<T>&& iSystem)
     {
@@ -256,7 +287,21 @@ namespace eXl
       NumStages
     };
 
-    void AddTick(Stage iStage, TickDelegate&& iDelegate);
+    //Delegates registered without an access description run alone, in registration order.
+    //iName labels the delegate in the profiler, it defaults to the stage name and the delegate index.
+    void AddTick(Stage iStage, TickDelegate&& iDelegate, KString iName = KString());
+    void AddTick(Stage iStage, TickDelegate&& iDelegate, TickAccess iAccess, KString iName = KString());
+
+    //Delegates of a wave run concurrently, waves run in sequence.
+    uint32_t GetNumTickWaves(Stage iStage) const { return m_Tick[iStage].m_Waves.size(); }
+    uint32_t GetTickWave(Stage iStage, uint32_t iTickIdx) const { return m_Tick[iStage].m_EntryWave[iTickIdx]; }
+
+    void SetJobSystem(JobSystem* iJobs) { m_Jobs = iJobs; }
+    JobSystem* GetJobSystem() const { return m_Jobs; }
+
+    //Reset at the end of Tick, for temporaries of the systems (FrameVector, FrameMap).
+    //Memory allocated outside of Tick lasts until the end of the next one.
+    FrameArena& GetFrameArena() { return m_FrameArena; }
 
     void Tick(ProfilingState& ioProfiling);
 
@@ -278,6 +323,8 @@ namespace eXl
 
     void ProcessTimers();
 
+    void RunStage(Stage iStage, float iDelta);
+
     struct SysReg
     {
       std::unique_ptr<WorldSystem> m_System;
@@ -285,12 +332,29 @@ namespace eXl
     };
 
     WorldObjects m_Objects;
+    uint32_t m_NumObjects = 0;
     UnorderedMap<uint64_t, ObjectHandle> m_PersistentIdToObjects;
 
     Vector<ObjectHandle> m_ObjectsToDelete;
     UnorderedMap<Rtti const*, SysReg> m_Systems;
     Vector<ComponentManager*> m_CompManagers;
-    Vector<Vector<TickDelegate>> m_Tick;
+    struct TickEntry
+    {
+      TickDelegate m_Delegate;
+      Optional<TickAccess> m_Access;
+      char const* m_ProfileName;
+    };
+    char const* GetTickProfileName(Stage iStage, KString iName);
+    struct StageTicks
+    {
+      Vector<TickEntry> m_Entries;
+      //Entries of a wave do not conflict, waves run in sequence.
+      Vector<Vector<uint32_t>> m_Waves;
+      Vector<uint32_t> m_EntryWave;
+    };
+    Vector<StageTicks> m_Tick;
+    JobSystem* m_Jobs = nullptr;
+    FrameArena m_FrameArena;
 
     TimerTable m_Timers;
     struct TimerSchedule
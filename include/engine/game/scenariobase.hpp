@@ -12,6 +12,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 #include <engine/common/app.hpp>
 #include <engine/map/map.hpp>
+#include <engine/map/mapstreamer.hpp>
 #include <engine/game/character.hpp>
 
 namespace eXl
@@ -36,6 +37,13 @@ namespace eXl
       m_Map = iMap;
     }
 
+    // Streams the chunks of partitioned maps around the main character instead of instantiating the whole map.
+    // 0 disables streaming.
+    void SetMapStreamingRadius(float iRadius)
+    {
+      m_StreamingRadius = iRadius;
+    }
+
     void SetMainChar(ResourceHandle<Archetype> iChar)
     {
       m_MainCharacter = iChar;
@@ -61,6 +69,8 @@ namespace eXl
     ResourceHandle<MapResource> m_Map;
     ResourceHandle<Archetype> m_MainCharacter;
     MapResource::InstanceData m_InstatiatedMap;
+    UniquePtr<MapStreamer> m_MapStreamer;
+    float m_StreamingRadius = 0;
 
     ObjectHandle m_MainChar;
 
@@ -20,11 +20,14 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <ogl/renderer/oglrendercommand.hpp>
 #include <engine/common/transforms.hpp>
 #include <engine/gfx/tileset.hpp>
+#include <engine/gfx/gfxspatialindex.hpp>
+#include <math/aabb2d.hpp>
 #include <engine/game/commondef.hpp>
 
 namespace eXl
 {
   class GfxSystem;
+  class GfxSpatialIndex;
   class OGLDisplayList;
 
 	class EXL_ENGINE_API GfxResource : public HeapObject
@@ -45,6 +48,9 @@ namespace eXl
 
     OGLVAssembly m_Assembly;
     OGLDraw::Command m_Command;
+
+    // Local bounds. Components whose geometry has none are never culled.
+    Optional<GfxBounds> m_Bounds;
   };
 
   class EXL_ENGINE_API MaterialInfo : public GfxResource
@@ -94,9 +100,16 @@ namespace eXl
     void SetProgram(OGLCompiledProgram const* iProgram)
     {
       m_Program = iProgram;
+      OnChanged();
     }
     void SetTransform(Mat4 const& iTransform);
 
+    // Static components are recorded once by their render node, and again only when their program,
+    // geometry or draws change. Their transform and material values can still be updated.
+    // They are not culled against the view.
+    void SetStatic(bool iStatic);
+    bool IsStatic() const { return m_Static; }
+
     void SetGeometry(GeometryInfo* iGeom);
     inline void SetGeometry(IntrusivePtr<GeometryInfo> const& iGeom) { SetGeometry(iGeom.get()); }
 
@@ -130,6 +143,7 @@ namespace eXl
     void ClearDraws()
     {
       m_Draws.clear();
+      OnChanged();
     }
 
     void Push(OGLDisplayList& iList);
@@ -139,12 +153,19 @@ namespace eXl
     void AddDraw(Draw&& iDraw)
     {
       m_Draws.emplace_back(std::move(iDraw));
+      OnChanged();
     }
 
+    void UpdateBounds();
+    void OnChanged();
+
     friend class GfxSystem;
     
     ObjectHandle m_Object;
     Mat4 m_Transform;
+    GfxSpatialIndex* m_Index = nullptr;
+    GfxComponentRenderNode* m_Node = nullptr;
+    bool m_Static = false;
 
     Vector<Draw> m_Draws;
     IntrusivePtr<GeometryInfo> m_Geometry;
@@ -0,0 +1,102 @@
+/*
+Copyright 2009-2021 Nicolas Colombe
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <engine/enginelib.hpp>
+#include <math/math.hpp>
+#include <math/aabb2d.hpp>
+
+namespace eXl
+{
+  class FontResource;
+  class OGLTexture;
+  class OGLShaderData;
+
+  // 8 bit glyph bitmaps packed in several texture pages, with a skyline packer.
+  // When every page is full, the least recently used one is emptied, pages used since the last NextFrame are kept.
+  // Bitmaps are copied to a CPU side copy of each page, and FlushUpdates uploads them once per page.
+  class EXL_ENGINE_API GfxGlyphAtlas
+  {
+  public:
+
+    struct Key
+    {
+      FontResource const* m_Font;
+      uint32_t m_Size;
+      uint32_t m_Glyph;
+
+      bool operator == (Key const& iOther) const
+      {
+        return m_Font == iOther.m_Font && m_Size == iOther.m_Size && m_Glyph == iOther.m_Glyph;
+      }
+    };
+
+    struct Location
+    {
+      uint32_t m_Page;
+      // Normalized coordinates of the glyph.
+      AABB2Df m_TexBox;
+      // Pixels taken in the page, with a 1 pixel border.
+      AABB2Di m_Rect;
+    };
+
+    GfxGlyphAtlas(Vec2u const& iPageSize = Vec2u(512, 512), uint32_t iMaxPages = 4);
+    ~GfxGlyphAtlas();
+
+    GfxGlyphAtlas(GfxGlyphAtlas const&) = delete;
+    GfxGlyphAtlas& operator=(GfxGlyphAtlas const&) = delete;
+
+    void NextFrame();
+
+    // Marks the page as used this frame.
+    void TouchPage(uint32_t iPage);
+
+    Location const* Find(Key const& iKey);
+
+    // iPixels holds iSize.x * iSize.y bytes. Returns nullptr if the glyph is larger than a page.
+    Location const* Add(Key const& iKey, Vec2u const& iSize, uint8_t const* iPixels);
+
+    void FlushUpdates();
+
+    uint32_t GetNumPages() const { return m_Pages.size(); }
+    OGLTexture* GetTexture(uint32_t iPage) const;
+    OGLShaderData const* GetTextureData(uint32_t iPage) const;
+    Vector<uint8_t> const& GetPixels(uint32_t iPage) const;
+
+    Vec2u const& GetPageSize() const { return m_PageSize; }
+    uint32_t GetNumGlyphs() const { return m_Glyphs.size(); }
+    uint32_t GetNumEvictions() const { return m_NumEvictions; }
+
+  protected:
+
+    struct Page;
+
+    bool Pack(Page& iPage, Vec2u const& iSize, Vec2u& oPos);
+    uint32_t FindPageFor(Vec2u const& iSize, Vec2u& oPos);
+    void ResetPage(Page& iPage);
+
+    Vec2u m_PageSize;
+    uint32_t m_MaxPages;
+    uint64_t m_Frame = 1;
+    uint32_t m_NumEvictions = 0;
+    Vector<UniquePtr<Page>> m_Pages;
+    UnorderedMap<Key, Location> m_Glyphs;
+  };
+
+  inline size_t hash_value(GfxGlyphAtlas::Key const& iKey)
+  {
+    size_t hash = 0;
+    boost::hash_combine(hash, iKey.m_Font);
+    boost::hash_combine(hash, iKey.m_Size);
+    boost::hash_combine(hash, iKey.m_Glyph);
+    return hash;
+  }
+}
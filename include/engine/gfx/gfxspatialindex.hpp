@@ -0,0 +1,122 @@
+/*
+Copyright 2009-2021 Nicolas Colombe
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <core/coredef.hpp>
+#include <engine/enginelib.hpp>
+#include <engine/common/world.hpp>
+#include <math/aabb2d.hpp>
+
+namespace eXl
+{
+  // Axis aligned render bounds.
+  struct GfxBounds
+  {
+    Vec3 m_Min;
+    Vec3 m_Max;
+
+    static GfxBounds FromBox(AABB2Df const& iBox, float iMinZ = 0, float iMaxZ = 0)
+    {
+      return { Vec3(iBox.MinX(), iBox.MinY(), iMinZ), Vec3(iBox.MaxX(), iBox.MaxY(), iMaxZ) };
+    }
+  };
+
+  // Volume seen through a projection * view matrix.
+  struct EXL_ENGINE_API GfxViewFrustum
+  {
+    GfxViewFrustum(Mat4 const& iViewProj);
+
+    bool Intersects(GfxBounds const& iBounds) const;
+
+    // XY extent of the part of the volume between iMinZ and iMaxZ, empty if it does not reach them.
+    Optional<AABB2Df> GetFootprint(float iMinZ, float iMaxZ) const;
+
+    // Inward facing, (normal, distance).
+    Vec4 m_Planes[6];
+    // Near corners first, then the far ones in the same order.
+    Vec3 m_Corners[8];
+  };
+
+  // Loose hierarchical grid of render bounds, on their XY extent.
+  // An object goes to the level whose cells are at least as large as its box, in the cell holding its center,
+  // so a query only visits the cells it overlaps, grown by half a cell.
+  // Boxes too large for the top level stay there, and grow the margin of its queries instead.
+  // Holds one entry per object, GfxSystem keeps one index for sprites and one for components.
+  class EXL_ENGINE_API GfxSpatialIndex
+  {
+  public:
+    static constexpr uint32_t s_NumLevels = 12;
+
+    GfxSpatialIndex(float iCellSize = 8.0);
+
+    // Inserts the object, or moves it if it is already indexed.
+    void Update(ObjectHandle iObject, GfxBounds const& iBounds);
+    void Update(ObjectHandle iObject, AABB2Df const& iBox) { Update(iObject, GfxBounds::FromBox(iBox)); }
+
+    // Objects without bounds are kept aside and never culled.
+    void SetUnbounded(ObjectHandle iObject);
+
+    void Remove(ObjectHandle iObject);
+
+    bool Contains(ObjectHandle iObject) const;
+
+    // Appends the objects whose XY extent intersects iBox.
+    void Query(AABB2Df const& iBox, Vector<ObjectHandle>& oObjects) const;
+
+    // Appends the objects whose bounds intersect the frustum.
+    void Query(GfxViewFrustum const& iFrustum, Vector<ObjectHandle>& oObjects) const;
+
+    // Appends the objects whose bounds the ray iOrigin + t * iDir, t >= 0, goes through, along with the t where it enters them.
+    void Raycast(Vec3 const& iOrigin, Vec3 const& iDir, Vector<std::pair<float, ObjectHandle>>& oObjects) const;
+
+    Vector<ObjectHandle> const& GetUnbounded() const { return m_Unbounded; }
+
+    // Box holding iLocalBounds once transformed.
+    static GfxBounds TransformBox(Mat4 const& iTransform, GfxBounds const& iLocalBounds);
+    static GfxBounds TransformBox(Mat4 const& iTransform, AABB2Df const& iLocalBox) { return TransformBox(iTransform, GfxBounds::FromBox(iLocalBox)); }
+
+    uint32_t GetNumObjects() const { return m_NumObjects; }
+
+  protected:
+
+    struct Entry
+    {
+      ObjectHandle m_Object;
+      GfxBounds m_Bounds;
+      uint64_t m_Cell;
+      uint32_t m_Slot;
+      uint8_t m_Level;
+      bool m_Bounded;
+    };
+
+    using Cells = UnorderedMap<uint64_t, Vector<uint32_t>>;
+
+    Entry* GetEntry(ObjectHandle iObject);
+    Entry& AddEntry(ObjectHandle iObject);
+    void Unlink(Entry& iEntry);
+
+    template <typename Functor>
+    void ForEachInBox(AABB2Df const& iBox, Functor const& iFunctor) const;
+
+    float m_CellSize;
+    uint32_t m_NumObjects = 0;
+    // Indexed by object id.
+    Vector<Entry> m_Entries;
+    Cells m_Levels[s_NumLevels];
+    uint32_t m_LevelCount[s_NumLevels] = {};
+    Vector<ObjectHandle> m_Unbounded;
+    // Largest box stored in the top level so far, only grows like the Z range.
+    float m_TopLevelSize = 0;
+    // Z range of everything indexed so far. Only grows, queries stay conservative after removals.
+    float m_MinZ = Mathf::MaxReal();
+    float m_MaxZ = -Mathf::MaxReal();
+  };
+}
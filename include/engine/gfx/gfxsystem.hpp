@@ -14,14 +14,19 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <engine/common/object.hpp>
 #include <engine/common/world.hpp>
 #include <core/coredef.hpp>
+#include <math/aabb2d.hpp>
 #include <ogl/oglspritealgo.hpp>
 
 namespace eXl
 {
   class GfxComponent;
+  class GfxSpatialIndex;
+  struct GfxViewFrustum;
   class GfxSystem;
   class Transforms;
   class OGLDisplayList;
+  class OGLRenderContext;
+  class OGLRecordingContext;
 
   namespace DebugTool
   {
@@ -59,6 +64,9 @@ namespace eXl
 
     virtual void Push(OGLDisplayList& iList, float iDelta) = 0;
 
+    // Nodes which only record into the list, without touching GL objects, may be pushed from a worker thread.
+    virtual bool CanPushInParallel() const { return false; }
+
     void AddObject(ObjectHandle iObject);
 
     GfxSystem* m_Sys = nullptr;
@@ -132,13 +140,31 @@ namespace eXl
 
     Vec2i WorldToScreen(Vec3 const& iWorldPos);
 
+    // Render bounds of the sprites and of the components, kept up to date by their render nodes.
+    GfxSpatialIndex& GetSpriteIndex();
+    GfxSpatialIndex& GetComponentIndex();
+
+    void SetViewCulling(bool iEnabled);
+
+    // Volume seen by the camera, nullptr when culling is disabled.
+    GfxViewFrustum const* GetCullingFrustum() const;
+
+    // Appends the objects whose render bounds are under iScreenPos, nearest first.
+    void PickObjects(Vec2i const& iScreenPos, Vector<ObjectHandle>& oObjects);
+
     void RenderFrame(float iDelta);
+    void RenderFrame(float iDelta, OGLRenderContext& iCtx);
+    // Records the frame instead of rendering it, to profile it without GL.
+    void RenderFrame(float iDelta, OGLRecordingContext& iCtx);
 
     Impl& GetImpl() { return *m_Impl; }
     Transforms& GetTransforms();
     using WorldSystem::GetWorld;
 
   protected:
+    template <class Context>
+    void RenderFrameImpl(float iDelta, Context& iCtx);
+
     friend GfxRenderNode;
     UniquePtr<Impl> m_Impl;
   };
@@ -12,18 +12,67 @@ namespace eXl
 
     void UpdateTransforms(ObjectHandle const* iObjects, Mat4 const** iTransforms, uint32_t iNum);
     void PrepareSprites();
+    void UpdateBounds(ObjectHandle iObject, GfxSpriteData const& iData, GfxSpriteComponent::Desc const& iDesc);
 
     void TickAnimation(ObjectHandle, GfxSpriteData& iData, float iDelta);
+    void TickAnimation(GfxSpriteData& iData, GfxSpriteComponent::Desc const& iDesc, float iDelta);
+
+    //Instanced path : sprites sharing texture, geometry and layer are drawn with a single instanced draw.
+    bool CanUseInstancing() const { return m_InstancedSpriteProgram != nullptr; }
+    void ClearInstances();
+    void AddInstance(GfxSpriteData const& iData);
+    void PushInstances(OGLDisplayList& iList, uint16_t iKey);
 
     GameDataView<GfxSpriteComponent::Desc> const& m_SpriteDescView;
     DenseGameDataView<GfxSpriteData>& m_SpriteData;
     Transforms& m_Transforms;
+    GfxSpatialIndex& m_Index;
 
     UnorderedMap<Vec3, IntrusivePtr<GeometryInfo>> m_SpriteGeomCache;
 
     UniquePtr<OGLCompiledProgram const> m_SpriteProgram;
+    UniquePtr<OGLCompiledProgram const> m_InstancedSpriteProgram;
     IntrusivePtr<OGLBuffer> m_DefaultSpriteIdxBuffer;
 
     UnorderedSet<ObjectHandle> m_DirtyComponents;
+
+    struct InstanceBatchKey
+    {
+      OGLTexture const* m_Texture;
+      GeometryInfo const* m_Geometry;
+      uint8_t m_Layer;
+
+      bool operator==(InstanceBatchKey const& iOther) const
+      {
+        return m_Texture == iOther.m_Texture
+          && m_Geometry == iOther.m_Geometry
+          && m_Layer == iOther.m_Layer;
+      }
+
+      friend size_t hash_value(InstanceBatchKey const& iKey)
+      {
+        size_t seed = reinterpret_cast<size_t>(iKey.m_Texture);
+        boost::hash_combine(seed, reinterpret_cast<size_t>(iKey.m_Geometry));
+        boost::hash_combine(seed, iKey.m_Layer);
+        return seed;
+      }
+    };
+
+    struct InstanceBatch
+    {
+      GeometryInfo const* m_Geometry;
+      OGLShaderData const* m_TextureData;
+      uint32_t m_Offset;
+      uint32_t m_Count;
+      uint8_t m_Layer;
+      OGLVAssembly m_Assembly;
+    };
+
+    UnorderedMap<InstanceBatchKey, uint32_t> m_BatchMap;
+    Vector<InstanceBatch> m_Batches;
+    Vector<GfxSpriteData const*> m_BatchedSprites;
+    Vector<uint32_t> m_BatchedSpritesBatch;
+    Vector<SpriteInstance> m_Instances;
+    IntrusivePtr<OGLBuffer> m_InstanceBuffer;
   };
 }
\ No newline at end of file
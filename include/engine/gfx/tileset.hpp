@@ -15,6 +15,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <core/image/image.hpp>
 #include <core/stream/serializer.hpp>
 #include <core/path.hpp>
+#include <core/utils/frozenmap.hpp>
 #include <ogl/renderer/ogltexture.hpp>
 #include <math/aabb2d.hpp>
 
@@ -87,6 +88,10 @@ namespace eXl
 
     Tile const* Find(TileName iTile) const 
     { 
+      if (m_TilesFrozen)
+      {
+        return m_FrozenTiles.Find(iTile);
+      }
       auto iter = m_Tiles.find(iTile);
       if (iter != m_Tiles.end())
       {
@@ -102,6 +107,9 @@ namespace eXl
     Err Serialize(Serializer iStreamer);
 
     UnorderedMap<TileName, Tile> m_Tiles;
+    // Lookup copy of m_Tiles built after loading, dropped when the tileset is edited.
+    FrozenMap<TileName, Tile> m_FrozenTiles;
+    bool m_TilesFrozen = false;
 
     friend TilesetLoader;
     Tileset(ResourceMetaData&);
@@ -38,13 +38,17 @@ namespace eXl
     static ResourceLoaderName StaticLoaderName();
     uint32_t ComputeHash() override;
 
+    // The bitmap has glyphSize.x * glyphSize.y bytes, the callback is skipped for empty glyphs.
     using RenderCallback = std::function<void(Font::GlyphDesc, uint8_t const*)>;
     Font::GlyphDesc RenderGlyph(uint32_t iChar, uint32_t iSize, RenderCallback iRender = RenderCallback()) const;
 
-    Font::GlyphDesc GetGlyphDesc(uint32_t iChar, uint32_t iSize) const
-    {
-      return RenderGlyph(iChar, iSize);
-    }
+    // Metrics are cached per char and size, only the first query loads the glyph.
+    Font::GlyphDesc GetGlyphDesc(uint32_t iChar, uint32_t iSize) const;
+    // Does not load the glyph, returns nullptr if it was never queried at this size.
+    Font::GlyphDesc const* FindGlyphDesc(uint32_t iChar, uint32_t iSize) const;
+
+    // Horizontal adjustment in pixels between two consecutive chars.
+    int32_t GetKerning(uint32_t iLeft, uint32_t iRight, uint32_t iSize) const;
 
   private:
     friend FontLoader;
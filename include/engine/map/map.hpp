@@ -20,6 +20,13 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 namespace eXl
 {
+  class JobSystem;
+
+  namespace MapTiler
+  {
+    struct Batcher;
+  }
+
   MAKE_NAME(TerrainTypeName)
 
   struct EXL_ENGINE_API TerrainType
@@ -101,6 +108,50 @@ namespace eXl
       CustomizationData m_Data;
     };
 
+    // Terrain shapes in pixels, once carved by the map objects.
+    struct EXL_ENGINE_API Collision
+    {
+      SERIALIZE_METHODS;
+    public:
+      TerrainTypeName m_Type;
+      Vector<AABB2DPolygoni> m_Shapes;
+    };
+
+    // Terrain vertices tiled when baking, in the layout of MapTiler::Batcher.
+    struct EXL_ENGINE_API TerrainBatch
+    {
+      SERIALIZE_METHODS;
+    public:
+      uint32_t m_Layer = 0;
+      ResourceHandle<Tileset> m_Tileset;
+      ImageName m_Image;
+      Vec2 m_VtxScaling = One<Vec2>();
+      Vec2 m_VtxOffset = Zero<Vec2>();
+      Vec2 m_Tiling = One<Vec2>();
+      Vector<float> m_Vertices;
+    };
+
+    // Square part of the map which can be instantiated on its own, built when baking the map.
+    struct EXL_ENGINE_API Chunk
+    {
+      SERIALIZE_METHODS;
+    public:
+      Vec2i m_Coords;
+      // Indices in m_Tiles[i].m_Tiles, for each entry of m_Tiles.
+      Vector<Vector<uint32_t>> m_Tiles;
+      // Terrain blocks clipped around the chunk, with a margin so that tiling patterns match across chunks.
+      // Emptied once tiled in m_TerrainBatches.
+      Vector<Terrain> m_Terrains;
+      Vector<TerrainBatch> m_TerrainBatches;
+      // Clipped to the chunk.
+      Vector<Collision> m_Collision;
+      // Indices in m_Objects.
+      Vector<uint32_t> m_Objects;
+    };
+
+    // Chunk side in world units used when baking maps.
+    static constexpr uint32_t s_DefaultChunkSize = 32;
+
     static void Init();
 
 #ifndef EXL_IS_BAKED_PLATFORM
@@ -121,6 +172,26 @@ namespace eXl
 
     InstanceData Instantiate(World& iWorld, const Mat4& iPos = Identity<Mat4>()) const;
 
+    // Partitions the map in square chunks of iChunkSize world units, 0 removes the partition.
+    void BuildChunks(uint32_t iChunkSize);
+
+    // Tiles the chunks' terrain once for all, on iJobs when given. The chunks must be built first.
+    void BakeTerrainGfx(JobSystem* iJobs);
+
+    // Terrain vertices by layer, copied from the baked batches when there are some.
+    void ComputeTerrainGfx(Vector<MapTiler::Batcher>& oLayers, JobSystem* iJobs) const;
+    void ComputeTerrainGfx(Chunk const& iChunk, Vector<MapTiler::Batcher>& oLayers, JobSystem* iJobs) const;
+
+    Vec2i GetChunkCoords(Vec2 const& iPos) const;
+    AABB2Df GetChunkBox(Vec2i const& iCoords) const;
+
+    // Creates the tiles, terrain and objects of a single chunk. No navigation mesh is built.
+    // iObjects, indices in m_Objects, replaces the chunk's object list when given.
+    InstanceData InstantiateChunk(World& iWorld, Chunk const& iChunk, const Mat4& iPos = Identity<Mat4>(), Vector<uint32_t> const* iObjects = nullptr) const;
+
+    // Navigation mesh of the whole map, built from the chunks' collision and the static objects' archetypes.
+    std::unique_ptr<NavMesh> BuildChunkedNavMesh() const;
+
     Err Stream_Data(Streamer& iStreamer) const override;
     Err Unstream_Data(Unstreamer& iStreamer) override;
 
@@ -129,6 +200,10 @@ namespace eXl
     Vector<PlacedTiles> m_Tiles;
     Vector<Terrain> m_Terrains;
     Vector<Object> m_Objects;
+
+    // 0 when the map is not partitioned.
+    uint32_t m_ChunkSize = 0;
+    Vector<Chunk> m_Chunks;
   private:
     Err Serialize(Serializer iSerializer);
   };
@@ -0,0 +1,83 @@
+/*
+Copyright 2009-2021 Nicolas Colombe
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+#include <engine/map/map.hpp>
+
+namespace eXl
+{
+  // Instantiates the chunks of a partitioned map around focus points, like cameras or players,
+  // and destroys them once they are out of reach.
+  // Map objects deleted by gameplay are not created again, and the ones which moved are created back
+  // where they were left, in the chunk they ended up in. Only their transform is kept.
+  class EXL_ENGINE_API MapStreamer
+  {
+  public:
+    MapStreamer(World& iWorld, MapResource const& iMap, Mat4 const& iPos = Identity<Mat4>());
+    ~MapStreamer();
+
+    MapStreamer(MapStreamer const&) = delete;
+    MapStreamer& operator=(MapStreamer const&) = delete;
+
+    // Chunks closer than iRadius world units are loaded, they are unloaded once one chunk further.
+    uint32_t AddFocusPoint(Vec2 const& iPos, float iRadius);
+    void MoveFocusPoint(uint32_t iFocus, Vec2 const& iPos);
+    // Follows the object's transform until it is deleted.
+    uint32_t AddFocusObject(ObjectHandle iObject, float iRadius);
+    void RemoveFocus(uint32_t iFocus);
+
+    // Unloads the chunks out of reach, then loads the missing ones, closest first, until iTimeBudget seconds are spent.
+    // At least one chunk is loaded per call, so that streaming always progresses.
+    void Update(float iTimeBudget);
+
+    // Destroys every loaded chunk. Loaded chunks are left in the world when the streamer is destroyed.
+    void Clear();
+
+    bool IsChunkLoaded(Vec2i const& iCoords) const;
+    uint32_t GetNumLoadedChunks() const { return m_LoadedChunks.size(); }
+    // Chunks in reach which were left for the next updates.
+    uint32_t GetNumPendingChunks() const { return m_NumPendingChunks; }
+
+    MapResource::InstanceData const* GetChunkData(Vec2i const& iCoords) const;
+
+  private:
+    struct Focus
+    {
+      Vec2 m_Pos;
+      ObjectHandle m_Object;
+      float m_Radius = 0;
+      bool m_Used = false;
+    };
+
+    static uint64_t GetChunkKey(Vec2i const& iCoords)
+    {
+      return (uint64_t(uint32_t(iCoords.x)) << 32) | uint32_t(iCoords.y);
+    }
+
+    uint32_t AllocFocus();
+    float GetDistance(Vec2i const& iCoords, Focus const& iFocus) const;
+    void LoadChunk(uint32_t iChunk);
+    void UnloadChunk(uint32_t iChunk);
+    uint32_t FindChunk(Vec2 const& iPos) const;
+
+    World& m_World;
+    MapResource const& m_Map;
+    Mat4 m_Pos;
+    Mat4 m_InvPos;
+    Vector<Focus> m_Focus;
+    UnorderedMap<uint64_t, uint32_t> m_ChunksIdx;
+    UnorderedMap<uint32_t, MapResource::InstanceData> m_LoadedChunks;
+    // Map objects of each chunk, indices in m_Map.m_Objects. Loaded chunks' objects are in the same order.
+    Vector<Vector<uint32_t>> m_ChunkObjects;
+    // Local transforms of the map objects which moved, by index in m_Map.m_Objects.
+    UnorderedMap<uint32_t, Mat4> m_MovedObjects;
+    uint32_t m_NumPendingChunks = 0;
+  };
+}
@@ -17,6 +17,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 namespace eXl
 {
   class GfxSystem;
+  class JobSystem;
   class TilingGroup;
 
   namespace MapTiler
@@ -41,6 +42,12 @@ namespace eXl
 
       Vector<float>& GetGroup(TexGroup const& iGroup);
 
+      // Crops the quads to iBox, in world units. Texture coordinates are interpolated, so tiled quads keep their pattern.
+      void Clip(AABB2Df const& iBox);
+
+      // Appends iOther's vertices, keeping the order of its texture groups.
+      void Merge(Batcher const& iOther);
+
       void Finalize(GfxSystem& iGfx, ObjectHandle iObject, uint8_t iLayer);
     };
 
@@ -51,5 +58,12 @@ namespace eXl
     };
 
     EXL_ENGINE_API void ComputeGfxForBlock(Batcher& oBatcher, AABB2Di const& iFullSize, Blocks const& iBlock);
+
+    // Loads the tileset and images used by the group, after which it can be tiled from several threads.
+    EXL_ENGINE_API void PrefetchImages(TilingGroup const& iGroup);
+
+    // Tiles the blocks of every layer in oLayers, one job per block when iJobs is given.
+    // The result is the same as calling ComputeGfxForBlock on each block in order.
+    EXL_ENGINE_API void ComputeGfxForLayers(Vector<Batcher>& oLayers, AABB2Di const& iFullSize, Vector<Vector<Blocks const*>> const& iBlocksByLayer, JobSystem* iJobs);
   }
 }
\ No newline at end of file
@@ -239,6 +239,19 @@ namespace eXl
 
     using ClientObjectMap = UnorderedMap<Network::ClientId, Network::ObjectId>;
 
+    //Area of interest, centered on the object assigned to each client. Distances are measured on the XY plane.
+    struct InterestParams
+    {
+      //Size of the spatial hash cells.
+      float m_CellSize = 32.0;
+      //Objects become relevant within m_EnterRadius, and stay relevant until farther than m_LeaveRadius.
+      float m_EnterRadius = 64.0;
+      float m_LeaveRadius = 80.0;
+      //Updates are sent every flush up to m_FullRateRadius, then the period grows linearly up to m_MaxUpdatePeriod flushes at m_LeaveRadius.
+      float m_FullRateRadius = 24.0;
+      uint32_t m_MaxUpdatePeriod = 8;
+    };
+
     class EXL_ENGINE_API ServerDispatcher
     {
     public:
@@ -250,17 +263,54 @@ namespace eXl
       void AddClient(ClientId, ObjectId);
       void RemoveClient(ClientId iClient);
 
+      void SetInterestParams(InterestParams const& iParams);
+      InterestParams const& GetInterestParams() const { return m_Params; }
+
+      //Clients are only sent the creation/deletion of objects entering/leaving their area of interest,
+      //and the updates of the objects they already know about.
       void Flush(Server& iServer);
 
       UnorderedMap<ObjectId, ClientData> const& GetObjects() { return m_Objects; }
       ClientObjectMap const& GetClients() { return m_ConnectedClients; }
+      uint32_t GetNumGridCells() const { return m_Grid.size(); }
 
     protected:
+
+      struct RelevantObject
+      {
+        uint32_t m_SentFrame;
+      };
+
+      struct ClientInterest
+      {
+        ObjectId m_Object;
+        UnorderedMap<ObjectId, RelevantObject> m_Relevant;
+      };
+
+      void BuildGrid();
+      void UpdateInterest(Server& iServer, ClientId iClient, ClientInterest& ioInterest);
+      uint32_t GetUpdatePeriod(float iDistance) const;
+
       UnorderedMap<ObjectId, ClientData> m_PendingUpdates;
       UnorderedMap<ObjectId, ClientData> m_Objects;
       UnorderedSet<ObjectId> m_DeletedObjects;
       UnorderedMap<ClientId, ObjectId> m_ConnectedClients;
       UnorderedMap<ClientId, ObjectId> m_NewClients;
+
+      InterestParams m_Params;
+      UnorderedMap<ClientId, ClientInterest> m_Interests;
+      UnorderedMap<ObjectId, uint32_t> m_UpdateFrame;
+      UnorderedMap<uint64_t, Vector<ObjectId>> m_Grid;
+      uint32_t m_Frame = 0;
+    };
+
+    //Object updates are batched per client and flush, and delta-encoded against the last snapshot the client acknowledged.
+    struct ReplicationStats
+    {
+      uint64_t m_NumBatches = 0;
+      //Objects written in the batches, including the removals.
+      uint64_t m_NumEntries = 0;
+      uint64_t m_NumBytes = 0;
     };
 
     class EXL_ENGINE_API Server : public HeapObject
@@ -286,6 +336,8 @@ namespace eXl
 
       String GetExternalClientId(ClientId iClient);
 
+      ReplicationStats const& GetReplicationStats() const;
+
     protected:
       friend Server_Impl;
       Server(NetCtx&, std::unique_ptr<Server_Impl>);
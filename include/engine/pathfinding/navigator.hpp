@@ -96,6 +96,7 @@ namespace eXl
     };
 
     NavigatorSystem(Transforms& iTransforms);
+    ~NavigatorSystem();
 
     void SetNavMesh(NavMesh& iMesh);
 
@@ -107,12 +108,20 @@ namespace eXl
 
     Err SetDestination(ObjectHandle iObject, Vec3 iDest);
 
+    // Orders a group to the same destination, with a single path search.
+    Err SetDestination(Vector<ObjectHandle> const& iObjects, Vec3 iDest);
+
     Obstacle const* AddObstacle(ObjectHandle iObject, float iRadius);
 
     //void SetObstacleSpeed(ObjectHandle iObject, Vec3 iSpeed);
 
     Obstacle const* AddObstacle(ObjectHandle iObject, Vec3 iBoxDims);
 
+    //Per-agent phases are split across the world's job system (if any).
+    //Agents see their neighbours as they were at the start of each phase, and cross-agent effects
+    //are applied in agent order afterwards, so the result does not depend on the number of threads.
+    //This differs from the former single loop, where an agent saw the rank, unstuck flag and avoidance
+    //direction already written by the agents processed before it in the same tick.
     void Tick(float iTime, NeighborhoodExtraction& iNeighbours);
 
     Obstacle const* GetObstacle(ObjectHandle iObject) const
@@ -145,10 +154,34 @@ namespace eXl
 
   protected:
 
+    //Avoidance solvers, one per job system thread.
+    struct CrowdScratch;
+
+    //Effect of an agent on one of its neighbours during avoidance.
+    struct NeighbourUpdate
+    {
+      Agent* m_Target;
+      float m_AvoidanceDelta;
+      bool m_PropagateRank;
+      bool m_Unstuck;
+    };
+
+    //Avoidance output read by the other agents, published after the parallel phase.
+    struct AvoidanceResult
+    {
+      Vec3 m_PriorityAvoidanceDir;
+      uint32_t m_NumUpdates;
+      bool m_ResetRank;
+    };
+
+    void UpdateAgentFace(Agent& agent);
     void HandleAgentPathfinding(Agent& agent, float iTime);
-    void HandleAgentAvoidance(NeighborhoodExtraction& iNeigh, VelocityObstacle& vo, RVO::ORCAAgent&, Agent& agent, float iTime);
+    void HandleAgentAvoidance(NeighborhoodExtraction& iNeigh, VelocityObstacle& vo, RVO::ORCAAgent&, Agent& agent, AvoidanceResult& oResult, Vector<NeighbourUpdate>& oUpdates, float iTime);
     void HandleAgentDiffusion(Agent& agent, float iTime);
 
+    template <typename Functor>
+    void ForEachAgentChunk(Functor const& iFn);
+
     Obstacle* GetObstacle_Internal(ObjectHandle iObject) const;
 
     Agent* GetAgent_Internal(ObjectHandle iObject) const;
@@ -171,5 +204,12 @@ namespace eXl
     Random* m_Rand;
 
     uint32_t m_Timestamp = 0;
+
+    static constexpr uint32_t s_AgentsPerJob = 64;
+
+    Vector<Agent*> m_TickAgents;
+    Vector<AvoidanceResult> m_AvoidanceResults;
+    Vector<Vector<NeighbourUpdate>> m_ChunkUpdates;
+    Vector<UniquePtr<CrowdScratch>> m_Scratch;
   };
 }
\ No newline at end of file
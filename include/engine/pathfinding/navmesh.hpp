@@ -66,6 +66,11 @@ namespace eXl
       EdgeMap m_FaceEdges;
     };
 
+    NavMesh();
+    NavMesh(NavMesh&&);
+    NavMesh& operator=(NavMesh&&);
+    ~NavMesh();
+
     static NavMesh MakeFromAABB2DPoly(Vector<AABB2DPolygoni> const& iPolys);
 
     static NavMesh MakeFromBoxes(Vector<AABB2Di> const& iBoxes);
@@ -99,10 +104,30 @@ namespace eXl
       Vector<Vec2> m_EdgeDirs;
     };
 
+    // The search starts from the start face and aims at the exact destination,
+    // results are cached by (start face, end face, destination).
     Optional<Path> FindPath(Vec2 const& iStart, Vec2 const& iEnd) const;
 
+    struct PathQuery
+    {
+      Vec2 m_Start;
+      Vec2 m_End;
+    };
+
+    // Queries sharing a destination are answered from a single reverse search.
+    void FindPaths(Vector<PathQuery> const& iQueries, Vector<Optional<Path>>& oPaths) const;
+
+    // Must be called if the components are modified.
+    void ClearPathCache();
+    void SetPathCacheSize(uint32_t iNumPaths);
+
   protected:
 
+    struct PathCache;
+
+    Optional<Path> ComputePath(FoundFace const& iStart, FoundFace const& iEnd, Vec2 const& iEndPt) const;
+
     Vector<Component> m_Components;
+    UniquePtr<PathCache> m_PathCache;
   };
 }
\ No newline at end of file
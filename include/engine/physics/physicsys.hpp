@@ -32,12 +32,20 @@ namespace eXl
 
   class BulletDebugDraw;
 
+  enum class NeighborhoodKind
+  {
+    //Walks Bullet's broadphase tree.
+    Dbvt,
+    //Uniform grid over the object positions, scales better with dense crowds.
+    Grid
+  };
+
   class EXL_ENGINE_API PhysicsSystem : public ComponentManager
   {
     DECLARE_RTTI(PhysicsSystem, ComponentManager);
   public:
 
-    PhysicsSystem(Transforms& iTransforms);
+    PhysicsSystem(Transforms& iTransforms, NeighborhoodKind iNeighKind = NeighborhoodKind::Dbvt);
     ~PhysicsSystem();
 
     void RayQuery(List<CollisionData>& oRes, const Vec3& iOrig,const Vec3& iEnd,unsigned int maxEnt=0,unsigned short category = 1,unsigned short mask=-1L);
@@ -90,6 +98,7 @@ namespace eXl
     PhysicsSystem& operator=(PhysicsSystem const&) = delete;
 
     friend struct PhysicComponent_Impl;
+    friend struct GridNeighborhoodExtractionImpl;
 
     PhysicsSystem_Impl* m_Impl;
     Transforms& m_Transforms;
@@ -45,6 +45,53 @@ namespace eXl
     PhysicsSystem& m_Sys;
   };
 
+  //Uniform grid rebuilt on each run, in the XY plane.
+  //Candidates are stored in SoA arrays sorted by cell, so that a row of cells is a contiguous range tested several objects at a time.
+  //Neighbours are selected with the same test as the tree : overlap of the boxes, the other one being expanded by the search radius.
+  struct GridNeighborhoodExtractionImpl : public NeighborhoodExtraction
+  {
+    GridNeighborhoodExtractionImpl(PhysicsSystem& iSys) : m_Sys(iSys) {}
+
+    void AddObject(ObjectHandle iObj, float iRadius, bool iPopulate) override;
+
+    void AddObject(ObjectHandle iObj, Vec3 const& iBoxDim, bool iPopulateNeigh) override;
+
+    void Remove(ObjectHandle iObj);
+
+    void Run(Vec3 const& iForwardOffset, float iRadiusSearch) override;
+
+  protected:
+
+    void AddObject(ObjectHandle iObj, Vec2 const& iHalfExtents, Neigh::Shape iShape, bool iPopulate);
+    void BuildGrid(float iInflate);
+    void Query(uint32_t iObj, float iInflate);
+
+    Vector<Vec2> m_HalfExtents;
+    Vector<Vec2> m_Positions;
+
+    //Sorted by cell, padded to a multiple of the SIMD width.
+    Vector<float> m_PosX;
+    Vector<float> m_PosY;
+    Vector<float> m_ExtX;
+    Vector<float> m_ExtY;
+    //Half extents of boxes, 0 for spheres, which are measured from their center.
+    Vector<float> m_BoxExtX;
+    Vector<float> m_BoxExtY;
+    Vector<uint32_t> m_SortedObjects;
+    //Position in the sorted arrays, by object.
+    Vector<uint32_t> m_SortedIndex;
+
+    Vector<uint32_t> m_CellStart;
+    Vector<uint32_t> m_CellCursor;
+    Vector<uint32_t> m_ObjectCell;
+    Vec2 m_GridOrigin;
+    Vec2i m_GridSize;
+    float m_CellSize;
+    float m_MaxExtent;
+
+    PhysicsSystem& m_Sys;
+  };
+
   struct ShapesCache
   {
     btCollisionShape* MakeGeom(const GeomDef& iDef, btCompoundShape* iCont);
@@ -61,7 +108,7 @@ namespace eXl
   {
   public:
 
-    PhysicsSystem_Impl(PhysicsSystem& iSys);
+    PhysicsSystem_Impl(PhysicsSystem& iSys, NeighborhoodKind iNeighKind);
     ~PhysicsSystem_Impl();
 
     //BulletRootComp                          m_Comp;
@@ -73,6 +120,8 @@ namespace eXl
     btDynamicsWorld*                        m_dynamicsWorld;
 
     NeighborhoodExtractionImpl              m_NeighExtraction;
+    //Replaces m_NeighExtraction when set.
+    UniquePtr<GridNeighborhoodExtractionImpl> m_GridNeighExtraction;
 
     UnorderedSet<IntrusivePtr<PhysicComponent_Impl>> m_ToDelete;
     PhysicsSystem& m_HostSys;
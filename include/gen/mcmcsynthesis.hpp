@@ -20,6 +20,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 namespace eXl
 {
   class Random;
+  class JobSystem;
 
   namespace MCMC2D
   {
@@ -312,10 +313,16 @@ namespace eXl
 
       float m_Temperature = 1.0;
 
+      // Parallel tempering : replicas run at temperatures spread up to m_MaxTemperature,
+      // swapping their temperatures every m_ExchangeInterval steps.
+      unsigned int m_NumChains = 1;
+      float m_MaxTemperature = 8.0;
+      unsigned int m_ExchangeInterval = 200;
+
       SERIALIZE_METHODS;
     };
 
-    EXL_GEN_API void Run(Random& iRand, RunParams& iParams, LearnedModel* model, Debug* iDebug = nullptr);
+    EXL_GEN_API void Run(Random& iRand, RunParams& iParams, LearnedModel* model, Debug* iDebug = nullptr, JobSystem* iJobs = nullptr);
     EXL_GEN_API Image DrawDbgImg(LearnedModel* iModel, uint32_t iOneHotIdx);
 #ifdef EXL_IMAGESTREAMER_ENABLED
     EXL_GEN_API void DrawDbgImg(String const& iPath, LearnedModel* model);
@@ -39,6 +39,29 @@ namespace eXl
     }
   };
 
+  // Solves repeated implicit diffusion steps (I - k * L) x = b for a fixed matrix and heat coefficient.
+  class DiffusionSolver : public HeapObject
+  {
+  public:
+    enum Method
+    {
+      // Sparse LU of the system, factorized once when the solver is built.
+      Direct,
+      // Jacobi preconditioned conjugate gradient, warm started from the field to diffuse.
+      // Needs a symmetric matrix, falls back to Direct otherwise.
+      ConjugateGradient
+    };
+
+    virtual ~DiffusionSolver()
+    {
+    }
+
+    virtual Method GetMethod() const = 0;
+
+    virtual void Solve(Vector<float>& ioValues) = 0;
+    virtual void Solve(Vector<Vector<float>>& ioFields) = 0;
+  };
+
   class EXL_GEN_API Terrain
   {
   public:
@@ -69,8 +92,13 @@ namespace eXl
 
     void BuildSmoothingMatrix(LaplaceMatrix*& oMatrix);
     void BuildLaplaceMatrix(ConductivityGetter& iGetter, LaplaceMatrix*& oMatrix);
+    // Keeps the factorization in iMatrix, repeated calls with the same coefficient only solve.
     void Diffusion(LaplaceMatrix const* iMatrix, float iHeatCoefficient, Vector<float>& ioValues);
 
+    // Prefer a solver when the same matrix and coefficient are applied several times.
+    // iTolerance is the relative residual the conjugate gradient stops at.
+    void BuildDiffusionSolver(LaplaceMatrix const* iMatrix, float iHeatCoefficient, DiffusionSolver::Method iMethod, DiffusionSolver*& oSolver, float iTolerance = 1.0e-6);
+
     struct OutputBuffer
     {
       void* data;
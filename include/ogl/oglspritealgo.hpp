@@ -18,6 +18,8 @@ namespace eXl
 {
   class OGLProgram;
   class OGLCompiledProgram;
+  class OGLBuffer;
+  struct OGLVAssembly;
 
   struct EXL_OGL_API CameraMatrix
   {
@@ -65,6 +67,15 @@ namespace eXl
     float alphaMult = 1.0;
   };
 
+  //Per-instance vertex data consumed by the instanced sprite program.
+  struct SpriteInstance
+  {
+    Mat4 worldMatrix;
+    Vec4 tcOffsetScaling;
+    Vec4 tint;
+    float alphaMult;
+  };
+
   class EXL_OGL_API OGLSpriteAlgo
   {
   public:
@@ -75,6 +86,16 @@ namespace eXl
 
     static OGLCompiledProgram const* CreateSpriteProgram(OGLSemanticManager& iSemantics, bool iFiltered = true);
 
+    static OGLCompiledProgram const* CreateInstancedSpriteProgram(OGLSemanticManager& iSemantics);
+
+    //Adds the per-instance attributes to iAssembly, reading SpriteInstance records starting at iOffset in iInstances.
+    static void AddInstanceAttribs(OGLVAssembly& iAssembly, OGLBuffer const* iInstances, uint32_t iOffset);
+
+    static AttributeName GetInstanceWorldAttrib(uint32_t iColumn);
+    static AttributeName GetInstanceTexCoordAttrib();
+    static AttributeName GetInstanceTintAttrib();
+    static AttributeName GetInstanceAlphaMultAttrib();
+
     static OGLCompiledProgram const* CreateFontProgram(OGLSemanticManager& iSemantics);
 
     static UniformName GetSpriteColorUniform();
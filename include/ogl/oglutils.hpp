@@ -21,6 +21,11 @@ namespace eXl
 
     static void Init();
 
+    // Headless mode skips every GL call, so GL resources are created with a 0 name
+    // and rendering can be recorded without a context. Always on without EXL_WITH_OGL.
+    static void SetHeadless(bool iHeadless);
+    static bool IsHeadless();
+
     static void CheckOGLState(char const* iFile, int iLine);
 
     static uint32_t CompileVertexShader(char const* iSource);
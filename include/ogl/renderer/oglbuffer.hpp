@@ -12,6 +12,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 #include <core/heapobject.hpp>
 #include <core/refcobject.hpp>
+#include <core/containers.hpp>
 #include <ogl/oglexp.hpp>
 #include <ogl/renderer/ogltypes.hpp>
 
@@ -44,6 +45,8 @@ namespace eXl
     OGLBufferUsage m_Usage;
     uint32_t m_Id;
     size_t m_Size;
+    // In headless mode, a buffer is an opaque handle keeping a CPU copy of its content.
+    Vector<uint8_t> m_Shadow;
   };
 
 }
\ No newline at end of file
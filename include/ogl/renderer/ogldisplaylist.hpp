@@ -25,6 +25,7 @@ namespace eXl
 {
   class OGLCompiledProgram;
   class OGLRenderContext;
+  class OGLRecordingContext;
   class OGLFramebuffer;
   class OGLSemanticManager;
   
@@ -73,13 +74,38 @@ namespace eXl
 
     void Render(OGLRenderContext* iCtx, OGLFramebuffer* iFBO = NULL);
 
+    // Same command stream as the GL render, recorded instead of executed.
+    void Render(OGLRecordingContext* iCtx, OGLFramebuffer* iFBO = NULL);
+
+    // Sub-lists let several threads record at once. InitSubList starts oSubList from the current
+    // states, program, assembly and data stack of this list, and Merge appends what it recorded.
+    // Merging sub-lists in a fixed order gives the same result as recording them in sequence.
+    void InitSubList(OGLDisplayList& oSubList);
+
+    // Merge leaves iSubList untouched, so content which does not change can be recorded once and merged every frame.
+    void Merge(OGLDisplayList& iSubList);
+
+    // True if iSubList was started from the states, program, assembly and data stack currently set on this list,
+    // and can be merged again without recording it again.
+    bool IsSubListCurrent(OGLDisplayList& iSubList);
+
   protected:
 
     void FlushDraws();
 
+    uint32_t FindOrAddDataSet(OGLShaderData const* iData, uint32_t iPrevSet);
+
+    void GrowDataSetTable();
+
+    void SortKeys();
+
     void FillDrawHeader(OGLDraw& iDraw, uint8_t iTopo);
 
-    void HandleDataSet(OGLRenderContext* iCtx, OGLShaderDataSet const* iSet);
+    template <class Context>
+    void RenderImpl(Context* iCtx, OGLFramebuffer* iFBO);
+
+    template <class Context>
+    void HandleDataSet(Context* iCtx, OGLShaderDataSet const* iSet);
 
     struct PendingDraw
     {
@@ -108,9 +134,9 @@ namespace eXl
     //OGLShaderDataSet const* m_CurDataSet;
     uint32_t m_CurDataSet = -1;
 
-    //Need custom allocator
     Vector<OGLShaderDataSet> m_DataSetStore;
-    UnorderedSet<OGLShaderDataSet> m_DataSetSeek;
+    // Open-addressed, indices in m_DataSetStore. Cleared every frame, but keeps its size.
+    Vector<uint32_t> m_DataSetTable;
 
     struct CommandKey
     {
@@ -123,8 +149,18 @@ namespace eXl
       size_t   m_Offset;
     };
     std::vector<CommandKey> m_Keys;
+    std::vector<CommandKey> m_SortScratch;
     std::vector<uint8_t> m_Commands;
 
+    // Sub-list dataset and state ids translated by Merge.
+    Vector<uint32_t> m_DataSetRemap;
+    Vector<uint16_t> m_StateRemap;
+
+    // What InitSubList set up a sub-list with, checked by IsSubListCurrent.
+    OGLCompiledProgram const* m_InheritedProgram = nullptr;
+    OGLVAssembly const* m_InheritedAssembly = nullptr;
+    Vector<OGLShaderData const*> m_InheritedData;
+
     uint32_t m_Timestamp;
     //Data set for each slot.
     struct DataSetup
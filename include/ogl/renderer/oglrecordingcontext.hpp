@@ -0,0 +1,138 @@
+/*
+Copyright 2009-2021 Nicolas Colombe
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <ogl/renderer/oglrendercontext.hpp>
+#include <core/containers.hpp>
+
+namespace eXl
+{
+  // Render context which never talks to GL, with the entry points of OGLRenderContext.
+  // Records the command stream it receives and counts the work a GL context would have done,
+  // to measure the CPU side of rendering without a window or a driver.
+  class EXL_OGL_API OGLRecordingContext final
+  {
+  public:
+
+    enum class Op : uint8_t
+    {
+      SetFramebuffer,
+      SetProgram,
+      SetVertexAttrib,
+      SetUniformData,
+      SetUniformBuffer,
+      SetTexture,
+      SetState,
+      ClearBuffers,
+      Draw,
+      DrawIndexed,
+      DrawInstanced,
+      DrawIndexedInstanced,
+      Clear
+    };
+
+    struct Command
+    {
+      Op m_Op;
+      // Semantic slot for bindings, state kind for SetState.
+      uint32_t m_Slot;
+      // Program, buffer, texture or uniform data.
+      void const* m_Object;
+      // Vertices or indices for draws.
+      uint32_t m_Count;
+      uint32_t m_Instances;
+    };
+
+    struct Stats
+    {
+      uint32_t m_Programs = 0;
+      uint32_t m_VertexAttribs = 0;
+      uint32_t m_Uniforms = 0;
+      uint32_t m_UniformBuffers = 0;
+      uint32_t m_Textures = 0;
+      uint32_t m_StateChanges = 0;
+      uint32_t m_Clears = 0;
+      uint32_t m_Draws = 0;
+      uint64_t m_Vertices = 0;
+      uint64_t m_Instances = 0;
+      // Bindings which did not change what was bound to their slot.
+      uint32_t m_RedundantBinds = 0;
+    };
+
+    // Counting alone is much cheaper than keeping the command stream around for large frames.
+    OGLRecordingContext(bool iRecordCommands = true);
+
+    void Reset();
+
+    Stats const& GetStats() const { return m_Stats; }
+    Vector<Command> const& GetCommands() const { return m_Commands; }
+
+    //Draw calls issued since the context was created or reset.
+    uint32_t GetNumDraws() const { return m_NumDraws; }
+
+    void Clear();
+
+    void SetFramebuffer(OGLFramebuffer* iFBO);
+
+    void SetProgram(OGLCompiledProgram const* iProgram);
+
+    void SetVertexAttrib(uint32_t iAttribName, OGLBuffer const* iBuffer, uint32_t iNum, size_t iStride, size_t iOffset);
+
+    void SetUniformData(uint32_t iDataName, void const* iData);
+
+    void SetUniformBuffer(uint32_t iDataName, OGLBuffer const* iBuffer);
+
+    void SetTexture(uint32_t iTexName, OGLTexture const* iTex);
+
+    void SetState(OGLDepthCommand const& iCmd);
+    void SetState(OGLScissorCommand const& iCmd);
+    void SetState(OGLViewportCommand const& iCmd);
+    void SetState(OGLBlendCommand const& iCmd);
+
+    void ClearBuffers(bool iClearColor, bool iClearDepth, Vec4 const& iColor, float iDepth);
+
+    void Draw(OGLConnectivity iTopo, uint32_t iFirstVertex, uint32_t iNumVertices);
+
+    void DrawIndexed(OGLBuffer const* iBuffer, OGLConnectivity iTopo, uint32_t iOffset, uint32_t iBaseVertex, uint32_t iNumIndices);
+#ifndef __ANDROID__
+    void DrawInstanced(OGLConnectivity iTopo, uint32_t iNumInstances, uint32_t iBaseInstance, uint32_t iFirstVertex, uint32_t iNumVertices);
+    void DrawIndexedInstanced(OGLBuffer const* iBuffer, OGLConnectivity iTopo, uint32_t iNumInstances, uint32_t iBaseInstance, uint32_t iOffset, uint32_t iBaseVertex, uint32_t iNumVertices);
+#else
+    void DrawInstanced(OGLConnectivity iTopo, uint32_t iNumInstances, uint32_t iFirstVertex, uint32_t iNumVertices);
+    void DrawIndexedInstanced(OGLBuffer const* iBuffer, OGLConnectivity iTopo, uint32_t iNumInstances, uint32_t iOffset, uint32_t iBaseVertex, uint32_t iNumVertices);
+#endif
+
+  protected:
+
+    enum StateKind
+    {
+      DepthState,
+      ScissorState,
+      ViewportState,
+      BlendState
+    };
+
+    void ResetBindings();
+    void Record(Op iOp, uint32_t iSlot, void const* iObject, uint32_t iCount = 0, uint32_t iInstances = 0);
+    bool Bind(Vector<void const*>& ioBound, uint32_t iSlot, void const* iObject);
+    void AddDraw(Op iOp, void const* iBuffer, uint32_t iCount, uint32_t iInstances);
+
+    Vector<Command> m_Commands;
+    Stats m_Stats;
+    bool m_RecordCommands;
+    uint32_t m_NumDraws = 0;
+
+    OGLCompiledProgram const* m_CurProgram = nullptr;
+    Vector<void const*> m_BoundData;
+    Vector<void const*> m_BoundUBO;
+    Vector<void const*> m_BoundTextures;
+  };
+}
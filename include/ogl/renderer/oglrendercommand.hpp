@@ -22,7 +22,6 @@ namespace eXl
   class OGLBuffer;
   class OGLShaderData;
   class OGLCompiledProgram;
-  class OGLRenderContext;
 
   struct OGLRenderCommand
   {
@@ -69,7 +68,7 @@ namespace eXl
     }
     inline bool operator == (OGLScissorCommand const& iOther) const {return ! operator!=(iOther);}
 
-    void Apply();
+    void Apply() const;
 
     uint16_t m_Flag = 0;
     uint16_t m_Padding = 0;
@@ -91,7 +90,7 @@ namespace eXl
     }
     inline bool operator == (OGLDepthCommand const& iOther) const {return ! operator!=(iOther);}
 
-    void Apply();
+    void Apply() const;
 
     uint16_t m_Flag = 0;
     uint16_t m_Padding = 0;
@@ -106,7 +105,7 @@ namespace eXl
     }
     inline bool operator == (OGLViewportCommand const& iOther) const {return ! operator!=(iOther);}
 
-    void Apply();
+    void Apply() const;
     uint16_t m_Flag = 0;
     uint16_t m_Padding = 0;
     Vec2i m_Orig;
@@ -130,7 +129,7 @@ namespace eXl
     }
     inline bool operator == (OGLBlendCommand const& iOther) const { return !operator!=(iOther); }
 
-    void Apply();
+    void Apply() const;
 
     uint16_t m_Flag = 0;
     uint16_t m_Padding = 0;
@@ -200,7 +199,16 @@ namespace eXl
     IntrusivePtr<OGLBuffer const> m_IBuffer;
     uint32_t m_IOffset;
 
-    void Apply(OGLSemanticManager const& iSemantics, OGLRenderContext* ) const;
+    template <class Context>
+    void Apply(OGLSemanticManager const& iSemantics, Context* iCtx) const
+    {
+      for(uint32_t i = 0; i<m_Attribs.size(); ++i)
+      {
+        VtxAttrib const& curAttr = m_Attribs[i];
+        uint32_t slot = iSemantics.GetSlotForName(curAttr.m_AttribName);
+        iCtx->SetVertexAttrib(slot, curAttr.m_VBuffer.get(), curAttr.m_Num, curAttr.m_Stride, curAttr.m_Offset);
+      }
+    }
   };
 
   struct OGLShaderDataSet
@@ -11,6 +11,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #pragma once
 
 #include <core/coredef.hpp>
+#include <math/math.hpp>
 #include <ogl/oglexp.hpp>
 #include <ogl/renderer/ogltypes.hpp>
 
@@ -22,8 +23,15 @@ namespace eXl
   class OGLCompiledProgram;
   class OGLRenderContextImpl;
   class OGLSemanticManager;
-
-  class EXL_OGL_API OGLRenderContext
+  struct OGLDepthCommand;
+  struct OGLScissorCommand;
+  struct OGLViewportCommand;
+  struct OGLBlendCommand;
+
+  // Executes display lists against the current GL context.
+  // OGLRecordingContext has the same entry points, display lists are rendered through either
+  // with templates so the GL path stays free of virtual calls.
+  class EXL_OGL_API OGLRenderContext final
   {
   public:
 
@@ -47,6 +55,14 @@ namespace eXl
 
     void SetTexture(uint32_t iTexName, OGLTexture const* iTex);
 
+    // Fixed function state, called by the display list when the state id of a command changes.
+    void SetState(OGLDepthCommand const& iCmd);
+    void SetState(OGLScissorCommand const& iCmd);
+    void SetState(OGLViewportCommand const& iCmd);
+    void SetState(OGLBlendCommand const& iCmd);
+
+    void ClearBuffers(bool iClearColor, bool iClearDepth, Vec4 const& iColor, float iDepth);
+
     void Draw(OGLConnectivity iTopo, uint32_t iFirstVertex, uint32_t iNumVertices);
 
     void DrawIndexed(OGLBuffer const* iBuffer, OGLConnectivity iTopo, uint32_t iOffset, uint32_t iBaseVertex, uint32_t iNumIndices);
@@ -58,7 +74,11 @@ namespace eXl
     void DrawIndexedInstanced(OGLBuffer const* iBuffer, OGLConnectivity iTopo, uint32_t iNumInstances, uint32_t iOffset, uint32_t iBaseVertex, uint32_t iNumVertices);
 #endif
 
+    //Draw calls issued since the context was created.
+    uint32_t GetNumDraws() const { return m_NumDraws; }
+
   protected:
-    OGLRenderContextImpl* m_Impl;
+    OGLRenderContextImpl* m_Impl = nullptr;
+    uint32_t m_NumDraws = 0;
   };
 }
@@ -31,6 +31,7 @@ namespace eXl
   public:
     uint16_t GetCommandId(StateCommand const& iCmd);
     StateCommand const& GetCommand(uint16_t iId) { return m_Commands[iId]; }
+    void ClearCommands() { m_CommandsId.clear(); m_Commands.clear(); }
   protected:
     UnorderedMap<StateCommand, uint16_t> m_CommandsId;
     Vector<StateCommand> m_Commands;
@@ -68,14 +69,28 @@ namespace eXl
 
     inline void InitForPush();
 
-    inline void InitForRender();
+    // Context is OGLRenderContext or OGLRecordingContext.
+    template <class Context>
+    inline void InitForRender(Context* iCtx);
 
-    inline void ApplyCommand(uint16_t iCmdId);
+    template <class Context>
+    inline void ApplyCommand(uint16_t iCmdId, Context* iCtx);
 
     inline uint16_t GetStateId();
 
     inline uint16_t GetCurState() const {return m_CurrentState;}
 
+    inline uint32_t GetNumStates() const { return m_StateIds.size(); }
+
+    // Makes the commands currently set in iOther the current ones of this collection.
+    inline void InheritCommands(OGLStateCollection& iOther);
+
+    // True if the commands currently set in iOther are the ones InheritCommands last took.
+    inline bool HasInheritedCommands(OGLStateCollection& iOther);
+
+    // Id in this collection of the state iStateId of iOther, registered if needed.
+    inline uint16_t ImportState(OGLStateCollection& iOther, uint16_t iStateId);
+
     template <class StateCommand>
     inline StateCommand const& GetCurrentSetCommand();
 
@@ -122,5 +137,6 @@ namespace eXl
     UnorderedMap<StateIds, uint16_t, StateIdHasher, std::equal_to<StateIds>> m_StateAssoc;
     Vector<StateStorage> m_States;
     Vector<StateIds> m_StateIds;
+    StateStorage m_Inherited;
   };
 }
\ No newline at end of file
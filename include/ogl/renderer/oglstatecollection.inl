@@ -113,67 +113,91 @@ namespace eXl
     }
   }
 
+  template <class StateCommand>
+  struct ClearCommandsHandler
+  {
+    inline static void Do(StateCommandHandler<StateCommand>& iHandler)
+    {
+      iHandler.ClearCommands();
+    }
+  };
+
   template <typename... Commands>
   inline void OGLStateCollection<Commands...>::InitForPush()
   {
-    
+    // Ids are only valid for a frame, keep the storage around for the next one.
+    ForEachUnwrapper<ClearCommandsHandler, Commands...>::Do(*this);
+    m_StateAssoc.clear();
+    m_States.clear();
+    m_StateIds.clear();
+    m_CurStateUpToDate = false;
   }
 
+  template <class Context>
   struct ApplyCommandCtx
   {
     int curIdx = 0;
     uint16_t const* prevState;
     uint16_t const* nextState;
+    Context* renderCtx;
   };
 
-  template <class StateCommand>
+  template <class Context>
   struct ApplyCommandHandler
   {
-    typedef ApplyCommandCtx& value_type1;
-    inline static void Do(CommandStorage<StateCommand>& iCmd, ApplyCommandCtx& iCtx)
+    template <class StateCommand>
+    struct Handler
     {
-      if (*iCtx.prevState != *iCtx.nextState)
+      typedef ApplyCommandCtx<Context>& value_type1;
+      inline static void Do(CommandStorage<StateCommand>& iCmd, ApplyCommandCtx<Context>& iCtx)
       {
-        iCmd.m_Command.Apply();
-      }
+        if (*iCtx.prevState != *iCtx.nextState)
+        {
+          iCtx.renderCtx->SetState(iCmd.m_Command);
+        }
 
-      ++iCtx.curIdx;
-      ++iCtx.prevState;
-      ++iCtx.nextState;
-    }
+        ++iCtx.curIdx;
+        ++iCtx.prevState;
+        ++iCtx.nextState;
+      }
+    };
   };
 
   template <typename... Commands>
-  inline void OGLStateCollection<Commands...>::InitForRender()
+  template <class Context>
+  inline void OGLStateCollection<Commands...>::InitForRender(Context* iCtx)
   {
     if (!m_StateIds.empty())
     {
       StateIds dummy;
       std::fill(dummy.m_Commands, dummy.m_Commands + GetListSize<Commands...>::result, 0xFFFF);
 
-      ApplyCommandCtx ctx;
+      ApplyCommandCtx<Context> ctx;
       ctx.prevState = dummy.m_Commands;
       ctx.nextState = m_StateIds[0].m_Commands;
+      ctx.renderCtx = iCtx;
       ctx.curIdx = 0;
 
-      ForEachUnwrapper<ApplyCommandHandler, Commands...>::Do(m_States[0], ctx);
+      ForEachUnwrapper<ApplyCommandHandler<Context>::template Handler, Commands...>::Do(m_States[0], ctx);
       m_CurrentState = 0;
     }
   }
 
   template <typename... Commands>
-  inline void OGLStateCollection<Commands...>::ApplyCommand(uint16_t iCmdId)
+  template <class Context>
+  inline void OGLStateCollection<Commands...>::ApplyCommand(uint16_t iCmdId, Context* iCtx)
   {
     if(iCmdId != m_CurrentState)
     {
       eXl_ASSERT_REPAIR_RET(iCmdId < m_States.size(), );
 
-      ApplyCommandCtx ctx;
+      ApplyCommandCtx<Context> ctx;
       ctx.prevState = m_StateIds[m_CurrentState].m_Commands;
       ctx.nextState = m_StateIds[iCmdId].m_Commands;
+      ctx.renderCtx = iCtx;
       ctx.curIdx = 0;
       
-      ForEachUnwrapper<ApplyCommandHandler, Commands...>::Do(m_States[iCmdId], ctx);
+      ForEachUnwrapper<ApplyCommandHandler<Context>::template Handler, Commands...>::Do(m_States[iCmdId], ctx);
 
       m_CurrentState = iCmdId;
     }
@@ -234,4 +258,63 @@ namespace eXl
       return newId;
     }
   }
+  template <class StateCommand>
+  struct ImportCommandsHandler
+  {
+    template <typename... Commands>
+    inline static void Do(CommandStorage<StateCommand>& iCmd, GatherCommandsCtx<Commands...>& iCtx)
+    {
+      iCtx.collection.SetDefaultCommand(iCmd.m_Command);
+    }
+  };
+
+  template <typename... Commands>
+  inline void OGLStateCollection<Commands...>::InheritCommands(OGLStateCollection& iOther)
+  {
+    StateStorage curCommands;
+    GatherCommandsCtx<Commands...> gatherCtx(iOther);
+    ForEachUnwrapper<GatherCommandsHandler, Commands...>::Do(curCommands, gatherCtx);
+
+    GatherCommandsCtx<Commands...> importCtx(*this);
+    ForEachUnwrapper<ImportCommandsHandler, Commands...>::Do(curCommands, importCtx);
+    m_Inherited = curCommands;
+  }
+
+  template <class StateCommand>
+  struct CompareCommandsHandler
+  {
+    template <typename Storage>
+    inline static void Do(CommandStorage<StateCommand>& iCmd, Storage& iOther, bool& ioSame)
+    {
+      ioSame = ioSame && static_cast<CommandStorage<StateCommand>&>(iOther).m_Command == iCmd.m_Command;
+    }
+  };
+
+  template <typename... Commands>
+  inline bool OGLStateCollection<Commands...>::HasInheritedCommands(OGLStateCollection& iOther)
+  {
+    StateStorage curCommands;
+    GatherCommandsCtx<Commands...> gatherCtx(iOther);
+    ForEachUnwrapper<GatherCommandsHandler, Commands...>::Do(curCommands, gatherCtx);
+
+    bool same = true;
+    ForEachUnwrapper<CompareCommandsHandler, Commands...>::Do(curCommands, m_Inherited, same);
+    return same;
+  }
+
+  template <typename... Commands>
+  inline uint16_t OGLStateCollection<Commands...>::ImportState(OGLStateCollection& iOther, uint16_t iStateId)
+  {
+    eXl_ASSERT(iStateId < iOther.m_States.size());
+
+    StateIds const prevCommand = m_NextCommand;
+    GatherCommandsCtx<Commands...> ctx(*this);
+    ForEachUnwrapper<ImportCommandsHandler, Commands...>::Do(iOther.m_States[iStateId], ctx);
+    uint16_t const stateId = GetStateId();
+
+    m_NextCommand = prevCommand;
+    m_CurStateUpToDate = false;
+
+    return stateId;
+  }
 }
\ No newline at end of file
@@ -50,6 +50,7 @@ namespace eXl
   IMPLEMENT_RTTI(Reader);
   IMPLEMENT_RTTI(Writer);
   IMPLEMENT_RTTI(StdOutWriter);
+  IMPLEMENT_RTTI(BinaryWriter);
 
   namespace
   {
@@ -0,0 +1,152 @@
+/*
+Copyright 2009-2021 Nicolas Colombe
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <core/framearena.hpp>
+#include <core/memorymanager.hpp>
+
+#include <cstring>
+#include <new>
+
+namespace eXl
+{
+  namespace
+  {
+#ifdef _DEBUG
+    // Recognizable pattern for memory read after the end of its frame.
+    constexpr uint8_t s_PoisonByte = 0xDD;
+#endif
+  }
+
+  FrameArena::FrameArena(size_t iBlockSize)
+    : m_Current(nullptr)
+    , m_BlockSize(iBlockSize)
+  {
+  }
+
+  FrameArena::~FrameArena()
+  {
+    Block* block = m_Current.load();
+    while (block)
+    {
+      Block* prev = block->m_Prev;
+      block->~Block();
+      MemoryManager::Free(block, false);
+      block = prev;
+    }
+  }
+
+  FrameArena::Block* FrameArena::AllocBlock(size_t iSize, Block* iPrev)
+  {
+    Block* block = new(MemoryManager::Allocate(sizeof(Block) + iSize)) Block;
+    block->m_Prev = iPrev;
+    block->m_Size = iSize;
+    block->m_Offset.store(0, std::memory_order_relaxed);
+    return block;
+  }
+
+  FrameArena::Block* FrameArena::Grow(Block* iFull, size_t iMinSize)
+  {
+    std::unique_lock<std::mutex> lock(m_GrowLock);
+    Block* current = m_Current.load(std::memory_order_acquire);
+    if (current != iFull)
+    {
+      // Another thread already added a block.
+      return current;
+    }
+    Block* newBlock = AllocBlock(iMinSize > m_BlockSize ? iMinSize : m_BlockSize, current);
+    m_Current.store(newBlock, std::memory_order_release);
+    return newBlock;
+  }
+
+  void* FrameArena::Alloc(size_t iSize, size_t iAlignment)
+  {
+    Block* block = m_Current.load(std::memory_order_acquire);
+    if (block == nullptr)
+    {
+      block = Grow(nullptr, iSize + iAlignment);
+    }
+
+    while (true)
+    {
+      uintptr_t const data = reinterpret_cast<uintptr_t>(block->GetData());
+      size_t offset = block->m_Offset.load(std::memory_order_relaxed);
+      size_t allocEnd;
+      size_t allocBegin;
+      do
+      {
+        allocBegin = ((data + offset + iAlignment - 1) & ~uintptr_t(iAlignment - 1)) - data;
+        allocEnd = allocBegin + iSize;
+      } while (allocEnd <= block->m_Size
+        && !block->m_Offset.compare_exchange_weak(offset, allocEnd, std::memory_order_relaxed));
+
+      if (allocEnd <= block->m_Size)
+      {
+        return block->GetData() + allocBegin;
+      }
+      block = Grow(block, iSize + iAlignment);
+    }
+  }
+
+  void FrameArena::Reset()
+  {
+    Block* block = m_Current.load(std::memory_order_relaxed);
+    if (block == nullptr)
+    {
+      return;
+    }
+
+    if (block->m_Prev != nullptr)
+    {
+      size_t totalSize = 0;
+      while (block)
+      {
+        totalSize += block->m_Size;
+        Block* prev = block->m_Prev;
+#ifdef _DEBUG
+        memset(block->GetData(), s_PoisonByte, block->m_Size);
+#endif
+        block->~Block();
+        MemoryManager::Free(block, false);
+        block = prev;
+      }
+      m_Current.store(AllocBlock(totalSize, nullptr), std::memory_order_relaxed);
+    }
+    else
+    {
+#ifdef _DEBUG
+      memset(block->GetData(), s_PoisonByte, block->m_Offset.load(std::memory_order_relaxed));
+#endif
+      block->m_Offset.store(0, std::memory_order_relaxed);
+    }
+
+    ++m_Generation;
+  }
+
+  size_t FrameArena::GetAllocatedBytes() const
+  {
+    size_t allocated = 0;
+    for (Block* block = m_Current.load(std::memory_order_relaxed); block; block = block->m_Prev)
+    {
+      size_t const offset = block->m_Offset.load(std::memory_order_relaxed);
+      allocated += offset < block->m_Size ? offset : block->m_Size;
+    }
+    return allocated;
+  }
+
+  size_t FrameArena::GetCapacity() const
+  {
+    size_t capacity = 0;
+    for (Block* block = m_Current.load(std::memory_order_relaxed); block; block = block->m_Prev)
+    {
+      capacity += block->m_Size;
+    }
+    return capacity;
+  }
+}
@@ -12,9 +12,9 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <new>
 #include <map>
 #include <mutex>
-#include <boost/multi_index_container.hpp>
-#include <boost/multi_index/ordered_index.hpp>
-#include <boost/multi_index/member.hpp>
+#include <algorithm>
+#include <unordered_map>
+#include <cstring>
 #include <core/coredef.hpp>
 #include <core/log.hpp>
 
@@ -26,6 +26,287 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 namespace eXl
 {
+  namespace
+  {
+    // Every block starts with this header, so that Free and GetNum do not need a lookup.
+    struct BlockHeader
+    {
+      uint32_t m_SizeClass;
+      uint32_t m_NumElems;
+      uint64_t m_Size;
+    };
+    static_assert(sizeof(BlockHeader) == 16, "The header keeps the 16 bytes alignment of the blocks");
+
+    struct FreeBlock
+    {
+      FreeBlock* m_Next;
+    };
+
+    // 16 bytes steps up to 256, then 4 steps per power of 2 up to 16KB. Bigger blocks go to s_AllocFn.
+    constexpr uint32_t s_NumSizeClasses = 16 + 6 * 4;
+    constexpr uint32_t s_MaxSmallSize = 16384;
+    constexpr uint32_t s_LargeClass = 0xFFFFFFFF;
+    constexpr uint32_t s_SpanSize = 64 * 1024;
+
+    struct SizeClasses
+    {
+      // Constant initialized, allocations can happen before the dynamic initialization of this file.
+      constexpr SizeClasses()
+      {
+        for (uint32_t i = 0; i < s_NumSizeClasses; ++i)
+        {
+          if (i < 16)
+          {
+            m_Size[i] = (i + 1) * 16;
+          }
+          else
+          {
+            uint32_t const step = i - 16;
+            uint32_t const pow2 = 256 << (step / 4);
+            m_Size[i] = pow2 + (step % 4 + 1) * (pow2 / 4);
+          }
+          // Keep about 32KB in a batch.
+          m_BatchSize[i] = std::max<uint32_t>(4, std::min<uint32_t>(128, 32 * 1024 / m_Size[i]));
+        }
+        uint32_t curClass = 0;
+        for (uint32_t i = 0; i < s_MaxSmallSize / 16; ++i)
+        {
+          while (m_Size[curClass] < (i + 1) * 16)
+          {
+            ++curClass;
+          }
+          m_ClassOfSize[i] = curClass;
+        }
+      }
+
+      uint32_t GetClass(size_t iBlockSize) const
+      {
+        return iBlockSize <= s_MaxSmallSize ? m_ClassOfSize[(iBlockSize - 1) / 16] : s_LargeClass;
+      }
+
+      uint32_t m_Size[s_NumSizeClasses] = {};
+      uint32_t m_BatchSize[s_NumSizeClasses] = {};
+      uint8_t m_ClassOfSize[s_MaxSmallSize / 16] = {};
+    };
+
+    constexpr SizeClasses s_Classes;
+  }
+
+  static void*(*s_AllocFn)(size_t) = &malloc;
+  static void(*s_FreeFn)(void*) = &free;
+
+  namespace
+  {
+    void* AllocFromSystem(size_t iSize)
+    {
+      return s_AllocFn(iSize);
+    }
+
+    void FreeToSystem(void* iPtr)
+    {
+      s_FreeFn(iPtr);
+    }
+
+    // Shared by all threads, refills the thread caches in batches. Spans are never given back to the system.
+    struct CentralDepot
+    {
+      struct ClassList
+      {
+        std::mutex m_Lock;
+        FreeBlock* m_Free = nullptr;
+      };
+
+      FreeBlock* Fetch(uint32_t iClass, uint32_t iNumBlocks)
+      {
+        ClassList& list = m_Lists[iClass];
+        std::unique_lock<std::mutex> lock(list.m_Lock);
+        if (list.m_Free == nullptr)
+        {
+          uint32_t const blockSize = s_Classes.m_Size[iClass];
+          uint32_t const spanSize = std::max(s_SpanSize, blockSize * iNumBlocks);
+          char* span = (char*)AllocFromSystem(spanSize);
+          if (span == nullptr)
+          {
+            return nullptr;
+          }
+          FreeBlock* chain = nullptr;
+          for (uint32_t offset = (spanSize / blockSize) * blockSize; offset > 0; offset -= blockSize)
+          {
+            FreeBlock* block = (FreeBlock*)(span + offset - blockSize);
+            block->m_Next = chain;
+            chain = block;
+          }
+          list.m_Free = chain;
+        }
+
+        FreeBlock* batch = list.m_Free;
+        FreeBlock* last = batch;
+        for (uint32_t i = 1; i < iNumBlocks && last->m_Next != nullptr; ++i)
+        {
+          last = last->m_Next;
+        }
+        list.m_Free = last->m_Next;
+        last->m_Next = nullptr;
+        return batch;
+      }
+
+      void Release(uint32_t iClass, FreeBlock* iFirst, FreeBlock* iLast)
+      {
+        ClassList& list = m_Lists[iClass];
+        std::unique_lock<std::mutex> lock(list.m_Lock);
+        iLast->m_Next = list.m_Free;
+        list.m_Free = iFirst;
+      }
+
+      ClassList m_Lists[s_NumSizeClasses];
+    };
+
+    CentralDepot& GetDepot()
+    {
+      // Never destroyed, blocks can be freed until the very end of the program.
+      alignas(CentralDepot) static char s_Storage[sizeof(CentralDepot)];
+      static CentralDepot* s_Depot = new(s_Storage) CentralDepot;
+      return *s_Depot;
+    }
+
+    struct ThreadCache;
+    thread_local ThreadCache* t_Cache = nullptr;
+    thread_local bool t_CacheDestroyed = false;
+
+    // Lock-free fast path, each thread keeps a few batches of free blocks per size class.
+    struct ThreadCache
+    {
+      struct ClassList
+      {
+        FreeBlock* m_Free = nullptr;
+        uint32_t m_Count = 0;
+      };
+
+      ~ThreadCache()
+      {
+        for (uint32_t i = 0; i < s_NumSizeClasses; ++i)
+        {
+          if (m_Lists[i].m_Free)
+          {
+            FreeBlock* last = m_Lists[i].m_Free;
+            while (last->m_Next)
+            {
+              last = last->m_Next;
+            }
+            GetDepot().Release(i, m_Lists[i].m_Free, last);
+          }
+        }
+        t_Cache = nullptr;
+        t_CacheDestroyed = true;
+      }
+
+      void* Alloc(uint32_t iClass)
+      {
+        ClassList& list = m_Lists[iClass];
+        if (list.m_Free == nullptr)
+        {
+          list.m_Free = GetDepot().Fetch(iClass, s_Classes.m_BatchSize[iClass]);
+          if (list.m_Free == nullptr)
+          {
+            return nullptr;
+          }
+          for (FreeBlock* block = list.m_Free; block; block = block->m_Next)
+          {
+            ++list.m_Count;
+          }
+        }
+        FreeBlock* block = list.m_Free;
+        list.m_Free = block->m_Next;
+        --list.m_Count;
+        return block;
+      }
+
+      void Free(uint32_t iClass, void* iBlock)
+      {
+        ClassList& list = m_Lists[iClass];
+        FreeBlock* block = (FreeBlock*)iBlock;
+        block->m_Next = list.m_Free;
+        list.m_Free = block;
+        uint32_t const batchSize = s_Classes.m_BatchSize[iClass];
+        if (++list.m_Count >= 2 * batchSize)
+        {
+          // Give a batch back, so that memory freed by a consumer thread goes back to the producers.
+          FreeBlock* last = list.m_Free;
+          for (uint32_t i = 1; i < batchSize; ++i)
+          {
+            last = last->m_Next;
+          }
+          FreeBlock* first = list.m_Free;
+          list.m_Free = last->m_Next;
+          list.m_Count -= batchSize;
+          GetDepot().Release(iClass, first, last);
+        }
+      }
+
+      ClassList m_Lists[s_NumSizeClasses];
+    };
+
+    ThreadCache* GetThreadCache()
+    {
+      if (t_Cache == nullptr && !t_CacheDestroyed)
+      {
+        thread_local ThreadCache s_Cache;
+        t_Cache = &s_Cache;
+      }
+      return t_Cache;
+    }
+
+    void* AllocBlock(size_t iSize, size_t iNumElems)
+    {
+      size_t const blockSize = iSize + sizeof(BlockHeader);
+      uint32_t const sizeClass = s_Classes.GetClass(blockSize);
+      void* block;
+      if (sizeClass == s_LargeClass)
+      {
+        block = AllocFromSystem(blockSize);
+      }
+      else if (ThreadCache* cache = GetThreadCache())
+      {
+        block = cache->Alloc(sizeClass);
+      }
+      else
+      {
+        // Thread is exiting.
+        block = GetDepot().Fetch(sizeClass, 1);
+      }
+
+      if (block == nullptr)
+      {
+        return nullptr;
+      }
+      BlockHeader* header = (BlockHeader*)block;
+      header->m_SizeClass = sizeClass;
+      header->m_NumElems = iNumElems;
+      header->m_Size = iSize;
+      return header + 1;
+    }
+
+    void ReleaseBlock(void* iPtr)
+    {
+      BlockHeader* header = (BlockHeader*)iPtr - 1;
+      uint32_t const sizeClass = header->m_SizeClass;
+      if (sizeClass == s_LargeClass)
+      {
+        FreeToSystem(header);
+      }
+      else if (ThreadCache* cache = GetThreadCache())
+      {
+        cache->Free(sizeClass, header);
+      }
+      else
+      {
+        FreeBlock* block = (FreeBlock*)header;
+        GetDepot().Release(sizeClass, block, block);
+      }
+    }
+  }
+
+#ifdef DEBUG_ALLOC
   struct MemRec
   {
     size_t size;
@@ -36,16 +317,57 @@ namespace eXl
     void* ptr;
   };
 
-  typedef boost::multi_index::multi_index_container<MemRec,
-    boost::multi_index::indexed_by<
-    boost::multi_index::ordered_unique<boost::multi_index::member<MemRec,void*,&MemRec::ptr> > > > MemMap;
-  typedef MemMap::nth_index<0>::type MemMap_by_ptr;
+  namespace
+  {
+    // Records are spread by address over independent maps, to keep tracked builds usable under load.
+    struct LeakTracker
+    {
+      static constexpr uint32_t s_NumShards = 64;
+
+      struct Shard
+      {
+        std::mutex m_Lock;
+        std::unordered_map<void*, MemRec> m_Records;
+      };
+
+      Shard& GetShard(void* iPtr)
+      {
+        uint64_t const hash = (uint64_t(uintptr_t(iPtr)) >> 4) * 0x9E3779B97F4A7C15ull;
+        return m_Shards[hash >> 58];
+      }
+
+      void Add(void* iPtr, size_t iSize, size_t iNumElems, const char* iFile, unsigned int iLine, const char* iFun)
+      {
+        MemRec newRec;
+        newRec.size = iSize;
+        newRec.line = iLine;
+        newRec.file = iFile;
+        newRec.func = iFun;
+        newRec.ptr = iPtr;
+        newRec.numElems = iNumElems;
+        Shard& shard = GetShard(iPtr);
+        std::unique_lock<std::mutex> lock(shard.m_Lock);
+        shard.m_Records.insert(std::make_pair(iPtr, newRec));
+      }
+
+      void Remove(void* iPtr)
+      {
+        Shard& shard = GetShard(iPtr);
+        std::unique_lock<std::mutex> lock(shard.m_Lock);
+        shard.m_Records.erase(iPtr);
+      }
 
-  static MemMap m_Map;
-  static std::mutex memLock;
+      Shard m_Shards[s_NumShards];
+    };
 
-  static void*(*s_AllocFn)(size_t) = nullptr;
-  static void(*s_FreeFn)(void*) = nullptr;
+    LeakTracker& GetTracker()
+    {
+      alignas(LeakTracker) static char s_Storage[sizeof(LeakTracker)];
+      static LeakTracker* s_Tracker = new(s_Storage) LeakTracker;
+      return *s_Tracker;
+    }
+  }
+#endif
 
   void MemoryManager::SetAllocFn(void*(*AllocFn)(size_t))
   {
@@ -65,39 +387,17 @@ namespace eXl
 
   void* MemoryManager::Allocate(size_t size,size_t numElems)
   {
-    if(!s_AllocFn)
-      s_AllocFn = &malloc;
-    void* res=s_AllocFn(size);
+    void* res = AllocBlock(size, numElems);
 #ifdef DEBUG_ALLOC
-    //eXl_ASSERT_MSG(res!=nullptr,"Out of Memory");
-    MemRec newRec;
-    newRec.size=size;
-    newRec.line=0;
-    newRec.file=nullptr;
-    newRec.func=nullptr;
-    newRec.ptr=res;
-    newRec.numElems=numElems;
-    std::unique_lock<std::mutex> mapLock(memLock);
-    m_Map.insert(newRec);
+    GetTracker().Add(res, size, numElems, nullptr, 0, nullptr);
 #endif
     return res;
   }
   void* MemoryManager::Allocate(size_t size,const char* file,unsigned int line,const char* iFun,size_t numElems)
   {
-    if(!s_AllocFn)
-      s_AllocFn = &malloc;
-    void* res=s_AllocFn(size);
+    void* res = AllocBlock(size, numElems);
 #ifdef DEBUG_ALLOC
-    //eXl_ASSERT_MSG(res!=nullptr,"Out of Memory");
-    MemRec newRec;
-    newRec.size=size;
-    newRec.line=line;
-    newRec.file=file;
-    newRec.func=iFun;
-    newRec.ptr=res;
-    newRec.numElems=numElems;
-    std::unique_lock<std::mutex> mapLock(memLock);
-    m_Map.insert(newRec);
+    GetTracker().Add(res, size, numElems, file, line, iFun);
 #endif
     return res;
   }
@@ -106,59 +406,39 @@ namespace eXl
   {
     void* res=iAlloc(size,16);
 #ifdef DEBUG_ALLOC
-    //eXl_ASSERT_MSG(res!=nullptr,"Out of Memory");
-    MemRec newRec;
-    newRec.size=size;
-    newRec.line=line;
-    newRec.file=file;
-    newRec.func=iFun;
-    newRec.ptr=res;
-    newRec.numElems=numElems;
-    std::unique_lock<std::mutex> mapLock(memLock);
-    m_Map.insert(newRec);
+    GetTracker().Add(res, size, numElems, file, line, iFun);
 #endif
     return res;
   }
   
   void MemoryManager::Free(void* ptr,bool array)
   {
-    if(!s_FreeFn)
-      s_FreeFn = &free;
+    if (ptr == nullptr)
+    {
+      return;
+    }
 #ifdef DEBUG_ALLOC
-    //eXl_ASSERT_MSG(ptr!=nullptr,(String("Trying to free nullptr")).c_str());
-    std::unique_lock<std::mutex> mapLock(memLock);
-    MemMap_by_ptr::iterator iter=m_Map.get<0>().find(ptr);
-    //eXl_ASSERT_MSG(iter!=m_Map.end(),(String("Trying to free unmanaged memory")).c_str());
-    //eXl_ASSERT_MSG((!array && iter->numElems==0) || (array && iter->numElems>0),(String("Wrong dtor for memory allocated in ")+iter->file+" at "+StringUtil::FromInt(iter->line)).c_str());
-    m_Map.erase(iter);
+    GetTracker().Remove(ptr);
 #endif
-    s_FreeFn(ptr);
+    ReleaseBlock(ptr);
   }
 
   void MemoryManager::Free(void* ptr,const char* file,unsigned int line,const char* iFun,bool array)
   {
-    if(!s_FreeFn)
-      s_FreeFn = &free;
+    if (ptr == nullptr)
+    {
+      return;
+    }
 #ifdef DEBUG_ALLOC
-    //eXl_ASSERT_MSG(ptr!=nullptr,(String("Trying to free nullptr in ")+file+" at "+StringUtil::FromInt(line)).c_str());
-    std::unique_lock<std::mutex> mapLock(memLock);
-    MemMap_by_ptr::iterator iter=m_Map.get<0>().find(ptr);
-    //eXl_ASSERT_MSG(iter!=m_Map.end(),(String("Trying to free unmanaged memory in ")+file+" at "+StringUtil::FromInt(line)).c_str());
-    //eXl_ASSERT_MSG((!array && iter->numElems==0) || (array && iter->numElems>0),(String("Wrong dtor called for memory in ")+file+" at "+StringUtil::FromInt(line)).c_str());
-    m_Map.erase(iter);
+    GetTracker().Remove(ptr);
 #endif
-    s_FreeFn(ptr);
+    ReleaseBlock(ptr);
   }
 
   void MemoryManager::Free_Ext(void* ptr,const char* file,unsigned int line,const char* iFun,bool array,void (*iFree)(void*))
   {
 #ifdef DEBUG_ALLOC
-    //eXl_ASSERT_MSG(ptr!=nullptr,(String("Trying to free nullptr in ")+file+" at "+StringUtil::FromInt(line)).c_str());
-    std::unique_lock<std::mutex> mapLock(memLock);
-    MemMap_by_ptr::iterator iter=m_Map.get<0>().find(ptr);
-    //eXl_ASSERT_MSG(iter!=m_Map.end(),(String("Trying to free unmanaged memory in ")+file+" at "+StringUtil::FromInt(line)).c_str());
-    //eXl_ASSERT_MSG((!array && iter->numElems==0) || (array && iter->numElems>0),(String("Wrong dtor called for memory in ")+file+" at "+StringUtil::FromInt(line)).c_str());
-    m_Map.erase(iter);
+    GetTracker().Remove(ptr);
 #endif
     iFree(ptr);
     
@@ -174,22 +454,21 @@ namespace eXl
 
   void MemoryManager::ReportLeaks()
   {
-    return;
-
+#ifdef DEBUG_ALLOC
     std::vector<char> buff(4096);
     char* buffer = &buff[0];
     size_t totalLeak=0;
     std::map<char const* ,unsigned int,CompStr> m_SetPos;
+    for (auto& shard : GetTracker().m_Shards)
     {
-      MemMap::iterator iter = m_Map.begin();
-      MemMap::iterator iterEnd = m_Map.end();
-
-      for(;iter!=iterEnd;iter++)
+      std::unique_lock<std::mutex> lock(shard.m_Lock);
+      for (auto const& entry : shard.m_Records)
       {
-        totalLeak+=iter->size;
-        if(iter->file!=nullptr)
+        MemRec const& rec = entry.second;
+        totalLeak+=rec.size;
+        if(rec.file!=nullptr)
         {
-          snprintf(buffer, buff.size(),("Leak in file %s in function %s at line %i of size %zi"),iter->file,iter->func,iter->line,iter->size);
+          snprintf(buffer, buff.size(),("Leak in file %s in function %s at line %i of size %zi"),rec.file,rec.func,rec.line,rec.size);
           std::map<char const* ,unsigned int,CompStr>::iterator iter = m_SetPos.find(buffer);
           if(iter == m_SetPos.end())
           {
@@ -204,8 +483,7 @@ namespace eXl
         }
         else
         {
-          //sprintf(buffer,"Leak at %p of size %i",iter->ptr,iter->size);
-          LOG_INFO<<"Leak at "<<iter->ptr<<" of size "<<iter->size<<"\n";
+          LOG_INFO<<"Leak at "<<rec.ptr<<" of size "<<rec.size<<"\n";
         } 
       }
     }
@@ -213,20 +491,17 @@ namespace eXl
     std::map<char const* ,unsigned int,CompStr>::iterator iterEnd = m_SetPos.end();
     for(;iter!=iterEnd;iter++)
     {
-      //totalLeak+=iter->size;
       LOG_INFO<<iter->first << " X "<< iter->second<<"\n";
     }
     LOG_INFO<<"Total memory leaks : "<<totalLeak<<"\n";
+#endif
   }
   
   unsigned int MemoryManager::GetNum(void* iPtr,size_t& oStride,const char* file,unsigned int line,const char* iFun)
   {
-    std::unique_lock<std::mutex> mapLock(memLock); 
-    MemMap_by_ptr::iterator iter=m_Map.get<0>().find(iPtr);
-    //eXl_ASSERT_MSG(iter!=m_Map.end(),(String("Trying to free unmanaged memory in ")+StringUtil::FromASCII(file)+" at "+StringUtil::FromInt(line)).c_str());
-    //eXl_ASSERT_MSG(iter->numElems>0,(String("Wrong dtor called memory in ")+StringUtil::FromASCII(file)+" at "+StringUtil::FromInt(line)).c_str());
-    oStride = iter->size/iter->numElems;
-    return iter->numElems;
+    BlockHeader const* header = (BlockHeader const*)iPtr - 1;
+    oStride = header->m_NumElems > 0 ? header->m_Size / header->m_NumElems : header->m_Size;
+    return header->m_NumElems;
   }
 
 }
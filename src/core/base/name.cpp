@@ -10,8 +10,8 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 #include <core/name.hpp>
 #include <boost/optional.hpp>
+#include <atomic>
 #include <mutex>
-#include <shared_mutex>
 
 namespace eXl
 {
@@ -116,28 +116,32 @@ namespace eXl
     return {};
   }
 
-  KString NameAllocHolder::InsertString(KString iStr)
+  KString NameAllocHolder::AllocString(KString iStr, size_t iHash)
   {
-    size_t strSize = iStr.size() + 1;
+    size_t const headerAlign = alignof(NameHeader);
+    size_t const strSize = sizeof(NameHeader) + ((iStr.size() + 1 + headerAlign - 1) & ~(headerAlign - 1));
     uint32_t const pageIdx = (m_Pages.back().m_Available < strSize) ?
       AllocPage(strSize) : m_Pages.size() - 1;
 
     Page& page = m_Pages[pageIdx];
-    char* insertPos = page.m_Cur;
-    KString newStr(insertPos, iStr.size());
+    NameHeader* header = reinterpret_cast<NameHeader*>(page.m_Cur);
+    header->m_Hash = iHash;
+    header->m_Size = iStr.size();
+    char* insertPos = reinterpret_cast<char*>(header + 1);
     memcpy(insertPos, iStr.data(), iStr.size());
-    insertPos += iStr.size();
-    insertPos[0] = 0;
-    insertPos++;
+    insertPos[iStr.size()] = 0;
 
-    auto insertRes = m_Strings.insert(newStr);
-    if (insertRes.second)
-    {
-      page.m_Available -= strSize;
-      page.m_Cur = insertPos;
-    }
-      
-    return *(insertRes.first);
+    page.m_Available -= strSize;
+    page.m_Cur += strSize;
+
+    return KString(insertPos, iStr.size());
+  }
+
+  KString NameAllocHolder::InsertString(KString iStr)
+  {
+    KString newStr = AllocString(iStr, HashNameString(iStr.data(), iStr.size()));
+    m_Strings.insert(newStr);
+    return newStr;
   }
 
   KString NameAllocHolder::Get(KString iStr)
@@ -151,40 +155,181 @@ namespace eXl
     return InsertString(iStr);
   }
 
+  // Open addressing table of interned strings. Lookups are lock-free : slots are only ever
+  // filled, and a full table is replaced by a bigger copy while the old one stays alive.
+  // Insertions are serialized, they only happen the first time a string is seen.
   struct TSNameAllocHolder : private NameAllocHolder
   {
-    using ReadLock = std::shared_lock<std::shared_mutex>;
-    using WriteLock = std::unique_lock<std::shared_mutex>;
+    using WriteLock = std::unique_lock<std::mutex>;
+
+    TSNameAllocHolder();
+
+    KString Get(KString iStr, size_t iHash);
+    void PreIntern(Vector<KString> const& iStrings);
+    Vector<KString> GetStrings();
 
-    KString Get(KString iStr);
   private:
-    std::shared_mutex m_Mutex;
+
+    struct Table
+    {
+      Table(size_t iSize)
+        : m_Mask(iSize - 1)
+        , m_Slots(iSize)
+      {
+        for (auto& slot : m_Slots)
+        {
+          slot.store(nullptr, std::memory_order_relaxed);
+        }
+      }
+
+      size_t m_Mask;
+      Vector<std::atomic<Char const*>> m_Slots;
+    };
+
+    static NameHeader const* GetHeader(Char const* iStr)
+    {
+      return reinterpret_cast<NameHeader const*>(iStr) - 1;
+    }
+
+    static Char const* Find(Table const& iTable, KString iStr, size_t iHash);
+    static void Insert(Table& iTable, Char const* iStr);
+    void Reserve(size_t iNumStrings);
+    KString InsertLocked(KString iStr, size_t iHash);
+
+    std::atomic<Table*> m_Current;
+    // Tables are never freed before shutdown, readers may still be probing the older ones.
+    Vector<UniquePtr<Table>> m_Tables;
+    size_t m_NumStrings = 0;
+    std::mutex m_Mutex;
   };
 
-  KString TSNameAllocHolder::Get(KString iStr)
+  TSNameAllocHolder::TSNameAllocHolder()
+  {
+    m_Tables.emplace_back(eXl_NEW Table(1024));
+    m_Current.store(m_Tables.back().get(), std::memory_order_release);
+  }
+
+  Char const* TSNameAllocHolder::Find(Table const& iTable, KString iStr, size_t iHash)
   {
+    for (size_t slot = iHash & iTable.m_Mask; ; slot = (slot + 1) & iTable.m_Mask)
     {
-      ReadLock lock(m_Mutex);
-      auto res = GetExistingString(iStr);
-      if (res)
+      Char const* entry = iTable.m_Slots[slot].load(std::memory_order_acquire);
+      if (entry == nullptr)
+      {
+        return nullptr;
+      }
+      NameHeader const* header = GetHeader(entry);
+      if (header->m_Hash == iHash
+        && header->m_Size == iStr.size()
+        && memcmp(entry, iStr.data(), iStr.size()) == 0)
       {
-        return *res;
+        return entry;
       }
     }
+  }
+
+  void TSNameAllocHolder::Insert(Table& iTable, Char const* iStr)
+  {
+    size_t slot = GetHeader(iStr)->m_Hash & iTable.m_Mask;
+    while (iTable.m_Slots[slot].load(std::memory_order_relaxed) != nullptr)
+    {
+      slot = (slot + 1) & iTable.m_Mask;
+    }
+    iTable.m_Slots[slot].store(iStr, std::memory_order_release);
+  }
+
+  void TSNameAllocHolder::Reserve(size_t iNumStrings)
+  {
+    Table& curTable = *m_Current.load(std::memory_order_relaxed);
+    // Keep the load factor under 1/2.
+    if (iNumStrings * 2 <= curTable.m_Slots.size())
+    {
+      return;
+    }
+    size_t newSize = curTable.m_Slots.size();
+    while (iNumStrings * 2 > newSize)
+    {
+      newSize *= 2;
+    }
+
+    // Rehashing reuses the stored hashes.
+    UniquePtr<Table> newTable(eXl_NEW Table(newSize));
+    for (auto const& slot : curTable.m_Slots)
+    {
+      if (Char const* entry = slot.load(std::memory_order_relaxed))
+      {
+        Insert(*newTable, entry);
+      }
+    }
+    m_Current.store(newTable.get(), std::memory_order_release);
+    m_Tables.push_back(std::move(newTable));
+  }
+
+  KString TSNameAllocHolder::InsertLocked(KString iStr, size_t iHash)
+  {
+    if (Char const* existing = Find(*m_Current.load(std::memory_order_relaxed), iStr, iHash))
+    {
+      return KString(existing, iStr.size());
+    }
+
+    Reserve(m_NumStrings + 1);
+    KString newStr = AllocString(iStr, iHash);
+    Insert(*m_Current.load(std::memory_order_relaxed), newStr.data());
+    ++m_NumStrings;
+
+    return newStr;
+  }
+
+  KString TSNameAllocHolder::Get(KString iStr, size_t iHash)
+  {
+    if (Char const* existing = Find(*m_Current.load(std::memory_order_acquire), iStr, iHash))
+    {
+      return KString(existing, iStr.size());
+    }
+
     WriteLock lock(m_Mutex);
+    return InsertLocked(iStr, iHash);
+  }
 
-    return InsertString(iStr);
+  void TSNameAllocHolder::PreIntern(Vector<KString> const& iStrings)
+  {
+    WriteLock lock(m_Mutex);
+    Reserve(m_NumStrings + iStrings.size());
+    for (KString str : iStrings)
+    {
+      InsertLocked(str, HashNameString(str.data(), str.size()));
+    }
+  }
+
+  Vector<KString> TSNameAllocHolder::GetStrings()
+  {
+    WriteLock lock(m_Mutex);
+    Vector<KString> strings;
+    strings.reserve(m_NumStrings);
+    for (auto const& slot : m_Current.load(std::memory_order_relaxed)->m_Slots)
+    {
+      if (Char const* entry = slot.load(std::memory_order_relaxed))
+      {
+        strings.push_back(KString(entry, GetHeader(entry)->m_Size));
+      }
+    }
+    return strings;
   }
 
   Optional<TSNameAllocHolder> s_Names;
+  // Head of the StaticName list, constant initialized so that it can be filled during static initialization.
+  StaticName* s_StaticNames = nullptr;
+  std::mutex s_StaticNamesLock;
 
   void Name_Init()
   {
     s_Names.emplace();
+    StaticName::RegisterAll();
   }
 
   void Name_Destroy()
   {
+    StaticName::UnregisterAll();
     s_Names.reset();
   }
 
@@ -195,19 +340,76 @@ namespace eXl
 
   Name::Name(String const& iStr)
   {
-    m_Str = s_Names->Get(KString(iStr));
+    m_Str = s_Names->Get(KString(iStr), HashNameString(iStr.data(), iStr.size()));
   }
 
   Name::Name(Char const* iStr) 
   {
-    m_Str = s_Names->Get(KString(iStr, strlen(iStr)));
+    KString str(iStr, strlen(iStr));
+    m_Str = s_Names->Get(str, HashNameString(str.data(), str.size()));
+  }
+
+  Name::Name(NameLiteral const& iLiteral)
+  {
+    m_Str = s_Names->Get(iLiteral.m_Str, iLiteral.m_Hash);
   }
 
   Name& Name::operator=(Char const* iStr)
   {
-    m_Str = s_Names->Get(KString(iStr, strlen(iStr)));
+    *this = Name(iStr);
     return *this;
   }
 
+  void Name::PreIntern(Vector<KString> const& iStrings)
+  {
+    s_Names->PreIntern(iStrings);
+  }
+
+  Vector<KString> Name::GetInternedStrings()
+  {
+    return s_Names->GetStrings();
+  }
+
+  StaticName::StaticName(NameLiteral const& iLiteral)
+    : m_Literal(iLiteral)
+  {
+    std::unique_lock<std::mutex> lock(s_StaticNamesLock);
+    m_Next = s_StaticNames;
+    s_StaticNames = this;
+    if (s_Names)
+    {
+      m_Name = Name(m_Literal);
+    }
+  }
+
+  StaticName::~StaticName()
+  {
+    std::unique_lock<std::mutex> lock(s_StaticNamesLock);
+    StaticName** link = &s_StaticNames;
+    while (*link != this)
+    {
+      link = &(*link)->m_Next;
+    }
+    *link = m_Next;
+  }
+
+  void StaticName::RegisterAll()
+  {
+    std::unique_lock<std::mutex> lock(s_StaticNamesLock);
+    for (StaticName* name = s_StaticNames; name != nullptr; name = name->m_Next)
+    {
+      name->m_Name = Name(name->m_Literal);
+    }
+  }
+
+  void StaticName::UnregisterAll()
+  {
+    std::unique_lock<std::mutex> lock(s_StaticNamesLock);
+    for (StaticName* name = s_StaticNames; name != nullptr; name = name->m_Next)
+    {
+      name->m_Name = Name();
+    }
+  }
+
 #endif
 }
\ No newline at end of file
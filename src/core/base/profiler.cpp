@@ -0,0 +1,418 @@
+/*
+Copyright 2009-2021 Nicolas Colombe
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <core/profiler.hpp>
+#include <core/clock.hpp>
+#include <core/log.hpp>
+
+#include <atomic>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <ostream>
+
+namespace eXl
+{
+  namespace
+  {
+    constexpr uint32_t s_BufferSize = 1 << 14;
+    constexpr uint32_t s_MaxZoneDepth = 64;
+    constexpr uint32_t s_DefaultMaxFrames = 128;
+
+    //Single producer (the owning thread), single consumer (NextFrame).
+    struct ThreadBuffer
+    {
+      ThreadBuffer(uint32_t iIdx)
+        : m_Events(s_BufferSize)
+        , m_Thread(iIdx)
+        , m_Name("Thread " + StringUtil::FromInt(iIdx))
+      {}
+
+      void Push(Profiler::Event const& iEvent)
+      {
+        uint32_t const head = m_Head.load(std::memory_order_relaxed);
+        if (head - m_Tail.load(std::memory_order_acquire) >= s_BufferSize)
+        {
+          m_Dropped.fetch_add(1, std::memory_order_relaxed);
+          return;
+        }
+        m_Events[head % s_BufferSize] = iEvent;
+        m_Head.store(head + 1, std::memory_order_release);
+      }
+
+      void Drain(Vector<Profiler::Event>& oEvents)
+      {
+        uint32_t const head = m_Head.load(std::memory_order_acquire);
+        uint32_t tail = m_Tail.load(std::memory_order_relaxed);
+        for (; tail != head; ++tail)
+        {
+          oEvents.push_back(m_Events[tail % s_BufferSize]);
+        }
+        m_Tail.store(tail, std::memory_order_release);
+      }
+
+      Vector<Profiler::Event> m_Events;
+      std::atomic<uint32_t> m_Head = {0};
+      std::atomic<uint32_t> m_Tail = {0};
+      std::atomic<uint32_t> m_Dropped = {0};
+
+      //Only touched by the owning thread.
+      uint64_t m_ZoneStart[s_MaxZoneDepth];
+      char const* m_ZoneName[s_MaxZoneDepth];
+      uint32_t m_Depth = 0;
+
+      uint32_t const m_Thread;
+      String m_Name;
+      //Set when the owning thread exits, the buffer is reused once drained.
+      std::atomic<bool> m_Released = {false};
+    };
+
+    struct ProfilerState
+    {
+      std::atomic<bool> m_Enabled = {false};
+
+      std::mutex m_BuffersLock;
+      //Buffers are never freed, a thread may exit with events left to collect.
+      Vector<UniquePtr<ThreadBuffer>> m_Buffers;
+
+      std::mutex m_NamesLock;
+      std::deque<String> m_Names;
+      UnorderedMap<KString, char const*> m_NameMap;
+
+      Vector<Profiler::Frame> m_Frames;
+      uint32_t m_MaxFrames = s_DefaultMaxFrames;
+      uint64_t m_LastFrameEnd = 0;
+
+      Vector<Profiler::Frame> m_Capture;
+      uint32_t m_CaptureRemaining = 0;
+      Path m_CapturePath;
+    };
+
+    ProfilerState& GetState()
+    {
+      static ProfilerState s_State;
+      return s_State;
+    }
+
+    struct ThreadBufferOwner
+    {
+      ~ThreadBufferOwner()
+      {
+        if (m_Buffer)
+        {
+          m_Buffer->m_Released.store(true, std::memory_order_release);
+        }
+      }
+      ThreadBuffer* m_Buffer = nullptr;
+    };
+
+    thread_local ThreadBufferOwner s_ThreadBuffer;
+
+    ThreadBuffer& GetThreadBuffer()
+    {
+      if (s_ThreadBuffer.m_Buffer == nullptr)
+      {
+        ProfilerState& state = GetState();
+        std::unique_lock<std::mutex> lock(state.m_BuffersLock);
+        for (auto& buffer : state.m_Buffers)
+        {
+          if (buffer->m_Released.load(std::memory_order_acquire)
+            && buffer->m_Head.load(std::memory_order_relaxed) == buffer->m_Tail.load(std::memory_order_relaxed))
+          {
+            buffer->m_Released.store(false, std::memory_order_relaxed);
+            buffer->m_Depth = 0;
+            buffer->m_Name = "Thread " + StringUtil::FromInt(buffer->m_Thread);
+            s_ThreadBuffer.m_Buffer = buffer.get();
+            return *s_ThreadBuffer.m_Buffer;
+          }
+        }
+        state.m_Buffers.emplace_back(new ThreadBuffer(state.m_Buffers.size()));
+        s_ThreadBuffer.m_Buffer = state.m_Buffers.back().get();
+      }
+      return *s_ThreadBuffer.m_Buffer;
+    }
+
+    void WriteEscaped(std::ostream& oStream, char const* iStr)
+    {
+      oStream << '"';
+      for (; *iStr; ++iStr)
+      {
+        if (*iStr == '"' || *iStr == '\\')
+        {
+          oStream << '\\';
+        }
+        oStream << *iStr;
+      }
+      oStream << '"';
+    }
+  }
+
+  void Profiler::Enable(bool iEnabled)
+  {
+    GetState().m_Enabled.store(iEnabled, std::memory_order_relaxed);
+  }
+
+  bool Profiler::IsEnabled()
+  {
+    return GetState().m_Enabled.load(std::memory_order_relaxed);
+  }
+
+  void Profiler::BeginZone(char const* iName)
+  {
+    ThreadBuffer& buffer = GetThreadBuffer();
+    if (buffer.m_Depth < s_MaxZoneDepth)
+    {
+      buffer.m_ZoneName[buffer.m_Depth] = iName;
+      buffer.m_ZoneStart[buffer.m_Depth] = Clock::GetTimestamp();
+    }
+    ++buffer.m_Depth;
+  }
+
+  void Profiler::EndZone()
+  {
+    ThreadBuffer& buffer = GetThreadBuffer();
+    eXl_ASSERT_REPAIR_RET(buffer.m_Depth > 0, );
+    --buffer.m_Depth;
+    if (buffer.m_Depth < s_MaxZoneDepth)
+    {
+      Event zone;
+      zone.m_Name = buffer.m_ZoneName[buffer.m_Depth];
+      zone.m_Start = buffer.m_ZoneStart[buffer.m_Depth];
+      zone.m_End = Clock::GetTimestamp();
+      zone.m_Value = 0;
+      zone.m_Thread = buffer.m_Thread;
+      zone.m_Depth = buffer.m_Depth;
+      zone.m_Kind = Event::Zone;
+      buffer.Push(zone);
+    }
+  }
+
+  void Profiler::SetCounter(char const* iName, int64_t iValue)
+  {
+    ThreadBuffer& buffer = GetThreadBuffer();
+    Event counter;
+    counter.m_Name = iName;
+    counter.m_Start = counter.m_End = Clock::GetTimestamp();
+    counter.m_Value = iValue;
+    counter.m_Thread = buffer.m_Thread;
+    counter.m_Depth = 0;
+    counter.m_Kind = Event::Counter;
+    buffer.Push(counter);
+  }
+
+  void Profiler::SetThreadName(KString iName)
+  {
+    ThreadBuffer& buffer = GetThreadBuffer();
+    ProfilerState& state = GetState();
+    std::unique_lock<std::mutex> lock(state.m_BuffersLock);
+    buffer.m_Name = String(iName);
+  }
+
+  Vector<String> Profiler::GetThreadNames()
+  {
+    ProfilerState& state = GetState();
+    std::unique_lock<std::mutex> lock(state.m_BuffersLock);
+    Vector<String> names;
+    for (auto const& buffer : state.m_Buffers)
+    {
+      names.push_back(buffer->m_Name);
+    }
+    return names;
+  }
+
+  char const* Profiler::InternName(KString iName)
+  {
+    ProfilerState& state = GetState();
+    std::unique_lock<std::mutex> lock(state.m_NamesLock);
+    auto iter = state.m_NameMap.find(iName);
+    if (iter != state.m_NameMap.end())
+    {
+      return iter->second;
+    }
+    //deque never moves its elements, the views stay valid.
+    state.m_Names.emplace_back(iName);
+    String const& newName = state.m_Names.back();
+    state.m_NameMap.insert(std::make_pair(KString(newName), newName.c_str()));
+    return newName.c_str();
+  }
+
+  void Profiler::NextFrame()
+  {
+    ProfilerState& state = GetState();
+    uint64_t const now = Clock::GetTimestamp();
+
+    Frame frame;
+    frame.m_Start = state.m_LastFrameEnd;
+    frame.m_End = now;
+    state.m_LastFrameEnd = now;
+    {
+      std::unique_lock<std::mutex> lock(state.m_BuffersLock);
+      for (auto& buffer : state.m_Buffers)
+      {
+        buffer->Drain(frame.m_Events);
+      }
+    }
+    if (frame.m_Start == 0)
+    {
+      frame.m_Start = now;
+      for (Event const& event : frame.m_Events)
+      {
+        frame.m_Start = event.m_Start < frame.m_Start ? event.m_Start : frame.m_Start;
+      }
+    }
+
+    if (!IsEnabled() && frame.m_Events.empty())
+    {
+      return;
+    }
+
+    if (state.m_CaptureRemaining > 0)
+    {
+      state.m_Capture.push_back(frame);
+      if (--state.m_CaptureRemaining == 0)
+      {
+        if (WriteChromeTrace(state.m_Capture, state.m_CapturePath) == Err::Success)
+        {
+          LOG_INFO << "Wrote " << state.m_Capture.size() << " profiled frames to " << ToString(state.m_CapturePath);
+        }
+        state.m_Capture.clear();
+      }
+    }
+
+    state.m_Frames.push_back(std::move(frame));
+    if (state.m_Frames.size() > state.m_MaxFrames)
+    {
+      state.m_Frames.erase(state.m_Frames.begin(), state.m_Frames.end() - state.m_MaxFrames);
+    }
+  }
+
+  Vector<Profiler::Frame> const& Profiler::GetFrames()
+  {
+    return GetState().m_Frames;
+  }
+
+  void Profiler::SetMaxFrames(uint32_t iNumFrames)
+  {
+    ProfilerState& state = GetState();
+    state.m_MaxFrames = iNumFrames > 0 ? iNumFrames : 1;
+    if (state.m_Frames.size() > state.m_MaxFrames)
+    {
+      state.m_Frames.erase(state.m_Frames.begin(), state.m_Frames.end() - state.m_MaxFrames);
+    }
+  }
+
+  uint32_t Profiler::GetNumDroppedEvents()
+  {
+    ProfilerState& state = GetState();
+    std::unique_lock<std::mutex> lock(state.m_BuffersLock);
+    uint32_t dropped = 0;
+    for (auto const& buffer : state.m_Buffers)
+    {
+      dropped += buffer->m_Dropped.load(std::memory_order_relaxed);
+    }
+    return dropped;
+  }
+
+  void Profiler::WriteChromeTrace(Vector<Frame> const& iFrames, std::ostream& oStream)
+  {
+    //Zones may have started before the first frame.
+    uint64_t origin = iFrames.empty() ? 0 : iFrames.front().m_Start;
+    for (Frame const& frame : iFrames)
+    {
+      for (Event const& event : frame.m_Events)
+      {
+        origin = event.m_Start < origin ? event.m_Start : origin;
+      }
+    }
+    double const toMicroSec = 1.0e6 / Clock::GetTicksPerSecond();
+    auto timeStamp = [&](uint64_t iTime)
+    {
+      return double(iTime - origin) * toMicroSec;
+    };
+
+    oStream << "{\"traceEvents\":[\n";
+    bool first = true;
+    auto separator = [&]
+    {
+      if (!first)
+      {
+        oStream << ",\n";
+      }
+      first = false;
+    };
+
+    separator();
+    oStream << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"Threads\"}}";
+    separator();
+    oStream << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"Frames\"}}";
+
+    Vector<String> threadNames = GetThreadNames();
+    for (uint32_t i = 0; i < threadNames.size(); ++i)
+    {
+      separator();
+      oStream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << i << ",\"args\":{\"name\":";
+      WriteEscaped(oStream, threadNames[i].c_str());
+      oStream << "}}";
+    }
+
+    for (uint32_t frameIdx = 0; frameIdx < iFrames.size(); ++frameIdx)
+    {
+      Frame const& frame = iFrames[frameIdx];
+      separator();
+      oStream << "{\"name\":\"Frame " << frameIdx << "\",\"cat\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":0,\"ts\":" << timeStamp(frame.m_Start)
+        << ",\"dur\":" << timeStamp(frame.m_End) - timeStamp(frame.m_Start) << "}";
+
+      for (Event const& event : frame.m_Events)
+      {
+        separator();
+        oStream << "{\"name\":";
+        WriteEscaped(oStream, event.m_Name);
+        if (event.m_Kind == Event::Zone)
+        {
+          oStream << ",\"ph\":\"X\",\"pid\":0,\"tid\":" << event.m_Thread << ",\"ts\":" << timeStamp(event.m_Start)
+            << ",\"dur\":" << timeStamp(event.m_End) - timeStamp(event.m_Start) << "}";
+        }
+        else
+        {
+          oStream << ",\"ph\":\"C\",\"pid\":0,\"ts\":" << timeStamp(event.m_Start)
+            << ",\"args\":{\"value\":" << event.m_Value << "}}";
+        }
+      }
+    }
+    oStream << "\n]}\n";
+  }
+
+  Err Profiler::WriteChromeTrace(Vector<Frame> const& iFrames, Path const& iPath)
+  {
+    std::ofstream outputStream;
+    outputStream.open(iPath, std::ios::binary);
+    if (!outputStream.is_open())
+    {
+      LOG_ERROR << "Could not open " << ToString(iPath) << " to write the profile";
+      return Err::Failure;
+    }
+    WriteChromeTrace(iFrames, outputStream);
+    return Err::Success;
+  }
+
+  void Profiler::CaptureFrames(uint32_t iNumFrames, Path const& iPath)
+  {
+    ProfilerState& state = GetState();
+    Enable(true);
+    state.m_Capture.clear();
+    state.m_CaptureRemaining = iNumFrames;
+    state.m_CapturePath = iPath;
+  }
+
+  bool Profiler::IsCapturing()
+  {
+    return GetState().m_CaptureRemaining > 0;
+  }
+}
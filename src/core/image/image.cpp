@@ -10,8 +10,21 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 #include <core/image/image.hpp>
 #include <cstring>
+#include <cmath>
+#include <algorithm>
 
+#include <core/containers.hpp>
 #include <core/log.hpp>
+#include <core/thread/jobsystem.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define EXL_IMAGE_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(__AVX__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 namespace eXl
 {
@@ -25,25 +38,274 @@ namespace eXl
                              4, 8,  12,  12,  16,   16  , 0, 0,     //Int
                              4, 8,  12,  12,  16,   16  , 0, 0};    //Float
     
-    template <typename T, unsigned int numComp>
-    void GenericMultiply(float iFloat, unsigned char const* iVal, unsigned char* oVal)
+    // Doubles: as a float, 4294967295 rounds to 2^32 and full scale Int values would wrap to 0.
+    double const formatMaxTab[] = {255.0, 65535.0, 4294967295.0, 1.0};
+
+    // Rows per job when an operation is split among threads.
+    constexpr uint32_t s_RowGrain = 16;
+
+    template <typename Fn>
+    void ForRowRanges(JobSystem* iJobs, uint32_t iBegin, uint32_t iEnd, Fn const& iFn)
+    {
+      if (iJobs == nullptr || iEnd - iBegin <= s_RowGrain)
+      {
+        if (iBegin < iEnd)
+        {
+          iFn(iBegin, iEnd);
+        }
+        return;
+      }
+      iJobs->ParallelFor(iBegin, iEnd, s_RowGrain, [&iFn](uint32_t iRangeBegin, uint32_t iRangeEnd, uint32_t)
+      {
+        iFn(iRangeBegin, iRangeEnd);
+      });
+    }
+
+    // oOut[i] = iIn[i] * iWeight
+    void MulRow(float* oOut, float const* iIn, float iWeight, uint32_t iNum)
+    {
+      uint32_t i = 0;
+#ifdef __AVX__
+      __m256 const weight8 = _mm256_set1_ps(iWeight);
+      for (; i + 8 <= iNum; i += 8)
+      {
+        _mm256_storeu_ps(oOut + i, _mm256_mul_ps(_mm256_loadu_ps(iIn + i), weight8));
+      }
+#endif
+#ifdef EXL_IMAGE_SSE2
+      __m128 const weight4 = _mm_set1_ps(iWeight);
+      for (; i + 4 <= iNum; i += 4)
+      {
+        _mm_storeu_ps(oOut + i, _mm_mul_ps(_mm_loadu_ps(iIn + i), weight4));
+      }
+#endif
+      for (; i < iNum; ++i)
+      {
+        oOut[i] = iIn[i] * iWeight;
+      }
+    }
+
+    // oOut[i] += iIn[i] * iWeight
+    void MulAddRow(float* oOut, float const* iIn, float iWeight, uint32_t iNum)
     {
-      T const* origVal = reinterpret_cast<T const*>(iVal);
-      T * result = reinterpret_cast<T *>(oVal);
-      for(unsigned int i = 0; i<numComp; ++i)
+      uint32_t i = 0;
+#ifdef __AVX__
+      __m256 const weight8 = _mm256_set1_ps(iWeight);
+      for (; i + 8 <= iNum; i += 8)
+      {
+        _mm256_storeu_ps(oOut + i, _mm256_add_ps(_mm256_loadu_ps(oOut + i), _mm256_mul_ps(_mm256_loadu_ps(iIn + i), weight8)));
+      }
+#endif
+#ifdef EXL_IMAGE_SSE2
+      __m128 const weight4 = _mm_set1_ps(iWeight);
+      for (; i + 4 <= iNum; i += 4)
+      {
+        _mm_storeu_ps(oOut + i, _mm_add_ps(_mm_loadu_ps(oOut + i), _mm_mul_ps(_mm_loadu_ps(iIn + i), weight4)));
+      }
+#endif
+      for (; i < iNum; ++i)
+      {
+        oOut[i] += iIn[i] * iWeight;
+      }
+    }
+
+    // Weighted sum of iNumTaps slices of iIn, iStride floats apart.
+    void FilterRow(float* oOut, float const* iIn, size_t iStride, float const* iTaps, uint32_t iNumTaps, uint32_t iNum)
+    {
+      MulRow(oOut, iIn, iTaps[0], iNum);
+      for (uint32_t tap = 1; tap < iNumTaps; ++tap)
+      {
+        MulAddRow(oOut, iIn + tap * iStride, iTaps[tap], iNum);
+      }
+    }
+
+    void ToFloat(void const* iIn, Image::Format iFormat, double iScale, float* oOut, uint32_t iNum)
+    {
+      uint32_t i = 0;
+      float const scale = float(iScale);
+      switch (iFormat)
+      {
+      case Image::Char:
+      {
+        uint8_t const* in = reinterpret_cast<uint8_t const*>(iIn);
+#ifdef __AVX2__
+        __m256 const scale8 = _mm256_set1_ps(scale);
+        for (; i + 8 <= iNum; i += 8)
+        {
+          __m256i values = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<__m128i const*>(in + i)));
+          _mm256_storeu_ps(oOut + i, _mm256_mul_ps(_mm256_cvtepi32_ps(values), scale8));
+        }
+#endif
+#ifdef EXL_IMAGE_SSE2
+        __m128i const zero = _mm_setzero_si128();
+        __m128 const scale4 = _mm_set1_ps(scale);
+        for (; i + 16 <= iNum; i += 16)
+        {
+          __m128i values = _mm_loadu_si128(reinterpret_cast<__m128i const*>(in + i));
+          __m128i low = _mm_unpacklo_epi8(values, zero);
+          __m128i high = _mm_unpackhi_epi8(values, zero);
+          _mm_storeu_ps(oOut + i,      _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(low, zero)), scale4));
+          _mm_storeu_ps(oOut + i + 4,  _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(low, zero)), scale4));
+          _mm_storeu_ps(oOut + i + 8,  _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(high, zero)), scale4));
+          _mm_storeu_ps(oOut + i + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(high, zero)), scale4));
+        }
+#endif
+        for (; i < iNum; ++i)
+        {
+          oOut[i] = in[i] * scale;
+        }
+        break;
+      }
+      case Image::Short:
       {
-        result[i] += origVal[i] * iFloat;
+        uint16_t const* in = reinterpret_cast<uint16_t const*>(iIn);
+#ifdef EXL_IMAGE_SSE2
+        __m128i const zero = _mm_setzero_si128();
+        __m128 const scale4 = _mm_set1_ps(scale);
+        for (; i + 8 <= iNum; i += 8)
+        {
+          __m128i values = _mm_loadu_si128(reinterpret_cast<__m128i const*>(in + i));
+          _mm_storeu_ps(oOut + i,     _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(values, zero)), scale4));
+          _mm_storeu_ps(oOut + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(values, zero)), scale4));
+        }
+#endif
+        for (; i < iNum; ++i)
+        {
+          oOut[i] = in[i] * scale;
+        }
+        break;
+      }
+      case Image::Int:
+      {
+        uint32_t const* in = reinterpret_cast<uint32_t const*>(iIn);
+        for (; i < iNum; ++i)
+        {
+          oOut[i] = float(in[i] * iScale);
+        }
+        break;
+      }
+      case Image::Float:
+        MulRow(oOut, reinterpret_cast<float const*>(iIn), scale, iNum);
+        break;
+      }
+    }
+
+    // Rounded to the nearest and clamped to the format's range.
+    void FromFloat(float const* iIn, double iScale, Image::Format iFormat, void* oOut, uint32_t iNum)
+    {
+      uint32_t i = 0;
+      float const scale = float(iScale);
+      float const maxVal = float(formatMaxTab[iFormat]);
+      switch (iFormat)
+      {
+      case Image::Char:
+      {
+        uint8_t* out = reinterpret_cast<uint8_t*>(oOut);
+#ifdef EXL_IMAGE_SSE2
+        __m128 const scale4 = _mm_set1_ps(scale);
+        __m128 const zero = _mm_setzero_ps();
+        __m128 const max4 = _mm_set1_ps(maxVal);
+        auto convert4 = [&](float const* iValues)
+        {
+          return _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(iValues), scale4), zero), max4));
+        };
+        for (; i + 16 <= iNum; i += 16)
+        {
+          __m128i low = _mm_packs_epi32(convert4(iIn + i), convert4(iIn + i + 4));
+          __m128i high = _mm_packs_epi32(convert4(iIn + i + 8), convert4(iIn + i + 12));
+          _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(low, high));
+        }
+#endif
+        for (; i < iNum; ++i)
+        {
+          out[i] = uint8_t(std::lrint(std::min(std::max(iIn[i] * scale, 0.0f), maxVal)));
+        }
+        break;
+      }
+      case Image::Short:
+      {
+        uint16_t* out = reinterpret_cast<uint16_t*>(oOut);
+        for (; i < iNum; ++i)
+        {
+          out[i] = uint16_t(std::lrint(std::min(std::max(iIn[i] * scale, 0.0f), maxVal)));
+        }
+        break;
+      }
+      case Image::Int:
+      {
+        uint32_t* out = reinterpret_cast<uint32_t*>(oOut);
+        for (; i < iNum; ++i)
+        {
+          out[i] = uint32_t(std::llrint(std::min(std::max(iIn[i] * iScale, 0.0), formatMaxTab[iFormat])));
+        }
+        break;
+      }
+      case Image::Float:
+        MulRow(reinterpret_cast<float*>(oOut), iIn, scale, iNum);
+        break;
+      }
+    }
+
+    // Finds iTaps = oCol * oRow^T when the filter has rank one.
+    bool Decompose(Vector<float> const& iTaps, Image::Size const& iSize, Vector<float>& oRow, Vector<float>& oCol)
+    {
+      uint32_t pivot = 0;
+      for (uint32_t i = 1; i < iTaps.size(); ++i)
+      {
+        if (std::abs(iTaps[i]) > std::abs(iTaps[pivot]))
+        {
+          pivot = i;
+        }
+      }
+      float const pivotVal = iTaps[pivot];
+      if (pivotVal == 0.0f)
+      {
+        return false;
+      }
+      uint32_t const pivotRow = pivot / iSize.x;
+      uint32_t const pivotCol = pivot % iSize.x;
+
+      oRow.assign(iTaps.begin() + pivotRow * iSize.x, iTaps.begin() + (pivotRow + 1) * iSize.x);
+      oCol.resize(iSize.y);
+      for (uint32_t l = 0; l < iSize.y; ++l)
+      {
+        oCol[l] = iTaps[l * iSize.x + pivotCol] / pivotVal;
+      }
+
+      float const tolerance = 1.0e-5f * std::abs(pivotVal);
+      for (uint32_t l = 0; l < iSize.y; ++l)
+      {
+        for (uint32_t m = 0; m < iSize.x; ++m)
+        {
+          if (std::abs(oCol[l] * oRow[m] - iTaps[l * iSize.x + m]) > tolerance)
+          {
+            return false;
+          }
+        }
       }
+      return true;
     }
 
-    void (*multiplierTab [])(float iFloat, unsigned char const* iVal, unsigned char* oVal) =
+    // Pixels covered by a filter of size iFilterSize, placed at iFilterOffset.
+    bool GetConvolutionRange(Image::Size const& iImageSize, Vec2i const& iFilterSize, Vec2i const& iFilterOffset, Vec2i& oMin, Vec2i& oMax)
     {
-      &GenericMultiply<unsigned char,1>,  &GenericMultiply<unsigned char,2>,  &GenericMultiply<unsigned char,3>,  &GenericMultiply<unsigned char,3>,  &GenericMultiply<unsigned char,4>,  &GenericMultiply<unsigned char,4>,  nullptr,nullptr,
-      &GenericMultiply<unsigned short,1>, &GenericMultiply<unsigned short,2>, &GenericMultiply<unsigned short,3>, &GenericMultiply<unsigned short,3>, &GenericMultiply<unsigned short,4>, &GenericMultiply<unsigned short,4>, nullptr,nullptr,
-      &GenericMultiply<unsigned int,1>,   &GenericMultiply<unsigned int,2>,   &GenericMultiply<unsigned int,3>,   &GenericMultiply<unsigned int,3>,   &GenericMultiply<unsigned int,4>,   &GenericMultiply<unsigned int,4>,   nullptr,nullptr,
-      &GenericMultiply<float,1>,          &GenericMultiply<float,2>,          &GenericMultiply<float,3>,          &GenericMultiply<float,3>,          &GenericMultiply<float,4>,          &GenericMultiply<float,4>,          nullptr,nullptr
+      Vec2i const imageSize(iImageSize.x, iImageSize.y);
+      oMin = Vec2i(glm::max(0, -iFilterOffset.x), glm::max(0, -iFilterOffset.y));
+      oMax = Vec2i(glm::min(imageSize.x, imageSize.x - (iFilterOffset.x + iFilterSize.x - 1)),
+                   glm::min(imageSize.y, imageSize.y - (iFilterOffset.y + iFilterSize.y - 1)));
+      return oMin.x < oMax.x && oMin.y < oMax.y;
+    }
+
+    // Channel order of each component layout, as indices in RGBA.
+    int const swizzleTab[][4] =
+    {
+      {0, -1, -1, -1}, //R
+      {0,  1, -1, -1}, //RG
+      {0,  1,  2, -1}, //RGB
+      {2,  1,  0, -1}, //BGR
+      {0,  1,  2,  3}, //RGBA
+      {2,  1,  0,  3}, //BGRA
     };
-    
   }
 
   void Image::Alloc()
@@ -169,87 +431,259 @@ namespace eXl
     return nullptr;
   }
 
-  void Image::Convolve(Image const& iFilter, Vec2i const& iFilterOffset)
+  void Image::Convolve(Image const& iFilter, Vec2i const& iFilterOffset, JobSystem* iJobs)
   {
     if(iFilter.GetComponents() != R || iFilter.GetFormat() != Float)
       return;
 
-    Vec2i minFilter = iFilterOffset;
-    Vec2i maxFilter = Vec2i(iFilter.GetSize().x, iFilter.GetSize().y) + iFilterOffset;
-    Size filterSize = iFilter.GetSize();
-
-    Vec2i minImage = Vec2i(glm::max(0,-minFilter.x), glm::max(0,-minFilter.y));
-    Vec2i maxImage = Vec2i(glm::min(m_Size.x,m_Size.x - (maxFilter.x - 1)), glm::min(m_Size.y,m_Size.y - (maxFilter.y - 1)));
-
-    void (*multiplier)(float , unsigned char const* , unsigned char* ) = multiplierTab[m_ImageFormat];
-
-    unsigned char* newImage = (unsigned char*)eXl_ALLOC(GetByteSize());
-
-    memcpy(newImage,m_ImageData,GetByteSize());
-
-    //for(unsigned int i = 0; i < minImage.y; ++i)
-    //{
-    //  unsigned char const* pixels = reinterpret_cast<unsigned char*>(m_ImageData) + i*m_RowStride;
-    //  unsigned char*       newVal = reinterpret_cast<unsigned char*>(newImage)    + i*m_RowStride;
-    //  memcpy(newVal,pixels,m_RowStride);
-    //  
-    //}
-    //
-    //for(unsigned int i = minImage.y; i < maxImage.y; ++i)
-    //{
-    //  unsigned char const* pixels = reinterpret_cast<unsigned char*>(m_ImageData) + i*m_RowStride;
-    //  unsigned char*       newVal = reinterpret_cast<unsigned char*>(newImage)    + i*m_RowStride;
-    //  for(unsigned int j = 0; j< minImage.x; ++j)
-    //  {
-    //    memcpy(newVal,pixels,GetPixelSize());
-    //    //_CrtCheckMemory();
-    //    pixels += GetPixelSize();
-    //    newVal += GetPixelSize();
-    //  }
-    //  pixels = reinterpret_cast<unsigned char*>(m_ImageData) + i*m_RowStride + maxImage.x * GetPixelSize();
-    //  newVal = reinterpret_cast<unsigned char*>(newImage)    + i*m_RowStride + maxImage.x * GetPixelSize();
-    //  for(unsigned int j = maxImage.x; j< m_Size.x; ++j)
-    //  {
-    //    memcpy(newVal,pixels,GetPixelSize());
-    //    //_CrtCheckMemory();
-    //    pixels += GetPixelSize();
-    //    newVal += GetPixelSize();
-    //  }
-    //}
-    //
-    //for(unsigned int i = maxImage.y; i < m_Size.y; ++i)
-    //{
-    //  unsigned char const* pixels = reinterpret_cast<unsigned char*>(m_ImageData) + i*m_RowStride;
-    //  unsigned char*       newVal = reinterpret_cast<unsigned char*>(newImage)    + i*m_RowStride;
-    //  memcpy(newVal,pixels,m_RowStride);
-    //}
-
-    for(int i = minImage.y; i< maxImage.y; ++i)
-    {
-      for(int j = minImage.x; j< maxImage.x; ++j)
-      {
-        unsigned char* value = newImage + i*m_RowStride + j * GetPixelSize();
-        unsigned char const* pixels = reinterpret_cast<unsigned char const*>(m_ImageData) + i *m_RowStride + j * GetPixelSize();
-        memset(value,0,GetPixelSize());
-        for(int l = minFilter.y; l<maxFilter.y; ++l)
-        {
-          float const* filterData = reinterpret_cast<float const*>(reinterpret_cast<unsigned char const*>(iFilter.GetImageData()) + iFilter.GetRowStride() * (l - minFilter.y));
-          for(int m = minFilter.x; m<maxFilter.x; ++m)
+    Size const filterSize = iFilter.GetSize();
+    if (filterSize.x == 0 || filterSize.y == 0)
+      return;
+
+    Vector<float> taps(filterSize.x * filterSize.y);
+    for (unsigned int i = 0; i < filterSize.y; ++i)
+    {
+      memcpy(taps.data() + i * filterSize.x, iFilter.GetRow(i), filterSize.x * sizeof(float));
+    }
+
+    Vector<float> rowFilter;
+    Vector<float> colFilter;
+    if (Decompose(taps, filterSize, rowFilter, colFilter))
+    {
+      ConvolveSeparable(rowFilter.data(), filterSize.x, iFilterOffset.x, colFilter.data(), filterSize.y, iFilterOffset.y, iJobs);
+      return;
+    }
+
+    Vec2i minImage;
+    Vec2i maxImage;
+    if (!GetConvolutionRange(m_Size, Vec2i(filterSize.x, filterSize.y), iFilterOffset, minImage, maxImage))
+      return;
+
+    uint32_t const numComp = compTab[GetComponents()];
+    uint32_t const rowFloats = m_Size.x * numComp;
+    uint32_t const spanFloats = (maxImage.x - minImage.x) * numComp;
+
+    Vector<float> source(m_Size.y * rowFloats);
+    Vector<float> result((maxImage.y - minImage.y) * rowFloats);
+
+    ForRowRanges(iJobs, 0, m_Size.y, [&](uint32_t iBegin, uint32_t iEnd)
+    {
+      for (uint32_t i = iBegin; i < iEnd; ++i)
+      {
+        ToFloat(GetRow(i), GetFormat(), 1.0, source.data() + i * rowFloats, rowFloats);
+      }
+    });
+
+    ForRowRanges(iJobs, minImage.y, maxImage.y, [&](uint32_t iBegin, uint32_t iEnd)
+    {
+      for (uint32_t i = iBegin; i < iEnd; ++i)
+      {
+        float* out = result.data() + (i - minImage.y) * rowFloats + minImage.x * numComp;
+        float const* in = source.data() + (i + iFilterOffset.y) * rowFloats + (minImage.x + iFilterOffset.x) * numComp;
+        for (uint32_t l = 0; l < filterSize.y; ++l)
+        {
+          float const* filterRow = taps.data() + l * filterSize.x;
+          for (uint32_t m = 0; m < filterSize.x; ++m)
           {
-            multiplier(*filterData,pixels + l * GetRowStride() + m * GetPixelSize(),value);
-            //_CrtCheckMemory();
-            //value[k] += *filterData * pixels[ (l * GetRowStride() + m)*GetPixelSize() + k];
-            ++filterData;
+            if (l == 0 && m == 0)
+            {
+              MulRow(out, in, filterRow[m], spanFloats);
+            }
+            else
+            {
+              MulAddRow(out, in + l * rowFloats + m * numComp, filterRow[m], spanFloats);
+            }
           }
-        } 
+        }
+        FromFloat(out, 1.0, GetFormat(), reinterpret_cast<uint8_t*>(GetRow(i)) + minImage.x * GetPixelSize(), spanFloats);
       }
+    });
+  }
+
+  void Image::ConvolveSeparable(float const* iRowFilter, unsigned int iRowSize, int iRowOffset,
+                                float const* iColFilter, unsigned int iColSize, int iColOffset, JobSystem* iJobs)
+  {
+    Vec2i minImage;
+    Vec2i maxImage;
+    if (iRowSize == 0 || iColSize == 0
+      || !GetConvolutionRange(m_Size, Vec2i(iRowSize, iColSize), Vec2i(iRowOffset, iColOffset), minImage, maxImage))
+      return;
+
+    uint32_t const numComp = compTab[GetComponents()];
+    uint32_t const rowFloats = m_Size.x * numComp;
+    uint32_t const spanFloats = (maxImage.x - minImage.x) * numComp;
+    uint32_t const firstSrcRow = minImage.y + iColOffset;
+    uint32_t const lastSrcRow = maxImage.y + iColOffset + iColSize - 1;
+
+    // Ping-pong between two float buffers : the row pass reads the first and writes the second, the column pass goes back.
+    Vector<float> buffers[2];
+    buffers[0].resize(m_Size.y * rowFloats);
+    buffers[1].resize(m_Size.y * rowFloats);
+
+    ForRowRanges(iJobs, firstSrcRow, lastSrcRow, [&](uint32_t iBegin, uint32_t iEnd)
+    {
+      for (uint32_t i = iBegin; i < iEnd; ++i)
+      {
+        float* source = buffers[0].data() + i * rowFloats;
+        ToFloat(GetRow(i), GetFormat(), 1.0, source, rowFloats);
+        FilterRow(buffers[1].data() + i * rowFloats + minImage.x * numComp,
+                  source + (minImage.x + iRowOffset) * numComp, numComp, iRowFilter, iRowSize, spanFloats);
+      }
+    });
+
+    ForRowRanges(iJobs, minImage.y, maxImage.y, [&](uint32_t iBegin, uint32_t iEnd)
+    {
+      for (uint32_t i = iBegin; i < iEnd; ++i)
+      {
+        float* out = buffers[0].data() + i * rowFloats + minImage.x * numComp;
+        FilterRow(out, buffers[1].data() + (i + iColOffset) * rowFloats + minImage.x * numComp, rowFloats, iColFilter, iColSize, spanFloats);
+        FromFloat(out, 1.0, GetFormat(), reinterpret_cast<uint8_t*>(GetRow(i)) + minImage.x * GetPixelSize(), spanFloats);
+      }
+    });
+  }
+
+  Image Image::Convert(Components iComp, Format iFormat, JobSystem* iJobs) const
+  {
+    Image converted(nullptr, m_Size, iComp, iFormat, m_RowAlign);
+    if (converted.GetByteSize() == 0)
+    {
+      return converted;
     }
 
-    if(m_StorageKind == Adopt)
+    uint32_t const srcComp = compTab[GetComponents()];
+    uint32_t const dstComp = compTab[iComp];
+    double const srcScale = 1.0 / formatMaxTab[GetFormat()];
+    double const dstScale = formatMaxTab[iFormat];
+    int const* srcSwizzle = swizzleTab[GetComponents()];
+    int const* dstSwizzle = swizzleTab[iComp];
+
+    ForRowRanges(iJobs, 0, m_Size.y, [&](uint32_t iBegin, uint32_t iEnd)
+    {
+      if (iComp == GetComponents() && iFormat == GetFormat())
+      {
+        for (uint32_t i = iBegin; i < iEnd; ++i)
+        {
+          memcpy(converted.GetRow(i), GetRow(i), m_Size.x * GetPixelSize());
+        }
+        return;
+      }
+
+      Vector<float> srcRow(m_Size.x * srcComp);
+      Vector<float> dstRow(m_Size.x * dstComp);
+      for (uint32_t i = iBegin; i < iEnd; ++i)
+      {
+        ToFloat(GetRow(i), GetFormat(), srcScale, srcRow.data(), srcRow.size());
+        float const* outRow = srcRow.data();
+        if (iComp != GetComponents())
+        {
+          for (uint32_t j = 0; j < m_Size.x; ++j)
+          {
+            float rgba[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+            for (uint32_t k = 0; k < srcComp; ++k)
+            {
+              rgba[srcSwizzle[k]] = srcRow[j * srcComp + k];
+            }
+            for (uint32_t k = 0; k < dstComp; ++k)
+            {
+              dstRow[j * dstComp + k] = rgba[dstSwizzle[k]];
+            }
+          }
+          outRow = dstRow.data();
+        }
+        FromFloat(outRow, dstScale, iFormat, converted.GetRow(i), m_Size.x * dstComp);
+      }
+    });
+
+    return converted;
+  }
+
+  void Image::Premultiply(JobSystem* iJobs)
+  {
+    if (GetComponents() != RGBA && GetComponents() != BGRA)
     {
-      eXl_FREE(m_ImageData);
+      return;
     }
-    m_StorageKind = Adopt;
-    m_ImageData = newImage;
+
+    ForRowRanges(iJobs, 0, m_Size.y, [&](uint32_t iBegin, uint32_t iEnd)
+    {
+      for (uint32_t i = iBegin; i < iEnd; ++i)
+      {
+        uint32_t j = 0;
+        switch (GetFormat())
+        {
+        case Char:
+        {
+          uint8_t* row = reinterpret_cast<uint8_t*>(GetRow(i));
+#ifdef EXL_IMAGE_SSE2
+          __m128i const zero = _mm_setzero_si128();
+          __m128i const half = _mm_set1_epi16(128);
+          __m128i const alphaMask = _mm_set1_epi32(int(0xFF000000));
+          // round(c * a / 255) computed as (x + (x >> 8)) >> 8 with x = c * a + 128.
+          auto premultiply2 = [&](__m128i iPixels)
+          {
+            __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(iPixels, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+            __m128i product = _mm_add_epi16(_mm_mullo_epi16(iPixels, alpha), half);
+            return _mm_srli_epi16(_mm_add_epi16(product, _mm_srli_epi16(product, 8)), 8);
+          };
+          for (; j + 4 <= m_Size.x; j += 4)
+          {
+            __m128i pixels = _mm_loadu_si128(reinterpret_cast<__m128i const*>(row + j * 4));
+            __m128i colors = _mm_packus_epi16(premultiply2(_mm_unpacklo_epi8(pixels, zero)), premultiply2(_mm_unpackhi_epi8(pixels, zero)));
+            colors = _mm_or_si128(_mm_andnot_si128(alphaMask, colors), _mm_and_si128(alphaMask, pixels));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(row + j * 4), colors);
+          }
+#endif
+          for (; j < m_Size.x; ++j)
+          {
+            uint8_t* pixel = row + j * 4;
+            for (uint32_t k = 0; k < 3; ++k)
+            {
+              uint32_t product = pixel[k] * pixel[3] + 128;
+              pixel[k] = uint8_t((product + (product >> 8)) >> 8);
+            }
+          }
+          break;
+        }
+        case Short:
+        {
+          uint16_t* row = reinterpret_cast<uint16_t*>(GetRow(i));
+          for (; j < m_Size.x; ++j)
+          {
+            uint16_t* pixel = row + j * 4;
+            for (uint32_t k = 0; k < 3; ++k)
+            {
+              pixel[k] = uint16_t((uint32_t(pixel[k]) * pixel[3] + 32767) / 65535);
+            }
+          }
+          break;
+        }
+        case Int:
+        {
+          uint32_t* row = reinterpret_cast<uint32_t*>(GetRow(i));
+          for (; j < m_Size.x; ++j)
+          {
+            uint32_t* pixel = row + j * 4;
+            for (uint32_t k = 0; k < 3; ++k)
+            {
+              pixel[k] = uint32_t((uint64_t(pixel[k]) * pixel[3] + 0x7FFFFFFF) / 0xFFFFFFFF);
+            }
+          }
+          break;
+        }
+        case Float:
+        {
+          float* row = reinterpret_cast<float*>(GetRow(i));
+          for (; j < m_Size.x; ++j)
+          {
+            float* pixel = row + j * 4;
+            pixel[0] *= pixel[3];
+            pixel[1] *= pixel[3];
+            pixel[2] *= pixel[3];
+          }
+          break;
+        }
+        }
+      }
+    });
   }
 }
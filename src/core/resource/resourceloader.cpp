@@ -12,6 +12,8 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <core/resource/resourcemanager.hpp>
 #include <core/stream/jsonstreamer.hpp>
 #include <core/stream/jsonunstreamer.hpp>
+#include <core/stream/binarystreamer.hpp>
+#include <core/stream/binaryunstreamer.hpp>
 #include <core/stream/writer.hpp>
 #include <core/stream/textreader.hpp>
 #include <sstream>
@@ -20,6 +22,41 @@ namespace eXl
 {
   Err ResourceLoader::Save(Resource* iRsc, Writer& iWriter) const
   {
+    if (auto binWriter = BinaryWriter::DynamicCast(&iWriter))
+    {
+      std::stringstream sstream;
+      BinaryStreamer streamer(&sstream);
+      Err res = streamer.Begin();
+      if (res)
+      {
+        res = iRsc->Stream(streamer);
+      }
+      if (res)
+      {
+        res = streamer.End();
+      }
+
+      if (!res)
+      {
+        LOG_ERROR << "Error saving asset " << iRsc->GetName() << "\n";
+        return res;
+      }
+
+      std::string const str = sstream.str();
+      {
+        BinaryUnstreamer unstreamer((uint8_t const*)str.data(), str.size());
+        if (!unstreamer.Begin())
+        {
+          LOG_ERROR << "Error while checking that temp saved resource can be read : " << iRsc->GetName() << "\n";
+          return Err::Failure;
+        }
+      }
+
+      binWriter->m_Stream.write(str.data(), str.size());
+
+      return res;
+    }
+
     if (auto stdWriter = StdOutWriter::DynamicCast(&iWriter))
     {
       std::stringstream sstream;
@@ -61,6 +98,35 @@ namespace eXl
 
   Resource* ResourceLoader::Load(Resource::Header const& iHeader, ResourceMetaData* iMetaData, Reader& iReader) const
   {
+    if (iHeader.m_Flags & Resource::BinaryResource)
+    {
+      TextReader* textReader = TextReader::DynamicCast(&iReader);
+      KString view = textReader ? textReader->GetView() : KString();
+      if (view.empty())
+      {
+        LOG_ERROR << "Binary asset " << iHeader.m_ResourceName << " is not available in memory" << "\n";
+        return nullptr;
+      }
+
+      Resource* rsc = Create_Impl(iMetaData);
+      BinaryUnstreamer unstreamer((uint8_t const*)view.data(), view.size());
+      Err res = unstreamer.Begin();
+      if (res)
+      {
+        res = rsc->Unstream(unstreamer);
+      }
+      if (res)
+      {
+        res = unstreamer.End();
+      }
+      if (!res)
+      {
+        eXl_DELETE rsc;
+        return nullptr;
+      }
+      return rsc;
+    }
+
     if (auto textReader = TextReader::DynamicCast(&iReader))
     {
       Resource* rsc = Create_Impl(iMetaData);
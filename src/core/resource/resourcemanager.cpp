@@ -12,6 +12,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <core/stream/stream_base.hpp>
 #include <core/stream/jsonunstreamer.hpp>
 #include <core/stream/jsonstreamer.hpp>
+#include <core/stream/binaryunstreamer.hpp>
 #include <core/log.hpp>
 #include <boost/uuid/random_generator.hpp>
 #include <core/type/resourcehandletype.hpp>
@@ -440,13 +441,30 @@ namespace eXl
       std::unique_ptr<TextReader> reader = GetImpl().m_TextFileRead(iPath);
       if (reader)
       {
-        String headerStr = ExtractHeader(*reader);
-        StringViewReader strReader(iPath, headerStr.data(), headerStr.data() + headerStr.size());
-
-        JSONUnstreamer unstreamer(&strReader);
-        unstreamer.Begin();
-        oHeader.Unstream(unstreamer);
-        unstreamer.End();
+        KString view = reader->GetView();
+        if (BinaryUnstreamer::IsBinary(view.data(), view.size()))
+        {
+          BinaryUnstreamer unstreamer((uint8_t const*)view.data(), view.size());
+          if (unstreamer.Begin() && unstreamer.PushKey("Header"))
+          {
+            oHeader.Unstream(unstreamer);
+            unstreamer.PopKey();
+          }
+          unstreamer.End();
+          oHeader.m_Flags |= Resource::BinaryResource;
+        }
+        else
+        {
+          String headerStr = ExtractHeader(*reader);
+          StringViewReader strReader(iPath, headerStr.data(), headerStr.data() + headerStr.size());
+
+          JSONUnstreamer unstreamer(&strReader);
+          unstreamer.Begin();
+          oHeader.Unstream(unstreamer);
+          unstreamer.End();
+          // The flag describes the file, not the resource, and may have been saved from a binary asset.
+          oHeader.m_Flags &= ~Resource::BinaryResource;
+        }
 
         if (oHeader.m_ResourceId.IsValid())
         {
@@ -530,8 +548,41 @@ namespace eXl
       return newEntry;
     }
 
+    void PreInternNames(String const& iDir)
+    {
+      String namesPath = iDir.empty() ? String("eXlNames") : iDir + "/eXlNames";
+      auto reader = GetImpl().m_TextFileRead(namesPath.c_str());
+      if (!reader)
+      {
+        return;
+      }
+
+      JSONUnstreamer unstreamer(reader.get());
+      if (!unstreamer.Begin())
+      {
+        LOG_ERROR << "Invalid JSON while reading names " << namesPath << "\n";
+        return;
+      }
+
+      Vector<String> names;
+      if (unstreamer.BeginSequence())
+      {
+        do
+        {
+          names.emplace_back();
+          unstreamer.ReadString(&names.back());
+        } while (unstreamer.NextSequenceElement());
+      }
+      unstreamer.End();
+
+      Vector<KString> namesView(names.begin(), names.end());
+      Name::PreIntern(namesView);
+    }
+
     void BootstrapAssetsFromManifest(String const& iDir)
     {
+      PreInternNames(iDir);
+
       String manifestPath("eXlManifest");
       bool validDir = true;
 //#ifdef EXL_RSC_HAS_FILESYSTEM
@@ -935,7 +986,7 @@ namespace eXl
       return alreadySavedResource != GetImpl().m_PathToEntry.end();
     }
 
-    void Bake(Path const& iDest)
+    void Bake(Path const& iDest, bool iBinary)
     {
       eXl_ASSERT_REPAIR_RET(Filesystem::exists(iDest) && Filesystem::is_directory(iDest), );
 
@@ -967,9 +1018,11 @@ namespace eXl
 
           ResourceLoader& loader = *GetImpl().m_Loaders[resourceType].loader;
           std::ofstream outputStream;
-          outputStream.open(completePath);
+          outputStream.open(completePath, iBinary ? std::ios::out | std::ios::binary : std::ios::out);
 
-          StdOutWriter writer(outputStream);
+          BinaryWriter binWriter(outputStream);
+          StdOutWriter textWriter(outputStream);
+          StdOutWriter& writer = iBinary ? binWriter : textWriter;
           
           if (loader.NeedsBaking(rsc))
           {
@@ -999,6 +1052,23 @@ namespace eXl
       }
       streamer.EndSequence();
       streamer.End();
+
+      // Every name seen while loading the assets, pre-interned in one go when booting from the manifest.
+      Path namesPath = iDest / "eXlNames";
+
+      std::ofstream namesStream;
+      namesStream.open(namesPath);
+
+      JSONStreamer namesStreamer(&namesStream);
+      namesStreamer.Begin();
+      namesStreamer.BeginSequence();
+      for (KString name : Name::GetInternedStrings())
+      {
+        String nameStr(name);
+        namesStreamer.Write(&nameStr);
+      }
+      namesStreamer.EndSequence();
+      namesStreamer.End();
     }
 #endif
   }
@@ -0,0 +1,359 @@
+/*
+Copyright 2009-2021 Nicolas Colombe
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <core/stream/binarystreamer.hpp>
+#include <core/log.hpp>
+
+#include <cstring>
+
+#define CHECK_FAIL_STATUS do { if(m_StreamFailed) return Err::Error;} while(false)
+
+namespace eXl
+{
+  namespace
+  {
+    void PatchUInt32(Vector<uint8_t>& ioBuffer, size_t iOffset, uint32_t iValue)
+    {
+      for (uint32_t i = 0; i < 4; ++i)
+      {
+        ioBuffer[iOffset + i] = uint8_t(iValue >> (8 * i));
+      }
+    }
+  }
+
+  BinaryStreamer::BinaryStreamer(std::ostream* iOutStream)
+    : m_OutStream(iOutStream)
+  {
+  }
+
+  Err BinaryStreamer::Begin()
+  {
+    m_Body.clear();
+    m_Containers.clear();
+    m_Keys.clear();
+    m_KeysIdx.clear();
+    m_PendingKey.reset();
+    m_RootWritten = false;
+    m_StreamFailed = false;
+    return Streamer::Begin();
+  }
+
+  Err BinaryStreamer::End()
+  {
+    Err err = Streamer::End();
+    if (err)
+    {
+      if (!m_Containers.empty())
+      {
+        LOG_ERROR << "Struct or sequence is still opened" << "\n";
+        RETURN_FAILURE;
+      }
+      if (m_PendingKey)
+      {
+        LOG_ERROR << "Keys are still pushed" << "\n";
+        RETURN_FAILURE;
+      }
+      CHECK_FAIL_STATUS;
+
+      Vector<uint8_t> body;
+      body.swap(m_Body);
+
+      WriteRaw(s_Magic, sizeof(s_Magic));
+      WriteRaw(&s_Version, 1);
+      WriteVarUInt(m_Keys.size());
+      for (auto const& key : m_Keys)
+      {
+        WriteVarUInt(key.size());
+        WriteRaw(key.data(), key.size());
+      }
+
+      m_OutStream->write((char const*)m_Body.data(), m_Body.size());
+      m_OutStream->write((char const*)body.data(), body.size());
+      m_Body.clear();
+
+      if (!m_OutStream->good())
+      {
+        LOG_ERROR << "Failed to write binary stream" << "\n";
+        RETURN_FAILURE;
+      }
+    }
+    return err;
+  }
+
+  void BinaryStreamer::WriteVarUInt(uint64_t iValue)
+  {
+    while (iValue >= 0x80)
+    {
+      m_Body.push_back(uint8_t(iValue) | 0x80);
+      iValue >>= 7;
+    }
+    m_Body.push_back(uint8_t(iValue));
+  }
+
+  void BinaryStreamer::WriteRaw(void const* iData, size_t iSize)
+  {
+    uint8_t const* data = reinterpret_cast<uint8_t const*>(iData);
+    m_Body.insert(m_Body.end(), data, data + iSize);
+  }
+
+  Err BinaryStreamer::PushKey(KString iKey)
+  {
+    CHECK_FAIL_STATUS;
+    if (m_Containers.empty() || m_Containers.back().m_Sequence || m_PendingKey)
+    {
+      LOG_ERROR << "Not a valid element to push a key" << "\n";
+      m_StreamFailed = true;
+      return Err::Error;
+    }
+
+    String keyStr(iKey.data(), iKey.size());
+    auto iter = m_KeysIdx.find(keyStr);
+    if (iter == m_KeysIdx.end())
+    {
+      iter = m_KeysIdx.insert(std::make_pair(keyStr, uint32_t(m_Keys.size()))).first;
+      m_Keys.push_back(keyStr);
+    }
+
+    m_PendingKey = m_Body.size();
+    WriteVarUInt(iter->second);
+    ++m_Containers.back().m_Count;
+
+    RETURN_SUCCESS;
+  }
+
+  Err BinaryStreamer::PopKey()
+  {
+    CHECK_FAIL_STATUS;
+    if (m_Containers.empty() || m_Containers.back().m_Sequence)
+    {
+      LOG_ERROR << "Not a valid element to pop a key" << "\n";
+      m_StreamFailed = true;
+      return Err::Error;
+    }
+    if (m_PendingKey)
+    {
+      // Nothing was written for this key, drop it.
+      m_Body.resize(*m_PendingKey);
+      --m_Containers.back().m_Count;
+      m_PendingKey.reset();
+    }
+    RETURN_SUCCESS;
+  }
+
+  Err BinaryStreamer::ElementPrologue()
+  {
+    CHECK_FAIL_STATUS;
+    if (m_Containers.empty())
+    {
+      if (m_RootWritten)
+      {
+        LOG_ERROR << "Only one root element can be written" << "\n";
+        m_StreamFailed = true;
+        return Err::Error;
+      }
+      m_RootWritten = true;
+    }
+    else if (m_Containers.back().m_Sequence)
+    {
+      ++m_Containers.back().m_Count;
+    }
+    else
+    {
+      if (!m_PendingKey)
+      {
+        LOG_ERROR << "Writing a struct field without a key" << "\n";
+        m_StreamFailed = true;
+        return Err::Error;
+      }
+      m_PendingKey.reset();
+    }
+    RETURN_SUCCESS;
+  }
+
+  Err BinaryStreamer::BeginContainer(bool iSequence)
+  {
+    Err err = ElementPrologue();
+    if (err)
+    {
+      m_Body.push_back(iSequence ? SequenceTag : StructTag);
+      Container newContainer;
+      newContainer.m_Offset = m_Body.size();
+      newContainer.m_Count = 0;
+      newContainer.m_Sequence = iSequence;
+      m_Containers.push_back(newContainer);
+      // Byte size and element count, patched by EndContainer.
+      m_Body.resize(m_Body.size() + 8);
+    }
+    return err;
+  }
+
+  Err BinaryStreamer::EndContainer(bool iSequence)
+  {
+    CHECK_FAIL_STATUS;
+    if (m_Containers.empty() || m_Containers.back().m_Sequence != iSequence || m_PendingKey)
+    {
+      LOG_ERROR << "Mismatched end of " << (iSequence ? "sequence" : "struct") << "\n";
+      m_StreamFailed = true;
+      return Err::Error;
+    }
+    Container const& container = m_Containers.back();
+    size_t const contentSize = m_Body.size() - (container.m_Offset + 8);
+    PatchUInt32(m_Body, container.m_Offset, uint32_t(contentSize));
+    PatchUInt32(m_Body, container.m_Offset + 4, container.m_Count);
+    m_Containers.pop_back();
+
+    RETURN_SUCCESS;
+  }
+
+  Err BinaryStreamer::BeginSequence()
+  {
+    return BeginContainer(true);
+  }
+
+  Err BinaryStreamer::EndSequence()
+  {
+    return EndContainer(true);
+  }
+
+  Err BinaryStreamer::BeginStruct()
+  {
+    return BeginContainer(false);
+  }
+
+  Err BinaryStreamer::EndStruct()
+  {
+    return EndContainer(false);
+  }
+
+  Err BinaryStreamer::WriteBool(bool const* iBoolean)
+  {
+    Err err = ElementPrologue();
+    if (err)
+    {
+      m_Body.push_back(*iBoolean ? BoolTrueTag : BoolFalseTag);
+    }
+    return err;
+  }
+
+  Err BinaryStreamer::WriteInt(int const* iInt)
+  {
+    Err err = ElementPrologue();
+    if (err)
+    {
+      // Zigzag encoding keeps small negative values short.
+      uint32_t const value = (uint32_t(*iInt) << 1) ^ uint32_t(*iInt >> 31);
+      m_Body.push_back(IntTag);
+      WriteVarUInt(value);
+    }
+    return err;
+  }
+
+  Err BinaryStreamer::WriteUInt(unsigned int const* iUInt)
+  {
+    Err err = ElementPrologue();
+    if (err)
+    {
+      m_Body.push_back(UIntTag);
+      WriteVarUInt(*iUInt);
+    }
+    return err;
+  }
+
+  Err BinaryStreamer::WriteUInt64(uint64_t const* iUInt)
+  {
+    Err err = ElementPrologue();
+    if (err)
+    {
+      m_Body.push_back(UIntTag);
+      WriteVarUInt(*iUInt);
+    }
+    return err;
+  }
+
+  Err BinaryStreamer::WriteFloat(float const* iFloat)
+  {
+    Err err = ElementPrologue();
+    if (err)
+    {
+      uint32_t bits;
+      memcpy(&bits, iFloat, sizeof(bits));
+      m_Body.push_back(FloatTag);
+      m_Body.resize(m_Body.size() + 4);
+      PatchUInt32(m_Body, m_Body.size() - 4, bits);
+    }
+    return err;
+  }
+
+  Err BinaryStreamer::WriteDouble(double const* iDouble)
+  {
+    Err err = ElementPrologue();
+    if (err)
+    {
+      uint64_t bits;
+      memcpy(&bits, iDouble, sizeof(bits));
+      m_Body.push_back(DoubleTag);
+      m_Body.resize(m_Body.size() + 8);
+      PatchUInt32(m_Body, m_Body.size() - 8, uint32_t(bits));
+      PatchUInt32(m_Body, m_Body.size() - 4, uint32_t(bits >> 32));
+    }
+    return err;
+  }
+
+  Err BinaryStreamer::WriteString(Char const* iStr)
+  {
+    return WriteString(KString(iStr));
+  }
+
+  Err BinaryStreamer::WriteString(KString const& iStr)
+  {
+    Err err = ElementPrologue();
+    if (err)
+    {
+      m_Body.push_back(StringTag);
+      WriteVarUInt(iStr.size());
+      WriteRaw(iStr.data(), iStr.size());
+    }
+    return err;
+  }
+
+  Err BinaryStreamer::WriteBinary(uint8_t const* iData, size_t iSize)
+  {
+    Err err = ElementPrologue();
+    if (err)
+    {
+      m_Body.push_back(BinaryTag);
+      WriteVarUInt(iSize);
+      WriteRaw(iData, iSize);
+    }
+    return err;
+  }
+
+  Err BinaryStreamer::WriteBinary(std::istream* iStream, Optional<size_t> iLen)
+  {
+    Vector<uint8_t> data;
+    if (iLen)
+    {
+      data.resize(*iLen);
+      iStream->read((char*)data.data(), *iLen);
+      data.resize(iStream->gcount());
+    }
+    else
+    {
+      size_t const bufferSize = 4096;
+      char buffer[bufferSize];
+      do
+      {
+        iStream->read(buffer, bufferSize);
+        data.insert(data.end(), buffer, buffer + iStream->gcount());
+      } while (iStream->gcount() > 0);
+    }
+    return WriteBinary(data.data(), data.size());
+  }
+}
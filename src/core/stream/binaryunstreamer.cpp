@@ -0,0 +1,503 @@
+/*
+Copyright 2009-2021 Nicolas Colombe
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <core/stream/binaryunstreamer.hpp>
+#include <core/stream/binarystreamer.hpp>
+#include <core/log.hpp>
+
+#include <cstring>
+
+#define CHECK_FAIL_STATUS do { if(m_FailStatus) return Err::Error;} while(false)
+
+namespace eXl
+{
+  namespace
+  {
+    template <typename T>
+    T ConvertNumber(uint8_t iTag, uint64_t iBits)
+    {
+      switch (iTag)
+      {
+      case BinaryStreamer::IntTag:
+        return T(int64_t(iBits));
+      case BinaryStreamer::FloatTag:
+      {
+        uint32_t bits = uint32_t(iBits);
+        float value;
+        memcpy(&value, &bits, sizeof(value));
+        return T(value);
+      }
+      case BinaryStreamer::DoubleTag:
+      {
+        double value;
+        memcpy(&value, &iBits, sizeof(value));
+        return T(value);
+      }
+      default:
+        return T(iBits);
+      }
+    }
+  }
+
+  BinaryUnstreamer::BinaryUnstreamer(uint8_t const* iData, size_t iSize)
+    : m_Data(iData)
+    , m_Size(iSize)
+  {
+  }
+
+  bool BinaryUnstreamer::IsBinary(void const* iData, size_t iSize)
+  {
+    return iSize > sizeof(BinaryStreamer::s_Magic)
+      && memcmp(iData, BinaryStreamer::s_Magic, sizeof(BinaryStreamer::s_Magic)) == 0;
+  }
+
+  Err BinaryUnstreamer::Fail()
+  {
+    m_FailStatus = true;
+    return Err::Error;
+  }
+
+  Err BinaryUnstreamer::Begin()
+  {
+    m_FailStatus = false;
+    m_Stack.clear();
+    m_KeysIdx.clear();
+
+    if (!IsBinary(m_Data, m_Size))
+    {
+      LOG_ERROR << "Not a binary stream" << "\n";
+      return Fail();
+    }
+    size_t offset = sizeof(BinaryStreamer::s_Magic);
+    if (m_Data[offset++] != BinaryStreamer::s_Version)
+    {
+      LOG_ERROR << "Unsupported binary stream version" << "\n";
+      return Fail();
+    }
+
+    uint64_t numKeys;
+    if (!ReadVarUInt(offset, numKeys))
+    {
+      return Fail();
+    }
+    for (uint64_t i = 0; i < numKeys; ++i)
+    {
+      uint64_t keyLen;
+      if (!ReadVarUInt(offset, keyLen) || keyLen > m_Size - offset)
+      {
+        return Fail();
+      }
+      m_KeysIdx.insert(std::make_pair(KString((char const*)m_Data + offset, keyLen), uint32_t(i)));
+      offset += keyLen;
+    }
+
+    if (offset >= m_Size)
+    {
+      return Fail();
+    }
+    m_Stack.push_back(Cursor(offset));
+
+    return Unstreamer::Begin();
+  }
+
+  Err BinaryUnstreamer::End()
+  {
+    m_Stack.clear();
+    m_KeysIdx.clear();
+    Unstreamer::End();
+    if (m_FailStatus)
+    {
+      return Err::Failure;
+    }
+    return Err::Success;
+  }
+
+  bool BinaryUnstreamer::ReadVarUInt(size_t& ioOffset, uint64_t& oValue)
+  {
+    oValue = 0;
+    for (uint32_t shift = 0; shift < 64 && ioOffset < m_Size; shift += 7)
+    {
+      uint8_t const byte = m_Data[ioOffset++];
+      oValue |= uint64_t(byte & 0x7F) << shift;
+      if ((byte & 0x80) == 0)
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool BinaryUnstreamer::ReadFixed(size_t& ioOffset, uint32_t iSize, uint64_t& oValue)
+  {
+    if (iSize > m_Size - ioOffset)
+    {
+      return false;
+    }
+    oValue = 0;
+    for (uint32_t i = 0; i < iSize; ++i)
+    {
+      oValue |= uint64_t(m_Data[ioOffset++]) << (8 * i);
+    }
+    return true;
+  }
+
+  bool BinaryUnstreamer::GetContainer(size_t iOffset, uint8_t iTag, Container& oContainer)
+  {
+    if (iOffset >= m_Size || m_Data[iOffset] != iTag)
+    {
+      return false;
+    }
+    ++iOffset;
+    uint64_t size;
+    uint64_t count;
+    if (!ReadFixed(iOffset, 4, size) || !ReadFixed(iOffset, 4, count)
+      || size > m_Size - iOffset)
+    {
+      m_FailStatus = true;
+      return false;
+    }
+    oContainer.m_Content = iOffset;
+    oContainer.m_End = iOffset + size;
+    oContainer.m_Count = count;
+    return true;
+  }
+
+  bool BinaryUnstreamer::SkipElement(size_t& ioOffset)
+  {
+    if (ioOffset >= m_Size)
+    {
+      return false;
+    }
+    uint64_t value;
+    switch (m_Data[ioOffset])
+    {
+    case BinaryStreamer::BoolFalseTag:
+    case BinaryStreamer::BoolTrueTag:
+      ++ioOffset;
+      return true;
+    case BinaryStreamer::IntTag:
+    case BinaryStreamer::UIntTag:
+      ++ioOffset;
+      return ReadVarUInt(ioOffset, value);
+    case BinaryStreamer::FloatTag:
+      ++ioOffset;
+      return ReadFixed(ioOffset, 4, value);
+    case BinaryStreamer::DoubleTag:
+      ++ioOffset;
+      return ReadFixed(ioOffset, 8, value);
+    case BinaryStreamer::StringTag:
+    case BinaryStreamer::BinaryTag:
+      ++ioOffset;
+      if (!ReadVarUInt(ioOffset, value) || value > m_Size - ioOffset)
+      {
+        return false;
+      }
+      ioOffset += value;
+      return true;
+    case BinaryStreamer::StructTag:
+    case BinaryStreamer::SequenceTag:
+    {
+      Container container;
+      if (!GetContainer(ioOffset, m_Data[ioOffset], container))
+      {
+        return false;
+      }
+      ioOffset = container.m_End;
+      return true;
+    }
+    default:
+      return false;
+    }
+  }
+
+  uint8_t BinaryUnstreamer::CurrentTag()
+  {
+    if (m_Stack.empty() || m_Stack.back().m_Offset >= m_Size)
+    {
+      return 0xFF;
+    }
+    return m_Data[m_Stack.back().m_Offset];
+  }
+
+  Err BinaryUnstreamer::PushKey(KString iKey)
+  {
+    CHECK_FAIL_STATUS;
+    Container structure;
+    if (m_Stack.empty() || !GetContainer(m_Stack.back().m_Offset, BinaryStreamer::StructTag, structure))
+    {
+      LOG_ERROR << "Not a valid element to look for a key" << "\n";
+      return Err::Failure;
+    }
+
+    auto keyIter = m_KeysIdx.find(iKey);
+    if (keyIter == m_KeysIdx.end())
+    {
+      return Err::Failure;
+    }
+
+    size_t offset = structure.m_Content;
+    for (uint32_t i = 0; i < structure.m_Count; ++i)
+    {
+      uint64_t keyIdx;
+      if (!ReadVarUInt(offset, keyIdx))
+      {
+        return Fail();
+      }
+      if (keyIdx == keyIter->second)
+      {
+        m_Stack.push_back(Cursor(offset));
+        RETURN_SUCCESS;
+      }
+      if (!SkipElement(offset) || offset > structure.m_End)
+      {
+        return Fail();
+      }
+    }
+
+    return Err::Failure;
+  }
+
+  Err BinaryUnstreamer::PopKey()
+  {
+    CHECK_FAIL_STATUS;
+    if (!m_Stack.empty())
+    {
+      m_Stack.pop_back();
+      if (CurrentTag() == BinaryStreamer::StructTag)
+      {
+        RETURN_SUCCESS;
+      }
+    }
+    return Err::Error;
+  }
+
+  Err BinaryUnstreamer::BeginStruct()
+  {
+    CHECK_FAIL_STATUS;
+    if (CurrentTag() == BinaryStreamer::StructTag)
+      RETURN_SUCCESS;
+    return Err::Error;
+  }
+
+  Err BinaryUnstreamer::EndStruct()
+  {
+    CHECK_FAIL_STATUS;
+    if (CurrentTag() == BinaryStreamer::StructTag)
+      RETURN_SUCCESS;
+    return Err::Error;
+  }
+
+  Err BinaryUnstreamer::BeginSequence()
+  {
+    CHECK_FAIL_STATUS;
+    Container sequence;
+    if (m_Stack.empty() || m_Stack.back().m_SeqIdx != -1
+      || !GetContainer(m_Stack.back().m_Offset, BinaryStreamer::SequenceTag, sequence))
+    {
+      return Err::Error;
+    }
+    if (sequence.m_Count == 0)
+    {
+      return Err::Failure;
+    }
+    m_Stack.back().m_SeqIdx = 0;
+    m_Stack.push_back(Cursor(sequence.m_Content));
+    RETURN_SUCCESS;
+  }
+
+  Err BinaryUnstreamer::NextSequenceElement()
+  {
+    CHECK_FAIL_STATUS;
+    if (m_Stack.size() < 2)
+    {
+      return Err::Error;
+    }
+    Container sequence;
+    size_t const seqIdx = m_Stack.size() - 2;
+    if (!GetContainer(m_Stack[seqIdx].m_Offset, BinaryStreamer::SequenceTag, sequence)
+      || m_Stack[seqIdx].m_SeqIdx < 0)
+    {
+      return Err::Error;
+    }
+
+    size_t offset = m_Stack.back().m_Offset;
+    m_Stack.pop_back();
+    int& curIdx = m_Stack.back().m_SeqIdx;
+    if (curIdx + 1 >= int(sequence.m_Count))
+    {
+      curIdx = -1;
+      return Err::Failure;
+    }
+    if (!SkipElement(offset) || offset >= sequence.m_End)
+    {
+      return Fail();
+    }
+    ++curIdx;
+    m_Stack.push_back(Cursor(offset));
+    RETURN_SUCCESS;
+  }
+
+  bool BinaryUnstreamer::ReadNumber(uint8_t& oTag, uint64_t& oBits)
+  {
+    if (m_FailStatus || m_Stack.empty())
+    {
+      return false;
+    }
+    size_t offset = m_Stack.back().m_Offset;
+    oTag = CurrentTag();
+    ++offset;
+    switch (oTag)
+    {
+    case BinaryStreamer::IntTag:
+      if (!ReadVarUInt(offset, oBits))
+      {
+        return false;
+      }
+      oBits = uint64_t(int64_t(oBits >> 1) ^ -int64_t(oBits & 1));
+      return true;
+    case BinaryStreamer::UIntTag:
+      return ReadVarUInt(offset, oBits);
+    case BinaryStreamer::FloatTag:
+      return ReadFixed(offset, 4, oBits);
+    case BinaryStreamer::DoubleTag:
+      return ReadFixed(offset, 8, oBits);
+    default:
+      return false;
+    }
+  }
+
+  Err BinaryUnstreamer::ReadBool(bool* oBoolean)
+  {
+    CHECK_FAIL_STATUS;
+    uint8_t const tag = CurrentTag();
+    if (tag == BinaryStreamer::BoolTrueTag || tag == BinaryStreamer::BoolFalseTag)
+    {
+      *oBoolean = tag == BinaryStreamer::BoolTrueTag;
+      RETURN_SUCCESS;
+    }
+    if (tag == BinaryStreamer::StringTag)
+    {
+      String tempStr;
+      ReadString(&tempStr);
+      if (tempStr == "true" || tempStr == "false")
+      {
+        *oBoolean = tempStr == "true";
+        RETURN_SUCCESS;
+      }
+    }
+    return Err::Failure;
+  }
+
+  Err BinaryUnstreamer::ReadInt(int * oInt)
+  {
+    CHECK_FAIL_STATUS;
+    uint8_t tag;
+    uint64_t bits;
+    if (!ReadNumber(tag, bits))
+    {
+      return Err::Error;
+    }
+    *oInt = ConvertNumber<int>(tag, bits);
+    RETURN_SUCCESS;
+  }
+
+  Err BinaryUnstreamer::ReadUInt(unsigned int * oUInt)
+  {
+    CHECK_FAIL_STATUS;
+    uint8_t tag;
+    uint64_t bits;
+    if (!ReadNumber(tag, bits))
+    {
+      return Err::Error;
+    }
+    *oUInt = ConvertNumber<unsigned int>(tag, bits);
+    RETURN_SUCCESS;
+  }
+
+  Err BinaryUnstreamer::ReadUInt64(uint64_t * oUInt)
+  {
+    CHECK_FAIL_STATUS;
+    uint8_t tag;
+    uint64_t bits;
+    if (!ReadNumber(tag, bits))
+    {
+      return Err::Error;
+    }
+    *oUInt = ConvertNumber<uint64_t>(tag, bits);
+    RETURN_SUCCESS;
+  }
+
+  Err BinaryUnstreamer::ReadFloat(float * oFloat)
+  {
+    CHECK_FAIL_STATUS;
+    uint8_t tag;
+    uint64_t bits;
+    if (!ReadNumber(tag, bits))
+    {
+      return Err::Error;
+    }
+    *oFloat = ConvertNumber<float>(tag, bits);
+    RETURN_SUCCESS;
+  }
+
+  Err BinaryUnstreamer::ReadDouble(double * oDouble)
+  {
+    CHECK_FAIL_STATUS;
+    uint8_t tag;
+    uint64_t bits;
+    if (!ReadNumber(tag, bits))
+    {
+      return Err::Error;
+    }
+    *oDouble = ConvertNumber<double>(tag, bits);
+    RETURN_SUCCESS;
+  }
+
+  Err BinaryUnstreamer::ReadString(String* oStr)
+  {
+    CHECK_FAIL_STATUS;
+    uint8_t const tag = CurrentTag();
+    if (tag == BinaryStreamer::BoolTrueTag || tag == BinaryStreamer::BoolFalseTag)
+    {
+      *oStr = tag == BinaryStreamer::BoolTrueTag ? "true" : "false";
+      RETURN_SUCCESS;
+    }
+    if (tag != BinaryStreamer::StringTag)
+    {
+      return Err::Error;
+    }
+    size_t offset = m_Stack.back().m_Offset + 1;
+    uint64_t len;
+    if (!ReadVarUInt(offset, len) || len > m_Size - offset)
+    {
+      return Fail();
+    }
+    oStr->assign((char const*)m_Data + offset, len);
+    RETURN_SUCCESS;
+  }
+
+  Err BinaryUnstreamer::ReadBinary(Vector<uint8_t>* oData)
+  {
+    CHECK_FAIL_STATUS;
+    uint8_t const tag = CurrentTag();
+    if (tag != BinaryStreamer::BinaryTag && tag != BinaryStreamer::StringTag)
+    {
+      return Err::Error;
+    }
+    size_t offset = m_Stack.back().m_Offset + 1;
+    uint64_t len;
+    if (!ReadVarUInt(offset, len) || len > m_Size - offset)
+    {
+      return Fail();
+    }
+    oData->assign(m_Data + offset, m_Data + offset + len);
+    RETURN_SUCCESS;
+  }
+}
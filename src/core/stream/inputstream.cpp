@@ -254,6 +254,20 @@ namespace eXl
     return m_CurOffset;
   }
 
+  KString InputStreamTextReader::GetView() const
+  {
+    if (m_Stream == nullptr)
+    {
+      return KString();
+    }
+    if (m_Content.size() != m_Stream->GetSize())
+    {
+      m_Content.resize(m_Stream->GetSize());
+      m_Content.resize(m_Stream->Read(0, m_Content.size(), m_Content.data()));
+    }
+    return KString(m_Content.data(), m_Content.size());
+  }
+
   void InputStreamTextReader::setPos(size_t iOffset)
   {
     if (m_Stream == nullptr || iOffset >= m_Stream->GetSize())
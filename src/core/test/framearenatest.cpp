@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+
+#include <core/framearena.hpp>
+#include <core/thread/jobsystem.hpp>
+
+#include <cstring>
+
+using namespace eXl;
+
+TEST(eXl_FrameArena, Containers)
+{
+  FrameArena arena(4096);
+  for (uint32_t frame = 0; frame < 4; ++frame)
+  {
+    {
+      FrameVector<uint32_t> values(arena);
+      FrameMap<uint32_t, uint32_t> sortedMap(arena);
+      FrameUnorderedMap<uint32_t, uint32_t> hashMap(arena);
+      for (uint32_t i = 0; i < 1000; ++i)
+      {
+        values.push_back(i);
+        sortedMap[i] = i;
+        hashMap[i] = i;
+      }
+      for (uint32_t i = 0; i < 1000; ++i)
+      {
+        ASSERT_EQ(values[i], i);
+        ASSERT_EQ(sortedMap[i], i);
+        ASSERT_EQ(hashMap[i], i);
+      }
+      EXPECT_GT(arena.GetAllocatedBytes(), 1000 * sizeof(uint32_t));
+    }
+    size_t const capacity = arena.GetCapacity();
+    arena.Reset();
+    EXPECT_EQ(arena.GetAllocatedBytes(), 0);
+    // The blocks of the first frame are merged, and reused afterwards.
+    EXPECT_EQ(arena.GetCapacity(), capacity);
+  }
+}
+
+TEST(eXl_FrameArena, Alignment)
+{
+  FrameArena arena(256);
+  for (size_t alignment : {1, 4, 16, 64, 128})
+  {
+    for (uint32_t i = 0; i < 16; ++i)
+    {
+      void* ptr = arena.Alloc(i * 7 + 1, alignment);
+      EXPECT_EQ(uintptr_t(ptr) % alignment, 0);
+    }
+  }
+}
+
+TEST(eXl_FrameArena, ParallelAlloc)
+{
+  JobSystem jobs(4);
+  FrameArena arena(4096);
+
+  uint32_t const numAllocs = 10000;
+  Vector<uint8_t*> ptrs(numAllocs);
+  jobs.ParallelFor(0, numAllocs, 64, [&](uint32_t iBegin, uint32_t iEnd, uint32_t)
+  {
+    for (uint32_t i = iBegin; i < iEnd; ++i)
+    {
+      ptrs[i] = (uint8_t*)arena.Alloc(24);
+      memset(ptrs[i], uint8_t(i), 24);
+    }
+  });
+
+  for (uint32_t i = 0; i < numAllocs; ++i)
+  {
+    for (uint32_t j = 0; j < 24; ++j)
+    {
+      ASSERT_EQ(ptrs[i][j], uint8_t(i)) << "Alloc " << i;
+    }
+  }
+}
@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+
+#include <core/image/image.hpp>
+#include <core/thread/jobsystem.hpp>
+
+#include <cmath>
+
+#include "imagetest.hpp"
+
+using namespace eXl;
+
+TEST(Image, ConvolveMatchesReference)
+{
+  JobSystem jobs(4);
+  Vec2i const filterSize(5, 5);
+  Vec2i const offset(-2, -1);
+  for (Image::Format format : {Image::Char, Image::Float})
+  {
+    for (bool separable : {false, true})
+    {
+      Vector<float> filterData = MakeFilter(separable);
+      Image filter(filterData.data(), Image::Size(5, 5), Image::R, Image::Float, 1, Image::Reference);
+      Image source = RandomImage(Image::Size(67, 45), Image::RGBA, format);
+      Image expected = ReferenceConvolve(source, filterData, filterSize, offset);
+
+      for (JobSystem* jobSys : {(JobSystem*)nullptr, &jobs})
+      {
+        Image image(source);
+        image.Convolve(filter, offset, jobSys);
+        for (uint32_t i = 0; i < image.GetSize().y; ++i)
+        {
+          for (uint32_t j = 0; j < image.GetSize().x; ++j)
+          {
+            for (uint32_t k = 0; k < 4; ++k)
+            {
+              // Char results may round differently when the sum lands on a half.
+              ASSERT_NEAR(GetValue(image, i, j, k), GetValue(expected, i, j, k), format == Image::Char ? 1.0 : 1.0e-3)
+                << "Separable " << separable << ", pixel " << i << ", " << j;
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST(Image, ConvertRoundTrip)
+{
+  Image source = RandomImage(Image::Size(37, 19), Image::BGRA, Image::Char);
+  Image asFloat = source.Convert(Image::RGB, Image::Float);
+  ASSERT_EQ(asFloat.GetComponents(), Image::RGB);
+  ASSERT_EQ(asFloat.GetFormat(), Image::Float);
+  Image back = asFloat.Convert(Image::BGRA, Image::Char);
+
+  for (uint32_t i = 0; i < source.GetSize().y; ++i)
+  {
+    for (uint32_t j = 0; j < source.GetSize().x; ++j)
+    {
+      EXPECT_NEAR(GetValue(asFloat, i, j, 0), GetValue(source, i, j, 2) / 255.0, 1.0e-6);
+      EXPECT_NEAR(GetValue(asFloat, i, j, 2), GetValue(source, i, j, 0) / 255.0, 1.0e-6);
+      for (uint32_t k = 0; k < 3; ++k)
+      {
+        EXPECT_EQ(GetValue(back, i, j, k), GetValue(source, i, j, k));
+      }
+      EXPECT_EQ(GetValue(back, i, j, 3), 255);
+    }
+  }
+}
+
+TEST(Image, ConvertShortAndInt)
+{
+  Image source = RandomImage(Image::Size(37, 19), Image::RGB, Image::Char);
+  Image asShort = source.Convert(Image::RGBA, Image::Short);
+  Image asInt = source.Convert(Image::RGBA, Image::Int);
+  Image fromShort = asShort.Convert(Image::RGB, Image::Char);
+  Image fromInt = asInt.Convert(Image::RGB, Image::Char);
+
+  for (uint32_t i = 0; i < source.GetSize().y; ++i)
+  {
+    for (uint32_t j = 0; j < source.GetSize().x; ++j)
+    {
+      for (uint32_t k = 0; k < 3; ++k)
+      {
+        double const value = GetValue(source, i, j, k);
+        EXPECT_EQ(GetValue(asShort, i, j, k), value * 257);
+        EXPECT_NEAR(GetValue(asInt, i, j, k), value / 255.0 * 4294967295.0, 4294967295.0 * 1.0e-6);
+        EXPECT_EQ(GetValue(fromShort, i, j, k), value);
+        EXPECT_EQ(GetValue(fromInt, i, j, k), value);
+      }
+      // The added alpha is full scale.
+      EXPECT_EQ(GetValue(asShort, i, j, 3), 65535);
+      EXPECT_EQ(GetValue(asInt, i, j, 3), 4294967295.0);
+    }
+  }
+
+  Image opaque(nullptr, Image::Size(4, 1), Image::R, Image::Float, 4);
+  reinterpret_cast<float*>(opaque.GetRow(0))[0] = 1.0f;
+  reinterpret_cast<float*>(opaque.GetRow(0))[1] = 2.0f;
+  reinterpret_cast<float*>(opaque.GetRow(0))[2] = 0.5f;
+  reinterpret_cast<float*>(opaque.GetRow(0))[3] = -1.0f;
+  Image opaqueInt = opaque.Convert(Image::R, Image::Int);
+  EXPECT_EQ(GetValue(opaqueInt, 0, 0, 0), 4294967295.0);
+  EXPECT_EQ(GetValue(opaqueInt, 0, 1, 0), 4294967295.0);
+  EXPECT_NEAR(GetValue(opaqueInt, 0, 2, 0), 2147483648.0, 1.0);
+  EXPECT_EQ(GetValue(opaqueInt, 0, 3, 0), 0);
+}
+
+TEST(Image, Premultiply)
+{
+  Image source = RandomImage(Image::Size(37, 19), Image::RGBA, Image::Char);
+  Image image(source);
+  image.Premultiply();
+  for (uint32_t i = 0; i < source.GetSize().y; ++i)
+  {
+    for (uint32_t j = 0; j < source.GetSize().x; ++j)
+    {
+      float const alpha = GetValue(source, i, j, 3);
+      for (uint32_t k = 0; k < 3; ++k)
+      {
+        EXPECT_EQ(GetValue(image, i, j, k), std::lrint(GetValue(source, i, j, k) * alpha / 255));
+      }
+      EXPECT_EQ(GetValue(image, i, j, 3), alpha);
+    }
+  }
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <core/image/image.hpp>
+#include <core/random.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace eXl
+{
+  inline uint32_t GetValueSize(Image::Format iFormat)
+  {
+    switch (iFormat)
+    {
+    case Image::Char:
+      return 1;
+    case Image::Short:
+      return 2;
+    default:
+      return 4;
+    }
+  }
+
+  inline Image RandomImage(Image::Size const& iSize, Image::Components iComp, Image::Format iFormat)
+  {
+    UniquePtr<Random> rand(Random::CreateDefaultRNG(0));
+    Image image(nullptr, iSize, iComp, iFormat, 4);
+    uint32_t const numValues = iSize.x * image.GetPixelSize() / GetValueSize(iFormat);
+    for (uint32_t i = 0; i < iSize.y; ++i)
+    {
+      void* row = image.GetRow(i);
+      for (uint32_t j = 0; j < numValues; ++j)
+      {
+        switch (iFormat)
+        {
+        case Image::Char:
+          reinterpret_cast<uint8_t*>(row)[j] = rand->Generate() % 256;
+          break;
+        case Image::Short:
+          reinterpret_cast<uint16_t*>(row)[j] = rand->Generate() % 65536;
+          break;
+        case Image::Int:
+          reinterpret_cast<uint32_t*>(row)[j] = rand->Generate();
+          break;
+        case Image::Float:
+          reinterpret_cast<float*>(row)[j] = (rand->Generate() % 1000) * 0.01f;
+          break;
+        }
+      }
+    }
+    return image;
+  }
+
+  inline double GetValue(Image const& iImage, uint32_t iRow, uint32_t iCol, uint32_t iComp)
+  {
+    uint32_t const numComp = iImage.GetPixelSize() / GetValueSize(iImage.GetFormat());
+    uint32_t const idx = iCol * numComp + iComp;
+    void const* row = iImage.GetRow(iRow);
+    switch (iImage.GetFormat())
+    {
+    case Image::Char:
+      return reinterpret_cast<uint8_t const*>(row)[idx];
+    case Image::Short:
+      return reinterpret_cast<uint16_t const*>(row)[idx];
+    case Image::Int:
+      return reinterpret_cast<uint32_t const*>(row)[idx];
+    default:
+      return reinterpret_cast<float const*>(row)[idx];
+    }
+  }
+
+  // Direct evaluation of the filter, one output pixel at a time, to check Image::Convolve against.
+  inline Image ReferenceConvolve(Image const& iImage, Vector<float> const& iFilter, Vec2i const& iFilterSize, Vec2i const& iOffset)
+  {
+    Image result(iImage);
+    uint32_t const numComp = iImage.GetPixelSize() / GetValueSize(iImage.GetFormat());
+    for (int32_t i = 0; i < int32_t(iImage.GetSize().y); ++i)
+    {
+      for (int32_t j = 0; j < int32_t(iImage.GetSize().x); ++j)
+      {
+        if (i + iOffset.y < 0 || j + iOffset.x < 0
+          || i + iOffset.y + iFilterSize.y > int32_t(iImage.GetSize().y)
+          || j + iOffset.x + iFilterSize.x > int32_t(iImage.GetSize().x))
+        {
+          continue;
+        }
+        for (uint32_t k = 0; k < numComp; ++k)
+        {
+          double value = 0;
+          for (int32_t l = 0; l < iFilterSize.y; ++l)
+          {
+            for (int32_t m = 0; m < iFilterSize.x; ++m)
+            {
+              value += iFilter[l * iFilterSize.x + m] * GetValue(iImage, i + iOffset.y + l, j + iOffset.x + m, k);
+            }
+          }
+          if (iImage.GetFormat() == Image::Float)
+          {
+            reinterpret_cast<float*>(result.GetRow(i))[j * numComp + k] = value;
+          }
+          else
+          {
+            reinterpret_cast<uint8_t*>(result.GetRow(i))[j * numComp + k] = uint8_t(std::lrint(std::min(std::max(value, 0.0), 255.0)));
+          }
+        }
+      }
+    }
+    return result;
+  }
+
+  inline Vector<float> MakeFilter(bool iSeparable)
+  {
+    float const binomial[] = {1, 4, 6, 4, 1};
+    Vector<float> filter(25);
+    for (uint32_t l = 0; l < 5; ++l)
+    {
+      for (uint32_t m = 0; m < 5; ++m)
+      {
+        filter[l * 5 + m] = iSeparable
+          ? binomial[l] * binomial[m] / 256
+          : ((l * 7 + m * 3) % 5) / 37.0f;
+      }
+    }
+    return filter;
+  }
+}
@@ -0,0 +1,59 @@
+#include <gtest/gtest.h>
+
+#include <core/thread/jobsystem.hpp>
+
+using namespace eXl;
+
+TEST(eXl_Jobs, ParallelFor)
+{
+  JobSystem jobs(4);
+
+  Vector<uint32_t> values(10000, 0);
+  jobs.ParallelFor(0, values.size(), 128, [&](uint32_t iBegin, uint32_t iEnd, uint32_t)
+  {
+    for (uint32_t i = iBegin; i < iEnd; ++i)
+    {
+      values[i] += i;
+    }
+  });
+
+  for (uint32_t i = 0; i < values.size(); ++i)
+  {
+    ASSERT_EQ(values[i], i);
+  }
+}
+
+TEST(eXl_Jobs, Dependencies)
+{
+  JobSystem jobs(4);
+
+  std::atomic<uint32_t> order = { 0 };
+  uint32_t firstRank = 0;
+  uint32_t secondRank = 0;
+
+  JobCounter first;
+  JobCounter second;
+  jobs.Submit([&] { firstRank = order.fetch_add(1); }, &first);
+  jobs.Submit([&] { secondRank = order.fetch_add(1); }, &second, &first);
+
+  jobs.Wait(second);
+  EXPECT_TRUE(first.IsDone());
+  EXPECT_EQ(firstRank, 0);
+  EXPECT_EQ(secondRank, 1);
+}
+
+TEST(eXl_Jobs, NestedWait)
+{
+  JobSystem jobs(2);
+
+  std::atomic<uint32_t> total = { 0 };
+  jobs.ParallelFor(0, 8, 1, [&](uint32_t, uint32_t, uint32_t)
+  {
+    jobs.ParallelFor(0, 64, 4, [&](uint32_t iBegin, uint32_t iEnd, uint32_t)
+    {
+      total += iEnd - iBegin;
+    });
+  });
+
+  EXPECT_EQ(total.load(), 8 * 64);
+}
@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+
+#include <core/coredef.hpp>
+#include <core/memorymanager.hpp>
+#include <core/random.hpp>
+
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+using namespace eXl;
+
+namespace
+{
+  struct LiveBlock
+  {
+    uint8_t* m_Ptr;
+    size_t m_Size;
+  };
+
+  uint8_t GetPattern(uint8_t* iPtr)
+  {
+    return uint8_t(uintptr_t(iPtr) >> 4);
+  }
+
+  bool CheckAndFree(LiveBlock const& iBlock)
+  {
+    bool valid = true;
+    for (size_t i = 0; i < iBlock.m_Size; ++i)
+    {
+      valid &= iBlock.m_Ptr[i] == GetPattern(iBlock.m_Ptr);
+    }
+    MemoryManager::Free(iBlock.m_Ptr, false);
+    return valid;
+  }
+}
+
+TEST(eXl_MemoryManager, SizeClasses)
+{
+  Vector<LiveBlock> blocks;
+  for (size_t size = 0; size < 40000; size += (size < 1024 ? 1 : 97))
+  {
+    uint8_t* ptr = (uint8_t*)MemoryManager::Allocate(size, 1);
+    ASSERT_NE(ptr, nullptr);
+    ASSERT_EQ(uintptr_t(ptr) % 16, 0) << "Size " << size;
+    memset(ptr, GetPattern(ptr), size);
+
+    size_t stride;
+    EXPECT_EQ(MemoryManager::GetNum(ptr, stride, __FILE__, __LINE__, FUN_STR), 1);
+    EXPECT_EQ(stride, size);
+    blocks.push_back({ptr, size});
+  }
+
+  for (auto const& block : blocks)
+  {
+    ASSERT_TRUE(CheckAndFree(block)) << "Size " << block.m_Size;
+  }
+}
+
+TEST(eXl_MemoryManager, CrossThreadFree)
+{
+  uint32_t const numThreads = 4;
+  uint32_t const numBlocks = 20000;
+
+  // Every thread frees what its neighbour allocated.
+  Vector<Vector<LiveBlock>> allocated(numThreads);
+  Vector<std::thread> threads;
+  for (uint32_t i = 0; i < numThreads; ++i)
+  {
+    threads.emplace_back([&allocated, i]
+    {
+      UniquePtr<Random> rand(Random::CreateDefaultRNG(i));
+      for (uint32_t j = 0; j < numBlocks; ++j)
+      {
+        size_t size = rand->Generate() % 2048;
+        uint8_t* ptr = (uint8_t*)MemoryManager::Allocate(size);
+        memset(ptr, GetPattern(ptr), size);
+        allocated[i].push_back({ptr, size});
+      }
+    });
+  }
+  for (auto& thread : threads)
+  {
+    thread.join();
+  }
+  threads.clear();
+
+  std::atomic<uint32_t> numCorrupted(0);
+  for (uint32_t i = 0; i < numThreads; ++i)
+  {
+    threads.emplace_back([&allocated, &numCorrupted, i, numThreads]
+    {
+      for (auto const& block : allocated[(i + 1) % numThreads])
+      {
+        if (!CheckAndFree(block))
+        {
+          ++numCorrupted;
+        }
+      }
+    });
+  }
+  for (auto& thread : threads)
+  {
+    thread.join();
+  }
+  EXPECT_EQ(numCorrupted.load(), 0);
+}
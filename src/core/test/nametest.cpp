@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+
+#include <core/name.hpp>
+#include <core/thread/jobsystem.hpp>
+
+#include <algorithm>
+
+using namespace eXl;
+
+// Defined in luabindtest.cpp
+bool InitCore();
+
+namespace
+{
+  StaticName const s_StaticTestName("StaticTestName");
+
+  String MakeString(char const* iPrefix, uint32_t iIdx)
+  {
+    return String(iPrefix) + StringUtil::FromInt(iIdx);
+  }
+}
+
+TEST(eXl_Name, Interning)
+{
+  InitCore();
+
+  Name name1("TestName");
+  Name name2(String("TestName"));
+  Name name3(NameLiteral("TestName"));
+  Name other("OtherName");
+
+  EXPECT_EQ(name1, name2);
+  EXPECT_EQ(name1, name3);
+  EXPECT_EQ(name1.c_str(), name3.c_str());
+  EXPECT_NE(name1, other);
+  EXPECT_EQ(name1.get(), KString("TestName"));
+
+  EXPECT_EQ(hash_value(name1), HashNameString("TestName", 8));
+  EXPECT_EQ(hash_value(Name()), 0);
+
+  static_assert(NameLiteral("TestName").m_Hash == HashNameString("TestName", 8), "Literals are hashed at compile time");
+
+  EXPECT_EQ(s_StaticTestName.Get(), Name("StaticTestName"));
+}
+
+TEST(eXl_Name, PreIntern)
+{
+  InitCore();
+
+  Vector<String> strings;
+  for (uint32_t i = 0; i < 5000; ++i)
+  {
+    strings.push_back(MakeString("PreInterned", i));
+  }
+  Vector<KString> stringsView(strings.begin(), strings.end());
+  Name::PreIntern(stringsView);
+
+  Vector<KString> interned = Name::GetInternedStrings();
+  for (uint32_t i = 0; i < strings.size(); i += 97)
+  {
+    Name name(strings[i]);
+    EXPECT_EQ(name.get(), KString(strings[i]));
+    EXPECT_NE(std::find(interned.begin(), interned.end(), KString(strings[i])), interned.end());
+  }
+}
+
+TEST(eXl_Name, ConcurrentInterning)
+{
+  InitCore();
+
+  JobSystem jobs(4);
+  uint32_t const numStrings = 20000;
+  Vector<String> strings;
+  for (uint32_t i = 0; i < numStrings; ++i)
+  {
+    strings.push_back(MakeString("Concurrent", i % (numStrings / 4)));
+  }
+
+  Vector<Name> names(numStrings);
+  jobs.ParallelFor(0, numStrings, 16, [&](uint32_t iBegin, uint32_t iEnd, uint32_t)
+  {
+    for (uint32_t i = iBegin; i < iEnd; ++i)
+    {
+      names[i] = strings[i].c_str();
+    }
+  });
+
+  for (uint32_t i = 0; i < numStrings; ++i)
+  {
+    ASSERT_EQ(names[i].get(), KString(strings[i]));
+    ASSERT_EQ(names[i], names[i % (numStrings / 4)]);
+  }
+}
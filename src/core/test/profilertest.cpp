@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+
+#include <core/profiler.hpp>
+#include <core/thread/jobsystem.hpp>
+
+#include <cstring>
+#include <functional>
+#include <map>
+#include <sstream>
+
+using namespace eXl;
+
+namespace
+{
+  Vector<Profiler::Event> RecordFrame(std::function<void()> const& iFn)
+  {
+    Profiler::Enable(true);
+    // Flush whatever was recorded before.
+    Profiler::NextFrame();
+    iFn();
+    Profiler::NextFrame();
+    Profiler::Enable(false);
+
+    return Profiler::GetFrames().back().m_Events;
+  }
+}
+
+TEST(eXl_Profiler, NestedZones)
+{
+  Vector<Profiler::Event> events = RecordFrame([]
+  {
+    eXl_PROFILE_ZONE("Outer");
+    {
+      eXl_PROFILE_ZONE("Inner");
+    }
+    {
+      eXl_PROFILE_ZONE("Inner2");
+    }
+  });
+
+  ASSERT_EQ(events.size(), 3);
+  std::map<std::string, Profiler::Event> byName;
+  for (auto const& event : events)
+  {
+    EXPECT_EQ(event.m_Kind, Profiler::Event::Zone);
+    EXPECT_LE(event.m_Start, event.m_End);
+    byName[event.m_Name] = event;
+  }
+  EXPECT_EQ(byName["Outer"].m_Depth, 0);
+  EXPECT_EQ(byName["Inner"].m_Depth, 1);
+  EXPECT_EQ(byName["Inner2"].m_Depth, 1);
+  EXPECT_LE(byName["Outer"].m_Start, byName["Inner"].m_Start);
+  EXPECT_LE(byName["Inner"].m_End, byName["Inner2"].m_Start);
+  EXPECT_LE(byName["Inner2"].m_End, byName["Outer"].m_End);
+}
+
+TEST(eXl_Profiler, DisabledRecordsNothing)
+{
+  Profiler::Enable(false);
+  Profiler::NextFrame();
+  {
+    eXl_PROFILE_ZONE("Ignored");
+    eXl_PROFILE_COUNTER("Ignored", 1);
+  }
+  Profiler::NextFrame();
+
+  EXPECT_TRUE(Profiler::GetFrames().back().m_Events.empty());
+}
+
+TEST(eXl_Profiler, Counters)
+{
+  Vector<Profiler::Event> events = RecordFrame([]
+  {
+    eXl_PROFILE_COUNTER("Objects", 42);
+  });
+
+  ASSERT_EQ(events.size(), 1);
+  EXPECT_EQ(events[0].m_Kind, Profiler::Event::Counter);
+  EXPECT_STREQ(events[0].m_Name, "Objects");
+  EXPECT_EQ(events[0].m_Value, 42);
+}
+
+TEST(eXl_Profiler, WorkerThreads)
+{
+  JobSystem jobs(4);
+  uint32_t const numChunks = 64;
+
+  Vector<Profiler::Event> events = RecordFrame([&]
+  {
+    eXl_PROFILE_ZONE("Main");
+    jobs.ParallelFor(0, numChunks, 1, [&](uint32_t, uint32_t, uint32_t)
+    {
+      eXl_PROFILE_ZONE("Chunk");
+    });
+  });
+
+  uint32_t numChunkZones = 0;
+  uint32_t mainThread = UINT32_MAX;
+  for (auto const& event : events)
+  {
+    if (strcmp(event.m_Name, "Main") == 0)
+    {
+      mainThread = event.m_Thread;
+    }
+    else
+    {
+      ++numChunkZones;
+    }
+  }
+  EXPECT_NE(mainThread, UINT32_MAX);
+  EXPECT_EQ(numChunkZones, numChunks);
+
+  std::ostringstream trace;
+  Profiler::WriteChromeTrace(Profiler::GetFrames(), trace);
+  std::string const traceStr = trace.str();
+  EXPECT_EQ(traceStr.front(), '{');
+  EXPECT_NE(traceStr.find("\"traceEvents\""), std::string::npos);
+  EXPECT_NE(traceStr.find("\"Main\""), std::string::npos);
+  EXPECT_NE(traceStr.find("\"Chunk\""), std::string::npos);
+}
@@ -0,0 +1,351 @@
+/*
+Copyright 2009-2021 Nicolas Colombe
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <core/thread/jobsystem.hpp>
+#include <core/thread/workerthread.hpp>
+#include <core/coredef.hpp>
+#include <core/profiler.hpp>
+
+#include <thread>
+#include <condition_variable>
+#include <deque>
+
+namespace eXl
+{
+  struct Job
+  {
+    JobFunction m_Function;
+    JobCounter* m_Counter;
+    JobSystem* m_System;
+  };
+
+  namespace
+  {
+    thread_local JobSystem_Impl const* s_CurrentSystem = nullptr;
+    thread_local uint32_t s_CurrentThreadIdx = 0;
+  }
+
+  class JobSystem_Impl
+  {
+  public:
+    JobSystem_Impl(uint32_t iNumWorkers)
+    {
+      // Queue 0 is shared by the threads outside of the pool.
+      for (uint32_t i = 0; i < iNumWorkers + 1; ++i)
+      {
+        m_Queues.emplace_back(eXl_NEW WorkQueue);
+      }
+      for (uint32_t i = 0; i < iNumWorkers; ++i)
+      {
+        m_Threads.emplace_back([this, i] { WorkerLoop(i + 1); });
+      }
+    }
+
+    ~JobSystem_Impl()
+    {
+      {
+        std::unique_lock<std::mutex> lock(m_SleepMutex);
+        m_Stop = true;
+      }
+      m_SleepCond.notify_all();
+      for (auto& thread : m_Threads)
+      {
+        thread.join();
+      }
+      for (auto& queue : m_Queues)
+      {
+        for (Job* job : queue->m_Jobs)
+        {
+          eXl_DELETE job;
+        }
+        eXl_DELETE queue;
+      }
+    }
+
+    uint32_t GetCurrentIndex() const
+    {
+      return s_CurrentSystem == this ? s_CurrentThreadIdx : 0;
+    }
+
+    void Push(Job* iJob)
+    {
+      WorkQueue& queue = *m_Queues[GetCurrentIndex()];
+      {
+        std::unique_lock<std::mutex> lock(queue.m_Mutex);
+        queue.m_Jobs.push_back(iJob);
+      }
+      m_QueuedJobs.fetch_add(1, std::memory_order_release);
+
+      // Taking the lock guarantees a worker cannot miss the notification between its check and its wait.
+      {
+        std::unique_lock<std::mutex> lock(m_SleepMutex);
+      }
+      m_SleepCond.notify_one();
+    }
+
+    Job* Pop(uint32_t iQueueIdx)
+    {
+      if (m_QueuedJobs.load(std::memory_order_acquire) == 0)
+      {
+        return nullptr;
+      }
+
+      {
+        WorkQueue& ownQueue = *m_Queues[iQueueIdx];
+        std::unique_lock<std::mutex> lock(ownQueue.m_Mutex);
+        if (!ownQueue.m_Jobs.empty())
+        {
+          Job* job = ownQueue.m_Jobs.back();
+          ownQueue.m_Jobs.pop_back();
+          m_QueuedJobs.fetch_sub(1, std::memory_order_relaxed);
+          return job;
+        }
+      }
+
+      uint32_t const numQueues = m_Queues.size();
+      for (uint32_t i = 1; i < numQueues; ++i)
+      {
+        WorkQueue& victim = *m_Queues[(iQueueIdx + i) % numQueues];
+        std::unique_lock<std::mutex> lock(victim.m_Mutex, std::try_to_lock);
+        if (lock.owns_lock() && !victim.m_Jobs.empty())
+        {
+          Job* job = victim.m_Jobs.front();
+          victim.m_Jobs.pop_front();
+          m_QueuedJobs.fetch_sub(1, std::memory_order_relaxed);
+          return job;
+        }
+      }
+
+      return nullptr;
+    }
+
+    static void Execute(Job* iJob)
+    {
+      iJob->m_Function();
+      JobCounter* counter = iJob->m_Counter;
+      eXl_DELETE iJob;
+      if (counter != nullptr)
+      {
+        counter->Decrement();
+      }
+    }
+
+    void WorkerLoop(uint32_t iIdx)
+    {
+      s_CurrentSystem = this;
+      s_CurrentThreadIdx = iIdx;
+      Profiler::SetThreadName("Job worker " + StringUtil::FromInt(iIdx));
+
+      while (true)
+      {
+        if (Job* job = Pop(iIdx))
+        {
+          Execute(job);
+          continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_SleepMutex);
+        m_SleepCond.wait(lock, [this] { return m_Stop || m_QueuedJobs.load(std::memory_order_acquire) > 0; });
+        if (m_Stop)
+        {
+          return;
+        }
+      }
+    }
+
+    struct WorkQueue
+    {
+      std::mutex m_Mutex;
+      std::deque<Job*> m_Jobs;
+    };
+
+    Vector<WorkQueue*> m_Queues;
+    Vector<std::thread> m_Threads;
+
+    std::atomic<uint32_t> m_QueuedJobs = {0};
+    std::mutex m_SleepMutex;
+    std::condition_variable m_SleepCond;
+    bool m_Stop = false;
+  };
+
+  JobCounter::~JobCounter()
+  {
+    eXl_ASSERT_MSG(m_WaitingJobs.empty(), "Destroying a counter with dependent jobs");
+  }
+
+  void JobCounter::Increment()
+  {
+    m_Pending.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  uint32_t JobCounter::LockWaitingList()
+  {
+    uint32_t value = m_Pending.load(std::memory_order_relaxed);
+    while (true)
+    {
+      if (value & s_LockBit)
+      {
+        std::this_thread::yield();
+        value = m_Pending.load(std::memory_order_relaxed);
+      }
+      else if (m_Pending.compare_exchange_weak(value, value | s_LockBit, std::memory_order_acquire, std::memory_order_relaxed))
+      {
+        return value;
+      }
+    }
+  }
+
+  void JobCounter::Decrement()
+  {
+    uint32_t value = m_Pending.load(std::memory_order_relaxed);
+    while (true)
+    {
+      if ((value & ~s_LockBit) > 1)
+      {
+        if (m_Pending.compare_exchange_weak(value, value - 1, std::memory_order_acq_rel, std::memory_order_relaxed))
+        {
+          return;
+        }
+      }
+      else if (value & s_LockBit)
+      {
+        std::this_thread::yield();
+        value = m_Pending.load(std::memory_order_relaxed);
+      }
+      else if (m_Pending.compare_exchange_weak(value, value | s_LockBit, std::memory_order_acquire, std::memory_order_relaxed))
+      {
+        break;
+      }
+    }
+
+    Vector<Job*> released;
+    released.swap(m_WaitingJobs);
+    // Unlock and decrement at once, the counter must not be touched afterwards.
+    m_Pending.fetch_sub(s_LockBit + 1, std::memory_order_acq_rel);
+
+    for (Job* job : released)
+    {
+      job->m_System->Schedule(job);
+    }
+  }
+
+  JobSystem::JobSystem(uint32_t iNumWorkers)
+  {
+    if (iNumWorkers == 0)
+    {
+      uint32_t hwThreads = WorkerThread::GetHardwareConcurrency();
+      iNumWorkers = hwThreads > 1 ? hwThreads - 1 : 0;
+    }
+    m_Impl = eXl_NEW JobSystem_Impl(iNumWorkers);
+  }
+
+  JobSystem::~JobSystem()
+  {
+    eXl_DELETE m_Impl;
+  }
+
+  JobSystem& JobSystem::GetDefault()
+  {
+    static JobSystem s_DefaultSystem;
+    return s_DefaultSystem;
+  }
+
+  uint32_t JobSystem::GetNumThreads() const
+  {
+    return m_Impl->m_Threads.size() + 1;
+  }
+
+  uint32_t JobSystem::GetCurrentThreadIndex() const
+  {
+    return m_Impl->GetCurrentIndex();
+  }
+
+  void JobSystem::Schedule(Job* iJob)
+  {
+    m_Impl->Push(iJob);
+  }
+
+  void JobSystem::Submit(JobFunction&& iFunction, JobCounter* iCounter, JobCounter* iDependency)
+  {
+    Job* newJob = eXl_NEW Job;
+    newJob->m_Function = std::move(iFunction);
+    newJob->m_Counter = iCounter;
+    newJob->m_System = this;
+
+    if (iCounter != nullptr)
+    {
+      iCounter->Increment();
+    }
+
+    if (iDependency != nullptr)
+    {
+      uint32_t pending = iDependency->LockWaitingList();
+      if (pending != 0)
+      {
+        iDependency->m_WaitingJobs.push_back(newJob);
+      }
+      iDependency->m_Pending.fetch_and(~JobCounter::s_LockBit, std::memory_order_release);
+      if (pending != 0)
+      {
+        return;
+      }
+    }
+
+    Schedule(newJob);
+  }
+
+  void JobSystem::Wait(JobCounter& iCounter)
+  {
+    uint32_t const queueIdx = m_Impl->GetCurrentIndex();
+    while (!iCounter.IsDone())
+    {
+      if (Job* job = m_Impl->Pop(queueIdx))
+      {
+        JobSystem_Impl::Execute(job);
+      }
+      else
+      {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  void JobSystem::ParallelFor(uint32_t iBegin, uint32_t iEnd, uint32_t iGrainSize, std::function<void(uint32_t, uint32_t, uint32_t)> const& iFunction)
+  {
+    iGrainSize = iGrainSize == 0 ? 1 : iGrainSize;
+    uint32_t const numChunks = GetNumChunks(iBegin, iEnd, iGrainSize);
+    if (numChunks == 0)
+    {
+      return;
+    }
+
+    if (numChunks == 1 || GetNumThreads() == 1)
+    {
+      for (uint32_t chunk = 0; chunk < numChunks; ++chunk)
+      {
+        uint32_t chunkBegin = iBegin + chunk * iGrainSize;
+        iFunction(chunkBegin, std::min(chunkBegin + iGrainSize, iEnd), chunk);
+      }
+      return;
+    }
+
+    JobCounter counter;
+    for (uint32_t chunk = 1; chunk < numChunks; ++chunk)
+    {
+      uint32_t chunkBegin = iBegin + chunk * iGrainSize;
+      uint32_t chunkEnd = std::min(chunkBegin + iGrainSize, iEnd);
+      Submit([&iFunction, chunkBegin, chunkEnd, chunk] { iFunction(chunkBegin, chunkEnd, chunk); }, &counter);
+    }
+
+    iFunction(iBegin, std::min(iBegin + iGrainSize, iEnd), 0);
+
+    Wait(counter);
+  }
+}
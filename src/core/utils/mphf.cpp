@@ -32,7 +32,9 @@ namespace eXl
     struct Node
     {
       uint32_t value;
-      Set<uint32_t> edges;
+      uint32_t degree = 0;
+      // Xor of the remaining edges, which is the last edge once the degree reaches 1.
+      uint32_t edgesXor = 0;
     };
   }
 
@@ -64,8 +66,8 @@ namespace eXl
       uint32_t arraySize = ((m_Mask + 1) / 32);
       arraySize = arraySize == 0 ? 1 : arraySize;
 
-      m_AssignmentTable.resize(3 * arraySize, UINT64_MAX);
-      m_RankTable.resize(m_AssignmentTable.size(), 0);
+      m_AssignmentTable.assign(3 * arraySize, UINT64_MAX);
+      m_RankTable.assign(m_AssignmentTable.size(), 0);
 
       Vector<Edge> edges;
       edges.resize(iNumKeys);
@@ -73,7 +75,6 @@ namespace eXl
       UnorderedMap<uint32_t, uint32_t> valueToNode;
       Vector<Node> nodes;
       nodes.reserve(iNumKeys * 3);
-      Vector<uint32_t> nodesByDegree;
 
       // Build the graph. Node == hash value. Edge == values assigned to a given key.
       for (uint32_t i = 0; i < iNumKeys; ++i)
@@ -94,91 +95,78 @@ namespace eXl
             newNode.value = curNodes[idx];
             nodes.push_back(newNode);
             iter = valueToNode.insert(std::make_pair(curNodes[idx], nodes.size() - 1)).first;
-            nodesByDegree.push_back(iter->second);
           }
           Node& curNode = nodes[iter->second];
-          curNode.edges.insert(i);
+          curNode.degree++;
+          curNode.edgesXor ^= i;
           edges[i].nodeIdx[idx] = iter->second;
         }
       }
 
-      auto compareNodeByDegree = [&nodes](uint32_t const& iNode1, uint32_t const& iNode2)
-      {
-        return nodes[iNode1].edges.size() > nodes[iNode2].edges.size();
-      };
-
-      std::sort(nodesByDegree.begin(), nodesByDegree.end(), compareNodeByDegree);
-
+      // Peel the hypergraph : a node of degree 1 identifies its only remaining edge,
+      // which is removed along with its contribution to the other two nodes.
       Vector<uint32_t> sortedEdges;
-      for (uint32_t i = 0; i < edges.size(); ++i)
+      Vector<uint8_t> peeledHash(iNumKeys);
+      sortedEdges.reserve(iNumKeys);
+      Vector<uint32_t> toPeel;
+      for (uint32_t i = 0; i < nodes.size(); ++i)
       {
-        if (nodesByDegree.empty())
+        if (nodes[i].degree == 1)
         {
-          break;
-        }
-        Node& curNode = nodes[nodesByDegree.back()];
-        if (curNode.edges.size() > 2)
-        {
-          // Cyclic graph.
-          break;
+          toPeel.push_back(i);
         }
+      }
 
-        if (curNode.edges.empty())
+      while (!toPeel.empty())
+      {
+        uint32_t const nodeIdx = toPeel.back();
+        toPeel.pop_back();
+        if (nodes[nodeIdx].degree != 1)
         {
-          break;
+          continue;
         }
 
-        uint32_t edge = *curNode.edges.begin();
+        uint32_t const edge = nodes[nodeIdx].edgesXor;
         sortedEdges.push_back(edge);
-        for (auto node : edges[edge].nodeIdx)
-        {
-          nodes[node].edges.erase(edge);
-        }
-        std::sort(nodesByDegree.begin(), nodesByDegree.end(), compareNodeByDegree);
-        while (!nodesByDegree.empty()
-          && nodes[nodesByDegree.back()].edges.empty())
+        for (uint32_t idx = 0; idx < 3; ++idx)
         {
-          nodesByDegree.pop_back();
+          uint32_t const otherIdx = edges[edge].nodeIdx[idx];
+          if (otherIdx == nodeIdx)
+          {
+            peeledHash[edge] = idx;
+          }
+          Node& otherNode = nodes[otherIdx];
+          otherNode.degree--;
+          otherNode.edgesXor ^= edge;
+          if (otherNode.degree == 1)
+          {
+            toPeel.push_back(otherIdx);
+          }
         }
       }
 
       if (sortedEdges.size() != edges.size())
       {
+        // Cyclic graph.
         continue;
       }
 
-      Vector<bool> visited(nodes.size(), false);
-
-      // "Hypergraph peeling" -> assigning a unique value to every key.
-      for (uint32_t i = 0; i < edges.size(); ++i)
+      // Assign in reverse peeling order : the peeled node of an edge does not belong to any edge
+      // assigned before it, and the other nodes of the edge will not be assigned afterwards.
+      while (!sortedEdges.empty())
       {
         uint32_t curEdgeIdx = sortedEdges.back();
         sortedEdges.pop_back();
         Edge& curEdge = edges[curEdgeIdx];
-        uint32_t nodeIdx;
-        uint32_t nodeHash = 0;
-        for (; nodeHash < 3; ++nodeHash)
-        {
-          nodeIdx = curEdge.nodeIdx[nodeHash];
-          if (!visited[nodeIdx])
-          {
-            break;
-          }
-        }
-
-        uint32_t nodeValue = nodes[nodeIdx].value;
-        uint32_t bucket = nodeValue / 32;
-        uint32_t bits = nodeValue % 32;
+        uint32_t const nodeHash = peeledHash[curEdgeIdx];
 
         int32_t assignment = nodeHash;
-        uint32_t testSum = 0;
-        for (auto otherNodeIdx : curEdge.nodeIdx)
+        for (uint32_t idx = 0; idx < 3; ++idx)
         {
-          if (visited[otherNodeIdx])
+          if (idx != nodeHash)
           {
-            uint32_t otherNodeValue = nodes[otherNodeIdx].value;
-            assignment -= GetLabel(otherNodeValue);
-            testSum += GetLabel(otherNodeValue);
+            // Unassigned values read as 3, which does not change the sum modulo 3.
+            assignment -= GetLabel(nodes[curEdge.nodeIdx[idx]].value);
           }
         }
 
@@ -188,16 +176,15 @@ namespace eXl
           assignment += 3;
         }
 
+        uint32_t nodeValue = nodes[curEdge.nodeIdx[nodeHash]].value;
+        uint32_t bucket = nodeValue / 32;
+        uint32_t bits = nodeValue % 32;
+
         uint64_t bitValue = assignment;
         bitValue <<= (2 * bits);
 
         m_AssignmentTable[bucket] &= ~(3ull << (2 * bits));
         m_AssignmentTable[bucket] |= bitValue;
-
-        for (auto allNodeIdx : curEdge.nodeIdx)
-        {
-          visited[allNodeIdx] = true;
-        }
       }
 
       uint32_t tot = 0;
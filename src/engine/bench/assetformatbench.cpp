@@ -0,0 +1,34 @@
+#include "benchmark.hpp"
+
+#include "assetformattest.hpp"
+
+using namespace eXl;
+
+EXL_BENCHMARK(AssetFormat, Load)
+{
+  uint32_t const numLoads = 20;
+  AssetScene scene(128);
+
+  for (Resource* rsc : {(Resource*)scene.m_Map, (Resource*)scene.m_Tileset, (Resource*)scene.m_Archetype})
+  {
+    std::string const jsonData = SaveResource(rsc, false);
+    std::string const binData = SaveResource(rsc, true);
+
+    float times[2];
+    for (bool binary : {false, true})
+    {
+      Bench::Timing timing;
+      for (uint32_t i = 0; i < numLoads; ++i)
+      {
+        timing.Begin();
+        Resource* loadedRsc = LoadResource(rsc, binary ? binData : jsonData, binary);
+        timing.End();
+        eXl_DELETE loadedRsc;
+      }
+      times[binary] = timing.GetMs();
+    }
+
+    Bench::Report("%s : JSON %zu bytes %f ms, binary %zu bytes %f ms\n", rsc->GetName().c_str(),
+      jsonData.size(), times[0], binData.size(), times[1]);
+  }
+}
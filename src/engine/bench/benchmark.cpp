@@ -0,0 +1,125 @@
+#include "benchmark.hpp"
+
+#include <core/corelib.hpp>
+#include <core/coretest.hpp>
+#include <core/containers.hpp>
+#include <ogl/oglutils.hpp>
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+#ifndef EXL_SHARED_LIBRARY
+
+#include <core/plugin.hpp>
+
+namespace eXl
+{
+  Plugin& MathPlugin_GetPlugin();
+  Plugin& OGLPlugin_GetPlugin();
+  Plugin& EnginePlugin_GetPlugin();
+
+  PluginLoadMap s_StaticPluginMap =
+  {
+    {"eXl_OGL", &OGLPlugin_GetPlugin},
+    {"eXl_Math", &MathPlugin_GetPlugin},
+    {"eXl_Engine", &EnginePlugin_GetPlugin}
+  };
+}
+#endif
+
+namespace eXl
+{
+  namespace Bench
+  {
+    namespace
+    {
+      struct Entry
+      {
+        String m_Name;
+        Function m_Function;
+      };
+
+      Vector<Entry>& GetEntries()
+      {
+        static Vector<Entry> s_Entries;
+        return s_Entries;
+      }
+
+      Entry const* s_Running = nullptr;
+    }
+
+    Registration::Registration(char const* iGroup, char const* iName, Function iFunction)
+    {
+      GetEntries().push_back(Entry{ String(iGroup) + "." + iName, iFunction });
+    }
+
+    void Report(char const* iFormat, ...)
+    {
+      if (s_Running)
+      {
+        printf("[%s] ", s_Running->m_Name.c_str());
+      }
+      va_list args;
+      va_start(args, iFormat);
+      vprintf(iFormat, args);
+      va_end(args);
+      fflush(stdout);
+    }
+  }
+}
+
+using namespace eXl;
+
+// engine_benchmarks [--list] [filter...]
+// Runs the benchmarks whose Group.Name contains one of the filters, or all of them without filters.
+int main(int argc, char** argv)
+{
+  bool listOnly = false;
+  Vector<char const*> filters;
+  for (int i = 1; i < argc; ++i)
+  {
+    if (strcmp(argv[i], "--list") == 0)
+    {
+      listOnly = true;
+    }
+    else
+    {
+      filters.push_back(argv[i]);
+    }
+  }
+
+  StartCoreLib(nullptr);
+  SetErrorHandling(DEBUG_STAGE);
+  // Render benchmarks record into OGLRecordingContext, there is no GL context to create resources with.
+  OGLUtils::SetHeadless(true);
+
+  for (Bench::Entry const& entry : Bench::GetEntries())
+  {
+    bool selected = filters.empty();
+    for (char const* filter : filters)
+    {
+      selected |= entry.m_Name.find(filter) != String::npos;
+    }
+    if (!selected)
+    {
+      continue;
+    }
+    if (listOnly)
+    {
+      printf("%s\n", entry.m_Name.c_str());
+      continue;
+    }
+
+    Bench::s_Running = &entry;
+    Clock timer;
+    timer.GetTime();
+    entry.m_Function();
+    printf("[%s] done in %f s\n", entry.m_Name.c_str(), timer.GetTime());
+    Bench::s_Running = nullptr;
+  }
+
+  StopCoreLib();
+
+  return 0;
+}
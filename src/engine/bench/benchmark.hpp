@@ -0,0 +1,57 @@
+#pragma once
+
+#include <core/clock.hpp>
+
+#include <cstdint>
+
+namespace eXl
+{
+  namespace Bench
+  {
+    using Function = void(*)();
+
+    // Adds a benchmark to the ones run by engine_benchmarks, see EXL_BENCHMARK.
+    struct Registration
+    {
+      Registration(char const* iGroup, char const* iName, Function iFunction);
+    };
+
+    // Accumulates the time spent between Begin and End over several runs.
+    class Timing
+    {
+    public:
+      void Begin() { m_Clock.GetTime(); }
+      void End() { m_Total += m_Clock.GetTime(); ++m_NumRuns; }
+
+      // Average run, in milliseconds.
+      float GetMs() const { return m_NumRuns == 0 ? 0.0f : m_Total * 1000 / m_NumRuns; }
+
+    private:
+      Clock m_Clock;
+      float m_Total = 0;
+      uint32_t m_NumRuns = 0;
+    };
+
+    // Average time of iNumRuns calls to iFunction, in milliseconds.
+    template <typename Functor>
+    float Measure(uint32_t iNumRuns, Functor&& iFunction)
+    {
+      Timing timing;
+      for (uint32_t i = 0; i < iNumRuns; ++i)
+      {
+        timing.Begin();
+        iFunction();
+        timing.End();
+      }
+      return timing.GetMs();
+    }
+
+    // printf, prefixed with the name of the running benchmark.
+    void Report(char const* iFormat, ...);
+  }
+}
+
+#define EXL_BENCHMARK(Group, Name) \
+  static void Group##_##Name##_Benchmark(); \
+  static eXl::Bench::Registration s_##Group##_##Name##_Registration(#Group, #Name, &Group##_##Name##_Benchmark); \
+  static void Group##_##Name##_Benchmark()
@@ -0,0 +1,65 @@
+#include "benchmark.hpp"
+
+#include "navigatortest.hpp"
+
+using namespace eXl;
+
+EXL_BENCHMARK(Navigator, MassOrder)
+{
+  uint32_t const numRuns = 10;
+  int32_t const side = 16;
+  NavMesh navMesh = MakeRoomsNavMesh(side, CrowdScene::s_RoomSize, CrowdScene::s_CorridorSize);
+  for (uint32_t numQueries : {50, 200, 1000})
+  {
+    Vector<NavMesh::PathQuery> queries = MakeRallyQueries(side, numQueries);
+
+    float const uncachedTime = Bench::Measure(numRuns, [&]
+    {
+      navMesh.SetPathCacheSize(0);
+      for (auto const& query : queries)
+      {
+        navMesh.FindPath(query.m_Start, query.m_End);
+      }
+    });
+    float const cachedTime = Bench::Measure(numRuns, [&]
+    {
+      navMesh.SetPathCacheSize(256);
+      for (auto const& query : queries)
+      {
+        navMesh.FindPath(query.m_Start, query.m_End);
+      }
+      navMesh.ClearPathCache();
+    });
+    float const batchedTime = Bench::Measure(numRuns, [&]
+    {
+      Vector<Optional<NavMesh::Path>> paths;
+      navMesh.FindPaths(queries, paths);
+    });
+
+    Bench::Report("Rally %u agents : uncached %f ms, cached %f ms, batched %f ms\n", numQueries,
+      uncachedTime, cachedTime, batchedTime);
+  }
+}
+
+EXL_BENCHMARK(Navigator, Crowd)
+{
+  uint32_t const numSteps = 10;
+  for (uint32_t numAgents : {1000, 5000, 20000})
+  {
+    CrowdScene serialScene(numAgents, nullptr);
+    CrowdScene parallelScene(numAgents, &JobSystem::GetDefault());
+
+    float serialTime = 0;
+    float parallelTime = 0;
+    for (uint32_t step = 0; step < numSteps; ++step)
+    {
+      serialTime += serialScene.Step(1.0 / 60);
+      parallelTime += parallelScene.Step(1.0 / 60);
+    }
+
+    Bench::Report("%u agents : serial %f ms, %u threads %f ms\n", numAgents,
+      serialTime * 1000 / numSteps,
+      JobSystem::GetDefault().GetNumThreads(),
+      parallelTime * 1000 / numSteps);
+  }
+}
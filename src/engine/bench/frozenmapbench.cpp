@@ -0,0 +1,41 @@
+#include "benchmark.hpp"
+
+#include <core/utils/frozenmap.hpp>
+
+#include "frozenmaptest.hpp"
+
+using namespace eXl;
+
+EXL_BENCHMARK(FrozenMap, Lookup)
+{
+  uint32_t const numQueries = 10000000;
+  for (uint32_t numKeys : {16, 256, 4096})
+  {
+    Vector<FrozenTestName> keys = MakeFrozenTestKeys(numKeys);
+    UnorderedMap<FrozenTestName, uint32_t> map;
+    for (uint32_t i = 0; i < numKeys; ++i)
+    {
+      map.insert(std::make_pair(keys[i], i));
+    }
+    FrozenMap<FrozenTestName, uint32_t> frozenMap;
+    frozenMap.Freeze(map);
+
+    uint32_t sum = 0;
+    float const mapTime = Bench::Measure(1, [&]
+    {
+      for (uint32_t i = 0; i < numQueries; ++i)
+      {
+        sum += map.find(keys[(i * 7919) % numKeys])->second;
+      }
+    });
+    float const frozenTime = Bench::Measure(1, [&]
+    {
+      for (uint32_t i = 0; i < numQueries; ++i)
+      {
+        sum += *frozenMap.Find(keys[(i * 7919) % numKeys]);
+      }
+    });
+
+    Bench::Report("%u keys : UnorderedMap %f ms, FrozenMap %f ms (%u)\n", numKeys, mapTime, frozenTime, sum);
+  }
+}
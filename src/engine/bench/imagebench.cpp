@@ -0,0 +1,59 @@
+#include "benchmark.hpp"
+
+#include <core/image/image.hpp>
+#include <core/thread/jobsystem.hpp>
+
+#include "imagetest.hpp"
+
+using namespace eXl;
+
+EXL_BENCHMARK(Image, Convolve)
+{
+  uint32_t const numRuns = 10;
+  JobSystem jobs;
+  Image::Size const size(1024, 1024);
+  Image source = RandomImage(size, Image::RGBA, Image::Char);
+
+  for (bool separable : {false, true})
+  {
+    Vector<float> filterData = MakeFilter(separable);
+    Image filter(filterData.data(), Image::Size(5, 5), Image::R, Image::Float, 1, Image::Reference);
+
+    float const referenceTime = Bench::Measure(numRuns, [&] { ReferenceConvolve(source, filterData, Vec2i(5, 5), Vec2i(-2, -2)); });
+    Bench::Timing timings[2];
+    for (uint32_t run = 0; run < numRuns; ++run)
+    {
+      for (uint32_t i = 0; i < 2; ++i)
+      {
+        Image image(source);
+        timings[i].Begin();
+        image.Convolve(filter, Vec2i(-2, -2), i == 0 ? nullptr : &jobs);
+        timings[i].End();
+      }
+    }
+    Bench::Report("5x5 %s RGBA8 %ux%u : reference %f ms, serial %f ms, parallel %f ms\n", separable ? "separable" : "full",
+      size.x, size.y, referenceTime, timings[0].GetMs(), timings[1].GetMs());
+  }
+}
+
+EXL_BENCHMARK(Image, Convert)
+{
+  uint32_t const numRuns = 10;
+  Image::Size const size(1024, 1024);
+  Image source = RandomImage(size, Image::RGBA, Image::Char);
+  Image asFloat = source.Convert(Image::RGBA, Image::Float);
+
+  float const toFloat = Bench::Measure(numRuns, [&] { source.Convert(Image::RGBA, Image::Float); });
+  float const fromFloat = Bench::Measure(numRuns, [&] { asFloat.Convert(Image::RGBA, Image::Char); });
+  float const toBGRA = Bench::Measure(numRuns, [&] { source.Convert(Image::BGRA, Image::Char); });
+  Bench::Timing premultiply;
+  for (uint32_t run = 0; run < numRuns; ++run)
+  {
+    Image image(source);
+    premultiply.Begin();
+    image.Premultiply();
+    premultiply.End();
+  }
+  Bench::Report("RGBA8 %ux%u : to float %f ms, from float %f ms, to BGRA %f ms, premultiply %f ms\n",
+    size.x, size.y, toFloat, fromFloat, toBGRA, premultiply.GetMs());
+}
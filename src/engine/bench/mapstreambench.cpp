@@ -0,0 +1,39 @@
+#include "benchmark.hpp"
+
+#include <core/thread/jobsystem.hpp>
+
+#include "mapstreamtest.hpp"
+
+using namespace eXl;
+
+EXL_BENCHMARK(MapStreaming, TerrainTiling)
+{
+  uint32_t const numRuns = 10;
+  JobSystem jobs;
+  for (uint32_t mapSide : {64, 256, 512})
+  {
+    ChunkedMapScene scene(mapSide);
+    scene.AddTerrain();
+    MapResource& map = *scene.m_Map;
+
+    float times[3];
+    for (uint32_t i = 0; i < 2; ++i)
+    {
+      times[i] = Bench::Measure(numRuns, [&]
+      {
+        Vector<MapTiler::Batcher> layers;
+        map.ComputeTerrainGfx(layers, i == 0 ? nullptr : &jobs);
+      });
+    }
+
+    map.BakeTerrainGfx(&jobs);
+    times[2] = Bench::Measure(numRuns, [&]
+    {
+      Vector<MapTiler::Batcher> layers;
+      map.ComputeTerrainGfx(layers, nullptr);
+    });
+
+    Bench::Report("%ux%u : serial %f ms, parallel %f ms, baked %f ms\n", mapSide, mapSide,
+      times[0], times[1], times[2]);
+  }
+}
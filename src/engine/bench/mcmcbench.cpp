@@ -0,0 +1,25 @@
+#include "benchmark.hpp"
+
+#include "mcmctest.hpp"
+
+using namespace eXl;
+
+EXL_BENCHMARK(MCMC, Tempering)
+{
+  uint32_t const numIter = 200000;
+  JobSystem jobs;
+  MCMCScene scene;
+
+  float times[3];
+  size_t numPlaced[3];
+  uint32_t const numChains[3] = {1, 4, 4};
+  for (uint32_t i = 0; i < 3; ++i)
+  {
+    times[i] = Bench::Measure(1, [&] { numPlaced[i] = scene.Run(numIter, numChains[i], i == 2 ? &jobs : nullptr).size(); });
+  }
+
+  Bench::Report("%u steps : single chain %f ms (%u placed), 4 chains serial %f ms (%u placed), 4 chains parallel %f ms (%u placed)\n", numIter,
+    times[0], uint32_t(numPlaced[0]),
+    times[1], uint32_t(numPlaced[1]),
+    times[2], uint32_t(numPlaced[2]));
+}
@@ -0,0 +1,61 @@
+#include "benchmark.hpp"
+
+#include <core/memorymanager.hpp>
+#include <core/random.hpp>
+
+#include <cstdlib>
+#include <thread>
+
+using namespace eXl;
+
+EXL_BENCHMARK(MemoryManager, Alloc)
+{
+  constexpr uint32_t numAllocs = 1000000;
+  // Each thread keeps a window of live blocks, freeing the oldest one before each allocation.
+  constexpr uint32_t windowSize = 64;
+
+  for (uint32_t numThreads : {1, 2, 4, 8, 16})
+  {
+    float times[2];
+    for (bool useMalloc : {true, false})
+    {
+      times[useMalloc ? 0 : 1] = Bench::Measure(1, [numThreads, useMalloc]
+      {
+        Vector<std::thread> threads;
+        for (uint32_t i = 0; i < numThreads; ++i)
+        {
+          threads.emplace_back([useMalloc, i]
+          {
+            UniquePtr<Random> rand(Random::CreateDefaultRNG(i));
+            void* window[windowSize] = {};
+            for (uint32_t j = 0; j < numAllocs; ++j)
+            {
+              size_t size = 16 + rand->Generate() % 1024;
+              void*& slot = window[j % windowSize];
+              if (useMalloc)
+              {
+                free(slot);
+                slot = malloc(size);
+              }
+              else
+              {
+                MemoryManager::Free(slot, false);
+                slot = MemoryManager::Allocate(size);
+              }
+            }
+            for (void* ptr : window)
+            {
+              useMalloc ? free(ptr) : MemoryManager::Free(ptr, false);
+            }
+          });
+        }
+        for (auto& thread : threads)
+        {
+          thread.join();
+        }
+      });
+    }
+
+    Bench::Report("%u threads : malloc %f ms, MemoryManager %f ms\n", numThreads, times[0], times[1]);
+  }
+}
@@ -0,0 +1,32 @@
+#include "benchmark.hpp"
+
+#include <core/name.hpp>
+#include <core/thread/jobsystem.hpp>
+
+using namespace eXl;
+
+EXL_BENCHMARK(Name, Lookup)
+{
+  JobSystem jobs(4);
+  uint32_t const numStrings = 1000;
+  uint32_t const numLookups = 1000000;
+  Vector<String> strings;
+  for (uint32_t i = 0; i < numStrings; ++i)
+  {
+    strings.push_back(String("PropertySheet") + StringUtil::FromInt(i));
+    Name name(strings.back());
+  }
+
+  float const time = Bench::Measure(1, [&]
+  {
+    jobs.ParallelFor(0, numLookups, 1024, [&](uint32_t iBegin, uint32_t iEnd, uint32_t)
+    {
+      for (uint32_t i = iBegin; i < iEnd; ++i)
+      {
+        Name name(strings[i % numStrings].c_str());
+      }
+    });
+  });
+
+  Bench::Report("%u lookups in %f ms\n", numLookups, time);
+}
@@ -0,0 +1,24 @@
+#include "benchmark.hpp"
+
+#include "neighbourstest.hpp"
+
+using namespace eXl;
+
+EXL_BENCHMARK(Neighbours, DenseCrowd)
+{
+  uint32_t const numRuns = 10;
+  for (uint32_t numObjects : {1000, 5000, 20000})
+  {
+    // About one object every 4 square units.
+    float const side = Mathf::Sqrt(numObjects * 4.0f);
+    float times[2];
+    uint32_t i = 0;
+    for (NeighborhoodKind kind : {NeighborhoodKind::Dbvt, NeighborhoodKind::Grid})
+    {
+      NeighScene scene(numObjects, side, kind);
+      times[i++] = Bench::Measure(numRuns, [&] { scene.m_Physics->GetNeighborhoodExtraction().Run(Zero<Vec3>(), 10.0); });
+    }
+
+    Bench::Report("%u objects : dbvt %f ms, grid %f ms\n", numObjects, times[0], times[1]);
+  }
+}
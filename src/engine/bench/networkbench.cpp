@@ -0,0 +1,34 @@
+#include "benchmark.hpp"
+
+#include "networktest.hpp"
+
+EXL_BENCHMARK(Network, ReplicationBandwidth)
+{
+  uint32_t const numObjects = 150;
+  uint32_t const numSteps = 200;
+  // Object id, moving flag and two full precision Vec3.
+  float const fullStateBytes = (64 + 1 + 6 * 32) / 8.0;
+
+  for (float movingRatio : {0.1f, 0.5f, 1.0f})
+  {
+    ReplicationScene scene(numObjects);
+    Network::ReplicationStats const startStats = scene.net.ctx.m_Server->GetReplicationStats();
+
+    uint32_t step = 0;
+    float const stepTime = Bench::Measure(numSteps, [&]
+    {
+      scene.Move(step++, movingRatio);
+      scene.net.Step();
+    });
+
+    Network::ReplicationStats const& stats = scene.net.ctx.m_Server->GetReplicationStats();
+    uint64_t const numBytes = stats.m_NumBytes - startStats.m_NumBytes;
+    Bench::Report("%u objects, %u%% moving : %f bytes per object per tick (full state %f), %f bytes per entry, %f ms per step\n"
+      , numObjects
+      , uint32_t(movingRatio * 100)
+      , float(numBytes) / (numObjects * numSteps)
+      , fullStateBytes
+      , float(numBytes) / (stats.m_NumEntries - startStats.m_NumEntries)
+      , stepTime);
+  }
+}
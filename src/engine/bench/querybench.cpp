@@ -0,0 +1,40 @@
+#include "benchmark.hpp"
+
+#include "querytest.hpp"
+
+using namespace eXl;
+
+EXL_BENCHMARK(Query, Join)
+{
+  uint32_t const numRuns = 20;
+  for (uint32_t numObjects : {10000, 100000})
+  {
+    QueryScene scene(numObjects);
+    float const perObjectTime = Bench::Measure(numRuns, [&]
+    {
+      for (ObjectHandle obj : scene.m_Objects)
+      {
+        if (!scene.m_World.IsObjectValid(obj))
+        {
+          continue;
+        }
+        Position* pos = scene.m_Positions.Get(obj);
+        Velocity const* vel = scene.m_Velocities.Get(obj);
+        if (pos && vel)
+        {
+          pos->m_Y += vel->m_DX;
+        }
+      }
+    });
+    float const queryTime = Bench::Measure(numRuns, [&]
+    {
+      Query<Position, Velocity const> query(scene.m_Positions.GetView(), scene.m_Velocities.GetView());
+      query.Iterate([](ObjectHandle, Position& iPos, Velocity const& iVel)
+      {
+        iPos.m_Y += iVel.m_DX;
+      });
+    });
+
+    Bench::Report("%u objects : per object %f ms, query %f ms\n", numObjects, perObjectTime, queryTime);
+  }
+}
@@ -0,0 +1,88 @@
+#include "benchmark.hpp"
+
+#include <core/thread/jobsystem.hpp>
+
+#include "rendertest.hpp"
+
+using namespace eXl;
+
+namespace
+{
+  // Average RenderFrame time, once the nodes are initialized by a first frame.
+  float MeasureFrames(GfxSystem& iGfx, OGLRecordingContext& iCtx, uint32_t iNumFrames)
+  {
+    iGfx.RenderFrame(0.0, iCtx);
+    return Bench::Measure(iNumFrames, [&]
+    {
+      iCtx.Reset();
+      iGfx.RenderFrame(0.0, iCtx);
+    });
+  }
+}
+
+// Renders headless through OGLRecordingContext, which only counts and records the GL calls.
+EXL_BENCHMARK(GfxRender, RenderFrame)
+{
+  uint32_t const numFrames = 10;
+  for (uint32_t numSprites : {10000, 50000, 200000})
+  {
+    RenderScene scene(numSprites);
+    OGLRecordingContext counter(false);
+    float const frameTime = MeasureFrames(*scene.m_Gfx, counter, numFrames);
+
+    OGLRecordingContext::Stats const& stats = counter.GetStats();
+    Bench::Report("%u sprites : %f ms per frame, %u draws, %u state changes, %u programs, %u textures, %u uniforms, %u redundant binds\n",
+      numSprites, frameTime,
+      stats.m_Draws, stats.m_StateChanges, stats.m_Programs, stats.m_Textures, stats.m_Uniforms, stats.m_RedundantBinds);
+  }
+}
+
+EXL_BENCHMARK(GfxRender, ParallelPush)
+{
+  uint32_t const numFrames = 10;
+  for (uint32_t numSprites : {10000, 50000, 200000})
+  {
+    // Same sprites split over several nodes, recorded serially then in parallel.
+    RenderScene scene(numSprites, 8);
+    OGLRecordingContext counter(false);
+    float times[2];
+    for (uint32_t pass = 0; pass < 2; ++pass)
+    {
+      scene.m_World.SetJobSystem(pass == 0 ? nullptr : &JobSystem::GetDefault());
+      times[pass] = MeasureFrames(*scene.m_Gfx, counter, numFrames);
+    }
+    Bench::Report("%u sprites over 8 nodes : serial push %f ms per frame, parallel push %f ms per frame\n",
+      numSprites, times[0], times[1]);
+  }
+}
+
+EXL_BENCHMARK(GfxRender, StaticComponents)
+{
+  uint32_t const numFrames = 10;
+  for (uint32_t numQuads : {10000, 50000, 200000})
+  {
+    RenderScene scene(0);
+    scene.m_Gfx->SetViewCulling(false);
+    OGLRecordingContext counter(false);
+    // Initializes the render nodes.
+    scene.m_Gfx->RenderFrame(0.0, counter);
+    QuadComponents quads(scene);
+    Vector<ObjectHandle> objects;
+    for (uint32_t i = 0; i < numQuads; ++i)
+    {
+      objects.push_back(quads.Add(Vec2(float(i % 1000), float(i / 1000))));
+    }
+
+    float times[2];
+    for (uint32_t pass = 0; pass < 2; ++pass)
+    {
+      for (ObjectHandle object : objects)
+      {
+        scene.m_Gfx->GetComponent(object)->SetStatic(pass == 1);
+      }
+      times[pass] = MeasureFrames(*scene.m_Gfx, counter, numFrames);
+    }
+    Bench::Report("%u components : dynamic %f ms per frame, static %f ms per frame\n",
+      numQuads, times[0], times[1]);
+  }
+}
@@ -0,0 +1,55 @@
+#include "benchmark.hpp"
+
+#include "terraintest.hpp"
+
+using namespace eXl;
+
+EXL_BENCHMARK(Terrain, Diffusion)
+{
+  uint32_t const numSteps = 20;
+  uint32_t const numFields = 4;
+  float const heatCoeff = 0.5;
+
+  UniquePtr<Random> rand(Random::CreateDefaultRNG(0));
+  Terrain terrain;
+  terrain.MakeCirclePacking(*rand, Vec2(512.0, 512.0), 2.0);
+  size_t const numCells = terrain.GetCells().size();
+  UniquePtr<LaplaceMatrix> matrix(BuildMatrix(terrain));
+
+  Vector<Vector<float>> fields;
+  for (uint32_t i = 0; i < numFields; ++i)
+  {
+    fields.push_back(RandomField(*rand, numCells));
+  }
+
+  Vector<Vector<float>> values = fields;
+  float const perCallTime = Bench::Measure(1, [&]
+  {
+    for (uint32_t step = 0; step < numSteps; ++step)
+    {
+      for (auto& field : values)
+      {
+        terrain.Diffusion(matrix.get(), heatCoeff, field);
+      }
+    }
+  });
+
+  float solverTimes[2];
+  for (auto method : {DiffusionSolver::Direct, DiffusionSolver::ConjugateGradient})
+  {
+    values = fields;
+    solverTimes[method == DiffusionSolver::Direct ? 0 : 1] = Bench::Measure(1, [&]
+    {
+      DiffusionSolver* solverPtr = nullptr;
+      terrain.BuildDiffusionSolver(matrix.get(), heatCoeff, method, solverPtr);
+      UniquePtr<DiffusionSolver> solver(solverPtr);
+      for (uint32_t step = 0; step < numSteps; ++step)
+      {
+        solver->Solve(values);
+      }
+    });
+  }
+
+  Bench::Report("%u cells, %u steps of %u fields : per call %f ms, direct batched %f ms, conjugate gradient %f ms\n",
+    uint32_t(numCells), numSteps, numFields, perCallTime, solverTimes[0], solverTimes[1]);
+}
@@ -0,0 +1,31 @@
+#include "benchmark.hpp"
+
+#include "transformupdatetest.hpp"
+
+using namespace eXl;
+
+EXL_BENCHMARK(Transforms, Update)
+{
+  uint32_t const numFrames = 20;
+  for (uint32_t numObjects : {1000, 10000, 50000})
+  {
+    for (auto storage : {Transforms::MatrixStorage, Transforms::Compact2DStorage})
+    {
+      HierarchyScene scene(numObjects, storage);
+      Bench::Timing timing;
+      for (uint32_t frame = 0; frame < numFrames; ++frame)
+      {
+        scene.m_Transforms->NextFrame();
+        scene.Move(numObjects / 4);
+
+        timing.Begin();
+        scene.m_Transforms->IterateOverDirtyTransforms([](Mat4 const&, ObjectHandle) {});
+        timing.End();
+      }
+
+      Bench::Report("%u objects, %s : %f ms\n", numObjects,
+        storage == Transforms::MatrixStorage ? "matrix" : "compact 2D",
+        timing.GetMs());
+    }
+  }
+}
@@ -15,6 +15,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <core/plugin.hpp>
 #include <core/input.hpp>
 #include <core/clock.hpp>
+#include <core/profiler.hpp>
 #include <math/mathtools.hpp>
 
 #include <engine/gfx/gfxsystem.hpp>
@@ -38,7 +39,7 @@ namespace eXl
   IMPLEMENT_RTTI(Scenario);
   struct WorldState::Impl
   {
-    Impl(PropertiesManifest const& iManifest);
+    Impl(PropertiesManifest const& iManifest, JobSystem* iJobs);
 
     World world;
 
@@ -114,7 +115,11 @@ namespace eXl
       ("p,project", "Project path", cxxopts::value<std::string>())
       ("plugin", "Additional plugins to load", cxxopts::value<std::vector<std::string>>())
       ("m,map", "Map to load", cxxopts::value<std::string>())
-      ("b,bake", "Bake directory path", cxxopts::value<std::string>());
+      ("b,bake", "Bake directory path", cxxopts::value<std::string>())
+      ("bake-binary", "Bake assets in the binary format")
+      ("profile", "Write a Chrome trace of the first frames to this file", cxxopts::value<std::string>())
+      ("profile-frames", "Number of frames written by --profile, or run with --headless", cxxopts::value<uint32_t>())
+      ("headless", "Run without window nor renderer");
 
     cxxopts::ParseResult result = options.parse(m_Argc, m_ArgV);
 
@@ -178,6 +183,18 @@ namespace eXl
         m_BakeDir = bakeDir;
       }
     }
+    m_BakeBinary = result.count("bake-binary") > 0;
+
+    if (result.count("profile-frames"))
+    {
+      m_ProfileFrames = result["profile-frames"].as<uint32_t>();
+    }
+    if (result.count("profile"))
+    {
+      m_ProfileOutput = Path(result["profile"].as<std::string>().c_str());
+      Profiler::CaptureFrames(m_ProfileFrames, *m_ProfileOutput);
+    }
+    m_Headless = result.count("headless") > 0;
     
     Path mapInput = m_MapPath;
 
@@ -239,9 +256,9 @@ namespace eXl
     return m_WorldState->GetCamera();
   }
 
-  WorldState& WorldState::Init(PropertiesManifest const& iProperties)
+  WorldState& WorldState::Init(PropertiesManifest const& iProperties, JobSystem* iJobs)
   {
-    m_Impl = std::make_unique<Impl>(iProperties);
+    m_Impl = std::make_unique<Impl>(iProperties, iJobs);
     m_CamState.Init(m_Impl->world);
 
     return *this;
@@ -283,8 +300,8 @@ namespace eXl
     m_Impl->Render(iView);
   }
 
-  WorldState::Impl::Impl(PropertiesManifest const& iManifest)
-    : world(EngineCommon::GetComponents())
+  WorldState::Impl::Impl(PropertiesManifest const& iManifest, JobSystem* iJobs)
+    : world(EngineCommon::GetComponents(), iJobs)
     , m_Manifest(iManifest)
   {
     transforms = world.AddSystem(std::make_unique<Transforms>());
@@ -504,6 +521,7 @@ namespace eXl
     Engine_Application& app = Engine_Application::GetAppl();
     InputSystem& inputs = app.GetInputSystem();
 
+    Profiler::NextFrame();
     world.Tick(m_ProfilingState);
 
     inputs.Clear();
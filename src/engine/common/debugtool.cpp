@@ -85,9 +85,10 @@ namespace eXl
 
     Context BeginDebug(System iSys, ObjectHandle iHandle)
     {
-      s_State.m_OutStream = std::stringstream();
+      // Only the selected object touches the shared stream, so that systems can query this from their jobs.
       if(iHandle == s_State.m_SelectedObject)
       {
+        s_State.m_OutStream = std::stringstream();
         if(s_State.m_BreakIn[iSys])
         {
 #ifdef WIN32
@@ -9,8 +9,7 @@ namespace eXl
 
   void GameDataAllocatorBase::Clear()
   {
-    m_IndexRef.m_WorldObjects.clear();
-    m_IndexRef.m_ObjectToSlot.clear();
+    m_IndexRef.Clear();
   }
 
   DenseGameDataAllocator::DenseGameDataAllocator(ObjectDataIndex& iIndex, Type const* iType)
@@ -29,7 +28,7 @@ namespace eXl
       Release(GetDataFromSlot_Inl(iSlot));
       ObjectHandle object = m_IndexRef.m_WorldObjects[iSlot];
       m_IndexRef.m_WorldObjects[iSlot] = ObjectHandle();
-      m_IndexRef.m_ObjectToSlot.erase(object);
+      m_IndexRef.ClearSlot(object, iSlot);
     }
   }
 
@@ -70,6 +69,7 @@ namespace eXl
   void SparseGameDataAllocator::EraseSlot(uint32_t iSlot)
   {
     ObjectHandle object = m_IndexRef.m_WorldObjects[iSlot];
+    m_IndexRef.ClearSlot(object, iSlot);
 
     if (m_ObjectHandles.size() > 1
       && iSlot != m_ObjectHandles.size() - 1)
@@ -79,7 +79,7 @@ namespace eXl
       std::swap(m_ArchetypeHandle[iSlot], m_ArchetypeHandle.back());
       std::swap(m_IndexRef.m_WorldObjects[iSlot], m_IndexRef.m_WorldObjects.back());
 
-      m_IndexRef.m_ObjectToSlot[lastObject] = iSlot;
+      m_IndexRef.MoveSlot(lastObject, m_ObjectHandles.size() - 1, iSlot);
     }
 
     if (!m_ArchetypeHandle.back().IsAssigned()
@@ -92,7 +92,6 @@ namespace eXl
     m_ObjectHandles.pop_back();
     m_ArchetypeHandle.pop_back();
     m_IndexRef.m_WorldObjects.pop_back();
-    m_IndexRef.m_ObjectToSlot.erase(object);
   }
 
   void SparseGameDataAllocator::GarbageCollect(World& iWorld)
@@ -50,7 +50,7 @@ namespace eXl
     iWorld.AddTick(World::PrePhysics, [this](World& iWorld, float)
     {
       Tick();
-    });
+    }, TickAccess().Write<TransformAnimManager>().Write<Transforms>(), "TransformAnim");
   }
 
   TransformAnimManager::TimelineHandle TransformAnimManager::Start(ObjectHandle iObject, LinearPositionAnimation& iAnim, Mat4 const& iPreTrans, Mat4 const& iPostTrans)
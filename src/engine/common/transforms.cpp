@@ -10,11 +10,46 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 #include <engine/common/transforms.hpp>
 
+#include <algorithm>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define EXL_TRANSFORMS_SSE
+#endif
+
 namespace eXl
 {
   IMPLEMENT_RTTI(Transforms);
 
-  Transforms::Transforms()
+  namespace
+  {
+    // oRes = iParent * iLocal, oRes must not alias the inputs.
+    inline void MultiplyTransforms(Mat4 const& iParent, Mat4 const& iLocal, Mat4& oRes)
+    {
+#ifdef EXL_TRANSFORMS_SSE
+      float const* parent = &iParent[0][0];
+      float const* local = &iLocal[0][0];
+      float* res = &oRes[0][0];
+      __m128 const col0 = _mm_loadu_ps(parent);
+      __m128 const col1 = _mm_loadu_ps(parent + 4);
+      __m128 const col2 = _mm_loadu_ps(parent + 8);
+      __m128 const col3 = _mm_loadu_ps(parent + 12);
+      for (uint32_t i = 0; i < 4; ++i)
+      {
+        __m128 resCol = _mm_mul_ps(col0, _mm_set1_ps(local[i * 4 + 0]));
+        resCol = _mm_add_ps(resCol, _mm_mul_ps(col1, _mm_set1_ps(local[i * 4 + 1])));
+        resCol = _mm_add_ps(resCol, _mm_mul_ps(col2, _mm_set1_ps(local[i * 4 + 2])));
+        resCol = _mm_add_ps(resCol, _mm_mul_ps(col3, _mm_set1_ps(local[i * 4 + 3])));
+        _mm_storeu_ps(res + i * 4, resCol);
+      }
+#else
+      oRes = iParent * iLocal;
+#endif
+    }
+  }
+
+  Transforms::Transforms(Storage iStorage)
+    : m_Storage(iStorage)
   {
     m_IdToPosition.reserve(s_PageSize);
     m_Stack.reserve(256);
@@ -38,7 +73,7 @@ namespace eXl
 
     if(m_Pages.empty() || m_Pages.back().m_Used == s_PageSize)
     {
-      m_Pages.emplace_back(TransformPage());
+      m_Pages.emplace_back(TransformPage(m_Storage));
     }
 
     uint32_t extId = iObj.GetId();
@@ -59,6 +94,11 @@ namespace eXl
       page.m_WorldTransform[page.m_Used] = Identity<Mat4>();
       page.m_LocalTransform[page.m_Used] = Identity<Mat4>();
     }
+    if (m_Storage == Compact2DStorage)
+    {
+      page.m_LocalCompact[page.m_Used] = page.m_WorldCompact[page.m_Used] = Transform2D::FromMatrix(page.m_LocalTransform[page.m_Used]);
+      page.m_StaleMatrix[page.m_Used] = 0;
+    }
     new(page.m_Owner + page.m_Used) ObjectHandle(iObj);
     page.m_Timestamps[page.m_Used] = m_TimeStamp | s_NeedUpdateMask;
     page.m_GlobId[page.m_Used] = globPosition;
@@ -79,6 +119,12 @@ namespace eXl
     Timestamp() = iOther.Timestamp();
     GlobId() = iOther.GlobId();
     Hierarchy() = iOther.Hierarchy();
+    if (m_Page->m_LocalCompact)
+    {
+      LocalCompact() = iOther.LocalCompact();
+      WorldCompact() = iOther.WorldCompact();
+      StaleMatrix() = iOther.StaleMatrix();
+    }
   }
 
   void Transforms::Entry::Destroy()
@@ -142,6 +188,13 @@ namespace eXl
       if (curEntry < m_DirtyStart)
       {
         Swap(curEntry, m_DirtyStart - 1);
+        for (uint32_t& pending : m_Stack)
+        {
+          if (pending == m_DirtyStart - 1)
+          {
+            pending = curEntry;
+          }
+        }
         --m_DirtyStart;
         curEntry = m_DirtyStart;
         trans = GetEntry(curEntry);
@@ -169,6 +222,31 @@ namespace eXl
       uint32_t globPosition = m_IdToPosition[extId];
       Entry updatedEntry = GetEntry(globPosition);
       updatedEntry.LocalTransform() = iTransform;
+      if (m_Storage == Compact2DStorage)
+      {
+        updatedEntry.LocalCompact() = Transform2D::FromMatrix(iTransform);
+      }
+      Touch(updatedEntry);
+    }
+  }
+
+  void Transforms::UpdateTransform(ObjectHandle iObj, Transform2D const& iTransform)
+  {
+    if (!GetWorld().IsObjectValid(iObj))
+    {
+      return;
+    }
+
+    uint32_t extId = iObj.GetId();
+    if(extId < m_IdToPosition.size() && m_IdToPosition[extId] != s_InvalidPos)
+    {
+      uint32_t globPosition = m_IdToPosition[extId];
+      Entry updatedEntry = GetEntry(globPosition);
+      updatedEntry.LocalTransform() = iTransform.ToMatrix();
+      if (m_Storage == Compact2DStorage)
+      {
+        updatedEntry.LocalCompact() = iTransform;
+      }
       Touch(updatedEntry);
     }
   }
@@ -245,7 +323,8 @@ namespace eXl
       Entry child = GetEntry(posChild);
       if (child.Hierarchy().parent != s_InvalidPos)
       {
-        Detach_Impl(parent, child);
+        Entry prevParent = GetEntry(child.Hierarchy().parent);
+        Detach_Impl(prevParent, child);
       }
 
       HierarchyInfo& parentInfo = parent.Hierarchy();
@@ -318,12 +397,66 @@ namespace eXl
     return dummyMatrix;
   }
 
+  void Transforms::ComputeWorld(Entry& iEntry)
+  {
+    HierarchyInfo hierarchy = iEntry.Hierarchy();
+    uint32_t parentPos = hierarchy.parent;
+    AttachType attach = (AttachType)hierarchy.attach;
+
+    if (m_Storage == Compact2DStorage)
+    {
+      Transform2D& worldTransform = iEntry.WorldCompact();
+      if (parentPos != s_InvalidPos)
+      {
+        Entry parentEntry = GetEntry(parentPos);
+        Transform2D const& parentWorldTransform = parentEntry.WorldCompact();
+        if (attach == PositionRotation)
+        {
+          worldTransform = parentWorldTransform * iEntry.LocalCompact();
+        }
+        else
+        {
+          worldTransform = iEntry.LocalCompact();
+          worldTransform.m_Translation += parentWorldTransform.m_Translation;
+        }
+      }
+      else
+      {
+        worldTransform = iEntry.LocalCompact();
+      }
+      iEntry.StaleMatrix() = 1;
+    }
+    else
+    {
+      Mat4& worldTransform = iEntry.WorldTransform();
+      if (parentPos != s_InvalidPos)
+      {
+        Entry parentEntry = GetEntry(parentPos);
+        Mat4 const& parentWorldTransform = parentEntry.WorldTransform();
+        if (attach == PositionRotation)
+        {
+          MultiplyTransforms(parentWorldTransform, iEntry.LocalTransform(), worldTransform);
+        }
+        else
+        {
+          worldTransform = iEntry.LocalTransform();
+          worldTransform[3] += Vec4(Vec3(parentWorldTransform[3]), 0);
+        }
+      }
+      else
+      {
+        worldTransform = iEntry.LocalTransform();
+      }
+    }
+
+    iEntry.Timestamp() &= s_TimestampMask;
+  }
+
   void Transforms::UpdateTrans(Entry& iEntry)
   {
     if (iEntry.Hierarchy().parent == s_InvalidPos)
     {
-      iEntry.WorldTransform() = iEntry.LocalTransform();
-      iEntry.Timestamp() &= s_TimestampMask;
+      ComputeWorld(iEntry);
 
       return;
     }
@@ -356,42 +489,88 @@ namespace eXl
       m_Stack.pop_back();
 
       Entry entryToUpdate = GetEntry(toUpdate);
-      HierarchyInfo hierarchy = entryToUpdate.Hierarchy();
-      uint32_t parentPos = hierarchy.parent;
-      AttachType attach = /*PositionRotation;*/ (AttachType)hierarchy.attach;
-      Mat4& worldTransform = entryToUpdate.WorldTransform();
+      ComputeWorld(entryToUpdate);
+    }
+  }
 
-      if (parentPos != s_InvalidPos)
+  void Transforms::UpdateDirty()
+  {
+    if (m_DirtyStart >= m_TotAlloc)
+    {
+      return;
+    }
+
+    auto needUpdate = [this](uint32_t iPos)
+    {
+      return iPos >= m_DirtyStart && (GetEntry(iPos).Timestamp() & s_NeedUpdateMask) != 0;
+    };
+
+    // Depth of each out of date entry, counted from its first up to date ancestor.
+    m_DirtyDepth.assign(m_TotAlloc - m_DirtyStart, s_InvalidPos);
+    m_DepthOffset.clear();
+    uint32_t numToUpdate = 0;
+    for (uint32_t pos = m_DirtyStart; pos < m_TotAlloc; ++pos)
+    {
+      if (!needUpdate(pos) || m_DirtyDepth[pos - m_DirtyStart] != s_InvalidPos)
       {
-        Entry parentEntry = GetEntry(parentPos);
-        Mat4& parentWorldTransform = parentEntry.WorldTransform();
-        if (attach == PositionRotation)
+        continue;
+      }
+
+      uint32_t depth = 0;
+      uint32_t curPos = pos;
+      while (true)
+      {
+        m_Stack.push_back(curPos);
+        uint32_t parentPos = GetEntry(curPos).Hierarchy().parent;
+        if (parentPos == s_InvalidPos || !needUpdate(parentPos))
         {
-          worldTransform = parentWorldTransform * entryToUpdate.LocalTransform();
+          break;
         }
-        else
+        if (m_DirtyDepth[parentPos - m_DirtyStart] != s_InvalidPos)
         {
-          worldTransform = entryToUpdate.LocalTransform();
-          worldTransform[3] += Vec4(Vec3(parentWorldTransform[3]), 0);
+          depth = m_DirtyDepth[parentPos - m_DirtyStart] + 1;
+          break;
         }
+        curPos = parentPos;
       }
-      else
+
+      for (; !m_Stack.empty(); m_Stack.pop_back(), ++depth)
       {
-        entryToUpdate.WorldTransform() = entryToUpdate.LocalTransform();
+        m_DirtyDepth[m_Stack.back() - m_DirtyStart] = depth;
+        if (m_DepthOffset.size() <= depth + 1)
+        {
+          m_DepthOffset.resize(depth + 2, 0);
+        }
+        ++m_DepthOffset[depth + 1];
+        ++numToUpdate;
       }
+    }
 
-      entryToUpdate.Timestamp() &= s_TimestampMask;
+    if (numToUpdate == 0)
+    {
+      return;
     }
-  }
 
-  void Transforms::IterationUpdate(Entry& iEntry) const
-  {
-    uint32_t entryParent = iEntry.Hierarchy().parent;
-    if (entryParent != s_InvalidPos && entryParent > iEntry.GlobId())
+    // Counting sort by depth, so that parents are always computed before their children.
+    for (uint32_t depth = 1; depth < m_DepthOffset.size(); ++depth)
+    {
+      m_DepthOffset[depth] += m_DepthOffset[depth - 1];
+    }
+    m_UpdateOrder.resize(numToUpdate);
+    for (uint32_t pos = m_DirtyStart; pos < m_TotAlloc; ++pos)
+    {
+      uint32_t depth = m_DirtyDepth[pos - m_DirtyStart];
+      if (depth != s_InvalidPos)
+      {
+        m_UpdateOrder[m_DepthOffset[depth]++] = pos;
+      }
+    }
+
+    for (uint32_t pos : m_UpdateOrder)
     {
-      const_cast<Transforms*>(this)->Swap(entryParent, iEntry.GlobId());
+      Entry entry = GetEntry(pos);
+      ComputeWorld(entry);
     }
-    const_cast<Transforms*>(this)->UpdateTrans(iEntry);
   }
 
   Mat4 const& Transforms::GetWorldTransform(ObjectHandle iObj)
@@ -405,12 +584,12 @@ namespace eXl
         Entry curEntry = GetEntry(globPosition);
         if ((curEntry.Timestamp() & s_NeedUpdateMask) == 0)
         {
-          return curEntry.WorldTransform();
+          return ResolveWorld(curEntry);
         }
         else
         {
           UpdateTrans(curEntry);
-          return curEntry.WorldTransform();
+          return ResolveWorld(curEntry);
 
         }
         //return GetEntry(m_IdToPosition[extId]).LocalTransform();
@@ -426,6 +605,20 @@ namespace eXl
     return dummyMatrix;
   }
 
+  Transforms::Transform2D Transforms::GetWorldTransform2D(ObjectHandle iObj)
+  {
+    if (m_Storage == Compact2DStorage && HasTransform(iObj))
+    {
+      Entry curEntry = GetEntry(m_IdToPosition[iObj.GetId()]);
+      if (curEntry.Timestamp() & s_NeedUpdateMask)
+      {
+        UpdateTrans(curEntry);
+      }
+      return curEntry.WorldCompact();
+    }
+    return Transform2D::FromMatrix(GetWorldTransform(iObj));
+  }
+
   //void Transforms::Update()
   //{
   //  if (m_DirtyStart < m_TotAlloc)
@@ -474,7 +667,6 @@ namespace eXl
           ++curPos;
         }
         ++curPageIdx;
-        ++curTrans.m_Page;
         curTrans.m_LocalPos = 0;
       }
     }
@@ -486,32 +678,42 @@ namespace eXl
     m_ModifQueue.push_back(modif);
   }
 
-  void Transforms::ApplyModif()
+  void Transforms::ApplyModif(uint32_t iPos1, uint32_t iPos2)
   {
-    for (auto& modif : m_ModifQueue)
+    // Links are reachable from both entries when they are related, they must be exchanged only once.
+    std::sort(m_ModifQueue.begin(), m_ModifQueue.end(), [](PendingModif const& iA, PendingModif const& iB) { return iA.dest < iB.dest; });
+    auto lastModif = std::unique(m_ModifQueue.begin(), m_ModifQueue.end(), [](PendingModif const& iA, PendingModif const& iB) { return iA.dest == iB.dest; });
+    for (auto modif = m_ModifQueue.begin(); modif != lastModif; ++modif)
     {
-      modif.Apply();
+      uint32_t const link = *modif->dest & ~s_AttachMask;
+      if (link == iPos1 || link == iPos2)
+      {
+        modif->value = link == iPos1 ? iPos2 : iPos1;
+        modif->Apply();
+      }
     }
 
     m_ModifQueue.clear();
   }
 
-  void Transforms::Remap(HierarchyInfo const& iInfo, uint32_t iOld, uint32_t iNew)
+  void Transforms::Remap(HierarchyInfo& iInfo)
   {
+    PushModif(&iInfo.parentField, 0);
+    PushModif(&iInfo.first, 0);
+    PushModif(&iInfo.next, 0);
+    PushModif(&iInfo.prev, 0);
+
     if (iInfo.parent != s_InvalidPos)
     {
       Entry parent = GetEntry(iInfo.parent);
-      if (parent.Hierarchy().first == iOld)
-      {
-        PushModif(&parent.Hierarchy().first, iNew);
-      }
+      PushModif(&parent.Hierarchy().first, 0);
       if (iInfo.prev != s_InvalidPos)
       {
-        PushModif(&GetEntry(iInfo.prev).Hierarchy().next, iNew);
+        PushModif(&GetEntry(iInfo.prev).Hierarchy().next, 0);
       }
       if (iInfo.next != s_InvalidPos)
       {
-        PushModif(&GetEntry(iInfo.next).Hierarchy().prev, iNew);
+        PushModif(&GetEntry(iInfo.next).Hierarchy().prev, 0);
       }
     }
 
@@ -519,7 +721,7 @@ namespace eXl
     while(curChild != s_InvalidPos)
     {
       Entry child = GetEntry(curChild);
-      PushModif(&child.Hierarchy().parentField, iNew);
+      PushModif(&child.Hierarchy().parentField, 0);
       curChild = child.Hierarchy().next;
     }
   }
@@ -531,16 +733,25 @@ namespace eXl
       Entry origEntry = GetEntry(iOrigPos);
       Entry destEntry = GetEntry(iDestPos);
 
-      Remap(origEntry.Hierarchy(), iOrigPos, iDestPos);
-      Remap(destEntry.Hierarchy(), iDestPos, iOrigPos);
+      Remap(origEntry.Hierarchy());
+      Remap(destEntry.Hierarchy());
 
-      ApplyModif();
+      ApplyModif(iOrigPos, iDestPos);
 
       Mat4 saveDestLTransform = destEntry.LocalTransform();
       Mat4 saveDestWTransform = destEntry.WorldTransform();
       ObjectHandle saveDestOwner = destEntry.Owner();
       uint32_t saveDestTimestamp = destEntry.Timestamp();
       HierarchyInfo saveHierarchyInfo = destEntry.Hierarchy();
+      Transform2D saveDestLCompact;
+      Transform2D saveDestWCompact;
+      uint8_t saveDestStale = 0;
+      if (m_Storage == Compact2DStorage)
+      {
+        saveDestLCompact = destEntry.LocalCompact();
+        saveDestWCompact = destEntry.WorldCompact();
+        saveDestStale = destEntry.StaleMatrix();
+      }
 
       destEntry.Copy(origEntry);
 
@@ -549,6 +760,12 @@ namespace eXl
       origEntry.Owner() = saveDestOwner;
       origEntry.Timestamp() = saveDestTimestamp;
       origEntry.Hierarchy() = saveHierarchyInfo;
+      if (m_Storage == Compact2DStorage)
+      {
+        origEntry.LocalCompact() = saveDestLCompact;
+        origEntry.WorldCompact() = saveDestWCompact;
+        origEntry.StaleMatrix() = saveDestStale;
+      }
 
       origEntry.GlobId() = iOrigPos;
       destEntry.GlobId() = iDestPos;
@@ -558,11 +775,15 @@ namespace eXl
     }
   }
 
-  Transforms::TransformPage::TransformPage()
+  Transforms::TransformPage::TransformPage(Storage iStorage)
   {
-    static size_t s_pageBufferSize = (2 * sizeof(Mat4) + sizeof(ObjectHandle) + 2*sizeof(uint32_t) + sizeof(HierarchyInfo)) * s_PageSize;
+    size_t pageBufferSize = (2 * sizeof(Mat4) + sizeof(ObjectHandle) + 2*sizeof(uint32_t) + sizeof(HierarchyInfo)) * s_PageSize;
+    if (iStorage == Compact2DStorage)
+    {
+      pageBufferSize += (2 * sizeof(Transform2D) + sizeof(uint8_t)) * s_PageSize;
+    }
 
-    m_Buffer = eXl_ALLOC(s_pageBufferSize);
+    m_Buffer = eXl_ALLOC(pageBufferSize);
 
     m_LocalTransform = reinterpret_cast<Mat4*>(m_Buffer);
     m_WorldTransform = reinterpret_cast<Mat4*>(m_LocalTransform + s_PageSize);
@@ -570,5 +791,11 @@ namespace eXl
     m_Timestamps = reinterpret_cast<uint32_t*>(m_Owner + s_PageSize);
     m_GlobId = reinterpret_cast<uint32_t*>(m_Timestamps + s_PageSize);
     m_Hierarchy = reinterpret_cast<HierarchyInfo*>(m_GlobId + s_PageSize);
+    if (iStorage == Compact2DStorage)
+    {
+      m_LocalCompact = reinterpret_cast<Transform2D*>(m_Hierarchy + s_PageSize);
+      m_WorldCompact = m_LocalCompact + s_PageSize;
+      m_StaleMatrix = reinterpret_cast<uint8_t*>(m_WorldCompact + s_PageSize);
+    }
   }
 }
@@ -19,6 +19,8 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <engine/game/ability.hpp>
 
 #include <core/clock.hpp>
+#include <core/profiler.hpp>
+#include <core/thread/jobsystem.hpp>
 
 namespace eXl
 {
@@ -74,28 +76,47 @@ namespace eXl
     newEntry.requiredData = std::move(iReqData);
     newEntry.factory = iFactory;
     m_Components.insert(std::make_pair(iName, newEntry));
+    m_ComponentsFrozen = !!m_FrozenComponents.Freeze(m_Components);
+    if (!m_ComponentsFrozen)
+    {
+      m_FrozenComponents.Clear();
+    }
   }
 
-  UnorderedSet<PropertySheetName> const* ComponentManifest::GetRequiredDataForComponent(ComponentName iName) const
+  ComponentManifest::ComponentEntry const* ComponentManifest::FindEntry(ComponentName iName) const
   {
+    if (m_ComponentsFrozen)
+    {
+      return m_FrozenComponents.Find(iName);
+    }
     auto iter = m_Components.find(iName);
-    if (iter == m_Components.end())
+    if (iter != m_Components.end())
+    {
+      return &iter->second;
+    }
+    return nullptr;
+  }
+
+  UnorderedSet<PropertySheetName> const* ComponentManifest::GetRequiredDataForComponent(ComponentName iName) const
+  {
+    ComponentEntry const* entry = FindEntry(iName);
+    if (entry == nullptr)
     {
       return nullptr;
     }
 
-    return &iter->second.requiredData;
+    return &entry->requiredData;
   }
 
   ComponentFactory const* ComponentManifest::GetComponentFactory(ComponentName iName) const
   {
-    auto iter = m_Components.find(iName);
-    if (iter == m_Components.end())
+    ComponentEntry const* entry = FindEntry(iName);
+    if (entry == nullptr)
     {
       return nullptr;
     }
 
-    return &iter->second.factory;
+    return &entry->factory;
   }
 
   Vector<ComponentName> ComponentManifest::GetComponents() const
@@ -109,8 +130,31 @@ namespace eXl
     return names;
   }
 
-  World::World(ComponentManifest const& iComponents)
+  bool TickAccess::ConflictsWith(TickAccess const& iOther) const
+  {
+    auto overlaps = [](Vector<Rtti const*> const& iSet1, Vector<Rtti const*> const& iSet2)
+    {
+      for (Rtti const* sys1 : iSet1)
+      {
+        for (Rtti const* sys2 : iSet2)
+        {
+          if (sys1->IsKindOf(*sys2) || sys2->IsKindOf(*sys1))
+          {
+            return true;
+          }
+        }
+      }
+      return false;
+    };
+
+    return overlaps(m_Writes, iOther.m_Writes)
+      || overlaps(m_Writes, iOther.m_Reads)
+      || overlaps(m_Reads, iOther.m_Writes);
+  }
+
+  World::World(ComponentManifest const& iComponents, JobSystem* iJobs)
     : m_Components(iComponents)
+    , m_Jobs(iJobs)
   {
     m_Tick.resize(NumStages);
   }
@@ -122,6 +166,7 @@ namespace eXl
 
   ObjectHandle World::CreateObject()
   {
+    ++m_NumObjects;
     ObjectHandle handle = m_Objects.Alloc();
     ObjectInfo& info = m_Objects.Get(handle);
     info.m_PersistentId = ObjectCreationInfo::s_AnonymousFlag | handle.GetGeneration() | handle.GetId();
@@ -131,6 +176,7 @@ namespace eXl
 
   ObjectHandle World::CreateObject(ObjectCreationInfo iInfo)
   {
+    ++m_NumObjects;
     ObjectHandle handle = m_Objects.Alloc();
     ObjectInfo& info = m_Objects.Get(handle);
     info.m_DisplayName = std::move(iInfo.m_DisplayName);
@@ -236,6 +282,7 @@ namespace eXl
         m_PersistentIdToObjects.erase(info->m_PersistentId);
       }
       m_Objects.Release(toDelete);
+      --m_NumObjects;
     }
     m_ObjectsToDelete.clear();
   }
@@ -329,15 +376,20 @@ namespace eXl
     ioProfiling.m_LastFrameTime = ioProfiling.m_CurFrameTime;
     Clock profiler;
 
-    FlushObjectsToDelete();
-    if (m_Database)
-    {
-      m_Database->GarbageCollect();
-    }
+    eXl_PROFILE_ZONE("World::Tick");
 
-    if (m_Events)
     {
-      m_Events->GarbageCollect();
+      eXl_PROFILE_ZONE("GarbageCollect");
+      FlushObjectsToDelete();
+      if (m_Database)
+      {
+        m_Database->GarbageCollect();
+      }
+
+      if (m_Events)
+      {
+        m_Events->GarbageCollect();
+      }
     }
     
     if (m_AbilitySystem)
@@ -347,63 +399,63 @@ namespace eXl
 
     if (m_PhSystem)
     {
+      eXl_PROFILE_ZONE("PhysicsSystem::SyncTriggersTransforms");
       m_PhSystem->SyncTriggersTransforms();
     }
 
     if (m_Transforms)
     {
+      eXl_PROFILE_ZONE("Transforms::NextFrame");
       m_Transforms->NextFrame();
     }
 
-    for (auto const& tickFn : m_Tick[FrameStart])
+    RunStage(FrameStart, iDelta);
+
     {
-      tickFn(*this, iDelta);
+      eXl_PROFILE_ZONE("Timers");
+      ProcessTimers();
     }
 
-    ProcessTimers();
-
     ioProfiling.m_FrameStartTime = profiler.GetTime();
     
     if (m_PhSystem)
     {
+      eXl_PROFILE_ZONE("NeighborhoodExtraction::Run");
       m_PhSystem->GetNeighborhoodExtraction().Run(Vec3(0.0, 0.0, 0.0), 10.0);
     }
 
     ioProfiling.m_NeighETime = profiler.GetTime();
 
-    for (auto const& tickFn : m_Tick[PrePhysics])
-    {
-      tickFn(*this, iDelta);
-    }
+    RunStage(PrePhysics, iDelta);
 
     if (m_PhSystem)
     {
+      eXl_PROFILE_ZONE("PhysicsSystem::Step");
       m_PhSystem->Step(iDelta);
     }
 
     ioProfiling.m_PhysicTime = profiler.GetTime() * 1000.0;
 
-    for (auto const& tickFn : m_Tick[PostPhysics])
-    {
-      tickFn(*this, iDelta);
-    }
+    RunStage(PostPhysics, iDelta);
 
     ioProfiling.m_PostPhysicsTime = profiler.GetTime() * 1000.0;
 
     if (m_AbilitySystem)
     {
+      eXl_PROFILE_ZONE("AbilitySystem::Tick");
       m_AbilitySystem->Tick(iDelta);
     }
 
     ioProfiling.m_AbilitiesTime = profiler.GetTime() * 1000.0;
 
-    for (auto const& tickFn : m_Tick[PostAbilites])
-    {
-      tickFn(*this, iDelta);
-    }
+    RunStage(PostAbilites, iDelta);
 
     ioProfiling.m_PostAbilitiesTime = profiler.GetTime() * 1000.0;
 
+    eXl_PROFILE_COUNTER("Objects", m_NumObjects);
+    eXl_PROFILE_COUNTER("Frame arena bytes", m_FrameArena.GetAllocatedBytes());
+    m_FrameArena.Reset();
+
     ioProfiling.m_CurFrameTime = 1000 * double(Clock::GetTimestamp() - m_CurrentTimestamp) / Clock::GetTicksPerSecond();
   }
 
@@ -412,9 +464,93 @@ namespace eXl
     return double(m_ElapsedGameTime) / Clock::GetTicksPerSecond();
   }
 
-  void World::AddTick(Stage iStage, TickDelegate&& iDelegate)
+  namespace
+  {
+    char const* s_StageNames[] =
+    {
+      "FrameStart",
+      "PrePhysics",
+      "PostPhysics",
+      "PostAbilities",
+    };
+  }
+
+  void World::RunStage(Stage iStage, float iDelta)
   {
-    m_Tick[iStage].emplace_back(std::move(iDelegate));
+    StageTicks& stage = m_Tick[iStage];
+    if (stage.m_Entries.empty())
+    {
+      return;
+    }
+
+    eXl_PROFILE_ZONE(s_StageNames[iStage]);
+    for (auto const& wave : stage.m_Waves)
+    {
+      if (wave.size() == 1 || m_Jobs == nullptr)
+      {
+        for (uint32_t entryIdx : wave)
+        {
+          eXl_PROFILE_ZONE(stage.m_Entries[entryIdx].m_ProfileName);
+          stage.m_Entries[entryIdx].m_Delegate(*this, iDelta);
+        }
+      }
+      else
+      {
+        m_Jobs->ParallelFor(0, wave.size(), 1, [&](uint32_t iBegin, uint32_t iEnd, uint32_t)
+        {
+          for (uint32_t i = iBegin; i < iEnd; ++i)
+          {
+            eXl_PROFILE_ZONE(stage.m_Entries[wave[i]].m_ProfileName);
+            stage.m_Entries[wave[i]].m_Delegate(*this, iDelta);
+          }
+        });
+      }
+    }
+  }
+
+  char const* World::GetTickProfileName(Stage iStage, KString iName)
+  {
+    if (!iName.empty())
+    {
+      return Profiler::InternName(iName);
+    }
+    String defaultName = String(s_StageNames[iStage]) + " #" + StringUtil::FromInt(uint32_t(m_Tick[iStage].m_Entries.size()));
+    return Profiler::InternName(defaultName);
+  }
+
+  void World::AddTick(Stage iStage, TickDelegate&& iDelegate, KString iName)
+  {
+    StageTicks& stage = m_Tick[iStage];
+    uint32_t const newWave = stage.m_Waves.size();
+    stage.m_EntryWave.push_back(newWave);
+    stage.m_Waves.emplace_back();
+    stage.m_Waves.back().push_back(stage.m_Entries.size());
+    stage.m_Entries.push_back(TickEntry{ std::move(iDelegate), {}, GetTickProfileName(iStage, iName) });
+  }
+
+  void World::AddTick(Stage iStage, TickDelegate&& iDelegate, TickAccess iAccess, KString iName)
+  {
+    StageTicks& stage = m_Tick[iStage];
+
+    // Run after every previously registered delegate we conflict with, to keep the registration order semantic.
+    uint32_t newWave = 0;
+    for (uint32_t i = 0; i < stage.m_Entries.size(); ++i)
+    {
+      TickEntry const& entry = stage.m_Entries[i];
+      if (!entry.m_Access || entry.m_Access->ConflictsWith(iAccess))
+      {
+        newWave = std::max(newWave, stage.m_EntryWave[i] + 1);
+      }
+    }
+
+    if (newWave == stage.m_Waves.size())
+    {
+      stage.m_Waves.emplace_back();
+    }
+    stage.m_EntryWave.push_back(newWave);
+    stage.m_Waves[newWave].push_back(stage.m_Entries.size());
+    char const* profileName = GetTickProfileName(iStage, iName);
+    stage.m_Entries.push_back(TickEntry{ std::move(iDelegate), std::move(iAccess), profileName });
   }
 
   TimerHandle World::AddTimer(float iTimeInSec, bool iLoop, std::function<void(World&)>&& iDelegate)
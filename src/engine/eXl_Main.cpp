@@ -6,6 +6,8 @@
 #include <core/plugin.hpp>
 #include <core/random.hpp>
 #include <core/clock.hpp>
+#include <core/profiler.hpp>
+#include <core/thread/jobsystem.hpp>
 #include <core/coretest.hpp>
 #include <core/image/imagestreamer.hpp>
 #include <core/resource/resourcemanager.hpp>
@@ -30,6 +32,7 @@
 
 #include <core/stream/jsonstreamer.hpp>
 #include <core/stream/jsonunstreamer.hpp>
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 #include <locale>
@@ -224,9 +227,109 @@ private:
     ImGui::Text("Physic Time : %f ms", m_State.m_PhysicTime);
     ImGui::Text("Renderer Time : %f ms", m_State.m_RendererTime);
     ImGui::Text("Transform tick Time : %f ms", m_State.m_TransformsTickTime);
+
+    ImGui::Separator();
+
+    bool enabled = Profiler::IsEnabled();
+    if (ImGui::Checkbox("Record zones", &enabled))
+    {
+      Profiler::Enable(enabled);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Capture trace") && !Profiler::IsCapturing())
+    {
+      Profiler::CaptureFrames(m_CaptureFrames, "profile.json");
+    }
+    ImGui::SameLine();
+    ImGui::DragInt("Frames", &m_CaptureFrames, 1.0, 1, 10000);
+    if (uint32_t dropped = Profiler::GetNumDroppedEvents())
+    {
+      ImGui::Text("Dropped events : %u", dropped);
+    }
+
+    Vector<Profiler::Frame> const& frames = Profiler::GetFrames();
+    if (frames.empty())
+    {
+      return;
+    }
+
+    // Averaged over the kept frames, to find which system regressed.
+    struct ZoneStats
+    {
+      uint64_t m_Time = 0;
+      uint32_t m_Calls = 0;
+    };
+    Map<KString, ZoneStats> zones;
+    Map<KString, int64_t> counters;
+    for (auto const& frame : frames)
+    {
+      for (auto const& event : frame.m_Events)
+      {
+        if (event.m_Kind == Profiler::Event::Zone)
+        {
+          ZoneStats& stats = zones[event.m_Name];
+          stats.m_Time += event.m_End - event.m_Start;
+          ++stats.m_Calls;
+        }
+        else
+        {
+          counters[event.m_Name] = event.m_Value;
+        }
+      }
+    }
+
+    Vector<std::pair<KString, ZoneStats>> sortedZones(zones.begin(), zones.end());
+    std::sort(sortedZones.begin(), sortedZones.end(), [](auto const& iA, auto const& iB) { return iA.second.m_Time > iB.second.m_Time; });
+
+    double const toMs = 1000.0 / (double(Clock::GetTicksPerSecond()) * frames.size());
+    if (ImGui::CollapsingHeader("Zones", ImGuiTreeNodeFlags_DefaultOpen))
+    {
+      ImGui::Text("Average over %u frames", uint32_t(frames.size()));
+      for (auto const& zone : sortedZones)
+      {
+        ImGui::Text("%8.3f ms %6.1f calls  %.*s", zone.second.m_Time * toMs, float(zone.second.m_Calls) / frames.size(), int(zone.first.size()), zone.first.data());
+      }
+    }
+
+    if (ImGui::CollapsingHeader("Counters", ImGuiTreeNodeFlags_DefaultOpen))
+    {
+      for (auto const& counter : counters)
+      {
+        ImGui::Text("%.*s : %lld", int(counter.first.size()), counter.first.data(), (long long)counter.second);
+      }
+    }
+
+    if (ImGui::CollapsingHeader("Last frame"))
+    {
+      Vector<String> threadNames = Profiler::GetThreadNames();
+      Vector<Profiler::Event> lastZones;
+      for (auto const& event : frames.back().m_Events)
+      {
+        if (event.m_Kind == Profiler::Event::Zone)
+        {
+          lastZones.push_back(event);
+        }
+      }
+      std::sort(lastZones.begin(), lastZones.end(), [](Profiler::Event const& iA, Profiler::Event const& iB)
+      {
+        return iA.m_Thread != iB.m_Thread ? iA.m_Thread < iB.m_Thread : iA.m_Start < iB.m_Start;
+      });
+      double const frameToMs = 1000.0 / double(Clock::GetTicksPerSecond());
+      uint32_t curThread = UINT32_MAX;
+      for (auto const& zone : lastZones)
+      {
+        if (zone.m_Thread != curThread)
+        {
+          curThread = zone.m_Thread;
+          ImGui::TextUnformatted(curThread < threadNames.size() ? threadNames[curThread].c_str() : "Unknown thread");
+        }
+        ImGui::Text("%*s%s : %.3f ms", int(zone.m_Depth + 1) * 2, "", zone.m_Name, (zone.m_End - zone.m_Start) * frameToMs);
+      }
+    }
   }
 
   ProfilingState const& m_State;
+  int m_CaptureFrames = 300;
 };
 
 namespace eXl
@@ -270,7 +373,7 @@ namespace eXl
 
       GfxSystem::StaticInit();
 
-      m_World->Init(*m_Manifest).WithGfx();
+      m_World->Init(*m_Manifest, &JobSystem::GetDefault()).WithGfx();
       if (GetScenario())
       {
         m_World->WithScenario(GetScenario());
@@ -411,17 +514,27 @@ namespace eXl
             PhysicsSystem& phSys = *m_World->GetWorld().GetSystem<PhysicsSystem>();
             GfxSystem& gfxSys = *m_World->GetWorld().GetSystem<GfxSystem>();
 
-            Vec3 worldPos;
-            Vec3 viewDir;
-            gfxSys.ScreenToWorld(m_MousePos, worldPos, viewDir);
+            // Select what is drawn under the cursor, falling back to colliders for objects without render bounds.
+            Vector<ObjectHandle> picked;
+            gfxSys.PickObjects(m_MousePos, picked);
+            if (!picked.empty())
+            {
+              DebugTool::SelectObject(picked.front());
+            }
+            else
+            {
+              Vec3 worldPos;
+              Vec3 viewDir;
+              gfxSys.ScreenToWorld(m_MousePos, worldPos, viewDir);
 
-            List<CollisionData> colResult;
+              List<CollisionData> colResult;
 
-            phSys.RayQuery(colResult, worldPos, worldPos - viewDir * 10000);
+              phSys.RayQuery(colResult, worldPos, worldPos - viewDir * 10000);
 
-            if (!colResult.empty())
-            {
-              DebugTool::SelectObject(colResult.front().obj1);
+              if (!colResult.empty())
+              {
+                DebugTool::SelectObject(colResult.front().obj1);
+              }
             }
           }
 
@@ -688,7 +801,7 @@ int eXl_Main::Start(int argc, char const* const argv[])
 #if defined(WIN32) && !defined(USE_BAKED)
   if (Path const* bakeDir = app.GetBakeDirectory())
   {
-    ResourceManager::Bake(*bakeDir);
+    ResourceManager::Bake(*bakeDir, app.IsBakeBinary());
     return 0;
   }
 #endif
@@ -725,6 +838,20 @@ int eXl_Main::Start(int argc, char const* const argv[])
     }
   }
 
+  if (app.IsHeadless())
+  {
+    world.Init(appManifest);
+    if (app.GetScenario())
+    {
+      world.WithScenario(app.GetScenario());
+    }
+    for (uint32_t frame = 0; frame < app.GetProfileFrames() || Profiler::IsCapturing(); ++frame)
+    {
+      world.Tick();
+    }
+    return 0;
+  }
+
   app.Start_SDLApp();
 
   app.DefaultLoop();
@@ -172,21 +172,7 @@ namespace eXl
       {
       case Image::Char:
         imageFormat = QImage::Format_RGBA8888;
-        converted.emplace(Image(nullptr, iImage.GetSize(), Image::RGBA, Image::Char, 1));
-        for (uint32_t row = 0; row < iImage.GetSize().y; ++row)
-        {
-          char const* rowPtr = (char const*)iImage.GetRow(row);
-          char* destRowPtr = (char*)converted->GetRow(row);
-          for (uint32_t pixel = 0; pixel < iImage.GetSize().x; ++pixel)
-          {
-            destRowPtr[0] = rowPtr[2];
-            destRowPtr[1] = rowPtr[1];
-            destRowPtr[2] = rowPtr[0];
-            destRowPtr[3] = rowPtr[3];
-            rowPtr += iImage.GetPixelSize();
-            destRowPtr += iImage.GetPixelSize();
-          }
-        }
+        converted.emplace(iImage.Convert(Image::RGBA, Image::Char));
         break;
       case Image::Short:
         return Err::Failure;
@@ -13,6 +13,7 @@
 #include <core/resource/resourcemanager.hpp>
 #include <core/process.hpp>
 #include <core/corelib.hpp>
+#include <core/thread/jobsystem.hpp>
 
 #include "tilestool.hpp"
 #include "terraintool.hpp"
@@ -79,7 +80,7 @@ namespace eXl
       mapEditorManifest.RegisterPropertySheet<TerrainIslandItemData>(TerrainTool::ToolDataName(), false);
       mapEditorManifest.RegisterPropertySheet<MapResource::ObjectHeader>(ObjectsTool::ToolDataName(), false);
 
-      m_World.Init(mapEditorManifest).WithGfx();
+      m_World.Init(mapEditorManifest, &JobSystem::GetDefault()).WithGfx();
 
       World& world = m_World.GetWorld();
 
@@ -13,6 +13,7 @@
 #include "../eXl_Editor/resourcehandle_editor.h"
 
 #include <core/random.hpp>
+#include <core/thread/jobsystem.hpp>
 #include <core/resource/resourcemanager.hpp>
 #include <math/mathtools.hpp>
 
@@ -597,6 +598,7 @@ namespace eXl
     MCMC2D::RunParams params;
     params.m_NumIter = m_RunIter->value();
     params.m_Shape = runSpace;
+    params.m_NumChains = 4;
 
     bool const cleanRun = m_CleanRun->isChecked();
 
@@ -674,7 +676,7 @@ namespace eXl
       m_Rand.reset(Random::CreateDefaultRNG(0));
     }
 
-    MCMC2D::Run(*m_Rand, params, model->m_Model.get());
+    MCMC2D::Run(*m_Rand, params, model->m_Model.get(), nullptr, &JobSystem::GetDefault());
 
     for (auto const& placed : params.m_Placed)
     {
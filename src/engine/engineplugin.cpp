@@ -140,6 +140,12 @@ namespace eXl
     };
 
     Optional<NameRegistry> s_NameRegistry;
+
+    StaticName const s_CharacterComponentName("Character");
+    StaticName const s_ObjectShapeName("ObjectShape");
+    StaticName const s_PhysicBodyName("PhysicBody");
+    StaticName const s_TriggerDescName("TriggerDescriprion");
+    StaticName const s_CharacterDescName("CharacterDescription");
   }
 
   ImageName Tile::EmptyName() { return s_NameRegistry->m_EmptyImage; }
@@ -178,8 +184,7 @@ namespace eXl
   ComponentName EngineCommon::TriggerComponentName() { return s_NameRegistry->m_TriggerComponentName; }
   ComponentName EngineCommon::CharacterComponentName()
   {
-    static ComponentName s_Name("Character");
-    return s_Name;
+    return ComponentName(s_CharacterComponentName.Get());
   }
   PropertySheetName EngineCommon::VelocityName() { return s_NameRegistry->m_VelocityName; }
 
@@ -191,26 +196,22 @@ namespace eXl
 
   PropertySheetName EngineCommon::ObjectShapeData::PropertyName()
   {
-    static PropertySheetName s_Name("ObjectShape");
-    return s_Name;
+    return PropertySheetName(s_ObjectShapeName.Get());
   }
 
   PropertySheetName EngineCommon::PhysicBodyData::PropertyName()
   {
-    static PropertySheetName s_Name("PhysicBody");
-    return s_Name;
+    return PropertySheetName(s_PhysicBodyName.Get());
   }
 
   PropertySheetName EngineCommon::TriggerComponentDesc::PropertyName()
   {
-    static PropertySheetName s_Name("TriggerDescriprion");
-    return s_Name;
+    return PropertySheetName(s_TriggerDescName.Get());
   }
 
   PropertySheetName EngineCommon::CharacterDesc::PropertyName()
   {
-    static PropertySheetName s_Name("CharacterDescription");
-    return s_Name;
+    return PropertySheetName(s_CharacterDescName.Get());
   }
 
 
@@ -31,6 +31,9 @@ namespace eXl
 {
   IMPLEMENT_RTTI(Scenario_Base);
 
+  // Seconds per frame spent instantiating map chunks.
+  static constexpr float s_MapStreamingBudget = 0.002f;
+
 
   Scenario_Base::Scenario_Base() = default;
   Scenario_Base::~Scenario_Base() = default;
@@ -47,7 +50,19 @@ namespace eXl
 
     if (MapResource const* map = m_Map.GetOrLoad())
     {
-      m_InstatiatedMap = map->Instantiate(iWorld);
+      if (m_StreamingRadius > 0 && map->m_ChunkSize > 0)
+      {
+        m_MapStreamer = std::make_unique<MapStreamer>(iWorld, *map);
+        if (NavigatorSystem* navSys = iWorld.GetSystem<NavigatorSystem>())
+        {
+          m_InstatiatedMap.navMesh = map->BuildChunkedNavMesh();
+          navSys->SetNavMesh(*m_InstatiatedMap.navMesh);
+        }
+      }
+      else
+      {
+        m_InstatiatedMap = map->Instantiate(iWorld);
+      }
     }
 
     if (m_InstatiatedMap.navMesh)
@@ -66,6 +81,17 @@ namespace eXl
     });
 
     StartLocal(iWorld);
+
+    if (m_MapStreamer)
+    {
+      m_MapStreamer->AddFocusObject(m_MainChar, m_StreamingRadius);
+      // Everything in reach is loaded before the first frame.
+      m_MapStreamer->Update(Mathf::MaxReal());
+      iWorld.AddTick(World::FrameStart, [this](World& iWorld, float)
+      {
+        m_MapStreamer->Update(s_MapStreamingBudget);
+      });
+    }
   }
 
   ObjectHandle Scenario_Base::SpawnCharacter(World& iWorld, Vec3 const& iPos, EngineCommon::CharacterControlKind iControl, ObjectCreationInfo const& iInfo)
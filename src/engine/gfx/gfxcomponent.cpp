@@ -9,7 +9,9 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 */
 
 #include <engine/gfx/gfxcomponent.hpp>
+#include <engine/gfx/gfxspatialindex.hpp>
 #include "gfxspriterendernode.hpp"
+#include "gfxcomponentrendernode.hpp"
 #include <ogl/renderer/ogldisplaylist.hpp>
 #include <ogl/oglspritealgo.hpp>
 #include <core/type/tagtype.hpp>
@@ -62,11 +64,48 @@ namespace eXl
   {
     //m_PositionData.AddData(OGLBaseAlgo::GetWorldMatUniform(), &iTransform);
     m_Transform = iTransform;
+    UpdateBounds();
   }
 
   void GfxComponent::SetGeometry(GeometryInfo* iGeometry)
   {
     m_Geometry = iGeometry;
+    UpdateBounds();
+    OnChanged();
+  }
+
+  void GfxComponent::SetStatic(bool iStatic)
+  {
+    if (m_Static != iStatic)
+    {
+      m_Static = iStatic;
+      if (m_Node != nullptr)
+      {
+        m_Node->InvalidateStatic();
+      }
+    }
+  }
+
+  void GfxComponent::OnChanged()
+  {
+    if (m_Static && m_Node != nullptr)
+    {
+      m_Node->InvalidateStatic();
+    }
+  }
+
+  void GfxComponent::UpdateBounds()
+  {
+    if (m_Index == nullptr)
+    {
+      return;
+    }
+    if (m_Geometry == nullptr || !m_Geometry->m_Bounds)
+    {
+      m_Index->SetUnbounded(m_Object);
+      return;
+    }
+    m_Index->Update(m_Object, GfxSpatialIndex::TransformBox(m_Transform, *m_Geometry->m_Bounds));
   }
 
   void GfxComponent::Push(OGLDisplayList& iList)
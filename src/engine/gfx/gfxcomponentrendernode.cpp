@@ -10,6 +10,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 #include <engine/gfx/gfxsystem.hpp>
 #include "gfxcomponentrendernode.hpp"
+#include <engine/gfx/gfxspatialindex.hpp>
 
 #include <ogl/renderer/oglrendercontext.hpp>
 #include <ogl/renderer/ogldisplaylist.hpp>
@@ -19,6 +20,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <engine/common/transforms.hpp>
 #include <math/mathtools.hpp>
 #include <core/type/tagtype.hpp>
+#include <core/thread/jobsystem.hpp>
 
 
 namespace eXl
@@ -27,15 +29,100 @@ namespace eXl
   void GfxComponentRenderNode::Init(GfxSystem& iSys, GfxRenderNodeHandle iHandle)
   {
     GfxRenderNode::Init(iSys, iHandle);
+    m_StaticList = std::make_unique<OGLDisplayList>(iSys.GetSemanticManager());
+  }
+
+  void GfxComponentRenderNode::PushStatic(OGLDisplayList& iList)
+  {
+    // Also recorded again when the list changed underneath, e.g. the viewport.
+    if (m_StaticDirty || !iList.IsSubListCurrent(*m_StaticList))
+    {
+      iList.InitSubList(*m_StaticList);
+      m_ToRender.Iterate([&](Components::Handle, GfxComponent& comp)
+        {
+          if (comp.m_Static)
+          {
+            comp.Push(*m_StaticList);
+          }
+        });
+      m_StaticDirty = false;
+    }
+    iList.Merge(*m_StaticList);
+  }
+
+  void GfxComponentRenderNode::PushDynamic(OGLDisplayList& iList)
+  {
+    JobSystem* jobs = GetWorld().GetJobSystem();
+    uint32_t const numComps = m_ToPush.size();
+    uint32_t const numSubLists = JobSystem::GetNumChunks(0, numComps, s_ComponentsPerSubList);
+    if (jobs == nullptr || numSubLists < 2)
+    {
+      for (GfxComponent* comp : m_ToPush)
+      {
+        comp->Push(iList);
+      }
+      return;
+    }
+
+    // Components only record into the list, merging the sub-lists in order gives the serial result.
+    while (m_SubLists.size() < numSubLists)
+    {
+      m_SubLists.push_back(std::make_unique<OGLDisplayList>(m_Sys->GetSemanticManager()));
+    }
+    for (uint32_t i = 0; i < numSubLists; ++i)
+    {
+      iList.InitSubList(*m_SubLists[i]);
+    }
+    jobs->ParallelFor(0, numComps, s_ComponentsPerSubList, [&](uint32_t iBegin, uint32_t iEnd, uint32_t iChunk)
+      {
+        OGLDisplayList& subList = *m_SubLists[iChunk];
+        for (uint32_t i = iBegin; i < iEnd; ++i)
+        {
+          m_ToPush[i]->Push(subList);
+        }
+      });
+    for (uint32_t i = 0; i < numSubLists; ++i)
+    {
+      iList.Merge(*m_SubLists[i]);
+    }
   }
 
   void GfxComponentRenderNode::Push(OGLDisplayList& iList, float iDelta)
   {
     iList.SetDepth(true, true);
-    m_ToRender.Iterate([&](Components::Handle, GfxComponent& comp)
+    PushStatic(iList);
+
+    m_ToPush.clear();
+    GfxViewFrustum const* frustum = m_Sys->GetCullingFrustum();
+    if (frustum == nullptr)
+    {
+      m_ToRender.Iterate([&](Components::Handle, GfxComponent& comp)
+        {
+          if (!comp.m_Static)
+          {
+            m_ToPush.push_back(&comp);
+          }
+        });
+      PushDynamic(iList);
+      return;
+    }
+
+    GfxSpatialIndex const& index = m_Sys->GetComponentIndex();
+    m_Visible.clear();
+    index.Query(*frustum, m_Visible);
+    m_Visible.insert(m_Visible.end(), index.GetUnbounded().begin(), index.GetUnbounded().end());
+    for (ObjectHandle object : m_Visible)
+    {
+      if (object.GetId() < m_ObjectToComp.size())
       {
-        comp.Push(iList);
-      });
+        GfxComponent* comp = m_ToRender.TryGet(m_ObjectToComp[object.GetId()]);
+        if (comp != nullptr && comp->m_Object == object && !comp->m_Static)
+        {
+          m_ToPush.push_back(comp);
+        }
+      }
+    }
+    PushDynamic(iList);
   }
 
   GfxRenderNode::TransformUpdateCallback GfxComponentRenderNode::GetTransformUpdateCallback()
@@ -95,12 +182,21 @@ namespace eXl
     }
     m_ObjectToComp[iObject.GetId()] = compHandle;
 
+    newComp.m_Node = this;
+    newComp.m_Index = &m_Sys->GetComponentIndex();
+    newComp.UpdateBounds();
+
     GfxRenderNode::AddObject(iObject);
   }
 
   void GfxComponentRenderNode::RemoveObject(ObjectHandle iObject)
   {
     eXl_ASSERT(iObject.GetId() < m_ObjectToComp.size() && m_ToRender.IsValid(m_ObjectToComp[iObject.GetId()]));
+    if (m_ToRender.Get(m_ObjectToComp[iObject.GetId()]).m_Static)
+    {
+      m_StaticDirty = true;
+    }
     m_ToRender.Release(m_ObjectToComp[iObject.GetId()]);
+    m_Sys->GetComponentIndex().Remove(iObject);
   }
 }
\ No newline at end of file
@@ -26,13 +26,27 @@ namespace eXl
     void AddObject(ObjectHandle);
     GfxComponent* GetComponent(ObjectHandle);
 
+    // Static components will be recorded again on the next push.
+    void InvalidateStatic() { m_StaticDirty = true; }
+
   protected:
 
     void RemoveObject(ObjectHandle);
+    void PushStatic(OGLDisplayList& iList);
+    void PushDynamic(OGLDisplayList& iList);
+
+    // With a job system, dynamic components are recorded in sub-lists of this many components.
+    static constexpr uint32_t s_ComponentsPerSubList = 256;
 
     typedef ObjectTable<GfxComponent> Components;
 
     Components m_ToRender;
     Vector<Components::Handle> m_ObjectToComp;
+    Vector<ObjectHandle> m_Visible;
+    Vector<GfxComponent*> m_ToPush;
+    Vector<UniquePtr<OGLDisplayList>> m_SubLists;
+    // Segment holding the static components, merged into every frame.
+    UniquePtr<OGLDisplayList> m_StaticList;
+    bool m_StaticDirty = true;
   };
 }
\ No newline at end of file
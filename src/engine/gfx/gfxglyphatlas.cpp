@@ -0,0 +1,285 @@
+/*
+Copyright 2009-2021 Nicolas Colombe
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <engine/gfx/gfxglyphatlas.hpp>
+
+#include <ogl/renderer/ogltexture.hpp>
+#include <ogl/renderer/oglshaderdata.hpp>
+#include <ogl/oglspritealgo.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace eXl
+{
+  struct GfxGlyphAtlas::Page
+  {
+    struct SkylineNode
+    {
+      uint32_t m_X;
+      uint32_t m_Y;
+      uint32_t m_Width;
+    };
+
+    IntrusivePtr<OGLTexture> m_Texture;
+    OGLShaderData m_TextureData;
+    Vector<uint8_t> m_Pixels;
+    Vector<SkylineNode> m_Skyline;
+    Vector<Key> m_Glyphs;
+    uint64_t m_LastUse = 0;
+    // Rows to upload.
+    uint32_t m_DirtyMinY = UINT32_MAX;
+    uint32_t m_DirtyMaxY = 0;
+  };
+
+  GfxGlyphAtlas::GfxGlyphAtlas(Vec2u const& iPageSize, uint32_t iMaxPages)
+    : m_PageSize(iPageSize)
+    , m_MaxPages(iMaxPages)
+  {
+    eXl_ASSERT(iPageSize.x > 2 && iPageSize.y > 2 && iMaxPages > 0);
+  }
+
+  GfxGlyphAtlas::~GfxGlyphAtlas() = default;
+
+  void GfxGlyphAtlas::NextFrame()
+  {
+    ++m_Frame;
+  }
+
+  void GfxGlyphAtlas::TouchPage(uint32_t iPage)
+  {
+    eXl_ASSERT(iPage < m_Pages.size());
+    m_Pages[iPage]->m_LastUse = m_Frame;
+  }
+
+  GfxGlyphAtlas::Location const* GfxGlyphAtlas::Find(Key const& iKey)
+  {
+    auto iter = m_Glyphs.find(iKey);
+    if (iter == m_Glyphs.end())
+    {
+      return nullptr;
+    }
+    TouchPage(iter->second.m_Page);
+    return &iter->second;
+  }
+
+  OGLTexture* GfxGlyphAtlas::GetTexture(uint32_t iPage) const
+  {
+    return m_Pages[iPage]->m_Texture.get();
+  }
+
+  OGLShaderData const* GfxGlyphAtlas::GetTextureData(uint32_t iPage) const
+  {
+    return &m_Pages[iPage]->m_TextureData;
+  }
+
+  Vector<uint8_t> const& GfxGlyphAtlas::GetPixels(uint32_t iPage) const
+  {
+    return m_Pages[iPage]->m_Pixels;
+  }
+
+  void GfxGlyphAtlas::ResetPage(Page& iPage)
+  {
+    for (Key const& key : iPage.m_Glyphs)
+    {
+      m_Glyphs.erase(key);
+    }
+    iPage.m_Glyphs.clear();
+    iPage.m_Skyline.clear();
+    iPage.m_Skyline.push_back({0, 0, m_PageSize.x});
+  }
+
+  bool GfxGlyphAtlas::Pack(Page& iPage, Vec2u const& iSize, Vec2u& oPos)
+  {
+    using SkylineNode = Page::SkylineNode;
+    Vector<SkylineNode>& skyline = iPage.m_Skyline;
+
+    // Bottom-left : lowest top edge first, then the narrowest segment.
+    uint32_t bestIdx = UINT32_MAX;
+    uint32_t bestTop = UINT32_MAX;
+    uint32_t bestWidth = UINT32_MAX;
+    for (uint32_t i = 0; i < skyline.size(); ++i)
+    {
+      if (skyline[i].m_X + iSize.x > m_PageSize.x)
+      {
+        break;
+      }
+      // The rectangle rests on the highest segment it spans.
+      uint32_t y = 0;
+      uint32_t widthLeft = iSize.x;
+      for (uint32_t j = i; widthLeft > 0; ++j)
+      {
+        y = std::max(y, skyline[j].m_Y);
+        widthLeft -= std::min(widthLeft, skyline[j].m_Width);
+      }
+      if (y + iSize.y > m_PageSize.y)
+      {
+        continue;
+      }
+      if (y + iSize.y < bestTop || (y + iSize.y == bestTop && skyline[i].m_Width < bestWidth))
+      {
+        bestIdx = i;
+        bestTop = y + iSize.y;
+        bestWidth = skyline[i].m_Width;
+      }
+    }
+    if (bestIdx == UINT32_MAX)
+    {
+      return false;
+    }
+
+    oPos = Vec2u(skyline[bestIdx].m_X, bestTop - iSize.y);
+    skyline.insert(skyline.begin() + bestIdx, SkylineNode({oPos.x, bestTop, iSize.x}));
+
+    // Trim the segments now under the rectangle.
+    uint32_t const rectEnd = oPos.x + iSize.x;
+    uint32_t next = bestIdx + 1;
+    while (next < skyline.size() && skyline[next].m_X < rectEnd)
+    {
+      uint32_t const segEnd = skyline[next].m_X + skyline[next].m_Width;
+      if (segEnd <= rectEnd)
+      {
+        skyline.erase(skyline.begin() + next);
+      }
+      else
+      {
+        skyline[next].m_Width = segEnd - rectEnd;
+        skyline[next].m_X = rectEnd;
+        break;
+      }
+    }
+
+    // Merge segments at the same height.
+    for (uint32_t i = bestIdx > 0 ? bestIdx - 1 : 0; i + 1 < skyline.size() && i <= bestIdx + 1; )
+    {
+      if (skyline[i].m_Y == skyline[i + 1].m_Y)
+      {
+        skyline[i].m_Width += skyline[i + 1].m_Width;
+        skyline.erase(skyline.begin() + i + 1);
+      }
+      else
+      {
+        ++i;
+      }
+    }
+
+    return true;
+  }
+
+  uint32_t GfxGlyphAtlas::FindPageFor(Vec2u const& iSize, Vec2u& oPos)
+  {
+    for (uint32_t i = 0; i < m_Pages.size(); ++i)
+    {
+      if (Pack(*m_Pages[i], iSize, oPos))
+      {
+        return i;
+      }
+    }
+
+    if (m_Pages.size() >= m_MaxPages)
+    {
+      uint32_t lruPage = UINT32_MAX;
+      for (uint32_t i = 0; i < m_Pages.size(); ++i)
+      {
+        if (m_Pages[i]->m_LastUse < m_Frame
+          && (lruPage == UINT32_MAX || m_Pages[i]->m_LastUse < m_Pages[lruPage]->m_LastUse))
+        {
+          lruPage = i;
+        }
+      }
+      if (lruPage != UINT32_MAX)
+      {
+        ResetPage(*m_Pages[lruPage]);
+        ++m_NumEvictions;
+        Pack(*m_Pages[lruPage], iSize, oPos);
+        return lruPage;
+      }
+      LOG_WARNING << "Glyph atlas over " << m_MaxPages << " pages, all in use this frame" << "\n";
+    }
+
+    UniquePtr<Page> newPage = std::make_unique<Page>();
+    newPage->m_Texture = MakeRefCounted<OGLTexture>(m_PageSize, OGLTextureType::TEXTURE_2D, OGLInternalTextureFormat::RED);
+    newPage->m_Texture->AllocateTexture();
+    newPage->m_TextureData.AddTexture(OGLSpriteAlgo::GetUnfilteredTexture(), newPage->m_Texture);
+    newPage->m_Pixels.resize(m_PageSize.x * m_PageSize.y, 0);
+    // Uploads the whole page, the texture storage is uninitialized.
+    newPage->m_DirtyMinY = 0;
+    newPage->m_DirtyMaxY = m_PageSize.y;
+    m_Pages.push_back(std::move(newPage));
+    ResetPage(*m_Pages.back());
+    Pack(*m_Pages.back(), iSize, oPos);
+
+    return m_Pages.size() - 1;
+  }
+
+  GfxGlyphAtlas::Location const* GfxGlyphAtlas::Add(Key const& iKey, Vec2u const& iSize, uint8_t const* iPixels)
+  {
+    if (Location const* existing = Find(iKey))
+    {
+      return existing;
+    }
+
+    Vec2u const paddedSize = iSize + Vec2u(2, 2);
+    if (paddedSize.x > m_PageSize.x || paddedSize.y > m_PageSize.y)
+    {
+      LOG_ERROR << "Glyph of " << iSize.x << "x" << iSize.y << " does not fit in the atlas pages" << "\n";
+      return nullptr;
+    }
+
+    Vec2u pos;
+    uint32_t const pageIdx = FindPageFor(paddedSize, pos);
+    Page& page = *m_Pages[pageIdx];
+
+    // Copy with a blank border, so that filtering does not bleed into the neighbours.
+    uint8_t* dst = page.m_Pixels.data() + pos.y * m_PageSize.x + pos.x;
+    memset(dst, 0, paddedSize.x);
+    for (uint32_t i = 0; i < iSize.y; ++i)
+    {
+      dst += m_PageSize.x;
+      dst[0] = 0;
+      memcpy(dst + 1, iPixels + i * iSize.x, iSize.x);
+      dst[iSize.x + 1] = 0;
+    }
+    memset(dst + m_PageSize.x, 0, paddedSize.x);
+
+    page.m_DirtyMinY = std::min(page.m_DirtyMinY, pos.y);
+    page.m_DirtyMaxY = std::max(page.m_DirtyMaxY, pos.y + paddedSize.y);
+    page.m_LastUse = m_Frame;
+    page.m_Glyphs.push_back(iKey);
+
+    float const halfPixelOffsetX = iSize.x > 1 ? 0.5 : 0.0;
+    float const halfPixelOffsetY = iSize.y > 1 ? 0.5 : 0.0;
+    Vec2 const texMin(pos.x + (1.0 - halfPixelOffsetX), pos.y + (1.0 - halfPixelOffsetY));
+
+    Location newLoc;
+    newLoc.m_Page = pageIdx;
+    newLoc.m_TexBox = AABB2Df(texMin.x / m_PageSize.x, texMin.y / m_PageSize.y,
+      (texMin.x + iSize.x) / m_PageSize.x, (texMin.y + iSize.y) / m_PageSize.y);
+    newLoc.m_Rect = AABB2Di(pos.x, pos.y, pos.x + paddedSize.x, pos.y + paddedSize.y);
+
+    return &m_Glyphs.emplace(iKey, newLoc).first->second;
+  }
+
+  void GfxGlyphAtlas::FlushUpdates()
+  {
+    for (UniquePtr<Page>& page : m_Pages)
+    {
+      if (page->m_DirtyMinY < page->m_DirtyMaxY)
+      {
+        // Whole rows, which are contiguous in the page copy.
+        AABB2Di const rows(0, page->m_DirtyMinY, m_PageSize.x, page->m_DirtyMaxY);
+        page->m_Texture->Update(rows, OGLTextureElementType::UNSIGNED_BYTE, OGLTextureFormat::RED,
+          page->m_Pixels.data() + page->m_DirtyMinY * m_PageSize.x);
+      }
+      page->m_DirtyMinY = UINT32_MAX;
+      page->m_DirtyMaxY = 0;
+    }
+  }
+}
@@ -4,6 +4,7 @@
 
 #include <engine/common/transforms.hpp>
 #include <engine/gfx/spriterenderer.hpp>
+#include <engine/gfx/gfxglyphatlas.hpp>
 #include <engine/common/data_tables/multi.hpp>
 
 #include <ogl/renderer/oglshaderdata.hpp>
@@ -14,216 +15,72 @@
 
 #include <utf8.h>
 
+#include <algorithm>
+
 namespace eXl
 {
   IMPLEMENT_RTTI(GfxGUIRenderNode);
 
   struct Text
   {
+    // One draw per atlas page used by the text.
+    struct PageDraw
+    {
+      OGLShaderData const* m_TextureData;
+      uint32_t m_Page;
+      uint32_t m_Offset;
+      uint32_t m_NumElems;
+    };
+
     String m_Text;
     uint32_t m_Size;
     uint8_t m_Depth;
     Resource::UUID m_FontId;
 
     Mat4 m_Transform;
-    uint32_t m_NumElems;
+    Vector<PageDraw> m_Draws;
     IntrusivePtr<OGLBuffer> m_TextData;
     OGLVAssembly m_Assembly;
-    OGLShaderData* m_TextureData;
     OGLShaderData m_ShaderData;
   };
 
-  struct FontCache
+  struct GlyphCache
   {
-    struct Entry
-    {
-      IntrusivePtr<OGLTexture> m_Texture;
-      OGLShaderData m_TextureData;
-      UnorderedMap<uint32_t, AABB2Df> m_AtlasLoc;
-      Vec2u m_CurAtlasLoc = Zero<Vec2u>();
-      uint32_t m_CurMaxY = 0;
-    };
-
-    struct Key
-    {
-      FontResource const* m_Font;
-      uint32_t m_Size;
-
-      bool operator == (Key const& iOther) const
-      {
-        return m_Font == iOther.m_Font && m_Size == iOther.m_Size;
-      }
-    };
-
-    using FontMap = UnorderedMap<Key, Entry>;
-    FontMap m_Fonts;
-    using FontEntry = FontMap::value_type;
-    Vector<uint8_t> m_GlyphCopyBuffer;
-
-    FontEntry& GetOrCreateEntry(Key const& iKey)
-    {
-      auto iter = m_Fonts.find(iKey);
-      if (iter != m_Fonts.end())
-      {
-        return *iter;
-      }
-
-      Entry newEntry;
-
-      Image::Size texSize(16 * iKey.m_Size, 16 * iKey.m_Size);
-      OGLTextureType textureType = OGLTextureType::TEXTURE_2D;
-      OGLInternalTextureFormat format = OGLInternalTextureFormat::RED;
-      newEntry.m_Texture = MakeRefCounted<OGLTexture>(texSize, textureType, format);
-      newEntry.m_Texture->AllocateTexture();
-      newEntry.m_TextureData.AddTexture(OGLSpriteAlgo::GetUnfilteredTexture(), newEntry.m_Texture);
-      iter = m_Fonts.emplace(Key(iKey), std::move(newEntry)).first;
-
-      // Bootstrap texture
-      for (uint32_t glyph = 'a'; glyph <= 'z'; glyph++)
-      {
-        AddGlyph(*iter, glyph);
-      }
-
-      for (uint32_t glyph = 'A'; glyph <= 'z'; glyph++)
-      {
-        AddGlyph(*iter, glyph);
-      }
-
-      for (uint32_t glyph = '0'; glyph <= '9'; glyph++)
-      {
-        AddGlyph(*iter, glyph);
-      }
-
-      AddGlyph(*iter, '.');
-      AddGlyph(*iter, ',');
-      AddGlyph(*iter, ' ');
-
-      return *iter;
-    }
-
-    Font::GlyphDesc GetGlyph(FontEntry& iEntry, uint32_t iGlyph, AABB2Df& oTexBox)
-    {
-      auto iter = iEntry.second.m_AtlasLoc.find(iGlyph);
-      if (iter != iEntry.second.m_AtlasLoc.end())
-      {
-        oTexBox = iter->second;
-      }
-      else
-      {
-        oTexBox = AddGlyph(iEntry, iGlyph);
-      }
-      return iEntry.first.m_Font->GetGlyphDesc(iGlyph, iEntry.first.m_Size);
-    }
+    GfxGlyphAtlas m_Atlas;
 
-    AABB2Df AddGlyph(FontEntry& iEntry, uint32_t iGlyph)
+    // Returns false for glyphs without pixels, oDesc is filled either way.
+    bool GetGlyph(FontResource const* iFont, uint32_t iSize, uint32_t iGlyph, Font::GlyphDesc& oDesc, GfxGlyphAtlas::Location& oLoc)
     {
-      AABB2Df glyphBox;
-      auto renderCb = [&glyphBox, &iEntry, iGlyph, this](Font::GlyphDesc iDesc, uint8_t const* iData)
+      GfxGlyphAtlas::Key key({ iFont, iSize, iGlyph });
+      if (Font::GlyphDesc const* desc = iFont->FindGlyphDesc(iGlyph, iSize))
       {
-        Entry& fontEntry = iEntry.second;
-        if ((iDesc.glyphSize.y + 2) > fontEntry.m_CurMaxY)
+        oDesc = *desc;
+        if (oDesc.glyphSize.x == 0 || oDesc.glyphSize.y == 0)
         {
-          fontEntry.m_CurMaxY = (iDesc.glyphSize.y + 2);
+          return false;
         }
-
-        float halfPixelOffsetX = iDesc.glyphSize.x > 1 ? 0.5 : 0.0;
-        float halfPixelOffsetY = iDesc.glyphSize.y > 1 ? 0.5 : 0.0;
-
-        Image::Size texSize = fontEntry.m_Texture->GetSize();
-        if (fontEntry.m_CurAtlasLoc.x + iDesc.glyphSize.x + 2 >= texSize.x)
+        if (GfxGlyphAtlas::Location const* loc = m_Atlas.Find(key))
         {
-          fontEntry.m_CurAtlasLoc.x = 0;
-          fontEntry.m_CurAtlasLoc.y += fontEntry.m_CurMaxY;
-          fontEntry.m_CurMaxY = 0;
-          eXl_ASSERT(fontEntry.m_CurAtlasLoc.y < texSize.y);
+          oLoc = *loc;
+          return true;
         }
+      }
 
-        glyphBox = AABB2Df(fontEntry.m_CurAtlasLoc.x + (1.0 - halfPixelOffsetX),
-          fontEntry.m_CurAtlasLoc.y + (1.0 - halfPixelOffsetY),
-          fontEntry.m_CurAtlasLoc.x + (1.0 - halfPixelOffsetX) + iDesc.glyphSize.x,
-          fontEntry.m_CurAtlasLoc.y + (1.0 - halfPixelOffsetY) + iDesc.glyphSize.y);
-
-        glyphBox.m_Data[0].x *= 1.0 / texSize.x;
-        glyphBox.m_Data[0].y *= 1.0 / texSize.y;
-        glyphBox.m_Data[1].x *= 1.0 / texSize.x;
-        glyphBox.m_Data[1].y *= 1.0 / texSize.y;
-        {
-          AABB2Di texLoc(fontEntry.m_CurAtlasLoc.x,
-            fontEntry.m_CurAtlasLoc.y,
-            fontEntry.m_CurAtlasLoc.x + iDesc.glyphSize.x + 2,
-            fontEntry.m_CurAtlasLoc.y + iDesc.glyphSize.y + 2);
-
-          size_t totSize = texLoc.GetSize().x * texLoc.GetSize().y;
-          if (m_GlyphCopyBuffer.size() <= totSize)
-          {
-            m_GlyphCopyBuffer.resize(totSize);
-          }
-          uint8_t const* src = iData;
-          uint8_t* dst = m_GlyphCopyBuffer.data();
-#if 0
-          memset(dst, 0, margin * (bitmap.width + 2 * margin) + margin);
-          dst += margin * (bitmap.width + 2 * margin) + margin;
-
-          for (uint32_t i = 0; i < bitmap.rows; ++i)
-          {
-            memcpy(dst, src, bitmap.width);
-            dst += bitmap.width;
-            memset(dst, 0, 2 * margin);
-            dst += 2 * margin;
-            src += bitmap.width;
-          }
-          memset(dst, 0, margin * bitmap.width + margin);
-
-          //Image filter(filterCoeff, Vec2i(3,3), Image::R, Image::Float, 1, Image::Reference);
-          Image filter(filterCoeff5, Image::Size(5, 5), Image::R, Image::Float, 1, Image::Reference);
-          Image newBitmap(m_Impl->m_GlyphCopyBuffer, Image::Size(bitmap.width + 2 * margin, bitmap.rows + 2 * margin), Image::R, Image::Char, 1, Image::Reference);
-          //newBitmap.Convolve(filter, Vec2i(-1,-1));
-          //newBitmap.Convolve(filter, Vec2i(-2,-2));
-
-          dst = m_Impl->m_GlyphCopyBuffer;
-          src = reinterpret_cast<unsigned char const*>(newBitmap.GetImageData());
-          src += margin * (bitmap.width + 2 * margin) + margin;
-#endif
-          memset(dst, 0, iDesc.glyphSize.x + 2 + 1);
-          dst += iDesc.glyphSize.x + 2 + 1;
-
-          for (uint32_t i = 0; i < iDesc.glyphSize.y; ++i)
-          {
-            memcpy(dst, src, iDesc.glyphSize.x);
-            dst += iDesc.glyphSize.x;
-            dst[0] = 0;
-            dst[1] = 1;
-            dst += 2;
-            src += iDesc.glyphSize.x;
-          }
-          memset(dst, 0, iDesc.glyphSize.x + 1);
-
-          //Assume 256 grey level format
-          fontEntry.m_Texture->Update(texLoc, OGLTextureElementType::UNSIGNED_BYTE, OGLTextureFormat::RED, m_GlyphCopyBuffer.data());
-          fontEntry.m_AtlasLoc.insert(std::make_pair(iGlyph, glyphBox));
-          fontEntry.m_CurAtlasLoc.x += iDesc.glyphSize.x + 2;
-          if (fontEntry.m_CurAtlasLoc.x >= texSize.x)
-          {
-            fontEntry.m_CurAtlasLoc.x = 0;
-            fontEntry.m_CurAtlasLoc.y += fontEntry.m_CurMaxY;
-            fontEntry.m_CurMaxY = 0;
-            eXl_ASSERT(fontEntry.m_CurAtlasLoc.y < texSize.y);
-          }
-        }
-      };
-      iEntry.first.m_Font->RenderGlyph(iGlyph, iEntry.first.m_Size, renderCb);
-      return glyphBox;
+      // First use, or evicted from the atlas.
+      GfxGlyphAtlas::Location const* loc = nullptr;
+      oDesc = iFont->RenderGlyph(iGlyph, iSize, [this, &key, &loc](Font::GlyphDesc iDesc, uint8_t const* iData)
+      {
+        loc = m_Atlas.Add(key, iDesc.glyphSize, iData);
+      });
+      if (loc == nullptr)
+      {
+        return false;
+      }
+      oLoc = *loc;
+      return true;
     }
   };
 
-  size_t hash_value(FontCache::Key const& iKey)
-  {
-    size_t hash = 0;
-    boost::hash_combine(hash, iKey.m_Font);
-    boost::hash_combine(hash, iKey.m_Size);
-    return hash;
-  }
-
   struct WorldGUIItem
   {
     ObjectHandle m_WorldAttachment;
@@ -257,7 +114,7 @@ namespace eXl
     OGLShaderData m_ScreenCamData;
     IntrusivePtr<OGLBuffer> m_WorldCamBuffer;
     IntrusivePtr<OGLBuffer> m_ScreenCamBuffer;
-    FontCache m_Fonts;
+    GlyphCache m_Glyphs;
 
     DenseGameDataStorage<GfxSpriteComponent::Desc> m_GUISprite;
     DenseGameDataStorage<GfxSpriteData> m_GUISpriteData;
@@ -342,9 +199,6 @@ namespace eXl
       return;
     }
 
-    FontCache::Key key({ iFont, iSize });
-    auto& entry = m_Impl->m_Fonts.GetOrCreateEntry(key);
-
     uint32_t curLineBegin = 0;
     uint32_t curLineEnd = 0;
     float curLineMin = 0;
@@ -360,6 +214,8 @@ namespace eXl
 
     Vector<AABB2Df> oPos;
     Vector<AABB2Df> oTexCoords;
+    Vector<uint32_t> oPages;
+    uint32_t prevSymbol = 0;
 
     String::const_iterator iterTxt = iText.begin();
     String::const_iterator iterTxtEnd = iText.end();
@@ -382,18 +238,26 @@ namespace eXl
         curLineBegin = curLineEnd = oPos.size();
         beginningOfLine = true;
         curLineMin = curLineMax = 0;
+        prevSymbol = 0;
       }
       else
       {
-        AABB2Df glyphBox;
-        Font::GlyphDesc desc = m_Impl->m_Fonts.GetGlyph(entry, symbol, glyphBox);
-        if (desc.glyphSize.x != 0 && desc.glyphSize.y != 0)
+        if (prevSymbol != 0 && !beginningOfLine)
+        {
+          penPos.x += iFont->GetKerning(prevSymbol, symbol, iSize);
+        }
+        prevSymbol = symbol;
+
+        Font::GlyphDesc desc;
+        GfxGlyphAtlas::Location glyphLoc;
+        if (m_Impl->m_Glyphs.GetGlyph(iFont, iSize, symbol, desc, glyphLoc))
         {
           oPos.push_back(AABB2Df(penPos.x + desc.penOffset.x,
             desc.penOffset.y - desc.glyphSize.y,
             penPos.x + (desc.penOffset.x + desc.glyphSize.x),
             desc.penOffset.y));
-          oTexCoords.push_back(glyphBox);
+          oTexCoords.push_back(glyphLoc.m_TexBox);
+          oPages.push_back(glyphLoc.m_Page);
 
           curLineMin = Mathf::Min(oPos.back().MinY(), curLineMin);
           curLineMax = Mathf::Max(oPos.back().MaxY(), curLineMax);
@@ -457,14 +321,35 @@ namespace eXl
     size_t totBufferSize = oPos.size() * 4 * 5 * sizeof(float);
     size_t totIdxBufferSize = oPos.size() * 6 * sizeof(uint32_t);
 
+    // Glyphs on the same page are drawn together.
+    Vector<uint32_t> order(oPos.size());
+    for (uint32_t i = 0; i < order.size(); ++i)
+    {
+      order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&oPages](uint32_t iA, uint32_t iB) { return oPages[iA] < oPages[iB]; });
+
+    textElem.m_Draws.clear();
     Vector<float> geomData;
     Vector<uint32_t> geomIdxData;
     geomData.reserve(oPos.size() * 4 * 5);
     geomIdxData.reserve(oPos.size() * 6);
     for (uint32_t i = 0; i < oPos.size(); ++i)
     {
-      AABB2Df const& geomBox = oPos[i];
-      AABB2Df const& texBox = oTexCoords[i];
+      uint32_t const page = oPages[order[i]];
+      if (textElem.m_Draws.empty() || textElem.m_Draws.back().m_Page != page)
+      {
+        Text::PageDraw newDraw;
+        newDraw.m_TextureData = m_Impl->m_Glyphs.m_Atlas.GetTextureData(page);
+        newDraw.m_Page = page;
+        newDraw.m_Offset = geomIdxData.size();
+        newDraw.m_NumElems = 0;
+        textElem.m_Draws.push_back(newDraw);
+      }
+      textElem.m_Draws.back().m_NumElems += 6;
+
+      AABB2Df const& geomBox = oPos[order[i]];
+      AABB2Df const& texBox = oTexCoords[order[i]];
 
       int32_t const permutation[] = { 0, 0, 1, 0, 1, 1, 0, 1 };
       for (uint32_t j = 0; j < 4; ++j)
@@ -483,14 +368,12 @@ namespace eXl
       }
     }
 
-    textElem.m_NumElems = geomIdxData.size();
     textElem.m_TextData = IntrusivePtr<OGLBuffer>(OGLBuffer::CreateBuffer(OGLBufferUsage::ARRAY_BUFFER, totBufferSize, geomData.data()));
     textElem.m_Assembly.m_IBuffer = IntrusivePtr<OGLBuffer>(OGLBuffer::CreateBuffer(OGLBufferUsage::ELEMENT_ARRAY_BUFFER, totIdxBufferSize, geomIdxData.data()));
     textElem.m_Assembly.m_IOffset = 0;
     textElem.m_Assembly.AddAttrib(textElem.m_TextData, OGLBaseAlgo::GetPosAttrib(), 3, 5 * sizeof(float), 0);
     textElem.m_Assembly.AddAttrib(textElem.m_TextData, OGLBaseAlgo::GetTexCoordAttrib(), 2, 5 * sizeof(float), 3 * sizeof(float));
 
-    textElem.m_TextureData = &entry.second.m_TextureData;
     textElem.m_Transform = m_Sys->GetTransforms().GetWorldTransform(iObject);
     textElem.m_ShaderData.AddData(OGLBaseAlgo::GetWorldMatUniform(), &textElem.m_Transform);
 
@@ -543,6 +426,10 @@ namespace eXl
 
   void GfxGUIRenderNode::Push(OGLDisplayList& iList, float iDelta)
   {
+    GfxGlyphAtlas& atlas = m_Impl->m_Glyphs.m_Atlas;
+    atlas.NextFrame();
+    atlas.FlushUpdates();
+
     iList.SetDepth(false, false);
 
     Vec2i viewport = m_Sys->GetViewportSize();
@@ -604,11 +491,15 @@ namespace eXl
         Mat4 const& attachTrans = m_Sys->GetTransforms().GetWorldTransform(iItem.m_WorldAttachment);
         Mat4 const& objTrans = m_Sys->GetTransforms().GetWorldTransform(iObject);
         iText.m_Transform = translate(objTrans, Vec3(worldToScreen * attachTrans[3]));
-        iList.PushData(iText.m_TextureData);
         iList.PushData(&iText.m_ShaderData);
         iList.SetVAssembly(&iText.m_Assembly);
-        iList.PushDraw(0x1000 + iText.m_Depth, OGLDraw::TriangleList, iText.m_NumElems, 0, 0);
-        iList.PopData();
+        for (Text::PageDraw const& draw : iText.m_Draws)
+        {
+          atlas.TouchPage(draw.m_Page);
+          iList.PushData(draw.m_TextureData);
+          iList.PushDraw(0x1000 + iText.m_Depth, OGLDraw::TriangleList, draw.m_NumElems, draw.m_Offset, 0);
+          iList.PopData();
+        }
         iList.PopData();
       });
     
@@ -627,13 +518,17 @@ namespace eXl
 
     iList.PushData(&m_Impl->m_DefaultData);
 
-    m_Impl->m_TextElementsScreen.Iterate([&iList](ObjectHandle iObject, Text const& iText)
+    m_Impl->m_TextElementsScreen.Iterate([&iList, &atlas](ObjectHandle iObject, Text const& iText)
       {
-        iList.PushData(iText.m_TextureData);
         iList.PushData(&iText.m_ShaderData);
         iList.SetVAssembly(&iText.m_Assembly);
-        iList.PushDraw(0x2000 + iText.m_Depth, OGLDraw::TriangleList, iText.m_NumElems, 0, 0);
-        iList.PopData();
+        for (Text::PageDraw const& draw : iText.m_Draws)
+        {
+          atlas.TouchPage(draw.m_Page);
+          iList.PushData(draw.m_TextureData);
+          iList.PushDraw(0x2000 + iText.m_Depth, OGLDraw::TriangleList, draw.m_NumElems, draw.m_Offset, 0);
+          iList.PopData();
+        }
         iList.PopData();
       });
 
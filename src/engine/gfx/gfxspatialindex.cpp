@@ -0,0 +1,434 @@
+/*
+Copyright 2009-2021 Nicolas Colombe
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <engine/gfx/gfxspatialindex.hpp>
+
+namespace eXl
+{
+  namespace
+  {
+    inline uint64_t CellKey(int32_t iX, int32_t iY)
+    {
+      return (uint64_t(uint32_t(iX)) << 32) | uint32_t(iY);
+    }
+
+    // Entry parameter of the ray in the box, if it goes through it.
+    inline bool RayBox(Vec3 const& iOrigin, Vec3 const& iDir, GfxBounds const& iBounds, float& oT)
+    {
+      float tMin = 0;
+      float tMax = Mathf::MaxReal();
+      for (uint32_t i = 0; i < 3; ++i)
+      {
+        if (iDir[i] == 0)
+        {
+          if (iOrigin[i] < iBounds.m_Min[i] || iOrigin[i] > iBounds.m_Max[i])
+          {
+            return false;
+          }
+          continue;
+        }
+        float t0 = (iBounds.m_Min[i] - iOrigin[i]) / iDir[i];
+        float t1 = (iBounds.m_Max[i] - iOrigin[i]) / iDir[i];
+        if (t0 > t1)
+        {
+          std::swap(t0, t1);
+        }
+        tMin = Mathf::Max(tMin, t0);
+        tMax = Mathf::Min(tMax, t1);
+        if (tMin > tMax)
+        {
+          return false;
+        }
+      }
+      oT = tMin;
+      return true;
+    }
+  }
+
+  GfxViewFrustum::GfxViewFrustum(Mat4 const& iViewProj)
+  {
+    // Clip space is -w <= x, y, z <= w, each side is row 3 +/- row i.
+    auto row = [&iViewProj](uint32_t iRow)
+    {
+      return Vec4(iViewProj[0][iRow], iViewProj[1][iRow], iViewProj[2][iRow], iViewProj[3][iRow]);
+    };
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+      m_Planes[2 * i + 0] = row(3) + row(i);
+      m_Planes[2 * i + 1] = row(3) - row(i);
+    }
+
+    Mat4 const invMat = inverse(iViewProj);
+    for (uint32_t i = 0; i < 8; ++i)
+    {
+      Vec4 const corner = invMat * Vec4(i & 1 ? 1 : -1, i & 2 ? 1 : -1, i & 4 ? 1 : -1, 1);
+      m_Corners[i] = Vec3(corner) / corner.w;
+    }
+  }
+
+  bool GfxViewFrustum::Intersects(GfxBounds const& iBounds) const
+  {
+    for (Vec4 const& plane : m_Planes)
+    {
+      // Corner of the box the furthest along the plane normal.
+      Vec3 const corner(plane.x >= 0 ? iBounds.m_Max.x : iBounds.m_Min.x,
+        plane.y >= 0 ? iBounds.m_Max.y : iBounds.m_Min.y,
+        plane.z >= 0 ? iBounds.m_Max.z : iBounds.m_Min.z);
+      if (dot(Vec3(plane), corner) + plane.w < 0)
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  Optional<AABB2Df> GfxViewFrustum::GetFootprint(float iMinZ, float iMaxZ) const
+  {
+    Optional<AABB2Df> footprint;
+    auto absorb = [&footprint](Vec3 const& iPoint)
+    {
+      if (!footprint)
+      {
+        footprint = AABB2Df(iPoint.x, iPoint.y, iPoint.x, iPoint.y);
+      }
+      else
+      {
+        footprint->Absorb(Vec2(iPoint));
+      }
+    };
+
+    if (iMinZ > iMaxZ)
+    {
+      return footprint;
+    }
+
+    // The volume clipped by the slab has the corners inside it, and the points where the edges cross it.
+    for (uint32_t i = 0; i < 8; ++i)
+    {
+      Vec3 const& corner = m_Corners[i];
+      if (corner.z >= iMinZ && corner.z <= iMaxZ)
+      {
+        absorb(corner);
+      }
+      for (uint32_t axis = 1; axis < 8; axis <<= 1)
+      {
+        if (i & axis)
+        {
+          continue;
+        }
+        Vec3 const& other = m_Corners[i | axis];
+        for (float z : {iMinZ, iMaxZ})
+        {
+          if ((corner.z - z) * (other.z - z) < 0)
+          {
+            absorb(corner + (other - corner) * ((z - corner.z) / (other.z - corner.z)));
+          }
+        }
+      }
+    }
+    return footprint;
+  }
+
+  GfxBounds GfxSpatialIndex::TransformBox(Mat4 const& iTransform, GfxBounds const& iLocalBounds)
+  {
+    Vec3 const first = Vec3(iTransform * Vec4(iLocalBounds.m_Min, 1));
+    GfxBounds bounds = { first, first };
+    for (uint32_t i = 1; i < 8; ++i)
+    {
+      Vec3 const corner(i & 1 ? iLocalBounds.m_Max.x : iLocalBounds.m_Min.x,
+        i & 2 ? iLocalBounds.m_Max.y : iLocalBounds.m_Min.y,
+        i & 4 ? iLocalBounds.m_Max.z : iLocalBounds.m_Min.z);
+      Vec3 const point = Vec3(iTransform * Vec4(corner, 1));
+      bounds.m_Min = glm::min(bounds.m_Min, point);
+      bounds.m_Max = glm::max(bounds.m_Max, point);
+    }
+    return bounds;
+  }
+
+  GfxSpatialIndex::GfxSpatialIndex(float iCellSize)
+    : m_CellSize(iCellSize)
+  {
+    eXl_ASSERT(iCellSize > 0);
+  }
+
+  GfxSpatialIndex::Entry* GfxSpatialIndex::GetEntry(ObjectHandle iObject)
+  {
+    if (iObject.GetId() < m_Entries.size() && m_Entries[iObject.GetId()].m_Object == iObject)
+    {
+      return &m_Entries[iObject.GetId()];
+    }
+    return nullptr;
+  }
+
+  bool GfxSpatialIndex::Contains(ObjectHandle iObject) const
+  {
+    return iObject.GetId() < m_Entries.size() && m_Entries[iObject.GetId()].m_Object == iObject;
+  }
+
+  GfxSpatialIndex::Entry& GfxSpatialIndex::AddEntry(ObjectHandle iObject)
+  {
+    if (m_Entries.size() <= iObject.GetId())
+    {
+      m_Entries.resize(iObject.GetId() + 1);
+    }
+    Entry& entry = m_Entries[iObject.GetId()];
+    if (entry.m_Object.IsAssigned())
+    {
+      // Stale entry of a destroyed object whose id got reused.
+      Unlink(entry);
+    }
+    else
+    {
+      ++m_NumObjects;
+    }
+    entry.m_Object = iObject;
+    return entry;
+  }
+
+  void GfxSpatialIndex::Unlink(Entry& iEntry)
+  {
+    if (iEntry.m_Bounded)
+    {
+      Cells& level = m_Levels[iEntry.m_Level];
+      auto iter = level.find(iEntry.m_Cell);
+      eXl_ASSERT(iter != level.end());
+      Vector<uint32_t>& cell = iter->second;
+      cell[iEntry.m_Slot] = cell.back();
+      m_Entries[cell[iEntry.m_Slot]].m_Slot = iEntry.m_Slot;
+      cell.pop_back();
+      if (cell.empty())
+      {
+        level.erase(iter);
+      }
+      --m_LevelCount[iEntry.m_Level];
+    }
+    else
+    {
+      m_Unbounded[iEntry.m_Slot] = m_Unbounded.back();
+      m_Entries[m_Unbounded[iEntry.m_Slot].GetId()].m_Slot = iEntry.m_Slot;
+      m_Unbounded.pop_back();
+    }
+  }
+
+  void GfxSpatialIndex::Update(ObjectHandle iObject, GfxBounds const& iBounds)
+  {
+    m_MinZ = Mathf::Min(m_MinZ, iBounds.m_Min.z);
+    m_MaxZ = Mathf::Max(m_MaxZ, iBounds.m_Max.z);
+
+    Vec2 const size = Vec2(iBounds.m_Max - iBounds.m_Min);
+    uint32_t levelIdx = 0;
+    float cellSize = m_CellSize;
+    while (levelIdx + 1 < s_NumLevels && (size.x > cellSize || size.y > cellSize))
+    {
+      ++levelIdx;
+      cellSize *= 2;
+    }
+    if (levelIdx + 1 == s_NumLevels)
+    {
+      m_TopLevelSize = Mathf::Max(m_TopLevelSize, Mathf::Max(size.x, size.y));
+    }
+    Vec2 const center = Vec2(iBounds.m_Min + iBounds.m_Max) * 0.5f;
+    uint64_t const cellKey = CellKey(Mathf::Floor(center.x / cellSize), Mathf::Floor(center.y / cellSize));
+
+    Entry* entry = GetEntry(iObject);
+    if (entry != nullptr)
+    {
+      if (entry->m_Bounded && entry->m_Level == levelIdx && entry->m_Cell == cellKey)
+      {
+        entry->m_Bounds = iBounds;
+        return;
+      }
+      Unlink(*entry);
+    }
+    else
+    {
+      entry = &AddEntry(iObject);
+    }
+
+    Vector<uint32_t>& cell = m_Levels[levelIdx][cellKey];
+    entry->m_Bounds = iBounds;
+    entry->m_Bounded = true;
+    entry->m_Level = levelIdx;
+    entry->m_Cell = cellKey;
+    entry->m_Slot = cell.size();
+    cell.push_back(iObject.GetId());
+    ++m_LevelCount[levelIdx];
+  }
+
+  void GfxSpatialIndex::SetUnbounded(ObjectHandle iObject)
+  {
+    Entry* entry = GetEntry(iObject);
+    if (entry != nullptr)
+    {
+      if (!entry->m_Bounded)
+      {
+        return;
+      }
+      Unlink(*entry);
+    }
+    else
+    {
+      entry = &AddEntry(iObject);
+    }
+
+    entry->m_Bounded = false;
+    entry->m_Slot = m_Unbounded.size();
+    m_Unbounded.push_back(iObject);
+  }
+
+  void GfxSpatialIndex::Remove(ObjectHandle iObject)
+  {
+    if (Entry* entry = GetEntry(iObject))
+    {
+      Unlink(*entry);
+      entry->m_Object = ObjectHandle();
+      --m_NumObjects;
+    }
+  }
+
+  template <typename Functor>
+  void GfxSpatialIndex::ForEachInBox(AABB2Df const& iBox, Functor const& iFunctor) const
+  {
+    auto testEntry = [&](uint32_t iEntry)
+    {
+      GfxBounds const& bounds = m_Entries[iEntry].m_Bounds;
+      if (bounds.m_Min.x <= iBox.MaxX() && bounds.m_Max.x >= iBox.MinX()
+        && bounds.m_Min.y <= iBox.MaxY() && bounds.m_Max.y >= iBox.MinY())
+      {
+        iFunctor(m_Entries[iEntry]);
+      }
+    };
+
+    float cellSize = m_CellSize;
+    for (uint32_t levelIdx = 0; levelIdx < s_NumLevels; ++levelIdx, cellSize *= 2)
+    {
+      if (m_LevelCount[levelIdx] == 0)
+      {
+        continue;
+      }
+
+      // Boxes of this level stick out of their cell by at most half a cell, or half of the largest box for the top one.
+      float const margin = levelIdx + 1 == s_NumLevels ? Mathf::Max(cellSize, m_TopLevelSize) * 0.5 : cellSize * 0.5;
+      float const minX = Mathf::Floor((iBox.MinX() - margin) / cellSize);
+      float const minY = Mathf::Floor((iBox.MinY() - margin) / cellSize);
+      float const maxX = Mathf::Floor((iBox.MaxX() + margin) / cellSize);
+      float const maxY = Mathf::Floor((iBox.MaxY() + margin) / cellSize);
+
+      Cells const& level = m_Levels[levelIdx];
+      if ((maxX - minX + 1) * (maxY - minY + 1) > float(level.size()))
+      {
+        // Fewer occupied cells than cells in range.
+        for (auto const& cell : level)
+        {
+          int32_t const cellX = int32_t(cell.first >> 32);
+          int32_t const cellY = int32_t(uint32_t(cell.first));
+          if (cellX >= minX && cellX <= maxX && cellY >= minY && cellY <= maxY)
+          {
+            for (uint32_t entry : cell.second)
+            {
+              testEntry(entry);
+            }
+          }
+        }
+        continue;
+      }
+
+      for (int32_t cellY = minY; cellY <= int32_t(maxY); ++cellY)
+      {
+        for (int32_t cellX = minX; cellX <= int32_t(maxX); ++cellX)
+        {
+          auto iter = level.find(CellKey(cellX, cellY));
+          if (iter != level.end())
+          {
+            for (uint32_t entry : iter->second)
+            {
+              testEntry(entry);
+            }
+          }
+        }
+      }
+    }
+  }
+
+  void GfxSpatialIndex::Query(AABB2Df const& iBox, Vector<ObjectHandle>& oObjects) const
+  {
+    ForEachInBox(iBox, [&oObjects](Entry const& iEntry)
+    {
+      oObjects.push_back(iEntry.m_Object);
+    });
+  }
+
+  void GfxSpatialIndex::Query(GfxViewFrustum const& iFrustum, Vector<ObjectHandle>& oObjects) const
+  {
+    Optional<AABB2Df> const footprint = iFrustum.GetFootprint(m_MinZ, m_MaxZ);
+    if (!footprint)
+    {
+      return;
+    }
+    ForEachInBox(*footprint, [&](Entry const& iEntry)
+    {
+      if (iFrustum.Intersects(iEntry.m_Bounds))
+      {
+        oObjects.push_back(iEntry.m_Object);
+      }
+    });
+  }
+
+  void GfxSpatialIndex::Raycast(Vec3 const& iOrigin, Vec3 const& iDir, Vector<std::pair<float, ObjectHandle>>& oObjects) const
+  {
+    auto testEntry = [&](Entry const& iEntry)
+    {
+      float t;
+      if (RayBox(iOrigin, iDir, iEntry.m_Bounds, t))
+      {
+        oObjects.push_back(std::make_pair(t, iEntry.m_Object));
+      }
+    };
+
+    if (m_MinZ > m_MaxZ)
+    {
+      return;
+    }
+
+    if (iDir.z == 0)
+    {
+      // Nothing bounds the ray in the XY plane.
+      if (iOrigin.z >= m_MinZ && iOrigin.z <= m_MaxZ)
+      {
+        for (Entry const& entry : m_Entries)
+        {
+          if (entry.m_Object.IsAssigned() && entry.m_Bounded)
+          {
+            testEntry(entry);
+          }
+        }
+      }
+      return;
+    }
+
+    // Only the part of the ray within the indexed Z range can hit something.
+    float t0 = (m_MinZ - iOrigin.z) / iDir.z;
+    float t1 = (m_MaxZ - iOrigin.z) / iDir.z;
+    if (t0 > t1)
+    {
+      std::swap(t0, t1);
+    }
+    if (t1 < 0)
+    {
+      return;
+    }
+    t0 = Mathf::Max(t0, 0);
+    Vec3 const start = iOrigin + iDir * t0;
+    Vec3 const end = iOrigin + iDir * t1;
+    AABB2Df segmentBox(start.x, start.y, start.x, start.y);
+    segmentBox.Absorb(Vec2(end));
+    ForEachInBox(segmentBox, testEntry);
+  }
+}
@@ -10,9 +10,11 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 #include <engine/gfx/gfxsystem.hpp>
 #include "gfxspriterendernode.hpp"
+#include <engine/gfx/gfxspatialindex.hpp>
 
 #include <ogl/renderer/ogldisplaylist.hpp>
 #include <engine/common/transforms.hpp>
+#include <engine/common/data_tables/query.hpp>
 
 namespace eXl
 {
@@ -30,12 +32,55 @@ namespace eXl
   {
     m_Renderer->PrepareSprites();
     iList.SetDepth(true, true);
+
+    // Only the sprites in view are pushed, the others keep their animation frame until they come back.
+    GfxViewFrustum const* frustum = m_Sys->GetCullingFrustum();
+    auto iterateSprites = [&](auto const& iFunctor)
+    {
+      if (frustum == nullptr)
+      {
+        Query<GfxSpriteData, GfxSpriteComponent::Desc const> sprites(m_Renderer->m_SpriteData, m_Renderer->m_SpriteDescView);
+        sprites.Iterate([&](ObjectHandle, GfxSpriteData& data, GfxSpriteComponent::Desc const& desc)
+        {
+          iFunctor(data, desc);
+        });
+        return;
+      }
+
+      m_Visible.clear();
+      m_Sys->GetSpriteIndex().Query(*frustum, m_Visible);
+      for (ObjectHandle object : m_Visible)
+      {
+        GfxSpriteData* data = m_Renderer->m_SpriteData.Get(object);
+        GfxSpriteComponent::Desc const* desc = m_Renderer->m_SpriteDescView.GetConst(object);
+        if (data != nullptr && desc != nullptr)
+        {
+          iFunctor(*data, *desc);
+        }
+      }
+    };
+
+    if (m_UseInstancing && m_Renderer->CanUseInstancing())
+    {
+      m_Renderer->ClearInstances();
+      iterateSprites([&](GfxSpriteData& data, GfxSpriteComponent::Desc const& desc)
+        {
+          if (data.m_Texture != nullptr)
+          {
+            m_Renderer->TickAnimation(data, desc, iDelta);
+            m_Renderer->AddInstance(data);
+          }
+        });
+      m_Renderer->PushInstances(iList, 0x0100);
+      return;
+    }
+
     iList.SetProgram(m_Renderer->m_SpriteProgram.get());
-    m_SpriteData->Iterate([&](ObjectHandle object, GfxSpriteData& data)
+    iterateSprites([&](GfxSpriteData& data, GfxSpriteComponent::Desc const& desc)
       {
         if (data.m_Texture != nullptr)
         {
-          m_Renderer->TickAnimation(object, data, iDelta);
+          m_Renderer->TickAnimation(data, desc, iDelta);
           data.Push(iList, 0x0100);
         }
       });
@@ -82,5 +127,6 @@ namespace eXl
   {
     m_Renderer->m_SpriteData.Erase(iObject);
     m_Renderer->m_DirtyComponents.erase(iObject);
+    m_Sys->GetSpriteIndex().Remove(iObject);
   }
 }
\ No newline at end of file
@@ -27,11 +27,16 @@ namespace eXl
 
     OGLCompiledProgram const* GetSpriteProgram() { return m_Renderer->m_SpriteProgram.get(); }
 
+    void SetUseInstancing(bool iUseInstancing) { m_UseInstancing = iUseInstancing; }
+
   protected:
 
     void RemoveObject(ObjectHandle);
 
+    bool m_UseInstancing = true;
+
     Optional<DenseGameDataStorage<GfxSpriteData>> m_SpriteData;
     Optional<SpriteRenderer> m_Renderer;
+    Vector<ObjectHandle> m_Visible;
   };
 }
\ No newline at end of file
@@ -12,8 +12,10 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include "gfxdebugdrawer.hpp"
 #include "gfxcomponentrendernode.hpp"
 #include "gfxspriterendernode.hpp"
+#include <engine/gfx/gfxspatialindex.hpp>
 
 #include <ogl/renderer/oglrendercontext.hpp>
+#include <ogl/renderer/oglrecordingcontext.hpp>
 #include <ogl/renderer/ogldisplaylist.hpp>
 #include <ogl/renderer/oglcompiledprogram.hpp>
 
@@ -21,6 +23,10 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <engine/common/transforms.hpp>
 #include <math/mathtools.hpp>
 #include <core/type/tagtype.hpp>
+#include <core/profiler.hpp>
+#include <core/thread/jobsystem.hpp>
+
+#include <algorithm>
 
 namespace eXl
 {
@@ -32,6 +38,7 @@ namespace eXl
   public:
     Impl(Transforms& iTrans)
       : m_Transforms(iTrans)
+      , m_DisplayList(m_Semantics)
     {
       
     }
@@ -39,6 +46,10 @@ namespace eXl
     Vec2i m_ViewportSize;
     float m_NearP;
     float m_FarP;
+    bool m_Culling = true;
+    Optional<GfxViewFrustum> m_Frustum;
+    GfxSpatialIndex m_SpriteIndex;
+    GfxSpatialIndex m_ComponentIndex;
     Vec4 m_ClearColor;
     float m_ClearDepth;
     CameraMatrix m_Camera;
@@ -48,10 +59,16 @@ namespace eXl
     GfxSpriteRenderNode* m_SpriteNode;
 
     IntrusivePtr<OGLBuffer> m_CameraBuffer;
+    // Kept at the same address, for the display list segments that render nodes retain.
+    OGLShaderData m_CameraData;
 
     Transforms& m_Transforms;
 
     OGLSemanticManager m_Semantics;
+    // Reused from frame to frame, along with the sub-lists of the nodes pushed in parallel.
+    OGLDisplayList m_DisplayList;
+    Vector<UniquePtr<OGLDisplayList>> m_SubLists;
+
     struct RenderNodeEntry
     {
       UniquePtr<GfxRenderNode> m_Node;
@@ -69,6 +86,7 @@ namespace eXl
     RenderNodeHandle m_SpriteHandle;
 
     Vector<RenderNodeHandle> m_ObjectToNode;
+    Vector<GfxRenderNode*> m_PushNodes;
   };
 
   OGLSemanticManager& GfxSystem::GetSemanticManager()
@@ -92,6 +110,56 @@ namespace eXl
     oViewDir = normalize(Vec3(worldPtF) - oWorldPos);
   }
 
+  GfxSpatialIndex& GfxSystem::GetSpriteIndex()
+  {
+    return m_Impl->m_SpriteIndex;
+  }
+
+  GfxSpatialIndex& GfxSystem::GetComponentIndex()
+  {
+    return m_Impl->m_ComponentIndex;
+  }
+
+  void GfxSystem::SetViewCulling(bool iEnabled)
+  {
+    m_Impl->m_Culling = iEnabled;
+  }
+
+  GfxViewFrustum const* GfxSystem::GetCullingFrustum() const
+  {
+    return m_Impl->m_Culling && m_Impl->m_Frustum ? &(*m_Impl->m_Frustum) : nullptr;
+  }
+
+  void GfxSystem::PickObjects(Vec2i const& iScreenPos, Vector<ObjectHandle>& oObjects)
+  {
+    // Ray from the near to the far plane, so that nothing in view is in front of its origin.
+    Vec2 const screenSpacePos(2.0 * float(iScreenPos.x) / m_Impl->m_ViewportSize.x - 1.0,
+      1.0 - 2.0 * float(iScreenPos.y) / m_Impl->m_ViewportSize.y);
+    Mat4 const invMat = inverse(m_Impl->m_Camera.projMatrix * m_Impl->m_Camera.viewMatrix);
+    Vec4 const nearPt = invMat * Vec4(screenSpacePos, -1, 1);
+    Vec4 const farPt = invMat * Vec4(screenSpacePos, 1, 1);
+    Vec3 const origin = Vec3(nearPt) / nearPt.w;
+    Vec3 const dir = Vec3(farPt) / farPt.w - origin;
+
+    Vector<std::pair<float, ObjectHandle>> hits;
+    m_Impl->m_SpriteIndex.Raycast(origin, dir, hits);
+    m_Impl->m_ComponentIndex.Raycast(origin, dir, hits);
+    std::sort(hits.begin(), hits.end(), [](std::pair<float, ObjectHandle> const& iHit1, std::pair<float, ObjectHandle> const& iHit2)
+    {
+      return iHit1.first < iHit2.first;
+    });
+
+    size_t const firstPicked = oObjects.size();
+    for (auto const& hit : hits)
+    {
+      // An object with both a sprite and a component is hit twice.
+      if (std::find(oObjects.begin() + firstPicked, oObjects.end(), hit.second) == oObjects.end())
+      {
+        oObjects.push_back(hit.second);
+      }
+    }
+  }
+
   Vec2i GfxSystem::WorldToScreen(Vec3 const& iWorldPos)
   {
     Vec4 worldPos(iWorldPos.x, iWorldPos.y, iWorldPos.z, 1.0);
@@ -223,6 +291,7 @@ namespace eXl
 
   void GfxSystem::SynchronizeTransforms()
   {
+    eXl_PROFILE_ZONE("GfxSystem::SynchronizeTransforms");
     m_Impl->m_Transforms.IterateOverDirtyTransforms([this](Mat4 const& iMat, ObjectHandle iObj)
     {
       if (m_Impl->m_ObjectToNode.size() > iObj.GetId()
@@ -295,6 +364,7 @@ namespace eXl
     m_Impl->m_Camera.viewInverseMatrix[3] = Vec4(iInfo.pos, 1);
 
     m_Impl->m_Camera.viewMatrix = inverse(m_Impl->m_Camera.viewInverseMatrix);
+    m_Impl->m_Frustum.emplace(m_Impl->m_Camera.projMatrix * m_Impl->m_Camera.viewMatrix);
 
     // Will work for ortho, but not persp.
     m_Impl->m_DebugDrawer->m_CurrentScreenSize = iInfo.displayedSize;
@@ -305,9 +375,18 @@ namespace eXl
 
   void GfxSystem::RenderFrame(float iDelta)
   {
+    OGLRenderContext renderContext(GetSemanticManager());
+    RenderFrame(iDelta, renderContext);
+  }
+
+  template <class Context>
+  void GfxSystem::RenderFrameImpl(float iDelta, Context& iCtx)
+  {
+    eXl_PROFILE_ZONE("GfxSystem::RenderFrame");
     if (!m_Impl->m_CameraBuffer)
     {
       m_Impl->m_CameraBuffer = OGLBuffer::CreateBuffer(OGLBufferUsage::UNIFORM_BUFFER, CameraMatrix::GetType()->GetSize(), nullptr);
+      m_Impl->m_CameraData.SetDataBuffer(OGLBaseAlgo::GetCameraUniform(), m_Impl->m_CameraBuffer);
     }
 
     m_Impl->m_Nodes.Iterate([&](Impl::RenderNodeHandle iNodeHandle, Impl::RenderNodeEntry& iNode)
@@ -318,33 +397,96 @@ namespace eXl
         }
       });
 
-    OGLDisplayList list(GetSemanticManager());
+    OGLDisplayList& list = m_Impl->m_DisplayList;
+
+    list.InitForPush();
 
     list.SetDefaultViewport(Zero<Vec2i>(), m_Impl->m_ViewportSize);
     list.SetDefaultDepth(true, true);
     list.SetDefaultScissor(Vec2i(0,0),Vec2i(-1,-1));
     list.SetDefaultBlend(true, OGLBlend::SRC_ALPHA, OGLBlend::ONE_MINUS_SRC_ALPHA);
 
-    list.InitForPush();
-
     list.Clear(0,true,true, m_Impl->m_ClearColor);
 
-    OGLShaderData camData;
     //camData.AddData(OGLBaseAlgo::GetCameraUniform(), &m_Impl->m_Camera);
     m_Impl->m_CameraBuffer->SetData(0, sizeof(m_Impl->m_Camera), &m_Impl->m_Camera);
-    camData.SetDataBuffer(OGLBaseAlgo::GetCameraUniform(), m_Impl->m_CameraBuffer);
 
-    list.PushData(&camData);
+    list.PushData(&m_Impl->m_CameraData);
 
     List<GfxComponent*> toDelete;
 
-    m_Impl->m_Nodes.Iterate([&](Impl::RenderNodeHandle, Impl::RenderNodeEntry& iNode)
     {
-      iNode.m_Node->Push(list, iDelta);
-    });
+      eXl_PROFILE_ZONE("GfxSystem::Push");
+      Vector<GfxRenderNode*>& nodes = m_Impl->m_PushNodes;
+      nodes.clear();
+      uint32_t numParallel = 0;
+      m_Impl->m_Nodes.Iterate([&](Impl::RenderNodeHandle, Impl::RenderNodeEntry& iNode)
+      {
+        nodes.push_back(iNode.m_Node.get());
+        numParallel += iNode.m_Node->CanPushInParallel() ? 1 : 0;
+      });
 
-    OGLRenderContext renderContext(GetSemanticManager());
-    list.Render(&renderContext);
+      JobSystem* jobs = GetWorld().GetJobSystem();
+      if (jobs == nullptr || numParallel < 2)
+      {
+        for (GfxRenderNode* node : nodes)
+        {
+          node->Push(list, iDelta);
+        }
+      }
+      else
+      {
+        // Every node records in its own sub-list, and they are merged in node order.
+        // The nodes that are not thread safe are pushed afterwards, from this thread.
+        Vector<UniquePtr<OGLDisplayList>>& subLists = m_Impl->m_SubLists;
+        while (subLists.size() < nodes.size())
+        {
+          subLists.push_back(std::make_unique<OGLDisplayList>(GetSemanticManager()));
+        }
+        for (uint32_t i = 0; i < nodes.size(); ++i)
+        {
+          list.InitSubList(*subLists[i]);
+        }
+
+        jobs->ParallelFor(0, nodes.size(), 1, [&](uint32_t iBegin, uint32_t iEnd, uint32_t)
+        {
+          for (uint32_t i = iBegin; i < iEnd; ++i)
+          {
+            if (nodes[i]->CanPushInParallel())
+            {
+              nodes[i]->Push(*subLists[i], iDelta);
+            }
+          }
+        });
+        for (uint32_t i = 0; i < nodes.size(); ++i)
+        {
+          if (!nodes[i]->CanPushInParallel())
+          {
+            nodes[i]->Push(*subLists[i], iDelta);
+          }
+        }
+
+        for (uint32_t i = 0; i < nodes.size(); ++i)
+        {
+          list.Merge(*subLists[i]);
+        }
+      }
+    }
+
+    eXl_PROFILE_ZONE("OGLDisplayList::Render");
+    uint32_t const prevDraws = iCtx.GetNumDraws();
+    list.Render(&iCtx);
+    eXl_PROFILE_COUNTER("Draw calls", iCtx.GetNumDraws() - prevDraws);
+  }
+
+  void GfxSystem::RenderFrame(float iDelta, OGLRenderContext& iCtx)
+  {
+    RenderFrameImpl(iDelta, iCtx);
+  }
+
+  void GfxSystem::RenderFrame(float iDelta, OGLRecordingContext& iCtx)
+  {
+    RenderFrameImpl(iDelta, iCtx);
   }
 
   GfxRenderNodeHandle GfxSystem::AddRenderNode(UniquePtr<GfxRenderNode> iNode)
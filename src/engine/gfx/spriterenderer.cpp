@@ -1,6 +1,8 @@
 #include <engine/gfx/spriterenderer.hpp>
+#include <engine/gfx/gfxspatialindex.hpp>
 
 #include <ogl/renderer/oglcompiledprogram.hpp>
+#include <ogl/renderer/ogldisplaylist.hpp>
 #include <ogl/oglutils.hpp>
 
 #define VALIDATE_FLOAT(floatValue) eXl_ASSERT(!std::isnan(floatValue) && std::isfinite(floatValue));
@@ -11,8 +13,10 @@ namespace eXl
     : m_SpriteDescView(iSpriteDescView)
     , m_SpriteData(iSpriteData)
     , m_Transforms(iSys.GetTransforms())
+    , m_Index(iSys.GetSpriteIndex())
   {
     m_SpriteProgram.reset(OGLSpriteAlgo::CreateSpriteProgram(iSys.GetSemanticManager()));
+    m_InstancedSpriteProgram.reset(OGLSpriteAlgo::CreateInstancedSpriteProgram(iSys.GetSemanticManager()));
   }
 
   SpriteRenderer::~SpriteRenderer() = default;
@@ -31,6 +35,7 @@ namespace eXl
       if (descData == nullptr)
       {
         m_SpriteData.Erase(obj);
+        m_Index.Remove(obj);
         continue;
       }
 
@@ -154,11 +159,44 @@ namespace eXl
       data.m_SpriteInfo.tcOffset = Vec2(tileOffset.x * texStep.x, tileOffset.y * texStep.y);
       data.m_SpriteInfo.tcScaling = Vec2(tileSize.x * texStep.x, tileSize.y * texStep.y);
       data.m_SpriteInfo.imageSize = Vec2(imageSize);
+
+      UpdateBounds(obj, data, *descData);
     }
     m_DirtyComponents.clear();
   }
 
+  void SpriteRenderer::UpdateBounds(ObjectHandle iObject, GfxSpriteData const& iData, GfxSpriteComponent::Desc const& iDesc)
+  {
+    // Standing sprites have their top edge raised to z = 1, see MakeSpriteGeometry.
+    GfxBounds const localBounds = GfxBounds::FromBox(AABB2Df::FromCenterAndSize(Zero<Vec2>(), iDesc.m_Size), 0, iDesc.m_Flat ? 0 : 1);
+    m_Index.Update(iObject, GfxSpatialIndex::TransformBox(iData.m_Billboard ? iData.m_BillboardTransform : iData.m_Transform, localBounds));
+  }
+
   void SpriteRenderer::TickAnimation(ObjectHandle object, GfxSpriteData& data, float iDelta)
+  {
+    if (!data.m_Texture || data.m_RemainingTime <= 0.0)
+    {
+      return;
+    }
+
+    // The desc is only looked up when the current frame expires.
+    if (data.m_RemainingTime - iDelta > 0)
+    {
+      data.m_RemainingTime -= iDelta;
+      return;
+    }
+
+    if (GfxSpriteComponent::Desc const* descData = m_SpriteDescView.GetConst(object))
+    {
+      TickAnimation(data, *descData, iDelta);
+    }
+    else
+    {
+      data.m_RemainingTime -= iDelta;
+    }
+  }
+
+  void SpriteRenderer::TickAnimation(GfxSpriteData& data, GfxSpriteComponent::Desc const& iDesc, float iDelta)
   {
     if (!data.m_Texture)
     {
@@ -170,11 +208,7 @@ namespace eXl
       data.m_RemainingTime -= iDelta;
       if (data.m_RemainingTime <= 0)
       {
-        GfxSpriteComponent::Desc const* descData = m_SpriteDescView.GetConst(object);
-        if (descData == nullptr)
-        {
-          return;
-        }
+        GfxSpriteComponent::Desc const* descData = &iDesc;
 
         Tileset const* tileset = descData->m_Tileset.Get();
         Tile const* tile = tileset->Find(descData->m_TileName);
@@ -239,8 +273,94 @@ namespace eXl
             data->m_Transform = translate(Identity<Mat4>(), Vec3((**iTransforms)[3]) + Vec3(descData->m_Offset + data->m_CurOffset, 0));
           }
           data->m_Transform = scale(data->m_Transform, Vec3(data->m_CurScale, 1));
+          UpdateBounds(*iObjects, *data, *descData);
         }
       }
     }
   }
-}
\ No newline at end of file
+
+  void SpriteRenderer::ClearInstances()
+  {
+    m_BatchMap.clear();
+    m_Batches.clear();
+    m_BatchedSprites.clear();
+    m_BatchedSpritesBatch.clear();
+  }
+
+  void SpriteRenderer::AddInstance(GfxSpriteData const& iData)
+  {
+    InstanceBatchKey key;
+    key.m_Texture = iData.m_Texture.get();
+    key.m_Geometry = iData.m_Geometry.get();
+    key.m_Layer = iData.m_Layer;
+
+    auto insertRes = m_BatchMap.insert(std::make_pair(key, (uint32_t)m_Batches.size()));
+    if (insertRes.second)
+    {
+      InstanceBatch newBatch;
+      newBatch.m_Geometry = key.m_Geometry;
+      // All sprites of the batch share the texture, hence the image size used by the filter.
+      newBatch.m_TextureData = &iData.m_TextureData;
+      newBatch.m_Offset = 0;
+      newBatch.m_Count = 0;
+      newBatch.m_Layer = key.m_Layer;
+      m_Batches.emplace_back(std::move(newBatch));
+    }
+    uint32_t batchIdx = insertRes.first->second;
+    ++m_Batches[batchIdx].m_Count;
+    m_BatchedSprites.push_back(&iData);
+    m_BatchedSpritesBatch.push_back(batchIdx);
+  }
+
+  void SpriteRenderer::PushInstances(OGLDisplayList& iList, uint16_t iKey)
+  {
+    if (m_BatchedSprites.empty())
+    {
+      return;
+    }
+
+    uint32_t curOffset = 0;
+    for (auto& batch : m_Batches)
+    {
+      batch.m_Offset = curOffset;
+      curOffset += batch.m_Count;
+      batch.m_Count = 0;
+    }
+
+    m_Instances.resize(m_BatchedSprites.size());
+    for (uint32_t i = 0; i < m_BatchedSprites.size(); ++i)
+    {
+      GfxSpriteData const& data = *m_BatchedSprites[i];
+      InstanceBatch& batch = m_Batches[m_BatchedSpritesBatch[i]];
+      SpriteInstance& instance = m_Instances[batch.m_Offset + batch.m_Count++];
+      instance.worldMatrix = data.m_Billboard ? data.m_BillboardTransform : data.m_Transform;
+      instance.tcOffsetScaling = Vec4(data.m_SpriteInfo.tcOffset, data.m_SpriteInfo.tcScaling);
+      instance.tint = data.m_SpriteInfo.tint;
+      instance.alphaMult = data.m_SpriteInfo.alphaMult;
+    }
+
+    size_t const dataSize = m_Instances.size() * sizeof(SpriteInstance);
+    if (m_InstanceBuffer == nullptr || m_InstanceBuffer->GetBufferSize() < dataSize)
+    {
+      size_t bufferSize = m_InstanceBuffer == nullptr ? dataSize : std::max(dataSize, m_InstanceBuffer->GetBufferSize() * 2);
+      m_InstanceBuffer = OGLBuffer::CreateBuffer(OGLBufferUsage::ARRAY_BUFFER, bufferSize, nullptr);
+    }
+    m_InstanceBuffer->SetData(0, dataSize, m_Instances.data());
+
+    iList.SetProgram(m_InstancedSpriteProgram.get());
+    for (auto& batch : m_Batches)
+    {
+      batch.m_Assembly = batch.m_Geometry->m_Assembly;
+      OGLSpriteAlgo::AddInstanceAttribs(batch.m_Assembly, m_InstanceBuffer.get(), batch.m_Offset * sizeof(SpriteInstance));
+
+      iList.SetVAssembly(&batch.m_Assembly);
+      iList.PushData(batch.m_TextureData);
+#ifndef __ANDROID__
+      iList.PushDrawInstanced(iKey + batch.m_Layer, OGLDraw::TriangleList, 6, 0, 0, batch.m_Count, 0);
+#else
+      iList.PushDrawInstanced(iKey + batch.m_Layer, OGLDraw::TriangleList, 6, 0, 0, batch.m_Count);
+#endif
+      iList.PopData();
+    }
+  }
+}
@@ -197,6 +197,8 @@ namespace eXl
 
   void Tileset::PostLoad()
   {
+    m_TilesFrozen = !!m_FrozenTiles.Freeze(m_Tiles);
+
 #ifndef EXL_IS_BAKED_PLATFORM
     Path rscPath = ResourceManager::GetPath(GetHeader().m_ResourceId);
     Path rscDir = rscPath.parent_path();
@@ -302,6 +304,8 @@ namespace eXl
     }
 
     m_Tiles.insert_or_assign(iName, iTile);
+    m_FrozenTiles.Clear();
+    m_TilesFrozen = false;
 
     return Err::Success;
   }
@@ -310,6 +314,8 @@ namespace eXl
   void Tileset::RemoveTile(TileName iName)
   {
     m_Tiles.erase(iName);
+    m_FrozenTiles.Clear();
+    m_TilesFrozen = false;
   }
 
   Image const* Tileset::GetImage(ImageName iImage) const
@@ -406,6 +412,8 @@ namespace eXl
 
   Err Tileset::Unstream_Data(Unstreamer& iStreamer)
   {
+    m_FrozenTiles.Clear();
+    m_TilesFrozen = false;
     return Serialize(Serializer(iStreamer));
   }
 
@@ -205,10 +205,32 @@ namespace eXl
       return s_Holder.m_Library;
     }
 
+    static uint64_t GlyphKey(uint32_t iChar, uint32_t iSize)
+    {
+      return (uint64_t(iSize) << 32) | iChar;
+    }
+
+    static uint64_t KerningKey(uint32_t iLeft, uint32_t iRight, uint32_t iSize)
+    {
+      return (uint64_t(iSize) << 42) | (uint64_t(iLeft & 0x1FFFFF) << 21) | (iRight & 0x1FFFFF);
+    }
+
+    void SetSize(uint32_t iSize)
+    {
+      if (m_CurSize != iSize)
+      {
+        FT_Set_Pixel_Sizes(m_Face, 0, iSize);
+        m_CurSize = iSize;
+      }
+    }
+
     FT_Face m_Face;
+    uint32_t m_CurSize = 0;
     UniquePtr<InputStream> m_FileHandle;
-    UnorderedMap<uint32_t, Font::GlyphDesc> m_GlyphMap;
+    Vector<uint8_t> m_Bitmap;
 #endif
+    UnorderedMap<uint64_t, Font::GlyphDesc> m_GlyphMap;
+    UnorderedMap<uint64_t, int32_t> m_KerningMap;
   };
 
   void FontResource::PostLoad()
@@ -250,13 +272,7 @@ namespace eXl
   Font::GlyphDesc FontResource::RenderGlyph(uint32_t iChar, uint32_t iSize, RenderCallback iRender) const
   {
 #ifdef EXL_WITH_OGL
-    auto iter = m_Impl->m_GlyphMap.find(iChar);
-    if (iter != m_Impl->m_GlyphMap.end() && !iRender)
-    {
-      return iter->second;
-    }
-
-    FT_Set_Pixel_Sizes(m_Impl->m_Face, 0, iSize);
+    m_Impl->SetSize(iSize);
     FT_UInt charIndex = FT_Get_Char_Index(m_Impl->m_Face, iChar);
     FT_Load_Glyph(m_Impl->m_Face, charIndex, FT_LOAD_DEFAULT);
     if (m_Impl->m_Face->glyph->format != FT_GLYPH_FORMAT_BITMAP)
@@ -268,17 +284,25 @@ namespace eXl
     newDesc.penAdvance = Vec2i(m_Impl->m_Face->glyph->advance.x >> 6, m_Impl->m_Face->glyph->advance.y >> 6);
     newDesc.glyphSize = Vec2i(m_Impl->m_Face->glyph->bitmap.width, m_Impl->m_Face->glyph->bitmap.rows);
 
-    if (iter == m_Impl->m_GlyphMap.end())
-    {
-      m_Impl->m_GlyphMap.insert(std::make_pair(iChar, newDesc));
-    }
+    m_Impl->m_GlyphMap[Impl::GlyphKey(iChar, iSize)] = newDesc;
 
-    if (iRender)
+    if (iRender && newDesc.glyphSize.x > 0 && newDesc.glyphSize.y > 0)
     {
       FT_Bitmap& bitmap = m_Impl->m_Face->glyph->bitmap;
       if (bitmap.pixel_mode == FT_PIXEL_MODE_GRAY)
       {
-        iRender(newDesc, bitmap.buffer);
+        uint8_t const* pixels = bitmap.buffer;
+        if (bitmap.pitch != int(bitmap.width))
+        {
+          // Repack the rows tightly.
+          m_Impl->m_Bitmap.resize(bitmap.width * bitmap.rows);
+          for (uint32_t i = 0; i < bitmap.rows; ++i)
+          {
+            memcpy(m_Impl->m_Bitmap.data() + i * bitmap.width, bitmap.buffer + int(i) * bitmap.pitch, bitmap.width);
+          }
+          pixels = m_Impl->m_Bitmap.data();
+        }
+        iRender(newDesc, pixels);
       }
       else
       {
@@ -289,6 +313,54 @@ namespace eXl
     return newDesc;
 #else
     return Font::GlyphDesc();
+#endif
+  }
+
+  Font::GlyphDesc const* FontResource::FindGlyphDesc(uint32_t iChar, uint32_t iSize) const
+  {
+    auto iter = m_Impl->m_GlyphMap.find(Impl::GlyphKey(iChar, iSize));
+    if (iter != m_Impl->m_GlyphMap.end())
+    {
+      return &iter->second;
+    }
+    return nullptr;
+  }
+
+  Font::GlyphDesc FontResource::GetGlyphDesc(uint32_t iChar, uint32_t iSize) const
+  {
+    if (Font::GlyphDesc const* desc = FindGlyphDesc(iChar, iSize))
+    {
+      return *desc;
+    }
+    return RenderGlyph(iChar, iSize);
+  }
+
+  int32_t FontResource::GetKerning(uint32_t iLeft, uint32_t iRight, uint32_t iSize) const
+  {
+#ifdef EXL_WITH_OGL
+    if (!FT_HAS_KERNING(m_Impl->m_Face))
+    {
+      return 0;
+    }
+
+    uint64_t const key = Impl::KerningKey(iLeft, iRight, iSize);
+    auto iter = m_Impl->m_KerningMap.find(key);
+    if (iter != m_Impl->m_KerningMap.end())
+    {
+      return iter->second;
+    }
+
+    m_Impl->SetSize(iSize);
+    FT_Vector kerning;
+    FT_Get_Kerning(m_Impl->m_Face,
+      FT_Get_Char_Index(m_Impl->m_Face, iLeft),
+      FT_Get_Char_Index(m_Impl->m_Face, iRight),
+      FT_KERNING_DEFAULT, &kerning);
+    int32_t const offset = kerning.x >> 6;
+    m_Impl->m_KerningMap.insert(std::make_pair(key, offset));
+    return offset;
+#else
+    return 0;
 #endif
   }
 }
\ No newline at end of file
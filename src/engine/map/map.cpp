@@ -15,6 +15,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <core/resource/resourcemanager.hpp>
 #include <math/mathtools.hpp>
 #include <engine/game/commondef.hpp>
+#include <core/thread/jobsystem.hpp>
 
 namespace eXl
 {
@@ -22,6 +23,9 @@ namespace eXl
   IMPLEMENT_SERIALIZE_METHODS(MapResource::Object);
   IMPLEMENT_SERIALIZE_METHODS(MapResource::Terrain::Block);
   IMPLEMENT_SERIALIZE_METHODS(MapResource::Terrain);
+  IMPLEMENT_SERIALIZE_METHODS(MapResource::Collision);
+  IMPLEMENT_SERIALIZE_METHODS(MapResource::TerrainBatch);
+  IMPLEMENT_SERIALIZE_METHODS(MapResource::Chunk);
 
   static TerrainType WallType()
   {
@@ -113,6 +117,77 @@ namespace eXl
     return Err::Success;
   }
 
+  Err MapResource::Collision::Serialize(Serializer iStreamer)
+  {
+    iStreamer.BeginStruct();
+    iStreamer.PushKey("Terrain");
+    iStreamer &= m_Type;
+    iStreamer.PopKey();
+    iStreamer.PushKey("Shapes");
+    iStreamer &= m_Shapes;
+    iStreamer.PopKey();
+    iStreamer.EndStruct();
+
+    return Err::Success;
+  }
+
+  Err MapResource::TerrainBatch::Serialize(Serializer iStreamer)
+  {
+    iStreamer.BeginStruct();
+    iStreamer.PushKey("Layer");
+    iStreamer &= m_Layer;
+    iStreamer.PopKey();
+    iStreamer.PushKey("Tileset");
+    iStreamer &= m_Tileset;
+    iStreamer.PopKey();
+    iStreamer.PushKey("Image");
+    iStreamer &= m_Image;
+    iStreamer.PopKey();
+    iStreamer.PushKey("VtxScaling");
+    iStreamer &= m_VtxScaling;
+    iStreamer.PopKey();
+    iStreamer.PushKey("VtxOffset");
+    iStreamer &= m_VtxOffset;
+    iStreamer.PopKey();
+    iStreamer.PushKey("Tiling");
+    iStreamer &= m_Tiling;
+    iStreamer.PopKey();
+    iStreamer.PushKey("Vertices");
+    iStreamer &= m_Vertices;
+    iStreamer.PopKey();
+    iStreamer.EndStruct();
+
+    return Err::Success;
+  }
+
+  Err MapResource::Chunk::Serialize(Serializer iStreamer)
+  {
+    iStreamer.BeginStruct();
+    iStreamer.PushKey("Coords");
+    iStreamer &= m_Coords;
+    iStreamer.PopKey();
+    iStreamer.PushKey("Tiles");
+    iStreamer &= m_Tiles;
+    iStreamer.PopKey();
+    iStreamer.PushKey("Terrain");
+    iStreamer &= m_Terrains;
+    iStreamer.PopKey();
+    if (iStreamer.PushKey("TerrainBatches"))
+    {
+      iStreamer &= m_TerrainBatches;
+      iStreamer.PopKey();
+    }
+    iStreamer.PushKey("Collision");
+    iStreamer &= m_Collision;
+    iStreamer.PopKey();
+    iStreamer.PushKey("Objects");
+    iStreamer &= m_Objects;
+    iStreamer.PopKey();
+    iStreamer.EndStruct();
+
+    return Err::Success;
+  }
+
 #if 0
 
   class MapLoader : public ResourceLoader
@@ -159,7 +234,35 @@ namespace eXl
   };
 #endif
 
-  using MapLoader = TResourceLoader<MapResource, ResourceLoader>;
+  class MapLoader : public TResourceLoader<MapResource, ResourceLoader>
+  {
+  public:
+
+    static MapLoader& Get()
+    {
+      static MapLoader s_This;
+      return s_This;
+    }
+
+    bool NeedsBaking(Resource* iRsc) const override
+    {
+      return true;
+    }
+
+    MapResource* CreateBakedResource(Resource* iRsc) const override
+    {
+      MapResource* mapToBake = MapResource::DynamicCast(iRsc);
+      MapResource* bakedMap = eXl_NEW MapResource(*CreateBakedMetaData(iRsc->GetMetaData()));
+
+      bakedMap->m_Tiles = mapToBake->m_Tiles;
+      bakedMap->m_Terrains = mapToBake->m_Terrains;
+      bakedMap->m_Objects = mapToBake->m_Objects;
+      bakedMap->BuildChunks(MapResource::s_DefaultChunkSize);
+      bakedMap->BakeTerrainGfx(&JobSystem::GetDefault());
+
+      return bakedMap;
+    }
+  };
 
   void MapResource::Init()
   {
@@ -213,6 +316,20 @@ namespace eXl
       });
     iStreamer.PopKey();
 
+    if (iStreamer.IsReading() || m_ChunkSize > 0)
+    {
+      if (iStreamer.PushKey("ChunkSize"))
+      {
+        iStreamer &= m_ChunkSize;
+        iStreamer.PopKey();
+      }
+      if (iStreamer.PushKey("Chunks"))
+      {
+        iStreamer &= m_Chunks;
+        iStreamer.PopKey();
+      }
+    }
+
     iStreamer.EndStruct();
 
     return Err::Success;
@@ -8,6 +8,7 @@ The above copyright notice and this permission notice shall be included in all c
 THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
+
 #include <engine/map/map.hpp>
 
 #include <math/mathtools.hpp>
@@ -19,28 +20,67 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <engine/physics/physicsys.hpp>
 #include <engine/pathfinding/navmesh.hpp>
 #include <engine/pathfinding/navigator.hpp>
+#include <core/thread/jobsystem.hpp>
 
 namespace eXl
 {
-  MapResource::InstanceData MapResource::Instantiate(World& iWorld, Mat4 const& iPos) const
+  using TerrainShapes = UnorderedMap<TerrainTypeName, Vector<AABB2DPolygoni>>;
+
+  // Terrain blocks around a chunk are kept with this margin, in tiling units, for the tiling patterns.
+  static constexpr int32_t s_ChunkTilingMargin = 2;
+
+  static int32_t FloorDiv(int32_t iVal, int32_t iDiv)
   {
-    InstanceData allObjects;
+    return iVal >= 0 ? iVal / iDiv : -((-iVal + iDiv - 1) / iDiv);
+  }
 
-    Transforms* trans = iWorld.GetSystem<Transforms>();
-    GameDatabase* database = iWorld.GetSystem<GameDatabase>();
-    eXl_ASSERT_REPAIR_RET(trans != nullptr, allObjects);
-    eXl_ASSERT_REPAIR_RET(database != nullptr, allObjects);
+  // Size in pixels of a terrain block unit, ie. the group's default tile.
+  static Vec2i GetTilingSize(TilingGroup const* iGroup)
+  {
+    if (iGroup != nullptr)
+    {
+      if (Tileset const* groupTileset = iGroup->GetTileset().GetOrLoad())
+      {
+        if (Tile const* tile = groupTileset->Find(iGroup->m_DefaultTile))
+        {
+          return tile->m_Size;
+        }
+      }
+    }
+    return One<Vec2i>() * EngineCommon::s_WorldToPixel;
+  }
 
-    GfxSystem* gfx = iWorld.GetSystem<GfxSystem>();
+  static void AddTerrainShapes(Vector<MapResource::Terrain> const& iTerrains, TerrainShapes& ioShapes)
+  {
+    for (auto const& terrainItem : iTerrains)
+    {
+      Vec2i tilingSize = GetTilingSize(terrainItem.m_TilingGroup.GetOrLoad());
+      auto insertRes = ioShapes.insert(std::make_pair(terrainItem.m_Type, Vector<AABB2DPolygoni>()));
+      auto& blocks = insertRes.first->second;
+      for (auto const& terrainBlock : terrainItem.m_Blocks)
+      {
+        blocks.push_back(terrainBlock.m_Shape);
+        blocks.back().ScaleComponents(tilingSize.x, tilingSize.y, 1, 1);
+      }
+    }
+  }
 
-    Vector<MapTiler::Batcher> tilesByLayer;
+  static void AddTileShape(MapResource::PlacedTiles const& iTiles, MapResource::PlacedTiles::Tile const& iTile, Tile const& iTileDesc, TerrainShapes& ioShapes)
+  {
+    auto insertRes = ioShapes.insert(std::make_pair(iTiles.m_Type, Vector<AABB2DPolygoni>()));
+    AABB2Di tileBox = AABB2Di::FromMinAndSize(iTile.m_Position - iTileDesc.m_Size / 2, iTileDesc.m_Size);
+    insertRes.first->second.push_back(AABB2DPolygoni(tileBox));
+  }
+
+  // Tiles the terrain blocks, and crops the result to iClip when only part of the map is tiled.
+  static void TileTerrain(Vector<MapResource::Terrain> const& iTerrains, AABB2Df const* iClip, JobSystem* iJobs,
+    Vector<MapTiler::Batcher>& oLayers)
+  {
     Vector<UnorderedMap<TilingGroup const*, MapTiler::Blocks>> blocksByLayer;
-    UnorderedMap<TerrainTypeName, Vector<AABB2DPolygoni>> components;
     AABB2Di fullSize;
 
-    for (auto const& terrainItem : m_Terrains)
+    for (auto const& terrainItem : iTerrains)
     {
-      Vec2i tilingSize = One<Vec2i>() * EngineCommon::s_WorldToPixel;
       TilingGroup const* group = terrainItem.m_TilingGroup.GetOrLoad();
       if (group != nullptr)
       {
@@ -50,10 +90,12 @@ namespace eXl
           Tile const* tile = groupTileset->Find(group->m_DefaultTile);
           if (tile != nullptr)
           {
-            tilingSize = tile->m_Size;
             for (auto const& terrainBlock : terrainItem.m_Blocks)
             {
-              blocksByLayer.resize(terrainBlock.m_Layer + 1);
+              if (blocksByLayer.size() <= terrainBlock.m_Layer)
+              {
+                blocksByLayer.resize(terrainBlock.m_Layer + 1);
+              }
               auto& curLayer = blocksByLayer[terrainBlock.m_Layer];
               auto iter = curLayer.insert(std::make_pair(group, MapTiler::Blocks())).first;
               MapTiler::Blocks& block = iter->second;
@@ -83,305 +125,435 @@ namespace eXl
       {
         LOG_ERROR << "Could not load tilegorup " << terrainItem.m_TilingGroup.GetUUID().ToString();
       }
+    }
 
-      Vec2 worldScaling(tilingSize.x / EngineCommon::s_WorldToPixel, tilingSize.y / EngineCommon::s_WorldToPixel);
-      auto insertRes = components.insert(std::make_pair(terrainItem.m_Type, Vector<AABB2DPolygoni>()));
-      auto& blocks = insertRes.first->second;
-      for (auto const& terrainBlock : terrainItem.m_Blocks)
+    if (fullSize.Empty())
+    {
+      return;
+    }
+
+    fullSize.m_Data[0] -= One<Vec2i>();
+    fullSize.m_Data[1] += One<Vec2i>();
+
+    Vector<Vector<MapTiler::Blocks const*>> blockList(blocksByLayer.size());
+    for (uint32_t layerIdx = 0; layerIdx < blocksByLayer.size(); ++layerIdx)
+    {
+      for (auto const& blockEntry : blocksByLayer[layerIdx])
       {
-        blocks.push_back(terrainBlock.m_Shape);
-        blocks.back().ScaleComponents(tilingSize.x, tilingSize.y, 1, 1);
+        blockList[layerIdx].push_back(&blockEntry.second);
       }
-        //auto insertRes = physicLayer.insert(std::make_pair(terrainItem.m_Type, PhysicInitData()));
-        //PhysicInitData& phData = insertRes.first->second;
-        //if (insertRes.second)
-        //{
-        //  phData.SetCategory(terrainDesc.m_PhysicCategory, terrainDesc.m_PhysicFilter);
-        //  phData.SetFlags(EngineCommon::s_BasePhFlags | PhysicFlags::Static);
-        //}
-        //for (auto const& terrainBlock : terrainItem.m_Blocks)
-        //{
-        //  Vector<AABB2Di> blockBoxes;
-        //  terrainBlock.m_Shape.GetBoxes(blockBoxes);
-        //
-        //  for (unsigned int j = 0; j < blockBoxes.size(); ++j)
-        //  {
-        //    Vec2i origi(blockBoxes[j].m_Data[0] + blockBoxes[j].m_Data[1]);
-        //    Vec2i sizei(blockBoxes[j].m_Data[1] - blockBoxes[j].m_Data[0]);
-        //    Vec3 orig((float)origi.x() * 0.5f * worldScaling.x()
-        //      , (float)origi.y() * 0.5f * worldScaling.y()
-        //      , terrainDesc.m_Altitude + terrainDesc.m_Height * 0.5f);
-        //    Vec3 size(sizei.x() * worldScaling.x(), sizei.y() * worldScaling.y(), terrainDesc.m_Height);
-        //    phData.AddBox(size, orig + MathTools::GetPosition(iPos));
-        //  }
-        //}
-        
-    }
-
-    if (!fullSize.Empty())
-    {
-      fullSize.m_Data[0] -= One<Vec2i>();
-      fullSize.m_Data[1] += One<Vec2i>();
-      if (gfx != nullptr)
-      {
-        for (uint32_t layerIdx = 0; layerIdx < blocksByLayer.size(); ++layerIdx)
-        {
-          MapTiler::Batcher batcher;
-          auto const& layer = blocksByLayer[layerIdx];
-          for (auto& blockEntry : layer)
-          {
-            MapTiler::ComputeGfxForBlock(batcher, fullSize, blockEntry.second);
-          }
-          ObjectHandle layerView = iWorld.CreateObject();
-          allObjects.terrain.push_back(layerView);
-          trans->AddTransform(layerView, iPos);
-          batcher.Finalize(*gfx, layerView, layerIdx);
-        }
+    }
+
+    MapTiler::ComputeGfxForLayers(oLayers, fullSize, blockList, iJobs);
+    if (iClip != nullptr)
+    {
+      for (auto& layer : oLayers)
+      {
+        layer.Clip(*iClip);
       }
     }
+  }
 
-    for (auto const& tiles : m_Tiles)
+  static void AddBakedBatches(Vector<MapResource::TerrainBatch> const& iBatches, Vector<MapTiler::Batcher>& oLayers)
+  {
+    for (auto const& batch : iBatches)
     {
-      Tileset const* tileset = tiles.m_Tileset.GetOrLoad();
-      if (tileset != nullptr)
+      MapTiler::TexGroup texGroup;
+      texGroup.m_Tileset = batch.m_Tileset.GetOrLoad();
+      if (texGroup.m_Tileset == nullptr)
       {
-        for (auto const& tile : tiles.m_Tiles)
-        {
-          Tile const* tileDesc = tileset->Find(tile.m_Name);
-          if (tileDesc != nullptr)
-          {
-            Vec2 tilePos = MathTools::ToFVec(tile.m_Position) / EngineCommon::s_WorldToPixel;
-            Vec2 phSize = MathTools::ToFVec(tileDesc->m_Size) / EngineCommon::s_WorldToPixel;
+        LOG_ERROR << "Could not load tileset " << batch.m_Tileset.GetUUID().ToString();
+        continue;
+      }
+      texGroup.m_Name = batch.m_Image;
+      texGroup.m_VtxScaling = batch.m_VtxScaling;
+      texGroup.m_VtxOffset = batch.m_VtxOffset;
+      texGroup.m_Tiling = batch.m_Tiling;
 
-            auto insertRes = components.insert(std::make_pair(tiles.m_Type, Vector<AABB2DPolygoni>()));
-            auto& blocks = insertRes.first->second;
-            AABB2Di tileBox = AABB2Di::FromMinAndSize(tile.m_Position - tileDesc->m_Size / 2, tileDesc->m_Size);
-            blocks.push_back(AABB2DPolygoni(tileBox));
+      if (oLayers.size() <= batch.m_Layer)
+      {
+        oLayers.resize(batch.m_Layer + 1);
+      }
+      Vector<float>& vertices = oLayers[batch.m_Layer].GetGroup(texGroup);
+      vertices.insert(vertices.end(), batch.m_Vertices.begin(), batch.m_Vertices.end());
+    }
+  }
 
-            TerrainType terrainDesc = TerrainType::GetTerrainTypeFromName(tiles.m_Type);
-            
-            if (gfx != nullptr)
-            {
-              if (tileDesc->m_Frames.size() == 1)
-              {
-                MapTiler::TexGroup texGroup;
-                texGroup.m_Name = tileDesc->m_ImageName;
-                texGroup.m_Tileset = tileset;
-
-                Vec2i imgSize = tileset->GetImageSize(tileDesc->m_ImageName);
-                Vec2i tileOffset = tileDesc->m_Frames.size() > 0 ? tileDesc->m_Frames[0] : Zero<Vec2i>();
-                Vec2 scale(float(tileDesc->m_Size.x) / imgSize.x, float(tileDesc->m_Size.y) / imgSize.y);
-                Vec2 offset(float(tileOffset.x) / imgSize.x, float(tileOffset.y) / imgSize.y);
-
-                texGroup.m_VtxOffset = offset;
-                texGroup.m_VtxScaling = scale;
-                texGroup.m_Tiling = scale;
-
-                if (tilesByLayer.size() <= tile.m_Layer)
-                {
-                  tilesByLayer.resize(tile.m_Layer + 1);
-                }
-
-                Vector<float>& curGroup = tilesByLayer[tile.m_Layer].GetGroup(texGroup);
-
-                float vtxData[][5] =
-                {
-                  {-0.5, -0.5, 0.0, 0.0, 1.0},
-                  { 0.5, -0.5, 0.0, 1.0, 1.0},
-                  {-0.5,  0.5, 0.0, 0.0, 0.0},
-                  {-0.5,  0.5, 0.0, 0.0, 0.0},
-                  { 0.5, -0.5, 0.0, 1.0, 1.0},
-                  { 0.5,  0.5, 0.0, 1.0, 0.0},
-                };
-                for (auto const& vtx : vtxData)
-                {
-                  curGroup.push_back(phSize.x * vtx[0] + tilePos.x);
-                  curGroup.push_back(phSize.y * vtx[1] + tilePos.y);
-                  curGroup.push_back(vtx[2] + terrainDesc.m_Altitude);
-                  curGroup.push_back(vtx[3]);
-                  curGroup.push_back(vtx[4]);
-                }
-              }
-              else
-              {
-                ObjectHandle animatedSprite = iWorld.CreateObject();
-                allObjects.tiles.push_back(animatedSprite);
-                trans->AddTransform(animatedSprite, translate(iPos, Vec3(tilePos, 0)));
-                gfx->CreateSpriteComponent(animatedSprite);
-                GfxSpriteComponent::SetFlat(iWorld, animatedSprite, true);
-                GfxSpriteComponent::SetTileset(iWorld, animatedSprite, tileset);
-                GfxSpriteComponent::SetTileName(iWorld, animatedSprite, tile.m_Name);
-                GfxSpriteComponent::SetLayer(iWorld, animatedSprite, tile.m_Layer);
-              }
-            }
-          }
-          else
-          {
-            LOG_ERROR << "Could not find tile " << tile.m_Name << " in tileset " << tileset->GetName();
-          }
-        }
+  // Single frame tiles are batched by layer, animated ones get their own sprite.
+  static void AddTileGfx(World& iWorld, GfxSystem& iGfx, Transforms& iTrans, Mat4 const& iPos,
+    Tileset const* iTileset, MapResource::PlacedTiles::Tile const& iTile, Tile const& iTileDesc, TerrainTypeName iType,
+    Vector<MapTiler::Batcher>& ioTilesByLayer, Vector<ObjectHandle>& oObjects)
+  {
+    Vec2 tilePos = MathTools::ToFVec(iTile.m_Position) / EngineCommon::s_WorldToPixel;
+    Vec2 phSize = MathTools::ToFVec(iTileDesc.m_Size) / EngineCommon::s_WorldToPixel;
+
+    if (iTileDesc.m_Frames.size() == 1)
+    {
+      TerrainType terrainDesc = TerrainType::GetTerrainTypeFromName(iType);
+
+      MapTiler::TexGroup texGroup;
+      texGroup.m_Name = iTileDesc.m_ImageName;
+      texGroup.m_Tileset = iTileset;
+
+      Vec2i imgSize = iTileset->GetImageSize(iTileDesc.m_ImageName);
+      Vec2i tileOffset = iTileDesc.m_Frames.size() > 0 ? iTileDesc.m_Frames[0] : Zero<Vec2i>();
+      Vec2 scale(float(iTileDesc.m_Size.x) / imgSize.x, float(iTileDesc.m_Size.y) / imgSize.y);
+      Vec2 offset(float(tileOffset.x) / imgSize.x, float(tileOffset.y) / imgSize.y);
+
+      texGroup.m_VtxOffset = offset;
+      texGroup.m_VtxScaling = scale;
+      texGroup.m_Tiling = scale;
+
+      if (ioTilesByLayer.size() <= iTile.m_Layer)
+      {
+        ioTilesByLayer.resize(iTile.m_Layer + 1);
       }
-      else
+
+      Vector<float>& curGroup = ioTilesByLayer[iTile.m_Layer].GetGroup(texGroup);
+
+      float vtxData[][5] =
       {
-        LOG_ERROR << "Could not load tileset " << tiles.m_Tileset.GetUUID().ToString();
+        {-0.5, -0.5, 0.0, 0.0, 1.0},
+        { 0.5, -0.5, 0.0, 1.0, 1.0},
+        {-0.5,  0.5, 0.0, 0.0, 0.0},
+        {-0.5,  0.5, 0.0, 0.0, 0.0},
+        { 0.5, -0.5, 0.0, 1.0, 1.0},
+        { 0.5,  0.5, 0.0, 1.0, 0.0},
+      };
+      for (auto const& vtx : vtxData)
+      {
+        curGroup.push_back(phSize.x * vtx[0] + tilePos.x);
+        curGroup.push_back(phSize.y * vtx[1] + tilePos.y);
+        curGroup.push_back(vtx[2] + terrainDesc.m_Altitude);
+        curGroup.push_back(vtx[3]);
+        curGroup.push_back(vtx[4]);
       }
     }
+    else
+    {
+      ObjectHandle animatedSprite = iWorld.CreateObject();
+      oObjects.push_back(animatedSprite);
+      iTrans.AddTransform(animatedSprite, translate(iPos, Vec3(tilePos, 0)));
+      iGfx.CreateSpriteComponent(animatedSprite);
+      GfxSpriteComponent::SetFlat(iWorld, animatedSprite, true);
+      GfxSpriteComponent::SetTileset(iWorld, animatedSprite, iTileset);
+      GfxSpriteComponent::SetTileName(iWorld, animatedSprite, iTile.m_Name);
+      GfxSpriteComponent::SetLayer(iWorld, animatedSprite, iTile.m_Layer);
+    }
+  }
 
-    allObjects.objects.reserve(m_Objects.size());
-    for (auto const& object : m_Objects)
+  static void FinalizeLayers(World& iWorld, GfxSystem& iGfx, Transforms& iTrans, Mat4 const& iPos,
+    Vector<MapTiler::Batcher>& ioLayers, Vector<ObjectHandle>& oObjects)
+  {
+    for (uint32_t layerIdx = 0; layerIdx < ioLayers.size(); ++layerIdx)
     {
+      auto& layer = ioLayers[layerIdx];
+      ObjectHandle layerView = iWorld.CreateObject();
+      oObjects.push_back(layerView);
+      iTrans.AddTransform(layerView, iPos);
+      layer.Finalize(iGfx, layerView, layerIdx);
+    }
+  }
+
+  // Objects are all created before their archetypes are instantiated, so that they can reference each other.
+  static void CreateObjects(World& iWorld, Transforms* iTrans, Mat4 const& iPos,
+    Vector<MapResource::Object> const& iObjects, Vector<uint32_t> const* iIndices, Vector<ObjectHandle>& oObjects)
+  {
+    uint32_t const numObjects = iIndices ? iIndices->size() : iObjects.size();
+    size_t const firstObject = oObjects.size();
+    oObjects.reserve(firstObject + numObjects);
+    for (uint32_t i = 0; i < numObjects; ++i)
+    {
+      auto const& object = iObjects[iIndices ? (*iIndices)[i] : i];
       ObjectCreationInfo creationInfo;
       creationInfo.m_DisplayName = object.m_Header.m_DisplayName;
       creationInfo.m_PersistentId = object.m_Header.m_ObjectId;
 
       ObjectHandle newObject = iWorld.CreateObject(std::move(creationInfo));
-      allObjects.objects.push_back(newObject);
-      if (trans != nullptr)
+      oObjects.push_back(newObject);
+      if (iTrans != nullptr)
       {
-        trans->AddTransform(newObject, translate(iPos, object.m_Header.m_Position));
+        iTrans->AddTransform(newObject, translate(iPos, object.m_Header.m_Position));
       }
     }
 
-    for (uint32_t i = 0; i < m_Objects.size(); ++i)
+    for (uint32_t i = 0; i < numObjects; ++i)
     {
-      auto const& objectDesc = m_Objects[i];
-      ObjectHandle mapObject = allObjects.objects[i];
+      auto const& objectDesc = iObjects[iIndices ? (*iIndices)[i] : i];
       Archetype const* objArchetype = objectDesc.m_Header.m_Archetype.GetOrLoad();
       if (objArchetype != nullptr)
       {
-        objArchetype->Instantiate(mapObject, iWorld, &objectDesc.m_Data);
+        objArchetype->Instantiate(oObjects[firstObject + i], iWorld, &objectDesc.m_Data);
       }
       else
       {
         LOG_ERROR << "Archetype missing for object " << objectDesc.m_Header.m_DisplayName << ", id : " << objectDesc.m_Header.m_ObjectId;
       }
+    }
+  }
 
-      auto const* carver = database->GetData<EngineCommon::TerrainCarver>(mapObject, EngineCommon::TerrainCarver::PropertyName());
-      auto const* shapeDesc = database->GetData<EngineCommon::ObjectShapeData>(mapObject, EngineCommon::ObjectShapeData::PropertyName());
-      if (carver != nullptr && shapeDesc != nullptr)
+  static void CarveTerrain(TerrainShapes& ioShapes, TerrainTypeName iCarverType, EngineCommon::ObjectShapeData const& iShapeDesc, Vec3 const& iPos)
+  {
+    for (auto const& shape : iShapeDesc.m_Shapes)
+    {
+      Vec2i offset(shape.m_Offset.x * EngineCommon::s_WorldToPixel, shape.m_Offset.y * EngineCommon::s_WorldToPixel);
+      offset += MathTools::ToIVec(MathTools::As2DVec(iPos) * EngineCommon::s_WorldToPixel);
+      Vec2i size;
+      switch (shape.m_Type)
+      {
+      case EngineCommon::PhysicsShapeType::Box:
+        size = Vec2i(shape.m_Dims.x, shape.m_Dims.y) * EngineCommon::s_WorldToPixel;
+        break;
+      case EngineCommon::PhysicsShapeType::Sphere:
+        size = Vec2i(shape.m_Dims.x, shape.m_Dims.x) * EngineCommon::s_WorldToPixel;
+        break;
+      }
+      AABB2Di pixelBox = AABB2Di::FromMinAndSize(offset - size / 2, size);
+
+      Vector<AABB2DPolygoni> diffResult;
+      for (auto& entry : ioShapes)
       {
-        for (auto const& shape : shapeDesc->m_Shapes)
+        if (entry.first == iCarverType)
+        {
+          entry.second.push_back(AABB2DPolygoni(pixelBox));
+          continue;
+        }
+        Vector<AABB2DPolygoni> newComponents;
+        for (auto& poly : entry.second)
         {
-          Vec2i offset(shape.m_Offset.x * EngineCommon::s_WorldToPixel, shape.m_Offset.y * EngineCommon::s_WorldToPixel);
-          offset += MathTools::ToIVec(MathTools::As2DVec(objectDesc.m_Header.m_Position) * EngineCommon::s_WorldToPixel);
-          Vec2i size;
-          switch (shape.m_Type)
+          if (poly.GetAABB().Intersect(pixelBox))
           {
-          case EngineCommon::PhysicsShapeType::Box:
-            size = Vec2i(shape.m_Dims.x, shape.m_Dims.y) * EngineCommon::s_WorldToPixel;
-            break;
-          case EngineCommon::PhysicsShapeType::Sphere:
-            size = Vec2i(shape.m_Dims.x, shape.m_Dims.x) * EngineCommon::s_WorldToPixel;
-            break;
-          }
-          AABB2Di pixelBox = AABB2Di::FromMinAndSize(offset - size / 2, size);
+            diffResult.clear();
+            poly.Difference(pixelBox, diffResult);
 
-          Vector<AABB2DPolygoni> diffResult;
-          for (auto& entry : components)
-          {
-            if (entry.first == carver->m_TerrainType)
+            if (diffResult.size() == 0)
             {
-              entry.second.push_back(AABB2DPolygoni(pixelBox));
-              continue;
+              poly.Clear();
             }
-            Vector<AABB2DPolygoni> newComponents;
-            for (auto& poly : entry.second)
+            if (diffResult.size() == 1)
             {
-              if (poly.GetAABB().Intersect(pixelBox))
-              {
-                diffResult.clear();
-                poly.Difference(pixelBox, diffResult);
-
-                if (diffResult.size() == 0)
-                {
-                  poly.Clear();
-                }
-                if (diffResult.size() == 1)
-                {
-                  poly = std::move(diffResult[0]);
-                }
-                if (diffResult.size() > 1)
-                {
-                  poly.Clear();
-                  for (auto& newComps : diffResult)
-                  {
-                    newComponents.push_back(std::move(newComps));
-                  }
-                }
-              }
+              poly = std::move(diffResult[0]);
             }
-            for (int32_t i = 0; i < (int32_t)entry.second.size(); ++i)
+            if (diffResult.size() > 1)
             {
-              auto& poly = entry.second[i];
-              if (poly.Empty())
+              poly.Clear();
+              for (auto& newComps : diffResult)
               {
-                poly = std::move(entry.second.back());
-                entry.second.pop_back();
-                --i;
+                newComponents.push_back(std::move(newComps));
               }
             }
-            for (auto& newComp : newComponents)
-            {
-              entry.second.push_back(std::move(newComp));
-            }
           }
         }
+        for (int32_t i = 0; i < (int32_t)entry.second.size(); ++i)
+        {
+          auto& poly = entry.second[i];
+          if (poly.Empty())
+          {
+            poly = std::move(entry.second.back());
+            entry.second.pop_back();
+            --i;
+          }
+        }
+        for (auto& newComp : newComponents)
+        {
+          entry.second.push_back(std::move(newComp));
+        }
       }
     }
+  }
 
-    for (auto& entry : components)
+  static void AddTerrainPhysics(World& iWorld, PhysicsSystem& iPhysics, Transforms& iTrans, Mat4 const& iPos,
+    TerrainShapes const& iShapes, Vector<ObjectHandle>& oObjects, Vector<AABB2Di>& oObstacles)
+  {
+    for (auto const& entry : iShapes)
     {
-      AABB2DPolygoni::Merge(entry.second);
+      TerrainType terrainDesc = TerrainType::GetTerrainTypeFromName(entry.first);
+      if (terrainDesc.m_Height > Mathf::ZeroTolerance())
+      {
+        for (auto const& poly : entry.second)
+        {
+          Vector<AABB2Di> boxes;
+          poly.GetBoxes(boxes);
+          for (auto const& box : boxes)
+          {
+            ObjectHandle terrainPhysics = iWorld.CreateObject();
+            oObjects.push_back(terrainPhysics);
+            oObstacles.push_back(box);
+
+            PhysicInitData phData;
+            phData.SetCategory(terrainDesc.m_PhysicCategory, terrainDesc.m_PhysicFilter);
+            phData.SetFlags(EngineCommon::s_BasePhFlags | PhysicFlags::Static);
+            Vec2 phSize = MathTools::ToFVec(box.GetSize()) / EngineCommon::s_WorldToPixel;
+            phData.AddBox(Vec3(phSize, terrainDesc.m_Height));
+
+            Vec2 tilePos = MathTools::ToFVec(box.GetCenter()) / EngineCommon::s_WorldToPixel;
+            Vec3 orig = Vec3(tilePos, terrainDesc.m_Altitude + terrainDesc.m_Height * 0.5f);
+            Mat4 boxPos = translate(iPos, orig);
+            iTrans.AddTransform(terrainPhysics, boxPos);
+            iPhysics.CreateComponent(terrainPhysics, phData);
+          }
+        }
+      }
     }
+  }
 
-    Vector<AABB2Di> tileObstacles;
+  static void AddStaticObstacle(EngineCommon::ObjectShapeData const& iShapes, Vec3 const& iPos, Vector<AABB2Di>& oObstacles)
+  {
+    for (auto const& geom : iShapes.m_Shapes)
+    {
+      Vec2i pixelMin = Vec2i((iPos + geom.m_Offset) * EngineCommon::s_WorldToPixel);
+      Vec2i shapeSize;
+      switch (geom.m_Type)
+      {
+      case EngineCommon::PhysicsShapeType::Sphere:
+        shapeSize = Vec2i(geom.m_Dims.x, geom.m_Dims.x) * EngineCommon::s_WorldToPixel;
+        break;
+      case EngineCommon::PhysicsShapeType::Box:
+        shapeSize = Vec2i(geom.m_Dims.x, geom.m_Dims.y) * EngineCommon::s_WorldToPixel;
+        break;
+      }
 
-    if (PhysicsSystem* physics = iWorld.GetSystem<PhysicsSystem>())
+      pixelMin -= shapeSize / 2;
+      AABB2Di pixelBox = AABB2Di::FromMinAndSize(pixelMin, shapeSize);
+      oObstacles.push_back(pixelBox);
+    }
+  }
+
+  static std::unique_ptr<NavMesh> MakeNavMesh(TerrainShapes& ioShapes, Vector<AABB2Di> const& iObstacles)
+  {
+    Vector<AABB2DPolygoni> floor;
+    auto iter = ioShapes.find(TerrainTypeName("Floor"));
+    if (iter != ioShapes.end())
     {
-      for (auto const& entry : components)
+      floor = std::move(iter->second);
+    }
+
+    Vector<AABB2DPolygoni> resVec;
+    for (int32_t i = 0; i < (int32_t)floor.size(); ++i)
+    {
+      for (auto const& obstacle : iObstacles)
       {
-        TerrainType terrainDesc = TerrainType::GetTerrainTypeFromName(entry.first);
-        if (terrainDesc.m_Height > Mathf::ZeroTolerance())
+        floor[i].Difference(obstacle, resVec);
+        if (resVec.size() == 0)
+        {
+          floor.erase(floor.begin() + i);
+          --i;
+          break;
+        }
+        else if (resVec.size() >= 1)
         {
-          for (auto const& poly : entry.second)
+          std::swap(floor[i], resVec[0]);
+          for (uint32_t j = 1; j < resVec.size(); ++j)
           {
-            Vector<AABB2Di> boxes;
-            poly.GetBoxes(boxes);
-            for (auto const& box : boxes)
+            floor.push_back(std::move(resVec[j]));
+          }
+        }
+        resVec.clear();
+      }
+    }
+
+    for (auto& floorPiece : floor)
+    {
+      floorPiece.Scale(1, EngineCommon::s_WorldToPixel);
+    }
+
+    return std::make_unique<NavMesh>(NavMesh::MakeFromAABB2DPoly(floor));
+  }
+
+  // Property of a map object as its archetype would instantiate it, without creating the object.
+  template <typename T>
+  static T const* GetObjectProperty(MapResource::Object const& iObject, PropertySheetName iName, DynObject& oStorage)
+  {
+    Archetype const* objArchetype = iObject.m_Header.m_Archetype.GetOrLoad();
+    if (objArchetype == nullptr || !objArchetype->HasProperty(iName))
+    {
+      return nullptr;
+    }
+    oStorage = DynObject(&objArchetype->GetProperty(iName));
+    iObject.m_Data.ApplyCustomization(iName, oStorage);
+    return oStorage.CastBuffer<T>();
+  }
+
+  MapResource::InstanceData MapResource::Instantiate(World& iWorld, Mat4 const& iPos) const
+  {
+    InstanceData allObjects;
+
+    Transforms* trans = iWorld.GetSystem<Transforms>();
+    GameDatabase* database = iWorld.GetSystem<GameDatabase>();
+    eXl_ASSERT_REPAIR_RET(trans != nullptr, allObjects);
+    eXl_ASSERT_REPAIR_RET(database != nullptr, allObjects);
+
+    GfxSystem* gfx = iWorld.GetSystem<GfxSystem>();
+
+    Vector<MapTiler::Batcher> tilesByLayer;
+    TerrainShapes components;
+
+    AddTerrainShapes(m_Terrains, components);
+    if (gfx != nullptr)
+    {
+      Vector<MapTiler::Batcher> terrainByLayer;
+      ComputeTerrainGfx(terrainByLayer, iWorld.GetJobSystem());
+      FinalizeLayers(iWorld, *gfx, *trans, iPos, terrainByLayer, allObjects.terrain);
+    }
+
+    for (auto const& tiles : m_Tiles)
+    {
+      Tileset const* tileset = tiles.m_Tileset.GetOrLoad();
+      if (tileset != nullptr)
+      {
+        for (auto const& tile : tiles.m_Tiles)
+        {
+          Tile const* tileDesc = tileset->Find(tile.m_Name);
+          if (tileDesc != nullptr)
+          {
+            AddTileShape(tiles, tile, *tileDesc, components);
+            if (gfx != nullptr)
             {
-              ObjectHandle terrainPhysics = iWorld.CreateObject();
-              allObjects.terrain.push_back(terrainPhysics);
-              tileObstacles.push_back(box);
-
-              PhysicInitData phData;
-              phData.SetCategory(terrainDesc.m_PhysicCategory, terrainDesc.m_PhysicFilter);
-              phData.SetFlags(EngineCommon::s_BasePhFlags | PhysicFlags::Static);
-              Vec2 phSize = MathTools::ToFVec(box.GetSize()) / EngineCommon::s_WorldToPixel;
-              phData.AddBox(Vec3(phSize, terrainDesc.m_Height));
-              
-              Vec2 tilePos = MathTools::ToFVec(box.GetCenter()) / EngineCommon::s_WorldToPixel;
-              Vec3 orig = Vec3(tilePos, terrainDesc.m_Altitude + terrainDesc.m_Height * 0.5f);
-              Mat4 boxPos = translate(iPos, orig);
-              trans->AddTransform(terrainPhysics, boxPos);
-              physics->CreateComponent(terrainPhysics, phData);
+              AddTileGfx(iWorld, *gfx, *trans, iPos, tileset, tile, *tileDesc, tiles.m_Type, tilesByLayer, allObjects.tiles);
             }
           }
+          else
+          {
+            LOG_ERROR << "Could not find tile " << tile.m_Name << " in tileset " << tileset->GetName();
+          }
         }
       }
+      else
+      {
+        LOG_ERROR << "Could not load tileset " << tiles.m_Tileset.GetUUID().ToString();
+      }
     }
 
-    if (gfx != nullptr)
+    CreateObjects(iWorld, trans, iPos, m_Objects, nullptr, allObjects.objects);
+
+    for (uint32_t i = 0; i < m_Objects.size(); ++i)
     {
-      for (uint32_t layerIdx = 0; layerIdx < tilesByLayer.size(); ++layerIdx)
+      ObjectHandle mapObject = allObjects.objects[i];
+      auto const* carver = database->GetData<EngineCommon::TerrainCarver>(mapObject, EngineCommon::TerrainCarver::PropertyName());
+      auto const* shapeDesc = database->GetData<EngineCommon::ObjectShapeData>(mapObject, EngineCommon::ObjectShapeData::PropertyName());
+      if (carver != nullptr && shapeDesc != nullptr)
       {
-        auto& layer = tilesByLayer[layerIdx];
-        ObjectHandle layerView = iWorld.CreateObject();
-        allObjects.tiles.push_back(layerView);
-        trans->AddTransform(layerView, iPos);
-        layer.Finalize(*gfx, layerView, layerIdx);
+        CarveTerrain(components, carver->m_TerrainType, *shapeDesc, m_Objects[i].m_Header.m_Position);
       }
     }
 
+    for (auto& entry : components)
+    {
+      AABB2DPolygoni::Merge(entry.second);
+    }
+
+    Vector<AABB2Di> tileObstacles;
+
+    if (PhysicsSystem* physics = iWorld.GetSystem<PhysicsSystem>())
+    {
+      AddTerrainPhysics(iWorld, *physics, *trans, iPos, components, allObjects.terrain, tileObstacles);
+    }
+
+    if (gfx != nullptr)
+    {
+      FinalizeLayers(iWorld, *gfx, *trans, iPos, tilesByLayer, allObjects.tiles);
+    }
+
     if (NavigatorSystem* navSys = iWorld.GetSystem<NavigatorSystem>())
     {
       auto view = database->GetView<EngineCommon::PhysicBodyData>(EngineCommon::PhysicBodyData::PropertyName());
@@ -395,25 +567,7 @@ namespace eXl
           if (phData->m_Type == EngineCommon::PhysicsType::Static && shapes)
           {
             Mat4 const& pos = trans->GetWorldTransform(obj);
-
-            for (auto const& geom : shapes->m_Shapes)
-            {
-              Vec2i pixelMin = Vec2i((Vec3(pos[3]) + geom.m_Offset) * EngineCommon::s_WorldToPixel);
-              Vec2i shapeSize;
-              switch (geom.m_Type)
-              {
-              case EngineCommon::PhysicsShapeType::Sphere:
-                shapeSize = Vec2i(geom.m_Dims.x, geom.m_Dims.x) * EngineCommon::s_WorldToPixel;
-                break;
-              case EngineCommon::PhysicsShapeType::Box:
-                shapeSize = Vec2i(geom.m_Dims.x, geom.m_Dims.y) * EngineCommon::s_WorldToPixel;
-                break;
-              }
-
-              pixelMin -= shapeSize / 2;
-              AABB2Di pixelBox = AABB2Di::FromMinAndSize(pixelMin, shapeSize);
-              tileObstacles.push_back(pixelBox);
-            }
+            AddStaticObstacle(*shapes, Vec3(pos[3]), tileObstacles);
           }
         }
       };
@@ -436,46 +590,375 @@ namespace eXl
         }
       }
 
-      Vector<AABB2DPolygoni> floor;
-      auto iter = components.find(TerrainTypeName("Floor"));
-      if (iter != components.end())
+      allObjects.navMesh = MakeNavMesh(components, tileObstacles);
+      navSys->SetNavMesh(*allObjects.navMesh);
+    }
+
+    return allObjects;
+  }
+
+  Vec2i MapResource::GetChunkCoords(Vec2 const& iPos) const
+  {
+    eXl_ASSERT(m_ChunkSize > 0);
+    return Vec2i(Mathf::Floor(iPos.x / m_ChunkSize), Mathf::Floor(iPos.y / m_ChunkSize));
+  }
+
+  AABB2Df MapResource::GetChunkBox(Vec2i const& iCoords) const
+  {
+    Vec2 chunkSize(m_ChunkSize, m_ChunkSize);
+    return AABB2Df::FromMinAndSize(MathTools::ToFVec(iCoords) * chunkSize, chunkSize);
+  }
+
+  void MapResource::BuildChunks(uint32_t iChunkSize)
+  {
+    m_ChunkSize = iChunkSize;
+    m_Chunks.clear();
+    if (m_ChunkSize == 0)
+    {
+      return;
+    }
+
+    UnorderedMap<uint64_t, uint32_t> chunksIdx;
+    auto getChunk = [this, &chunksIdx](Vec2i const& iCoords) -> Chunk&
+    {
+      uint64_t key = (uint64_t(uint32_t(iCoords.x)) << 32) | uint32_t(iCoords.y);
+      auto insertRes = chunksIdx.insert(std::make_pair(key, uint32_t(m_Chunks.size())));
+      if (insertRes.second)
       {
-        floor = std::move(iter->second);
+        m_Chunks.push_back(Chunk());
+        m_Chunks.back().m_Coords = iCoords;
+        m_Chunks.back().m_Tiles.resize(m_Tiles.size());
       }
+      return m_Chunks[insertRes.first->second];
+    };
 
-      Vector<AABB2DPolygoni> resVec;
-      for (int32_t i = 0; i < (int32_t)floor.size(); ++i)
+    // Chunks overlapped by a box in pixels.
+    int32_t const chunkPixels = m_ChunkSize * EngineCommon::s_WorldToPixel;
+    auto getChunkRange = [chunkPixels](AABB2Di const& iBox)
+    {
+      return AABB2Di(
+        FloorDiv(iBox.m_Data[0].x, chunkPixels), FloorDiv(iBox.m_Data[0].y, chunkPixels),
+        FloorDiv(iBox.m_Data[1].x - 1, chunkPixels) + 1, FloorDiv(iBox.m_Data[1].y - 1, chunkPixels) + 1);
+    };
+
+    // Chunks index objects in the order they are serialized.
+    std::sort(m_Objects.begin(), m_Objects.end(), [](Object const& iObj1, Object const& iObj2)
+    {
+      return iObj1.m_Header.m_ObjectId < iObj2.m_Header.m_ObjectId;
+    });
+
+    TerrainShapes components;
+    AddTerrainShapes(m_Terrains, components);
+
+    for (uint32_t groupIdx = 0; groupIdx < m_Tiles.size(); ++groupIdx)
+    {
+      PlacedTiles const& tiles = m_Tiles[groupIdx];
+      Tileset const* tileset = tiles.m_Tileset.GetOrLoad();
+      for (uint32_t tileIdx = 0; tileIdx < tiles.m_Tiles.size(); ++tileIdx)
       {
-        for (auto const& obstacle : tileObstacles)
+        PlacedTiles::Tile const& tile = tiles.m_Tiles[tileIdx];
+        Vec2 tilePos = MathTools::ToFVec(tile.m_Position) / EngineCommon::s_WorldToPixel;
+        getChunk(GetChunkCoords(tilePos)).m_Tiles[groupIdx].push_back(tileIdx);
+        if (Tile const* tileDesc = tileset ? tileset->Find(tile.m_Name) : nullptr)
         {
-          floor[i].Difference(obstacle, resVec);
-          if (resVec.size() == 0)
+          AddTileShape(tiles, tile, *tileDesc, components);
+        }
+      }
+    }
+
+    for (uint32_t objIdx = 0; objIdx < m_Objects.size(); ++objIdx)
+    {
+      Object const& object = m_Objects[objIdx];
+      getChunk(GetChunkCoords(MathTools::As2DVec(object.m_Header.m_Position))).m_Objects.push_back(objIdx);
+
+      DynObject carverStorage;
+      DynObject shapeStorage;
+      auto const* carver = GetObjectProperty<EngineCommon::TerrainCarver>(object, EngineCommon::TerrainCarver::PropertyName(), carverStorage);
+      auto const* shapeDesc = GetObjectProperty<EngineCommon::ObjectShapeData>(object, EngineCommon::ObjectShapeData::PropertyName(), shapeStorage);
+      if (carver != nullptr && shapeDesc != nullptr)
+      {
+        CarveTerrain(components, carver->m_TerrainType, *shapeDesc, object.m_Header.m_Position);
+      }
+    }
+
+    Vector<AABB2DPolygoni> clipped;
+    for (auto const& terrainItem : m_Terrains)
+    {
+      Vec2i const tilingSize = GetTilingSize(terrainItem.m_TilingGroup.GetOrLoad());
+      UnorderedMap<uint32_t, uint32_t> terrainInChunk;
+      for (auto const& terrainBlock : terrainItem.m_Blocks)
+      {
+        AABB2Di blockBox = terrainBlock.m_Shape.GetAABB();
+        blockBox.m_Data[0] *= tilingSize;
+        blockBox.m_Data[1] *= tilingSize;
+        AABB2Di const range = getChunkRange(blockBox);
+        for (int32_t y = range.m_Data[0].y; y < range.m_Data[1].y; ++y)
+        {
+          for (int32_t x = range.m_Data[0].x; x < range.m_Data[1].x; ++x)
           {
-            floor.erase(floor.begin() + i);
-            --i;
-            break;
+            Vec2i chunkMin = Vec2i(x, y) * chunkPixels;
+            Vec2i chunkMax = chunkMin + One<Vec2i>() * chunkPixels;
+            AABB2Di clipBox(
+              FloorDiv(chunkMin.x, tilingSize.x) - s_ChunkTilingMargin, FloorDiv(chunkMin.y, tilingSize.y) - s_ChunkTilingMargin,
+              FloorDiv(chunkMax.x - 1, tilingSize.x) + 1 + s_ChunkTilingMargin, FloorDiv(chunkMax.y - 1, tilingSize.y) + 1 + s_ChunkTilingMargin);
+
+            clipped.clear();
+            terrainBlock.m_Shape.Intersection(AABB2DPolygoni(clipBox), clipped);
+            if (clipped.empty())
+            {
+              continue;
+            }
+
+            Chunk& chunk = getChunk(Vec2i(x, y));
+            uint32_t chunkIdx = &chunk - m_Chunks.data();
+            auto insertRes = terrainInChunk.insert(std::make_pair(chunkIdx, uint32_t(chunk.m_Terrains.size())));
+            if (insertRes.second)
+            {
+              chunk.m_Terrains.push_back(Terrain());
+              chunk.m_Terrains.back().m_Type = terrainItem.m_Type;
+              chunk.m_Terrains.back().m_TilingGroup = terrainItem.m_TilingGroup;
+            }
+            Terrain& chunkTerrain = chunk.m_Terrains[insertRes.first->second];
+            for (auto& piece : clipped)
+            {
+              chunkTerrain.m_Blocks.push_back(Terrain::Block());
+              chunkTerrain.m_Blocks.back().m_Shape = std::move(piece);
+              chunkTerrain.m_Blocks.back().m_Layer = terrainBlock.m_Layer;
+            }
           }
-          else if (resVec.size() >= 1)
+        }
+      }
+    }
+
+    for (auto& entry : components)
+    {
+      AABB2DPolygoni::Merge(entry.second);
+      UnorderedMap<uint32_t, uint32_t> collisionInChunk;
+      for (auto const& poly : entry.second)
+      {
+        AABB2Di const range = getChunkRange(poly.GetAABB());
+        for (int32_t y = range.m_Data[0].y; y < range.m_Data[1].y; ++y)
+        {
+          for (int32_t x = range.m_Data[0].x; x < range.m_Data[1].x; ++x)
           {
-            std::swap(floor[i], resVec[0]);
-            for (uint32_t j = 1; j < resVec.size(); ++j)
+            Vec2i chunkMin = Vec2i(x, y) * chunkPixels;
+            clipped.clear();
+            poly.Intersection(AABB2DPolygoni(AABB2Di::FromMinAndSize(chunkMin, One<Vec2i>() * chunkPixels)), clipped);
+            if (clipped.empty())
             {
-              floor.push_back(std::move(resVec[j]));
+              continue;
             }
+
+            Chunk& chunk = getChunk(Vec2i(x, y));
+            uint32_t chunkIdx = &chunk - m_Chunks.data();
+            auto insertRes = collisionInChunk.insert(std::make_pair(chunkIdx, uint32_t(chunk.m_Collision.size())));
+            if (insertRes.second)
+            {
+              chunk.m_Collision.push_back(Collision());
+              chunk.m_Collision.back().m_Type = entry.first;
+            }
+            Collision& chunkCollision = chunk.m_Collision[insertRes.first->second];
+            for (auto& piece : clipped)
+            {
+              chunkCollision.m_Shapes.push_back(std::move(piece));
+            }
+          }
+        }
+      }
+    }
+  }
+
+  MapResource::InstanceData MapResource::InstantiateChunk(World& iWorld, Chunk const& iChunk, Mat4 const& iPos, Vector<uint32_t> const* iObjects) const
+  {
+    InstanceData chunkObjects;
+
+    Transforms* trans = iWorld.GetSystem<Transforms>();
+    eXl_ASSERT_REPAIR_RET(trans != nullptr, chunkObjects);
+
+    GfxSystem* gfx = iWorld.GetSystem<GfxSystem>();
+
+    if (gfx != nullptr)
+    {
+      Vector<MapTiler::Batcher> terrainByLayer;
+      ComputeTerrainGfx(iChunk, terrainByLayer, iWorld.GetJobSystem());
+      FinalizeLayers(iWorld, *gfx, *trans, iPos, terrainByLayer, chunkObjects.terrain);
+
+      Vector<MapTiler::Batcher> tilesByLayer;
+      for (uint32_t groupIdx = 0; groupIdx < iChunk.m_Tiles.size() && groupIdx < m_Tiles.size(); ++groupIdx)
+      {
+        PlacedTiles const& tiles = m_Tiles[groupIdx];
+        Tileset const* tileset = tiles.m_Tileset.GetOrLoad();
+        if (tileset == nullptr)
+        {
+          continue;
+        }
+        for (uint32_t tileIdx : iChunk.m_Tiles[groupIdx])
+        {
+          PlacedTiles::Tile const& tile = tiles.m_Tiles[tileIdx];
+          if (Tile const* tileDesc = tileset->Find(tile.m_Name))
+          {
+            AddTileGfx(iWorld, *gfx, *trans, iPos, tileset, tile, *tileDesc, tiles.m_Type, tilesByLayer, chunkObjects.tiles);
           }
-          resVec.clear();
         }
       }
+      FinalizeLayers(iWorld, *gfx, *trans, iPos, tilesByLayer, chunkObjects.tiles);
+    }
 
-      for (auto& floorPiece : floor)
+    CreateObjects(iWorld, trans, iPos, m_Objects, iObjects ? iObjects : &iChunk.m_Objects, chunkObjects.objects);
+
+    if (PhysicsSystem* physics = iWorld.GetSystem<PhysicsSystem>())
+    {
+      TerrainShapes components;
+      for (auto const& collision : iChunk.m_Collision)
       {
-        floorPiece.Scale(1, EngineCommon::s_WorldToPixel);
+        components.insert(std::make_pair(collision.m_Type, collision.m_Shapes));
       }
+      Vector<AABB2Di> obstacles;
+      AddTerrainPhysics(iWorld, *physics, *trans, iPos, components, chunkObjects.terrain, obstacles);
+    }
 
-      allObjects.navMesh = std::make_unique<NavMesh>(NavMesh::MakeFromAABB2DPoly(floor));
-      navSys->SetNavMesh(*allObjects.navMesh);
+    return chunkObjects;
+  }
+
+  void MapResource::ComputeTerrainGfx(Vector<MapTiler::Batcher>& oLayers, JobSystem* iJobs) const
+  {
+    bool hasBatches = false;
+    for (auto const& chunk : m_Chunks)
+    {
+      hasBatches |= !chunk.m_TerrainBatches.empty();
     }
+    if (!hasBatches)
+    {
+      TileTerrain(m_Terrains, nullptr, iJobs, oLayers);
+      return;
+    }
+    for (auto const& chunk : m_Chunks)
+    {
+      AddBakedBatches(chunk.m_TerrainBatches, oLayers);
+    }
+  }
 
-    return allObjects;
+  void MapResource::ComputeTerrainGfx(Chunk const& iChunk, Vector<MapTiler::Batcher>& oLayers, JobSystem* iJobs) const
+  {
+    if (!iChunk.m_TerrainBatches.empty())
+    {
+      AddBakedBatches(iChunk.m_TerrainBatches, oLayers);
+      return;
+    }
+    AABB2Df const chunkBox = GetChunkBox(iChunk.m_Coords);
+    TileTerrain(iChunk.m_Terrains, &chunkBox, iJobs, oLayers);
+  }
+
+  void MapResource::BakeTerrainGfx(JobSystem* iJobs)
+  {
+    // Tileset::GetImage loads lazily, everything has to be there before tiling from several threads.
+    UnorderedSet<TilingGroup const*> groups;
+    for (auto const& chunk : m_Chunks)
+    {
+      for (auto const& terrain : chunk.m_Terrains)
+      {
+        TilingGroup const* group = terrain.m_TilingGroup.GetOrLoad();
+        if (group != nullptr && groups.insert(group).second)
+        {
+          MapTiler::PrefetchImages(*group);
+        }
+      }
+    }
+
+    Vector<Vector<MapTiler::Batcher>> chunkLayers(m_Chunks.size());
+    auto tileChunks = [&](uint32_t iBegin, uint32_t iEnd, uint32_t)
+    {
+      for (uint32_t i = iBegin; i < iEnd; ++i)
+      {
+        AABB2Df const chunkBox = GetChunkBox(m_Chunks[i].m_Coords);
+        TileTerrain(m_Chunks[i].m_Terrains, &chunkBox, nullptr, chunkLayers[i]);
+      }
+    };
+    if (iJobs != nullptr)
+    {
+      iJobs->ParallelFor(0, m_Chunks.size(), 1, tileChunks);
+    }
+    else
+    {
+      tileChunks(0, m_Chunks.size(), 0);
+    }
+
+    for (uint32_t i = 0; i < m_Chunks.size(); ++i)
+    {
+      Chunk& chunk = m_Chunks[i];
+      chunk.m_TerrainBatches.clear();
+      for (uint32_t layerIdx = 0; layerIdx < chunkLayers[i].size(); ++layerIdx)
+      {
+        MapTiler::Batcher const& layer = chunkLayers[i][layerIdx];
+        Vector<MapTiler::TexGroup const*> texGroups(layer.textures.size(), nullptr);
+        for (auto const& entry : layer.textures)
+        {
+          texGroups[entry.second] = &entry.first;
+        }
+        for (uint32_t groupIdx = 0; groupIdx < texGroups.size() && groupIdx < layer.allTiles.size(); ++groupIdx)
+        {
+          if (layer.allTiles[groupIdx].empty())
+          {
+            continue;
+          }
+          TerrainBatch batch;
+          batch.m_Layer = layerIdx;
+          batch.m_Tileset.Set(texGroups[groupIdx]->m_Tileset);
+          batch.m_Image = texGroups[groupIdx]->m_Name;
+          batch.m_VtxScaling = texGroups[groupIdx]->m_VtxScaling;
+          batch.m_VtxOffset = texGroups[groupIdx]->m_VtxOffset;
+          batch.m_Tiling = texGroups[groupIdx]->m_Tiling;
+          batch.m_Vertices = layer.allTiles[groupIdx];
+          chunk.m_TerrainBatches.push_back(std::move(batch));
+        }
+      }
+      if (!chunk.m_TerrainBatches.empty())
+      {
+        chunk.m_Terrains.clear();
+      }
+    }
+  }
+
+  std::unique_ptr<NavMesh> MapResource::BuildChunkedNavMesh() const
+  {
+    TerrainShapes components;
+    Vector<AABB2Di> obstacles;
+    for (auto const& chunk : m_Chunks)
+    {
+      for (auto const& collision : chunk.m_Collision)
+      {
+        TerrainType terrainDesc = TerrainType::GetTerrainTypeFromName(collision.m_Type);
+        if (terrainDesc.m_Height > Mathf::ZeroTolerance())
+        {
+          for (auto const& poly : collision.m_Shapes)
+          {
+            poly.GetBoxes(obstacles);
+          }
+        }
+        auto& shapes = components.insert(std::make_pair(collision.m_Type, Vector<AABB2DPolygoni>())).first->second;
+        shapes.insert(shapes.end(), collision.m_Shapes.begin(), collision.m_Shapes.end());
+      }
+    }
+
+    for (auto const& object : m_Objects)
+    {
+      DynObject bodyStorage;
+      DynObject shapeStorage;
+      auto const* phData = GetObjectProperty<EngineCommon::PhysicBodyData>(object, EngineCommon::PhysicBodyData::PropertyName(), bodyStorage);
+      auto const* shapes = GetObjectProperty<EngineCommon::ObjectShapeData>(object, EngineCommon::ObjectShapeData::PropertyName(), shapeStorage);
+      if (phData != nullptr && shapes != nullptr && phData->m_Type == EngineCommon::PhysicsType::Static)
+      {
+        AddStaticObstacle(*shapes, object.m_Header.m_Position, obstacles);
+      }
+    }
+
+    // Floor pieces were cut along the chunks' borders.
+    auto floorIter = components.find(TerrainTypeName("Floor"));
+    if (floorIter != components.end())
+    {
+      AABB2DPolygoni::Merge(floorIter->second);
+    }
+
+    return MakeNavMesh(components, obstacles);
   }
-}
\ No newline at end of file
+}
@@ -0,0 +1,298 @@
+/*
+Copyright 2009-2021 Nicolas Colombe
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <engine/map/mapstreamer.hpp>
+#include <engine/common/transforms.hpp>
+
+#include <core/clock.hpp>
+
+namespace eXl
+{
+  MapStreamer::MapStreamer(World& iWorld, MapResource const& iMap, Mat4 const& iPos)
+    : m_World(iWorld)
+    , m_Map(iMap)
+    , m_Pos(iPos)
+    , m_InvPos(inverse(iPos))
+  {
+    eXl_ASSERT_MSG(m_Map.m_ChunkSize > 0, "Map was not partitioned in chunks");
+    m_ChunkObjects.reserve(m_Map.m_Chunks.size());
+    for (uint32_t i = 0; i < m_Map.m_Chunks.size(); ++i)
+    {
+      m_ChunksIdx.insert(std::make_pair(GetChunkKey(m_Map.m_Chunks[i].m_Coords), i));
+      m_ChunkObjects.push_back(m_Map.m_Chunks[i].m_Objects);
+    }
+  }
+
+  MapStreamer::~MapStreamer() = default;
+
+  uint32_t MapStreamer::AllocFocus()
+  {
+    for (uint32_t i = 0; i < m_Focus.size(); ++i)
+    {
+      if (!m_Focus[i].m_Used)
+      {
+        return i;
+      }
+    }
+    m_Focus.push_back(Focus());
+    return m_Focus.size() - 1;
+  }
+
+  uint32_t MapStreamer::AddFocusPoint(Vec2 const& iPos, float iRadius)
+  {
+    uint32_t focusIdx = AllocFocus();
+    Focus& focus = m_Focus[focusIdx];
+    focus.m_Pos = Vec2(m_InvPos * Vec4(iPos, 0.0, 1.0));
+    focus.m_Object = ObjectHandle();
+    focus.m_Radius = iRadius;
+    focus.m_Used = true;
+
+    return focusIdx;
+  }
+
+  void MapStreamer::MoveFocusPoint(uint32_t iFocus, Vec2 const& iPos)
+  {
+    eXl_ASSERT_REPAIR_RET(iFocus < m_Focus.size() && m_Focus[iFocus].m_Used, );
+    m_Focus[iFocus].m_Pos = Vec2(m_InvPos * Vec4(iPos, 0.0, 1.0));
+  }
+
+  uint32_t MapStreamer::AddFocusObject(ObjectHandle iObject, float iRadius)
+  {
+    uint32_t focusIdx = AddFocusPoint(Zero<Vec2>(), iRadius);
+    m_Focus[focusIdx].m_Object = iObject;
+
+    return focusIdx;
+  }
+
+  void MapStreamer::RemoveFocus(uint32_t iFocus)
+  {
+    eXl_ASSERT_REPAIR_RET(iFocus < m_Focus.size(), );
+    m_Focus[iFocus] = Focus();
+  }
+
+  float MapStreamer::GetDistance(Vec2i const& iCoords, Focus const& iFocus) const
+  {
+    AABB2Df const box = m_Map.GetChunkBox(iCoords);
+    Vec2 const diff(
+      Mathf::Max(0.0f, Mathf::Max(box.m_Data[0].x - iFocus.m_Pos.x, iFocus.m_Pos.x - box.m_Data[1].x)),
+      Mathf::Max(0.0f, Mathf::Max(box.m_Data[0].y - iFocus.m_Pos.y, iFocus.m_Pos.y - box.m_Data[1].y)));
+    return length(diff);
+  }
+
+  void MapStreamer::Update(float iTimeBudget)
+  {
+    Clock timer;
+    timer.GetTime();
+
+    Transforms* trans = m_World.GetSystem<Transforms>();
+    for (auto& focus : m_Focus)
+    {
+      if (!focus.m_Used || !focus.m_Object.IsAssigned())
+      {
+        continue;
+      }
+      if (!m_World.IsObjectValid(focus.m_Object))
+      {
+        focus = Focus();
+        continue;
+      }
+      Mat4 const& objPos = trans->GetWorldTransform(focus.m_Object);
+      focus.m_Pos = Vec2(m_InvPos * objPos[3]);
+    }
+
+    float const chunkSize = m_Map.m_ChunkSize;
+
+    Vector<uint32_t> toUnload;
+    for (auto const& entry : m_LoadedChunks)
+    {
+      Vec2i const coords = m_Map.m_Chunks[entry.first].m_Coords;
+      bool inReach = false;
+      for (uint32_t i = 0; i < m_Focus.size() && !inReach; ++i)
+      {
+        inReach = m_Focus[i].m_Used && GetDistance(coords, m_Focus[i]) <= m_Focus[i].m_Radius + chunkSize;
+      }
+      if (!inReach)
+      {
+        toUnload.push_back(entry.first);
+      }
+    }
+    for (uint32_t chunk : toUnload)
+    {
+      UnloadChunk(chunk);
+    }
+
+    UnorderedMap<uint32_t, float> toLoad;
+    for (auto const& focus : m_Focus)
+    {
+      if (!focus.m_Used)
+      {
+        continue;
+      }
+      Vec2i const minCoords = m_Map.GetChunkCoords(focus.m_Pos - One<Vec2>() * focus.m_Radius);
+      Vec2i const maxCoords = m_Map.GetChunkCoords(focus.m_Pos + One<Vec2>() * focus.m_Radius);
+      for (int32_t y = minCoords.y; y <= maxCoords.y; ++y)
+      {
+        for (int32_t x = minCoords.x; x <= maxCoords.x; ++x)
+        {
+          auto iter = m_ChunksIdx.find(GetChunkKey(Vec2i(x, y)));
+          if (iter == m_ChunksIdx.end() || m_LoadedChunks.count(iter->second) > 0)
+          {
+            continue;
+          }
+          float const dist = GetDistance(Vec2i(x, y), focus);
+          if (dist <= focus.m_Radius)
+          {
+            auto insertRes = toLoad.insert(std::make_pair(iter->second, dist));
+            insertRes.first->second = Mathf::Min(insertRes.first->second, dist);
+          }
+        }
+      }
+    }
+
+    Vector<std::pair<float, uint32_t>> loadOrder;
+    loadOrder.reserve(toLoad.size());
+    for (auto const& entry : toLoad)
+    {
+      loadOrder.push_back(std::make_pair(entry.second, entry.first));
+    }
+    std::sort(loadOrder.begin(), loadOrder.end());
+
+    uint32_t numLoaded = 0;
+    for (auto const& entry : loadOrder)
+    {
+      if (numLoaded > 0 && timer.PeekTime() >= iTimeBudget)
+      {
+        break;
+      }
+      LoadChunk(entry.second);
+      ++numLoaded;
+    }
+    m_NumPendingChunks = loadOrder.size() - numLoaded;
+  }
+
+  uint32_t MapStreamer::FindChunk(Vec2 const& iPos) const
+  {
+    auto iter = m_ChunksIdx.find(GetChunkKey(m_Map.GetChunkCoords(iPos)));
+    return iter != m_ChunksIdx.end() ? iter->second : -1;
+  }
+
+  void MapStreamer::LoadChunk(uint32_t iChunk)
+  {
+    Vector<uint32_t> const& objectsIdx = m_ChunkObjects[iChunk];
+    MapResource::InstanceData data = m_Map.InstantiateChunk(m_World, m_Map.m_Chunks[iChunk], m_Pos, &objectsIdx);
+
+    Transforms* trans = m_World.GetSystem<Transforms>();
+    for (uint32_t i = 0; i < objectsIdx.size() && i < data.objects.size(); ++i)
+    {
+      auto iter = m_MovedObjects.find(objectsIdx[i]);
+      if (iter != m_MovedObjects.end())
+      {
+        trans->UpdateTransform(data.objects[i], iter->second);
+      }
+    }
+    m_LoadedChunks.insert(std::make_pair(iChunk, std::move(data)));
+  }
+
+  void MapStreamer::UnloadChunk(uint32_t iChunk)
+  {
+    auto iter = m_LoadedChunks.find(iChunk);
+    if (iter == m_LoadedChunks.end())
+    {
+      return;
+    }
+    MapResource::InstanceData& data = iter->second;
+    for (auto const* objects : {&data.tiles, &data.terrain})
+    {
+      for (ObjectHandle object : *objects)
+      {
+        if (m_World.IsObjectValid(object))
+        {
+          m_World.DeleteObject(object);
+        }
+      }
+    }
+
+    Transforms* trans = m_World.GetSystem<Transforms>();
+    Vector<uint32_t> keptObjects;
+    Vector<uint32_t>& objectsIdx = m_ChunkObjects[iChunk];
+    for (uint32_t i = 0; i < objectsIdx.size() && i < data.objects.size(); ++i)
+    {
+      uint32_t const objIdx = objectsIdx[i];
+      ObjectHandle const object = data.objects[i];
+      // Gameplay may have deleted some of the map objects already, they are gone for good.
+      if (!m_World.IsObjectValid(object))
+      {
+        m_MovedObjects.erase(objIdx);
+        continue;
+      }
+
+      Mat4 const& localPos = trans->GetLocalTransform(object);
+      if (localPos != translate(m_Pos, m_Map.m_Objects[objIdx].m_Header.m_Position))
+      {
+        m_MovedObjects[objIdx] = localPos;
+      }
+      else
+      {
+        m_MovedObjects.erase(objIdx);
+      }
+
+      // Objects which left the chunk now belong to the one they are in, if any.
+      uint32_t const newChunk = FindChunk(Vec2(m_InvPos * trans->GetWorldTransform(object)[3]));
+      if (newChunk == uint32_t(-1) || newChunk == iChunk)
+      {
+        keptObjects.push_back(objIdx);
+        m_World.DeleteObject(object);
+        continue;
+      }
+      m_ChunkObjects[newChunk].push_back(objIdx);
+      auto loadedIter = m_LoadedChunks.find(newChunk);
+      if (loadedIter != m_LoadedChunks.end())
+      {
+        loadedIter->second.objects.push_back(object);
+      }
+      else
+      {
+        m_World.DeleteObject(object);
+      }
+    }
+    objectsIdx = std::move(keptObjects);
+    m_LoadedChunks.erase(iter);
+  }
+
+  void MapStreamer::Clear()
+  {
+    Vector<uint32_t> loaded;
+    for (auto const& entry : m_LoadedChunks)
+    {
+      loaded.push_back(entry.first);
+    }
+    for (uint32_t chunk : loaded)
+    {
+      UnloadChunk(chunk);
+    }
+    m_NumPendingChunks = 0;
+  }
+
+  bool MapStreamer::IsChunkLoaded(Vec2i const& iCoords) const
+  {
+    return GetChunkData(iCoords) != nullptr;
+  }
+
+  MapResource::InstanceData const* MapStreamer::GetChunkData(Vec2i const& iCoords) const
+  {
+    auto iter = m_ChunksIdx.find(GetChunkKey(iCoords));
+    if (iter == m_ChunksIdx.end())
+    {
+      return nullptr;
+    }
+    auto loadedIter = m_LoadedChunks.find(iter->second);
+    return loadedIter != m_LoadedChunks.end() ? &loadedIter->second : nullptr;
+  }
+}
@@ -14,6 +14,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <engine/gfx/gfxcomponent.hpp>
 #include <engine/gfx/gfxsystem.hpp>
 #include <math/mathtools.hpp>
+#include <core/thread/jobsystem.hpp>
 #include <numeric>
 #include <bitset>
 
@@ -51,16 +52,83 @@ namespace eXl
       return allTiles[groupIdx];
     }
 
+    void Batcher::Clip(AABB2Df const& iBox)
+    {
+      uint32_t const vtxSize = 5;
+      uint32_t const quadSize = 6 * vtxSize;
+      for (auto& group : allTiles)
+      {
+        uint32_t keptSize = 0;
+        for (uint32_t quadOffset = 0; quadOffset + quadSize <= group.size(); quadOffset += quadSize)
+        {
+          float quad[quadSize];
+          std::copy(group.begin() + quadOffset, group.begin() + quadOffset + quadSize, quad);
+
+          // Quads are axis aligned, the first vertex is the lower corner and the last one the upper corner.
+          float const* minVtx = quad;
+          float const* maxVtx = quad + quadSize - vtxSize;
+          Vec2 clipMin(Mathf::Max(minVtx[0], iBox.m_Data[0].x), Mathf::Max(minVtx[1], iBox.m_Data[0].y));
+          Vec2 clipMax(Mathf::Min(maxVtx[0], iBox.m_Data[1].x), Mathf::Min(maxVtx[1], iBox.m_Data[1].y));
+          if (clipMin.x >= clipMax.x || clipMin.y >= clipMax.y)
+          {
+            continue;
+          }
+
+          float* dest = group.data() + keptSize;
+          for (uint32_t vtx = 0; vtx < 6; ++vtx)
+          {
+            float const* srcVtx = quad + vtx * vtxSize;
+            float* destVtx = dest + vtx * vtxSize;
+            for (uint32_t axis = 0; axis < 2; ++axis)
+            {
+              bool const upper = srcVtx[axis] > (minVtx[axis] + maxVtx[axis]) * 0.5;
+              float const pos = upper ? clipMax[axis] : clipMin[axis];
+              float const t = (pos - minVtx[axis]) / (maxVtx[axis] - minVtx[axis]);
+              destVtx[axis] = pos;
+              destVtx[3 + axis] = minVtx[3 + axis] + (maxVtx[3 + axis] - minVtx[3 + axis]) * t;
+            }
+            destVtx[2] = srcVtx[2];
+          }
+          keptSize += quadSize;
+        }
+        group.resize(keptSize);
+      }
+    }
+
+    void Batcher::Merge(Batcher const& iOther)
+    {
+      Vector<TexGroup const*> otherGroups(iOther.textures.size(), nullptr);
+      for (auto const& entry : iOther.textures)
+      {
+        otherGroups[entry.second] = &entry.first;
+      }
+      for (uint32_t i = 0; i < otherGroups.size(); ++i)
+      {
+        Vector<float>& dest = GetGroup(*otherGroups[i]);
+        if (i < iOther.allTiles.size())
+        {
+          dest.insert(dest.end(), iOther.allTiles[i].begin(), iOther.allTiles[i].end());
+        }
+      }
+    }
+
     void Batcher::Finalize(GfxSystem& iGfx, ObjectHandle iObject, uint8_t iLayer)
     {
       Vector<uint32_t> numVtx;
       Vector<uint32_t> offset;
       uint32_t totNumVtx = 0;
+      GfxBounds bounds = { Vec3(Mathf::MaxReal()), Vec3(-Mathf::MaxReal()) };
       for (auto const& group : allTiles)
       {
         offset.push_back(totNumVtx);
         numVtx.push_back(group.size() / 5);
         totNumVtx += group.size() / 5;
+        for (size_t i = 0; i + 2 < group.size(); i += 5)
+        {
+          Vec3 const vtx(group[i], group[i + 1], group[i + 2]);
+          bounds.m_Min = glm::min(bounds.m_Min, vtx);
+          bounds.m_Max = glm::max(bounds.m_Max, vtx);
+        }
       }
       if (totNumVtx == 0)
       {
@@ -93,11 +161,14 @@ namespace eXl
       geom->m_Assembly = assembly;
       geom->m_Vertices = buffer;
       geom->m_Command = OGLDraw::TriangleList;
+      geom->m_Bounds = bounds;
 
       GfxComponent& comp = iGfx.CreateComponent(iObject);
       comp.SetProgram(iGfx.GetSpriteProgram());
       comp.SetGeometry(geom);
       comp.SetTransform(identMatrix);
+      // Terrain and tile layers do not change after load.
+      comp.SetStatic(true);
 
       for (auto groupEntry : textures)
       {
@@ -697,5 +768,74 @@ namespace eXl
         }
       }
     }
+
+    void PrefetchImages(TilingGroup const& iGroup)
+    {
+      Tileset const* tileset = iGroup.GetTileset().GetOrLoad();
+      if (tileset == nullptr)
+      {
+        return;
+      }
+      auto prefetchTile = [tileset](TileName iName)
+      {
+        if (Tile const* tile = tileset->Find(iName))
+        {
+          tileset->GetImageSize(tile->m_ImageName);
+        }
+      };
+      prefetchTile(iGroup.m_DefaultTile);
+      for (auto const& pattern : iGroup.m_Patterns)
+      {
+        for (auto const& element : pattern.second.drawElement)
+        {
+          prefetchTile(element.m_Name);
+        }
+      }
+    }
+
+    void ComputeGfxForLayers(Vector<Batcher>& oLayers, AABB2Di const& iFullSize, Vector<Vector<Blocks const*>> const& iBlocksByLayer, JobSystem* iJobs)
+    {
+      if (oLayers.size() < iBlocksByLayer.size())
+      {
+        oLayers.resize(iBlocksByLayer.size());
+      }
+
+      Vector<std::pair<uint32_t, Blocks const*>> items;
+      UnorderedSet<TilingGroup const*> groups;
+      for (uint32_t layerIdx = 0; layerIdx < iBlocksByLayer.size(); ++layerIdx)
+      {
+        for (Blocks const* block : iBlocksByLayer[layerIdx])
+        {
+          items.push_back(std::make_pair(layerIdx, block));
+          if (groups.insert(block->group).second)
+          {
+            PrefetchImages(*block->group);
+          }
+        }
+      }
+
+      if (iJobs == nullptr || items.size() < 2)
+      {
+        for (auto const& item : items)
+        {
+          ComputeGfxForBlock(oLayers[item.first], iFullSize, *item.second);
+        }
+        return;
+      }
+
+      // Every block gets its own batcher, merged in order afterwards so that the result does not depend on scheduling.
+      Vector<Batcher> itemBatchers(items.size());
+      iJobs->ParallelFor(0, items.size(), 1, [&](uint32_t iBegin, uint32_t iEnd, uint32_t)
+      {
+        for (uint32_t i = iBegin; i < iEnd; ++i)
+        {
+          ComputeGfxForBlock(itemBatchers[i], iFullSize, *items[i].second);
+        }
+      });
+      for (uint32_t i = 0; i < items.size(); ++i)
+      {
+        oLayers[items[i].first].Merge(itemBatchers[i]);
+      }
+    }
   }
 }
\ No newline at end of file
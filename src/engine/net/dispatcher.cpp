@@ -1,5 +1,6 @@
 
 #include <engine/net/network.hpp>
+#include <core/profiler.hpp>
 
 namespace eXl
 {
@@ -42,56 +43,176 @@ namespace eXl
     {
       eXl_ASSERT_REPAIR_RET(m_ConnectedClients.count(iClient) != 0, void());
       m_ConnectedClients.erase(iClient);
+      m_Interests.erase(iClient);
     }
 
-    void ServerDispatcher::Flush(Server& iServer)
+    void ServerDispatcher::SetInterestParams(InterestParams const& iParams)
     {
-      for (auto const& obj : m_DeletedObjects)
+      eXl_ASSERT_REPAIR_RET(iParams.m_CellSize > 0 && iParams.m_EnterRadius <= iParams.m_LeaveRadius, void());
+      m_Params = iParams;
+    }
+
+    namespace
+    {
+      int32_t GetCellCoord(float iCoord, float iCellSize)
       {
-        m_Objects.erase(obj);
-        m_PendingUpdates.erase(obj);
-        for (auto client : m_ConnectedClients)
+        return static_cast<int32_t>(Mathf::Floor(iCoord / iCellSize));
+      }
+
+      uint64_t GetCellKey(int32_t iX, int32_t iY)
+      {
+        return (uint64_t(uint32_t(iX)) << 32) | uint32_t(iY);
+      }
+
+      float DistanceXY(Vec3 const& iPos1, Vec3 const& iPos2)
+      {
+        return length(Vec2(iPos1.x - iPos2.x, iPos1.y - iPos2.y));
+      }
+    }
+
+    void ServerDispatcher::BuildGrid()
+    {
+      for (auto& cell : m_Grid)
+      {
+        cell.second.clear();
+      }
+      for (auto const& object : m_Objects)
+      {
+        Vec3 const& pos = object.second.m_Pos;
+        m_Grid[GetCellKey(GetCellCoord(pos.x, m_Params.m_CellSize), GetCellCoord(pos.y, m_Params.m_CellSize))].push_back(object.first);
+      }
+      // Cells still occupied keep their storage, the others are dropped so the grid follows the objects.
+      for (auto iter = m_Grid.begin(); iter != m_Grid.end(); )
+      {
+        if (iter->second.empty())
         {
-          iServer.DeleteObject(client.first , obj);
+          iter = m_Grid.erase(iter);
+        }
+        else
+        {
+          ++iter;
         }
       }
-      m_DeletedObjects.clear();
+    }
 
-      for (auto const& update : m_PendingUpdates)
+    uint32_t ServerDispatcher::GetUpdatePeriod(float iDistance) const
+    {
+      if (iDistance <= m_Params.m_FullRateRadius || m_Params.m_LeaveRadius <= m_Params.m_FullRateRadius)
+      {
+        return 1;
+      }
+      float const ratio = Mathf::Min((iDistance - m_Params.m_FullRateRadius) / (m_Params.m_LeaveRadius - m_Params.m_FullRateRadius), 1.0);
+      return 1 + static_cast<uint32_t>(ratio * (Mathi::Max(m_Params.m_MaxUpdatePeriod, 1) - 1));
+    }
+
+    void ServerDispatcher::UpdateInterest(Server& iServer, ClientId iClient, ClientInterest& ioInterest)
+    {
+      auto centerIter = m_Objects.find(ioInterest.m_Object);
+      if (centerIter == m_Objects.end())
+      {
+        return;
+      }
+      Vec3 const center = centerIter->second.m_Pos;
+
+      // Already known objects : leave with hysteresis, or throttled update.
+      for (auto iter = ioInterest.m_Relevant.begin(); iter != ioInterest.m_Relevant.end(); )
       {
-        auto dataIter = m_Objects.find(update.first);
-        bool const firstCreation = m_Objects.end() == dataIter;
-        for (auto client : m_ConnectedClients)
+        ClientData const& data = m_Objects[iter->first];
+        float const distance = DistanceXY(data.m_Pos, center);
+        if (distance > m_Params.m_LeaveRadius && iter->first != ioInterest.m_Object)
         {
-          if (firstCreation)
+          iServer.DeleteObject(iClient, iter->first);
+          iter = ioInterest.m_Relevant.erase(iter);
+          continue;
+        }
+
+        RelevantObject& relevant = iter->second;
+        if (m_UpdateFrame[iter->first] > relevant.m_SentFrame
+          && m_Frame - relevant.m_SentFrame >= GetUpdatePeriod(distance))
+        {
+          iServer.UpdateObject(iClient, iter->first, data);
+          relevant.m_SentFrame = m_Frame;
+        }
+        ++iter;
+      }
+
+      // New objects.
+      RelevantObject newEntry = { m_Frame };
+      if (ioInterest.m_Relevant.insert(std::make_pair(ioInterest.m_Object, newEntry)).second)
+      {
+        iServer.CreateObject(iClient, ioInterest.m_Object, centerIter->second);
+      }
+
+      int32_t const minX = GetCellCoord(center.x - m_Params.m_EnterRadius, m_Params.m_CellSize);
+      int32_t const maxX = GetCellCoord(center.x + m_Params.m_EnterRadius, m_Params.m_CellSize);
+      int32_t const minY = GetCellCoord(center.y - m_Params.m_EnterRadius, m_Params.m_CellSize);
+      int32_t const maxY = GetCellCoord(center.y + m_Params.m_EnterRadius, m_Params.m_CellSize);
+      for (int32_t y = minY; y <= maxY; ++y)
+      {
+        for (int32_t x = minX; x <= maxX; ++x)
+        {
+          auto cell = m_Grid.find(GetCellKey(x, y));
+          if (cell == m_Grid.end())
           {
-            iServer.CreateObject(client.first, update.first, update.second);
+            continue;
           }
-          else
+          for (ObjectId object : cell->second)
           {
-            iServer.UpdateObject(client.first, update.first, update.second);
+            ClientData const& data = m_Objects[object];
+            if (DistanceXY(data.m_Pos, center) <= m_Params.m_EnterRadius
+              && ioInterest.m_Relevant.insert(std::make_pair(object, newEntry)).second)
+            {
+              iServer.CreateObject(iClient, object, data);
+            }
           }
         }
-        if (firstCreation)
-        {
-          m_Objects.insert(update).first;
-        }
-        else
+      }
+    }
+
+    void ServerDispatcher::Flush(Server& iServer)
+    {
+      eXl_PROFILE_ZONE("ServerDispatcher::Flush");
+      eXl_PROFILE_COUNTER("Net object updates", m_PendingUpdates.size());
+      eXl_PROFILE_COUNTER("Net object deletions", m_DeletedObjects.size());
+      ++m_Frame;
+
+      for (auto const& obj : m_DeletedObjects)
+      {
+        m_Objects.erase(obj);
+        m_PendingUpdates.erase(obj);
+        m_UpdateFrame.erase(obj);
+        for (auto& client : m_Interests)
         {
-          dataIter->second = update.second;
+          if (client.second.m_Relevant.erase(obj) != 0)
+          {
+            iServer.DeleteObject(client.first, obj);
+          }
         }
       }
+      m_DeletedObjects.clear();
+
+      for (auto const& update : m_PendingUpdates)
+      {
+        m_Objects[update.first] = update.second;
+        m_UpdateFrame[update.first] = m_Frame;
+      }
       m_PendingUpdates.clear();
 
       for (auto const& newClient : m_NewClients)
       {
-        for (auto const& object : m_Objects)
-        {
-          iServer.CreateObject(newClient.first, object.first, object.second);
-        }
         m_ConnectedClients.insert(newClient);
+        ClientInterest& interest = m_Interests[newClient.first];
+        interest.m_Object = newClient.second;
+        interest.m_Relevant.clear();
       }
       m_NewClients.clear();
+
+      BuildGrid();
+
+      for (auto& client : m_Interests)
+      {
+        UpdateInterest(iServer, client.first, client.second);
+      }
     }
   }
 }
\ No newline at end of file
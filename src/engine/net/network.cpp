@@ -178,7 +178,11 @@ namespace eXl
       for (auto const& cmdName : iDriver.m_CommandsByName)
       {
         uint32_t targetId = m_CommandsHash.Compute(cmdName.first.get());
-        m_Commands.insert(std::make_pair(targetId, &iDriver.m_Commands[cmdName.second]));
+        if (targetId >= m_Commands.size())
+        {
+          m_Commands.resize(targetId + 1, nullptr);
+        }
+        m_Commands[targetId] = &iDriver.m_Commands[cmdName.second];
         m_CommandsTable.insert(std::make_pair(functions[cmdName.second], targetId));
       }
     }
@@ -195,16 +199,20 @@ namespace eXl
       for (auto const& cmdName : iDriver.m_CommandsByName)
       {
         uint32_t targetId = m_CommandsHash.Compute(cmdName.first.get());
-        m_Commands.insert(std::make_pair(targetId, &iDriver.m_Commands[cmdName.second]));
+        if (targetId >= m_Commands.size())
+        {
+          m_Commands.resize(targetId + 1, nullptr);
+        }
+        m_Commands[targetId] = &iDriver.m_Commands[cmdName.second];
         m_CommandsTable.insert(std::make_pair(functions[cmdName.second], targetId));
       }
     }
 
     void CommandDictionary::ReceiveCommand(uint64_t iClient, uint32_t iId, ConstDynObject const& iArgs, DynObject& oRes) const
     {
-      auto iter = m_Commands.find(iId);
-      eXl_ASSERT_REPAIR_RET(iter != m_Commands.end(), void());
-      iter->second->m_Callback(iClient, iArgs, oRes);
+      CommandDesc const* cmd = GetCommand(iId);
+      eXl_ASSERT_REPAIR_RET(cmd != nullptr, void());
+      cmd->m_Callback(iClient, iArgs, oRes);
     }
 
     Err CommandHandler::Enqueue(CommandCallData&& iCall)
@@ -213,7 +221,7 @@ namespace eXl
       newCommand.m_Args = std::move(iCall.m_Args);
       auto iter = m_Dictionary.m_CommandsTable.find(iCall.m_CommandPtr);
       eXl_ASSERT_REPAIR_RET(iter != m_Dictionary.m_CommandsTable.end(), Err::Failure);
-      CommandDesc const* cmd = m_Dictionary.m_Commands.find(iter->second)->second;
+      CommandDesc const* cmd = m_Dictionary.GetCommand(iter->second);
       newCommand.m_CommandId = iter->second;
       newCommand.m_Reliable = cmd->m_Reliable;
       newCommand.m_CompletionCallback = std::move(iCall.m_CompletionCallback);
@@ -22,9 +22,14 @@ namespace eXl
       void Build(NetDriver const&);
       void Build_Client(NetDriver const&);
       void ReceiveCommand(uint64_t iClient, uint32_t iId, ConstDynObject const& iArgs, DynObject& oRes) const;
+      CommandDesc const* GetCommand(uint32_t iId) const
+      {
+        return iId < m_Commands.size() ? m_Commands[iId] : nullptr;
+      }
       StringMPH m_CommandsHash;
       UnorderedMap<void*, uint32_t> m_CommandsTable;
-      UnorderedMap<uint32_t, CommandDesc const*> m_Commands;
+      // Indexed by the perfect hash of the command name.
+      Vector<CommandDesc const*> m_Commands;
     };
 
     struct OutgoingCommand
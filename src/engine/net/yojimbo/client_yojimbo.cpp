@@ -1,5 +1,6 @@
 #include "network_yojimbo.hpp"
 #include <thread>
+#include <algorithm>
 
 namespace eXl
 {
@@ -28,6 +29,21 @@ namespace eXl
 
     Client_Impl::~Client_Impl() = default;
 
+    namespace
+    {
+      void EraseReported(ClientReplication& ioReplication, ObjectId iObject)
+      {
+        auto iter = std::lower_bound(ioReplication.m_Reported.begin(), ioReplication.m_Reported.end(), iObject.id, [](SnapshotEntry const& iEntry, uint64_t iId)
+          {
+            return iEntry.m_Object.id < iId;
+          });
+        if (iter != ioReplication.m_Reported.end() && iter->m_Object == iObject)
+        {
+          ioReplication.m_Reported.erase(iter);
+        }
+      }
+    }
+
     void Client_Impl::ClientSendLoopbackPacket(int clientIndex, const uint8_t* packetData, int packetBytes, uint64_t packetSequence)
     {
       m_eXlClient->m_Ctx.m_Server->GetImpl().m_Server.ProcessLoopbackPacket(clientIndex, packetData, packetBytes, packetSequence);
@@ -125,6 +141,9 @@ namespace eXl
       case GameMessageType::OBJECT_CREATE:
       {
         UpdateMessage const& update = static_cast<UpdateMessage const&>(iMessage);
+        // The next batch reports the replicated state, even if it did not change.
+        m_Replication.m_LiveObjects.insert(update.m_Object);
+        EraseReported(m_Replication, update.m_Object);
         auto& cb = m_eXlClient->m_Ctx.m_ClientEvents.OnNewObject;
         if (cb)
         {
@@ -132,19 +151,16 @@ namespace eXl
         }
       }
       break;
-      case GameMessageType::OBJECT_UPDATE:
+      case GameMessageType::OBJECT_BATCH:
       {
-        UpdateMessage const& update = static_cast<UpdateMessage const&>(iMessage);
-        auto& cb = m_eXlClient->m_Ctx.m_ClientEvents.OnObjectUpdated;
-        if (cb)
-        {
-          cb(m_LocalIndex, update.m_Object, update.m_Data);
-        }
+        ProcessBatch(static_cast<ObjectBatchMessage const&>(iMessage));
       }
       break;
       case GameMessageType::OBJECT_DELETE:
       {
         UpdateMessage const& update = static_cast<UpdateMessage const&>(iMessage);
+        m_Replication.m_LiveObjects.erase(update.m_Object);
+        EraseReported(m_Replication, update.m_Object);
         auto& cb = m_eXlClient->m_Ctx.m_ClientEvents.OnObjectDeleted;
         if (cb)
         {
@@ -159,6 +175,80 @@ namespace eXl
       }
     }
 
+    void Client_Impl::ProcessBatch(yojimbo::ObjectBatchMessage const& iBatch)
+    {
+      ClientReplication& replication = m_Replication;
+      // Batches hold the whole state, older ones can be dropped.
+      if (replication.m_HasApplied && !yojimbo::sequence_greater_than(iBatch.m_Sequence, replication.m_LastApplied))
+      {
+        return;
+      }
+
+      SnapshotEntries const emptyBase;
+      SnapshotEntries const* baseEntries = &emptyBase;
+      if (iBatch.m_BaseOffset != 0)
+      {
+        Snapshot const* base = replication.m_Received.Find(uint16_t(iBatch.m_Sequence - iBatch.m_BaseOffset));
+        if (base == nullptr)
+        {
+          // The server falls back to an older acknowledged snapshot.
+          return;
+        }
+        baseEntries = &base->m_Entries;
+      }
+
+      Snapshot& snapshot = replication.m_Received.Get(iBatch.m_Sequence);
+      snapshot.m_Valid = ApplyBatch(*baseEntries, iBatch, snapshot.m_Entries);
+      if (!snapshot.m_Valid)
+      {
+        LOG_ERROR << "Inconsistent object batch " << std::to_string(iBatch.m_Sequence);
+        return;
+      }
+      snapshot.m_Sequence = iBatch.m_Sequence;
+      replication.m_LastApplied = iBatch.m_Sequence;
+      replication.m_HasApplied = true;
+      replication.m_PendingAck = true;
+
+      auto& cb = m_eXlClient->m_Ctx.m_ClientEvents.OnObjectUpdated;
+      SnapshotEntries& nextReported = replication.m_NextReported;
+      nextReported.clear();
+      auto prevIter = replication.m_Reported.begin();
+      for (SnapshotEntry const& entry : snapshot.m_Entries)
+      {
+        if (replication.m_LiveObjects.count(entry.m_Object) == 0)
+        {
+          continue;
+        }
+        while (prevIter != replication.m_Reported.end() && prevIter->m_Object.id < entry.m_Object.id)
+        {
+          ++prevIter;
+        }
+        bool const changed = prevIter == replication.m_Reported.end()
+          || prevIter->m_Object != entry.m_Object
+          || prevIter->m_State != entry.m_State;
+
+        nextReported.push_back(entry);
+        if (changed && cb)
+        {
+          cb(m_LocalIndex, entry.m_Object, Dequantize(entry.m_State));
+        }
+      }
+      replication.m_Reported.swap(nextReported);
+    }
+
+    void Client_Impl::Flush()
+    {
+      using namespace yojimbo;
+      if (m_Replication.m_PendingAck && m_Client.IsConnected())
+      {
+        ObjectAckMessage* message = (ObjectAckMessage*)m_Client.CreateMessage(GameMessageType::OBJECT_ACK);
+        message->m_Sequence = m_Replication.m_LastApplied;
+        m_Client.SendMessage(GameChannel::UNRELIABLE, message);
+        m_Replication.m_PendingAck = false;
+      }
+      m_Client.SendPackets();
+    }
+
     Err Client_Impl::SendServerCommand(CommandCallData&& iCall)
     {
       using namespace yojimbo;
@@ -223,7 +313,7 @@ namespace eXl
 
     void Client::Flush()
     {
-      m_Impl->m_Client.SendPackets();
+      m_Impl->Flush();
     }
 
     uint32_t Client::GetLocalIndex() const
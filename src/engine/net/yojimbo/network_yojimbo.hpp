@@ -23,7 +23,8 @@ namespace yojimbo
     SERVER_REPLY,
     OBJECT_CREATE,
     OBJECT_DELETE,
-    OBJECT_UPDATE,
+    OBJECT_BATCH,
+    OBJECT_ACK,
     MESSAGES_COUNT
   };
 
@@ -90,6 +91,59 @@ namespace yojimbo
     YOJIMBO_VIRTUAL_SERIALIZE_FUNCTIONS();
   };
 
+  //All the object updates sent to a client during a flush.
+  //Entries are sorted by object, and are relative to the base snapshot when there is one.
+  class ObjectBatchMessage : public yojimbo::Message
+  {
+  public:
+    enum EntryKind
+    {
+      Delta,
+      Full,
+      Removed
+    };
+
+    struct Entry
+    {
+      eXl::Network::ObjectId m_Object;
+      uint32_t m_Kind;
+      //One bit per value, set when it differs from the base (Delta only).
+      uint32_t m_ChangedMask;
+      bool m_Moving;
+      //Full entries only, the position values hold the raw float bits.
+      bool m_Raw;
+      //Absolute quantized values for Full entries, difference to the base for Delta entries.
+      int32_t m_Values[6];
+    };
+
+    uint16_t m_Sequence;
+    //Distance to the base snapshot, 0 when there is none.
+    uint32_t m_BaseOffset;
+    eXl::Vector<Entry> m_Entries;
+
+    template <typename Stream>
+    bool Serialize(Stream& stream);
+
+    bool SerializeInternal(yojimbo::ReadStream& stream);
+    bool SerializeInternal(yojimbo::WriteStream& stream);
+    bool SerializeInternal(yojimbo::MeasureStream& stream);
+  };
+
+  class ObjectAckMessage : public yojimbo::Message
+  {
+  public:
+    uint16_t m_Sequence;
+
+    template <typename Stream>
+    bool Serialize(Stream& stream)
+    {
+      serialize_bits(stream, m_Sequence, 16);
+      return true;
+    }
+
+    YOJIMBO_VIRTUAL_SERIALIZE_FUNCTIONS();
+  };
+
   YOJIMBO_MESSAGE_FACTORY_START(GameMessageFactory, GameMessageType::MESSAGES_COUNT);
   YOJIMBO_DECLARE_MESSAGE_TYPE(GameMessageType::SEND_MANIFEST, ManifestMessage);
   YOJIMBO_DECLARE_MESSAGE_TYPE(GameMessageType::CLIENT_COMMAND, CommandMessage);
@@ -97,8 +151,9 @@ namespace yojimbo
   YOJIMBO_DECLARE_MESSAGE_TYPE(GameMessageType::CLIENT_REPLY, CommandMessage);
   YOJIMBO_DECLARE_MESSAGE_TYPE(GameMessageType::SERVER_REPLY, CommandMessage);
   YOJIMBO_DECLARE_MESSAGE_TYPE(GameMessageType::OBJECT_CREATE, UpdateMessage);
-  YOJIMBO_DECLARE_MESSAGE_TYPE(GameMessageType::OBJECT_UPDATE, UpdateMessage);
   YOJIMBO_DECLARE_MESSAGE_TYPE(GameMessageType::OBJECT_DELETE, UpdateMessage);
+  YOJIMBO_DECLARE_MESSAGE_TYPE(GameMessageType::OBJECT_BATCH, ObjectBatchMessage);
+  YOJIMBO_DECLARE_MESSAGE_TYPE(GameMessageType::OBJECT_ACK, ObjectAckMessage);
   YOJIMBO_MESSAGE_FACTORY_FINISH();
 
   class NetAlloc : public Allocator
@@ -273,6 +328,115 @@ namespace eXl
       Err ElementEpilogue();
     };
 
+    //Bounds of the replicated object state.
+    struct Replication
+    {
+      static uint32_t constexpr s_SnapshotRingSize = 32;
+      //Keeps a batch well within a packet, the remaining changes are sent on the next flushes.
+      static uint32_t constexpr s_MaxBatchEntries = 160;
+
+      static uint32_t constexpr s_NumValues = 6;
+      static uint32_t constexpr s_NumPosValues = 3;
+
+      //Positions are quantized in [-s_PosBound, s_PosBound] with s_PosResolution steps per unit.
+      //Positions beyond the bound are sent at full precision instead (see QuantizedState::m_Raw).
+      static int32_t constexpr s_PosResolution = 64;
+      static int32_t constexpr s_PosBound = 4096;
+      static int32_t constexpr s_PosMax = s_PosBound * s_PosResolution;
+      static int32_t constexpr s_PosSmallDelta = 128;
+
+      //Directions are clamped to [-1, 1].
+      static int32_t constexpr s_DirMax = 511;
+      static int32_t constexpr s_DirSmallDelta = 32;
+
+      static int32_t GetMaxValue(uint32_t iValue) { return iValue < s_NumPosValues ? s_PosMax : s_DirMax; }
+      static int32_t GetSmallDelta(uint32_t iValue) { return iValue < s_NumPosValues ? s_PosSmallDelta : s_DirSmallDelta; }
+    };
+
+    //Position then direction.
+    struct QuantizedState
+    {
+      int32_t m_Values[Replication::s_NumValues];
+      bool m_Moving;
+      //The position is out of the quantization bounds, and m_Values holds its raw float bits.
+      //Raw states are always sent as Full entries.
+      bool m_Raw;
+
+      bool operator == (QuantizedState const& iOther) const
+      {
+        return m_Moving == iOther.m_Moving && m_Raw == iOther.m_Raw
+          && memcmp(m_Values, iOther.m_Values, sizeof(m_Values)) == 0;
+      }
+      bool operator != (QuantizedState const& iOther) const { return !(*this == iOther); }
+    };
+
+    QuantizedState Quantize(ClientData const& iData);
+    ClientData Dequantize(QuantizedState const& iState);
+
+    struct SnapshotEntry
+    {
+      ObjectId m_Object;
+      QuantizedState m_State;
+    };
+
+    //Sorted by object.
+    using SnapshotEntries = Vector<SnapshotEntry>;
+
+    struct Snapshot
+    {
+      uint16_t m_Sequence = 0;
+      bool m_Valid = false;
+      SnapshotEntries m_Entries;
+    };
+
+    struct SnapshotRing
+    {
+      Snapshot& Get(uint16_t iSequence) { return m_Snapshots[iSequence % Replication::s_SnapshotRingSize]; }
+      //nullptr once the snapshot has been overwritten.
+      Snapshot const* Find(uint16_t iSequence) const;
+      void Clear();
+
+      Snapshot m_Snapshots[Replication::s_SnapshotRingSize];
+    };
+
+    //Rebuilds a snapshot from its base and a batch.
+    bool ApplyBatch(SnapshotEntries const& iBase, yojimbo::ObjectBatchMessage const& iBatch, SnapshotEntries& oEntries);
+
+    struct ServerReplication
+    {
+      struct PendingChange
+      {
+        ObjectId m_Object;
+        QuantizedState m_State;
+        bool m_Removed;
+      };
+
+      void Clear();
+
+      Vector<PendingChange> m_Pending;
+      Vector<yojimbo::ObjectBatchMessage::Entry> m_Changes;
+      //Latest state of the objects the client was sent an update for.
+      SnapshotEntries m_Current;
+      SnapshotRing m_Sent;
+      uint16_t m_Sequence = 0;
+      uint16_t m_AckedSequence = 0;
+      bool m_HasAck = false;
+      //Changes that did not fit in a batch are sent first on the next flush.
+      uint64_t m_Cursor = 0;
+    };
+
+    struct ClientReplication
+    {
+      SnapshotRing m_Received;
+      //State last reported through OnObjectUpdated, for the created objects.
+      SnapshotEntries m_Reported;
+      SnapshotEntries m_NextReported;
+      UnorderedSet<ObjectId> m_LiveObjects;
+      uint16_t m_LastApplied = 0;
+      bool m_HasApplied = false;
+      bool m_PendingAck = false;
+    };
+
     struct SerializationContext
     {
       CommandDictionary m_CmdDictionary;
@@ -301,7 +465,9 @@ namespace eXl
       void ClientSendLoopbackPacket(int clientIndex, const uint8_t* packetData, int packetBytes, uint64_t packetSequence) override;
 
       void Tick();
+      void Flush();
       void ProcessMessage(yojimbo::Message const& iMessage);
+      void ProcessBatch(yojimbo::ObjectBatchMessage const& iBatch);
 
       eXl::Err SendServerCommand(eXl::Network::CommandCallData&& iCall);
 
@@ -313,6 +479,7 @@ namespace eXl
 
       SerializationContext m_SerializationCtx;
       CommandHandler m_Commands;
+      ClientReplication m_Replication;
       bool m_HasManifest = false;
     };
 
@@ -332,6 +499,7 @@ namespace eXl
 
       void Tick();
       void Flush();
+      void FlushObjects(uint32_t iClientIndex);
       void ProcessMessage(uint32_t iClientIndex, yojimbo::Message const& iMessage);
       bool IsValidClientId(ClientId);
 
@@ -348,6 +516,8 @@ namespace eXl
 
       SerializationContext m_SerializationCtx;
       Vector<CommandHandler> m_ClientCmdQueues;
+      ServerReplication m_Replication[yojimbo::MAX_PLAYERS];
+      ReplicationStats m_ReplicationStats;
     };
   }
 }
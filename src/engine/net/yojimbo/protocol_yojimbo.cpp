@@ -9,7 +9,7 @@
 namespace yojimbo
 {
   const uint8_t DEFAULT_PRIVATE_KEY[KeyBytes] = { 0 };
-  const uint64_t s_ProtocolId = 0xE816CB0010000001;
+  const uint64_t s_ProtocolId = 0xE816CB0010000003;
 
   GameConnectionConfig::GameConnectionConfig()
   {
@@ -91,12 +91,12 @@ namespace yojimbo
       return false;
 
     SerializationContext const& ctx = *reinterpret_cast<SerializationContext const*>(stream.GetContext());
-    auto iter = ctx.m_CmdDictionary.m_Commands.find(m_CommandId);
-    if (iter == ctx.m_CmdDictionary.m_Commands.end())
+    CommandDesc const* cmdPtr = ctx.m_CmdDictionary.GetCommand(m_CommandId);
+    if (cmdPtr == nullptr)
     {
       return false;
     }
-    CommandDesc const& cmd = *iter->second;
+    CommandDesc const& cmd = *cmdPtr;
     m_Args.SetType(&cmd.m_FunDesc.GetType(), cmd.m_FunDesc.GetType().Alloc(), true);
 
     Yo_Unstreamer unstreamer(stream);
@@ -130,12 +130,12 @@ namespace yojimbo
       return false;
 
     SerializationContext const& ctx = *reinterpret_cast<SerializationContext const*>(stream.GetContext());
-    auto iter = ctx.m_CmdDictionary.m_Commands.find(m_CommandId);
-    if (iter == ctx.m_CmdDictionary.m_Commands.end())
+    CommandDesc const* cmdPtr = ctx.m_CmdDictionary.GetCommand(m_CommandId);
+    if (cmdPtr == nullptr)
     {
       return false;
     }
-    CommandDesc const& cmd = *iter->second;
+    CommandDesc const& cmd = *cmdPtr;
     Yo_Streamer<WriteStream> streamer(stream);
     if (!streamer.Begin())
     {
@@ -158,12 +158,12 @@ namespace yojimbo
       return false;
 
     SerializationContext const& ctx = *reinterpret_cast<SerializationContext const*>(stream.GetContext());
-    auto iter = ctx.m_CmdDictionary.m_Commands.find(m_CommandId);
-    if (iter == ctx.m_CmdDictionary.m_Commands.end())
+    CommandDesc const* cmdPtr = ctx.m_CmdDictionary.GetCommand(m_CommandId);
+    if (cmdPtr == nullptr)
     {
       return false;
     }
-    CommandDesc const& cmd = *iter->second;
+    CommandDesc const& cmd = *cmdPtr;
     Yo_Streamer<MeasureStream> streamer(stream);
     if (!streamer.Begin())
     {
@@ -223,6 +223,133 @@ namespace yojimbo
   {
     return Serialize(stream);
   }
+
+  namespace
+  {
+    //Entries are sorted, only the gap to the previous object is written.
+    template <typename Stream>
+    bool SerializeObjectGap(Stream& stream, uint64_t& ioGap)
+    {
+      uint32_t sizeClass = 0;
+      if (Stream::IsWriting)
+      {
+        sizeClass = ioGap < (1ull << 8) ? 0
+          : ioGap < (1ull << 16) ? 1
+          : ioGap < (1ull << 32) ? 2 : 3;
+      }
+      serialize_bits(stream, sizeClass, 2);
+      if (sizeClass == 3)
+      {
+        serialize_uint64(stream, ioGap);
+      }
+      else
+      {
+        uint32_t gap = uint32_t(ioGap);
+        serialize_bits(stream, gap, 8 << sizeClass);
+        ioGap = gap;
+      }
+      return true;
+    }
+
+    template <typename Stream>
+    bool SerializeDelta(Stream& stream, int32_t& ioDelta, int32_t iSmallDelta, int32_t iMaxValue)
+    {
+      bool isSmall = Stream::IsWriting && ioDelta >= -iSmallDelta && ioDelta < iSmallDelta;
+      serialize_bool(stream, isSmall);
+      if (isSmall)
+      {
+        serialize_int(stream, ioDelta, -iSmallDelta, iSmallDelta - 1);
+      }
+      else
+      {
+        serialize_int(stream, ioDelta, -2 * iMaxValue, 2 * iMaxValue);
+      }
+      return true;
+    }
+  }
+
+  template <typename Stream>
+  bool ObjectBatchMessage::Serialize(Stream& stream)
+  {
+    using eXl::Network::Replication;
+
+    serialize_bits(stream, m_Sequence, 16);
+    serialize_int(stream, m_BaseOffset, 0, Replication::s_SnapshotRingSize - 1);
+
+    int32_t numEntries = m_Entries.size();
+    serialize_int(stream, numEntries, 0, Replication::s_MaxBatchEntries);
+    if (Stream::IsReading)
+    {
+      m_Entries.resize(numEntries);
+    }
+
+    uint64_t prevObject = 0;
+    for (Entry& entry : m_Entries)
+    {
+      uint64_t gap = entry.m_Object.id - prevObject;
+      if (!SerializeObjectGap(stream, gap)
+        || (gap == 0 && &entry != m_Entries.data()))
+      {
+        return false;
+      }
+      entry.m_Object.id = prevObject + gap;
+      prevObject = entry.m_Object.id;
+
+      serialize_int(stream, entry.m_Kind, Delta, Removed);
+      if (entry.m_Kind == Removed)
+      {
+        continue;
+      }
+      serialize_bool(stream, entry.m_Moving);
+
+      if (entry.m_Kind == Full)
+      {
+        serialize_bool(stream, entry.m_Raw);
+        for (uint32_t i = 0; i < Replication::s_NumValues; ++i)
+        {
+          if (entry.m_Raw && i < Replication::s_NumPosValues)
+          {
+            uint32_t rawValue = uint32_t(entry.m_Values[i]);
+            serialize_bits(stream, rawValue, 32);
+            entry.m_Values[i] = int32_t(rawValue);
+            continue;
+          }
+          int32_t const maxValue = Replication::GetMaxValue(i);
+          serialize_int(stream, entry.m_Values[i], -maxValue, maxValue);
+        }
+      }
+      else
+      {
+        serialize_bits(stream, entry.m_ChangedMask, Replication::s_NumValues);
+        for (uint32_t i = 0; i < Replication::s_NumValues; ++i)
+        {
+          if (entry.m_ChangedMask & (1 << i))
+          {
+            if (!SerializeDelta(stream, entry.m_Values[i], Replication::GetSmallDelta(i), Replication::GetMaxValue(i)))
+            {
+              return false;
+            }
+          }
+        }
+      }
+    }
+    return true;
+  }
+
+  bool ObjectBatchMessage::SerializeInternal(yojimbo::ReadStream& stream)
+  {
+    return Serialize(stream);
+  }
+
+  bool ObjectBatchMessage::SerializeInternal(yojimbo::WriteStream& stream)
+  {
+    return Serialize(stream);
+  }
+
+  bool ObjectBatchMessage::SerializeInternal(yojimbo::MeasureStream& stream)
+  {
+    return Serialize(stream);
+  }
 }
 
 namespace eXl
@@ -234,5 +361,143 @@ namespace eXl
       static yojimbo::NetAlloc s_Alloc;
       return s_Alloc;
     }
+
+    QuantizedState Quantize(ClientData const& iData)
+    {
+      QuantizedState state;
+      state.m_Raw = false;
+      for (uint32_t i = 0; i < 3; ++i)
+      {
+        // NaN fails the comparison as well and goes through untouched.
+        state.m_Raw |= !(Mathf::Abs(iData.m_Pos[i]) <= Replication::s_PosBound);
+      }
+      if (state.m_Raw)
+      {
+        static bool s_Warned = false;
+        if (!s_Warned)
+        {
+          LOG_WARNING << "Replicated position out of the +/-" << std::to_string(Replication::s_PosBound)
+            << " quantization range, sending it at full precision";
+          s_Warned = true;
+        }
+      }
+      for (uint32_t i = 0; i < 3; ++i)
+      {
+        if (state.m_Raw)
+        {
+          memcpy(&state.m_Values[i], &iData.m_Pos[i], sizeof(float));
+        }
+        else
+        {
+          state.m_Values[i] = int32_t(Mathf::Floor(iData.m_Pos[i] * Replication::s_PosResolution + 0.5));
+        }
+        float const dir = Mathf::Clamp(iData.m_Dir[i], -1.0, 1.0);
+        state.m_Values[Replication::s_NumPosValues + i] = int32_t(Mathf::Floor(dir * Replication::s_DirMax + 0.5));
+      }
+      state.m_Moving = iData.m_Moving;
+      return state;
+    }
+
+    ClientData Dequantize(QuantizedState const& iState)
+    {
+      ClientData data;
+      for (uint32_t i = 0; i < 3; ++i)
+      {
+        if (iState.m_Raw)
+        {
+          memcpy(&data.m_Pos[i], &iState.m_Values[i], sizeof(float));
+        }
+        else
+        {
+          data.m_Pos[i] = float(iState.m_Values[i]) / Replication::s_PosResolution;
+        }
+        data.m_Dir[i] = float(iState.m_Values[Replication::s_NumPosValues + i]) / Replication::s_DirMax;
+      }
+      data.m_Moving = iState.m_Moving;
+      return data;
+    }
+
+    Snapshot const* SnapshotRing::Find(uint16_t iSequence) const
+    {
+      Snapshot const& snapshot = m_Snapshots[iSequence % Replication::s_SnapshotRingSize];
+      return snapshot.m_Valid && snapshot.m_Sequence == iSequence ? &snapshot : nullptr;
+    }
+
+    void SnapshotRing::Clear()
+    {
+      for (Snapshot& snapshot : m_Snapshots)
+      {
+        snapshot.m_Valid = false;
+        snapshot.m_Entries.clear();
+      }
+    }
+
+    bool ApplyBatch(SnapshotEntries const& iBase, yojimbo::ObjectBatchMessage const& iBatch, SnapshotEntries& oEntries)
+    {
+      using yojimbo::ObjectBatchMessage;
+
+      oEntries.clear();
+      oEntries.reserve(iBase.size() + iBatch.m_Entries.size());
+      auto baseIter = iBase.begin();
+      for (ObjectBatchMessage::Entry const& entry : iBatch.m_Entries)
+      {
+        while (baseIter != iBase.end() && baseIter->m_Object.id < entry.m_Object.id)
+        {
+          oEntries.push_back(*baseIter);
+          ++baseIter;
+        }
+        bool const inBase = baseIter != iBase.end() && baseIter->m_Object == entry.m_Object;
+        if (entry.m_Kind != ObjectBatchMessage::Full && !inBase)
+        {
+          return false;
+        }
+        if (entry.m_Kind == ObjectBatchMessage::Delta && baseIter->m_State.m_Raw)
+        {
+          return false;
+        }
+
+        if (entry.m_Kind != ObjectBatchMessage::Removed)
+        {
+          SnapshotEntry newEntry;
+          newEntry.m_Object = entry.m_Object;
+          if (entry.m_Kind == ObjectBatchMessage::Full)
+          {
+            memcpy(newEntry.m_State.m_Values, entry.m_Values, sizeof(entry.m_Values));
+            newEntry.m_State.m_Raw = entry.m_Raw;
+          }
+          else
+          {
+            newEntry.m_State = baseIter->m_State;
+            for (uint32_t i = 0; i < Replication::s_NumValues; ++i)
+            {
+              if (entry.m_ChangedMask & (1 << i))
+              {
+                newEntry.m_State.m_Values[i] += entry.m_Values[i];
+              }
+            }
+          }
+          newEntry.m_State.m_Moving = entry.m_Moving;
+          oEntries.push_back(newEntry);
+        }
+
+        if (inBase)
+        {
+          ++baseIter;
+        }
+      }
+      oEntries.insert(oEntries.end(), baseIter, iBase.end());
+      return true;
+    }
+
+    void ServerReplication::Clear()
+    {
+      m_Pending.clear();
+      m_Current.clear();
+      m_Sent.Clear();
+      m_Sequence = 0;
+      m_AckedSequence = 0;
+      m_HasAck = false;
+      m_Cursor = 0;
+    }
   }
 }
\ No newline at end of file
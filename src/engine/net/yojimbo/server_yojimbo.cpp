@@ -1,6 +1,8 @@
 
 #include "network_yojimbo.hpp"
 
+#include <algorithm>
+
 namespace eXl
 {
   namespace Network
@@ -36,6 +38,7 @@ namespace eXl
       memcpy(data, m_SerializationCtx.m_CmdDictionary.m_CommandsHash.GetData().m_RankTable.data(), arraySize * sizeof(uint32_t));
 
       m_Server.SendMessage(clientIndex, GameChannel::RELIABLE, message);
+      m_Replication[clientIndex].Clear();
 
       auto& cb = m_eXlServer->m_Ctx.m_ServerEvents.OnClientConnected;
       if (cb)
@@ -52,6 +55,7 @@ namespace eXl
         cb(GetClientId(clientIndex, m_ClientSlotGeneration));
       }
       m_ClientCmdQueues[clientIndex].Clear();
+      m_Replication[clientIndex].Clear();
       ReleaseClientId(clientIndex, m_ClientSlotGeneration);
     }
 
@@ -127,6 +131,17 @@ namespace eXl
         m_ClientCmdQueues[iClientIndex].ReceiveResponse(cmd.m_QueryId, cmd.m_Args);
       }
       break;
+      case GameMessageType::OBJECT_ACK:
+      {
+        ObjectAckMessage const& ack = static_cast<ObjectAckMessage const&>(iMessage);
+        ServerReplication& replication = m_Replication[iClientIndex];
+        if (!replication.m_HasAck || sequence_greater_than(ack.m_Sequence, replication.m_AckedSequence))
+        {
+          replication.m_AckedSequence = ack.m_Sequence;
+          replication.m_HasAck = true;
+        }
+      }
+      break;
       default:
         eXl_ASSERT_MSG(false, "Unrecognized message");
         break;
@@ -150,11 +165,11 @@ namespace eXl
       using namespace yojimbo;
       eXl_ASSERT_REPAIR_RET(IsValidClientId(iClient), void());
 
-      uint32_t clientIndex = GetClientIndexFromId(iClient);
-      UpdateMessage* message = (UpdateMessage*)m_Server.CreateMessage(clientIndex, GameMessageType::OBJECT_UPDATE);
-      message->m_Object = iObject;
-      message->m_Data = iData;
-      m_Server.SendMessage(clientIndex, GameChannel::RELIABLE, message);
+      ServerReplication::PendingChange change;
+      change.m_Object = iObject;
+      change.m_State = Quantize(iData);
+      change.m_Removed = false;
+      m_Replication[GetClientIndexFromId(iClient)].m_Pending.push_back(change);
     }
 
     void Server_Impl::DeleteObject(ClientId iClient, ObjectId iObject)
@@ -166,6 +181,11 @@ namespace eXl
       UpdateMessage* message = (UpdateMessage*)m_Server.CreateMessage(clientIndex, GameMessageType::OBJECT_DELETE);
       message->m_Object = iObject;
       m_Server.SendMessage(clientIndex, GameChannel::RELIABLE, message);
+
+      ServerReplication::PendingChange change;
+      change.m_Object = iObject;
+      change.m_Removed = true;
+      m_Replication[clientIndex].m_Pending.push_back(change);
     }
 
     Err Server_Impl::SendClientCommand(CommandCallData&& iCall, ClientId iClient)
@@ -194,12 +214,163 @@ namespace eXl
               message->m_Args = std::move(iArgs);
               m_Server.SendMessage(i, iIsReliable ? GameChannel::RELIABLE : GameChannel::UNRELIABLE, message);
             });
+          FlushObjects(i);
         }
       }
 
       m_Server.SendPackets();
     }
 
+    void Server_Impl::FlushObjects(uint32_t iClientIndex)
+    {
+      using namespace yojimbo;
+      ServerReplication& replication = m_Replication[iClientIndex];
+
+      if (!replication.m_Pending.empty())
+      {
+        auto& pending = replication.m_Pending;
+        std::stable_sort(pending.begin(), pending.end(), [](ServerReplication::PendingChange const& iChange1, ServerReplication::PendingChange const& iChange2)
+          {
+            return iChange1.m_Object.id < iChange2.m_Object.id;
+          });
+
+        SnapshotEntries merged;
+        merged.reserve(replication.m_Current.size() + pending.size());
+        auto curIter = replication.m_Current.begin();
+        for (uint32_t i = 0; i < pending.size(); ++i)
+        {
+          // The last change of an object wins.
+          ServerReplication::PendingChange const& change = pending[i];
+          if (i + 1 < pending.size() && pending[i + 1].m_Object == change.m_Object)
+          {
+            continue;
+          }
+          while (curIter != replication.m_Current.end() && curIter->m_Object.id < change.m_Object.id)
+          {
+            merged.push_back(*curIter);
+            ++curIter;
+          }
+          if (curIter != replication.m_Current.end() && curIter->m_Object == change.m_Object)
+          {
+            ++curIter;
+          }
+          if (!change.m_Removed)
+          {
+            merged.push_back(SnapshotEntry{ change.m_Object, change.m_State });
+          }
+        }
+        merged.insert(merged.end(), curIter, replication.m_Current.end());
+        replication.m_Current.swap(merged);
+        pending.clear();
+      }
+
+      // The client has the acknowledged snapshot, unless it is too old to be referenced.
+      Snapshot const* base = nullptr;
+      if (replication.m_HasAck
+        && uint16_t(replication.m_Sequence - replication.m_AckedSequence) < Replication::s_SnapshotRingSize)
+      {
+        base = replication.m_Sent.Find(replication.m_AckedSequence);
+      }
+      SnapshotEntries const emptyBase;
+      SnapshotEntries const& baseEntries = base ? base->m_Entries : emptyBase;
+
+      auto& changes = replication.m_Changes;
+      changes.clear();
+      auto baseIter = baseEntries.begin();
+      auto addRemovedUntil = [&](uint64_t iObject)
+      {
+        for (; baseIter != baseEntries.end() && baseIter->m_Object.id < iObject; ++baseIter)
+        {
+          ObjectBatchMessage::Entry removed;
+          removed.m_Object = baseIter->m_Object;
+          removed.m_Kind = ObjectBatchMessage::Removed;
+          changes.push_back(removed);
+        }
+      };
+      for (SnapshotEntry const& entry : replication.m_Current)
+      {
+        addRemovedUntil(entry.m_Object.id);
+        ObjectBatchMessage::Entry change;
+        change.m_Object = entry.m_Object;
+        change.m_Moving = entry.m_State.m_Moving;
+        change.m_ChangedMask = 0;
+        change.m_Raw = false;
+        QuantizedState const* baseState = nullptr;
+        if (baseIter != baseEntries.end() && baseIter->m_Object == entry.m_Object)
+        {
+          baseState = &baseIter->m_State;
+          ++baseIter;
+          if (*baseState == entry.m_State)
+          {
+            continue;
+          }
+        }
+        // Raw float bits do not make meaningful deltas.
+        if (baseState && !baseState->m_Raw && !entry.m_State.m_Raw)
+        {
+          change.m_Kind = ObjectBatchMessage::Delta;
+          for (uint32_t i = 0; i < Replication::s_NumValues; ++i)
+          {
+            change.m_Values[i] = entry.m_State.m_Values[i] - baseState->m_Values[i];
+            change.m_ChangedMask |= change.m_Values[i] != 0 ? 1 << i : 0;
+          }
+        }
+        else
+        {
+          change.m_Kind = ObjectBatchMessage::Full;
+          change.m_Raw = entry.m_State.m_Raw;
+          memcpy(change.m_Values, entry.m_State.m_Values, sizeof(change.m_Values));
+        }
+        changes.push_back(change);
+      }
+      addRemovedUntil(UINT64_MAX);
+
+      if (changes.empty())
+      {
+        return;
+      }
+
+      ObjectBatchMessage* message = (ObjectBatchMessage*)m_Server.CreateMessage(iClientIndex, GameMessageType::OBJECT_BATCH);
+      message->m_Sequence = replication.m_Sequence;
+      message->m_BaseOffset = base ? uint16_t(replication.m_Sequence - replication.m_AckedSequence) : 0;
+      if (changes.size() <= Replication::s_MaxBatchEntries)
+      {
+        message->m_Entries.swap(changes);
+      }
+      else
+      {
+        // Round robin over the objects, starting where the previous batch stopped.
+        auto start = std::lower_bound(changes.begin(), changes.end(), replication.m_Cursor, [](ObjectBatchMessage::Entry const& iEntry, uint64_t iObject)
+          {
+            return iEntry.m_Object.id < iObject;
+          });
+        std::rotate(changes.begin(), start, changes.end());
+        changes.resize(Replication::s_MaxBatchEntries);
+        replication.m_Cursor = changes.back().m_Object.id + 1;
+        std::sort(changes.begin(), changes.end(), [](ObjectBatchMessage::Entry const& iEntry1, ObjectBatchMessage::Entry const& iEntry2)
+          {
+            return iEntry1.m_Object.id < iEntry2.m_Object.id;
+          });
+        message->m_Entries.swap(changes);
+      }
+
+      // Mirrors what the client will rebuild, to be used as a base once acknowledged.
+      Snapshot& sent = replication.m_Sent.Get(replication.m_Sequence);
+      ApplyBatch(baseEntries, *message, sent.m_Entries);
+      sent.m_Sequence = replication.m_Sequence;
+      sent.m_Valid = true;
+      ++replication.m_Sequence;
+
+      MeasureStream measure(GetNetAllocator());
+      measure.SetContext(&m_SerializationCtx);
+      message->SerializeInternal(measure);
+      m_ReplicationStats.m_NumBatches++;
+      m_ReplicationStats.m_NumEntries += message->m_Entries.size();
+      m_ReplicationStats.m_NumBytes += measure.GetBytesProcessed();
+
+      m_Server.SendMessage(iClientIndex, GameChannel::UNRELIABLE, message);
+    }
+
     Server::~Server()
     {}
 
@@ -252,6 +423,11 @@ namespace eXl
       return Uint64ToHex(id);
     }
 
+    ReplicationStats const& Server::GetReplicationStats() const
+    {
+      return m_Impl->m_ReplicationStats;
+    }
+
     const size_t Server::s_PrivateKeySize = yojimbo::KeyBytes;
 
     Server* Server::Start(NetCtx& iCtx, String const& iIPAddr, Vector<uint8_t> const& iPrivateKey)
@@ -22,6 +22,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include "ORCA/ORCAAgent.hpp"
 
 #include <core/random.hpp>
+#include <core/thread/jobsystem.hpp>
 
 //#pragma optimize("", off)
 
@@ -29,6 +30,16 @@ namespace eXl
 {
   IMPLEMENT_RTTI(NavigatorSystem);
 
+  struct NavigatorSystem::CrowdScratch : public HeapObject
+  {
+    CrowdScratch(Random& iRand)
+      : m_VO(iRand)
+    {}
+
+    VelocityObstacle m_VO;
+    RVO::ORCAAgent m_ORCA;
+  };
+
   namespace
   {
     bool TestBoxSegmentExcept(AABB2Df const& iBox, Segmentf const& iSeg, Segmentf const& iSegToExclude, float iTrim)
@@ -275,6 +286,8 @@ namespace eXl
     
   }
 
+  NavigatorSystem::~NavigatorSystem() = default;
+
   void NavigatorSystem::SetNavMesh(NavMesh& iMesh)
   {
     m_NavMesh = &iMesh;
@@ -407,6 +420,44 @@ namespace eXl
     return Err::Failure;
   }
 
+  Err NavigatorSystem::SetDestination(Vector<ObjectHandle> const& iObjects, Vec3 iDest)
+  {
+    Vector<Agent*> agents;
+    Vector<NavMesh::PathQuery> queries;
+    Vec2 destPos2D(iDest.x, iDest.y);
+    for (ObjectHandle object : iObjects)
+    {
+      if (auto agent = GetAgent_Internal(object))
+      {
+        NavMesh::PathQuery query;
+        query.m_Start = Vec2(m_Transforms.GetWorldTransform(object)[3]);
+        query.m_End = destPos2D;
+        queries.push_back(query);
+        agents.push_back(agent);
+      }
+    }
+
+    Vector<Optional<NavMesh::Path>> paths;
+    m_NavMesh->FindPaths(queries, paths);
+
+    Err result = agents.size() == iObjects.size() ? Err::Success : Err::Failure;
+    for (uint32_t i = 0; i < agents.size(); ++i)
+    {
+      if (!paths[i])
+      {
+        result = Err::Failure;
+        continue;
+      }
+      Agent* agent = agents[i];
+      agent->m_HasDest = true;
+      agent->m_Dest = iDest;
+      agent->m_Dest.z = 0;
+      agent->m_CurrentPath = std::move(*paths[i]);
+      agent->m_CurPathStep = agent->m_CurrentPath.m_Edges.size() - 1;
+    }
+    return result;
+  }
+
   Vector<NavigatorSystem::Event> NavigatorSystem::DispatchEvents()
   {
     return std::move(m_Events);
@@ -414,57 +465,120 @@ namespace eXl
 
 //#define USE_ORCA
 
+  template <typename Functor>
+  void NavigatorSystem::ForEachAgentChunk(Functor const& iFn)
+  {
+    uint32_t const numAgents = m_TickAgents.size();
+    JobSystem* jobs = GetWorld().GetJobSystem();
+    if (jobs == nullptr)
+    {
+      uint32_t const numChunks = JobSystem::GetNumChunks(0, numAgents, s_AgentsPerJob);
+      for (uint32_t chunk = 0; chunk < numChunks; ++chunk)
+      {
+        uint32_t chunkBegin = chunk * s_AgentsPerJob;
+        iFn(chunkBegin, std::min(chunkBegin + s_AgentsPerJob, numAgents), chunk, 0);
+      }
+    }
+    else
+    {
+      jobs->ParallelFor(0, numAgents, s_AgentsPerJob, [jobs, &iFn](uint32_t iBegin, uint32_t iEnd, uint32_t iChunk)
+      {
+        iFn(iBegin, iEnd, iChunk, jobs->GetCurrentThreadIndex());
+      });
+    }
+  }
+
   void NavigatorSystem::Tick(float iTime, NeighborhoodExtraction& iNeigh)
   {
     if (m_NavMesh == nullptr)
     {
       return;
     }
-    VelocityObstacle vo(*m_Rand);
-    RVO::ORCAAgent orca;
 
-    m_Agents.Iterate([&](Agents::Handle, Agent& agent)
+    // Resolve everything that is lazily computed, the jobs below only read shared data.
+    GameDataView<Vec3>* velocities = EngineCommon::GetVelocities(GetWorld());
+    m_Obstacles.Iterate([&](Obstacles::Handle, Obstacle& obstacle)
     {
-      if (!(agent.m_HasDest || agent.m_EnableAvoidance))
-      {
-        return;
-      }
+      m_Transforms.GetWorldTransform(obstacle.m_Object);
+      velocities->GetOrCreate(obstacle.m_Object);
+    });
 
-      Obstacle& agentObs = m_Obstacles.Get(agent.m_Obstacle);
-      auto const& transform = m_Transforms.GetWorldTransform(agentObs.m_Object);
-      Vec3 const& curPos = transform[3];
+    m_TickAgents.clear();
+    m_Agents.Iterate([this](Agents::Handle, Agent& agent)
+    {
+      m_TickAgents.push_back(&agent);
+    });
 
-      Vec2 curPos2D(curPos.x, curPos.y);
+    JobSystem* jobs = GetWorld().GetJobSystem();
+    uint32_t const numThreads = jobs ? jobs->GetNumThreads() : 1;
+    while (m_Scratch.size() < numThreads)
+    {
+      m_Scratch.emplace_back(eXl_NEW CrowdScratch(*m_Rand));
+    }
+    m_ChunkUpdates.resize(JobSystem::GetNumChunks(0, m_TickAgents.size(), s_AgentsPerJob));
+    m_AvoidanceResults.resize(m_TickAgents.size());
 
-      if (!agent.m_CurFace.Contains(curPos2D))
-      {
-        if (auto faceIdx = m_NavMesh->FindFace(curPos2D))
-        {
-          agent.m_CurComponent = faceIdx->m_Component;
-          agent.m_CurFaceIdx = faceIdx->m_Face;
-          agent.m_CurFace = m_NavMesh->GetFaces(faceIdx->m_Component)[faceIdx->m_Face].m_Box;
-        }
-        else
-        {
-          agent.m_CurComponent = -1;
-        }
-      }
-      if (agent.m_CurComponent != -1)
+    ForEachAgentChunk([this, iTime](uint32_t iBegin, uint32_t iEnd, uint32_t, uint32_t)
+    {
+      for (uint32_t i = iBegin; i < iEnd; ++i)
       {
-        agent.m_TreadmillDir = GetNavMesh()->GetFaces(agent.m_CurComponent)[agent.m_CurFaceIdx].GetTreadmillDir(curPos2D);
-        agent.m_TreadmillDir *= m_Timestamp % 10000 > 5000 ? -1.0 : 1.0;
+        UpdateAgentFace(*m_TickAgents[i]);
+        HandleAgentPathfinding(*m_TickAgents[i], iTime);
       }
     });
 
-    m_Agents.Iterate([this, iTime](Agents::Handle, Agent& agent)
+    ForEachAgentChunk([this, &iNeigh, iTime](uint32_t iBegin, uint32_t iEnd, uint32_t iChunk, uint32_t iThread)
     {
-      HandleAgentPathfinding(agent, iTime);
+      CrowdScratch& scratch = *m_Scratch[iThread];
+      Vector<NeighbourUpdate>& updates = m_ChunkUpdates[iChunk];
+      updates.clear();
+      for (uint32_t i = iBegin; i < iEnd; ++i)
+      {
+        Agent& agent = *m_TickAgents[i];
+        AvoidanceResult& result = m_AvoidanceResults[i];
+        result.m_PriorityAvoidanceDir = agent.m_PriorityAvoidanceDir;
+        result.m_ResetRank = false;
+        uint32_t const prevNumUpdates = updates.size();
+        HandleAgentAvoidance(iNeigh, scratch.m_VO, scratch.m_ORCA, agent, result, updates, iTime);
+        result.m_NumUpdates = updates.size() - prevNumUpdates;
+      }
     });
 
-    m_Agents.Iterate([this, &iNeigh, iTime, &vo, &orca](Agents::Handle, Agent& agent)
+    // Gather, in agent order.
+    for (uint32_t chunk = 0; chunk < m_ChunkUpdates.size(); ++chunk)
     {
-      HandleAgentAvoidance(iNeigh, vo, orca, agent, iTime);
-    });
+      NeighbourUpdate const* update = m_ChunkUpdates[chunk].data();
+      uint32_t const chunkBegin = chunk * s_AgentsPerJob;
+      uint32_t const chunkEnd = std::min<uint32_t>(chunkBegin + s_AgentsPerJob, m_TickAgents.size());
+      for (uint32_t i = chunkBegin; i < chunkEnd; ++i)
+      {
+        Agent& agent = *m_TickAgents[i];
+        AvoidanceResult const& result = m_AvoidanceResults[i];
+
+        agent.m_PriorityAvoidanceDir = result.m_PriorityAvoidanceDir;
+        if (result.m_ResetRank)
+        {
+          agent.m_Rank = 0;
+          agent.m_RankTimestamp = m_Timestamp;
+        }
+
+        for (uint32_t updateNum = 0; updateNum < result.m_NumUpdates; ++updateNum, ++update)
+        {
+          Agent& otherAgent = *update->m_Target;
+          if (update->m_PropagateRank
+            && otherAgent.m_RankTimestamp < agent.m_RankTimestamp)
+          {
+            otherAgent.m_Rank = agent.m_Rank + 1;
+            otherAgent.m_RankTimestamp = agent.m_RankTimestamp;
+          }
+          if (update->m_Unstuck)
+          {
+            otherAgent.m_UnstuckEnabled = true;
+          }
+          otherAgent.m_AvoidanceDelta += update->m_AvoidanceDelta;
+        }
+      }
+    }
 
     m_Timestamp++;
     if (m_Timestamp == 0)
@@ -476,12 +590,48 @@ namespace eXl
       ++m_Timestamp;
     }
 
-    m_Agents.Iterate([this, iTime](Agents::Handle, Agent& agent)
+    ForEachAgentChunk([this, iTime](uint32_t iBegin, uint32_t iEnd, uint32_t, uint32_t)
     {
-      HandleAgentDiffusion(agent, iTime);
+      for (uint32_t i = iBegin; i < iEnd; ++i)
+      {
+        HandleAgentDiffusion(*m_TickAgents[i], iTime);
+      }
     });
   }
 
+  void NavigatorSystem::UpdateAgentFace(Agent& agent)
+  {
+    if (!(agent.m_HasDest || agent.m_EnableAvoidance))
+    {
+      return;
+    }
+
+    Obstacle& agentObs = m_Obstacles.Get(agent.m_Obstacle);
+    auto const& transform = m_Transforms.GetWorldTransform(agentObs.m_Object);
+    Vec3 const& curPos = transform[3];
+
+    Vec2 curPos2D(curPos.x, curPos.y);
+
+    if (!agent.m_CurFace.Contains(curPos2D))
+    {
+      if (auto faceIdx = m_NavMesh->FindFace(curPos2D))
+      {
+        agent.m_CurComponent = faceIdx->m_Component;
+        agent.m_CurFaceIdx = faceIdx->m_Face;
+        agent.m_CurFace = m_NavMesh->GetFaces(faceIdx->m_Component)[faceIdx->m_Face].m_Box;
+      }
+      else
+      {
+        agent.m_CurComponent = -1;
+      }
+    }
+    if (agent.m_CurComponent != -1)
+    {
+      agent.m_TreadmillDir = GetNavMesh()->GetFaces(agent.m_CurComponent)[agent.m_CurFaceIdx].GetTreadmillDir(curPos2D);
+      agent.m_TreadmillDir *= m_Timestamp % 10000 > 5000 ? -1.0 : 1.0;
+    }
+  }
+
   void NavigatorSystem::HandleAgentPathfinding(Agent& agent, float iTime)
   {
     if (!(agent.m_HasDest || agent.m_EnableAvoidance)
@@ -681,7 +831,7 @@ namespace eXl
     agent.m_HasPriority = treadmillFactor > 1.0 / Mathf::Sqrt(2.0);
   }
 
-  void NavigatorSystem::HandleAgentAvoidance(NeighborhoodExtraction& iNeigh, VelocityObstacle& vo, RVO::ORCAAgent&, Agent& agent, float iTime)
+  void NavigatorSystem::HandleAgentAvoidance(NeighborhoodExtraction& iNeigh, VelocityObstacle& vo, RVO::ORCAAgent& orca, Agent& agent, AvoidanceResult& oResult, Vector<NeighbourUpdate>& oUpdates, float iTime)
   {
     if (!(agent.m_HasDest || agent.m_EnableAvoidance)
       || agent.m_CurComponent == -1)
@@ -706,10 +856,11 @@ namespace eXl
       avoidanceToTransmit = Mathf::Min(1.0, avoidanceToTransmit);
     }
 
+    uint32_t agentRank = agent.m_Rank;
     if (agent.m_UnstuckEnabled)
     {
-      agent.m_Rank = 0;
-      agent.m_RankTimestamp = m_Timestamp;
+      agentRank = 0;
+      oResult.m_ResetRank = true;
     }
 
     float const agentRadius = agentObs.m_Dims.x;
@@ -802,7 +953,7 @@ namespace eXl
         }
 
         GameDataView<Vec3>* velocities = EngineCommon::GetVelocities(GetWorld());
-        Vec3 agentLinVel = velocities->GetOrCreate(agentObs.m_Object);
+        Vec3 agentLinVel = *velocities->GetConst(agentObs.m_Object);
         if (foundNeighEntry != iNeigh.GetObjects().end())
         {
           auto const& neighbours = iNeigh.GetNeigh()[foundNeighEntry->second];
@@ -826,12 +977,11 @@ namespace eXl
                 {
                   if (Agent* otherAgent = m_Agents.TryGet(otherObs->m_Agent))
                   {
-                    if (otherAgent->m_PriorityAvoidance
-                      && otherAgent->m_RankTimestamp < agent.m_RankTimestamp)
-                    {
-                      otherAgent->m_Rank = agent.m_Rank + 1;
-                      otherAgent->m_RankTimestamp = agent.m_RankTimestamp;
-                    }
+                    NeighbourUpdate update;
+                    update.m_Target = otherAgent;
+                    update.m_AvoidanceDelta = 0.0;
+                    update.m_PropagateRank = otherAgent->m_PriorityAvoidance;
+                    update.m_Unstuck = false;
 
                     auto const& otherObjTrans = m_Transforms.GetWorldTransform(otherObj);
                     Vec3 const& otherPos = otherObjTrans[3];
@@ -844,19 +994,24 @@ namespace eXl
                       && agent.m_UnstuckEnabled 
                       &&otherAgent->m_HasPriority)
                     {
-                      otherAgent->m_UnstuckEnabled = true;
+                      update.m_Unstuck = true;
                     }
 
                     if (!otherAgent->m_HasPriority
                       && (!otherAgent->m_PriorityAvoidance
-                        || otherAgent->m_Rank > agent.m_Rank))
+                        || otherAgent->m_Rank > agentRank))
                     {
                       float amountToTransmit = (agent.m_UnstuckEnabled ? 1.0 : avoidanceToTransmit);
                       if (!isInCone)
                       {
                         amountToTransmit *= 0.01;
                       }
-                      otherAgent->m_AvoidanceDelta += amountToTransmit;
+                      update.m_AvoidanceDelta = amountToTransmit;
+                    }
+
+                    if (update.m_PropagateRank || update.m_Unstuck || update.m_AvoidanceDelta != 0.0)
+                    {
+                      oUpdates.push_back(update);
                     }
                   }
                 }
@@ -880,7 +1035,7 @@ namespace eXl
               if (otherObs->m_ObsKind == Obstacle::Sphere)
               {
                 
-                Vec2 otherVel = MathTools::As2DVec(velocities->GetOrCreate(otherObs->m_Object));
+                Vec2 otherVel = MathTools::As2DVec(*velocities->GetConst(otherObs->m_Object));
 
 #ifndef USE_ORCA
                 if (otherObs->m_Agent.IsAssigned())
@@ -901,7 +1056,7 @@ namespace eXl
                         //Vec2 dirOther = (otherPos2D - curPos2D);
                         //dirOther.Normalize();
                         //if (dot(dirOther, testDir) < 0.7)
-                        if (otherAgent->m_Rank >= agent.m_Rank)
+                        if (otherAgent->m_Rank >= agentRank)
                         {
                           continue;
                         }
@@ -973,14 +1128,14 @@ namespace eXl
             }
             else
             {
-              agent.m_PriorityAvoidanceDir = Zero<Vec3>();
+              oResult.m_PriorityAvoidanceDir = Zero<Vec3>();
               break;
             }
           }
 
           if (attempt == priorityAvoidanceAttempt)
           {
-            agent.m_PriorityAvoidanceDir = bestVelocity;
+            oResult.m_PriorityAvoidanceDir = bestVelocity;
           }
         }
       }
@@ -12,9 +12,11 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <boost/graph/connected_components.hpp>
 #include <engine/common/graphutils.hpp>
 #include <math/mathtools.hpp>
-#include <boost/graph/astar_search.hpp>
 #include <engine/pathfinding/penumbratools.hpp>
 
+#include <algorithm>
+#include <mutex>
+
 namespace eXl
 {
   Vec2 NavMesh::Face::GetTreadmillDir(Vec2 const& iPos) const
@@ -464,65 +466,254 @@ namespace eXl
 
   namespace 
   {
-    struct found_goal 
+    using Vertex = NavMesh::Graph::vertex_descriptor;
+
+    // Reused across searches, FindPath is called from the navigator jobs.
+    struct SearchScratch
     {
-      NavMesh::Graph::vertex_descriptor outEdge;
+      struct HeapEntry
+      {
+        bool operator < (HeapEntry const& iOther) const
+        {
+          // Min heap, ties broken on the vertex to stay deterministic.
+          return m_Priority != iOther.m_Priority ? m_Priority > iOther.m_Priority : m_Vtx > iOther.m_Vtx;
+        }
+        float m_Priority;
+        float m_Cost;
+        Vertex m_Vtx;
+      };
+
+      void Reset(uint32_t iNumVertices)
+      {
+        if (m_Stamp.size() < iNumVertices)
+        {
+          m_Stamp.resize(iNumVertices, 0);
+          m_Cost.resize(iNumVertices);
+          m_Link.resize(iNumVertices);
+        }
+        if (++m_CurStamp == 0)
+        {
+          std::fill(m_Stamp.begin(), m_Stamp.end(), 0);
+          m_CurStamp = 1;
+        }
+        m_Heap.clear();
+        m_Chain.clear();
+      }
+
+      bool IsReached(Vertex iVtx) const
+      {
+        return m_Stamp[iVtx] == m_CurStamp;
+      }
+
+      void Reach(Vertex iVtx, Vertex iLink, float iCost, float iPriority)
+      {
+        m_Stamp[iVtx] = m_CurStamp;
+        m_Link[iVtx] = iLink;
+        m_Cost[iVtx] = iCost;
+        m_Heap.push_back({iPriority, iCost, iVtx});
+        std::push_heap(m_Heap.begin(), m_Heap.end());
+      }
+
+      bool Pop(HeapEntry& oEntry)
+      {
+        while (!m_Heap.empty())
+        {
+          std::pop_heap(m_Heap.begin(), m_Heap.end());
+          oEntry = m_Heap.back();
+          m_Heap.pop_back();
+          // Skip entries superseded by a cheaper one.
+          if (oEntry.m_Cost == m_Cost[oEntry.m_Vtx])
+          {
+            return true;
+          }
+        }
+        return false;
+      }
+
+      Vector<uint32_t> m_Stamp;
+      Vector<float> m_Cost;
+      // Predecessor for A*, next vertex towards the goal for flow fields.
+      Vector<Vertex> m_Link;
+      Vector<HeapEntry> m_Heap;
+      Vector<Vertex> m_Chain;
+      uint32_t m_CurStamp = 0;
     };
 
-    class astar_goal_visitor : public boost::default_astar_visitor
+    thread_local SearchScratch s_Scratch;
+
+    Vec2 GetEdgeCenter(NavMesh::Edge const& iEdge)
+    {
+      return (iEdge.segment.m_Ext1 + iEdge.segment.m_Ext2) * 0.5;
+    }
+
+    bool TouchFace(NavMesh::Edge const& iEdge, uint32_t iFace)
+    {
+      return iEdge.face1 == iFace || iEdge.face2 == iFace;
+    }
+
+    template <typename Functor>
+    void ForEachNeighbour(NavMesh::Graph const& iGraph, Vertex iVtx, Functor const& iFn)
     {
-    public:
-      inline astar_goal_visitor(NavMesh::EdgeMap const& iEdges, uint32_t iGoalFace) 
-        : m_Edges(iEdges)
-        , m_Goal(iGoalFace)
+      auto weights = boost::get(boost::edge_weight, iGraph);
+      auto edges = boost::out_edges(iVtx, iGraph);
+      for (auto edge = edges.first; edge != edges.second; ++edge)
       {
+        iFn(boost::target(*edge, iGraph), boost::get(weights, *edge));
       }
+    }
 
-      void examine_vertex(NavMesh::Graph::vertex_descriptor u, NavMesh::Graph const& g) 
+    // A* from iStart, until an edge of iGoalFace is reached. Fills ioScratch.m_Chain, goal first.
+    bool SearchPath(NavMesh::Component const& iComponent, Vertex iStart, uint32_t iGoalFace, Vec2 const& iGoalPt, SearchScratch& ioScratch)
+    {
+      auto heuristic = [&](Vertex iVtx)
       {
-        eXl_ASSERT(u < m_Edges.size());
-        auto const& desc = m_Edges[u];
-        //if(desc != m_Edges.end())
+        return length(GetEdgeCenter(iComponent.m_FaceEdges[iVtx]) - iGoalPt);
+      };
+
+      ioScratch.Reset(boost::num_vertices(iComponent.m_Graph));
+      ioScratch.Reach(iStart, iStart, 0.0, heuristic(iStart));
+
+      SearchScratch::HeapEntry cur;
+      while (ioScratch.Pop(cur))
+      {
+        eXl_ASSERT(cur.m_Vtx < iComponent.m_FaceEdges.size());
+        if (TouchFace(iComponent.m_FaceEdges[cur.m_Vtx], iGoalFace))
         {
-          if(desc.face1 == m_Goal
-          || desc.face2 == m_Goal)
+          for (Vertex v = cur.m_Vtx;; v = ioScratch.m_Link[v])
           {
-            found_goal goal = {u};
-            throw goal;
+            ioScratch.m_Chain.push_back(v);
+            if (ioScratch.m_Link[v] == v)
+            {
+              return true;
+            }
           }
         }
+
+        ForEachNeighbour(iComponent.m_Graph, cur.m_Vtx, [&](Vertex iNeigh, float iWeight)
+        {
+          float const cost = cur.m_Cost + iWeight;
+          if (!ioScratch.IsReached(iNeigh) || cost < ioScratch.m_Cost[iNeigh])
+          {
+            ioScratch.Reach(iNeigh, cur.m_Vtx, cost, cost + heuristic(iNeigh));
+          }
+        });
       }
-    private:
-      NavMesh::EdgeMap const& m_Edges;
-      uint32_t m_Goal;
-    };
+      return false;
+    }
 
-    class distance_heuristic : public boost::astar_heuristic<NavMesh::Graph, float>
+    // Reverse Dijkstra from all the edges of iGoalFace, ioScratch.m_Link leads every reached vertex to the goal.
+    // The edges start at the SearchPath heuristic towards iGoalPt, and the search does not go through them,
+    // so that the chain is the one SearchPath finds.
+    void ComputeFlowField(NavMesh::Component const& iComponent, uint32_t iGoalFace, Vec2 const& iGoalPt, SearchScratch& ioScratch)
     {
-    public:
-      typedef boost::graph_traits<NavMesh::Graph>::vertex_descriptor Vertex;
-      distance_heuristic(NavMesh::EdgeMap const& iEdges, Vec2 iGoalPt) 
-        : m_Edges(iEdges)
-        , m_GoalPt(iGoalPt)
-      {}
+      ioScratch.Reset(boost::num_vertices(iComponent.m_Graph));
+      for (Vertex goalVtx : iComponent.m_Faces[iGoalFace].m_Edges)
+      {
+        float const cost = length(GetEdgeCenter(iComponent.m_FaceEdges[goalVtx]) - iGoalPt);
+        ioScratch.Reach(goalVtx, goalVtx, cost, cost);
+      }
 
-      float operator()(Vertex u)
+      SearchScratch::HeapEntry cur;
+      while (ioScratch.Pop(cur))
       {
-        eXl_ASSERT(u < m_Edges.size());
-        auto const& desc = m_Edges[u];
-        //if(desc != m_Edges.end())
+        ForEachNeighbour(iComponent.m_Graph, cur.m_Vtx, [&](Vertex iNeigh, float iWeight)
         {
-          Vec2 edgeCenter = (desc.segment.m_Ext1 + desc.segment.m_Ext2) * 0.5;
+          if (TouchFace(iComponent.m_FaceEdges[iNeigh], iGoalFace))
+          {
+            return;
+          }
+          float const cost = cur.m_Cost + iWeight;
+          if (!ioScratch.IsReached(iNeigh) || cost < ioScratch.m_Cost[iNeigh])
+          {
+            ioScratch.Reach(iNeigh, cur.m_Vtx, cost, cost);
+          }
+        });
+      }
+    }
 
-          return length(edgeCenter - m_GoalPt);
+    // Fills ioScratch.m_Chain from a flow field, goal first.
+    bool FollowFlowField(Vertex iStart, SearchScratch& ioScratch)
+    {
+      ioScratch.m_Chain.clear();
+      if (!ioScratch.IsReached(iStart))
+      {
+        return false;
+      }
+      for (Vertex v = iStart;; v = ioScratch.m_Link[v])
+      {
+        ioScratch.m_Chain.push_back(v);
+        if (ioScratch.m_Link[v] == v)
+        {
+          break;
         }
+      }
+      std::reverse(ioScratch.m_Chain.begin(), ioScratch.m_Chain.end());
+      return true;
+    }
+  }
+
+  struct NavMesh::PathCache
+  {
+    struct Key
+    {
+      bool operator == (Key const& iOther) const
+      {
+        return m_Component == iOther.m_Component && m_StartFace == iOther.m_StartFace && m_EndFace == iOther.m_EndFace
+          && m_End == iOther.m_End;
+      }
+      uint32_t m_Component;
+      uint32_t m_StartFace;
+      uint32_t m_EndFace;
+      // The search aims at the exact destination.
+      Vec2 m_End;
+    };
 
-        return Mathf::MaxReal();
+    struct KeyHash
+    {
+      size_t operator()(Key const& iKey) const
+      {
+        size_t seed = iKey.m_Component;
+        boost::hash_combine(seed, iKey.m_StartFace);
+        boost::hash_combine(seed, iKey.m_EndFace);
+        boost::hash_combine(seed, iKey.m_End.x);
+        boost::hash_combine(seed, iKey.m_End.y);
+        return seed;
       }
-    private:
-      NavMesh::EdgeMap const& m_Edges;
-      Vec2 m_GoalPt;
     };
+
+    using Entry = std::pair<Key, Optional<Path>>;
+
+    std::mutex m_Mutex;
+    // Most recently used first.
+    List<Entry> m_Entries;
+    UnorderedMap<Key, List<Entry>::iterator, KeyHash> m_Index;
+    uint32_t m_MaxSize = 256;
+  };
+
+  NavMesh::NavMesh()
+    : m_PathCache(std::make_unique<PathCache>())
+  {}
+
+  NavMesh::NavMesh(NavMesh&&) = default;
+  NavMesh& NavMesh::operator=(NavMesh&&) = default;
+  NavMesh::~NavMesh() = default;
+
+  void NavMesh::ClearPathCache()
+  {
+    std::unique_lock<std::mutex> lock(m_PathCache->m_Mutex);
+    m_PathCache->m_Entries.clear();
+    m_PathCache->m_Index.clear();
+  }
+
+  void NavMesh::SetPathCacheSize(uint32_t iNumPaths)
+  {
+    std::unique_lock<std::mutex> lock(m_PathCache->m_Mutex);
+    m_PathCache->m_MaxSize = iNumPaths;
+    while (m_PathCache->m_Entries.size() > iNumPaths)
+    {
+      m_PathCache->m_Index.erase(m_PathCache->m_Entries.back().first);
+      m_PathCache->m_Entries.pop_back();
+    }
   }
 
   Optional<uint32_t> NavMesh::Edge::CommonFace(Edge const& iOther) const
@@ -565,127 +756,239 @@ namespace eXl
     }
   }
 
-  Optional<NavMesh::Path> NavMesh::FindPath(Vec2 const& iStart, Vec2 const& iEnd) const
+  namespace
   {
-    Optional<FoundFace> faceStartId = FindFace(iStart);
-    Optional<FoundFace> faceEndId = FindFace(iEnd);
-
-    if(faceStartId && faceEndId)
+    // Turns a chain of edges, goal first, into a path.
+    Optional<NavMesh::Path> MakePath(NavMesh::Component const& iComponent, uint32_t iComponentIdx, Vector<Vertex> const& iChain, uint32_t iStartFace, uint32_t iEndFace, Vec2 const& iEnd)
     {
-      if(*faceStartId == *faceEndId)
+      uint32_t curFaceId = iEndFace;
+      Vec2 goalPt = iEnd;
+      NavMesh::Path res;
+      res.m_Component = iComponentIdx;
+      res.m_Edges.reserve(iChain.size());
+      res.m_EdgeDirs.reserve(iChain.size());
+      for (auto v : iChain)
       {
-        return NavMesh::Path();
-      }
+        res.m_Edges.push_back(v);
 
-      if (faceStartId->m_Component != faceEndId->m_Component)
-      {
-        return {};
-      }
+        eXl_ASSERT_REPAIR_RET(v < iComponent.m_FaceEdges.size(), {});
 
-      Component const& component = m_Components[faceStartId->m_Component];
+        auto const& edgeDesc = iComponent.m_FaceEdges[v];
+        uint32_t prevFaceId = edgeDesc.face1 == curFaceId ? edgeDesc.face2 : edgeDesc.face1;
 
-      Face const& faceStart = component.m_Faces[faceStartId->m_Face];
-      Face const& faceEnd = component.m_Faces[faceEndId->m_Face];
+        Segmentf const& seg = edgeDesc.segment;
+        auto midPt = (seg.m_Ext1 + seg.m_Ext2) * 0.5;
 
-      eXl_ASSERT_REPAIR_RET(!faceStart.m_Edges.empty() && !faceStart.m_Edges.empty(), {})
+        auto dirToGoal = goalPt - midPt;
+
+        if (length(dirToGoal) < Mathf::ZeroTolerance())
+        {
+          dirToGoal = normalize(seg.m_Ext1 - seg.m_Ext2);
+          res.m_EdgeDirs.push_back(dirToGoal);
+        }
+        else
+        {
+          NavMesh::Face const& curFace = iComponent.m_Faces[curFaceId];
+          NavMesh::Face const& prevFace = iComponent.m_Faces[prevFaceId];
+
+          auto perpDir = GetDirToFace(prevFace.m_Box, curFace.m_Box);
+
+          res.m_EdgeDirs.push_back(perpDir);
+        }
+
+        goalPt = midPt;
+        curFaceId = prevFaceId;
+      }
+
+      if (res.m_Edges.size() >= 2)
       {
-        IndexMap<Graph> outIndex(component.m_Graph);
+        auto const& edge1 = iComponent.m_FaceEdges[*(--res.m_Edges.end())];
+        auto const& edge2 = iComponent.m_FaceEdges[*(--(--res.m_Edges.end()))];
 
-        auto startVtx = faceStart.m_Edges.front();
+        auto commonFaceIdx = edge1.CommonFace(edge2);
 
-        Vector<Graph::vertex_descriptor> p(boost::num_vertices(component.m_Graph), startVtx);
-        try
+        eXl_ASSERT_REPAIR_RET(!(!commonFaceIdx), {});
         {
-          boost::astar_search_tree
-          (component.m_Graph, startVtx,
-            distance_heuristic(component.m_FaceEdges, iEnd),
-            boost::predecessor_map(boost::make_iterator_property_map(p.begin(), outIndex)).
-            visitor(astar_goal_visitor(component.m_FaceEdges, faceEndId->m_Face)));
+          if (*commonFaceIdx == iStartFace)
+          {
+            res.m_Edges.pop_back();
+            res.m_EdgeDirs.pop_back();
+          }
         }
-        catch(found_goal& goal)
+      }
+
+      if (res.m_Edges.size() >= 2)
+      {
+        auto const& edge1 = iComponent.m_FaceEdges[*(res.m_Edges.begin())];
+        auto const& edge2 = iComponent.m_FaceEdges[*(++res.m_Edges.begin())];
+
+        auto commonFaceIdx = edge1.CommonFace(edge2);
+
+        eXl_ASSERT_REPAIR_RET(!(!commonFaceIdx), {});
         {
-          uint32_t curFaceId = faceEndId->m_Face;
-          Vec2 goalPt(iEnd.x, iEnd.y);
-          Path res;
-          res.m_Component = faceStartId->m_Component;
-          for(auto v = goal.outEdge;; v = p[v]) 
+          if (*commonFaceIdx == iEndFace)
           {
-            res.m_Edges.push_back(v);
+            res.m_Edges.erase(res.m_Edges.begin());
+            res.m_EdgeDirs.erase(res.m_EdgeDirs.begin());
+          }
+        }
+      }
 
-            eXl_ASSERT_REPAIR_RET(v < component.m_FaceEdges.size(), {});
+      return res;
+    }
+  }
 
-            auto const& edgeDesc = component.m_FaceEdges[v];
-            //eXl_ASSERT_REPAIR_RET(edgeDesc != component.m_FaceEdges.end(), {})
-            {
-              uint32_t prevFaceId = edgeDesc.face1 == curFaceId ? edgeDesc.face2 : edgeDesc.face1;
+  Optional<NavMesh::Path> NavMesh::ComputePath(FoundFace const& iStart, FoundFace const& iEnd, Vec2 const& iEndPt) const
+  {
+    Component const& component = m_Components[iStart.m_Component];
 
-              Segmentf const& seg = edgeDesc.segment;
-              auto midPt = (seg.m_Ext1 + seg.m_Ext2) * 0.5;
+    Face const& faceStart = component.m_Faces[iStart.m_Face];
+    Face const& faceEnd = component.m_Faces[iEnd.m_Face];
 
-              auto dirToGoal = goalPt - midPt;
+    eXl_ASSERT_REPAIR_RET(!faceStart.m_Edges.empty() && !faceEnd.m_Edges.empty(), {});
 
-              if(length(dirToGoal) < Mathf::ZeroTolerance())
-              {
-                dirToGoal = normalize(seg.m_Ext1 - seg.m_Ext2);
-                res.m_EdgeDirs.push_back(dirToGoal);
-              }
-              else
-              {
-                Face const& curFace = component.m_Faces[curFaceId];
-                Face const& prevFace = component.m_Faces[prevFaceId];
+    SearchScratch& scratch = s_Scratch;
+    if (!SearchPath(component, faceStart.m_Edges.front(), iEnd.m_Face, iEndPt, scratch))
+    {
+      return {};
+    }
 
-                auto perpDir = GetDirToFace(prevFace.m_Box, curFace.m_Box);
+    return MakePath(component, iStart.m_Component, scratch.m_Chain, iStart.m_Face, iEnd.m_Face, iEndPt);
+  }
 
-                res.m_EdgeDirs.push_back(perpDir);
-              }
+  Optional<NavMesh::Path> NavMesh::FindPath(Vec2 const& iStart, Vec2 const& iEnd) const
+  {
+    Optional<FoundFace> faceStartId = FindFace(iStart);
+    Optional<FoundFace> faceEndId = FindFace(iEnd);
 
-              goalPt = midPt;
-              curFaceId = prevFaceId;
-            }
+    if (!faceStartId || !faceEndId)
+    {
+      return {};
+    }
 
-            if(p[v] == v)
-              break;
-          }
+    if (*faceStartId == *faceEndId)
+    {
+      return NavMesh::Path();
+    }
 
-          if(res.m_Edges.size() >= 2)
-          {
-            auto const& edge1 = component.m_FaceEdges[*(--res.m_Edges.end())];
-            auto const& edge2 = component.m_FaceEdges[*(--(--res.m_Edges.end()))];
+    if (faceStartId->m_Component != faceEndId->m_Component)
+    {
+      return {};
+    }
 
-            auto commonFaceIdx = edge1.CommonFace(edge2);
+    PathCache::Key key = {faceStartId->m_Component, faceStartId->m_Face, faceEndId->m_Face, iEnd};
+    {
+      std::unique_lock<std::mutex> lock(m_PathCache->m_Mutex);
+      auto iter = m_PathCache->m_Index.find(key);
+      if (iter != m_PathCache->m_Index.end())
+      {
+        m_PathCache->m_Entries.splice(m_PathCache->m_Entries.begin(), m_PathCache->m_Entries, iter->second);
+        return iter->second->second;
+      }
+    }
 
-            eXl_ASSERT_REPAIR_RET(!(!commonFaceIdx), {});
-            {
-              if(*commonFaceIdx == faceStartId->m_Face)
-              {
-                res.m_Edges.pop_back();
-                res.m_EdgeDirs.pop_back();
-              }
-            }
-          }
+    Optional<Path> path = ComputePath(*faceStartId, *faceEndId, iEnd);
 
-          if(res.m_Edges.size() >= 2)
-          {
-            auto const& edge1 = component.m_FaceEdges[*(res.m_Edges.begin())];
-            auto const& edge2 = component.m_FaceEdges[*(++res.m_Edges.begin())];
+    std::unique_lock<std::mutex> lock(m_PathCache->m_Mutex);
+    if (m_PathCache->m_MaxSize > 0 && m_PathCache->m_Index.count(key) == 0)
+    {
+      if (m_PathCache->m_Entries.size() >= m_PathCache->m_MaxSize)
+      {
+        m_PathCache->m_Index.erase(m_PathCache->m_Entries.back().first);
+        m_PathCache->m_Entries.pop_back();
+      }
+      m_PathCache->m_Entries.push_front(std::make_pair(key, path));
+      m_PathCache->m_Index.insert(std::make_pair(key, m_PathCache->m_Entries.begin()));
+    }
+
+    return path;
+  }
+
+  void NavMesh::FindPaths(Vector<PathQuery> const& iQueries, Vector<Optional<Path>>& oPaths) const
+  {
+    // Below that, a flow field costs more than the cached searches.
+    static constexpr uint32_t s_MinFlowFieldQueries = 4;
+
+    struct PendingQuery
+    {
+      FoundFace m_Start;
+      FoundFace m_End;
+      Vec2 m_EndPt;
+      uint32_t m_Query;
+    };
+
+    oPaths.clear();
+    oPaths.resize(iQueries.size());
+
+    Vector<PendingQuery> pending;
+    for (uint32_t i = 0; i < iQueries.size(); ++i)
+    {
+      Optional<FoundFace> faceStartId = FindFace(iQueries[i].m_Start);
+      Optional<FoundFace> faceEndId = FindFace(iQueries[i].m_End);
+      if (!faceStartId || !faceEndId || faceStartId->m_Component != faceEndId->m_Component)
+      {
+        continue;
+      }
+      if (*faceStartId == *faceEndId)
+      {
+        oPaths[i] = NavMesh::Path();
+        continue;
+      }
+      pending.push_back({*faceStartId, *faceEndId, iQueries[i].m_End, i});
+    }
 
-            auto commonFaceIdx = edge1.CommonFace(edge2);
+    std::sort(pending.begin(), pending.end(), [](PendingQuery const& iA, PendingQuery const& iB)
+    {
+      if (iA.m_End.m_Component != iB.m_End.m_Component)
+      {
+        return iA.m_End.m_Component < iB.m_End.m_Component;
+      }
+      if (iA.m_End.m_Face != iB.m_End.m_Face)
+      {
+        return iA.m_End.m_Face < iB.m_End.m_Face;
+      }
+      if (iA.m_EndPt != iB.m_EndPt)
+      {
+        return iA.m_EndPt.x != iB.m_EndPt.x ? iA.m_EndPt.x < iB.m_EndPt.x : iA.m_EndPt.y < iB.m_EndPt.y;
+      }
+      return iA.m_Query < iB.m_Query;
+    });
+
+    SearchScratch& scratch = s_Scratch;
+    for (uint32_t groupBegin = 0; groupBegin < pending.size();)
+    {
+      uint32_t groupEnd = groupBegin + 1;
+      while (groupEnd < pending.size() && pending[groupEnd].m_End == pending[groupBegin].m_End
+        && pending[groupEnd].m_EndPt == pending[groupBegin].m_EndPt)
+      {
+        ++groupEnd;
+      }
 
-            eXl_ASSERT_REPAIR_RET(!(!commonFaceIdx), {});
+      if (groupEnd - groupBegin < s_MinFlowFieldQueries)
+      {
+        for (uint32_t i = groupBegin; i < groupEnd; ++i)
+        {
+          oPaths[pending[i].m_Query] = FindPath(iQueries[pending[i].m_Query].m_Start, iQueries[pending[i].m_Query].m_End);
+        }
+      }
+      else
+      {
+        FoundFace const& endFace = pending[groupBegin].m_End;
+        Component const& component = m_Components[endFace.m_Component];
+        if (!component.m_Faces[endFace.m_Face].m_Edges.empty())
+        {
+          ComputeFlowField(component, endFace.m_Face, pending[groupBegin].m_EndPt, scratch);
+          for (uint32_t i = groupBegin; i < groupEnd; ++i)
+          {
+            Face const& faceStart = component.m_Faces[pending[i].m_Start.m_Face];
+            if (!faceStart.m_Edges.empty() && FollowFlowField(faceStart.m_Edges.front(), scratch))
             {
-              if(*commonFaceIdx == faceEndId->m_Face)
-              {
-                res.m_Edges.erase(res.m_Edges.begin());
-                res.m_EdgeDirs.erase(res.m_EdgeDirs.begin());
-              }
+              oPaths[pending[i].m_Query] = MakePath(component, endFace.m_Component, scratch.m_Chain, pending[i].m_Start.m_Face, endFace.m_Face, pending[i].m_EndPt);
             }
           }
-
-          return res;
         }
       }
+      groupBegin = groupEnd;
     }
-
-    return {};
   }
-}
\ No newline at end of file
+}
@@ -94,9 +94,6 @@ namespace eXl
 
   void VelocityObstacle::AddObstacle(Vec2 const& iWorldOrig, Vec2 const (&iWorldVecDir)[2], float iDistance)
   {
-    static uint32_t numExec = 0;
-    ++numExec;
-
     Obstacle newObstacle;
 
     Vec2 iOrig(dot(iWorldOrig, m_CasterDesiredDir), dot(iWorldOrig, m_PerpDir));
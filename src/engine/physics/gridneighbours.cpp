@@ -0,0 +1,352 @@
+/*
+Copyright 2009-2021 Nicolas Colombe
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <engine/physics/physicsys_impl.hpp>
+#include <engine/physics/physiccomponent_impl.hpp>
+#include <engine/physics/physicsys.hpp>
+#include <core/thread/jobsystem.hpp>
+
+#include <cfloat>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define EXL_NEIGH_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define EXL_NEIGH_SSE
+#endif
+
+namespace eXl
+{
+  namespace
+  {
+#ifdef EXL_NEIGH_AVX
+    constexpr uint32_t s_Lanes = 8;
+#else
+    constexpr uint32_t s_Lanes = 4;
+#endif
+    //Position of the padding lanes, out of reach of any query.
+    constexpr float s_FarAway = 1.0e30f;
+    //Bounds the grid size when the objects are sparse.
+    constexpr uint32_t s_MaxCellsPerObject = 4;
+    constexpr uint32_t s_ObjectsPerJob = 256;
+
+    struct BlockQuery
+    {
+      float m_PosX;
+      float m_PosY;
+      float m_ReachX;
+      float m_ReachY;
+    };
+
+    struct BlockData
+    {
+      float const* m_PosX;
+      float const* m_PosY;
+      float const* m_ExtX;
+      float const* m_ExtY;
+      float const* m_BoxExtX;
+      float const* m_BoxExtY;
+    };
+
+    //Tests the s_Lanes candidates starting at iIdx.
+    //Returns a bit per overlapping candidate, and writes the squared distances of all of them.
+    inline uint32_t TestBlock(BlockQuery const& iQuery, BlockData const& iData, uint32_t iIdx, float* oSqDist)
+    {
+#if defined(EXL_NEIGH_AVX)
+      __m256 const absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+      __m256 const zero = _mm256_setzero_ps();
+      __m256 const dx = _mm256_and_ps(_mm256_sub_ps(_mm256_loadu_ps(iData.m_PosX + iIdx), _mm256_set1_ps(iQuery.m_PosX)), absMask);
+      __m256 const dy = _mm256_and_ps(_mm256_sub_ps(_mm256_loadu_ps(iData.m_PosY + iIdx), _mm256_set1_ps(iQuery.m_PosY)), absMask);
+      __m256 const reachX = _mm256_add_ps(_mm256_loadu_ps(iData.m_ExtX + iIdx), _mm256_set1_ps(iQuery.m_ReachX));
+      __m256 const reachY = _mm256_add_ps(_mm256_loadu_ps(iData.m_ExtY + iIdx), _mm256_set1_ps(iQuery.m_ReachY));
+      __m256 const overlap = _mm256_and_ps(_mm256_cmp_ps(dx, reachX, _CMP_LE_OQ), _mm256_cmp_ps(dy, reachY, _CMP_LE_OQ));
+
+      __m256 const boxDx = _mm256_max_ps(_mm256_sub_ps(dx, _mm256_loadu_ps(iData.m_BoxExtX + iIdx)), zero);
+      __m256 const boxDy = _mm256_max_ps(_mm256_sub_ps(dy, _mm256_loadu_ps(iData.m_BoxExtY + iIdx)), zero);
+      _mm256_storeu_ps(oSqDist, _mm256_add_ps(_mm256_mul_ps(boxDx, boxDx), _mm256_mul_ps(boxDy, boxDy)));
+
+      return _mm256_movemask_ps(overlap);
+#elif defined(EXL_NEIGH_SSE)
+      __m128 const absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+      __m128 const zero = _mm_setzero_ps();
+      __m128 const dx = _mm_and_ps(_mm_sub_ps(_mm_loadu_ps(iData.m_PosX + iIdx), _mm_set1_ps(iQuery.m_PosX)), absMask);
+      __m128 const dy = _mm_and_ps(_mm_sub_ps(_mm_loadu_ps(iData.m_PosY + iIdx), _mm_set1_ps(iQuery.m_PosY)), absMask);
+      __m128 const reachX = _mm_add_ps(_mm_loadu_ps(iData.m_ExtX + iIdx), _mm_set1_ps(iQuery.m_ReachX));
+      __m128 const reachY = _mm_add_ps(_mm_loadu_ps(iData.m_ExtY + iIdx), _mm_set1_ps(iQuery.m_ReachY));
+      __m128 const overlap = _mm_and_ps(_mm_cmple_ps(dx, reachX), _mm_cmple_ps(dy, reachY));
+
+      __m128 const boxDx = _mm_max_ps(_mm_sub_ps(dx, _mm_loadu_ps(iData.m_BoxExtX + iIdx)), zero);
+      __m128 const boxDy = _mm_max_ps(_mm_sub_ps(dy, _mm_loadu_ps(iData.m_BoxExtY + iIdx)), zero);
+      _mm_storeu_ps(oSqDist, _mm_add_ps(_mm_mul_ps(boxDx, boxDx), _mm_mul_ps(boxDy, boxDy)));
+
+      return _mm_movemask_ps(overlap);
+#else
+      //Branchless, so that it can be vectorized by the compiler.
+      uint32_t mask = 0;
+      for (uint32_t lane = 0; lane < s_Lanes; ++lane)
+      {
+        float const dx = Mathf::Abs(iData.m_PosX[iIdx + lane] - iQuery.m_PosX);
+        float const dy = Mathf::Abs(iData.m_PosY[iIdx + lane] - iQuery.m_PosY);
+        bool const overlap = (dx <= iData.m_ExtX[iIdx + lane] + iQuery.m_ReachX)
+          & (dy <= iData.m_ExtY[iIdx + lane] + iQuery.m_ReachY);
+        float const boxDx = Mathf::Max(dx - iData.m_BoxExtX[iIdx + lane], 0.0f);
+        float const boxDy = Mathf::Max(dy - iData.m_BoxExtY[iIdx + lane], 0.0f);
+        oSqDist[lane] = boxDx * boxDx + boxDy * boxDy;
+        mask |= uint32_t(overlap) << lane;
+      }
+      return mask;
+#endif
+    }
+
+    //Keeps the s_NumNeigh closest ones, sorted by distance.
+    inline void InsertNeighbour(NeighborhoodExtraction::Neigh& ioNeigh, uint32_t iOther, float iSqDist)
+    {
+      uint32_t const numNeigh = ioNeigh.numNeigh;
+      if (numNeigh == NeighborhoodExtraction::s_NumNeigh && ioNeigh.neighSqDist[numNeigh - 1] <= iSqDist)
+      {
+        return;
+      }
+      uint32_t slot = numNeigh < NeighborhoodExtraction::s_NumNeigh ? numNeigh : numNeigh - 1;
+      while (slot > 0 && ioNeigh.neighSqDist[slot - 1] >= iSqDist)
+      {
+        ioNeigh.neighSqDist[slot] = ioNeigh.neighSqDist[slot - 1];
+        ioNeigh.neighbors[slot] = ioNeigh.neighbors[slot - 1];
+        --slot;
+      }
+      ioNeigh.neighSqDist[slot] = iSqDist;
+      ioNeigh.neighbors[slot] = iOther;
+      if (numNeigh < NeighborhoodExtraction::s_NumNeigh)
+      {
+        ++ioNeigh.numNeigh;
+      }
+    }
+  }
+
+  void GridNeighborhoodExtractionImpl::AddObject(ObjectHandle iObj, float iRadius, bool iPopulate)
+  {
+    AddObject(iObj, Vec2(iRadius, iRadius), Neigh::Sphere, iPopulate);
+  }
+
+  void GridNeighborhoodExtractionImpl::AddObject(ObjectHandle iObj, Vec3 const& iDims, bool iPopulate)
+  {
+    AddObject(iObj, Vec2(iDims.x, iDims.y) * 0.5f, Neigh::Box, iPopulate);
+  }
+
+  void GridNeighborhoodExtractionImpl::AddObject(ObjectHandle iObj, Vec2 const& iHalfExtents, Neigh::Shape iShape, bool iPopulate)
+  {
+    //Removal is driven by the physic component, like for the tree.
+    if (m_Sys.GetCompImpl(iObj) == nullptr || m_Objects.count(iObj) != 0)
+    {
+      return;
+    }
+
+    m_Objects.insert(std::make_pair(iObj, m_ObjectsNeigh.size()));
+    m_ObjectsNeigh.push_back(Neigh());
+    Neigh& newObj = m_ObjectsNeigh.back();
+    newObj.populateNeigh = iPopulate;
+    newObj.m_Shape = iShape;
+    m_Handles.push_back(iObj);
+    m_HalfExtents.push_back(iHalfExtents);
+  }
+
+  void GridNeighborhoodExtractionImpl::Remove(ObjectHandle iObj)
+  {
+    auto neighIter = m_Objects.find(iObj);
+    if (neighIter == m_Objects.end())
+    {
+      return;
+    }
+
+    uint32_t const toErase = neighIter->second;
+    if (toErase < m_Handles.size() - 1)
+    {
+      m_Handles[toErase] = m_Handles.back();
+      m_ObjectsNeigh[toErase] = m_ObjectsNeigh.back();
+      m_HalfExtents[toErase] = m_HalfExtents.back();
+      m_Objects[m_Handles[toErase]] = toErase;
+    }
+
+    m_Handles.pop_back();
+    m_ObjectsNeigh.pop_back();
+    m_HalfExtents.pop_back();
+    m_Objects.erase(iObj);
+  }
+
+  void GridNeighborhoodExtractionImpl::BuildGrid(float iInflate)
+  {
+    uint32_t const numObjects = m_Handles.size();
+    Transforms& transforms = m_Sys.GetTransforms();
+
+    m_Positions.resize(numObjects);
+    Vec2 boundsMin(FLT_MAX, FLT_MAX);
+    Vec2 boundsMax(-FLT_MAX, -FLT_MAX);
+    m_MaxExtent = 0;
+    for (uint32_t i = 0; i < numObjects; ++i)
+    {
+      Mat4 const& trans = transforms.GetWorldTransform(m_Handles[i]);
+      Vec2 const pos(trans[3][0], trans[3][1]);
+      m_Positions[i] = pos;
+      boundsMin = min(boundsMin, pos);
+      boundsMax = max(boundsMax, pos);
+      m_MaxExtent = Mathf::Max(m_MaxExtent, Mathf::Max(m_HalfExtents[i].x, m_HalfExtents[i].y));
+    }
+
+    //A query then spans about 3x3 cells.
+    m_CellSize = Mathf::Max(iInflate + 2 * m_MaxExtent, 1.0e-3f);
+    Vec2 const boundsSize = boundsMax - boundsMin;
+    uint64_t const maxCells = uint64_t(numObjects) * s_MaxCellsPerObject;
+    while (true)
+    {
+      m_GridSize = Vec2i(int32_t(boundsSize.x / m_CellSize) + 1, int32_t(boundsSize.y / m_CellSize) + 1);
+      if (uint64_t(m_GridSize.x) * uint64_t(m_GridSize.y) <= maxCells)
+      {
+        break;
+      }
+      m_CellSize *= 2;
+    }
+    m_GridOrigin = boundsMin;
+
+    uint32_t const numCells = m_GridSize.x * m_GridSize.y;
+    m_CellStart.assign(numCells + 1, 0);
+    m_ObjectCell.resize(numObjects);
+    for (uint32_t i = 0; i < numObjects; ++i)
+    {
+      Vec2 const cellPos = (m_Positions[i] - m_GridOrigin) / m_CellSize;
+      uint32_t const cellX = Mathi::Min(int32_t(cellPos.x), m_GridSize.x - 1);
+      uint32_t const cellY = Mathi::Min(int32_t(cellPos.y), m_GridSize.y - 1);
+      uint32_t const cell = cellY * m_GridSize.x + cellX;
+      m_ObjectCell[i] = cell;
+      ++m_CellStart[cell + 1];
+    }
+    for (uint32_t i = 0; i < numCells; ++i)
+    {
+      m_CellStart[i + 1] += m_CellStart[i];
+    }
+
+    //Padding lets the last block be loaded at once.
+    uint32_t const paddedSize = numObjects + s_Lanes;
+    m_PosX.assign(paddedSize, s_FarAway);
+    m_PosY.assign(paddedSize, s_FarAway);
+    m_ExtX.assign(paddedSize, 0);
+    m_ExtY.assign(paddedSize, 0);
+    m_BoxExtX.assign(paddedSize, 0);
+    m_BoxExtY.assign(paddedSize, 0);
+    m_SortedObjects.assign(paddedSize, 0);
+    m_SortedIndex.resize(numObjects);
+
+    m_CellCursor.assign(m_CellStart.begin(), m_CellStart.end() - 1);
+    for (uint32_t i = 0; i < numObjects; ++i)
+    {
+      uint32_t const sortedIdx = m_CellCursor[m_ObjectCell[i]]++;
+      m_SortedIndex[i] = sortedIdx;
+      m_SortedObjects[sortedIdx] = i;
+      m_PosX[sortedIdx] = m_Positions[i].x;
+      m_PosY[sortedIdx] = m_Positions[i].y;
+      m_ExtX[sortedIdx] = m_HalfExtents[i].x;
+      m_ExtY[sortedIdx] = m_HalfExtents[i].y;
+      if (m_ObjectsNeigh[i].m_Shape == Neigh::Box)
+      {
+        m_BoxExtX[sortedIdx] = m_HalfExtents[i].x;
+        m_BoxExtY[sortedIdx] = m_HalfExtents[i].y;
+      }
+    }
+  }
+
+  void GridNeighborhoodExtractionImpl::Query(uint32_t iObj, float iInflate)
+  {
+    Neigh& neigh = m_ObjectsNeigh[iObj];
+    neigh.numNeigh = 0;
+    if (!neigh.populateNeigh)
+    {
+      return;
+    }
+
+    uint32_t const sortedIdx = m_SortedIndex[iObj];
+    BlockQuery query;
+    query.m_PosX = m_PosX[sortedIdx];
+    query.m_PosY = m_PosY[sortedIdx];
+    query.m_ReachX = m_ExtX[sortedIdx] + iInflate;
+    query.m_ReachY = m_ExtY[sortedIdx] + iInflate;
+
+    BlockData data;
+    data.m_PosX = m_PosX.data();
+    data.m_PosY = m_PosY.data();
+    data.m_ExtX = m_ExtX.data();
+    data.m_ExtY = m_ExtY.data();
+    data.m_BoxExtX = m_BoxExtX.data();
+    data.m_BoxExtY = m_BoxExtY.data();
+
+    auto cellRange = [this](float iPos, float iOrigin, float iReach, int32_t iSize, int32_t& oBegin, int32_t& oEnd)
+    {
+      oBegin = Mathi::Clamp(int32_t(Mathf::Floor((iPos - iReach - iOrigin) / m_CellSize)), 0, iSize - 1);
+      oEnd = Mathi::Clamp(int32_t(Mathf::Floor((iPos + iReach - iOrigin) / m_CellSize)), 0, iSize - 1);
+    };
+
+    int32_t x0, x1, y0, y1;
+    cellRange(query.m_PosX, m_GridOrigin.x, query.m_ReachX + m_MaxExtent, m_GridSize.x, x0, x1);
+    cellRange(query.m_PosY, m_GridOrigin.y, query.m_ReachY + m_MaxExtent, m_GridSize.y, y0, y1);
+
+    float sqDist[s_Lanes];
+    for (int32_t y = y0; y <= y1; ++y)
+    {
+      //Cells of a row are contiguous in the sorted arrays.
+      uint32_t const rowBegin = m_CellStart[y * m_GridSize.x + x0];
+      uint32_t const rowEnd = m_CellStart[y * m_GridSize.x + x1 + 1];
+      for (uint32_t i = rowBegin; i < rowEnd; i += s_Lanes)
+      {
+        uint32_t mask = TestBlock(query, data, i, sqDist);
+        if (rowEnd - i < s_Lanes)
+        {
+          mask &= (1u << (rowEnd - i)) - 1;
+        }
+        for (uint32_t lane = 0; mask != 0; ++lane, mask >>= 1)
+        {
+          if ((mask & 1) && i + lane != sortedIdx)
+          {
+            InsertNeighbour(neigh, m_SortedObjects[i + lane], sqDist[lane]);
+          }
+        }
+      }
+    }
+  }
+
+  void GridNeighborhoodExtractionImpl::Run(Vec3 const& iForwardOffset, float iRadiusSearch)
+  {
+    m_Sys.GetImpl().Cleanup();
+
+    uint32_t const numObjects = m_Handles.size();
+    if (numObjects == 0)
+    {
+      return;
+    }
+
+    float const inflate = iRadiusSearch + length(iForwardOffset);
+    BuildGrid(inflate);
+
+    auto queryRange = [this, inflate](uint32_t iBegin, uint32_t iEnd, uint32_t)
+    {
+      for (uint32_t i = iBegin; i < iEnd; ++i)
+      {
+        Query(i, inflate);
+      }
+    };
+
+    //Each query only writes its own entry.
+    if (JobSystem* jobs = m_Sys.GetWorld().GetJobSystem())
+    {
+      jobs->ParallelFor(0, numObjects, s_ObjectsPerJob, queryRange);
+    }
+    else
+    {
+      queryRange(0, numObjects, 0);
+    }
+  }
+}
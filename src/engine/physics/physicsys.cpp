@@ -34,8 +34,8 @@ namespace eXl
 {
   IMPLEMENT_RTTI(PhysicsSystem);
 
-  PhysicsSystem::PhysicsSystem(Transforms& iTransforms)
-    : m_Impl(eXl_NEW PhysicsSystem_Impl(*this))
+  PhysicsSystem::PhysicsSystem(Transforms& iTransforms, NeighborhoodKind iNeighKind)
+    : m_Impl(eXl_NEW PhysicsSystem_Impl(*this, iNeighKind))
     , m_Transforms(iTransforms)
   {
   }
@@ -152,6 +152,10 @@ namespace eXl
 
   NeighborhoodExtraction& PhysicsSystem::GetNeighborhoodExtraction() const
   {
+    if (m_Impl->m_GridNeighExtraction)
+    {
+      return *m_Impl->m_GridNeighExtraction;
+    }
     return m_Impl->m_NeighExtraction;
   }
 
@@ -428,11 +428,16 @@ namespace eXl
     UnorderedMap<ObjectHandle, ContactFilterCallback> m_CustomCB;
   };
 
-  PhysicsSystem_Impl::PhysicsSystem_Impl(PhysicsSystem& iSys)
+  PhysicsSystem_Impl::PhysicsSystem_Impl(PhysicsSystem& iSys, NeighborhoodKind iNeighKind)
     : m_HostSys(iSys)
     , m_NeighExtraction(iSys)
     , m_Triggers(*this)
   {
+    if (iNeighKind == NeighborhoodKind::Grid)
+    {
+      m_GridNeighExtraction = std::make_unique<GridNeighborhoodExtractionImpl>(iSys);
+    }
+
     m_collisionConfiguration = new btDefaultCollisionConfiguration();
     m_collisionConfiguration->setPlaneConvexMultipointIterations();
     m_dispatcher = new eXlCustomDispatcher(m_collisionConfiguration);
@@ -460,6 +465,10 @@ namespace eXl
     {
       ObjectHandle id = comp->m_ObjectId;
       m_NeighExtraction.Remove(id, comp.get());
+      if (m_GridNeighExtraction)
+      {
+        m_GridNeighExtraction->Remove(id);
+      }
       RemoveContactCb(id);
 
       if(!(comp->m_InitData.GetFlags() & PhysicFlags::IsGhost))
@@ -666,7 +675,7 @@ namespace eXl
 
   struct ObjSort : btDbvt::ICollide
   {
-    ObjSort(UnorderedMap<void*, uint32_t> const& iIdMap, Vector<NeighborhoodExtraction::Neigh> const& iDescs, Vector<uint32_t>& oIds)
+    ObjSort(UnorderedMap<void*, uint32_t> const& iIdMap, Vector<NeighborhoodExtraction::Neigh> const& iDescs, FrameVector<uint32_t>& oIds)
       : m_IdMap(iIdMap)
       , m_OutIds(oIds)
       , m_Descs(iDescs)
@@ -674,7 +683,7 @@ namespace eXl
     }
     UnorderedMap<void*, uint32_t> const& m_IdMap;
     Vector<NeighborhoodExtraction::Neigh> const& m_Descs;
-    Vector<uint32_t>& m_OutIds;
+    FrameVector<uint32_t>& m_OutIds;
     void Process(const btDbvtNode* leaf)
     {
       auto iter = m_IdMap.find(leaf->data);
@@ -711,7 +720,8 @@ namespace eXl
       return;
     }
 
-    Vector<uint32_t> objects;
+    FrameArena& arena = m_Sys.GetWorld().GetFrameArena();
+    FrameVector<uint32_t> objects(arena);
     objects.reserve(m_Objects.size());
     {
       ObjSort sort(m_UsrDataToNum, m_ObjectsNeigh, objects);
@@ -728,7 +738,7 @@ namespace eXl
       neigh.numNeigh = 0;
     }
 
-    Vector<VisitStackElem> nodes;
+    FrameVector<VisitStackElem> nodes(arena);
     nodes.reserve(64);
 
     nodes.push_back(VisitStackElem(iTree.m_root, objects.size()));
@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+
+#include <engine/common/app.hpp>
+#include <engine/game/commondef.hpp>
+#include <engine/game/archetype.hpp>
+#include <engine/gfx/tileset.hpp>
+#include <engine/map/map.hpp>
+
+#include <core/resource/resourcemanager.hpp>
+#include <core/stream/writer.hpp>
+#include <core/stream/textreader.hpp>
+#include <core/stream/inputstream.hpp>
+#include <core/stream/binaryunstreamer.hpp>
+
+#include <sstream>
+
+#include "assetformattest.hpp"
+
+using namespace eXl;
+
+TEST(AssetFormat, BinaryRoundTrip)
+{
+  AssetScene scene(16);
+
+  {
+    Resource* loadedRsc = LoadResource(scene.m_Map, SaveResource(scene.m_Map, true), true);
+    MapResource* loadedMap = MapResource::DynamicCast(loadedRsc);
+    ASSERT_NE(loadedMap, nullptr);
+    ASSERT_EQ(loadedMap->m_Tiles.size(), 1);
+    ASSERT_EQ(loadedMap->m_Tiles[0].m_Tiles.size(), scene.m_Map->m_Tiles[0].m_Tiles.size());
+    for (uint32_t i = 0; i < loadedMap->m_Tiles[0].m_Tiles.size(); ++i)
+    {
+      EXPECT_EQ(loadedMap->m_Tiles[0].m_Tiles[i].m_Position, scene.m_Map->m_Tiles[0].m_Tiles[i].m_Position);
+      EXPECT_EQ(loadedMap->m_Tiles[0].m_Tiles[i].m_Name, scene.m_Map->m_Tiles[0].m_Tiles[i].m_Name);
+    }
+    ASSERT_EQ(loadedMap->m_Objects.size(), scene.m_Map->m_Objects.size());
+    for (uint32_t i = 0; i < loadedMap->m_Objects.size(); ++i)
+    {
+      MapResource::ObjectHeader const& loadedHeader = loadedMap->m_Objects[i].m_Header;
+      MapResource::ObjectHeader const& header = scene.m_Map->m_Objects[i].m_Header;
+      EXPECT_EQ(loadedHeader.m_ObjectId, header.m_ObjectId);
+      EXPECT_EQ(loadedHeader.m_DisplayName, header.m_DisplayName);
+      EXPECT_EQ(loadedHeader.m_Position, header.m_Position);
+      EXPECT_EQ(loadedHeader.m_Archetype.GetUUID(), header.m_Archetype.GetUUID());
+    }
+    eXl_DELETE loadedRsc;
+  }
+
+  {
+    Resource* loadedRsc = LoadResource(scene.m_Tileset, SaveResource(scene.m_Tileset, true), true);
+    Tileset* loadedTileset = Tileset::DynamicCast(loadedRsc);
+    ASSERT_NE(loadedTileset, nullptr);
+    for (auto const& entry : *scene.m_Tileset)
+    {
+      Tile const* loadedTile = loadedTileset->Find(entry.first);
+      ASSERT_NE(loadedTile, nullptr);
+      EXPECT_EQ(loadedTile->m_Size, entry.second.m_Size);
+      EXPECT_EQ(loadedTile->m_AnimType, entry.second.m_AnimType);
+      ASSERT_EQ(loadedTile->m_Frames.size(), entry.second.m_Frames.size());
+      for (uint32_t i = 0; i < loadedTile->m_Frames.size(); ++i)
+      {
+        EXPECT_EQ(loadedTile->m_Frames[i], entry.second.m_Frames[i]);
+      }
+    }
+    eXl_DELETE loadedRsc;
+  }
+
+  {
+    Resource* loadedRsc = LoadResource(scene.m_Archetype, SaveResource(scene.m_Archetype, true), true);
+    Archetype* loadedArchetype = Archetype::DynamicCast(loadedRsc);
+    ASSERT_NE(loadedArchetype, nullptr);
+    EXPECT_EQ(loadedArchetype->GetComponents(), scene.m_Archetype->GetComponents());
+    ASSERT_EQ(loadedArchetype->GetProperties().size(), scene.m_Archetype->GetProperties().size());
+    for (auto const& entry : scene.m_Archetype->GetProperties())
+    {
+      EXPECT_TRUE(loadedArchetype->HasProperty(entry.first));
+    }
+    eXl_DELETE loadedRsc;
+  }
+}
+
+// Baked builds read assets through InputStreamTextReader instead of a memory mapped file.
+TEST(AssetFormat, BinaryFromInputStream)
+{
+  AssetScene scene(16);
+
+  std::string const binData = SaveResource(scene.m_Map, true);
+  InputStreamTextReader reader(scene.m_Map->GetName(), std::make_unique<BinaryInputStream>(binData.data(), binData.size()));
+  KString const view = reader.GetView();
+  ASSERT_EQ(view.size(), binData.size());
+  EXPECT_TRUE(BinaryUnstreamer::IsBinary(view.data(), view.size()));
+
+  ResourceLoader* loader = ResourceManager::GetLoader(scene.m_Map->GetHeader().m_LoaderName);
+  Resource::Header header = scene.m_Map->GetHeader();
+  header.m_Flags |= Resource::BinaryResource;
+  Resource* loadedRsc = loader->Load(header, &scene.m_Map->GetMetaData(), reader);
+  MapResource* loadedMap = MapResource::DynamicCast(loadedRsc);
+  ASSERT_NE(loadedMap, nullptr);
+  ASSERT_EQ(loadedMap->m_Objects.size(), scene.m_Map->m_Objects.size());
+  for (uint32_t i = 0; i < loadedMap->m_Objects.size(); ++i)
+  {
+    EXPECT_EQ(loadedMap->m_Objects[i].m_Header.m_ObjectId, scene.m_Map->m_Objects[i].m_Header.m_ObjectId);
+    EXPECT_EQ(loadedMap->m_Objects[i].m_Header.m_Position, scene.m_Map->m_Objects[i].m_Header.m_Position);
+  }
+  eXl_DELETE loadedRsc;
+
+  // Text assets keep being read through the character interface.
+  std::string const jsonData = SaveResource(scene.m_Map, false);
+  InputStreamTextReader textReader(scene.m_Map->GetName(), std::make_unique<BinaryInputStream>(jsonData.data(), jsonData.size()));
+  EXPECT_FALSE(BinaryUnstreamer::IsBinary(textReader.GetView().data(), textReader.GetView().size()));
+  EXPECT_EQ(textReader.get(), jsonData[0]);
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <engine/common/app.hpp>
+#include <engine/game/commondef.hpp>
+#include <engine/game/archetype.hpp>
+#include <engine/gfx/tileset.hpp>
+#include <engine/map/map.hpp>
+
+#include <core/resource/resourcemanager.hpp>
+#include <core/stream/writer.hpp>
+#include <core/stream/textreader.hpp>
+
+#include <sstream>
+
+namespace eXl
+{
+  // Nothing is written on disk, the paths only have to be unused.
+  Path const s_TestDir("AssetFormatTest");
+
+  struct AssetScene
+  {
+    AssetScene(uint32_t iMapSide)
+      : m_Properties(EngineCommon::GetBaseProperties())
+    {
+      ResourceManager::AddManifest(m_Properties);
+      ResourceManager::AddManifest(EngineCommon::GetComponents());
+
+      m_Archetype = Archetype::Create(s_TestDir, "TestArchetype");
+      m_Archetype->AddComponent(EngineCommon::GfxSpriteComponentName(), EngineCommon::GetComponents(), m_Properties);
+      m_Archetype->AddComponent(EngineCommon::PhysicsComponentName(), EngineCommon::GetComponents(), m_Properties);
+      m_Archetype->AddComponent(EngineCommon::CharacterComponentName(), EngineCommon::GetComponents(), m_Properties);
+
+      m_Tileset = Tileset::Create(s_TestDir, "TestTileset");
+      for (uint32_t i = 0; i < iMapSide; ++i)
+      {
+        Tile tile;
+        tile.m_Size = Vec2i(16, 16);
+        tile.m_Frames.clear();
+        for (int32_t frame = 0; frame < 4; ++frame)
+        {
+          tile.m_Frames.push_back(Vec2i(frame * 16, i * 16));
+        }
+        tile.m_AnimType = AnimationType::Loop;
+        m_Tileset->AddTile(TileName(StringUtil::FromInt(i).c_str()), tile);
+      }
+
+      m_Map = MapResource::Create(s_TestDir, "TestMap");
+      MapResource::PlacedTiles placed;
+      placed.m_Tileset.Set(m_Tileset);
+      for (int32_t y = 0; y < int32_t(iMapSide); ++y)
+      {
+        for (int32_t x = 0; x < int32_t(iMapSide); ++x)
+        {
+          MapResource::PlacedTiles::Tile tile;
+          tile.m_Position = Vec2i(x, y);
+          tile.m_Name = TileName(StringUtil::FromInt((x + y) % iMapSide).c_str());
+          placed.m_Tiles.push_back(tile);
+        }
+      }
+      m_Map->m_Tiles.push_back(std::move(placed));
+
+      for (uint32_t i = 0; i < iMapSide * 4; ++i)
+      {
+        MapResource::Object object;
+        object.m_Header.m_ObjectId = i + 1;
+        object.m_Header.m_DisplayName = "Object" + StringUtil::FromInt(i);
+        object.m_Header.m_Position = Vec3(i % iMapSide, i / iMapSide, 0.0);
+        object.m_Header.m_Archetype.Set(m_Archetype);
+        m_Map->m_Objects.push_back(std::move(object));
+      }
+    }
+
+    ~AssetScene()
+    {
+      ResourceManager::RemoveManifest(EngineCommon::GetComponents());
+      ResourceManager::RemoveManifest(m_Properties);
+    }
+
+    PropertiesManifest m_Properties;
+    Archetype* m_Archetype;
+    Tileset* m_Tileset;
+    MapResource* m_Map;
+  };
+
+  inline std::string SaveResource(Resource* iRsc, bool iBinary)
+  {
+    ResourceLoader* loader = ResourceManager::GetLoader(iRsc->GetHeader().m_LoaderName);
+    std::stringstream stream;
+    BinaryWriter binWriter(stream);
+    StdOutWriter textWriter(stream);
+    loader->Save(iRsc, iBinary ? binWriter : textWriter);
+    return stream.str();
+  }
+
+  inline Resource* LoadResource(Resource* iRsc, std::string const& iData, bool iBinary)
+  {
+    ResourceLoader* loader = ResourceManager::GetLoader(iRsc->GetHeader().m_LoaderName);
+    Resource::Header header = iRsc->GetHeader();
+    if (iBinary)
+    {
+      header.m_Flags |= Resource::BinaryResource;
+    }
+    StringViewReader reader(iRsc->GetName(), iData.data(), iData.data() + iData.size());
+    return loader->Load(header, &iRsc->GetMetaData(), reader);
+  }
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <core/name.hpp>
+#include <core/containers.hpp>
+
+namespace eXl
+{
+  MAKE_NAME(FrozenTestName);
+
+  inline Vector<FrozenTestName> MakeFrozenTestKeys(uint32_t iNumKeys)
+  {
+    Vector<FrozenTestName> keys;
+    for (uint32_t i = 0; i < iNumKeys; ++i)
+    {
+      keys.push_back(FrozenTestName(StringUtil::FromInt(i)));
+    }
+    return keys;
+  }
+}
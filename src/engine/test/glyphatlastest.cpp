@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+
+#include <engine/gfx/gfxglyphatlas.hpp>
+
+#include <core/random.hpp>
+
+using namespace eXl;
+
+namespace
+{
+  GfxGlyphAtlas::Key MakeKey(uint32_t iGlyph)
+  {
+    return GfxGlyphAtlas::Key({ nullptr, 12, iGlyph });
+  }
+
+  bool Overlap(AABB2Di const& iBox1, AABB2Di const& iBox2)
+  {
+    return iBox1.m_Data[0].x < iBox2.m_Data[1].x && iBox2.m_Data[0].x < iBox1.m_Data[1].x
+      && iBox1.m_Data[0].y < iBox2.m_Data[1].y && iBox2.m_Data[0].y < iBox1.m_Data[1].y;
+  }
+}
+
+TEST(GlyphAtlas, PacksWithoutOverlap)
+{
+  GfxGlyphAtlas atlas(Vec2u(256, 256), 8);
+  UniquePtr<Random> rand(Random::CreateDefaultRNG(0));
+  Vector<GfxGlyphAtlas::Location> locations;
+  for (uint32_t i = 0; i < 600; ++i)
+  {
+    Vec2u const size(1 + rand->Generate() % 20, 1 + rand->Generate() % 24);
+    Vector<uint8_t> pixels(size.x * size.y, 255);
+    GfxGlyphAtlas::Location const* loc = atlas.Add(MakeKey(i), size, pixels.data());
+    ASSERT_NE(loc, nullptr);
+    EXPECT_EQ(loc->m_Rect.GetSize(), Vec2i(size.x + 2, size.y + 2));
+    locations.push_back(*loc);
+  }
+  EXPECT_EQ(atlas.GetNumGlyphs(), 600);
+  EXPECT_EQ(atlas.GetNumEvictions(), 0);
+
+  for (uint32_t i = 0; i < locations.size(); ++i)
+  {
+    AABB2Di const& rect = locations[i].m_Rect;
+    ASSERT_LT(locations[i].m_Page, atlas.GetNumPages());
+    ASSERT_TRUE(rect.m_Data[0].x >= 0 && rect.m_Data[0].y >= 0 && rect.m_Data[1].x <= 256 && rect.m_Data[1].y <= 256) << "Glyph " << i;
+    for (uint32_t j = i + 1; j < locations.size(); ++j)
+    {
+      if (locations[i].m_Page == locations[j].m_Page)
+      {
+        ASSERT_FALSE(Overlap(rect, locations[j].m_Rect)) << "Glyphs " << i << ", " << j;
+      }
+    }
+  }
+}
+
+TEST(GlyphAtlas, FillsPageBeforeAddingOne)
+{
+  GfxGlyphAtlas atlas(Vec2u(256, 256), 4);
+  Vector<uint8_t> pixels(16 * 16, 255);
+  // 14 x 14 padded glyphs of 18 x 18.
+  for (uint32_t i = 0; i < 196; ++i)
+  {
+    atlas.Add(MakeKey(i), Vec2u(16, 16), pixels.data());
+  }
+  EXPECT_EQ(atlas.GetNumPages(), 1);
+  atlas.Add(MakeKey(196), Vec2u(16, 16), pixels.data());
+  EXPECT_EQ(atlas.GetNumPages(), 2);
+}
+
+TEST(GlyphAtlas, EvictsLeastRecentlyUsedPage)
+{
+  GfxGlyphAtlas atlas(Vec2u(128, 128), 2);
+  Vector<uint8_t> pixels(30 * 30, 255);
+  // 16 glyphs per page.
+  for (uint32_t i = 0; i < 32; ++i)
+  {
+    atlas.Add(MakeKey(i), Vec2u(30, 30), pixels.data());
+  }
+  ASSERT_EQ(atlas.GetNumPages(), 2);
+  ASSERT_EQ(atlas.Find(MakeKey(0))->m_Page, 0);
+  ASSERT_EQ(atlas.Find(MakeKey(16))->m_Page, 1);
+
+  atlas.NextFrame();
+  atlas.TouchPage(0);
+  atlas.NextFrame();
+  atlas.TouchPage(0);
+
+  GfxGlyphAtlas::Location const* loc = atlas.Add(MakeKey(100), Vec2u(30, 30), pixels.data());
+  ASSERT_NE(loc, nullptr);
+  EXPECT_EQ(loc->m_Page, 1);
+  EXPECT_EQ(atlas.GetNumEvictions(), 1);
+  EXPECT_NE(atlas.Find(MakeKey(0)), nullptr);
+  for (uint32_t i = 16; i < 32; ++i)
+  {
+    EXPECT_EQ(atlas.Find(MakeKey(i)), nullptr) << "Glyph " << i;
+  }
+
+  // Both pages are used this frame, the limit is exceeded instead.
+  for (uint32_t i = 0; i < 16; ++i)
+  {
+    atlas.Add(MakeKey(200 + i), Vec2u(30, 30), pixels.data());
+  }
+  EXPECT_EQ(atlas.GetNumPages(), 3);
+  EXPECT_EQ(atlas.GetNumEvictions(), 1);
+}
+
+TEST(GlyphAtlas, RejectsGlyphsLargerThanPage)
+{
+  GfxGlyphAtlas atlas(Vec2u(128, 128), 2);
+  Vector<uint8_t> pixels(127 * 10, 255);
+  EXPECT_EQ(atlas.Add(MakeKey(0), Vec2u(127, 10), pixels.data()), nullptr);
+  EXPECT_EQ(atlas.GetNumGlyphs(), 0);
+}
+
+TEST(GlyphAtlas, CopiesGlyphWithBorder)
+{
+  GfxGlyphAtlas atlas(Vec2u(16, 16), 1);
+  uint8_t const pixels[] = { 1, 2, 3, 4, 5, 6 };
+  GfxGlyphAtlas::Location const loc = *atlas.Add(MakeKey(0), Vec2u(3, 2), pixels);
+  uint8_t const expected[] =
+  {
+    0, 0, 0, 0, 0,
+    0, 1, 2, 3, 0,
+    0, 4, 5, 6, 0,
+    0, 0, 0, 0, 0,
+  };
+
+  Vector<uint8_t> const& page = atlas.GetPixels(loc.m_Page);
+  for (uint32_t i = 0; i < 4; ++i)
+  {
+    for (uint32_t j = 0; j < 5; ++j)
+    {
+      EXPECT_EQ(page[(loc.m_Rect.m_Data[0].y + i) * 16 + loc.m_Rect.m_Data[0].x + j], expected[i * 5 + j]) << "Pixel " << i << ", " << j;
+    }
+  }
+}
@@ -3,6 +3,7 @@
 #include <core/corelib.hpp>
 #include <core/coretest.hpp>
 #include <core/vlog.hpp>
+#include <ogl/oglutils.hpp>
 
 #ifndef EXL_SHARED_LIBRARY
 
@@ -43,6 +44,8 @@ GTEST_API_ int main(int argc, char** argv)
   CoreLibCtx eXlCtx;
 
   eXl::SetErrorHandling(eXl::DEBUG_STAGE);
+  // Rendering tests record into OGLRecordingContext, there is no GL context to create resources with.
+  eXl::OGLUtils::SetHeadless(true);
 
   return RUN_ALL_TESTS();
 }
\ No newline at end of file
@@ -0,0 +1,306 @@
+#include <gtest/gtest.h>
+
+#include <engine/common/world.hpp>
+#include <engine/common/transforms.hpp>
+#include <engine/game/commondef.hpp>
+#include <engine/map/mapstreamer.hpp>
+#include <engine/map/maptiler.hpp>
+#include <engine/map/tilinggroup.hpp>
+#include <math/mathtools.hpp>
+
+#include <core/resource/resourcemanager.hpp>
+#include <core/stream/writer.hpp>
+#include <core/stream/textreader.hpp>
+#include <core/thread/jobsystem.hpp>
+
+#include <sstream>
+
+#include "mapstreamtest.hpp"
+
+using namespace eXl;
+
+namespace
+{
+  struct StreamScene
+  {
+    StreamScene(MapResource const& iMap)
+      : m_World(m_Dummy)
+    {
+      m_World.AddSystem(std::make_unique<Transforms>());
+      m_Streamer = std::make_unique<MapStreamer>(m_World, iMap);
+    }
+
+    ComponentManifest m_Dummy;
+    World m_World;
+    UniquePtr<MapStreamer> m_Streamer;
+  };
+
+  // Vertices of each layer, in texture group order.
+  Vector<Vector<float>> FlattenLayers(Vector<MapTiler::Batcher> const& iLayers)
+  {
+    Vector<Vector<float>> vertices(iLayers.size());
+    for (uint32_t i = 0; i < iLayers.size(); ++i)
+    {
+      for (auto const& group : iLayers[i].allTiles)
+      {
+        vertices[i].insert(vertices[i].end(), group.begin(), group.end());
+      }
+    }
+    return vertices;
+  }
+}
+
+TEST(MapStreaming, ChunkPartition)
+{
+  ChunkedMapScene scene(64);
+  MapResource const& map = *scene.m_Map;
+  uint32_t const chunksPerSide = scene.m_MapSide / s_ChunkSize;
+  ASSERT_EQ(map.m_Chunks.size(), chunksPerSide * chunksPerSide);
+
+  Vector<uint32_t> tilesSeen(map.m_Tiles[0].m_Tiles.size(), 0);
+  Vector<uint32_t> objectsSeen(map.m_Objects.size(), 0);
+  for (auto const& chunk : map.m_Chunks)
+  {
+    AABB2Df const box = map.GetChunkBox(chunk.m_Coords);
+    ASSERT_EQ(chunk.m_Tiles.size(), 1);
+    for (uint32_t tileIdx : chunk.m_Tiles[0])
+    {
+      Vec2 pos = MathTools::ToFVec(map.m_Tiles[0].m_Tiles[tileIdx].m_Position) / EngineCommon::s_WorldToPixel;
+      EXPECT_TRUE(box.Contains(pos));
+      ++tilesSeen[tileIdx];
+    }
+    for (uint32_t objIdx : chunk.m_Objects)
+    {
+      EXPECT_TRUE(box.Contains(MathTools::As2DVec(map.m_Objects[objIdx].m_Header.m_Position)));
+      ++objectsSeen[objIdx];
+    }
+
+    // The walls cover the whole chunk.
+    ASSERT_EQ(chunk.m_Collision.size(), 1);
+    int32_t area = 0;
+    for (auto const& shape : chunk.m_Collision[0].m_Shapes)
+    {
+      Vector<AABB2Di> boxes;
+      shape.GetBoxes(boxes);
+      for (auto const& shapeBox : boxes)
+      {
+        area += shapeBox.GetSize().x * shapeBox.GetSize().y;
+      }
+    }
+    EXPECT_EQ(area, s_ChunkSize * s_ChunkSize * EngineCommon::s_WorldToPixel * EngineCommon::s_WorldToPixel);
+  }
+  for (uint32_t seen : tilesSeen)
+  {
+    EXPECT_EQ(seen, 1);
+  }
+  for (uint32_t seen : objectsSeen)
+  {
+    EXPECT_EQ(seen, 1);
+  }
+  for (uint32_t i = 1; i < map.m_Objects.size(); ++i)
+  {
+    EXPECT_LT(map.m_Objects[i - 1].m_Header.m_ObjectId, map.m_Objects[i].m_Header.m_ObjectId);
+  }
+}
+
+TEST(MapStreaming, BinaryRoundTrip)
+{
+  ChunkedMapScene scene(32);
+
+  ResourceLoader* loader = ResourceManager::GetLoader(scene.m_Map->GetHeader().m_LoaderName);
+  std::stringstream stream;
+  BinaryWriter writer(stream);
+  loader->Save(scene.m_Map, writer);
+  std::string data = stream.str();
+
+  Resource::Header header = scene.m_Map->GetHeader();
+  header.m_Flags |= Resource::BinaryResource;
+  StringViewReader reader(scene.m_Map->GetName(), data.data(), data.data() + data.size());
+  Resource* loadedRsc = loader->Load(header, &scene.m_Map->GetMetaData(), reader);
+  MapResource* loadedMap = MapResource::DynamicCast(loadedRsc);
+  ASSERT_NE(loadedMap, nullptr);
+
+  EXPECT_EQ(loadedMap->m_ChunkSize, s_ChunkSize);
+  ASSERT_EQ(loadedMap->m_Chunks.size(), scene.m_Map->m_Chunks.size());
+  for (uint32_t i = 0; i < loadedMap->m_Chunks.size(); ++i)
+  {
+    MapResource::Chunk const& loadedChunk = loadedMap->m_Chunks[i];
+    MapResource::Chunk const& chunk = scene.m_Map->m_Chunks[i];
+    EXPECT_EQ(loadedChunk.m_Coords, chunk.m_Coords);
+    EXPECT_EQ(loadedChunk.m_Tiles, chunk.m_Tiles);
+    EXPECT_EQ(loadedChunk.m_Objects, chunk.m_Objects);
+    ASSERT_EQ(loadedChunk.m_Collision.size(), chunk.m_Collision.size());
+    for (uint32_t j = 0; j < chunk.m_Collision.size(); ++j)
+    {
+      EXPECT_EQ(loadedChunk.m_Collision[j].m_Type, chunk.m_Collision[j].m_Type);
+      EXPECT_EQ(loadedChunk.m_Collision[j].m_Shapes.size(), chunk.m_Collision[j].m_Shapes.size());
+    }
+  }
+  for (uint32_t i = 0; i < loadedMap->m_Objects.size(); ++i)
+  {
+    EXPECT_EQ(loadedMap->m_Objects[i].m_Header.m_ObjectId, scene.m_Map->m_Objects[i].m_Header.m_ObjectId);
+  }
+  eXl_DELETE loadedRsc;
+}
+
+TEST(MapStreaming, LoadAroundFocus)
+{
+  ChunkedMapScene mapScene(64);
+  StreamScene scene(*mapScene.m_Map);
+  MapStreamer& streamer = *scene.m_Streamer;
+
+  uint32_t focus = streamer.AddFocusPoint(Vec2(8.0, 8.0), 4.0);
+  streamer.Update(Mathf::MaxReal());
+  EXPECT_EQ(streamer.GetNumLoadedChunks(), 1);
+  ASSERT_TRUE(streamer.IsChunkLoaded(Vec2i(0, 0)));
+  Vector<ObjectHandle> firstObjects = streamer.GetChunkData(Vec2i(0, 0))->objects;
+  EXPECT_EQ(firstObjects.size(), s_ChunkSize * s_ChunkSize / 2);
+  for (ObjectHandle obj : firstObjects)
+  {
+    EXPECT_TRUE(scene.m_World.IsObjectValid(obj));
+  }
+
+  // Still within one chunk of the focus, the first chunk is kept.
+  streamer.MoveFocusPoint(focus, Vec2(24.0, 8.0));
+  streamer.Update(Mathf::MaxReal());
+  EXPECT_TRUE(streamer.IsChunkLoaded(Vec2i(0, 0)));
+  EXPECT_TRUE(streamer.IsChunkLoaded(Vec2i(1, 0)));
+
+  streamer.MoveFocusPoint(focus, Vec2(40.0, 8.0));
+  streamer.Update(Mathf::MaxReal());
+  EXPECT_FALSE(streamer.IsChunkLoaded(Vec2i(0, 0)));
+  EXPECT_TRUE(streamer.IsChunkLoaded(Vec2i(2, 0)));
+  for (ObjectHandle obj : firstObjects)
+  {
+    EXPECT_FALSE(scene.m_World.IsObjectValid(obj));
+  }
+
+  streamer.RemoveFocus(focus);
+  streamer.Update(Mathf::MaxReal());
+  EXPECT_EQ(streamer.GetNumLoadedChunks(), 0);
+}
+
+TEST(MapStreaming, PersistentObjects)
+{
+  ChunkedMapScene mapScene(64);
+  StreamScene scene(*mapScene.m_Map);
+  MapStreamer& streamer = *scene.m_Streamer;
+  Transforms& transforms = *scene.m_World.GetSystem<Transforms>();
+
+  auto countObjectsAt = [&](Vec2i const& iChunk, Vec2 const& iPos)
+  {
+    uint32_t count = 0;
+    for (ObjectHandle obj : streamer.GetChunkData(iChunk)->objects)
+    {
+      count += Vec2(transforms.GetWorldTransform(obj)[3]) == iPos ? 1 : 0;
+    }
+    return count;
+  };
+
+  uint32_t focus = streamer.AddFocusPoint(Vec2(8.0, 8.0), 4.0);
+  streamer.Update(Mathf::MaxReal());
+  ASSERT_TRUE(streamer.IsChunkLoaded(Vec2i(0, 0)));
+  Vector<ObjectHandle> objects = streamer.GetChunkData(Vec2i(0, 0))->objects;
+  uint32_t const numObjects = objects.size();
+
+  Vec2 const deletedPos(transforms.GetWorldTransform(objects[0])[3]);
+  scene.m_World.DeleteObject(objects[0]);
+  // Odd tiles have no object.
+  Vec2 const movedPos(3.5, 3.5);
+  transforms.UpdateTransform(objects[1], translate(Identity<Mat4>(), Vec3(movedPos, 0.0)));
+  Vec2 const leftPos(41.5, 8.5);
+  transforms.UpdateTransform(objects[2], translate(Identity<Mat4>(), Vec3(leftPos, 0.0)));
+
+  streamer.MoveFocusPoint(focus, Vec2(40.0, 8.0));
+  streamer.Update(Mathf::MaxReal());
+  ASSERT_FALSE(streamer.IsChunkLoaded(Vec2i(0, 0)));
+  ASSERT_TRUE(streamer.IsChunkLoaded(Vec2i(2, 0)));
+  EXPECT_EQ(streamer.GetChunkData(Vec2i(2, 0))->objects.size(), numObjects + 1);
+  EXPECT_EQ(countObjectsAt(Vec2i(2, 0), leftPos), 1);
+
+  streamer.MoveFocusPoint(focus, Vec2(8.0, 8.0));
+  streamer.Update(Mathf::MaxReal());
+  ASSERT_TRUE(streamer.IsChunkLoaded(Vec2i(0, 0)));
+  EXPECT_EQ(streamer.GetChunkData(Vec2i(0, 0))->objects.size(), numObjects - 2);
+  EXPECT_EQ(countObjectsAt(Vec2i(0, 0), deletedPos), 0);
+  EXPECT_EQ(countObjectsAt(Vec2i(0, 0), movedPos), 1);
+
+  // The object stays in the chunk it moved to.
+  streamer.MoveFocusPoint(focus, Vec2(40.0, 8.0));
+  streamer.Update(Mathf::MaxReal());
+  ASSERT_TRUE(streamer.IsChunkLoaded(Vec2i(2, 0)));
+  EXPECT_EQ(countObjectsAt(Vec2i(2, 0), leftPos), 1);
+}
+
+TEST(MapStreaming, TimeBudget)
+{
+  ChunkedMapScene mapScene(64);
+  StreamScene scene(*mapScene.m_Map);
+  MapStreamer& streamer = *scene.m_Streamer;
+  uint32_t const numChunks = mapScene.m_Map->m_Chunks.size();
+
+  ObjectHandle player = scene.m_World.CreateObject();
+  Transforms* transforms = scene.m_World.GetSystem<Transforms>();
+  transforms->AddTransform(player, translate(Identity<Mat4>(), Vec3(2.0, 2.0, 0.0)));
+  streamer.AddFocusObject(player, 128.0);
+
+  // A single chunk per update without any budget, the closest first.
+  streamer.Update(0.0);
+  EXPECT_EQ(streamer.GetNumLoadedChunks(), 1);
+  EXPECT_TRUE(streamer.IsChunkLoaded(Vec2i(0, 0)));
+  EXPECT_EQ(streamer.GetNumPendingChunks(), numChunks - 1);
+
+  for (uint32_t i = 1; i < numChunks; ++i)
+  {
+    streamer.Update(0.0);
+  }
+  EXPECT_EQ(streamer.GetNumLoadedChunks(), numChunks);
+  EXPECT_EQ(streamer.GetNumPendingChunks(), 0);
+
+  // The focus goes away with its object.
+  scene.m_World.DeleteObject(player);
+  streamer.Update(0.0);
+  EXPECT_EQ(streamer.GetNumLoadedChunks(), 0);
+}
+
+TEST(MapStreaming, TerrainTiling)
+{
+  ChunkedMapScene scene(64);
+  scene.AddTerrain();
+  MapResource& map = *scene.m_Map;
+
+  Vector<MapTiler::Batcher> serialLayers;
+  map.ComputeTerrainGfx(serialLayers, nullptr);
+  ASSERT_EQ(serialLayers.size(), 2);
+  Vector<Vector<float>> serialVertices = FlattenLayers(serialLayers);
+  EXPECT_FALSE(serialVertices[0].empty());
+  EXPECT_FALSE(serialVertices[1].empty());
+
+  JobSystem jobs(4);
+  Vector<MapTiler::Batcher> parallelLayers;
+  map.ComputeTerrainGfx(parallelLayers, &jobs);
+  EXPECT_EQ(FlattenLayers(parallelLayers), serialVertices);
+
+  Vector<Vector<Vector<float>>> chunkVertices;
+  for (auto const& chunk : map.m_Chunks)
+  {
+    Vector<MapTiler::Batcher> chunkLayers;
+    map.ComputeTerrainGfx(chunk, chunkLayers, nullptr);
+    chunkVertices.push_back(FlattenLayers(chunkLayers));
+  }
+
+  map.BakeTerrainGfx(&jobs);
+  for (uint32_t i = 0; i < map.m_Chunks.size(); ++i)
+  {
+    MapResource::Chunk const& chunk = map.m_Chunks[i];
+    EXPECT_TRUE(chunk.m_Terrains.empty());
+    EXPECT_FALSE(chunk.m_TerrainBatches.empty());
+
+    Vector<MapTiler::Batcher> bakedLayers;
+    map.ComputeTerrainGfx(chunk, bakedLayers, nullptr);
+    Vector<Vector<float>> bakedVertices = FlattenLayers(bakedLayers);
+    // Empty trailing layers are not baked.
+    bakedVertices.resize(chunkVertices[i].size());
+    EXPECT_EQ(bakedVertices, chunkVertices[i]) << "Chunk " << i;
+  }
+}
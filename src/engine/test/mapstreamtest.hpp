@@ -0,0 +1,94 @@
+#pragma once
+
+#include <engine/game/commondef.hpp>
+#include <engine/game/archetype.hpp>
+#include <engine/gfx/tileset.hpp>
+#include <engine/map/map.hpp>
+#include <engine/map/maptiler.hpp>
+#include <engine/map/tilinggroup.hpp>
+
+#include <core/resource/resourcemanager.hpp>
+
+namespace eXl
+{
+  // Nothing is written on disk, the paths only have to be unused.
+  Path const s_TestDir("MapStreamTest");
+
+  uint32_t const s_ChunkSize = 16;
+
+  // A square of wall tiles, one world unit each, with an object on every other tile.
+  struct ChunkedMapScene
+  {
+    ChunkedMapScene(uint32_t iMapSide)
+      : m_MapSide(iMapSide)
+    {
+      m_Tileset = Tileset::Create(s_TestDir, "ChunkTileset");
+      Tile tile;
+      tile.m_Size = One<Vec2i>() * EngineCommon::s_WorldToPixel;
+      m_Tileset->AddTile(TileName("Wall"), tile);
+
+      m_Archetype = Archetype::Create(s_TestDir, "ChunkArchetype");
+
+      m_Map = MapResource::Create(s_TestDir, "ChunkMap");
+      MapResource::PlacedTiles placed;
+      placed.m_Type = TerrainTypeName("Wall");
+      placed.m_Tileset.Set(m_Tileset);
+      for (int32_t y = 0; y < int32_t(iMapSide); ++y)
+      {
+        for (int32_t x = 0; x < int32_t(iMapSide); ++x)
+        {
+          MapResource::PlacedTiles::Tile tile;
+          tile.m_Position = Vec2i(x, y) * EngineCommon::s_WorldToPixel + One<Vec2i>() * (EngineCommon::s_WorldToPixel / 2);
+          tile.m_Name = TileName("Wall");
+          placed.m_Tiles.push_back(tile);
+        }
+      }
+      m_Map->m_Tiles.push_back(std::move(placed));
+
+      for (uint32_t i = 0; i < iMapSide * iMapSide / 2; ++i)
+      {
+        MapResource::Object object;
+        // Not sorted, the chunks have to sort them by id.
+        object.m_Header.m_ObjectId = iMapSide * iMapSide - i;
+        object.m_Header.m_DisplayName = "Object" + StringUtil::FromInt(i);
+        object.m_Header.m_Position = Vec3((i * 2) % iMapSide + 0.5, (i * 2) / iMapSide + 0.5, 0.0);
+        object.m_Header.m_Archetype.Set(m_Archetype);
+        m_Map->m_Objects.push_back(std::move(object));
+      }
+      m_Map->BuildChunks(s_ChunkSize);
+    }
+
+    // A floor over the whole map, with squares of a second layer on top.
+    void AddTerrain()
+    {
+      m_TilingGroup = TilingGroup::Create(s_TestDir, "ChunkTilingGroup");
+      m_TilingGroup->SetTileset(*m_Tileset);
+      m_TilingGroup->m_DefaultTile = TileName("Wall");
+
+      MapResource::Terrain terrain;
+      terrain.m_Type = TerrainTypeName("Floor");
+      terrain.m_TilingGroup.Set(m_TilingGroup);
+      MapResource::Terrain::Block floor;
+      floor.m_Shape = AABB2DPolygoni(AABB2Di(0, 0, m_MapSide, m_MapSide));
+      terrain.m_Blocks.push_back(floor);
+      for (int32_t y = 2; y < int32_t(m_MapSide); y += 8)
+      {
+        for (int32_t x = 2; x < int32_t(m_MapSide); x += 8)
+        {
+          MapResource::Terrain::Block square;
+          square.m_Shape = AABB2DPolygoni(AABB2Di(x, y, x + 4, y + 4));
+          square.m_Layer = 1;
+          terrain.m_Blocks.push_back(square);
+        }
+      }
+      m_Map->m_Terrains.push_back(std::move(terrain));
+      m_Map->BuildChunks(s_ChunkSize);
+    }
+
+    uint32_t m_MapSide;
+    Tileset* m_Tileset;
+    TilingGroup* m_TilingGroup = nullptr;
+    Archetype* m_Archetype;
+    MapResource* m_Map;
+  };
+}
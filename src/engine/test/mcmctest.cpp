@@ -0,0 +1,59 @@
+#include <gtest/gtest.h>
+
+#include <gen/mcmcsynthesis.hpp>
+#include <core/thread/jobsystem.hpp>
+
+#include "mcmctest.hpp"
+
+using namespace eXl;
+
+namespace
+{
+  void CheckSame(Vector<MCMC2D::PlacedElement> const& iPlaced1, Vector<MCMC2D::PlacedElement> const& iPlaced2)
+  {
+    ASSERT_EQ(iPlaced1.size(), iPlaced2.size());
+    for (uint32_t i = 0; i < iPlaced1.size(); ++i)
+    {
+      EXPECT_EQ(iPlaced1[i].m_Pos, iPlaced2[i].m_Pos) << "Element " << i;
+      EXPECT_EQ(iPlaced1[i].m_Element, iPlaced2[i].m_Element) << "Element " << i;
+    }
+  }
+
+  void CheckNoOverlap(Vector<MCMC2D::PlacedElement> const& iPlaced)
+  {
+    int const size = 2 * MCMCScene::s_HalfSize;
+    for (uint32_t i = 0; i < iPlaced.size(); ++i)
+    {
+      for (uint32_t j = i + 1; j < iPlaced.size(); ++j)
+      {
+        Vec2i const diff = iPlaced[i].m_Pos - iPlaced[j].m_Pos;
+        ASSERT_TRUE(Mathi::Abs(diff.x) >= size || Mathi::Abs(diff.y) >= size) << "Elements " << i << ", " << j;
+      }
+    }
+  }
+}
+
+TEST(MCMC, CachedRatesMatchFullEvaluation)
+{
+  // The rates cached for death proposals are disabled when debugging, which evaluates every proposal.
+  MCMCScene scene;
+  MCMC2D::Debug debug;
+  Vector<MCMC2D::PlacedElement> cached = scene.Run(20000, 1, nullptr);
+  Vector<MCMC2D::PlacedElement> evaluated = scene.Run(20000, 1, nullptr, &debug);
+
+  EXPECT_FALSE(cached.empty());
+  CheckNoOverlap(cached);
+  CheckSame(cached, evaluated);
+}
+
+TEST(MCMC, ParallelTemperingIsDeterministic)
+{
+  JobSystem jobs(4);
+  MCMCScene scene;
+  Vector<MCMC2D::PlacedElement> serial = scene.Run(20000, 4, nullptr);
+  Vector<MCMC2D::PlacedElement> parallel = scene.Run(20000, 4, &jobs);
+
+  EXPECT_FALSE(serial.empty());
+  CheckNoOverlap(serial);
+  CheckSame(serial, parallel);
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <gen/mcmcsynthesis.hpp>
+#include <core/thread/jobsystem.hpp>
+#include <core/random.hpp>
+
+namespace eXl
+{
+  // Elements repel each other below m_MaxDist, and are indifferent past it.
+  class RepulsionModel : public MCMC2D::LearnedModel
+  {
+  public:
+    RepulsionModel(Vector<DistParams> const& iDist, Vector<MCMC2D::Element> const& iElements)
+      : LearnedModel(iDist, iElements, false)
+    {}
+
+    float Sample(MCMC2D::FullInteraction const& iInter) override
+    {
+      float const ratio = Mathf::Min(iInter.dist / GetMaxDist(iInter.oneHotIdx), 1.0);
+      return 0.2 + 0.8 * ratio * ratio;
+    }
+
+    String const& GetModelName() const override
+    {
+      static String const s_Name("Repulsion");
+      return s_Name;
+    }
+
+    Err Stream(Streamer&) const override { return Err::Failure; }
+    Err Unstream(Unstreamer&) override { return Err::Failure; }
+  };
+
+  struct MCMCScene
+  {
+    static constexpr int s_HalfSize = 5;
+
+    MCMCScene()
+    {
+      MCMC2D::Element element;
+      element.m_Shapes.push_back(Polygoni(AABB2Di(-s_HalfSize, -s_HalfSize, s_HalfSize, s_HalfSize)));
+      element.m_AbsDensity = 4.0;
+      Vector<MCMC2D::Element> elements(1, element);
+
+      MCMC2D::LearnedModel::DistParams dist;
+      dist.m_MaxDist = 20.0;
+      dist.m_EaseOutOffset = 0.0;
+      dist.m_EaseOutCoeff = 0.0;
+      m_Model = std::make_unique<RepulsionModel>(Vector<MCMC2D::LearnedModel::DistParams>(1, dist), elements);
+    }
+
+    MCMC2D::RunParams MakeParams(unsigned int iNumIter, unsigned int iNumChains)
+    {
+      MCMC2D::RunParams params;
+      params.m_Shape = Polygoni(AABB2Di(0, 0, 300, 300));
+      params.m_NumIter = iNumIter;
+      params.m_NumChains = iNumChains;
+      return params;
+    }
+
+    Vector<MCMC2D::PlacedElement> Run(unsigned int iNumIter, unsigned int iNumChains, JobSystem* iJobs, MCMC2D::Debug* iDebug = nullptr)
+    {
+      UniquePtr<Random> rand(Random::CreateDefaultRNG(0));
+      MCMC2D::RunParams params = MakeParams(iNumIter, iNumChains);
+      MCMC2D::Run(*rand, params, m_Model.get(), iDebug, iJobs);
+      return params.m_Placed;
+    }
+
+    UniquePtr<RepulsionModel> m_Model;
+  };
+}
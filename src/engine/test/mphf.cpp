@@ -4,8 +4,11 @@
 #include <core/random.hpp>
 #include <core/clock.hpp>
 #include <core/utils/mphf.hpp>
+#include <core/utils/frozenmap.hpp>
 #include <core/name.hpp>
 
+#include "frozenmaptest.hpp"
+
 #ifdef _WIN32
 #include <intrin.h>
 #else
@@ -152,4 +155,34 @@ TEST(Core, MPHF)
 
     printf("Time MPHFStruct names : %f\n", timer.GetTime());
   }
-}
\ No newline at end of file
+}
+
+TEST(Core, FrozenMap)
+{
+  for (uint32_t numKeys : {0, 1, 2, 31, 100, 5000})
+  {
+    Vector<FrozenTestName> keys = MakeFrozenTestKeys(numKeys);
+    UnorderedMap<FrozenTestName, uint32_t> map;
+    for (uint32_t i = 0; i < numKeys; ++i)
+    {
+      map.insert(std::make_pair(keys[i], i));
+    }
+
+    FrozenMap<FrozenTestName, uint32_t> frozenMap;
+    ASSERT_TRUE(!!frozenMap.Freeze(map));
+    ASSERT_EQ(frozenMap.size(), numKeys);
+    for (uint32_t i = 0; i < numKeys; ++i)
+    {
+      uint32_t const* value = frozenMap.Find(keys[i]);
+      ASSERT_NE(value, nullptr);
+      EXPECT_EQ(*value, i);
+    }
+    for (auto const& entry : frozenMap)
+    {
+      EXPECT_EQ(map[entry.first], entry.second);
+    }
+
+    EXPECT_EQ(frozenMap.Find(FrozenTestName("Missing")), nullptr);
+    EXPECT_EQ(frozenMap.find(FrozenTestName("Missing")), frozenMap.end());
+  }
+}
@@ -0,0 +1,175 @@
+#include <gtest/gtest.h>
+
+#include <engine/common/world.hpp>
+#include <engine/common/transforms.hpp>
+#include <engine/common/gamedatabase.hpp>
+#include <engine/game/commondef.hpp>
+#include <engine/pathfinding/navmesh.hpp>
+#include <engine/pathfinding/navigator.hpp>
+
+#include <core/thread/jobsystem.hpp>
+
+#include "navigatortest.hpp"
+
+using namespace eXl;
+
+namespace
+{
+  bool SameBits(void const* iData1, void const* iData2, size_t iSize)
+  {
+    return memcmp(iData1, iData2, iSize) == 0;
+  }
+
+  // Compares the whole state the navigator keeps per agent, bit for bit.
+  void ExpectSameCrowd(CrowdScene const& iScene1, CrowdScene const& iScene2)
+  {
+    ASSERT_EQ(iScene1.m_Agents.size(), iScene2.m_Agents.size());
+    for (uint32_t i = 0; i < iScene1.m_Agents.size(); ++i)
+    {
+      NavigatorSystem::Agent const& agent1 = *iScene1.m_Navigator->GetAgent(iScene1.m_Agents[i]);
+      NavigatorSystem::Agent const& agent2 = *iScene2.m_Navigator->GetAgent(iScene2.m_Agents[i]);
+
+      ASSERT_TRUE(SameBits(&agent1.m_CorrectedVelocity, &agent2.m_CorrectedVelocity, sizeof(Vec3))) << "Agent " << i;
+      ASSERT_TRUE(SameBits(&agent1.m_PriorityAvoidanceDir, &agent2.m_PriorityAvoidanceDir, sizeof(Vec3))) << "Agent " << i;
+      ASSERT_TRUE(SameBits(&agent1.m_PrevPos, &agent2.m_PrevPos, sizeof(Vec3))) << "Agent " << i;
+      ASSERT_TRUE(SameBits(&agent1.m_TreadmillDir, &agent2.m_TreadmillDir, sizeof(Vec2))) << "Agent " << i;
+      ASSERT_TRUE(SameBits(&agent1.m_AvoidanceFactor, &agent2.m_AvoidanceFactor, sizeof(float))) << "Agent " << i;
+      ASSERT_TRUE(SameBits(&agent1.m_AvoidanceDelta, &agent2.m_AvoidanceDelta, sizeof(float))) << "Agent " << i;
+      ASSERT_EQ(agent1.m_CurPathStep, agent2.m_CurPathStep) << "Agent " << i;
+      ASSERT_EQ(agent1.m_CurComponent, agent2.m_CurComponent) << "Agent " << i;
+      ASSERT_EQ(agent1.m_CurFaceIdx, agent2.m_CurFaceIdx) << "Agent " << i;
+      ASSERT_EQ(agent1.m_Rank, agent2.m_Rank) << "Agent " << i;
+      ASSERT_EQ(agent1.m_RankTimestamp, agent2.m_RankTimestamp) << "Agent " << i;
+      ASSERT_EQ(agent1.m_HasPriority, agent2.m_HasPriority) << "Agent " << i;
+      ASSERT_EQ(agent1.m_HasDest, agent2.m_HasDest) << "Agent " << i;
+      ASSERT_EQ(agent1.m_PriorityAvoidance, agent2.m_PriorityAvoidance) << "Agent " << i;
+      ASSERT_EQ(agent1.m_UnstuckEnabled, agent2.m_UnstuckEnabled) << "Agent " << i;
+
+      NavigatorSystem::Obstacle const& obs1 = *iScene1.m_Navigator->GetObstacle(iScene1.m_Agents[i]);
+      NavigatorSystem::Obstacle const& obs2 = *iScene2.m_Navigator->GetObstacle(iScene2.m_Agents[i]);
+      ASSERT_TRUE(SameBits(&obs1.m_Dir, &obs2.m_Dir, sizeof(Vec3))) << "Agent " << i;
+      ASSERT_TRUE(SameBits(&obs1.m_Speed, &obs2.m_Speed, sizeof(float))) << "Agent " << i;
+      ASSERT_TRUE(SameBits(&obs1.m_ImmobilityFactor, &obs2.m_ImmobilityFactor, sizeof(float))) << "Agent " << i;
+
+      Mat4 const& trans1 = iScene1.m_Transforms->GetWorldTransform(iScene1.m_Agents[i]);
+      Mat4 const& trans2 = iScene2.m_Transforms->GetWorldTransform(iScene2.m_Agents[i]);
+      ASSERT_TRUE(SameBits(&trans1[3], &trans2[3], sizeof(Vec4))) << "Agent " << i;
+    }
+  }
+
+  // Returns the length of the path, or a negative value if it does not lead from the start face to the end face.
+  float CheckPath(NavMesh const& iMesh, NavMesh::PathQuery const& iQuery, NavMesh::Path const& iPath)
+  {
+    auto startFace = iMesh.FindFace(iQuery.m_Start);
+    auto endFace = iMesh.FindFace(iQuery.m_End);
+    auto const& edges = iMesh.GetEdges(startFace->m_Component);
+    if (iPath.m_Edges.empty())
+    {
+      return *startFace == *endFace ? 0.0 : -1.0;
+    }
+
+    auto touch = [](NavMesh::Edge const& iEdge, uint32_t iFace) { return iEdge.face1 == iFace || iEdge.face2 == iFace; };
+    if (!touch(edges[iPath.m_Edges.back()], startFace->m_Face)
+      || !touch(edges[iPath.m_Edges.front()], endFace->m_Face))
+    {
+      return -1.0;
+    }
+
+    float pathLength = 0;
+    for (uint32_t i = 1; i < iPath.m_Edges.size(); ++i)
+    {
+      NavMesh::Edge const& edge = edges[iPath.m_Edges[i]];
+      NavMesh::Edge const& nextEdge = edges[iPath.m_Edges[i - 1]];
+      if (!edge.CommonFace(nextEdge))
+      {
+        return -1.0;
+      }
+      pathLength += length((edge.segment.m_Ext1 + edge.segment.m_Ext2) - (nextEdge.segment.m_Ext1 + nextEdge.segment.m_Ext2)) * 0.5;
+    }
+    return pathLength;
+  }
+}
+
+TEST(Navigator, ParallelTickIsDeterministic)
+{
+  uint32_t const numAgents = 500;
+  uint32_t const numSteps = 30;
+
+  CrowdScene serialScene(numAgents, nullptr);
+  for (uint32_t step = 0; step < numSteps; ++step)
+  {
+    serialScene.Step(1.0 / 60);
+  }
+
+  for (uint32_t numWorkers : {1, 3, 7})
+  {
+    JobSystem jobs(numWorkers);
+    CrowdScene parallelScene(numAgents, &jobs);
+    for (uint32_t step = 0; step < numSteps; ++step)
+    {
+      parallelScene.Step(1.0 / 60);
+    }
+    ExpectSameCrowd(serialScene, parallelScene);
+  }
+}
+
+TEST(Navigator, BatchedPathsMatchSingleQueries)
+{
+  int32_t const side = 8;
+  NavMesh navMesh = MakeRoomsNavMesh(side, CrowdScene::s_RoomSize, CrowdScene::s_CorridorSize);
+  Vector<NavMesh::PathQuery> queries = MakeRallyQueries(side, 200);
+
+  Vector<Optional<NavMesh::Path>> batchedPaths;
+  navMesh.FindPaths(queries, batchedPaths);
+  ASSERT_EQ(batchedPaths.size(), queries.size());
+
+  for (uint32_t i = 0; i < queries.size(); ++i)
+  {
+    Optional<NavMesh::Path> path = navMesh.FindPath(queries[i].m_Start, queries[i].m_End);
+    ASSERT_TRUE(path && batchedPaths[i]) << "Query " << i;
+
+    float const pathLength = CheckPath(navMesh, queries[i], *path);
+    float const batchedLength = CheckPath(navMesh, queries[i], *batchedPaths[i]);
+    ASSERT_GE(pathLength, 0.0) << "Query " << i;
+    ASSERT_GE(batchedLength, 0.0) << "Query " << i;
+    EXPECT_LE(batchedLength, pathLength + 1.0e-3) << "Query " << i;
+
+    // Served from the cache, or recomputed, the result does not change.
+    Optional<NavMesh::Path> cachedPath = navMesh.FindPath(queries[i].m_Start, queries[i].m_End);
+    EXPECT_EQ(cachedPath->m_Edges, path->m_Edges) << "Query " << i;
+    navMesh.ClearPathCache();
+    Optional<NavMesh::Path> recomputedPath = navMesh.FindPath(queries[i].m_Start, queries[i].m_End);
+    EXPECT_EQ(recomputedPath->m_Edges, path->m_Edges) << "Query " << i;
+  }
+}
+
+TEST(Navigator, PathCacheKeepsTheDestination)
+{
+  int32_t const side = 8;
+  NavMesh navMesh = MakeRoomsNavMesh(side, CrowdScene::s_RoomSize, CrowdScene::s_CorridorSize);
+  Vector<NavMesh::PathQuery> queries = MakeRallyQueries(side, 50);
+
+  for (uint32_t i = 0; i < queries.size(); ++i)
+  {
+    // Other corner of the rally room, the search aims at it rather than at the face.
+    NavMesh::PathQuery otherQuery = queries[i];
+    otherQuery.m_End += Vec2(CrowdScene::s_RoomSize - 3, CrowdScene::s_RoomSize - 3);
+
+    navMesh.ClearPathCache();
+    Optional<NavMesh::Path> expected = navMesh.FindPath(otherQuery.m_Start, otherQuery.m_End);
+    ASSERT_TRUE(expected) << "Query " << i;
+
+    navMesh.ClearPathCache();
+    navMesh.FindPath(queries[i].m_Start, queries[i].m_End);
+    Optional<NavMesh::Path> path = navMesh.FindPath(otherQuery.m_Start, otherQuery.m_End);
+    ASSERT_TRUE(path) << "Query " << i;
+    EXPECT_EQ(path->m_Edges, expected->m_Edges) << "Query " << i;
+    EXPECT_EQ(path->m_EdgeDirs, expected->m_EdgeDirs) << "Query " << i;
+
+    Vector<Optional<NavMesh::Path>> batchedPaths;
+    navMesh.FindPaths({queries[i], otherQuery}, batchedPaths);
+    ASSERT_EQ(batchedPaths.size(), 2u);
+    ASSERT_TRUE(batchedPaths[1]) << "Query " << i;
+    EXPECT_GE(CheckPath(navMesh, otherQuery, *batchedPaths[1]), 0.0) << "Query " << i;
+  }
+}
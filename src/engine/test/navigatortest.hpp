@@ -0,0 +1,225 @@
+#pragma once
+
+#include <engine/common/world.hpp>
+#include <engine/common/transforms.hpp>
+#include <engine/common/gamedatabase.hpp>
+#include <engine/game/commondef.hpp>
+#include <engine/pathfinding/navmesh.hpp>
+#include <engine/pathfinding/navigator.hpp>
+#include <math/mathtools.hpp>
+
+#include <core/thread/jobsystem.hpp>
+#include <core/random.hpp>
+#include <core/clock.hpp>
+
+namespace eXl
+{
+  // Brute force grid, stands in for the physics broadphase.
+  class GridNeighbours : public NeighborhoodExtraction
+  {
+  public:
+    GridNeighbours(Transforms& iTransforms)
+      : m_Transforms(iTransforms)
+    {}
+
+    void AddObject(ObjectHandle iObj, float iRadius, bool iPopulateNeigh) override
+    {
+      m_Objects.insert(std::make_pair(iObj, m_Handles.size()));
+      m_Handles.push_back(iObj);
+      m_ObjectsNeigh.push_back(Neigh());
+      m_ObjectsNeigh.back().m_Shape = Neigh::Sphere;
+      m_ObjectsNeigh.back().populateNeigh = iPopulateNeigh;
+    }
+
+    void AddObject(ObjectHandle iObj, Vec3 const& iBoxDim, bool iPopulateNeigh) override
+    {
+      AddObject(iObj, 0.0, iPopulateNeigh);
+      m_ObjectsNeigh.back().m_Shape = Neigh::Box;
+    }
+
+    void Run(Vec3 const& iForwardOffset, float iRadiusSearch) override
+    {
+      auto cellKey = [](int32_t iX, int32_t iY)
+      {
+        return (uint64_t(uint32_t(iX)) << 32) | uint32_t(iY);
+      };
+
+      m_Positions.clear();
+      m_Cells.clear();
+      for (uint32_t i = 0; i < m_Handles.size(); ++i)
+      {
+        Vec2 pos = MathTools::As2DVec(Vec3(m_Transforms.GetWorldTransform(m_Handles[i])[3]));
+        m_Positions.push_back(pos);
+        m_Cells[cellKey(Mathf::Floor(pos.x / iRadiusSearch), Mathf::Floor(pos.y / iRadiusSearch))].push_back(i);
+      }
+
+      float const maxSqDist = iRadiusSearch * iRadiusSearch;
+      for (uint32_t i = 0; i < m_Handles.size(); ++i)
+      {
+        Neigh& neigh = m_ObjectsNeigh[i];
+        neigh.numNeigh = 0;
+        if (!neigh.populateNeigh)
+        {
+          continue;
+        }
+        Vec2 const pos = m_Positions[i];
+        int32_t const cellX = Mathf::Floor(pos.x / iRadiusSearch);
+        int32_t const cellY = Mathf::Floor(pos.y / iRadiusSearch);
+        for (int32_t y = cellY - 1; y <= cellY + 1; ++y)
+        {
+          for (int32_t x = cellX - 1; x <= cellX + 1; ++x)
+          {
+            auto cell = m_Cells.find(cellKey(x, y));
+            if (cell == m_Cells.end())
+            {
+              continue;
+            }
+            for (uint32_t other : cell->second)
+            {
+              Vec2 const diff = m_Positions[other] - pos;
+              float const sqDist = dot(diff, diff);
+              if (other == i || sqDist > maxSqDist)
+              {
+                continue;
+              }
+              // Keep the closest ones, sorted by distance.
+              uint32_t slot = neigh.numNeigh;
+              while (slot > 0 && neigh.neighSqDist[slot - 1] > sqDist)
+              {
+                if (slot < s_NumNeigh)
+                {
+                  neigh.neighbors[slot] = neigh.neighbors[slot - 1];
+                  neigh.neighSqDist[slot] = neigh.neighSqDist[slot - 1];
+                }
+                --slot;
+              }
+              if (slot < s_NumNeigh)
+              {
+                neigh.neighbors[slot] = other;
+                neigh.neighSqDist[slot] = sqDist;
+                if (neigh.numNeigh < s_NumNeigh)
+                {
+                  ++neigh.numNeigh;
+                }
+              }
+            }
+          }
+        }
+      }
+    }
+
+  protected:
+    Transforms& m_Transforms;
+    Vector<Vec2> m_Positions;
+    UnorderedMap<uint64_t, Vector<uint32_t>> m_Cells;
+  };
+
+  // Square grid of rooms, linked to their neighbours by corridors.
+  inline NavMesh MakeRoomsNavMesh(int32_t iSide, int32_t iRoomSize, int32_t iCorridorSize)
+  {
+    int32_t const stride = iRoomSize + iCorridorSize;
+    int32_t const corridorOffset = (iRoomSize - iCorridorSize) / 2;
+    Vector<AABB2Di> boxes;
+    for (int32_t y = 0; y < iSide; ++y)
+    {
+      for (int32_t x = 0; x < iSide; ++x)
+      {
+        boxes.push_back(AABB2Di::FromMinAndSize(Vec2i(x * stride, y * stride), Vec2i(iRoomSize, iRoomSize)));
+        if (x + 1 < iSide)
+        {
+          boxes.push_back(AABB2Di::FromMinAndSize(Vec2i(x * stride + iRoomSize, y * stride + corridorOffset), Vec2i(iCorridorSize, iCorridorSize)));
+        }
+        if (y + 1 < iSide)
+        {
+          boxes.push_back(AABB2Di::FromMinAndSize(Vec2i(x * stride + corridorOffset, y * stride + iRoomSize), Vec2i(iCorridorSize, iCorridorSize)));
+        }
+      }
+    }
+    return NavMesh::MakeFromBoxes(boxes);
+  }
+
+  struct CrowdScene
+  {
+    static constexpr int32_t s_RoomSize = 12;
+    static constexpr int32_t s_CorridorSize = 4;
+    static constexpr uint32_t s_AgentsPerRoom = 8;
+
+    CrowdScene(uint32_t iNumAgents, JobSystem* iJobs)
+      : m_World(EngineCommon::GetComponents(), iJobs)
+    {
+      m_World.AddSystem(std::make_unique<GameDatabase>(EngineCommon::GetBaseProperties()));
+      m_Transforms = m_World.AddSystem(std::make_unique<Transforms>());
+      m_Navigator = m_World.AddSystem(std::make_unique<NavigatorSystem>(*m_Transforms));
+
+      int32_t const side = Mathf::Ceil(Mathf::Sqrt(float(iNumAgents) / s_AgentsPerRoom));
+      m_NavMesh.reset(new NavMesh(MakeRoomsNavMesh(side, s_RoomSize, s_CorridorSize)));
+      m_Navigator->SetNavMesh(*m_NavMesh);
+      m_Neighbours.reset(new GridNeighbours(*m_Transforms));
+
+      UniquePtr<Random> rand(Random::CreateDefaultRNG(0));
+      auto randomPos = [&]
+      {
+        int32_t const stride = s_RoomSize + s_CorridorSize;
+        uint32_t room = rand->Generate() % (side * side);
+        Vec2 roomMin((room % side) * stride, (room / side) * stride);
+        Vec2 offset(rand->Generate() % 1000, rand->Generate() % 1000);
+        return Vec3(roomMin + One<Vec2>() + offset * ((s_RoomSize - 2) / 1000.0f), 0.0);
+      };
+
+      for (uint32_t i = 0; i < iNumAgents; ++i)
+      {
+        ObjectHandle agent = m_World.CreateObject();
+        m_Transforms->AddTransform(agent, translate(Identity<Mat4>(), randomPos()));
+        m_Navigator->AddNavigator(agent, 0.5, 4.0);
+        m_Navigator->SetDestination(agent, randomPos());
+        m_Neighbours->AddObject(agent, 0.5, true);
+        m_Agents.push_back(agent);
+      }
+    }
+
+    // Returns the time spent in the navigator.
+    float Step(float iDelta)
+    {
+      m_Neighbours->Run(Zero<Vec3>(), 4.0);
+
+      Clock timer;
+      timer.GetTime();
+      m_Navigator->Tick(iDelta, *m_Neighbours);
+      float const tickTime = timer.GetTime();
+
+      GameDataView<Vec3>* velocities = EngineCommon::GetVelocities(m_World);
+      for (ObjectHandle agent : m_Agents)
+      {
+        Vec3 const velocity = m_Navigator->GetAgent(agent)->m_CorrectedVelocity;
+        velocities->GetOrCreate(agent) = velocity;
+        Mat4 transform = m_Transforms->GetWorldTransform(agent);
+        transform[3] += Vec4(velocity * iDelta, 0.0);
+        m_Transforms->UpdateTransform(agent, transform);
+      }
+      return tickTime;
+    }
+
+    UniquePtr<NavMesh> m_NavMesh;
+    World m_World;
+    Transforms* m_Transforms;
+    NavigatorSystem* m_Navigator;
+    UniquePtr<GridNeighbours> m_Neighbours;
+    Vector<ObjectHandle> m_Agents;
+  };
+
+  inline Vector<NavMesh::PathQuery> MakeRallyQueries(int32_t iSide, uint32_t iNumQueries)
+  {
+    int32_t const stride = CrowdScene::s_RoomSize + CrowdScene::s_CorridorSize;
+    UniquePtr<Random> rand(Random::CreateDefaultRNG(0));
+    Vec2 const rallyPoint(stride * (iSide / 2) + 1, stride * (iSide / 2) + 1);
+    Vector<NavMesh::PathQuery> queries;
+    for (uint32_t i = 0; i < iNumQueries; ++i)
+    {
+      NavMesh::PathQuery query;
+      query.m_Start = Vec2((rand->Generate() % iSide) * stride + 1, (rand->Generate() % iSide) * stride + 1);
+      query.m_End = rallyPoint;
+      queries.push_back(query);
+    }
+    return queries;
+  }
+}
@@ -0,0 +1,49 @@
+#include <gtest/gtest.h>
+
+#include <engine/common/world.hpp>
+#include <engine/common/transforms.hpp>
+#include <engine/common/gamedatabase.hpp>
+#include <engine/game/commondef.hpp>
+#include <engine/physics/physicsys.hpp>
+
+#include <algorithm>
+
+#include "neighbourstest.hpp"
+
+using namespace eXl;
+
+TEST(Neighbours, GridMatchesBruteForce)
+{
+  float const searchRadius = 3.0;
+  NeighScene scene(2000, 80.0, NeighborhoodKind::Grid);
+
+  NeighborhoodExtraction& neighExt = scene.m_Physics->GetNeighborhoodExtraction();
+  neighExt.Run(Zero<Vec3>(), searchRadius);
+
+  float const reach = 2 * NeighScene::s_Radius + searchRadius;
+  for (ObjectHandle obj : scene.m_Objects)
+  {
+    Vec2 const pos = scene.GetPos(obj);
+    Vector<float> expectedDist;
+    for (ObjectHandle other : scene.m_Objects)
+    {
+      Vec2 const diff = scene.GetPos(other) - pos;
+      if (other != obj && Mathf::Abs(diff.x) <= reach && Mathf::Abs(diff.y) <= reach)
+      {
+        expectedDist.push_back(dot(diff, diff));
+      }
+    }
+    std::sort(expectedDist.begin(), expectedDist.end());
+    expectedDist.resize(std::min<size_t>(expectedDist.size(), NeighborhoodExtraction::s_NumNeigh));
+
+    NeighborhoodExtraction::Neigh const& neigh = neighExt.GetNeigh()[neighExt.GetObjects().find(obj)->second];
+    ASSERT_EQ(neigh.numNeigh, expectedDist.size());
+    for (uint32_t i = 0; i < neigh.numNeigh; ++i)
+    {
+      EXPECT_NEAR(neigh.neighSqDist[i], expectedDist[i], 1.0e-4);
+      ObjectHandle neighObj = neighExt.GetHandles()[neigh.neighbors[i]];
+      Vec2 const diff = scene.GetPos(neighObj) - pos;
+      EXPECT_NEAR(dot(diff, diff), neigh.neighSqDist[i], 1.0e-4);
+    }
+  }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <engine/common/world.hpp>
+#include <engine/common/transforms.hpp>
+#include <engine/common/gamedatabase.hpp>
+#include <engine/game/commondef.hpp>
+#include <engine/physics/physicsys.hpp>
+
+#include <core/random.hpp>
+
+namespace eXl
+{
+  struct NeighScene
+  {
+    static constexpr float s_Radius = 0.5;
+
+    NeighScene(uint32_t iNumObjects, float iSide, NeighborhoodKind iKind)
+      : m_World(EngineCommon::GetComponents())
+    {
+      m_World.AddSystem(std::make_unique<GameDatabase>(EngineCommon::GetBaseProperties()));
+      m_Transforms = m_World.AddSystem(std::make_unique<Transforms>());
+      m_Physics = m_World.AddSystem(std::make_unique<PhysicsSystem>(*m_Transforms, iKind));
+
+      UniquePtr<Random> rand(Random::CreateDefaultRNG(0));
+      for (uint32_t i = 0; i < iNumObjects; ++i)
+      {
+        Vec3 pos((rand->Generate() % 10000) * iSide / 10000, (rand->Generate() % 10000) * iSide / 10000, 0.0);
+        ObjectHandle obj = m_World.CreateObject();
+        m_Transforms->AddTransform(obj, translate(Identity<Mat4>(), pos));
+
+        PhysicInitData desc;
+        desc.SetFlags(PhysicFlags::NoGravity | PhysicFlags::LockZ | PhysicFlags::LockRotation | PhysicFlags::Kinematic);
+        desc.AddSphere(s_Radius);
+        m_Physics->CreateComponent(obj, desc);
+        m_Physics->GetNeighborhoodExtraction().AddObject(obj, s_Radius, true);
+        m_Objects.push_back(obj);
+      }
+    }
+
+    Vec2 GetPos(ObjectHandle iObj)
+    {
+      return Vec2(m_Transforms->GetWorldTransform(iObj)[3]);
+    }
+
+    World m_World;
+    Transforms* m_Transforms;
+    PhysicsSystem* m_Physics;
+    Vector<ObjectHandle> m_Objects;
+  };
+}
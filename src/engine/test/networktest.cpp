@@ -7,201 +7,10 @@
 #include <engine/common/transforms.hpp>
 #include <engine/net/network.hpp>
 
-struct WorldState;
-
-namespace eXl
-{
-  namespace Network
-  {
-    class TestNetDriver : public NetDriver
-    {
-    public:
-
-      std::function<void(uint32_t iParam1, float iParam2, String const& iParam3)> TestCommand;
-      std::function<void(uint32_t iLocalClient, ObjectId iObject)> AssignPlayer;
-      std::function<void(ClientId iClientId, ClientInputData const& iData)> SetPlayerInput;
-
-      TestNetDriver(NetCtx& iCtx)
-        : NetDriver(iCtx)
-      {
-        DECLARE_CLIENT_RELIABLE_COMMAND(TestCommand);
-        DECLARE_CLIENT_RELIABLE_COMMAND(AssignPlayer);
-        DECLARE_SERVER_RELIABLE_COMMAND(SetPlayerInput);
-      }
-    };
-  }
-}
+#include "networktest.hpp"
 
 using namespace eXl;
 
-struct WorldState
-{
-  UnorderedMap<Network::ObjectId, Network::ClientData> m_Objects;
-  UnorderedMap<Network::ClientId, Network::ClientInputData> m_Clients;
-  UnorderedMap<Network::ClientId, Network::ObjectId> m_ClientToObject;
-
-  void TickAuth(float iDelta, UnorderedSet<Network::ObjectId>& oToUpdate)
-  {
-    for (auto const& client : m_Clients)
-    {
-      auto iterObject = m_ClientToObject.find(client.first);
-      ASSERT_TRUE(iterObject != m_ClientToObject.end());
-      auto iter = m_Objects.find(iterObject->second);
-      ASSERT_TRUE(iter != m_Objects.end());
-      if (client.second.m_Moving)
-      {
-        iter->second.m_Moving = true;
-        iter->second.m_Dir = client.second.m_Dir;
-        iter->second.m_Pos += client.second.m_Dir * iDelta;
-        oToUpdate.insert(iter->first);
-      }
-      else if(iter->second.m_Moving)
-      {
-        iter->second.m_Moving = false;
-        oToUpdate.insert(iter->first);
-      }
-    }
-  }
-};
-
-struct TestClientEvents
-{
-  static void OnNewObject(WorldState& iWorld, Network::ObjectId iObject, Network::ClientData const& iData)
-  {
-    auto insertRes = iWorld.m_Objects.insert(std::make_pair(iObject, iData));
-    ASSERT_TRUE(insertRes.second);
-  }
-
-  static void OnObjectDeleted(WorldState& iWorld, Network::ObjectId iObject)
-  {
-    ASSERT_EQ(iWorld.m_Objects.erase(iObject), 1);
-  }
-
-  static void OnObjectUpdated(WorldState& iWorld, Network::ObjectId iObject, Network::ClientData const& iData)
-  {
-    auto iterObj = iWorld.m_Objects.find(iObject);
-    ASSERT_TRUE(iterObj != iWorld.m_Objects.end());
-    iterObj->second = iData;
-  }
-};
-
-struct TestServerEvents
-{
-  void OnClientConnected(Network::ClientId iClient)
-  {
-    auto handle = m_Objects.Alloc();
-    Network::ObjectId netId{ handle.GetId() };
-    auto insertClientRes = m_World.m_Clients.insert(std::make_pair(iClient, Network::ClientInputData()));
-    ASSERT_TRUE(insertClientRes.second);
-
-    auto insertClientObj = m_World.m_Objects.insert(std::make_pair(netId, Network::ClientData()));
-    ASSERT_TRUE(insertClientObj.second);
-
-    m_World.m_ClientToObject.insert(std::make_pair(iClient, netId));
-
-    m_NewObjects.insert(netId);
-    m_NewClient.insert(iClient);
-  }
-
-  void OnClientDisconnected(Network::ClientId iClient)
-  {
-
-  }
-
-  void OnClientCommand(Network::ClientId iClient, Network::ClientInputData const& iData)
-  {
-    auto clientData = m_World.m_Clients.find(iClient);
-    ASSERT_TRUE(clientData != m_World.m_Clients.end());
-    clientData->second = iData;
-  }
-
-  void TickAuth(float iDelta)
-  {
-    m_World.TickAuth(iDelta, m_ToUpdate);
-  }
-
-  void FlushAuth(Network::Server& iServer)
-  {
-    for (auto const& newObj : m_NewObjects)
-    {
-      for (auto const& client : m_World.m_Clients)
-      {
-        if (m_NewClient.count(client.first) != 0)
-        {
-          continue;
-        }
-        iServer.CreateObject(client.first, newObj, m_World.m_Objects[newObj]);
-      }
-    }
-    m_NewObjects.clear();
-
-    for (Network::ClientId newClient : m_NewClient)
-    {
-      for (auto const& object : m_World.m_Objects)
-      {
-        iServer.CreateObject(newClient, object.first, object.second);
-      }
-    }
-    m_NewClient.clear();
-
-    for (Network::ObjectId object : m_ToUpdate)
-    {
-      for (auto const& client : m_World.m_Clients)
-      {
-        iServer.UpdateObject(client.first, object, m_World.m_Objects[object]);
-      }
-    }
-    m_ToUpdate.clear();
-  }
-
-  ObjectTable<int> m_Objects;
-  UnorderedSet<Network::ObjectId> m_NewObjects;
-  UnorderedSet<Network::ClientId> m_NewClient;
-  UnorderedSet<Network::ObjectId> m_ToUpdate;
-  WorldState m_World;
-};
-
-struct NetworkSim
-{
-  Network::NetCtx ctx;
-  Network::TestNetDriver driver;
-  Vector<uint8_t> key;
-  Clock timer;
-
-  NetworkSim()
-    : driver(ctx)
-  {
-    key.resize(Network::Server::s_PrivateKeySize, 0);
-  }
-
-  void Tick(float iTimeout, std::function<bool()> iWaitCondition = [] { return false; })
-  {
-    float elapsedTime = 0.0;
-    float lastDelta = 0.0;
-    while (elapsedTime < iTimeout)
-    {
-      lastDelta = timer.GetTime();
-      elapsedTime += lastDelta;
-      if (ctx.m_Server)
-      {
-        ctx.m_Server->Tick();
-        ctx.m_Server->Flush();
-      }
-
-      for (auto const& client : ctx.m_Clients)
-      {
-        client->Tick();
-        client->Flush();
-      }
-
-      if (iWaitCondition && iWaitCondition())
-      {
-        break;
-      }
-    }
-  }
-};
-
 TEST(Network, BasicConnect)
 {
   String const serverAddress("127.0.0.1:21616");
@@ -361,4 +170,152 @@ TEST(Network, BasicRepl)
   //serverEvents.TickAuth(1.0);
   //serverEvents.FlushAuth(*net.ctx.m_Server);
   //net.Tick(0.01);
-}
\ No newline at end of file
+}
+
+TEST(Network, InterestManagement)
+{
+  String const serverAddress("127.0.0.1");
+
+  NetworkSim net;
+  WorldState clientWorld;
+  net.ctx.m_ClientEvents.OnNewObject = [&](uint32_t, Network::ObjectId iObject, Network::ClientData const& iData)
+  {
+    TestClientEvents::OnNewObject(clientWorld, iObject, iData);
+  };
+  net.ctx.m_ClientEvents.OnObjectUpdated = [&](uint32_t, Network::ObjectId iObject, Network::ClientData const& iData)
+  {
+    TestClientEvents::OnObjectUpdated(clientWorld, iObject, iData);
+  };
+  net.ctx.m_ClientEvents.OnObjectDeleted = [&](uint32_t, Network::ObjectId iObject)
+  {
+    TestClientEvents::OnObjectDeleted(clientWorld, iObject);
+  };
+
+  Network::Server::Start(net.ctx, serverAddress, net.key);
+  ASSERT_TRUE(net.ctx.m_Server != nullptr);
+
+  Network::ServerDispatcher& dispatcher = net.ctx.m_Server->GetDispatcher();
+  Network::InterestParams const params = dispatcher.GetInterestParams();
+
+  Network::ObjectId const playerObj{ 1 };
+  Network::ObjectId const nearObj{ 2 };
+  Network::ObjectId const farObj{ 3 };
+
+  net.ctx.m_ServerEvents.OnClientConnected = [&](Network::ClientId iClient)
+  {
+    dispatcher.CreateObject(playerObj, Network::ClientData());
+    dispatcher.AddClient(iClient, playerObj);
+  };
+
+  Network::ClientData nearData;
+  nearData.m_Pos = UnitX<Vector3f>() * params.m_EnterRadius * 0.5;
+  dispatcher.CreateObject(nearObj, nearData);
+
+  Network::ClientData farData;
+  farData.m_Pos = UnitX<Vector3f>() * params.m_LeaveRadius * 2;
+  dispatcher.CreateObject(farObj, farData);
+
+  ASSERT_TRUE(Network::Client::ConnectLoopback(net.ctx, "1"));
+
+  net.Tick(1.0, [&] { return clientWorld.m_Objects.size() >= 2; });
+  ASSERT_EQ(clientWorld.m_Objects.size(), 2);
+  ASSERT_EQ(clientWorld.m_Objects.count(playerObj), 1);
+  ASSERT_EQ(clientWorld.m_Objects.count(nearObj), 1);
+
+  // Entering the area of interest.
+  farData.m_Pos = UnitY<Vector3f>() * params.m_EnterRadius * 0.9;
+  dispatcher.UpdateObject(farObj, farData);
+  net.Tick(1.0, [&] { return clientWorld.m_Objects.count(farObj) != 0; });
+  ASSERT_EQ(clientWorld.m_Objects.count(farObj), 1);
+
+  // Between the enter and leave radius, still relevant and updated.
+  nearData.m_Pos = UnitX<Vector3f>() * (params.m_EnterRadius + params.m_LeaveRadius) * 0.5;
+  dispatcher.UpdateObject(nearObj, nearData);
+  net.Tick(1.0, [&] { return clientWorld.m_Objects[nearObj].m_Pos == nearData.m_Pos; });
+  ASSERT_TRUE(clientWorld.m_Objects[nearObj].m_Pos == nearData.m_Pos);
+
+  // Leaving the area of interest.
+  nearData.m_Pos = UnitX<Vector3f>() * params.m_LeaveRadius * 1.5;
+  dispatcher.UpdateObject(nearObj, nearData);
+  net.Tick(1.0, [&] { return clientWorld.m_Objects.count(nearObj) == 0; });
+  ASSERT_EQ(clientWorld.m_Objects.count(nearObj), 0);
+
+  dispatcher.DeleteObject(farObj);
+  net.Tick(1.0, [&] { return clientWorld.m_Objects.count(farObj) == 0; });
+  ASSERT_EQ(clientWorld.m_Objects.count(farObj), 0);
+  ASSERT_EQ(clientWorld.m_Objects.count(playerObj), 1);
+
+  // Cells left by the objects are not kept.
+  EXPECT_LE(dispatcher.GetNumGridCells(), dispatcher.GetObjects().size());
+}
+
+TEST(Network, DeltaReplication)
+{
+  uint32_t const numObjects = 100;
+  ReplicationScene scene(numObjects);
+  ASSERT_EQ(scene.clientWorld.m_Objects.size(), numObjects + 1);
+
+  // First batch holds every object, the next ones are relative to it.
+  scene.Move(0, 0.0);
+  scene.net.Step();
+  scene.net.Step();
+  ASSERT_TRUE(scene.IsSynchronized());
+
+  for (uint32_t step = 0; step < 30; ++step)
+  {
+    Network::ReplicationStats const prevStats = scene.net.ctx.m_Server->GetReplicationStats();
+    scene.Move(step, 0.1);
+    scene.net.Step();
+    ASSERT_TRUE(scene.IsSynchronized());
+
+    // Only the moving objects are sent.
+    Network::ReplicationStats const& stats = scene.net.ctx.m_Server->GetReplicationStats();
+    ASSERT_EQ(stats.m_NumBatches, prevStats.m_NumBatches + 1);
+    ASSERT_LE(stats.m_NumEntries - prevStats.m_NumEntries, numObjects / 10);
+  }
+
+  // Once acknowledged, nothing changes and nothing is sent.
+  scene.Move(0, 0.0);
+  scene.net.Step();
+  scene.net.Step();
+  uint64_t const numBatches = scene.net.ctx.m_Server->GetReplicationStats().m_NumBatches;
+  scene.Move(0, 0.0);
+  scene.net.Step();
+  ASSERT_EQ(scene.net.ctx.m_Server->GetReplicationStats().m_NumBatches, numBatches);
+
+  scene.dispatcher->DeleteObject(scene.m_Objects[0]);
+  scene.serverWorld.m_Objects.erase(scene.m_Objects[0]);
+  scene.net.Step();
+  ASSERT_EQ(scene.clientWorld.m_Objects.count(scene.m_Objects[0]), 0);
+  ASSERT_TRUE(scene.IsSynchronized());
+}
+
+TEST(Network, ReplicationOutOfQuantizationRange)
+{
+  uint32_t const numObjects = 20;
+  ReplicationScene scene(numObjects);
+  scene.Move(0, 0.0);
+  scene.net.Step();
+  scene.net.Step();
+  ASSERT_TRUE(scene.IsSynchronized());
+
+  // Beyond the quantization bounds, positions fall back to full precision instead of being clamped.
+  scene.Translate(Vec3(10000.0, -6000.0, 0.0));
+  scene.net.Step();
+  scene.net.Step();
+  ASSERT_TRUE(scene.IsSynchronized());
+
+  for (uint32_t step = 0; step < 5; ++step)
+  {
+    scene.Move(step, 0.5);
+    scene.net.Step();
+    ASSERT_TRUE(scene.IsSynchronized());
+  }
+
+  // And back to quantized positions.
+  scene.Translate(Vec3(-10000.0, 6000.0, 0.0));
+  scene.Move(0, 0.5);
+  scene.net.Step();
+  scene.net.Step();
+  ASSERT_TRUE(scene.IsSynchronized());
+}
@@ -0,0 +1,312 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <core/clock.hpp>
+#include <engine/common/world.hpp>
+#include <engine/net/network.hpp>
+
+struct WorldState;
+
+namespace eXl
+{
+  namespace Network
+  {
+    class TestNetDriver : public NetDriver
+    {
+    public:
+
+      std::function<void(uint32_t iParam1, float iParam2, String const& iParam3)> TestCommand;
+      std::function<void(uint32_t iLocalClient, ObjectId iObject)> AssignPlayer;
+      std::function<void(ClientId iClientId, ClientInputData const& iData)> SetPlayerInput;
+
+      TestNetDriver(NetCtx& iCtx)
+        : NetDriver(iCtx)
+      {
+        DECLARE_CLIENT_RELIABLE_COMMAND(TestCommand);
+        DECLARE_CLIENT_RELIABLE_COMMAND(AssignPlayer);
+        DECLARE_SERVER_RELIABLE_COMMAND(SetPlayerInput);
+      }
+    };
+  }
+}
+
+using namespace eXl;
+
+struct WorldState
+{
+  UnorderedMap<Network::ObjectId, Network::ClientData> m_Objects;
+  UnorderedMap<Network::ClientId, Network::ClientInputData> m_Clients;
+  UnorderedMap<Network::ClientId, Network::ObjectId> m_ClientToObject;
+
+  void TickAuth(float iDelta, UnorderedSet<Network::ObjectId>& oToUpdate)
+  {
+    for (auto const& client : m_Clients)
+    {
+      auto iterObject = m_ClientToObject.find(client.first);
+      ASSERT_TRUE(iterObject != m_ClientToObject.end());
+      auto iter = m_Objects.find(iterObject->second);
+      ASSERT_TRUE(iter != m_Objects.end());
+      if (client.second.m_Moving)
+      {
+        iter->second.m_Moving = true;
+        iter->second.m_Dir = client.second.m_Dir;
+        iter->second.m_Pos += client.second.m_Dir * iDelta;
+        oToUpdate.insert(iter->first);
+      }
+      else if(iter->second.m_Moving)
+      {
+        iter->second.m_Moving = false;
+        oToUpdate.insert(iter->first);
+      }
+    }
+  }
+};
+
+struct TestClientEvents
+{
+  static void OnNewObject(WorldState& iWorld, Network::ObjectId iObject, Network::ClientData const& iData)
+  {
+    auto insertRes = iWorld.m_Objects.insert(std::make_pair(iObject, iData));
+    ASSERT_TRUE(insertRes.second);
+  }
+
+  static void OnObjectDeleted(WorldState& iWorld, Network::ObjectId iObject)
+  {
+    ASSERT_EQ(iWorld.m_Objects.erase(iObject), 1);
+  }
+
+  static void OnObjectUpdated(WorldState& iWorld, Network::ObjectId iObject, Network::ClientData const& iData)
+  {
+    auto iterObj = iWorld.m_Objects.find(iObject);
+    ASSERT_TRUE(iterObj != iWorld.m_Objects.end());
+    iterObj->second = iData;
+  }
+};
+
+struct TestServerEvents
+{
+  void OnClientConnected(Network::ClientId iClient)
+  {
+    auto handle = m_Objects.Alloc();
+    Network::ObjectId netId{ handle.GetId() };
+    auto insertClientRes = m_World.m_Clients.insert(std::make_pair(iClient, Network::ClientInputData()));
+    ASSERT_TRUE(insertClientRes.second);
+
+    auto insertClientObj = m_World.m_Objects.insert(std::make_pair(netId, Network::ClientData()));
+    ASSERT_TRUE(insertClientObj.second);
+
+    m_World.m_ClientToObject.insert(std::make_pair(iClient, netId));
+
+    m_NewObjects.insert(netId);
+    m_NewClient.insert(iClient);
+  }
+
+  void OnClientDisconnected(Network::ClientId iClient)
+  {
+
+  }
+
+  void OnClientCommand(Network::ClientId iClient, Network::ClientInputData const& iData)
+  {
+    auto clientData = m_World.m_Clients.find(iClient);
+    ASSERT_TRUE(clientData != m_World.m_Clients.end());
+    clientData->second = iData;
+  }
+
+  void TickAuth(float iDelta)
+  {
+    m_World.TickAuth(iDelta, m_ToUpdate);
+  }
+
+  void FlushAuth(Network::Server& iServer)
+  {
+    for (auto const& newObj : m_NewObjects)
+    {
+      for (auto const& client : m_World.m_Clients)
+      {
+        if (m_NewClient.count(client.first) != 0)
+        {
+          continue;
+        }
+        iServer.CreateObject(client.first, newObj, m_World.m_Objects[newObj]);
+      }
+    }
+    m_NewObjects.clear();
+
+    for (Network::ClientId newClient : m_NewClient)
+    {
+      for (auto const& object : m_World.m_Objects)
+      {
+        iServer.CreateObject(newClient, object.first, object.second);
+      }
+    }
+    m_NewClient.clear();
+
+    for (Network::ObjectId object : m_ToUpdate)
+    {
+      for (auto const& client : m_World.m_Clients)
+      {
+        iServer.UpdateObject(client.first, object, m_World.m_Objects[object]);
+      }
+    }
+    m_ToUpdate.clear();
+  }
+
+  ObjectTable<int> m_Objects;
+  UnorderedSet<Network::ObjectId> m_NewObjects;
+  UnorderedSet<Network::ClientId> m_NewClient;
+  UnorderedSet<Network::ObjectId> m_ToUpdate;
+  WorldState m_World;
+};
+
+struct NetworkSim
+{
+  Network::NetCtx ctx;
+  Network::TestNetDriver driver;
+  Vector<uint8_t> key;
+  Clock timer;
+
+  NetworkSim()
+    : driver(ctx)
+  {
+    key.resize(Network::Server::s_PrivateKeySize, 0);
+  }
+
+  void Tick(float iTimeout, std::function<bool()> iWaitCondition = [] { return false; })
+  {
+    float elapsedTime = 0.0;
+    float lastDelta = 0.0;
+    while (elapsedTime < iTimeout)
+    {
+      lastDelta = timer.GetTime();
+      elapsedTime += lastDelta;
+      Step();
+
+      if (iWaitCondition && iWaitCondition())
+      {
+        break;
+      }
+    }
+  }
+
+  void Step()
+  {
+    if (ctx.m_Server)
+    {
+      ctx.m_Server->Tick();
+      ctx.m_Server->Flush();
+    }
+
+    for (auto const& client : ctx.m_Clients)
+    {
+      client->Tick();
+      client->Flush();
+    }
+  }
+};
+
+// Objects circling around their anchor, within the full rate radius of the client's object.
+struct ReplicationScene
+{
+  ReplicationScene(uint32_t iNumObjects)
+  {
+    net.ctx.m_ClientEvents.OnNewObject = [this](uint32_t, Network::ObjectId iObject, Network::ClientData const& iData)
+    {
+      TestClientEvents::OnNewObject(clientWorld, iObject, iData);
+    };
+    net.ctx.m_ClientEvents.OnObjectUpdated = [this](uint32_t, Network::ObjectId iObject, Network::ClientData const& iData)
+    {
+      TestClientEvents::OnObjectUpdated(clientWorld, iObject, iData);
+    };
+    net.ctx.m_ClientEvents.OnObjectDeleted = [this](uint32_t, Network::ObjectId iObject)
+    {
+      TestClientEvents::OnObjectDeleted(clientWorld, iObject);
+    };
+
+    Network::Server::Start(net.ctx, "127.0.0.1", net.key);
+    dispatcher = &net.ctx.m_Server->GetDispatcher();
+
+    net.ctx.m_ServerEvents.OnClientConnected = [this](Network::ClientId iClient)
+    {
+      dispatcher->CreateObject(playerObj, Network::ClientData());
+      dispatcher->AddClient(iClient, playerObj);
+    };
+
+    float const maxDist = dispatcher->GetInterestParams().m_FullRateRadius - 4.0;
+    for (uint32_t i = 0; i < iNumObjects; ++i)
+    {
+      Network::ObjectId object{ 2 + i };
+      Vec3 anchor(maxDist * ((i * 37) % 100) / 100.0, maxDist * ((i * 61) % 100) / 100.0, 0.0);
+      anchor *= 0.7;
+      m_Objects.push_back(object);
+      m_Anchors.push_back(anchor);
+      Network::ClientData& data = serverWorld.m_Objects[object];
+      data.m_Pos = anchor;
+      data.m_Dir = Zero<Vec3>();
+      dispatcher->CreateObject(object, serverWorld.m_Objects[object]);
+    }
+
+    Network::Client::ConnectLoopback(net.ctx, "1");
+    net.Tick(1.0, [&] { return clientWorld.m_Objects.size() == iNumObjects + 1; });
+  }
+
+  void Move(uint32_t iStep, float iMovingRatio)
+  {
+    uint32_t const numMoving = m_Objects.size() * iMovingRatio;
+    for (uint32_t i = 0; i < m_Objects.size(); ++i)
+    {
+      Network::ClientData& data = serverWorld.m_Objects[m_Objects[i]];
+      if (i < numMoving)
+      {
+        float const angle = (iStep + i) * 0.05;
+        data.m_Moving = true;
+        data.m_Pos = m_Anchors[i] + Vec3(Mathf::Cos(angle), Mathf::Sin(angle), 0.0) * 2.0f;
+        data.m_Dir = Vec3(-Mathf::Sin(angle), Mathf::Cos(angle), 0.0);
+      }
+      // Static objects are updated as well, the delta encoding skips them.
+      dispatcher->UpdateObject(m_Objects[i], data);
+    }
+  }
+
+  // Moves every object and the player, keeping their relative positions.
+  void Translate(Vec3 const& iOffset)
+  {
+    Network::ClientData playerData;
+    playerData.m_Pos = iOffset;
+    dispatcher->UpdateObject(playerObj, playerData);
+    for (uint32_t i = 0; i < m_Objects.size(); ++i)
+    {
+      m_Anchors[i] += iOffset;
+      Network::ClientData& data = serverWorld.m_Objects[m_Objects[i]];
+      data.m_Pos += iOffset;
+      dispatcher->UpdateObject(m_Objects[i], data);
+    }
+  }
+
+  bool IsSynchronized() const
+  {
+    float const posTolerance = 1.0 / 64;
+    float const dirTolerance = 1.0 / 256;
+    for (auto const& object : serverWorld.m_Objects)
+    {
+      auto iter = clientWorld.m_Objects.find(object.first);
+      if (iter == clientWorld.m_Objects.end()
+        || iter->second.m_Moving != object.second.m_Moving
+        || length(iter->second.m_Pos - object.second.m_Pos) > posTolerance
+        || length(iter->second.m_Dir - object.second.m_Dir) > dirTolerance)
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  NetworkSim net;
+  Network::ServerDispatcher* dispatcher;
+  WorldState serverWorld;
+  WorldState clientWorld;
+  Network::ObjectId const playerObj{ 1 };
+  Vector<Network::ObjectId> m_Objects;
+  Vector<Vec3> m_Anchors;
+};
@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+
+#include <engine/common/world.hpp>
+#include <engine/common/gamedata.hpp>
+
+#include <core/thread/jobsystem.hpp>
+
+#include <atomic>
+
+#include "querytest.hpp"
+
+using namespace eXl;
+
+TEST(Query, MatchesPerObjectLookup)
+{
+  QueryScene scene(5000);
+
+  uint32_t numMatches = 0;
+  Query<Position, Velocity const, Health const> query(scene.m_Positions.GetView(), scene.m_Velocities.GetView(), scene.m_Health.GetView());
+  query.Iterate([&](ObjectHandle iObj, Position& iPos, Velocity const& iVel, Health const& iHealth)
+  {
+    EXPECT_EQ(&iPos, scene.m_Positions.Get(iObj));
+    EXPECT_EQ(iVel.m_DY, iPos.m_X);
+    EXPECT_EQ(iHealth.m_Value, iPos.m_X);
+    iPos.m_Y += iVel.m_DX;
+    ++numMatches;
+  });
+
+  uint32_t expectedMatches = 0;
+  for (ObjectHandle obj : scene.m_Objects)
+  {
+    if (!scene.m_World.IsObjectValid(obj))
+    {
+      continue;
+    }
+    bool const match = scene.m_Velocities.Get(obj) != nullptr && scene.m_Health.Get(obj) != nullptr;
+    expectedMatches += match ? 1 : 0;
+    EXPECT_EQ(scene.m_Positions.Get(obj)->m_Y, match ? 1 : 0);
+  }
+  EXPECT_GT(expectedMatches, 0);
+  EXPECT_EQ(numMatches, expectedMatches);
+}
+
+TEST(Query, ParallelIterate)
+{
+  QueryScene scene(20000);
+  JobSystem jobs(4);
+
+  std::atomic<uint32_t> numMatches(0);
+  Query<Position, Velocity const> query(scene.m_Positions.GetView(), scene.m_Velocities.GetView());
+  query.ParallelIterate(&jobs, 256, [&](ObjectHandle, Position& iPos, Velocity const& iVel)
+  {
+    iPos.m_Y += iVel.m_DX;
+    ++numMatches;
+  });
+
+  uint32_t expectedMatches = 0;
+  for (ObjectHandle obj : scene.m_Objects)
+  {
+    if (scene.m_World.IsObjectValid(obj))
+    {
+      bool const match = scene.m_Velocities.Get(obj) != nullptr;
+      expectedMatches += match ? 1 : 0;
+      EXPECT_EQ(scene.m_Positions.Get(obj)->m_Y, match ? 1 : 0);
+    }
+  }
+  EXPECT_EQ(numMatches.load(), expectedMatches);
+}
+
+TEST(Query, ReusedIdsBeforeGarbageCollection)
+{
+  QueryScene scene(1000);
+
+  // Deleted objects give their ids back while their data still waits for garbage collection.
+  Vector<ObjectHandle> newObjects;
+  for (uint32_t i = 0; i < 1000; i += 7)
+  {
+    ObjectHandle obj = scene.m_World.CreateObject();
+    newObjects.push_back(obj);
+    scene.m_Positions.GetOrCreate(obj).m_X = -1;
+    scene.m_Health.GetOrCreate(obj).m_Value = -1;
+  }
+
+  auto checkObjects = [&]
+  {
+    for (ObjectHandle obj : newObjects)
+    {
+      ASSERT_NE(scene.m_Positions.Get(obj), nullptr);
+      ASSERT_NE(scene.m_Health.Get(obj), nullptr);
+      EXPECT_EQ(scene.m_Positions.Get(obj)->m_X, -1);
+      EXPECT_EQ(scene.m_Health.Get(obj)->m_Value, -1);
+    }
+
+    uint32_t numNew = 0;
+    Query<Position const, Health const> query(scene.m_Positions.GetView(), scene.m_Health.GetView());
+    query.Iterate([&](ObjectHandle, Position const& iPos, Health const& iHealth)
+    {
+      EXPECT_EQ(iHealth.m_Value, iPos.m_X);
+      numNew += iPos.m_X == -1 ? 1 : 0;
+    });
+    EXPECT_EQ(numNew, newObjects.size());
+  };
+
+  checkObjects();
+  scene.m_Positions.GarbageCollect();
+  scene.m_Health.GarbageCollect();
+  checkObjects();
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <engine/common/world.hpp>
+#include <engine/common/gamedata.hpp>
+
+#include <core/random.hpp>
+
+namespace eXl
+{
+  struct Position
+  {
+    int32_t m_X = 0;
+    int32_t m_Y = 0;
+  };
+
+  struct Velocity
+  {
+    int32_t m_DX = 0;
+    int32_t m_DY = 0;
+  };
+
+  struct Health
+  {
+    int32_t m_Value = 0;
+  };
+
+  struct QueryScene
+  {
+    // Positions on every object, velocities on half of them, health on a third.
+    QueryScene(uint32_t iNumObjects)
+      : m_World(m_Dummy)
+      , m_Positions(m_World)
+      , m_Velocities(m_World)
+      , m_Health(m_World)
+    {
+      UniquePtr<Random> rand(Random::CreateDefaultRNG(0));
+      for (uint32_t i = 0; i < iNumObjects; ++i)
+      {
+        ObjectHandle obj = m_World.CreateObject();
+        m_Objects.push_back(obj);
+        m_Positions.GetOrCreate(obj).m_X = i;
+        if (rand->Generate() % 2 == 0)
+        {
+          Velocity& vel = m_Velocities.GetOrCreate(obj);
+          vel.m_DX = 1;
+          vel.m_DY = i;
+        }
+        if (rand->Generate() % 3 == 0)
+        {
+          m_Health.GetOrCreate(obj).m_Value = i;
+        }
+      }
+      // Leaves holes in the slots.
+      for (uint32_t i = 0; i < iNumObjects; i += 7)
+      {
+        m_World.DeleteObject(m_Objects[i]);
+      }
+    }
+
+    ComponentManifest m_Dummy;
+    World m_World;
+    DenseGameDataStorage<Position> m_Positions;
+    DenseGameDataStorage<Velocity> m_Velocities;
+    SparseGameDataStorage<Health> m_Health;
+    Vector<ObjectHandle> m_Objects;
+  };
+}
@@ -0,0 +1,426 @@
+#include <gtest/gtest.h>
+
+#include <engine/gfx/gfxsystem.hpp>
+#include <engine/gfx/gfxcomponent.hpp>
+#include <engine/gfx/gfxspatialindex.hpp>
+#include <engine/common/transforms.hpp>
+#include <engine/common/gamedatabase.hpp>
+#include <engine/game/commondef.hpp>
+
+#include <ogl/renderer/oglrecordingcontext.hpp>
+#include <ogl/renderer/ogldisplaylist.hpp>
+#include <ogl/renderer/oglcompiledprogram.hpp>
+#include <ogl/renderer/oglshaderdata.hpp>
+#include <ogl/renderer/oglbuffer.hpp>
+#include <ogl/renderer/ogltextureloader.hpp>
+#include <ogl/oglspritealgo.hpp>
+
+#include <core/thread/jobsystem.hpp>
+#include <core/random.hpp>
+
+#include <algorithm>
+
+#include "rendertest.hpp"
+
+using namespace eXl;
+
+namespace
+{
+  void ExpectSameCommands(OGLRecordingContext const& iExpected, OGLRecordingContext const& iActual)
+  {
+    auto const& expectedCmds = iExpected.GetCommands();
+    auto const& actualCmds = iActual.GetCommands();
+    ASSERT_EQ(expectedCmds.size(), actualCmds.size());
+    for (uint32_t i = 0; i < expectedCmds.size(); ++i)
+    {
+      ASSERT_EQ(expectedCmds[i].m_Op, actualCmds[i].m_Op) << "Command " << i;
+      ASSERT_EQ(expectedCmds[i].m_Slot, actualCmds[i].m_Slot) << "Command " << i;
+      ASSERT_EQ(expectedCmds[i].m_Object, actualCmds[i].m_Object) << "Command " << i;
+      ASSERT_EQ(expectedCmds[i].m_Count, actualCmds[i].m_Count) << "Command " << i;
+      ASSERT_EQ(expectedCmds[i].m_Instances, actualCmds[i].m_Instances) << "Command " << i;
+    }
+  }
+}
+
+TEST(GfxRender, RecordingContextCountsFrame)
+{
+  RenderScene scene(2000);
+  SyntheticSceneNode const& node = *scene.m_Node;
+
+  OGLRecordingContext recorder;
+  scene.m_Gfx->RenderFrame(0.0, recorder);
+  OGLRecordingContext::Stats const& stats = recorder.GetStats();
+
+  EXPECT_EQ(stats.m_Clears, 1u);
+  EXPECT_EQ(stats.m_Draws, node.GetNumDraws());
+  EXPECT_EQ(recorder.GetNumDraws(), node.GetNumDraws());
+  EXPECT_EQ(stats.m_Instances, node.GetNumTiles());
+  EXPECT_EQ(stats.m_Vertices, 6 * uint64_t(node.GetNumSprites() + node.GetNumTiles() + SyntheticSceneNode::s_NumPanels));
+  // Keys are sorted by layer first, so each program is bound once.
+  EXPECT_EQ(stats.m_Programs, 3u);
+  EXPECT_GE(stats.m_StateChanges, SyntheticSceneNode::s_NumPanels);
+  EXPECT_LE(stats.m_Textures, node.GetNumDraws());
+
+  uint32_t numDrawCmds = 0;
+  bool programSet = false;
+  for (auto const& cmd : recorder.GetCommands())
+  {
+    switch (cmd.m_Op)
+    {
+    case OGLRecordingContext::Op::SetProgram:
+      programSet = cmd.m_Object != nullptr;
+      break;
+    case OGLRecordingContext::Op::Draw:
+    case OGLRecordingContext::Op::DrawIndexed:
+    case OGLRecordingContext::Op::DrawInstanced:
+    case OGLRecordingContext::Op::DrawIndexedInstanced:
+      EXPECT_TRUE(programSet);
+      ++numDrawCmds;
+      break;
+    default:
+      break;
+    }
+  }
+  EXPECT_EQ(numDrawCmds, stats.m_Draws);
+  ASSERT_FALSE(recorder.GetCommands().empty());
+  EXPECT_EQ(recorder.GetCommands().back().m_Op, OGLRecordingContext::Op::Clear);
+
+  // Counting alone sees the same frame.
+  OGLRecordingContext counter(false);
+  scene.m_Gfx->RenderFrame(0.0, counter);
+  EXPECT_TRUE(counter.GetCommands().empty());
+  EXPECT_EQ(counter.GetStats().m_Draws, stats.m_Draws);
+  EXPECT_EQ(counter.GetStats().m_Textures, stats.m_Textures);
+  EXPECT_EQ(counter.GetStats().m_Uniforms, stats.m_Uniforms);
+  EXPECT_EQ(counter.GetStats().m_StateChanges, stats.m_StateChanges);
+}
+
+TEST(GfxRender, ParallelPushMatchesSerial)
+{
+  JobSystem jobs(4);
+  RenderScene scene(8000, 4);
+
+  // Frames after the first reuse the display lists.
+  for (uint32_t frame = 0; frame < 2; ++frame)
+  {
+    OGLRecordingContext serial;
+    scene.m_World.SetJobSystem(nullptr);
+    scene.m_Gfx->RenderFrame(0.0, serial);
+
+    OGLRecordingContext parallel;
+    scene.m_World.SetJobSystem(&jobs);
+    scene.m_Gfx->RenderFrame(0.0, parallel);
+
+    EXPECT_EQ(parallel.GetStats().m_Draws, 4 * scene.m_Node->GetNumDraws());
+    EXPECT_EQ(parallel.GetStats().m_Programs, serial.GetStats().m_Programs);
+    EXPECT_EQ(parallel.GetStats().m_StateChanges, serial.GetStats().m_StateChanges);
+    EXPECT_EQ(parallel.GetStats().m_Textures, serial.GetStats().m_Textures);
+    EXPECT_EQ(parallel.GetStats().m_Uniforms, serial.GetStats().m_Uniforms);
+
+    ExpectSameCommands(serial, parallel);
+  }
+}
+
+TEST(GfxRender, ParallelComponentPushMatchesSerial)
+{
+  JobSystem jobs(4);
+  RenderScene scene(0);
+  GfxSystem::ViewInfo view;
+  view.viewportSize = Vec2i(1280, 720);
+  view.projection = GfxSystem::Orthographic;
+  view.displayedSize = 720;
+  view.pos = Vec3(0, 0, 50);
+  scene.m_Gfx->SetView(view);
+
+  QuadComponents quads(scene);
+  // Enough components in view for several sub-lists, and a last partial one.
+  uint32_t const numComps = 2000;
+  for (uint32_t i = 0; i < numComps; ++i)
+  {
+    quads.Add(Vec2(float(i % 50) * 10 - 250, float(i / 50) * 10 - 200));
+  }
+
+  for (bool culling : {true, false})
+  {
+    scene.m_Gfx->SetViewCulling(culling);
+    for (uint32_t frame = 0; frame < 2; ++frame)
+    {
+      OGLRecordingContext serial;
+      scene.m_World.SetJobSystem(nullptr);
+      scene.m_Gfx->RenderFrame(0.0, serial);
+
+      OGLRecordingContext parallel;
+      scene.m_World.SetJobSystem(&jobs);
+      scene.m_Gfx->RenderFrame(0.0, parallel);
+
+      EXPECT_EQ(parallel.GetStats().m_Draws, scene.m_Node->GetNumDraws() + numComps);
+      ExpectSameCommands(serial, parallel);
+    }
+  }
+}
+
+TEST(GfxRender, SpatialIndexMatchesBruteForce)
+{
+  World world(EngineCommon::GetComponents());
+  UniquePtr<Random> rand(Random::CreateDefaultRNG(0));
+  GfxSpatialIndex index(4.0);
+
+  auto randomBox = [&]()
+  {
+    // Mostly small boxes, a few large enough to go up several levels.
+    float const size = rand->Generate() % 10 == 0 ? float(rand->Generate() % 200) : float(rand->Generate() % 8);
+    Vec2 const center(float(rand->Generate() % 1000) - 500, float(rand->Generate() % 1000) - 500);
+    return AABB2Df::FromCenterAndSize(center, Vec2(size, size * 0.5));
+  };
+
+  Vector<ObjectHandle> objects;
+  Vector<AABB2Df> boxes;
+  for (uint32_t i = 0; i < 2000; ++i)
+  {
+    objects.push_back(world.CreateObject());
+    boxes.push_back(randomBox());
+    index.Update(objects.back(), boxes.back());
+  }
+  // Move some, and remove others.
+  for (uint32_t i = 0; i < 500; ++i)
+  {
+    uint32_t const objIdx = rand->Generate() % objects.size();
+    boxes[objIdx] = randomBox();
+    index.Update(objects[objIdx], boxes[objIdx]);
+  }
+  for (uint32_t i = 0; i < 200; ++i)
+  {
+    uint32_t const objIdx = rand->Generate() % objects.size();
+    index.Remove(objects[objIdx]);
+    objects.erase(objects.begin() + objIdx);
+    boxes.erase(boxes.begin() + objIdx);
+  }
+  EXPECT_EQ(index.GetNumObjects(), objects.size());
+
+  for (uint32_t query = 0; query < 100; ++query)
+  {
+    AABB2Df const queryBox = query == 0
+      ? AABB2Df(-1.0e6, -1.0e6, 1.0e6, 1.0e6)
+      : AABB2Df::FromCenterAndSize(Vec2(float(rand->Generate() % 1000) - 500, float(rand->Generate() % 1000) - 500), Vec2(float(rand->Generate() % 300), float(rand->Generate() % 300)));
+
+    Vector<ObjectHandle> found;
+    index.Query(queryBox, found);
+    std::sort(found.begin(), found.end(), [](ObjectHandle iA, ObjectHandle iB) { return iA.GetId() < iB.GetId(); });
+
+    Vector<ObjectHandle> expected;
+    for (uint32_t i = 0; i < objects.size(); ++i)
+    {
+      if (boxes[i].MinX() <= queryBox.MaxX() && boxes[i].MaxX() >= queryBox.MinX()
+        && boxes[i].MinY() <= queryBox.MaxY() && boxes[i].MaxY() >= queryBox.MinY())
+      {
+        expected.push_back(objects[i]);
+      }
+    }
+    std::sort(expected.begin(), expected.end(), [](ObjectHandle iA, ObjectHandle iB) { return iA.GetId() < iB.GetId(); });
+    ASSERT_EQ(found, expected) << "Query " << query;
+  }
+}
+
+TEST(GfxRender, SpatialIndexFindsOversizedBoxes)
+{
+  World world(EngineCommon::GetComponents());
+  GfxSpatialIndex index(4.0);
+  float const topCellSize = 4.0 * float(1 << (GfxSpatialIndex::s_NumLevels - 1));
+
+  // Larger than the top level cells, around a center far from the queries.
+  ObjectHandle const road = world.CreateObject();
+  index.Update(road, AABB2Df::FromCenterAndSize(Vec2(topCellSize * 6, 0), Vec2(topCellSize * 7, 2)));
+  ObjectHandle const small = world.CreateObject();
+  index.Update(small, AABB2Df::FromCenterAndSize(Vec2(topCellSize * 3, 0), Vec2(1, 1)));
+
+  Vec2 const queryPt(topCellSize * 3, 0);
+  Vector<ObjectHandle> found;
+  index.Query(AABB2Df::FromCenterAndSize(queryPt, Vec2(4, 4)), found);
+  EXPECT_EQ(found.size(), 2u);
+  EXPECT_NE(std::find(found.begin(), found.end(), road), found.end());
+
+  found.clear();
+  GfxViewFrustum const frustum(ortho(-10.0f, 10.0f, -10.0f, 10.0f, 1.0f, 100.0f)
+    * lookAt(Vec3(queryPt, 50), Vec3(queryPt, 0), UnitY<Vec3>()));
+  index.Query(frustum, found);
+  EXPECT_EQ(found.size(), 2u);
+  EXPECT_NE(std::find(found.begin(), found.end(), road), found.end());
+
+  Vector<std::pair<float, ObjectHandle>> hits;
+  index.Raycast(Vec3(queryPt + Vec2(3, 0), 10), -UnitZ<Vec3>(), hits);
+  ASSERT_EQ(hits.size(), 1u);
+  EXPECT_EQ(hits[0].second, road);
+}
+
+TEST(GfxRender, FrustumQueryKeepsRaisedBounds)
+{
+  World world(EngineCommon::GetComponents());
+  UniquePtr<Random> rand(Random::CreateDefaultRNG(0));
+  GfxSpatialIndex index(4.0);
+
+  // Looking down at the origin, the ground closer than y = -40 is below the view.
+  GfxViewFrustum const frustum(perspective(Mathf::Pi() / 3, 16.0f / 9.0f, 1.0f, 500.0f)
+    * lookAt(Vec3(0, -60, 30), Zero<Vec3>(), UnitZ<Vec3>()));
+
+  ObjectHandle const raised = world.CreateObject();
+  index.Update(raised, GfxBounds{ Vec3(-1, -46, 19), Vec3(1, -44, 21) });
+  ObjectHandle const grounded = world.CreateObject();
+  index.Update(grounded, GfxBounds{ Vec3(-1, -46, 0), Vec3(1, -44, 0) });
+
+  Vector<ObjectHandle> found;
+  index.Query(frustum, found);
+  EXPECT_NE(std::find(found.begin(), found.end(), raised), found.end());
+  EXPECT_EQ(std::find(found.begin(), found.end(), grounded), found.end());
+
+  Vector<ObjectHandle> objects = { raised, grounded };
+  Vector<GfxBounds> bounds = { GfxBounds{ Vec3(-1, -46, 19), Vec3(1, -44, 21) }, GfxBounds{ Vec3(-1, -46, 0), Vec3(1, -44, 0) } };
+  for (uint32_t i = 0; i < 2000; ++i)
+  {
+    Vec3 const center(float(rand->Generate() % 400) - 200, float(rand->Generate() % 400) - 100, float(rand->Generate() % 40));
+    Vec3 const size(float(rand->Generate() % 8), float(rand->Generate() % 8), float(rand->Generate() % 4));
+    objects.push_back(world.CreateObject());
+    bounds.push_back(GfxBounds{ center - size * 0.5f, center + size * 0.5f });
+    index.Update(objects.back(), bounds.back());
+  }
+
+  found.clear();
+  index.Query(frustum, found);
+  std::sort(found.begin(), found.end(), [](ObjectHandle iA, ObjectHandle iB) { return iA.GetId() < iB.GetId(); });
+
+  // The grid only narrows down the candidates.
+  Vector<ObjectHandle> expected;
+  for (uint32_t i = 0; i < objects.size(); ++i)
+  {
+    if (frustum.Intersects(bounds[i]))
+    {
+      expected.push_back(objects[i]);
+    }
+  }
+  std::sort(expected.begin(), expected.end(), [](ObjectHandle iA, ObjectHandle iB) { return iA.GetId() < iB.GetId(); });
+  EXPECT_FALSE(expected.empty());
+  EXPECT_EQ(found, expected);
+}
+
+TEST(GfxRender, CullsComponentsOutOfView)
+{
+  RenderScene scene(0);
+  GfxSystem& gfx = *scene.m_Gfx;
+  OGLRecordingContext recorder(false);
+  // Initializes the render nodes, and counts what the synthetic node draws on its own.
+  gfx.RenderFrame(0.0, recorder);
+  uint32_t const baseDraws = recorder.GetStats().m_Draws;
+
+  // 720 units tall, 1280 wide, around (200, 200).
+  GfxSystem::ViewInfo view;
+  view.viewportSize = Vec2i(1280, 720);
+  view.projection = GfxSystem::Orthographic;
+  view.displayedSize = 720;
+  view.pos = Vec3(200, 200, 50);
+  gfx.SetView(view);
+  ASSERT_NE(gfx.GetCullingFrustum(), nullptr);
+
+  QuadComponents quads(scene);
+  uint32_t const gridSide = 100;
+  float const spacing = 20;
+  uint32_t numVisible = 0;
+  ObjectHandle centerObject;
+  for (uint32_t i = 0; i < gridSide * gridSide; ++i)
+  {
+    Vec2 const pos(float(i % gridSide) * spacing, float(i / gridSide) * spacing);
+    ObjectHandle object = quads.Add(pos);
+
+    numVisible += Mathf::Abs(pos.x - 200) <= 640.5 && Mathf::Abs(pos.y - 200) <= 360.5 ? 1 : 0;
+    centerObject = pos == Vec2(200, 200) ? object : centerObject;
+  }
+  ASSERT_TRUE(centerObject.IsAssigned());
+
+  recorder.Reset();
+  gfx.RenderFrame(0.0, recorder);
+  EXPECT_EQ(recorder.GetStats().m_Draws, baseDraws + numVisible);
+
+  gfx.SetViewCulling(false);
+  recorder.Reset();
+  gfx.RenderFrame(0.0, recorder);
+  EXPECT_EQ(recorder.GetStats().m_Draws, baseDraws + gridSide * gridSide);
+  gfx.SetViewCulling(true);
+
+  Vector<ObjectHandle> picked;
+  gfx.PickObjects(Vec2i(640, 360), picked);
+  ASSERT_EQ(picked.size(), 1u);
+  EXPECT_EQ(picked[0], centerObject);
+
+  // Moving through the transforms updates the index.
+  scene.m_Transforms->UpdateTransform(centerObject, translate(Identity<Mat4>(), Vec3(-5000, 0, 0)));
+  gfx.SynchronizeTransforms();
+  picked.clear();
+  gfx.PickObjects(Vec2i(640, 360), picked);
+  EXPECT_TRUE(picked.empty());
+
+  recorder.Reset();
+  gfx.RenderFrame(0.0, recorder);
+  EXPECT_EQ(recorder.GetStats().m_Draws, baseDraws + numVisible - 1);
+}
+
+TEST(GfxRender, StaticComponentsAreRetained)
+{
+  RenderScene scene(0);
+  GfxSystem& gfx = *scene.m_Gfx;
+  gfx.SetViewCulling(false);
+  {
+    // Initializes the render nodes.
+    OGLRecordingContext counter(false);
+    gfx.RenderFrame(0.0, counter);
+  }
+
+  QuadComponents quads(scene);
+  Vector<ObjectHandle> objects;
+  for (uint32_t i = 0; i < 500; ++i)
+  {
+    objects.push_back(quads.Add(Vec2(float(i % 25), float(i / 25))));
+  }
+  auto setStatic = [&](bool iStatic)
+  {
+    for (ObjectHandle object : objects)
+    {
+      gfx.GetComponent(object)->SetStatic(iStatic);
+    }
+  };
+
+  OGLRecordingContext dynamicFrame;
+  gfx.RenderFrame(0.0, dynamicFrame);
+
+  setStatic(true);
+  OGLRecordingContext recordedFrame;
+  gfx.RenderFrame(0.0, recordedFrame);
+  OGLRecordingContext retainedFrame;
+  gfx.RenderFrame(0.0, retainedFrame);
+  ExpectSameCommands(dynamicFrame, recordedFrame);
+  ExpectSameCommands(dynamicFrame, retainedFrame);
+
+  // Changing the draws of a static component records the segment again.
+  uint32_t const numDraws = retainedFrame.GetStats().m_Draws;
+  gfx.GetComponent(objects[0])->AddDraw(quads.m_Material.get()).NumElements(6).Layer(1).End();
+  OGLRecordingContext counter(false);
+  gfx.RenderFrame(0.0, counter);
+  EXPECT_EQ(counter.GetStats().m_Draws, numDraws + 1);
+
+  gfx.GetComponent(objects[1])->ClearDraws();
+  gfx.GetComponent(objects[2])->ClearDraws();
+  counter.Reset();
+  gfx.RenderFrame(0.0, counter);
+  EXPECT_EQ(counter.GetStats().m_Draws, numDraws - 1);
+
+  // So does changing the viewport the segment inherited its states from.
+  GfxSystem::ViewInfo view;
+  view.viewportSize = Vec2i(640, 480);
+  view.projection = GfxSystem::Orthographic;
+  view.displayedSize = 480;
+  gfx.SetView(view);
+  OGLRecordingContext resizedFrame;
+  gfx.RenderFrame(0.0, resizedFrame);
+
+  setStatic(false);
+  OGLRecordingContext resizedDynamicFrame;
+  gfx.RenderFrame(0.0, resizedDynamicFrame);
+  ExpectSameCommands(resizedDynamicFrame, resizedFrame);
+}
@@ -0,0 +1,267 @@
+#pragma once
+
+#include <engine/gfx/gfxsystem.hpp>
+#include <engine/gfx/gfxcomponent.hpp>
+#include <engine/common/transforms.hpp>
+#include <engine/common/gamedatabase.hpp>
+#include <engine/game/commondef.hpp>
+
+#include <ogl/renderer/oglrecordingcontext.hpp>
+#include <ogl/renderer/ogldisplaylist.hpp>
+#include <ogl/renderer/oglcompiledprogram.hpp>
+#include <ogl/renderer/oglshaderdata.hpp>
+#include <ogl/renderer/oglbuffer.hpp>
+#include <ogl/renderer/ogltextureloader.hpp>
+#include <ogl/oglspritealgo.hpp>
+
+#include <core/random.hpp>
+
+namespace eXl
+{
+  // Stands in for the sprite, tilemap and GUI nodes, with the same programs and draw patterns,
+  // without needing tileset resources on disk.
+  class SyntheticSceneNode : public GfxRenderNode
+  {
+  public:
+    static constexpr uint32_t s_NumLayers = 4;
+    static constexpr uint32_t s_NumTextures = 8;
+    static constexpr uint32_t s_NumTileLayers = 2;
+    static constexpr uint32_t s_TileLayerSide = 64;
+    static constexpr uint32_t s_NumPanels = 16;
+
+    SyntheticSceneNode(uint32_t iNumSprites, bool iParallel = false)
+      : m_NumSprites(iNumSprites)
+      , m_Parallel(iParallel)
+    {}
+
+    uint32_t GetNumSprites() const { return m_NumSprites; }
+    uint32_t GetNumTiles() const { return s_NumTileLayers * s_TileLayerSide * s_TileLayerSide; }
+    uint32_t GetNumDraws() const { return m_NumSprites + s_NumTileLayers + s_NumPanels; }
+
+    bool CanPushInParallel() const override { return m_Parallel; }
+
+  protected:
+    struct Sprite
+    {
+      Mat4 m_Transform;
+      SpriteColor m_Color;
+      uint32_t m_Texture;
+      uint16_t m_Layer;
+    };
+
+    void Init(GfxSystem& iSys, GfxRenderNodeHandle iHandle) override
+    {
+      GfxRenderNode::Init(iSys, iHandle);
+      OGLSemanticManager& semantics = iSys.GetSemanticManager();
+      OGLSpriteAlgo::Init(semantics);
+      m_SpriteProgram.reset(OGLSpriteAlgo::CreateSpriteProgram(semantics));
+      m_InstancedProgram.reset(OGLSpriteAlgo::CreateInstancedSpriteProgram(semantics));
+      m_FontProgram.reset(OGLSpriteAlgo::CreateFontProgram(semantics));
+
+      float const quad[] =
+      {
+        -0.5, -0.5, 0.0, 0.0, 1.0,
+         0.5, -0.5, 0.0, 1.0, 1.0,
+        -0.5,  0.5, 0.0, 0.0, 0.0,
+         0.5,  0.5, 0.0, 1.0, 0.0,
+      };
+      uint32_t const indices[] = {0, 1, 2, 2, 1, 3};
+      m_Quad = OGLBuffer::CreateBuffer(OGLBufferUsage::ARRAY_BUFFER, sizeof(quad), (void*)quad);
+      m_QuadIdx = OGLBuffer::CreateBuffer(OGLBufferUsage::ELEMENT_ARRAY_BUFFER, sizeof(indices), (void*)indices);
+
+      m_QuadAssembly.AddAttrib(m_Quad, OGLBaseAlgo::GetPosAttrib(), 3, 5 * sizeof(float), 0);
+      m_QuadAssembly.AddAttrib(m_Quad, OGLBaseAlgo::GetTexCoordAttrib(), 2, 5 * sizeof(float), 3 * sizeof(float));
+      m_QuadAssembly.m_IBuffer = m_QuadIdx;
+      m_QuadAssembly.m_IOffset = 0;
+
+      m_TextureData.resize(s_NumTextures);
+      for (uint32_t i = 0; i < s_NumTextures; ++i)
+      {
+        m_Textures.push_back(IntrusivePtr<OGLTexture>(OGLTextureLoader::Create(Image::Size(256, 256), OGLTextureLoader::RGBA8)));
+        m_TextureData[i].AddTexture(OGLSpriteAlgo::GetUnfilteredTexture(), m_Textures.back());
+      }
+
+      UniquePtr<Random> rand(Random::CreateDefaultRNG(0));
+      m_Sprites.resize(m_NumSprites);
+      m_SpriteData.resize(m_NumSprites);
+      for (uint32_t i = 0; i < m_NumSprites; ++i)
+      {
+        Sprite& sprite = m_Sprites[i];
+        sprite.m_Transform = Identity<Mat4>();
+        sprite.m_Transform[3] = Vec4(rand->Generate() % 1000, rand->Generate() % 1000, 0.0, 1.0);
+        sprite.m_Color.tint = One<Vec4>();
+        sprite.m_Texture = rand->Generate() % s_NumTextures;
+        sprite.m_Layer = rand->Generate() % s_NumLayers;
+        m_SpriteData[i].AddData(OGLBaseAlgo::GetWorldMatUniform(), &sprite.m_Transform);
+        m_SpriteData[i].AddData(OGLSpriteAlgo::GetSpriteColorUniform(), &sprite.m_Color);
+      }
+
+      Vector<SpriteInstance> tiles;
+      for (uint32_t layer = 0; layer < s_NumTileLayers; ++layer)
+      {
+        for (uint32_t i = 0; i < s_TileLayerSide * s_TileLayerSide; ++i)
+        {
+          SpriteInstance tile;
+          tile.worldMatrix = Identity<Mat4>();
+          tile.worldMatrix[3] = Vec4(i % s_TileLayerSide, i / s_TileLayerSide, -1.0 * layer, 1.0);
+          tile.tcOffsetScaling = Vec4(0.0, 0.0, 1.0, 1.0);
+          tile.tint = One<Vec4>();
+          tile.alphaMult = 1.0;
+          tiles.push_back(tile);
+        }
+      }
+      m_Tiles = OGLBuffer::CreateBuffer(OGLBufferUsage::ARRAY_BUFFER, tiles.size() * sizeof(SpriteInstance), tiles.data());
+      m_TileAssemblies.resize(s_NumTileLayers);
+      for (uint32_t layer = 0; layer < s_NumTileLayers; ++layer)
+      {
+        m_TileAssemblies[layer] = m_QuadAssembly;
+        OGLSpriteAlgo::AddInstanceAttribs(m_TileAssemblies[layer], m_Tiles.get(), layer * s_TileLayerSide * s_TileLayerSide * sizeof(SpriteInstance));
+      }
+
+      m_Panels.resize(s_NumPanels);
+      m_PanelData.resize(s_NumPanels);
+      for (uint32_t i = 0; i < s_NumPanels; ++i)
+      {
+        m_Panels[i].m_Transform = Identity<Mat4>();
+        m_Panels[i].m_Color.tint = One<Vec4>();
+        m_PanelData[i].AddData(OGLBaseAlgo::GetWorldMatUniform(), &m_Panels[i].m_Transform);
+        m_PanelData[i].AddData(OGLSpriteAlgo::GetSpriteColorUniform(), &m_Panels[i].m_Color);
+        m_PanelData[i].AddTexture(OGLSpriteAlgo::GetUnfilteredTexture(), m_Textures[i % s_NumTextures]);
+      }
+    }
+
+    void Push(OGLDisplayList& iList, float iDelta) override
+    {
+      iList.SetDepth(true, true);
+      iList.SetProgram(m_InstancedProgram.get());
+      for (uint32_t layer = 0; layer < s_NumTileLayers; ++layer)
+      {
+        iList.SetVAssembly(&m_TileAssemblies[layer]);
+        iList.PushData(&m_TextureData[layer]);
+        iList.PushDrawInstanced(0x0080 | layer, OGLDraw::TriangleList, 6, 0, 0, s_TileLayerSide * s_TileLayerSide
+#ifndef __ANDROID__
+          , 0
+#endif
+        );
+        iList.PopData();
+      }
+
+      iList.SetProgram(m_SpriteProgram.get());
+      iList.SetVAssembly(&m_QuadAssembly);
+      for (uint32_t i = 0; i < m_NumSprites; ++i)
+      {
+        iList.PushData(&m_TextureData[m_Sprites[i].m_Texture]);
+        iList.PushData(&m_SpriteData[i]);
+        iList.PushDraw(0x0100 | m_Sprites[i].m_Layer, OGLDraw::TriangleList, 6, 0, 0);
+        iList.PopData();
+        iList.PopData();
+      }
+
+      // Each panel clips its content.
+      iList.SetDepth(false, false);
+      iList.SetProgram(m_FontProgram.get());
+      for (uint32_t i = 0; i < s_NumPanels; ++i)
+      {
+        iList.SetScissor(Vec2i(i * 16, 0), Vec2i(64, 64));
+        iList.PushData(&m_PanelData[i]);
+        iList.PushDraw(0x1000, OGLDraw::TriangleList, 6, 0, 0);
+        iList.PopData();
+      }
+      iList.SetScissor(Vec2i(0, 0), Vec2i(-1, -1));
+    }
+
+    uint32_t m_NumSprites;
+    bool m_Parallel;
+    UniquePtr<OGLCompiledProgram const> m_SpriteProgram;
+    UniquePtr<OGLCompiledProgram const> m_InstancedProgram;
+    UniquePtr<OGLCompiledProgram const> m_FontProgram;
+    IntrusivePtr<OGLBuffer> m_Quad;
+    IntrusivePtr<OGLBuffer> m_QuadIdx;
+    IntrusivePtr<OGLBuffer> m_Tiles;
+    OGLVAssembly m_QuadAssembly;
+    Vector<OGLVAssembly> m_TileAssemblies;
+    Vector<IntrusivePtr<OGLTexture>> m_Textures;
+    Vector<OGLShaderData> m_TextureData;
+    Vector<Sprite> m_Sprites;
+    Vector<OGLShaderData> m_SpriteData;
+    Vector<Sprite> m_Panels;
+    Vector<OGLShaderData> m_PanelData;
+  };
+
+  struct RenderScene
+  {
+    RenderScene(uint32_t iNumSprites, uint32_t iNumNodes = 1)
+      : m_Properties(EngineCommon::GetBaseProperties())
+      , m_World(EngineCommon::GetComponents())
+    {
+      GfxSystem::StaticInit();
+      m_Transforms = m_World.AddSystem(std::make_unique<Transforms>());
+      m_Gfx = m_World.AddSystem(std::make_unique<GfxSystem>(*m_Transforms));
+      m_World.AddSystem(std::make_unique<GameDatabase>(m_Properties));
+
+      GfxSystem::ViewInfo view;
+      view.viewportSize = Vec2i(1280, 720);
+      view.projection = GfxSystem::Orthographic;
+      view.displayedSize = 720;
+      m_Gfx->SetView(view);
+
+      for (uint32_t i = 0; i < iNumNodes; ++i)
+      {
+        SyntheticSceneNode* node = eXl_NEW SyntheticSceneNode(iNumSprites / iNumNodes, true);
+        m_Gfx->AddRenderNode(UniquePtr<GfxRenderNode>(node));
+        m_Node = i == 0 ? node : m_Node;
+      }
+    }
+
+    PropertiesManifest m_Properties;
+    World m_World;
+    Transforms* m_Transforms;
+    GfxSystem* m_Gfx;
+    SyntheticSceneNode* m_Node;
+  };
+
+  // Textured unit quads, as GfxComponents.
+  struct QuadComponents
+  {
+    QuadComponents(RenderScene& iScene)
+      : m_Scene(iScene)
+    {
+      GfxSystem& gfx = *iScene.m_Gfx;
+      m_Program.reset(OGLSpriteAlgo::CreateSpriteProgram(gfx.GetSemanticManager()));
+      float const quad[] =
+      {
+        -0.5, -0.5, 0.0, 0.0, 1.0,
+         0.5, -0.5, 0.0, 1.0, 1.0,
+        -0.5,  0.5, 0.0, 0.0, 0.0,
+         0.5, -0.5, 0.0, 1.0, 1.0,
+         0.5,  0.5, 0.0, 1.0, 0.0,
+        -0.5,  0.5, 0.0, 0.0, 0.0,
+      };
+      m_Geom = eXl_NEW GeometryInfo;
+      m_Geom->m_Vertices = OGLBuffer::CreateBuffer(OGLBufferUsage::ARRAY_BUFFER, sizeof(quad), (void*)quad);
+      m_Geom->SetupAssembly(true);
+      m_Geom->m_Command = OGLDraw::TriangleList;
+      m_Geom->m_Bounds = GfxBounds::FromBox(AABB2Df(-0.5, -0.5, 0.5, 0.5));
+
+      m_Material = eXl_NEW SpriteMaterialInfo;
+      m_Material->m_Texture = OGLTextureLoader::Create(Image::Size(16, 16), OGLTextureLoader::RGBA8);
+      m_Material->SetupData();
+    }
+
+    ObjectHandle Add(Vec2 const& iPos)
+    {
+      ObjectHandle object = m_Scene.m_World.CreateObject();
+      m_Scene.m_Transforms->AddTransform(object, translate(Identity<Mat4>(), Vec3(iPos, 0)));
+      GfxComponent& comp = m_Scene.m_Gfx->CreateComponent(object);
+      comp.SetProgram(m_Program.get());
+      comp.SetGeometry(m_Geom);
+      comp.AddDraw(m_Material.get()).NumElements(6).End();
+      return object;
+    }
+
+    RenderScene& m_Scene;
+    UniquePtr<OGLCompiledProgram const> m_Program;
+    IntrusivePtr<GeometryInfo> m_Geom;
+    IntrusivePtr<SpriteMaterialInfo> m_Material;
+  };
+}
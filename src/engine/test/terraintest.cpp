@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+
+#include <gen/terrain.hpp>
+#include <core/random.hpp>
+
+#include "terraintest.hpp"
+
+using namespace eXl;
+
+TEST(Terrain, DiffusionSolversMatchDiffusion)
+{
+  Terrain terrain;
+  terrain.MakeGrid(Vec2(32.0, 32.0), Vec2i(24, 24));
+  size_t const numCells = terrain.GetCells().size();
+  UniquePtr<LaplaceMatrix> matrix(BuildMatrix(terrain));
+  UniquePtr<Random> rand(Random::CreateDefaultRNG(0));
+  float const heatCoeff = 0.8;
+
+  Vector<Vector<float>> fields;
+  Vector<Vector<float>> expected;
+  for (uint32_t i = 0; i < 3; ++i)
+  {
+    fields.push_back(RandomField(*rand, numCells));
+    expected.push_back(fields.back());
+    // Several steps, as the solver is meant to be reused.
+    for (uint32_t step = 0; step < 4; ++step)
+    {
+      terrain.Diffusion(matrix.get(), heatCoeff, expected.back());
+    }
+  }
+
+  for (auto method : {DiffusionSolver::Direct, DiffusionSolver::ConjugateGradient})
+  {
+    DiffusionSolver* solverPtr = nullptr;
+    terrain.BuildDiffusionSolver(matrix.get(), heatCoeff, method, solverPtr, 1.0e-7);
+    UniquePtr<DiffusionSolver> solver(solverPtr);
+    EXPECT_EQ(solver->GetMethod(), method);
+
+    Vector<Vector<float>> batched = fields;
+    Vector<float> single = fields[0];
+    for (uint32_t step = 0; step < 4; ++step)
+    {
+      solver->Solve(batched);
+      solver->Solve(single);
+    }
+
+    for (uint32_t i = 0; i < fields.size(); ++i)
+    {
+      for (uint32_t cell = 0; cell < numCells; ++cell)
+      {
+        ASSERT_NEAR(batched[i][cell], expected[i][cell], 1.0e-3) << "Field " << i << ", cell " << cell;
+      }
+    }
+    for (uint32_t cell = 0; cell < numCells; ++cell)
+    {
+      ASSERT_NEAR(single[cell], expected[0][cell], 1.0e-3) << "Cell " << cell;
+    }
+  }
+}
+
+TEST(Terrain, DiffusionFollowsCoefficient)
+{
+  Terrain terrain;
+  terrain.MakeGrid(Vec2(16.0, 16.0), Vec2i(12, 12));
+  size_t const numCells = terrain.GetCells().size();
+  UniquePtr<LaplaceMatrix> matrix(BuildMatrix(terrain));
+  UniquePtr<Random> rand(Random::CreateDefaultRNG(0));
+  Vector<float> const field = RandomField(*rand, numCells);
+
+  // Diffusion keeps its factorization between calls, it must not be used for another coefficient.
+  for (float heatCoeff : {0.8f, 0.8f, 0.2f})
+  {
+    Vector<float> diffused = field;
+    terrain.Diffusion(matrix.get(), heatCoeff, diffused);
+
+    DiffusionSolver* solverPtr = nullptr;
+    terrain.BuildDiffusionSolver(matrix.get(), heatCoeff, DiffusionSolver::Direct, solverPtr);
+    UniquePtr<DiffusionSolver> solver(solverPtr);
+    Vector<float> expected = field;
+    solver->Solve(expected);
+
+    for (uint32_t cell = 0; cell < numCells; ++cell)
+    {
+      ASSERT_NEAR(diffused[cell], expected[cell], 1.0e-5) << "Coefficient " << heatCoeff << ", cell " << cell;
+    }
+  }
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <gen/terrain.hpp>
+#include <core/random.hpp>
+
+namespace eXl
+{
+  inline LaplaceMatrix* BuildMatrix(Terrain& iTerrain)
+  {
+    Terrain::ConductivityGetter conductivity = [](uint32_t, uint32_t, float iEdgeLen, float iCellDist)
+    {
+      return iEdgeLen / iCellDist;
+    };
+    LaplaceMatrix* matrix = nullptr;
+    iTerrain.BuildLaplaceMatrix(conductivity, matrix);
+    return matrix;
+  }
+
+  inline Vector<float> RandomField(Random& iRand, size_t iNumCells)
+  {
+    Vector<float> field(iNumCells);
+    for (auto& value : field)
+    {
+      value = (iRand.Generate() % 1000) * 0.01f;
+    }
+    return field;
+  }
+}
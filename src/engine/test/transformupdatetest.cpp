@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+
+#include <engine/common/world.hpp>
+#include <engine/common/transforms.hpp>
+
+#include "transformupdatetest.hpp"
+
+using namespace eXl;
+
+namespace
+{
+  void CheckHierarchy(HierarchyScene& iScene)
+  {
+    UnorderedMap<ObjectHandle, Mat4> updated;
+    iScene.m_Transforms->IterateOverDirtyTransforms([&updated](Mat4 const& iMat, ObjectHandle iObj)
+    {
+      updated.insert(std::make_pair(iObj, iMat));
+    });
+
+    for (uint32_t i = 0; i < iScene.m_Objects.size(); ++i)
+    {
+      Mat4 const expected = iScene.ExpectedWorld(i);
+      Mat4 const& world = iScene.m_Transforms->GetWorldTransform(iScene.m_Objects[i]);
+      auto iter = updated.find(iScene.m_Objects[i]);
+      for (uint32_t col = 0; col < 4; ++col)
+      {
+        for (uint32_t row = 0; row < 4; ++row)
+        {
+          ASSERT_NEAR(world[col][row], expected[col][row], 1.0e-3) << "Object " << i;
+          if (iter != updated.end())
+          {
+            ASSERT_EQ(iter->second[col][row], world[col][row]) << "Object " << i;
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST(Transforms, BatchedUpdateMatchesHierarchy)
+{
+  for (auto storage : {Transforms::MatrixStorage, Transforms::Compact2DStorage})
+  {
+    HierarchyScene scene(3000, storage);
+    CheckHierarchy(scene);
+
+    for (uint32_t frame = 0; frame < 10; ++frame)
+    {
+      scene.m_Transforms->NextFrame();
+      scene.Move(100);
+      scene.Reparent(20);
+      CheckHierarchy(scene);
+    }
+  }
+}
+
+TEST(Transforms, Compact2DRoundTrip)
+{
+  ComponentManifest dummy;
+  World world(dummy);
+  Transforms* transforms = world.AddSystem(std::make_unique<Transforms>(Transforms::Compact2DStorage));
+
+  ObjectHandle parent = world.CreateObject();
+  ObjectHandle child = world.CreateObject();
+  transforms->AddTransform(parent);
+  transforms->AddTransform(child);
+  transforms->Attach(child, parent);
+
+  Transforms::Transform2D parentTrans;
+  parentTrans.m_Rotation = Vec2(0.0, 1.0);
+  parentTrans.m_Translation = Vec3(1.0, 2.0, 3.0);
+  Transforms::Transform2D childTrans;
+  childTrans.m_Translation = Vec3(1.0, 0.0, 0.0);
+  transforms->UpdateTransform(parent, parentTrans);
+  transforms->UpdateTransform(child, childTrans);
+
+  Transforms::Transform2D childWorld = transforms->GetWorldTransform2D(child);
+  EXPECT_NEAR(childWorld.m_Rotation.x, 0.0, 1.0e-5);
+  EXPECT_NEAR(childWorld.m_Rotation.y, 1.0, 1.0e-5);
+  EXPECT_NEAR(childWorld.m_Translation.x, 1.0, 1.0e-5);
+  EXPECT_NEAR(childWorld.m_Translation.y, 3.0, 1.0e-5);
+  EXPECT_NEAR(childWorld.m_Translation.z, 3.0, 1.0e-5);
+
+  Mat4 const& childMatrix = transforms->GetWorldTransform(child);
+  EXPECT_NEAR(childMatrix[3].x, 1.0, 1.0e-5);
+  EXPECT_NEAR(childMatrix[3].y, 3.0, 1.0e-5);
+  EXPECT_NEAR(childMatrix[0].y, 1.0, 1.0e-5);
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <engine/common/world.hpp>
+#include <engine/common/transforms.hpp>
+
+#include <core/random.hpp>
+
+namespace eXl
+{
+  struct HierarchyScene
+  {
+    // Every object past the first s_NumRoots is attached to a random previous one.
+    static constexpr uint32_t s_NumRoots = 16;
+
+    HierarchyScene(uint32_t iNumObjects, Transforms::Storage iStorage)
+      : m_World(m_Dummy)
+      , m_Rand(Random::CreateDefaultRNG(0))
+    {
+      m_Transforms = m_World.AddSystem(std::make_unique<Transforms>(iStorage));
+      for (uint32_t i = 0; i < iNumObjects; ++i)
+      {
+        ObjectHandle obj = m_World.CreateObject();
+        m_Transforms->AddTransform(obj, RandomTransform());
+        m_Parents.push_back(i < s_NumRoots ? -1 : int32_t(m_Rand->Generate() % i));
+        if (m_Parents.back() >= 0)
+        {
+          m_Transforms->Attach(obj, m_Objects[m_Parents.back()]);
+        }
+        m_Objects.push_back(obj);
+      }
+    }
+
+    Mat4 RandomTransform()
+    {
+      float const angle = (m_Rand->Generate() % 1000) * Mathf::Pi() / 500;
+      Vec3 const pos((m_Rand->Generate() % 1000) * 0.01f, (m_Rand->Generate() % 1000) * 0.01f, 0.0);
+      return rotate(translate(Identity<Mat4>(), pos), angle, UnitZ<Vec3>());
+    }
+
+    // Move a random subset of the objects.
+    void Move(uint32_t iNumMoves)
+    {
+      for (uint32_t i = 0; i < iNumMoves; ++i)
+      {
+        m_Transforms->UpdateTransform(m_Objects[m_Rand->Generate() % m_Objects.size()], RandomTransform());
+      }
+    }
+
+    // Attach a random subset of the objects to new parents, keeping parents before their children.
+    void Reparent(uint32_t iNumChanges)
+    {
+      for (uint32_t i = 0; i < iNumChanges; ++i)
+      {
+        uint32_t child = s_NumRoots + m_Rand->Generate() % (m_Objects.size() - s_NumRoots);
+        m_Parents[child] = m_Rand->Generate() % child;
+        m_Transforms->Attach(m_Objects[child], m_Objects[m_Parents[child]]);
+      }
+    }
+
+    Mat4 ExpectedWorld(uint32_t iIdx)
+    {
+      Mat4 const& local = m_Transforms->GetLocalTransform(m_Objects[iIdx]);
+      return m_Parents[iIdx] < 0 ? local : ExpectedWorld(m_Parents[iIdx]) * local;
+    }
+
+    ComponentManifest m_Dummy;
+    World m_World;
+    UniquePtr<Random> m_Rand;
+    Transforms* m_Transforms;
+    Vector<ObjectHandle> m_Objects;
+    Vector<int32_t> m_Parents;
+  };
+}
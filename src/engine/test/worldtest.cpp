@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+
+#include <engine/common/world.hpp>
+#include <engine/common/transforms.hpp>
+#include <engine/common/gamedatabase.hpp>
+#include <engine/game/commondef.hpp>
+#include <engine/pathfinding/navigator.hpp>
+
+#include <core/thread/jobsystem.hpp>
+
+#include <atomic>
+
+using namespace eXl;
+
+namespace
+{
+  void NoOp(World&, float) {}
+
+  // Drops the frozen lookup table, as when freezing the component names fails.
+  struct UnfrozenManifest : ComponentManifest
+  {
+    void DropFrozen()
+    {
+      m_FrozenComponents.Clear();
+      m_ComponentsFrozen = false;
+    }
+  };
+}
+
+TEST(World, ComponentManifestLookup)
+{
+  UnfrozenManifest manifest;
+  uint32_t numCreated = 0;
+  manifest.RegisterComponent(ComponentName("TestComponentA"), [&](World&, ObjectHandle) { ++numCreated; }, {});
+  manifest.RegisterComponent(ComponentName("TestComponentB"), [&](World&, ObjectHandle) { numCreated += 10; }, {PropertySheetName("TestData")});
+
+  for (bool frozen : {true, false})
+  {
+    if (!frozen)
+    {
+      manifest.DropFrozen();
+    }
+    World world(manifest);
+    ComponentFactory const* factoryA = manifest.GetComponentFactory(ComponentName("TestComponentA"));
+    ComponentFactory const* factoryB = manifest.GetComponentFactory(ComponentName("TestComponentB"));
+    ASSERT_NE(factoryA, nullptr);
+    ASSERT_NE(factoryB, nullptr);
+    numCreated = 0;
+    (*factoryA)(world, ObjectHandle());
+    (*factoryB)(world, ObjectHandle());
+    EXPECT_EQ(numCreated, 11);
+
+    UnorderedSet<PropertySheetName> const* requiredData = manifest.GetRequiredDataForComponent(ComponentName("TestComponentB"));
+    ASSERT_NE(requiredData, nullptr);
+    EXPECT_EQ(requiredData->count(PropertySheetName("TestData")), 1);
+
+    EXPECT_EQ(manifest.GetComponentFactory(ComponentName("Missing")), nullptr);
+    EXPECT_EQ(manifest.GetRequiredDataForComponent(ComponentName("Missing")), nullptr);
+  }
+}
+
+TEST(World, TickAccessConflicts)
+{
+  TickAccess writeTrans = TickAccess().Write<Transforms>();
+  TickAccess readTrans = TickAccess().Read<Transforms>();
+  TickAccess writeNav = TickAccess().Write<NavigatorSystem>();
+  TickAccess writeBase = TickAccess().Write<ComponentManager>();
+
+  EXPECT_TRUE(writeTrans.ConflictsWith(readTrans));
+  EXPECT_TRUE(readTrans.ConflictsWith(writeTrans));
+  EXPECT_FALSE(readTrans.ConflictsWith(readTrans));
+  EXPECT_FALSE(writeTrans.ConflictsWith(writeNav));
+  // Systems conflict with their base classes.
+  EXPECT_TRUE(writeBase.ConflictsWith(readTrans));
+  EXPECT_TRUE(writeNav.ConflictsWith(writeBase));
+}
+
+TEST(World, TickWavesFollowAccess)
+{
+  World world(EngineCommon::GetComponents());
+  World::Stage const stage = World::PrePhysics;
+
+  world.AddTick(stage, &NoOp, TickAccess().Write<Transforms>());
+  world.AddTick(stage, &NoOp, TickAccess().Write<NavigatorSystem>());
+  world.AddTick(stage, &NoOp, TickAccess().Read<GameDatabase>());
+  world.AddTick(stage, &NoOp, TickAccess().Read<Transforms>());
+  world.AddTick(stage, &NoOp, TickAccess().Read<Transforms>().Read<GameDatabase>());
+  world.AddTick(stage, &NoOp, TickAccess().Write<ComponentManager>());
+  world.AddTick(stage, &NoOp);
+  world.AddTick(stage, &NoOp, TickAccess().Read<GameDatabase>());
+
+  uint32_t const expectedWaves[] = { 0, 0, 0, 1, 1, 2, 3, 4 };
+  for (uint32_t i = 0; i < 8; ++i)
+  {
+    EXPECT_EQ(world.GetTickWave(stage, i), expectedWaves[i]) << "Tick " << i;
+  }
+  EXPECT_EQ(world.GetNumTickWaves(stage), 5);
+  EXPECT_EQ(world.GetNumTickWaves(World::PostPhysics), 0);
+}
+
+TEST(World, ConcurrentTicksKeepConflictOrder)
+{
+  JobSystem jobs(4);
+  World world(EngineCommon::GetComponents(), &jobs);
+  World::Stage const stage = World::PostPhysics;
+
+  uint32_t const numFrames = 50;
+  uint32_t const numReaders = 8;
+  uint32_t written = 0;
+  std::atomic<uint32_t> numBadReads(0);
+  std::atomic<uint32_t> numReads(0);
+  uint32_t lastSeenReads = 0;
+
+  world.AddTick(stage, [&](World&, float)
+  {
+    ++written;
+  }, TickAccess().Write<Transforms>());
+  for (uint32_t i = 0; i < numReaders; ++i)
+  {
+    world.AddTick(stage, [&](World&, float)
+    {
+      if (written != lastSeenReads / numReaders + 1)
+      {
+        ++numBadReads;
+      }
+      ++numReads;
+    }, TickAccess().Read<Transforms>().Read<GameDatabase>());
+  }
+  // Runs alone, after every reader of the frame.
+  world.AddTick(stage, [&](World&, float)
+  {
+    if (numReads != written * numReaders)
+    {
+      ++numBadReads;
+    }
+    lastSeenReads = numReads;
+  });
+  EXPECT_EQ(world.GetNumTickWaves(stage), 3);
+
+  ProfilingState profiling;
+  for (uint32_t i = 0; i < numFrames; ++i)
+  {
+    world.Tick(profiling);
+  }
+
+  EXPECT_EQ(written, numFrames);
+  EXPECT_EQ(numReads, numFrames * numReaders);
+  EXPECT_EQ(numBadReads, 0);
+}
@@ -14,6 +14,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <math/mathtools.hpp>
 #include <math/segment.hpp>
 #include <core/random.hpp>
+#include <core/thread/jobsystem.hpp>
 #include <gen/voronoigr.hpp>
 
 //#include <boost/pool/pool_alloc.hpp>
@@ -25,6 +26,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <core/stream/unstreamer.hpp>
 
 #include <fstream>
+#include <cmath>
 
 #include <core/stream/jsonstreamer.hpp>
 #include <core/stream/jsonunstreamer.hpp>
@@ -146,6 +148,21 @@ namespace eXl
     iStreamer.PushKey("Static");
     iStreamer &= m_Static;
     iStreamer.PopKey();
+    if(iStreamer.PushKey("NumChains"))
+    {
+      iStreamer &= m_NumChains;
+      iStreamer.PopKey();
+    }
+    if(iStreamer.PushKey("MaxTemperature"))
+    {
+      iStreamer &= m_MaxTemperature;
+      iStreamer.PopKey();
+    }
+    if(iStreamer.PushKey("ExchangeInterval"))
+    {
+      iStreamer &= m_ExchangeInterval;
+      iStreamer.PopKey();
+    }
     iStreamer.EndStruct();
 
     return Err::Success;
@@ -213,6 +230,9 @@ namespace eXl
     }
 
     AABB2Di curBox;
+    // Interaction rate of the element with its neighbours, used by death proposals.
+    float cachedRate = 0.0;
+    bool cacheValid = false;
   };
 
 
@@ -756,437 +776,516 @@ namespace eXl
 
 //#define INDIVIDUAL_SPACE
 
-  void MCMC2D::Run(Random& iRand, RunParams& iParams, LearnedModel* iModel, Debug* iDebug)
+  // Only reports the elements it is given, to invalidate their cached rates.
+  struct CacheInvalidator : RunHandler
   {
-    if(!iModel)
-      return;
+    using RunHandler::RunHandler;
 
-    //unsigned int maxTotElem = 0;
-    //
-    //if(iMaxElements != nullptr)
-    //{
-    //  if(iMaxElements->size() < m_Elements.size())
-    //  {
-    //    iMaxElements->resize(m_Elements.size(), 0);
-    //  }
-    //  for(auto curMax : *iMaxElements)
-    //  {
-    //    maxTotElem += curMax;
-    //  }
-    //}
+    inline bool Accept(SpIdxValList const& iVal, PlacedElemList::iterator const&)
+    {
+      if(iVal.second->m_Element > 0)
+      {
+        iVal.second->cacheValid = false;
+      }
+      return false;
+    }
+  };
 
-    //std::vector<float> relDensity(m_Elements.size());
+  // Data shared by all the chains of a run, read only once the chains are started.
+  struct RunContext
+  {
+    RunContext(MCMC2D::RunParams const& iParams, MCMC2D::LearnedModel& iModel)
+      : m_Params(iParams)
+      , m_Model(iModel)
+      , m_Elements(iModel.GetElements())
+      , m_Builder(m_Elements, iModel.IsToroidal())
+    {}
 
-    auto const& m_Elements = iModel->GetElements();
+    bool Init();
 
-    InputBuilder builder(m_Elements, iModel->IsToroidal());
+    MCMC2D::RunParams const& m_Params;
+    MCMC2D::LearnedModel& m_Model;
+    Vector<MCMC2D::Element> const& m_Elements;
+    MCMC2D::InputBuilder m_Builder;
+
+    std::map<unsigned int, unsigned int> m_RelDensity;
+    std::vector<AABB2Di> m_QuerySize;
+    double m_GlobArea;
+    int m_FirstElem = -1;
+    int m_LastElem = -1;
+    Vec2i m_SamplingAreaSize;
+    Vector<Polygoni> m_NegShape;
+    // Any sample box is within this distance of its element's position.
+    int m_InvalidationRadius = 0;
+  };
 
+  bool RunContext::Init()
+  {
     float iMaxDist = 0.0;
-    for(unsigned int idx = 0; idx < builder.oneHotSize; ++idx)
+    for(unsigned int idx = 0; idx < m_Builder.oneHotSize; ++idx)
     {
-      iMaxDist = Mathf::Max(iMaxDist, iModel->GetMaxDist(idx));
+      iMaxDist = Mathf::Max(iMaxDist, m_Model.GetMaxDist(idx));
     }
 
-    std::map<unsigned int, unsigned int> relDensity;
-    std::vector<AABB2Di> querySize(m_Elements.size());
-    std::vector<float> elementCoeff(m_Elements.size(), 0.0);
-    std::vector<unsigned int> elementsInst(m_Elements.size(), 0);
-    double globArea = iParams.m_Shape.Area();
+    m_QuerySize.resize(m_Elements.size());
+    m_GlobArea = m_Params.m_Shape.Area();
     float totalDensity = 0;
-    int firstElem = -1;
-    int lastElem  = -1;
+    float maxCorner = 0;
     for(unsigned int i = 0; i<m_Elements.size(); ++i)
     {
       totalDensity += m_Elements[i].m_RelDensity;
       for(auto const& poly : m_Elements[i].m_Shapes)
-        querySize[i].Absorb(poly.GetAABB());
-      
+        m_QuerySize[i].Absorb(poly.GetAABB());
+
       float maxQuery = iMaxDist;
 
-      querySize[i].m_Data[0].x -= maxQuery;
-      querySize[i].m_Data[0].y -= maxQuery;
-      querySize[i].m_Data[1].x += maxQuery;
-      querySize[i].m_Data[1].y += maxQuery;
+      m_QuerySize[i].m_Data[0].x -= maxQuery;
+      m_QuerySize[i].m_Data[0].y -= maxQuery;
+      m_QuerySize[i].m_Data[1].x += maxQuery;
+      m_QuerySize[i].m_Data[1].y += maxQuery;
+
+      for(auto const& corner : m_QuerySize[i].m_Data)
+      {
+        maxCorner = Mathf::Max(maxCorner, length(MathTools::ToFVec(corner)));
+      }
     }
+    m_InvalidationRadius = int(Mathf::Ceil(maxCorner)) + 1;
 
     unsigned int cumulatedDensity = 0;
     for(unsigned int i = 0; i<m_Elements.size(); ++i)
     {
       if(m_Elements[i].m_RelDensity > 0.0 && m_Elements[i].m_AbsDensity > 0.0 && !m_Elements[i].m_Shapes.empty())
       {
-        double accumArea = 0;
-        for(auto const& poly : m_Elements[i].m_Shapes)
-          accumArea += poly.Area();
-        accumArea /= m_Elements[i].m_Shapes.size();
-
-        elementCoeff[i] = (globArea/accumArea) * m_Elements[i].m_AbsDensity;
-        relDensity.insert(std::make_pair(cumulatedDensity, i));
+        m_RelDensity.insert(std::make_pair(cumulatedDensity, i));
         cumulatedDensity += k_RelDensitySampling * (m_Elements[i].m_RelDensity / totalDensity);
       }
     }
 
-    if(relDensity.empty())
-      return;
+    if(m_RelDensity.empty())
+      return false;
 
-    firstElem = relDensity.begin()->second;
-    lastElem = relDensity.rbegin()->second;
+    m_FirstElem = m_RelDensity.begin()->second;
+    m_LastElem = m_RelDensity.rbegin()->second;
 
-    unsigned int area = iParams.m_Shape.Area() /*/ (iQuerySize * iQuerySize * 0.25 )*/;
+    m_SamplingAreaSize = m_Params.m_Shape.GetAABB().GetSize();
+    if(m_SamplingAreaSize.x <= 0 || m_SamplingAreaSize.y <= 0)
+    {
+      return false;
+    }
 
-    Vec2i samplingAreaSize = iParams.m_Shape.GetAABB().GetSize();
+    Polygoni outerBorder(AABB2Di::FromMinAndSize(m_Params.m_Shape.GetAABB().m_Data[0] - One<Vec2i>() * 50, m_Params.m_Shape.GetAABB().GetSize() + One<Vec2i>() * 100));
+    outerBorder.Difference(m_Params.m_Shape, m_NegShape);
 
-    boost::random::uniform_real_distribution<double> distribX(0, samplingAreaSize.x);
-    boost::random::uniform_real_distribution<double> distribY(0, samplingAreaSize.y);
+    return true;
+  }
 
-    if(samplingAreaSize.x <= 0 || samplingAreaSize.y <= 0)
-    {
-      return;
-    }
+  // One chain of birth and death moves.
+  struct RunChain
+  {
+    RunChain(RunContext& iContext, Random& iRand, MCMC2D::Debug* iDebug)
+      : m_Context(iContext)
+      , m_Rand(iRand)
+      , m_Debug(iDebug)
+      , m_Handler(iContext.m_Model, iContext.m_Builder, iDebug)
+      , m_DistribX(0, iContext.m_SamplingAreaSize.x)
+      , m_DistribY(0, iContext.m_SamplingAreaSize.y)
+    {}
+
+    RunChain(RunChain const&) = delete;
+    RunChain& operator=(RunChain const&) = delete;
 
-    RandomWrapper rand(&iRand);
-    //PlacedElemList origElements;
-    PlacedElemList elements;
-    PlacedElemList wallList;
-    std::vector<PlacedElemList::iterator> orderedPlaced;
-    unsigned int numPlaced = 0;
+    void Init();
+    void Step();
+    void GetPlaced(Vector<MCMC2D::PlacedElement>& oPlaced) const;
 
-    //PointIndex<PlacedElemList::iterator> idx;
+    // Marks the elements whose interactions may involve an element at iBox.
+    void Invalidate(MCMC2D::PlacedElement const& iElement, AABB2Di const& iBox);
 
-    QueryCache<PointIndex<PlacedElemList::iterator> > queryCache;
-    //RunHandler queryHandler(m_Distribs, m_BorderDistribs);
+    RunContext& m_Context;
+    Random& m_Rand;
+    MCMC2D::Debug* m_Debug;
 
-    RunHandler queryHandler(*iModel, builder, iDebug);
-    //queryHandler.m_MaxDist = ;
+    PlacedElemList m_ElementsList;
+    PlacedElemList m_WallList;
+    std::vector<PlacedElemList::iterator> m_OrderedPlaced;
+    std::vector<unsigned int> m_ElementsInst;
+    unsigned int m_NumPlaced = 0;
+
+    QueryCache<PointIndex<PlacedElemList::iterator> > m_QueryCache;
+    RunHandler m_Handler;
+    boost::random::uniform_real_distribution<double> m_DistribX;
+    boost::random::uniform_real_distribution<double> m_DistribY;
+
+    // Inverse temperature the interaction terms are raised to.
+    float m_Beta = 1.0;
+    // Log of the unnormalized density of the current state, relative to the initial one.
+    double m_LogDensity = 0.0;
+  };
 
-    Polygoni outerBorder(AABB2Di::FromMinAndSize(iParams.m_Shape.GetAABB().m_Data[0] - One<Vec2i>() * 50, iParams.m_Shape.GetAABB().GetSize() + One<Vec2i>() * 100));
-    Vector<Polygoni> negShape;
-    outerBorder.Difference(iParams.m_Shape, negShape);
+  void RunChain::Init()
+  {
+    auto const& m_Elements = m_Context.m_Elements;
+    MCMC2D::RunParams const& iParams = m_Context.m_Params;
+    m_ElementsInst.resize(m_Elements.size(), 0);
 
-    PlacedElemList::iterator iterOrig;
+    Vector<SpIdxValList> values;
+    if(!m_Context.m_Model.IsToroidal())
     {
-      Vector<SpIdxValList> values;
-      if(!iModel->IsToroidal())
+      Vector<Polygoni> trapezoids;
+      for(auto poly : m_Context.m_NegShape)
       {
-        Vector<Polygoni> trapezoids;
-        for(auto poly : negShape)
-        {
-          trapezoids = poly.GetTrapezoids();
-        }
-        for(auto trap : trapezoids)
-        {
-          trap.RemoveUselessPoints();
-          PlacedElementAndBox element(Zero<Vec2i>(), 0.0, -int(queryCache.m_Walls.size()), 0, trap.GetAABB());
-          wallList.push_back(element);
-          SpIdxValList value = std::make_pair(trap.GetAABB(), std::prev(wallList.end()));
-          values.push_back(value);
-          queryCache.m_Walls.emplace_back(std::move(trap));
-        }
+        trapezoids = poly.GetTrapezoids();
       }
-      for(int i = 0; i < iParams.m_Static.size(); ++i)
+      for(auto trap : trapezoids)
       {
-        PlacedElement currentElement = iParams.m_Static[i];
-        unsigned int element = currentElement.m_Element - 1;
-        if(element < m_Elements.size() && currentElement.m_ShapeNum < m_Elements[element].m_Shapes.size())
-        {
-          queryCache.m_Poly1 = m_Elements[element].m_Shapes[currentElement.m_ShapeNum];
-          queryCache.m_Poly1.Rotate(currentElement.m_Angle);
-          queryCache.m_Poly1.Translate(currentElement.m_Pos);
-
-          elements.push_back({currentElement, queryCache.m_Poly1.GetAABB()});
-          orderedPlaced.push_back(std::prev(elements.end()));
-          SpIdxValList spIdxVal = std::make_pair(queryCache.m_Poly1.GetAABB(), std::prev(elements.end()));
-          values.push_back(spIdxVal);
-          ++elementsInst[element];
-          ++numPlaced;
-        }
+        trap.RemoveUselessPoints();
+        PlacedElementAndBox element(Zero<Vec2i>(), 0.0, -int(m_QueryCache.m_Walls.size()), 0, trap.GetAABB());
+        m_WallList.push_back(element);
+        SpIdxValList value = std::make_pair(trap.GetAABB(), std::prev(m_WallList.end()));
+        values.push_back(value);
+        m_QueryCache.m_Walls.emplace_back(std::move(trap));
       }
-      
-      for(int i = 0; i < iParams.m_Placed.size(); ++i)
+    }
+    for(auto const* placedList : {&iParams.m_Static, &iParams.m_Placed})
+    {
+      for(MCMC2D::PlacedElement const& currentElement : *placedList)
       {
-        PlacedElement const& currentElement = iParams.m_Placed[i];
         unsigned int element = currentElement.m_Element - 1;
         if(element < m_Elements.size() && currentElement.m_ShapeNum < m_Elements[element].m_Shapes.size())
         {
-          queryCache.m_Poly1 = m_Elements[element].m_Shapes[currentElement.m_ShapeNum];
-          queryCache.m_Poly1.Rotate(currentElement.m_Angle);
-          queryCache.m_Poly1.Translate(currentElement.m_Pos);
+          m_QueryCache.m_Poly1 = m_Elements[element].m_Shapes[currentElement.m_ShapeNum];
+          m_QueryCache.m_Poly1.Rotate(currentElement.m_Angle);
+          m_QueryCache.m_Poly1.Translate(currentElement.m_Pos);
 
-          elements.push_back({currentElement, queryCache.m_Poly1.GetAABB()});
-          SpIdxValList spIdxVal = std::make_pair(queryCache.m_Poly1.GetAABB(), std::prev(elements.end()));
+          m_ElementsList.push_back({currentElement, m_QueryCache.m_Poly1.GetAABB()});
+          m_OrderedPlaced.push_back(std::prev(m_ElementsList.end()));
+          SpIdxValList spIdxVal = std::make_pair(m_QueryCache.m_Poly1.GetAABB(), std::prev(m_ElementsList.end()));
           values.push_back(spIdxVal);
-          orderedPlaced.push_back(std::prev(elements.end()));
-          ++elementsInst[element];
-          ++numPlaced;
+          ++m_ElementsInst[element];
+          ++m_NumPlaced;
         }
       }
-      iParams.m_Placed.clear();
-      //Packing;
-      queryCache.m_Index = PointIndex<PlacedElemList::iterator>(std::make_pair(values.begin(), values.end()));
     }
-    
-    Vector<Vector<float>> accRates(m_Elements.size());
-
-    for(unsigned int step = 0; step<iParams.m_NumIter; ++step)
-    {
-      //if(step % 100 == 0)
-      //{
-      //  char buffer[128];
-      //  //int val = iRand.Generate();
-      //  sprintf(buffer,"Step : %i\n", step);
-      //  OutputDebugStringA(buffer);
-      //}
-      unsigned int elemIdx;
-      PlacedElemList::iterator elemIter;
-      PlacedElementAndBox currentElement;
-      unsigned int operation = 0;
-      if(/*iMaxElements != nullptr ||*/ orderedPlaced.empty())
+    //Packing;
+    m_QueryCache.m_Index = PointIndex<PlacedElemList::iterator>(std::make_pair(values.begin(), values.end()));
+  }
+
+  void RunChain::Invalidate(MCMC2D::PlacedElement const& iElement, AABB2Di const& iBox)
+  {
+    if(m_Debug)
+    {
+      return;
+    }
+
+    // An element interacts with iBox when its sample box overlaps it. The sample box is within m_InvalidationRadius of the
+    // element's position, as is the element's own box, hence twice the radius around iBox.
+    AABB2Di invalidationBox = iBox;
+    invalidationBox.m_Data[0] -= One<Vec2i>() * (2 * m_Context.m_InvalidationRadius);
+    invalidationBox.m_Data[1] += One<Vec2i>() * (2 * m_Context.m_InvalidationRadius);
+
+    Vec2i const sceneSize = m_Context.m_SamplingAreaSize;
+    Vec2i const boxSize = invalidationBox.GetSize();
+    if(m_Context.m_Model.IsToroidal() && (boxSize.x >= sceneSize.x || boxSize.y >= sceneSize.y))
+    {
+      // The wrapped query only handles boxes smaller than the scene.
+      for(auto& element : m_ElementsList)
+      {
+        element.cacheValid = false;
+      }
+      return;
+    }
+
+    CacheInvalidator invalidator(m_Context.m_Model, m_Context.m_Builder, nullptr);
+    Query(m_Context.m_Elements, m_QueryCache, invalidator, m_ElementsList.end(), invalidationBox, iElement, m_Context.m_Model.IsToroidal(), m_Context.m_Params.m_Shape.GetAABB());
+  }
+
+  void RunChain::Step()
+  {
+    auto const& m_Elements = m_Context.m_Elements;
+    MCMC2D::RunParams const& iParams = m_Context.m_Params;
+    RandomWrapper rand(&m_Rand);
+
+    unsigned int elemIdx = 0;
+    PlacedElemList::iterator elemIter = m_ElementsList.end();
+    PlacedElementAndBox currentElement;
+    unsigned int operation = 0;
+    if(m_OrderedPlaced.empty())
+    {
+      operation = 0;
+    }
+    else
+    {
+      operation = (m_Rand.Generate() % 2);
+    }
+
+    bool const death = (operation == 1) && m_OrderedPlaced.size() > iParams.m_Static.size();
+    bool const birth = !death;
+
+    if(birth)
+    {
+      auto densIter = m_Context.m_RelDensity.lower_bound((m_Rand.Generate() % k_RelDensitySampling));
+      if(densIter == m_Context.m_RelDensity.end())
       {
-        operation = 0;
+        currentElement.m_Element = m_Context.m_LastElem;
+      }
+      else if(densIter == m_Context.m_RelDensity.begin())
+      {
+        currentElement.m_Element = m_Context.m_FirstElem;
       }
       else
       {
-        operation = (iRand.Generate() % 2);
+        --densIter;
+        currentElement.m_Element = densIter->second;
       }
 
-      bool death = (operation == 1) && orderedPlaced.size() > iParams.m_Static.size();
-      bool birth = (operation == 0) || !death;
-      //bool move =  (operation == 2) && orderedPlaced.size() > iParams.m_Static.size();
-      bool move = false;
+      currentElement.m_ShapeNum = (m_Rand.Generate() % m_Elements[currentElement.m_Element].m_Shapes.size());
+      currentElement.m_Element++;
 
-      bool manipulatedElem = false;
+      bool inShape = false;
+      unsigned int sampleCount = 0;
 
-      if(birth)
+      do
       {
-        do
-        {
-          auto densIter = relDensity.lower_bound((iRand.Generate() % k_RelDensitySampling));
-          if(densIter == relDensity.end())
-          {
-            currentElement.m_Element = lastElem;
-          }
-          else if(densIter == relDensity.begin())
-          {
-            currentElement.m_Element = firstElem;
-          }
-          else
-          {
-            --densIter;
-            currentElement.m_Element = densIter->second;
-          }
-        }while(0);
+        ++sampleCount;
 
-        currentElement.m_ShapeNum = (iRand.Generate() % m_Elements[currentElement.m_Element].m_Shapes.size());
-        currentElement.m_Element++;
+        currentElement.m_Pos = Vec2i(m_DistribX(rand), m_DistribY(rand));
+        unsigned int turn = m_Elements[currentElement.m_Element - 1].m_Turn;
+        currentElement.m_Angle = turn > 1 ? (m_Rand.Generate() % turn) * (Mathf::Pi() * 2 / float(turn)) : 0.0;
+        currentElement.m_Pos += iParams.m_Shape.GetAABB().m_Data[0];
 
-        bool inShape = false;
-        unsigned int sampleCount = 0;
-
-        do
+        MCMC2D::Element const& elemDef = m_Elements[currentElement.m_Element - 1];
+        if(elemDef.m_GridX > 1)
         {
-          ++sampleCount;
-
-          //if(!orderedPlaced.empty() 
-          //  && iModel->CanSuggestPosition() 
-          //  //&& iParams.m_SuggestionFrequency > 0
-          //  && (iRand() % 1000 < iParams.m_SuggestionFrequency * 1000)
-          //  && iModel->SuggestPosition(iRand, builder, *orderedPlaced[(iRand.Generate() % orderedPlaced.size())], currentElement)
-          //  )
-          //{
-          //}
-          //else
-          {
-            currentElement.m_Pos = Vec2i(distribX(rand),distribY(rand));
-            unsigned int turn = m_Elements[currentElement.m_Element - 1].m_Turn;
-            currentElement.m_Angle = turn > 1 ? (iRand.Generate() % turn) * (Mathf::Pi() * 2 / float(turn)) : 0.0;
-            currentElement.m_Pos += iParams.m_Shape.GetAABB().m_Data[0];
-          }
-          Element const& elemDef = m_Elements[currentElement.m_Element - 1];
-          if(elemDef.m_GridX > 1)
-          {
-            currentElement.m_Pos.x = currentElement.m_Pos.x - Mathi::Mod(currentElement.m_Pos.x, elemDef.m_GridX);
-            currentElement.m_Pos.x += elemDef.m_GridX / 2;
-          }
-          if(elemDef.m_GridY > 1)
-          {
-            currentElement.m_Pos.y = currentElement.m_Pos.y - Mathi::Mod(currentElement.m_Pos.y, elemDef.m_GridY);
-            currentElement.m_Pos.y += elemDef.m_GridY / 2;
-          }
-
-          inShape = iParams.m_Shape.ContainsPoint(currentElement.m_Pos);
+          currentElement.m_Pos.x = currentElement.m_Pos.x - Mathi::Mod(currentElement.m_Pos.x, elemDef.m_GridX);
+          currentElement.m_Pos.x += elemDef.m_GridX / 2;
         }
-        while(!inShape && sampleCount < 10000);
-
-        if(!inShape)
+        if(elemDef.m_GridY > 1)
         {
-          continue;
+          currentElement.m_Pos.y = currentElement.m_Pos.y - Mathi::Mod(currentElement.m_Pos.y, elemDef.m_GridY);
+          currentElement.m_Pos.y += elemDef.m_GridY / 2;
         }
+
+        inShape = iParams.m_Shape.ContainsPoint(currentElement.m_Pos);
       }
-      else
+      while(!inShape && sampleCount < 10000);
+
+      if(!inShape)
       {
-        elemIdx = iParams.m_Static.size() + (iRand.Generate() % (orderedPlaced.size() - iParams.m_Static.size()));
-        elemIter = orderedPlaced[elemIdx];
-        currentElement = *elemIter;
+        return;
       }
+    }
+    else
+    {
+      elemIdx = iParams.m_Static.size() + (m_Rand.Generate() % (m_OrderedPlaced.size() - iParams.m_Static.size()));
+      elemIter = m_OrderedPlaced[elemIdx];
+      currentElement = *elemIter;
+    }
 
-      unsigned int element = currentElement.m_Element - 1;
-      //AABB2Di sampleBox(MathTools::ToDVec(origPt), Vec2d::ONE * 2 * iQuerySize + MathTools::ToDVec(m_Elements[element - 1].m_Shape.GetAABB().GetSize()));
-      //Polygoni samplePoly(querySize[element]);
-      //samplePoly.Rotate(currentElement.m_Angle);
+    unsigned int element = currentElement.m_Element - 1;
 
-      AABB2Df sampleBoxf;
-      sampleBoxf.m_Data[0] = MathTools::ToFVec(querySize[element].m_Data[0]);
-      sampleBoxf.m_Data[1] = MathTools::ToFVec(querySize[element].m_Data[1]);
-      sampleBoxf.Rotate(currentElement.m_Angle);
+    AABB2Df sampleBoxf;
+    sampleBoxf.m_Data[0] = MathTools::ToFVec(m_Context.m_QuerySize[element].m_Data[0]);
+    sampleBoxf.m_Data[1] = MathTools::ToFVec(m_Context.m_QuerySize[element].m_Data[1]);
+    sampleBoxf.Rotate(currentElement.m_Angle);
 
-      AABB2Di sampleBox;
-      sampleBox.m_Data[0] = MathTools::ToIVec(sampleBoxf.m_Data[0]) + currentElement.m_Pos;
-      sampleBox.m_Data[1] = MathTools::ToIVec(sampleBoxf.m_Data[1]) + currentElement.m_Pos;
+    AABB2Di sampleBox;
+    sampleBox.m_Data[0] = MathTools::ToIVec(sampleBoxf.m_Data[0]) + currentElement.m_Pos;
+    sampleBox.m_Data[1] = MathTools::ToIVec(sampleBoxf.m_Data[1]) + currentElement.m_Pos;
 
-      AABB2Di newBox = birth ? AABB2Di() : elemIter->curBox;
-      AABB2Di prevBox = newBox;
+    if(m_Debug)
+    {
+      MCMC2D::Debug::OpDesc newOp;
+      newOp.m_Op = death ? MCMC2D::Debug::Death : MCMC2D::Debug::Birth;
+      newOp.m_Element = currentElement;
+      m_Debug->m_Ops.push_back(newOp);
+    }
 
-      if(iDebug)
+    // Density and interaction terms of the element, ie. the ratio between the densities with and without it.
+    float interRate;
+    if(death && elemIter->cacheValid)
+    {
+      interRate = elemIter->cachedRate;
+    }
+    else
+    {
+      m_Handler.m_Birth = birth;
+      m_Handler.m_ComputeGrad = false;
+      m_Handler.m_MoveGrad = Zero<Vec2d>();
+      m_Handler.m_AcceptanceRate = m_Elements[element].m_AbsDensity;
+      Query(m_Elements, m_QueryCache, m_Handler, elemIter, sampleBox, currentElement, m_Context.m_Model.IsToroidal(), iParams.m_Shape.GetAABB());
+      interRate = m_Handler.m_AcceptanceRate;
+      if(death && !m_Debug)
       {
-        Debug::OpDesc newOp;
-        newOp.m_Op = death ? Debug::Death : Debug::Birth;
-        newOp.m_Element = currentElement;
-        iDebug->m_Ops.push_back(newOp);
+        elemIter->cachedRate = interRate;
+        elemIter->cacheValid = true;
       }
+    }
 
-      float prevAcceptRate = 0.0;
+#ifdef INDIVIDUAL_SPACE
+    float const proposalRate = m_Context.m_GlobArea / ((m_ElementsInst[element] + (birth ? 1 : 0)));
+#else
+    float const proposalRate = m_Context.m_GlobArea / ((m_NumPlaced + (birth ? 1 : 0)));
+#endif
+    float const acceptanceRate = proposalRate * (m_Beta == 1.0 ? interRate : std::pow(interRate, m_Beta));
 
-      queryHandler.m_Birth = birth;
-      queryHandler.m_ComputeGrad = false;//birth;
-      Vec2i prevPos = currentElement.m_Pos;
-      bool superiorGrad = true;
-      unsigned int const numGradMove = queryHandler.m_ComputeGrad ? 10 : 1;
+    if(m_Debug)
+    {
+      m_Debug->m_Ops.back().m_FinalResult = acceptanceRate;
+    }
 
-      for(unsigned int gradMove = 0; gradMove < numGradMove && superiorGrad; ++gradMove)
+    if(birth)
+    {
+      if((m_Rand.Generate() % 1000) < acceptanceRate * 1000 * iParams.m_Temperature)
       {
-        prevBox = newBox;
-        prevPos = currentElement.m_Pos;
-
-        if(gradMove > 1)
+        if(m_Debug)
         {
-          double moveNorm = NormalizeAndGetLength(queryHandler.m_MoveGrad);
-          if(moveNorm > Mathf::ZeroTolerance())
-          {
-            //queryHandler.m_MoveGrad *= m_MaxDist * (0.1 - 0.05 * float(iRand.Generate() % 1000) / 1000.0 );
-
-            currentElement.m_Pos += Vec2i(Mathf::Round(queryHandler.m_MoveGrad.x), Mathf::Round(queryHandler.m_MoveGrad.y)); 
-          }
-          else
-          {
-            break;
-          }
+          m_Debug->m_Ops.back().m_Passed = true;
         }
+        AABB2Di const newBox = m_QueryCache.m_Poly1.GetAABB();
+        Invalidate(currentElement, newBox);
 
-        prevAcceptRate = queryHandler.m_AcceptanceRate;
-#ifdef INDIVIDUAL_SPACE
-        queryHandler.m_AcceptanceRate = m_Elements[element].m_AbsDensity * globArea / ((elementsInst[element] + (birth ? 1 : 0)));
-#else
-        queryHandler.m_AcceptanceRate = m_Elements[element].m_AbsDensity * globArea / ((numPlaced + (birth ? 1 : 0)));
-#endif
+        // The new element sees the same neighbours as the ones queried for its birth.
+        currentElement.curBox = newBox;
+        currentElement.cachedRate = interRate;
+        currentElement.cacheValid = m_Debug == nullptr;
+        m_ElementsList.push_back(currentElement);
+
+        SpIdxValList spIdxVal = std::make_pair(newBox, std::prev(m_ElementsList.end()));
+        m_OrderedPlaced.push_back(spIdxVal.second);
 
-        queryHandler.m_MoveGrad = Zero<Vec2d>();
-        Query(m_Elements, queryCache, queryHandler, elemIter, sampleBox, currentElement, iModel->IsToroidal(), iParams.m_Shape.GetAABB());
+        m_QueryCache.m_Index.insert(spIdxVal);
 
-        if(iDebug)
+        ++m_NumPlaced;
+        ++m_ElementsInst[element];
+        m_LogDensity += std::log(Mathf::Max(interRate, Mathf::Epsilon()));
+      }
+    }
+    else
+    {
+      float prob = 1.0 / (acceptanceRate + Mathf::Epsilon());
+      if((m_Rand.Generate() % 1000) < prob * 1000 * iParams.m_Temperature)
+      {
+        if(m_Debug)
         {
-          iDebug->m_Ops.back().m_FinalResult = queryHandler.m_AcceptanceRate;
+          m_Debug->m_Ops.back().m_Passed = true;
         }
+        AABB2Di shapeBox = elemIter->curBox;
 
-        accRates[element].push_back((death ? -1.0 : 1.0) * queryHandler.m_AcceptanceRate);
+        m_QueryCache.m_Index.remove(SpIdxValList(std::make_pair(shapeBox, m_OrderedPlaced[elemIdx])));
+        m_ElementsList.erase(elemIter);
+        m_OrderedPlaced.erase(m_OrderedPlaced.begin() + elemIdx);
+        --m_NumPlaced;
+        --m_ElementsInst[element];
+        m_LogDensity -= std::log(Mathf::Max(interRate, Mathf::Epsilon()));
 
-        if(gradMove > 1 && queryHandler.m_AcceptanceRate < prevAcceptRate + Mathf::ZeroTolerance())
-        {
-          superiorGrad = false;
-          newBox = prevBox;
-          currentElement.m_Pos = prevPos;
-          break;
-        }
-        
-        newBox = queryCache.m_Poly1.GetAABB();
+        Invalidate(currentElement, shapeBox);
       }
+    }
+  }
 
-      //printf("%f\n",queryHandler.m_AcceptanceRate);
-      if(birth)
-      {
-        //if(((iRand.Generate() % 1000) * queryHandler.m_AcceptanceRate) / 1000.0 > 0.5)
-        if((iRand.Generate() % 1000) < queryHandler.m_AcceptanceRate * 1000 * iParams.m_Temperature)
-        {
-          if(iDebug)
-          {
-            iDebug->m_Ops.back().m_Passed = true;
-          }
-          currentElement.curBox = newBox;
-          elements.push_back(currentElement);
-          
-          SpIdxValList spIdxVal = std::make_pair(newBox, std::prev(elements.end()));
-          orderedPlaced.push_back(spIdxVal.second);
+  void RunChain::GetPlaced(Vector<MCMC2D::PlacedElement>& oPlaced) const
+  {
+    unsigned int const numStatic = m_Context.m_Params.m_Static.size();
+    oPlaced.clear();
+    oPlaced.reserve(m_OrderedPlaced.size() - numStatic);
+    for(unsigned int i = numStatic; i < m_OrderedPlaced.size(); ++i)
+    {
+      oPlaced.push_back(*m_OrderedPlaced[i]);
+    }
+  }
+
+  void MCMC2D::Run(Random& iRand, RunParams& iParams, LearnedModel* iModel, Debug* iDebug, JobSystem* iJobs)
+  {
+    if(!iModel)
+      return;
 
-          queryCache.m_Index.insert(spIdxVal);
+    RunContext context(iParams, *iModel);
+    if(!context.Init())
+      return;
 
-          ++numPlaced;
-          ++elementsInst[element];
-        }
+    if(iParams.m_NumChains <= 1)
+    {
+      RunChain chain(context, iRand, iDebug);
+      chain.Init();
+      iParams.m_Placed.clear();
+
+      for(unsigned int step = 0; step<iParams.m_NumIter; ++step)
+      {
+        chain.Step();
       }
-      else if(death)
+      chain.GetPlaced(iParams.m_Placed);
+      return;
+    }
+
+    // Parallel tempering : the replicas only share the context, each one draws from its own generator.
+    // Exchanges are decided on this thread, so the result does not depend on how the replicas are scheduled.
+    unsigned int const numChains = iParams.m_NumChains;
+    Vector<UniquePtr<Random>> chainRands;
+    Vector<UniquePtr<RunChain>> chains;
+    Vector<unsigned int> chainAtSlot(numChains);
+    UniquePtr<Random> exchangeRand(Random::CreateDefaultRNG(iRand.Generate()));
+    for(unsigned int i = 0; i < numChains; ++i)
+    {
+      chainRands.emplace_back(Random::CreateDefaultRNG(iRand.Generate()));
+      chains.emplace_back(std::make_unique<RunChain>(context, *chainRands.back(), i == 0 ? iDebug : nullptr));
+      chains.back()->Init();
+      chains.back()->m_Beta = std::pow(1.0f / Mathf::Max(iParams.m_MaxTemperature, 1.0), float(i) / (numChains - 1));
+      chainAtSlot[i] = i;
+    }
+    iParams.m_Placed.clear();
+
+    Vector<PlacedElement> bestPlaced;
+    double bestDensity = 0.0;
+    chains[0]->GetPlaced(bestPlaced);
+
+    unsigned int const exchangeInterval = iParams.m_ExchangeInterval > 0 ? iParams.m_ExchangeInterval : 1;
+    unsigned int round = 0;
+    for(unsigned int step = 0; step < iParams.m_NumIter; step += exchangeInterval, ++round)
+    {
+      unsigned int const numSteps = std::min(exchangeInterval, iParams.m_NumIter - step);
+      auto runChains = [&chains, numSteps](uint32_t iBegin, uint32_t iEnd, uint32_t)
       {
-        float prob = 1.0 / (queryHandler.m_AcceptanceRate + Mathf::Epsilon());
-        //if(((iRand.Generate() % 1000) * prob) / 1000.0 > 0.5)
-        if((iRand.Generate() % 1000) < prob * 1000 * iParams.m_Temperature)
+        for(uint32_t chainIdx = iBegin; chainIdx < iEnd; ++chainIdx)
         {
-          if(iDebug)
+          for(unsigned int i = 0; i < numSteps; ++i)
           {
-            iDebug->m_Ops.back().m_Passed = true;
+            chains[chainIdx]->Step();
           }
-          AABB2Di shapeBox = elemIter->curBox;
-
-          size_t res = queryCache.m_Index.remove(SpIdxValList(std::make_pair(shapeBox, orderedPlaced[elemIdx])));
-          elements.erase(elemIter);
-          orderedPlaced.erase(orderedPlaced.begin() + elemIdx);
-          --numPlaced;
-          --elementsInst[element];
         }
+      };
+      if(iJobs)
+      {
+        iJobs->ParallelFor(0, numChains, 1, runChains);
       }
-      else if(move)
+      else
       {
-        AABB2Di shapeBox = elemIter->curBox;
-      
-        size_t res = queryCache.m_Index.remove(SpIdxValList(std::make_pair(shapeBox, orderedPlaced[elemIdx])));
-        elemIter->curBox = newBox;
-        queryCache.m_Index.insert(SpIdxValList(std::make_pair(newBox, orderedPlaced[elemIdx])));
+        runChains(0, numChains, 0);
       }
 
-      if(iDebug)
+      for(auto const& chain : chains)
       {
+        if(chain->m_LogDensity > bestDensity)
+        {
+          bestDensity = chain->m_LogDensity;
+          chain->GetPlaced(bestPlaced);
+        }
+      }
 
+      // Neighbouring temperatures are swapped, alternating between even and odd pairs.
+      for(unsigned int slot = round % 2; slot + 1 < numChains; slot += 2)
+      {
+        RunChain& cold = *chains[chainAtSlot[slot]];
+        RunChain& hot = *chains[chainAtSlot[slot + 1]];
+        double const logRatio = (cold.m_Beta - hot.m_Beta) * (hot.m_LogDensity - cold.m_LogDensity);
+        if(logRatio >= 0.0 || (exchangeRand->Generate() % 1000000) < std::exp(logRatio) * 1000000)
+        {
+          std::swap(cold.m_Beta, hot.m_Beta);
+          std::swap(chainAtSlot[slot], chainAtSlot[slot + 1]);
+        }
       }
     }
-    
-    iParams.m_Placed.reserve(orderedPlaced.size() - iParams.m_Static.size());
-    for(unsigned int i = iParams.m_Static.size(); i < orderedPlaced.size(); ++i)
-    {
-      iParams.m_Placed.push_back(*orderedPlaced[i]);
-    }
 
-    //for(unsigned int i = 0; i<m_Elements.size(); ++i)
-    //{
-    //  char filename[256];
-    //
-    //  sprintf(filename, "D:\\Element_%i_History.txt", i);
-    //
-    //  if(FILE* history = fopen(filename, "w"))
-    //  {
-    //    fprintf(history, "Element %i with density %f", i, m_Elements[i].m_AbsDensity);
-    //    for(auto f : accRates[i])
-    //    {
-    //      fprintf(history, "\n%f", f);
-    //    }
-    //    fclose(history);
-    //  }
-    //}
+    iParams.m_Placed = std::move(bestPlaced);
   }
 
   struct LearnHandler
@@ -0,0 +1,107 @@
+/*
+Copyright 2009-2021 Nicolas Colombe
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "sparselu.hpp"
+
+#include <slu_ddefs.h>
+
+namespace eXl
+{
+  struct SparseLU::Impl
+  {
+    ~Impl()
+    {
+      if (m_HasFactors)
+      {
+        Destroy_SuperNode_Matrix(&m_L);
+        Destroy_CompCol_Matrix(&m_U);
+      }
+    }
+
+    uint32_t m_Size;
+    bool m_HasFactors = false;
+    SuperMatrix m_L;
+    SuperMatrix m_U;
+    Vector<int> m_PermC;
+    Vector<int> m_PermR;
+  };
+
+  SparseLU::SparseLU() = default;
+  SparseLU::~SparseLU() = default;
+
+  bool SparseLU::Factorize(uint32_t iSize, int const* iColPtrs, int const* iRowIndices, double const* iValues)
+  {
+    m_Impl.reset();
+
+    superlu_options_t options;
+    set_default_options(&options);
+
+    // SuperLU only reads the matrix, its API is not const correct.
+    SuperMatrix matrix;
+    dCreate_CompCol_Matrix(&matrix, iSize, iSize, iColPtrs[iSize],
+      const_cast<double*>(iValues), const_cast<int*>(iRowIndices), const_cast<int*>(iColPtrs),
+      SLU_NC, SLU_D, SLU_GE);
+
+    UniquePtr<Impl> impl = std::make_unique<Impl>();
+    impl->m_Size = iSize;
+    impl->m_PermC.resize(iSize);
+    impl->m_PermR.resize(iSize);
+    Vector<int> etree(iSize);
+
+    get_perm_c(options.ColPerm, &matrix, impl->m_PermC.data());
+    SuperMatrix permuted;
+    sp_preorder(&options, &matrix, impl->m_PermC.data(), etree.data(), &permuted);
+
+    SuperLUStat_t stat;
+    StatInit(&stat);
+    int info = 0;
+#if defined(SUPERLU_MAJOR_VERSION) && SUPERLU_MAJOR_VERSION >= 5
+    GlobalLU_t globalLU;
+    dgstrf(&options, &permuted, sp_ienv(2), sp_ienv(1), etree.data(), nullptr, 0,
+      impl->m_PermC.data(), impl->m_PermR.data(), &impl->m_L, &impl->m_U, &globalLU, &stat, &info);
+#else
+    dgstrf(&options, &permuted, sp_ienv(2), sp_ienv(1), etree.data(), nullptr, 0,
+      impl->m_PermC.data(), impl->m_PermR.data(), &impl->m_L, &impl->m_U, &stat, &info);
+#endif
+    StatFree(&stat);
+    Destroy_CompCol_Permuted(&permuted);
+    Destroy_SuperMatrix_Store(&matrix);
+
+    // Above iSize, the factors could not even be allocated.
+    impl->m_HasFactors = info <= int(iSize);
+    if (info != 0)
+    {
+      return false;
+    }
+
+    m_Impl = std::move(impl);
+    return true;
+  }
+
+  bool SparseLU::Solve(double* ioColumns, uint32_t iNumColumns) const
+  {
+    if (m_Impl == nullptr)
+    {
+      return false;
+    }
+
+    SuperMatrix columns;
+    dCreate_Dense_Matrix(&columns, m_Impl->m_Size, iNumColumns, ioColumns, m_Impl->m_Size, SLU_DN, SLU_D, SLU_GE);
+
+    SuperLUStat_t stat;
+    StatInit(&stat);
+    int info = 0;
+    dgstrs(NOTRANS, &m_Impl->m_L, &m_Impl->m_U, m_Impl->m_PermC.data(), m_Impl->m_PermR.data(), &columns, &stat, &info);
+    StatFree(&stat);
+    Destroy_SuperMatrix_Store(&columns);
+
+    return info == 0;
+  }
+}
@@ -0,0 +1,40 @@
+/*
+Copyright 2009-2021 Nicolas Colombe
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <core/coredef.hpp>
+#include <core/containers.hpp>
+
+namespace eXl
+{
+  // SuperLU factorization of a square sparse matrix, kept to solve the same system several times.
+  class SparseLU
+  {
+  public:
+    SparseLU();
+    ~SparseLU();
+
+    SparseLU(SparseLU const&) = delete;
+    SparseLU& operator=(SparseLU const&) = delete;
+
+    // Compressed column storage, as in arma::sp_mat. Returns false if the matrix is singular.
+    bool Factorize(uint32_t iSize, int const* iColPtrs, int const* iRowIndices, double const* iValues);
+
+    bool IsFactorized() const { return m_Impl != nullptr; }
+
+    // Solves in place iNumColumns right hand sides, stored column after column.
+    bool Solve(double* ioColumns, uint32_t iNumColumns) const;
+
+  private:
+    struct Impl;
+    UniquePtr<Impl> m_Impl;
+  };
+}
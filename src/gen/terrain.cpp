@@ -5,9 +5,12 @@
 
 #include <gen/poissonsampling.hpp>
 #include <math/mathtools.hpp>
+#include <core/log.hpp>
 
 #include <armadillo>
 
+#include "sparselu.hpp"
+
 namespace eXl
 {
 
@@ -15,6 +18,10 @@ namespace eXl
   {
   public:
     arma::sp_mat m_Matrix;
+
+    // Terrain::Diffusion keeps the system it solved, for the next calls with the same coefficient.
+    mutable UniquePtr<DiffusionSolver> m_Solver;
+    mutable float m_SolverCoefficient = 0;
   };
 
   struct found_goal{};
@@ -557,34 +564,220 @@ namespace eXl
     }
   }
 
-  void Terrain::Diffusion(LaplaceMatrix const* iMatrix, float iHeatCoefficient, Vector<float>& ioValues)
+  namespace
   {
-    ArmaLaplaceMatrix const* matrixContainer = static_cast<ArmaLaplaceMatrix const*>(iMatrix);
+    arma::sp_mat BuildDiffusionSystem(LaplaceMatrix const* iMatrix, float iHeatCoefficient)
+    {
+      arma::sp_mat const& laplace = static_cast<ArmaLaplaceMatrix const*>(iMatrix)->m_Matrix;
+      return arma::speye<arma::sp_mat>(laplace.n_rows, laplace.n_cols) - laplace * iHeatCoefficient;
+    }
 
-    unsigned int const numCells = m_Cells.size();
+    arma::mat ToColumns(Vector<Vector<float>> const& iFields, unsigned int iNumCells)
+    {
+      arma::mat columns(iNumCells, iFields.size());
+      for (unsigned int field = 0; field < iFields.size(); ++field)
+      {
+        eXl_ASSERT(iFields[field].size() == iNumCells);
+        double* column = columns.colptr(field);
+        for (unsigned int i = 0; i < iNumCells; ++i)
+        {
+          column[i] = iFields[field][i];
+        }
+      }
+      return columns;
+    }
 
-    eXl_ASSERT(numCells == ioValues.size());
+    void FromColumns(arma::mat const& iColumns, Vector<Vector<float>>& oFields)
+    {
+      for (unsigned int field = 0; field < oFields.size(); ++field)
+      {
+        double const* column = iColumns.colptr(field);
+        for (unsigned int i = 0; i < iColumns.n_rows; ++i)
+        {
+          oFields[field][i] = column[i];
+        }
+      }
+    }
 
-    arma::colvec inputTemp(numCells);
-    for (unsigned int i = 0; i < numCells; ++i)
+    class ArmaDiffusionSolver : public DiffusionSolver
     {
-      inputTemp.at(i) = ioValues[i];
+    public:
+      ArmaDiffusionSolver(arma::sp_mat&& iSystem)
+        : m_System(std::move(iSystem))
+      {}
+
+      void Solve(Vector<float>& ioValues) override
+      {
+        Vector<Vector<float>> fields(1);
+        fields[0].swap(ioValues);
+        Solve(fields);
+        fields[0].swap(ioValues);
+      }
+
+      void Solve(Vector<Vector<float>>& ioFields) override
+      {
+        if (ioFields.empty())
+        {
+          return;
+        }
+        arma::mat values = ToColumns(ioFields, m_System.n_rows);
+        arma::mat result;
+        SolveColumns(values, result);
+        FromColumns(result, ioFields);
+      }
+
+    protected:
+      virtual void SolveColumns(arma::mat const& iValues, arma::mat& oResult) = 0;
+
+      arma::sp_mat m_System;
+    };
+
+    class DirectDiffusionSolver : public ArmaDiffusionSolver
+    {
+    public:
+      // Armadillo does not expose the factorization spsolve computes, SuperLU is used directly to keep it.
+      DirectDiffusionSolver(arma::sp_mat&& iSystem)
+        : ArmaDiffusionSolver(std::move(iSystem))
+      {
+        m_System.sync();
+        Vector<int> colPtrs(m_System.col_ptrs, m_System.col_ptrs + m_System.n_cols + 1);
+        Vector<int> rowIndices(m_System.row_indices, m_System.row_indices + m_System.n_nonzero);
+        if (!m_LU.Factorize(m_System.n_rows, colPtrs.data(), rowIndices.data(), m_System.values))
+        {
+          LOG_ERROR << "Singular diffusion system";
+        }
+      }
+
+      Method GetMethod() const override { return Direct; }
+
+    protected:
+      void SolveColumns(arma::mat const& iValues, arma::mat& oResult) override
+      {
+        oResult = iValues;
+        if (!m_LU.Solve(oResult.memptr(), oResult.n_cols))
+        {
+          // Leaves the values as they were.
+          oResult = iValues;
+        }
+      }
+
+      SparseLU m_LU;
+    };
+
+    class CGDiffusionSolver : public ArmaDiffusionSolver
+    {
+    public:
+      CGDiffusionSolver(arma::sp_mat&& iSystem, float iTolerance)
+        : ArmaDiffusionSolver(std::move(iSystem))
+        , m_Tolerance(iTolerance)
+      {
+        m_InvDiag.set_size(m_System.n_rows);
+        for (unsigned int i = 0; i < m_System.n_rows; ++i)
+        {
+          m_InvDiag[i] = 1.0 / m_System(i, i);
+        }
+      }
+
+      Method GetMethod() const override { return ConjugateGradient; }
+
+    protected:
+      // Runs the iterations on all the columns at once, so they share the sparse products.
+      void SolveColumns(arma::mat const& iValues, arma::mat& oResult) override
+      {
+        unsigned int const numFields = iValues.n_cols;
+
+        // The diffused field stays close to the input.
+        oResult = iValues;
+        arma::mat residual = iValues - m_System * oResult;
+        arma::mat precond = residual.each_col() % m_InvDiag;
+        arma::mat dir = precond;
+        arma::rowvec rz = arma::sum(residual % precond, 0);
+
+        arma::rowvec threshold = arma::sum(iValues % iValues, 0) * (double(m_Tolerance) * m_Tolerance);
+        threshold.transform([](double iVal) { return Mathd::Max(iVal, Mathd::Epsilon()); });
+
+        arma::rowvec alpha(numFields);
+        arma::rowvec beta(numFields);
+        for (unsigned int iter = 0; iter < m_System.n_rows; ++iter)
+        {
+          arma::rowvec const sqResidual = arma::sum(residual % residual, 0);
+          bool converged = true;
+          for (unsigned int field = 0; field < numFields; ++field)
+          {
+            converged &= sqResidual[field] <= threshold[field];
+          }
+          if (converged)
+          {
+            break;
+          }
+
+          arma::mat const sysDir = m_System * dir;
+          arma::rowvec const dirSysDir = arma::sum(dir % sysDir, 0);
+          for (unsigned int field = 0; field < numFields; ++field)
+          {
+            bool const active = sqResidual[field] > threshold[field] && dirSysDir[field] > 0.0;
+            alpha[field] = active ? rz[field] / dirSysDir[field] : 0.0;
+          }
+          oResult += dir.each_row() % alpha;
+          residual -= sysDir.each_row() % alpha;
+
+          precond = residual.each_col() % m_InvDiag;
+          arma::rowvec const rzNext = arma::sum(residual % precond, 0);
+          for (unsigned int field = 0; field < numFields; ++field)
+          {
+            beta[field] = alpha[field] != 0.0 ? rzNext[field] / rz[field] : 0.0;
+          }
+          dir = precond + dir.each_row() % beta;
+          rz = rzNext;
+        }
+      }
+
+      arma::colvec m_InvDiag;
+      float m_Tolerance;
+    };
+
+    bool IsSymmetric(arma::sp_mat const& iMat)
+    {
+      arma::sp_mat const diff = iMat - iMat.t();
+      double maxDiff = 0.0;
+      for (auto iter = diff.begin(); iter != diff.end(); ++iter)
+      {
+        maxDiff = Mathd::Max(maxDiff, Mathd::Abs(*iter));
+      }
+      return maxDiff <= 1.0e-6 * Mathd::Max(1.0, arma::abs(iMat).max());
     }
+  }
 
-    arma::colvec tempRes(numCells, arma::fill::zeros);
+  void Terrain::Diffusion(LaplaceMatrix const* iMatrix, float iHeatCoefficient, Vector<float>& ioValues)
+  {
+    eXl_ASSERT(m_Cells.size() == ioValues.size());
 
-    arma::sp_mat resEqn(numCells, numCells);
-    arma::sp_mat idMat(numCells, numCells);
-    for (unsigned int i = 0; i < numCells; ++i)
-      idMat.at(i, i) = 1.0;
+    ArmaLaplaceMatrix const* matrix = static_cast<ArmaLaplaceMatrix const*>(iMatrix);
+    if (matrix->m_Solver == nullptr || matrix->m_SolverCoefficient != iHeatCoefficient)
+    {
+      matrix->m_Solver.reset(eXl_NEW DirectDiffusionSolver(BuildDiffusionSystem(iMatrix, iHeatCoefficient)));
+      matrix->m_SolverCoefficient = iHeatCoefficient;
+    }
+    matrix->m_Solver->Solve(ioValues);
+  }
 
-    resEqn = idMat - matrixContainer->m_Matrix * iHeatCoefficient;
+  void Terrain::BuildDiffusionSolver(LaplaceMatrix const* iMatrix, float iHeatCoefficient, DiffusionSolver::Method iMethod, DiffusionSolver*& oSolver, float iTolerance)
+  {
+    if (oSolver != nullptr)
+    {
+      delete oSolver;
+    }
 
-    arma::spsolve(tempRes, resEqn, inputTemp);
+    arma::sp_mat system = BuildDiffusionSystem(iMatrix, iHeatCoefficient);
+    eXl_ASSERT(system.n_rows == m_Cells.size());
 
-    for (unsigned int i = 0; i < numCells; ++i)
+    if (iMethod == DiffusionSolver::ConjugateGradient && IsSymmetric(system))
+    {
+      oSolver = eXl_NEW CGDiffusionSolver(std::move(system), iTolerance);
+    }
+    else
     {
-      ioValues[i] = tempRes.at(i);
+      oSolver = eXl_NEW DirectDiffusionSolver(std::move(system));
     }
   }
 
@@ -57,7 +57,7 @@ void main()
 }
 )";
 
-char const* hq4xPS =
+char const* hq4xPSHeader =
 #ifdef __ANDROID__
 "#version 320 es\n"
 "precision mediump float;\n"
@@ -71,7 +71,93 @@ uniform vec2 texSize;
 uniform sampler2D iUnfilteredTexture;
 uniform float     alphaMult;
 out vec4 fragColor;
- const float mx = 1.00;      // start smoothing wt.
+)";
+
+char const* hq4xInstancedVS =
+#ifdef __ANDROID__
+"#version 320 es\n"
+"precision mediump float;\n"
+#else
+"#version 140\n"
+#endif
+R"(
+in vec4 iPosition;
+in vec2 iTexCoord;
+
+in vec4 iInstWorld0;
+in vec4 iInstWorld1;
+in vec4 iInstWorld2;
+in vec4 iInstWorld3;
+in vec4 iInstTexCoord;
+in vec4 iInstTint;
+in float iInstAlphaMult;
+
+layout(std140) uniform Camera
+{
+  mat4 viewMatrix;
+  mat4 viewInverseMatrix;
+  mat4 projMatrix;
+};
+
+uniform vec2 imageSize;
+
+out vec4 texCoord[7];
+flat out vec2 tcOffset;
+flat out vec4 tint;
+flat out float alphaMult;
+
+void main()
+{
+  mat4 worldMatrix = mat4(iInstWorld0, iInstWorld1, iInstWorld2, iInstWorld3);
+  tcOffset = iInstTexCoord.xy;
+  tint = iInstTint;
+  alphaMult = iInstAlphaMult;
+
+  texCoord[0].xy = iTexCoord * iInstTexCoord.zw + iInstTexCoord.xy;
+
+  vec2 dg1 = 0.5 / imageSize;
+  vec2 dg2 = vec2(-dg1.x, dg1.y);
+  vec2 sd1 = dg1 * 0.5;
+  vec2 sd2 = dg2 * 0.5;
+  vec2 ddx = vec2(dg1.x, 0.0);
+  vec2 ddy = vec2(0.0, dg1.y);
+
+  texCoord[1].xy = texCoord[0].xy - sd1;
+  texCoord[2].xy = texCoord[0].xy - sd2;
+  texCoord[3].xy = texCoord[0].xy + sd1;
+  texCoord[4].xy = texCoord[0].xy + sd2;
+  texCoord[5].xy = texCoord[0].xy - dg1;
+  texCoord[6].xy = texCoord[0].xy + dg1;
+  texCoord[5].zw = texCoord[0].xy - dg2;
+  texCoord[6].zw = texCoord[0].xy + dg2;
+  texCoord[1].zw = texCoord[0].xy - ddy;
+  texCoord[2].zw = texCoord[0].xy + ddx;
+  texCoord[3].zw = texCoord[0].xy + ddy;
+  texCoord[4].zw = texCoord[0].xy - ddx;
+
+  gl_Position = projMatrix * viewMatrix * worldMatrix * iPosition;
+}
+)";
+
+// Same filter as hq4xPSHeader, but per-sprite parameters come from the instance stream.
+char const* hq4xInstancedPSHeader =
+#ifdef __ANDROID__
+"#version 320 es\n"
+"precision mediump float;\n"
+#else
+"#version 140\n"
+#endif
+R"(flat in vec4 tint;
+in vec4 texCoord[7];
+flat in vec2 tcOffset;
+uniform vec2 texSize;
+uniform sampler2D iUnfilteredTexture;
+flat in float alphaMult;
+out vec4 fragColor;
+)";
+
+char const* hq4xPSMain =
+R"( const float mx = 1.00;      // start smoothing wt.
  const float k = -1.10;      // wt. decrease factor
  const float max_w = 0.75;   // max filter weigth
  const float min_w = 0.03;   // min filter weigth
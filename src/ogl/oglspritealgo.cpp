@@ -12,6 +12,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <ogl/renderer/oglprogram.hpp>
 #include <ogl/renderer/oglsemanticmanager.hpp>
 #include <ogl/renderer/oglcompiledprogram.hpp>
+#include <ogl/renderer/oglrendercommand.hpp>
 #include <ogl/oglutils.hpp>
 
 #include "ogldefaultVS.inl"
@@ -43,6 +44,23 @@ namespace eXl
 {
   namespace
   {
+    // In headless mode this returns 0, and the program built on it is an empty handle
+    // whose compiled slots come from the interface declarations.
+    uint32_t CompileAndLink(char const* iVS, char const* iPS)
+    {
+      uint32_t vShader = OGLUtils::CompileVertexShader(iVS);
+      uint32_t fShader = OGLUtils::CompileFragmentShader(iPS);
+
+      uint32_t programId = OGLUtils::LinkProgram(vShader, fShader);
+#ifdef EXL_WITH_OGL
+      if (!OGLUtils::IsHeadless())
+      {
+        glDeleteShader(vShader);
+        glDeleteShader(fShader);
+      }
+#endif
+      return programId;
+    }
   }
 
   struct dummyStruct
@@ -107,18 +125,9 @@ namespace eXl
 
   OGLCompiledProgram const* OGLSpriteAlgo::CreateSpriteProgram(OGLSemanticManager& iSemantics, bool iFiltered)
   {
-#ifdef EXL_WITH_OGL
     if (!iFiltered)
     {
-      GLuint defaultVShader = OGLUtils::CompileShader(GL_VERTEX_SHADER, defaultVS);
-      GLuint defaultFShader = OGLUtils::CompileShader(GL_FRAGMENT_SHADER, defaultUPS);
-
-      GLuint defaultProgramId = OGLUtils::LinkProgram(defaultVShader, defaultFShader);
-
-      glDeleteShader(defaultVShader);
-      glDeleteShader(defaultFShader);
-
-      OGLProgram* defaultProgram = eXl_NEW OGLProgram(defaultProgramId);
+      OGLProgram* defaultProgram = eXl_NEW OGLProgram(CompileAndLink(defaultVS, defaultUPS));
 
       OGLProgramInterface sprTechDesc;
       sprTechDesc.AddAttrib(OGLBaseAlgo::GetPosAttrib());
@@ -132,15 +141,8 @@ namespace eXl
     }
     else
     {
-      GLuint hq4xVShader = OGLUtils::CompileShader(GL_VERTEX_SHADER, hq4xVS);
-      GLuint unfilteredFShader = OGLUtils::CompileShader(GL_FRAGMENT_SHADER, hq4xPS);
-
-      GLuint unfilteredProgramId = OGLUtils::LinkProgram(hq4xVShader, unfilteredFShader);
-
-      glDeleteShader(hq4xVShader);
-      glDeleteShader(unfilteredFShader);
-
-      OGLProgram* unfilteredProgram = eXl_NEW OGLProgram(unfilteredProgramId);
+      AString hq4xPS = AString(hq4xPSHeader) + hq4xPSMain;
+      OGLProgram* unfilteredProgram = eXl_NEW OGLProgram(CompileAndLink(hq4xVS, hq4xPS.c_str()));
 
       OGLProgramInterface uSprTechDesc;
       uSprTechDesc.AddAttrib(OGLBaseAlgo::GetPosAttrib());
@@ -152,22 +154,82 @@ namespace eXl
 
       return uSprTechDesc.Compile(iSemantics, unfilteredProgram);
     }
-#else
-    return nullptr;
-#endif
   }
 
-  OGLCompiledProgram const* OGLSpriteAlgo::CreateFontProgram(OGLSemanticManager& iSemantics)
+  OGLCompiledProgram const* OGLSpriteAlgo::CreateInstancedSpriteProgram(OGLSemanticManager& iSemantics)
   {
-#ifdef EXL_WITH_OGL
-    GLuint defaultVShader = OGLUtils::CompileShader(GL_VERTEX_SHADER, defaultVS);
-    GLuint fontFShader = OGLUtils::CompileShader(GL_FRAGMENT_SHADER, fontPS);
-    GLuint fontProgramId = OGLUtils::LinkProgram(defaultVShader, fontFShader);
+    AString instancedPS = AString(hq4xInstancedPSHeader) + hq4xPSMain;
+    uint32_t instancedProgramId = CompileAndLink(hq4xInstancedVS, instancedPS.c_str());
+    if (instancedProgramId == 0 && !OGLUtils::IsHeadless())
+    {
+      return nullptr;
+    }
 
-    glDeleteShader(defaultVShader);
-    glDeleteShader(fontFShader);
+    OGLProgram* instancedProgram = eXl_NEW OGLProgram(instancedProgramId);
 
-    OGLProgram* fontProgram = eXl_NEW OGLProgram(fontProgramId);
+    OGLProgramInterface instSprTechDesc;
+    instSprTechDesc.AddAttrib(OGLBaseAlgo::GetPosAttrib());
+    instSprTechDesc.AddAttrib(OGLBaseAlgo::GetTexCoordAttrib());
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+      instSprTechDesc.AddAttrib(GetInstanceWorldAttrib(i));
+    }
+    instSprTechDesc.AddAttrib(GetInstanceTexCoordAttrib());
+    instSprTechDesc.AddAttrib(GetInstanceTintAttrib());
+    instSprTechDesc.AddAttrib(GetInstanceAlphaMultAttrib());
+    instSprTechDesc.AddTexture(OGLSpriteAlgo::GetUnfilteredTexture());
+    instSprTechDesc.AddUniform(OGLBaseAlgo::GetCameraUniform());
+    instSprTechDesc.AddUniform(OGLSpriteAlgo::GetSpriteColorUniform());
+
+    return instSprTechDesc.Compile(iSemantics, instancedProgram);
+  }
+
+  void OGLSpriteAlgo::AddInstanceAttribs(OGLVAssembly& iAssembly, OGLBuffer const* iInstances, uint32_t iOffset)
+  {
+    uint32_t const stride = sizeof(SpriteInstance);
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+      iAssembly.AddAttrib(iInstances, GetInstanceWorldAttrib(i), 4, stride, iOffset + offsetof(SpriteInstance, worldMatrix) + i * sizeof(Vec4));
+    }
+    iAssembly.AddAttrib(iInstances, GetInstanceTexCoordAttrib(), 4, stride, iOffset + offsetof(SpriteInstance, tcOffsetScaling));
+    iAssembly.AddAttrib(iInstances, GetInstanceTintAttrib(), 4, stride, iOffset + offsetof(SpriteInstance, tint));
+    iAssembly.AddAttrib(iInstances, GetInstanceAlphaMultAttrib(), 1, stride, iOffset + offsetof(SpriteInstance, alphaMult));
+  }
+
+  AttributeName OGLSpriteAlgo::GetInstanceWorldAttrib(uint32_t iColumn)
+  {
+    static AttributeName s_Names[] = 
+    {
+      AttributeName("iInstWorld0"),
+      AttributeName("iInstWorld1"),
+      AttributeName("iInstWorld2"),
+      AttributeName("iInstWorld3"),
+    };
+    eXl_ASSERT(iColumn < 4);
+    return s_Names[iColumn];
+  }
+
+  AttributeName OGLSpriteAlgo::GetInstanceTexCoordAttrib()
+  {
+    static AttributeName s_Name("iInstTexCoord");
+    return s_Name;
+  }
+
+  AttributeName OGLSpriteAlgo::GetInstanceTintAttrib()
+  {
+    static AttributeName s_Name("iInstTint");
+    return s_Name;
+  }
+
+  AttributeName OGLSpriteAlgo::GetInstanceAlphaMultAttrib()
+  {
+    static AttributeName s_Name("iInstAlphaMult");
+    return s_Name;
+  }
+
+  OGLCompiledProgram const* OGLSpriteAlgo::CreateFontProgram(OGLSemanticManager& iSemantics)
+  {
+    OGLProgram* fontProgram = eXl_NEW OGLProgram(CompileAndLink(defaultVS, fontPS));
 
     OGLProgramInterface fontTechDesc;
     fontTechDesc.AddAttrib(OGLBaseAlgo::GetPosAttrib());
@@ -178,9 +240,6 @@ namespace eXl
     fontTechDesc.AddUniform(OGLSpriteAlgo::GetSpriteColorUniform());
 
     return fontTechDesc.Compile(iSemantics, fontProgram);
-#else
-    return nullptr;
-#endif
   }
 
   UniformName OGLSpriteAlgo::GetSpriteColorUniform()
@@ -209,6 +268,14 @@ namespace eXl
     samplerDesc.wrapY = OGLWrapMode::REPEAT;
 
     iManager.RegisterTexture(GetUnfilteredTexture(), samplerDesc);
+
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+      iManager.RegisterAttribute(GetInstanceWorldAttrib(i), OGLType::FLOAT32, 4, 1);
+    }
+    iManager.RegisterAttribute(GetInstanceTexCoordAttrib(), OGLType::FLOAT32, 4, 1);
+    iManager.RegisterAttribute(GetInstanceTintAttrib(), OGLType::FLOAT32, 4, 1);
+    iManager.RegisterAttribute(GetInstanceAlphaMultAttrib(), OGLType::FLOAT32, 1, 1);
   }
 
 #if 0
@@ -260,16 +327,7 @@ namespace eXl
 
   OGLCompiledProgram const* OGLLineAlgo::CreateProgram(OGLSemanticManager& iSemantics)
   {
-#ifdef EXL_WITH_OGL
-    GLuint defaultVShader = OGLUtils::CompileShader(GL_VERTEX_SHADER, defaultVS);
-    GLuint defaultFShader = OGLUtils::CompileShader(GL_FRAGMENT_SHADER, linePS);
-
-    GLuint defaultProgramId = OGLUtils::LinkProgram(defaultVShader, defaultFShader);
-
-    glDeleteShader(defaultVShader);
-    glDeleteShader(defaultFShader);
-
-    OGLProgram* defaultProgram = eXl_NEW OGLProgram(defaultProgramId);
+    OGLProgram* defaultProgram = eXl_NEW OGLProgram(CompileAndLink(defaultVS, linePS));
 
     OGLProgramInterface lineTechDesc;
     lineTechDesc.AddAttrib(OGLBaseAlgo::GetPosAttrib());
@@ -279,9 +337,6 @@ namespace eXl
     lineTechDesc.AddUniform(OGLLineAlgo::GetColor());
 
     return lineTechDesc.Compile(iSemantics, defaultProgram);
-#else
-    return nullptr;
-#endif
   }
 
   UniformName OGLLineAlgo::GetColor()
@@ -15,6 +15,24 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 namespace eXl
 {
+  namespace
+  {
+    bool s_Headless = false;
+  }
+
+  void OGLUtils::SetHeadless(bool iHeadless)
+  {
+    s_Headless = iHeadless;
+  }
+
+  bool OGLUtils::IsHeadless()
+  {
+#ifdef EXL_WITH_OGL
+    return s_Headless;
+#else
+    return true;
+#endif
+  }
 
   void OGLUtils::Init()
   {
@@ -23,7 +41,10 @@ namespace eXl
     {
 #ifdef EXL_WITH_OGL
 #ifndef __ANDROID__
-      glewInit();
+      if (!s_Headless)
+      {
+        glewInit();
+      }
 #endif
 #endif
 
@@ -36,6 +57,10 @@ namespace eXl
   void OGLUtils::CheckOGLState(char const* iFile, int iLine)
   {
 #ifdef EXL_WITH_OGL
+    if (s_Headless)
+    {
+      return;
+    }
     GLenum error;
     while((error = glGetError()) != GL_NO_ERROR)
     {
@@ -66,7 +91,7 @@ namespace eXl
   {
     uint32_t shaderName = 0;
 #ifdef EXL_WITH_OGL
-    if(iSource != NULL)
+    if(iSource != NULL && !s_Headless)
     {
       shaderName = glCreateShader(iType);
       if(shaderName != 0)
@@ -102,7 +127,7 @@ namespace eXl
   {
     uint32_t progName = 0;
 #ifdef EXL_WITH_OGL
-    if(iVS != 0 && iPS != 0)
+    if(iVS != 0 && iPS != 0 && !s_Headless)
     {
       progName = glCreateProgram();
       glAttachShader(progName,iVS);
@@ -13,6 +13,8 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <ogl/renderer/oglinclude.hpp>
 #include <ogl/renderer/ogltypesconv.hpp>
 
+#include <cstring>
+
 namespace eXl
 {
   IMPLEMENT_RefC(OGLBuffer);
@@ -24,82 +26,108 @@ namespace eXl
   OGLBuffer* OGLBuffer::CreateBuffer(OGLBufferUsage iUsage, size_t iSize, void* iData)
   {
 #ifdef EXL_WITH_OGL
-    GLenum glUsage = GetGLUsage(iUsage);
-    GLuint newBufferId;
-    glGenBuffers(1,&newBufferId);
-    if(newBufferId != 0)
+    if (!OGLUtils::IsHeadless())
     {
-      glBindBuffer(glUsage,newBufferId);
-      while(GL_NO_ERROR != glGetError()){}
+      GLenum glUsage = GetGLUsage(iUsage);
+      GLuint newBufferId;
+      glGenBuffers(1,&newBufferId);
+      if(newBufferId != 0)
+      {
+        glBindBuffer(glUsage,newBufferId);
+        while(GL_NO_ERROR != glGetError()){}
       
-      glBufferData(glUsage,iSize,iData,GL_STATIC_DRAW);
+        glBufferData(glUsage,iSize,iData,GL_STATIC_DRAW);
 
-      GLenum error = glGetError();
-      if(error == GL_NO_ERROR)
-      {
-        OGLBuffer* newBuffer = eXl_NEW OGLBuffer;
+        GLenum error = glGetError();
+        if(error == GL_NO_ERROR)
+        {
+          OGLBuffer* newBuffer = eXl_NEW OGLBuffer;
 
-        newBuffer->m_Id = newBufferId;
-        newBuffer->m_Size = iSize;
-        newBuffer->m_Usage = iUsage;
+          newBuffer->m_Id = newBufferId;
+          newBuffer->m_Size = iSize;
+          newBuffer->m_Usage = iUsage;
 
-        return newBuffer;
+          return newBuffer;
+        }
       }
+      return nullptr;
     }
 #endif
-    return nullptr;
+    OGLBuffer* newBuffer = eXl_NEW OGLBuffer;
+    newBuffer->m_Size = iSize;
+    newBuffer->m_Usage = iUsage;
+    newBuffer->m_Shadow.resize(iSize);
+    if (iData != nullptr)
+    {
+      memcpy(newBuffer->m_Shadow.data(), iData, iSize);
+    }
+    return newBuffer;
   }
 
   void OGLBuffer::SetData(size_t iOffset, size_t iSize, void* iData)
   {
 #ifdef EXL_WITH_OGL
-    GLenum glUsage = GetGLUsage(m_Usage);
-    glBindBuffer(glUsage,m_Id);
-    glBufferSubData(glUsage,iOffset,iSize,iData);
+    if (m_Id != 0)
+    {
+      GLenum glUsage = GetGLUsage(m_Usage);
+      glBindBuffer(glUsage,m_Id);
+      glBufferSubData(glUsage,iOffset,iSize,iData);
+      return;
+    }
 #endif
+    eXl_ASSERT_REPAIR_RET(iOffset + iSize <= m_Shadow.size(), );
+    memcpy(m_Shadow.data() + iOffset, iData, iSize);
   }
 
   void* OGLBuffer::MapBuffer(OGLBufferAccess iAccess)
   {
 #ifdef EXL_WITH_OGL
-    GLenum glUsage = GetGLUsage(m_Usage);
-    GLenum glAccess = GetGLAccess(iAccess);
+    if (m_Id != 0)
+    {
+      GLenum glUsage = GetGLUsage(m_Usage);
+      GLenum glAccess = GetGLAccess(iAccess);
 #ifndef __ANDROID__
-    glBindBuffer(glUsage,GetBufferId());
-    return glMapBuffer(glUsage,glAccess);
+      glBindBuffer(glUsage,GetBufferId());
+      return glMapBuffer(glUsage,glAccess);
 #else
       //return glMapBufferOES(GL_ARRAY_BUFFER,GL_WRITE_ONLY_OES);
-    if(GetBufferSize() > s_TempBufferSize)
-    {
-      s_TempBuffer = realloc(s_TempBuffer,GetBufferSize());
-    }
-    return s_TempBuffer;
+      if(GetBufferSize() > s_TempBufferSize)
+      {
+        s_TempBuffer = realloc(s_TempBuffer,GetBufferSize());
+      }
+      return s_TempBuffer;
 #endif
-#else
-    return nullptr;
+    }
 #endif
+    return m_Shadow.data();
   }
 
   void OGLBuffer::UnmapBuffer()
   {
 #ifdef EXL_WITH_OGL
-    GLenum glUsage = GetGLUsage(m_Usage);
+    if (m_Id != 0)
+    {
+      GLenum glUsage = GetGLUsage(m_Usage);
 #ifndef __ANDROID__
-    glBindBuffer(glUsage,m_Id);
-    glUnmapBuffer(glUsage);
+      glBindBuffer(glUsage,m_Id);
+      glUnmapBuffer(glUsage);
 #else
-    //glUnmapBufferOES(GL_ARRAY_BUFFER);
-    glBindBuffer(glUsage,GetBufferId());
-    glBufferSubData(glUsage,0,GetBufferSize(),s_TempBuffer);
+      //glUnmapBufferOES(GL_ARRAY_BUFFER);
+      glBindBuffer(glUsage,GetBufferId());
+      glBufferSubData(glUsage,0,GetBufferSize(),s_TempBuffer);
 #endif
-    CHECKOGL();
+      CHECKOGL();
+    }
 #endif
   }
 
   OGLBuffer::~OGLBuffer()
   {
 #ifdef EXL_WITH_OGL
-    glDeleteBuffers(1,&m_Id);
+    if (m_Id != 0)
+    {
+      glDeleteBuffers(1,&m_Id);
+    }
 #endif
   }
 
@@ -18,6 +18,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <core/type/dynobject.hpp>
 #include <ogl/renderer/oglinclude.hpp>
 #include <ogl/renderer/ogltypesconv.hpp>
+#include <ogl/oglutils.hpp>
 
 #include <boost/container/flat_set.hpp>
 #include <boost/container/flat_map.hpp>
@@ -260,189 +261,226 @@ namespace eXl
   OGLCompiledProgram* OGLProgramInterface::Compile(OGLSemanticManager& iManager, OGLProgram const* iProg)
   { 
 #ifdef EXL_WITH_OGL
-    if(iProg == nullptr)
-      return nullptr;
+    if (!OGLUtils::IsHeadless())
+    {
+      if(iProg == nullptr)
+        return nullptr;
 
-    OGLCompiledProgram tempTech;
+      OGLCompiledProgram tempTech;
 
-    for(uint32_t i = 0; i<m_AttribNames.size(); ++i)
-    {
-      std::optional<uint32_t> attribSlot = iManager.GetSlotForName(m_AttribNames[i]);
-      eXl_ASSERT_MSG_REPAIR_BEGIN(attribSlot.has_value(), "Invalid attribute")
-      {
-        continue;
-      }
-      OGLAttribDesc const& attrib = iManager.GetAttrib(*attribSlot);
-      eXl_ASSERT_MSG(!attrib.m_Name.empty(),"Wrong attrib name");
+      for(uint32_t i = 0; i<m_AttribNames.size(); ++i)
       {
-        int loc = iProg->GetAttribLocation(attrib.m_Name);
-        if(loc > -1)
+        std::optional<uint32_t> attribSlot = iManager.GetSlotForName(m_AttribNames[i]);
+        eXl_ASSERT_MSG_REPAIR_BEGIN(attribSlot.has_value(), "Invalid attribute")
         {
-          OGLType oType;
-          uint32_t oNum;
-          iProg->GetAttribDescription(attrib.m_Name,oType,oNum);
-          //Pas ncessaire selon OGL
-          //eXl_ASSERT_MSG(oType == attrib.m_Type /*&& oNum == attrib.m_Mult*/,"Incompatible layout");
-          if(oType == attrib.m_Type && tempTech.m_MaxAttrib < 16)
+          continue;
+        }
+        OGLAttribDesc const& attrib = iManager.GetAttrib(*attribSlot);
+        eXl_ASSERT_MSG(!attrib.m_Name.empty(),"Wrong attrib name");
+        {
+          int loc = iProg->GetAttribLocation(attrib.m_Name);
+          if(loc > -1)
           {
-            tempTech.m_AttribSlot[tempTech.m_MaxAttrib] = *attribSlot;
-            tempTech.m_AttribDesc[tempTech.m_MaxAttrib].attribLoc = loc;
-            tempTech.m_AttribDesc[tempTech.m_MaxAttrib].attribType = oType;
-            tempTech.m_AttribDesc[tempTech.m_MaxAttrib].attribDivisor = attrib.m_Divisor;
-            tempTech.m_MaxAttrib++;
+            OGLType oType;
+            uint32_t oNum;
+            iProg->GetAttribDescription(attrib.m_Name,oType,oNum);
+            //Pas ncessaire selon OGL
+            //eXl_ASSERT_MSG(oType == attrib.m_Type /*&& oNum == attrib.m_Mult*/,"Incompatible layout");
+            if(oType == attrib.m_Type && tempTech.m_MaxAttrib < 16)
+            {
+              tempTech.m_AttribSlot[tempTech.m_MaxAttrib] = *attribSlot;
+              tempTech.m_AttribDesc[tempTech.m_MaxAttrib].attribLoc = loc;
+              tempTech.m_AttribDesc[tempTech.m_MaxAttrib].attribType = oType;
+              tempTech.m_AttribDesc[tempTech.m_MaxAttrib].attribDivisor = attrib.m_Divisor;
+              tempTech.m_MaxAttrib++;
+            }
           }
         }
       }
-    }
 
-    OGLDataHandlerProgData* progData = nullptr;
+      OGLDataHandlerProgData* progData = nullptr;
 
-    std::vector<FieldsList> oList;
-
-    for(uint32_t i = 0; i<m_UnifNames.size(); ++i)
-    {
-      oList.clear();
+      std::vector<FieldsList> oList;
 
-      std::optional<uint32_t> uniformSlot = iManager.GetSlotForName(m_UnifNames[i]);
-      eXl_ASSERT_MSG_REPAIR_BEGIN(uniformSlot.has_value(), "Invalid Uniform")
+      for(uint32_t i = 0; i<m_UnifNames.size(); ++i)
       {
-        continue;
-      }
+        oList.clear();
+
+        std::optional<uint32_t> uniformSlot = iManager.GetSlotForName(m_UnifNames[i]);
+        eXl_ASSERT_MSG_REPAIR_BEGIN(uniformSlot.has_value(), "Invalid Uniform")
+        {
+          continue;
+        }
 
-      TupleType const* dataType = iManager.GetDataType(*uniformSlot);
-      eXl_ASSERT_MSG(dataType != nullptr, "Wrong data name");
+        TupleType const* dataType = iManager.GetDataType(*uniformSlot);
+        eXl_ASSERT_MSG(dataType != nullptr, "Wrong data name");
 
-      AString const* dataName = iManager.GetDataName(*uniformSlot);
-      eXl_ASSERT(dataName != nullptr);
+        AString const* dataName = iManager.GetDataName(*uniformSlot);
+        eXl_ASSERT(dataName != nullptr);
 
-      uint32_t unifSize;
-      if (iProg->GetUniformBlockDescription(*dataName, unifSize))
-      {
-        uint32_t currentSlot = tempTech.m_MaxUnifBlock;
-        eXl_ASSERT(unifSize == dataType->GetSize());
+        uint32_t unifSize;
+        if (iProg->GetUniformBlockDescription(*dataName, unifSize))
+        {
+          uint32_t currentSlot = tempTech.m_MaxUnifBlock;
+          eXl_ASSERT(unifSize == dataType->GetSize());
 
-        tempTech.m_TechData.m_BlockHandler[currentSlot] = std::make_pair(iProg->GetUniformBlockLocation(*dataName), unifSize);
+          tempTech.m_TechData.m_BlockHandler[currentSlot] = std::make_pair(iProg->GetUniformBlockLocation(*dataName), unifSize);
 
-        tempTech.m_UnifBlockSlot[currentSlot] = *uniformSlot;
-        ++tempTech.m_MaxUnifBlock;
-        continue;
-      }
+          tempTech.m_UnifBlockSlot[currentSlot] = *uniformSlot;
+          ++tempTech.m_MaxUnifBlock;
+          continue;
+        }
       
-      uint32_t currentSlot = tempTech.m_MaxUnif;
-      if(tempTech.m_MaxUnif < 16)
-      {
-        ListLeavesField(dataType, oList);
-
-        for(uint32_t j = 0; j < oList.size(); ++j)
+        uint32_t currentSlot = tempTech.m_MaxUnif;
+        if(tempTech.m_MaxUnif < 16)
         {
-          AString unifName = StringUtil::ToASCII(oList[j].m_Name);
-          int loc = iProg->GetUniformLocation(unifName);
-          //eXl_ASSERT_MSG(loc != -1, "Missing location");
-          //LOG_INFO << "Uniform " << unifName << " to loc " << loc << "\n";
-          if(loc != -1)
-          {
-            OGLType progType;
-            uint32_t progNum;
-            iProg->GetUniformDescription(unifName,progType,progNum);
-            GLenum oType;
-            s_TypeMap.GetType(oList[j].m_Type,oType);
+          ListLeavesField(dataType, oList);
 
-            if(GetGLType(progType) == oType && progNum == oList[j].m_Multi)
+          for(uint32_t j = 0; j < oList.size(); ++j)
+          {
+            AString unifName = StringUtil::ToASCII(oList[j].m_Name);
+            int loc = iProg->GetUniformLocation(unifName);
+            //eXl_ASSERT_MSG(loc != -1, "Missing location");
+            //LOG_INFO << "Uniform " << unifName << " to loc " << loc << "\n";
+            if(loc != -1)
             {
-              OGLDataHandlerProgData::SetValuefptr setter = s_SetterMap.FindSetter(oType);
-              OGLDataHandlerProgData::DataSetter setterStruct;
-              setterStruct.count = oList[j].m_Multi;
-              setterStruct.location = loc;
-              setterStruct.offset = oList[j].m_Offset;
-              setterStruct.setter = setter;
-              tempTech.m_TechData.m_UnifHandler[currentSlot].push_back(setterStruct);
+              OGLType progType;
+              uint32_t progNum;
+              iProg->GetUniformDescription(unifName,progType,progNum);
+              GLenum oType;
+              s_TypeMap.GetType(oList[j].m_Type,oType);
+
+              if(GetGLType(progType) == oType && progNum == oList[j].m_Multi)
+              {
+                OGLDataHandlerProgData::SetValuefptr setter = s_SetterMap.FindSetter(oType);
+                OGLDataHandlerProgData::DataSetter setterStruct;
+                setterStruct.count = oList[j].m_Multi;
+                setterStruct.location = loc;
+                setterStruct.offset = oList[j].m_Offset;
+                setterStruct.setter = setter;
+                tempTech.m_TechData.m_UnifHandler[currentSlot].push_back(setterStruct);
+              }
             }
           }
-        }
-        if(tempTech.m_TechData.m_UnifHandler[currentSlot].size() > 0)
-        {
-          tempTech.m_UnifSlot[currentSlot] = *uniformSlot;
-          tempTech.m_MaxUnif++;
+          if(tempTech.m_TechData.m_UnifHandler[currentSlot].size() > 0)
+          {
+            tempTech.m_UnifSlot[currentSlot] = *uniformSlot;
+            tempTech.m_MaxUnif++;
+          }
         }
       }
-    }
 
-    for(uint32_t i = 0; i<m_Textures.size(); ++i)
-    {
-      if(tempTech.m_MaxTexture < 8)
+      for(uint32_t i = 0; i<m_Textures.size(); ++i)
       {
-        std::optional<uint32_t> textureSlot = iManager.GetSlotForName(m_Textures[i]);
-        eXl_ASSERT_MSG_REPAIR_BEGIN(textureSlot.has_value(), "Invalid Texture")
+        if(tempTech.m_MaxTexture < 8)
         {
-          continue;
-        }
-
-        uint32_t currentTexSlot = tempTech.m_MaxTexture;
-        OGLSamplerDesc const& sampler = iManager.GetSampler(*textureSlot);
-        if(!sampler.name.empty())
-        {
-          int texLoc = iProg->GetUniformLocation(sampler.name);
-          if(texLoc >= 0)
+          std::optional<uint32_t> textureSlot = iManager.GetSlotForName(m_Textures[i]);
+          eXl_ASSERT_MSG_REPAIR_BEGIN(textureSlot.has_value(), "Invalid Texture")
           {
-            OGLType oType;
-            uint32_t oNum;
-            iProg->GetUniformDescription(sampler.name,oType,oNum);
+            continue;
+          }
 
-            if(IsSampler(oType))
+          uint32_t currentTexSlot = tempTech.m_MaxTexture;
+          OGLSamplerDesc const& sampler = iManager.GetSampler(*textureSlot);
+          if(!sampler.name.empty())
+          {
+            int texLoc = iProg->GetUniformLocation(sampler.name);
+            if(texLoc >= 0)
             {
-              if (GetSamplerTextureType(oType) != sampler.samplerType)
+              OGLType oType;
+              uint32_t oNum;
+              iProg->GetUniformDescription(sampler.name,oType,oNum);
+
+              if(IsSampler(oType))
               {
-                LOG_ERROR << "Wrong type for texture." << "\n";
-                continue;
+                if (GetSamplerTextureType(oType) != sampler.samplerType)
+                {
+                  LOG_ERROR << "Wrong type for texture." << "\n";
+                  continue;
+                }
+                tempTech.m_TechData.m_Samplers[currentTexSlot].first = texLoc;
+                tempTech.m_TechData.m_Samplers[currentTexSlot].second.samplerType = sampler.samplerType;
+                tempTech.m_TechData.m_Samplers[currentTexSlot].second.maxFilter = sampler.maxFilter;
+                tempTech.m_TechData.m_Samplers[currentTexSlot].second.minFilter = sampler.minFilter;
+                tempTech.m_TechData.m_Samplers[currentTexSlot].second.wrapX = sampler.wrapX;
+                tempTech.m_TechData.m_Samplers[currentTexSlot].second.wrapY = sampler.wrapY;
+                tempTech.m_TexSlot[currentTexSlot] = *textureSlot;
+                tempTech.m_MaxTexture++;
               }
-              tempTech.m_TechData.m_Samplers[currentTexSlot].first = texLoc;
-              tempTech.m_TechData.m_Samplers[currentTexSlot].second.samplerType = sampler.samplerType;
-              tempTech.m_TechData.m_Samplers[currentTexSlot].second.maxFilter = sampler.maxFilter;
-              tempTech.m_TechData.m_Samplers[currentTexSlot].second.minFilter = sampler.minFilter;
-              tempTech.m_TechData.m_Samplers[currentTexSlot].second.wrapX = sampler.wrapX;
-              tempTech.m_TechData.m_Samplers[currentTexSlot].second.wrapY = sampler.wrapY;
-              tempTech.m_TexSlot[currentTexSlot] = *textureSlot;
-              tempTech.m_MaxTexture++;
             }
           }
         }
       }
-    }
 
-    OGLCompiledProgram* newTech = eXl_NEW OGLCompiledProgram;
+      OGLCompiledProgram* newTech = eXl_NEW OGLCompiledProgram;
 
-    newTech->m_Program = iProg;
-    newTech->m_MaxAttrib = tempTech.m_MaxAttrib;
-    newTech->m_MaxUnif = tempTech.m_MaxUnif;
-    newTech->m_MaxUnifBlock = tempTech.m_MaxUnifBlock;
-    newTech->m_MaxTexture = tempTech.m_MaxTexture;
+      newTech->m_Program = iProg;
+      newTech->m_MaxAttrib = tempTech.m_MaxAttrib;
+      newTech->m_MaxUnif = tempTech.m_MaxUnif;
+      newTech->m_MaxUnifBlock = tempTech.m_MaxUnifBlock;
+      newTech->m_MaxTexture = tempTech.m_MaxTexture;
     
-    std::copy(tempTech.m_AttribDesc, tempTech.m_AttribDesc + tempTech.m_MaxAttrib, newTech->m_AttribDesc);
-    std::copy(tempTech.m_AttribSlot, tempTech.m_AttribSlot + tempTech.m_MaxAttrib, newTech->m_AttribSlot);
-    std::copy(tempTech.m_TexSlot, tempTech.m_TexSlot + tempTech.m_MaxTexture, newTech->m_TexSlot);
+      std::copy(tempTech.m_AttribDesc, tempTech.m_AttribDesc + tempTech.m_MaxAttrib, newTech->m_AttribDesc);
+      std::copy(tempTech.m_AttribSlot, tempTech.m_AttribSlot + tempTech.m_MaxAttrib, newTech->m_AttribSlot);
+      std::copy(tempTech.m_TexSlot, tempTech.m_TexSlot + tempTech.m_MaxTexture, newTech->m_TexSlot);
 
-    for(uint32_t i = 0; i<tempTech.m_MaxTexture; ++i)
-    {
-      newTech->m_TechData.m_Samplers[i] = tempTech.m_TechData.m_Samplers[i];
-    }
+      for(uint32_t i = 0; i<tempTech.m_MaxTexture; ++i)
+      {
+        newTech->m_TechData.m_Samplers[i] = tempTech.m_TechData.m_Samplers[i];
+      }
 
-    std::copy(tempTech.m_UnifSlot, tempTech.m_UnifSlot + tempTech.m_MaxUnif, newTech->m_UnifSlot);
+      std::copy(tempTech.m_UnifSlot, tempTech.m_UnifSlot + tempTech.m_MaxUnif, newTech->m_UnifSlot);
     
-    for(uint32_t i = 0; i < tempTech.m_MaxUnif; ++i)
+      for(uint32_t i = 0; i < tempTech.m_MaxUnif; ++i)
+      {
+        newTech->m_TechData.m_UnifHandler[i] = std::move(tempTech.m_TechData.m_UnifHandler[i]);
+      }
+
+      std::copy(tempTech.m_UnifBlockSlot, tempTech.m_UnifBlockSlot + tempTech.m_MaxUnifBlock, newTech->m_UnifBlockSlot);
+
+      for (uint32_t i = 0; i < tempTech.m_MaxUnifBlock; ++i)
+      {
+        newTech->m_TechData.m_BlockHandler[i] = tempTech.m_TechData.m_BlockHandler[i];
+      }
+
+      return newTech;
+    }
+#endif
+    // Headless, no program to introspect: every declared name gets a slot so the program can still drive a render context.
+    OGLCompiledProgram* newTech = eXl_NEW OGLCompiledProgram;
+    newTech->m_Program = iProg;
+
+    for (auto const& name : m_AttribNames)
     {
-      newTech->m_TechData.m_UnifHandler[i] = std::move(tempTech.m_TechData.m_UnifHandler[i]);
+      if (newTech->m_MaxAttrib < 16)
+      {
+        uint32_t attribSlot = iManager.GetSlotForName(name);
+        OGLAttribDesc const& attrib = iManager.GetAttrib(attribSlot);
+        newTech->m_AttribSlot[newTech->m_MaxAttrib] = attribSlot;
+        newTech->m_AttribDesc[newTech->m_MaxAttrib].attribLoc = newTech->m_MaxAttrib;
+        newTech->m_AttribDesc[newTech->m_MaxAttrib].attribType = attrib.m_Type;
+        newTech->m_AttribDesc[newTech->m_MaxAttrib].attribDivisor = attrib.m_Divisor;
+        newTech->m_MaxAttrib++;
+      }
     }
 
-    std::copy(tempTech.m_UnifBlockSlot, tempTech.m_UnifBlockSlot + tempTech.m_MaxUnifBlock, newTech->m_UnifBlockSlot);
+    for (auto const& name : m_UnifNames)
+    {
+      if (newTech->m_MaxUnif < 16)
+      {
+        newTech->m_UnifSlot[newTech->m_MaxUnif++] = iManager.GetSlotForName(name);
+      }
+    }
 
-    for (uint32_t i = 0; i < tempTech.m_MaxUnifBlock; ++i)
+    for (auto const& name : m_Textures)
     {
-      newTech->m_TechData.m_BlockHandler[i] = tempTech.m_TechData.m_BlockHandler[i];
+      if (newTech->m_MaxTexture < 8)
+      {
+        newTech->m_TexSlot[newTech->m_MaxTexture++] = iManager.GetSlotForName(name);
+      }
     }
 
     return newTech;
-#endif
-    return nullptr;
   }
 
   OGLCompiledProgram::OGLCompiledProgram()
@@ -452,7 +490,7 @@ namespace eXl
   OGLCompiledProgram::~OGLCompiledProgram()
   {
 #ifdef EXL_WITH_OGL
-    if (m_Program)
+    if (m_Program && m_Program->GetProgName() != 0)
     {
       glDeleteProgram(m_Program->GetProgName());
     }
@@ -10,6 +10,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 #include <ogl/renderer/ogldisplaylist.hpp>
 #include <ogl/renderer/oglrendercontext.hpp>
+#include <ogl/renderer/oglrecordingcontext.hpp>
 #include <ogl/renderer/oglinclude.hpp>
 #include <ogl/renderer/oglsemanticmanager.hpp>
 #include <ogl/renderer/oglshaderdata.hpp>
@@ -18,10 +19,11 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <ogl/renderer/ogltypesconv.hpp>
 
 #include <algorithm>
+#include <cstring>
 
 namespace eXl
 {
-  void OGLDepthCommand::Apply()
+  void OGLDepthCommand::Apply() const
   {
 #ifdef EXL_WITH_OGL
     if(m_Flag & ReadZ)
@@ -45,7 +47,7 @@ namespace eXl
 #endif
   }
 
-  void OGLScissorCommand::Apply()
+  void OGLScissorCommand::Apply() const
   {
 #ifdef EXL_WITH_OGL
     if(m_Flag & EnableScissor)
@@ -60,14 +62,14 @@ namespace eXl
 #endif
   }
 
-  void OGLViewportCommand::Apply()
+  void OGLViewportCommand::Apply() const
   {
 #ifdef EXL_WITH_OGL
     glViewport(m_Orig.x,m_Orig.y, m_Size.x,m_Size.y);
 #endif
   }
 
-  void OGLBlendCommand::Apply()
+  void OGLBlendCommand::Apply() const
   {
 #ifdef EXL_WITH_OGL
     if (m_Flag & Enabled)
@@ -82,11 +84,21 @@ namespace eXl
 #endif
   }
 
+  namespace
+  {
+    inline uint32_t HashDataSet(OGLShaderData const* iData, uint32_t iPrevSet)
+    {
+      uint64_t value = uint64_t(uintptr_t(iData)) * 0x9E3779B97F4A7C15ull;
+      value ^= (uint64_t(iPrevSet) + 1) * 0xC2B2AE3D27D4EB4Full;
+      return uint32_t(value >> 32);
+    }
+  }
+
   OGLDisplayList::OGLDisplayList(OGLSemanticManager& iSemantics)
     : m_Semantics(iSemantics)
   {
-    m_DataSetSeek.reserve(1024);
     m_DataSetStore.reserve(1024);
+    m_DataSetTable.resize(2048, -1);
   }
 
   void OGLDisplayList::InitForPush()
@@ -94,14 +106,235 @@ namespace eXl
     m_CurDataSet = -1;
     m_CurAssembly = nullptr;
     m_CurProgram = nullptr;
-    m_DataSetSeek.clear();
+    m_PendingDraws.clear();
     m_DataSetStore.clear();
+    std::fill(m_DataSetTable.begin(), m_DataSetTable.end(), -1);
     m_Commands.clear();
     m_Keys.clear();
 
     m_States.InitForPush();
   }
 
+  uint32_t OGLDisplayList::FindOrAddDataSet(OGLShaderData const* iData, uint32_t iPrevSet)
+  {
+    uint32_t const mask = m_DataSetTable.size() - 1;
+    uint32_t slot = HashDataSet(iData, iPrevSet) & mask;
+    while (m_DataSetTable[slot] != -1)
+    {
+      OGLShaderDataSet const& curSet = m_DataSetStore[m_DataSetTable[slot]];
+      if (curSet.m_AdditionalData == iData && curSet.m_PrevSet == iPrevSet)
+      {
+        return curSet.m_Id;
+      }
+      slot = (slot + 1) & mask;
+    }
+
+    uint32_t const newId = m_DataSetStore.size();
+    OGLShaderDataSet newSet(iData, iPrevSet != -1 ? &m_DataSetStore[iPrevSet] : nullptr, newId);
+    m_DataSetStore.push_back(newSet);
+    m_DataSetTable[slot] = newId;
+
+    if (m_DataSetStore.size() * 2 > m_DataSetTable.size())
+    {
+      GrowDataSetTable();
+    }
+
+    return newId;
+  }
+
+  void OGLDisplayList::GrowDataSetTable()
+  {
+    m_DataSetTable.assign(m_DataSetTable.size() * 2, -1);
+    uint32_t const mask = m_DataSetTable.size() - 1;
+    for (OGLShaderDataSet const& curSet : m_DataSetStore)
+    {
+      uint32_t slot = HashDataSet(curSet.m_AdditionalData, curSet.m_PrevSet) & mask;
+      while (m_DataSetTable[slot] != -1)
+      {
+        slot = (slot + 1) & mask;
+      }
+      m_DataSetTable[slot] = curSet.m_Id;
+    }
+  }
+
+  void OGLDisplayList::SortKeys()
+  {
+    size_t const numKeys = m_Keys.size();
+    if (numKeys < 256)
+    {
+      std::stable_sort(m_Keys.begin(), m_Keys.end());
+      return;
+    }
+
+    // LSD radix sort, one byte per pass. All the histograms are built in a single read.
+    uint32_t histograms[8][256];
+    memset(histograms, 0, sizeof(histograms));
+    for (CommandKey const& key : m_Keys)
+    {
+      for (uint32_t pass = 0; pass < 8; ++pass)
+      {
+        ++histograms[pass][(key.m_Key >> (pass * 8)) & 0xFF];
+      }
+    }
+
+    m_SortScratch.resize(numKeys);
+    CommandKey* src = m_Keys.data();
+    CommandKey* dst = m_SortScratch.data();
+    for (uint32_t pass = 0; pass < 8; ++pass)
+    {
+      uint32_t* histogram = histograms[pass];
+      uint32_t const shift = pass * 8;
+      // Most bytes of the state and data hash are shared by all the keys.
+      if (histogram[(src[0].m_Key >> shift) & 0xFF] == numKeys)
+      {
+        continue;
+      }
+
+      uint32_t offset = 0;
+      for (uint32_t i = 0; i < 256; ++i)
+      {
+        uint32_t const count = histogram[i];
+        histogram[i] = offset;
+        offset += count;
+      }
+
+      for (size_t i = 0; i < numKeys; ++i)
+      {
+        dst[histogram[(src[i].m_Key >> shift) & 0xFF]++] = src[i];
+      }
+      std::swap(src, dst);
+    }
+
+    if (src != m_Keys.data())
+    {
+      m_Keys.swap(m_SortScratch);
+    }
+  }
+
+  void OGLDisplayList::InitSubList(OGLDisplayList& oSubList)
+  {
+    eXl_ASSERT(&oSubList.m_Semantics == &m_Semantics);
+    eXl_ASSERT(&oSubList != this);
+
+    oSubList.InitForPush();
+    oSubList.m_States.InheritCommands(m_States);
+    oSubList.m_CurProgram = oSubList.m_InheritedProgram = m_CurProgram;
+    oSubList.m_CurAssembly = oSubList.m_InheritedAssembly = m_CurAssembly;
+
+    // Replay the data stack, Merge maps it back to the sets of this list.
+    Vector<OGLShaderData const*>& dataStack = oSubList.m_InheritedData;
+    dataStack.clear();
+    for (uint32_t setId = m_CurDataSet; setId != -1; setId = m_DataSetStore[setId].m_PrevSet)
+    {
+      dataStack.push_back(m_DataSetStore[setId].m_AdditionalData);
+    }
+    std::reverse(dataStack.begin(), dataStack.end());
+    for (OGLShaderData const* data : dataStack)
+    {
+      oSubList.PushData(data);
+    }
+  }
+
+  bool OGLDisplayList::IsSubListCurrent(OGLDisplayList& iSubList)
+  {
+    if (&iSubList.m_Semantics != &m_Semantics
+      || iSubList.m_InheritedProgram != m_CurProgram
+      || iSubList.m_InheritedAssembly != m_CurAssembly)
+    {
+      return false;
+    }
+
+    // Walk the data stack from the top.
+    auto iter = iSubList.m_InheritedData.rbegin();
+    for (uint32_t setId = m_CurDataSet; setId != -1; setId = m_DataSetStore[setId].m_PrevSet, ++iter)
+    {
+      if (iter == iSubList.m_InheritedData.rend() || *iter != m_DataSetStore[setId].m_AdditionalData)
+      {
+        return false;
+      }
+    }
+    if (iter != iSubList.m_InheritedData.rend())
+    {
+      return false;
+    }
+
+    return iSubList.m_States.HasInheritedCommands(m_States);
+  }
+
+  void OGLDisplayList::Merge(OGLDisplayList& iSubList)
+  {
+    eXl_ASSERT(&iSubList.m_Semantics == &m_Semantics);
+    eXl_ASSERT(&iSubList != this);
+
+    FlushDraws();
+    iSubList.FlushDraws();
+
+    // Sets are stored after their parent, and in push order.
+    m_DataSetRemap.resize(iSubList.m_DataSetStore.size());
+    for (OGLShaderDataSet const& subSet : iSubList.m_DataSetStore)
+    {
+      uint32_t const prevSet = subSet.m_PrevSet != -1 ? m_DataSetRemap[subSet.m_PrevSet] : -1;
+      m_DataSetRemap[subSet.m_Id] = FindOrAddDataSet(subSet.m_AdditionalData, prevSet);
+    }
+
+    // States are registered on first use, the way they would have been when pushing to this list.
+    m_StateRemap.assign(iSubList.m_States.GetNumStates(), 0xFFFF);
+    auto remapState = [&](uint16_t iStateId)
+    {
+      uint16_t& newId = m_StateRemap[iStateId];
+      if (newId == 0xFFFF)
+      {
+        newId = m_States.ImportState(iSubList.m_States, iStateId);
+      }
+      return newId;
+    };
+
+    size_t const baseOffset = m_Commands.size();
+    m_Commands.insert(m_Commands.end(), iSubList.m_Commands.begin(), iSubList.m_Commands.end());
+    m_Keys.reserve(m_Keys.size() + iSubList.m_Keys.size());
+
+    for (CommandKey const& subKey : iSubList.m_Keys)
+    {
+      CommandKey newKey;
+      newKey.m_Offset = baseOffset + subKey.m_Offset;
+      newKey.m_Key = subKey.m_Key;
+
+      uint8_t* curCmd = &m_Commands[newKey.m_Offset];
+      eXl_ASSERT(((*curCmd & OGLRenderCommand::Mask) >> OGLRenderCommand::Shift) == OGLRenderCommand::DrawCommand);
+      if ((*curCmd & OGLDraw::MaskDraw) == OGLDraw::Clear)
+      {
+        OGLClear* clearCmd = (OGLClear*)curCmd;
+        clearCmd->m_StateId = remapState(clearCmd->m_StateId);
+      }
+      else
+      {
+        OGLDraw* drawCmd = (OGLDraw*)curCmd;
+        uint16_t const stateId = remapState(drawCmd->m_StateId);
+        drawCmd->m_StateId = stateId;
+        newKey.m_Key = (newKey.m_Key & ~(uint64_t(0xFFFF) << 32)) | uint64_t(stateId) << 32;
+
+        uint8_t* geomPtr = (uint8_t*)(drawCmd + 1);
+        uint32_t numDraws = 1;
+        if (drawCmd->m_Flags & OGLDraw::DrawGroup)
+        {
+          numDraws = *(uint32_t*)geomPtr;
+          geomPtr += sizeof(uint32_t);
+        }
+        size_t const geomSize = (drawCmd->m_Flags & OGLDraw::DrawInstanced) ? sizeof(OGLInstancedGeometry) : sizeof(OGLGeometry);
+        for (uint32_t i = 0; i < numDraws; ++i, geomPtr += geomSize)
+        {
+          OGLGeometry* geom = (OGLGeometry*)geomPtr;
+          if (geom->m_Mat != -1)
+          {
+            geom->m_Mat = m_DataSetRemap[geom->m_Mat];
+          }
+        }
+      }
+
+      m_Keys.push_back(newKey);
+    }
+  }
+
   void OGLDisplayList::SetDefaultViewport(Vec2i const& iOrig, Vec2i const& iSize)
   {
     OGLViewportCommand defCommand;
@@ -203,16 +436,7 @@ namespace eXl
   {
     eXl_ASSERT(iData != nullptr);
     //FlushDraws();
-    OGLShaderDataSet const* prevSet = m_CurDataSet != -1 ? &m_DataSetStore[m_CurDataSet] : nullptr;
-    OGLShaderDataSet curSet(iData, prevSet, static_cast<uint32_t>(m_DataSetStore.size()));
-    auto iter = m_DataSetSeek.find(curSet);
-    if(iter == m_DataSetSeek.end())
-    {
-      auto res = m_DataSetSeek.insert(curSet);
-      m_DataSetStore.push_back(curSet);
-      iter = res.first;
-    }
-    m_CurDataSet = iter->m_Id;
+    m_CurDataSet = FindOrAddDataSet(iData, m_CurDataSet);
   }
 
   void OGLDisplayList::PopData()
@@ -435,16 +659,6 @@ namespace eXl
     m_PendingDraws.push_back(newDraw);
   }
 
-  void OGLVAssembly::Apply(OGLSemanticManager const& iSemantics, OGLRenderContext* iCtx)const
-  {
-    for(uint32_t i = 0; i<m_Attribs.size(); ++i)
-    {
-      VtxAttrib const& curAttr = m_Attribs[i];
-      uint32_t slot = iSemantics.GetSlotForName(curAttr.m_AttribName);
-      iCtx->SetVertexAttrib(slot, curAttr.m_VBuffer.get(), curAttr.m_Num, curAttr.m_Stride, curAttr.m_Offset);
-    }
-  }
-
   namespace
   {
     OGLConnectivity topology [] = 
@@ -457,7 +671,8 @@ namespace eXl
     };
   }
 
-  void OGLDisplayList::HandleDataSet(OGLRenderContext* iCtx, OGLShaderDataSet const* iSet)
+  template <class Context>
+  void OGLDisplayList::HandleDataSet(Context* iCtx, OGLShaderDataSet const* iSet)
   {
     m_Timestamp++;
     while(iSet != nullptr)
@@ -523,11 +738,12 @@ namespace eXl
     }
   }
 
-  void OGLDisplayList::Render(OGLRenderContext* iCtx, OGLFramebuffer* iFBO)
+  template <class Context>
+  void OGLDisplayList::RenderImpl(Context* iCtx, OGLFramebuffer* iFBO)
   {
     FlushDraws();
-    m_States.InitForRender();
-    std::sort(m_Keys.begin(), m_Keys.end());
+    m_States.InitForRender(iCtx);
+    SortKeys();
 
     m_CurrentSetupData.clear();
     m_CurrentSetupData.resize(m_Semantics.GetNumUniforms(),DataSetup());
@@ -564,7 +780,7 @@ namespace eXl
                 OGLDraw const* drawCmd = (OGLDraw const*)curCmd;
                 if (drawCmd->m_StateId != m_States.GetCurState())
                 {
-                  m_States.ApplyCommand(drawCmd->m_StateId);
+                  m_States.ApplyCommand(drawCmd->m_StateId, iCtx);
                 }
 
                 OGLConnectivity topo = topology[drawCmd->m_Topo];
@@ -692,23 +908,13 @@ namespace eXl
               break;
             case OGLDraw::Clear:
               {
-#ifdef EXL_WITH_OGL
                 OGLClear const* clearCmd = (OGLClear const*)curCmd;
                 if (clearCmd->m_StateId != m_States.GetCurState())
                 {
-                  m_States.ApplyCommand(clearCmd->m_StateId);
-                }
-                if (clearCmd->m_Flags & OGLClear::Color)
-                {
-                  glClearColor(clearCmd->m_ClearColor.x, clearCmd->m_ClearColor.y, clearCmd->m_ClearColor.z, clearCmd->m_ClearColor.w);
-                  glClear(GL_COLOR_BUFFER_BIT);
-                }
-                if (clearCmd->m_Flags & OGLClear::Depth)
-                {
-                  glClearDepthf(clearCmd->m_ClearDepth);
-                  glClear(GL_DEPTH_BUFFER_BIT);
+                  m_States.ApplyCommand(clearCmd->m_StateId, iCtx);
                 }
-#endif
+                iCtx->ClearBuffers((clearCmd->m_Flags & OGLClear::Color) != 0, (clearCmd->m_Flags & OGLClear::Depth) != 0,
+                  clearCmd->m_ClearColor, clearCmd->m_ClearDepth);
               }
               break;
             default:
@@ -725,4 +931,14 @@ namespace eXl
 
     iCtx->Clear();
   }
+
+  void OGLDisplayList::Render(OGLRenderContext* iCtx, OGLFramebuffer* iFBO)
+  {
+    RenderImpl(iCtx, iFBO);
+  }
+
+  void OGLDisplayList::Render(OGLRecordingContext* iCtx, OGLFramebuffer* iFBO)
+  {
+    RenderImpl(iCtx, iFBO);
+  }
 }
@@ -0,0 +1,185 @@
+/*
+Copyright 2009-2021 Nicolas Colombe
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <ogl/renderer/oglrecordingcontext.hpp>
+#include <ogl/renderer/oglrendercommand.hpp>
+
+namespace eXl
+{
+  OGLRecordingContext::OGLRecordingContext(bool iRecordCommands)
+    : m_RecordCommands(iRecordCommands)
+  {
+  }
+
+  void OGLRecordingContext::Reset()
+  {
+    m_Commands.clear();
+    m_Stats = Stats();
+    m_NumDraws = 0;
+    ResetBindings();
+  }
+
+  void OGLRecordingContext::Record(Op iOp, uint32_t iSlot, void const* iObject, uint32_t iCount, uint32_t iInstances)
+  {
+    if (m_RecordCommands)
+    {
+      Command cmd = { iOp, iSlot, iObject, iCount, iInstances };
+      m_Commands.push_back(cmd);
+    }
+  }
+
+  bool OGLRecordingContext::Bind(Vector<void const*>& ioBound, uint32_t iSlot, void const* iObject)
+  {
+    if (iSlot >= ioBound.size())
+    {
+      ioBound.resize(iSlot + 1, nullptr);
+    }
+    if (ioBound[iSlot] == iObject)
+    {
+      ++m_Stats.m_RedundantBinds;
+      return false;
+    }
+    ioBound[iSlot] = iObject;
+    return true;
+  }
+
+  void OGLRecordingContext::ResetBindings()
+  {
+    m_CurProgram = nullptr;
+    m_BoundData.clear();
+    m_BoundUBO.clear();
+    m_BoundTextures.clear();
+  }
+
+  void OGLRecordingContext::Clear()
+  {
+    Record(Op::Clear, 0, nullptr);
+    ResetBindings();
+  }
+
+  void OGLRecordingContext::SetFramebuffer(OGLFramebuffer* iFBO)
+  {
+    Record(Op::SetFramebuffer, 0, iFBO);
+  }
+
+  void OGLRecordingContext::SetProgram(OGLCompiledProgram const* iProgram)
+  {
+    if (iProgram == m_CurProgram)
+    {
+      ++m_Stats.m_RedundantBinds;
+      return;
+    }
+    m_CurProgram = iProgram;
+    ++m_Stats.m_Programs;
+    Record(Op::SetProgram, 0, iProgram);
+  }
+
+  void OGLRecordingContext::SetVertexAttrib(uint32_t iAttribName, OGLBuffer const* iBuffer, uint32_t iNum, size_t iStride, size_t iOffset)
+  {
+    // The same buffer with another layout is a different binding, so these are never filtered.
+    ++m_Stats.m_VertexAttribs;
+    Record(Op::SetVertexAttrib, iAttribName, iBuffer, iNum);
+  }
+
+  void OGLRecordingContext::SetUniformData(uint32_t iDataName, void const* iData)
+  {
+    if (Bind(m_BoundData, iDataName, iData))
+    {
+      ++m_Stats.m_Uniforms;
+      Record(Op::SetUniformData, iDataName, iData);
+    }
+  }
+
+  void OGLRecordingContext::SetUniformBuffer(uint32_t iDataName, OGLBuffer const* iBuffer)
+  {
+    if (Bind(m_BoundUBO, iDataName, iBuffer))
+    {
+      ++m_Stats.m_UniformBuffers;
+      Record(Op::SetUniformBuffer, iDataName, iBuffer);
+    }
+  }
+
+  void OGLRecordingContext::SetTexture(uint32_t iTexName, OGLTexture const* iTex)
+  {
+    if (Bind(m_BoundTextures, iTexName, iTex))
+    {
+      ++m_Stats.m_Textures;
+      Record(Op::SetTexture, iTexName, iTex);
+    }
+  }
+
+  void OGLRecordingContext::SetState(OGLDepthCommand const& iCmd)
+  {
+    ++m_Stats.m_StateChanges;
+    Record(Op::SetState, DepthState, nullptr);
+  }
+
+  void OGLRecordingContext::SetState(OGLScissorCommand const& iCmd)
+  {
+    ++m_Stats.m_StateChanges;
+    Record(Op::SetState, ScissorState, nullptr);
+  }
+
+  void OGLRecordingContext::SetState(OGLViewportCommand const& iCmd)
+  {
+    ++m_Stats.m_StateChanges;
+    Record(Op::SetState, ViewportState, nullptr);
+  }
+
+  void OGLRecordingContext::SetState(OGLBlendCommand const& iCmd)
+  {
+    ++m_Stats.m_StateChanges;
+    Record(Op::SetState, BlendState, nullptr);
+  }
+
+  void OGLRecordingContext::ClearBuffers(bool iClearColor, bool iClearDepth, Vec4 const& iColor, float iDepth)
+  {
+    ++m_Stats.m_Clears;
+    Record(Op::ClearBuffers, (iClearColor ? 1 : 0) | (iClearDepth ? 2 : 0), nullptr);
+  }
+
+  void OGLRecordingContext::AddDraw(Op iOp, void const* iBuffer, uint32_t iCount, uint32_t iInstances)
+  {
+    eXl_ASSERT_MSG(m_CurProgram != nullptr, "Draw without a program");
+    ++m_NumDraws;
+    ++m_Stats.m_Draws;
+    m_Stats.m_Vertices += uint64_t(iCount) * (iInstances > 0 ? iInstances : 1);
+    m_Stats.m_Instances += iInstances;
+    Record(iOp, 0, iBuffer, iCount, iInstances);
+  }
+
+  void OGLRecordingContext::Draw(OGLConnectivity iTopo, uint32_t iFirstVertex, uint32_t iNumVertices)
+  {
+    AddDraw(Op::Draw, nullptr, iNumVertices, 0);
+  }
+
+  void OGLRecordingContext::DrawIndexed(OGLBuffer const* iBuffer, OGLConnectivity iTopo, uint32_t iOffset, uint32_t iBaseVertex, uint32_t iNumIndices)
+  {
+    AddDraw(Op::DrawIndexed, iBuffer, iNumIndices, 0);
+  }
+
+#ifndef __ANDROID__
+  void OGLRecordingContext::DrawInstanced(OGLConnectivity iTopo, uint32_t iNumInstances, uint32_t iBaseInstance, uint32_t iFirstVertex, uint32_t iNumVertices)
+#else
+  void OGLRecordingContext::DrawInstanced(OGLConnectivity iTopo, uint32_t iNumInstances, uint32_t iFirstVertex, uint32_t iNumVertices)
+#endif
+  {
+    AddDraw(Op::DrawInstanced, nullptr, iNumVertices, iNumInstances);
+  }
+
+#ifndef __ANDROID__
+  void OGLRecordingContext::DrawIndexedInstanced(OGLBuffer const* iBuffer, OGLConnectivity iTopo, uint32_t iNumInstances, uint32_t iBaseInstance, uint32_t iOffset, uint32_t iBaseVertex, uint32_t iNumIndices)
+#else
+  void OGLRecordingContext::DrawIndexedInstanced(OGLBuffer const* iBuffer, OGLConnectivity iTopo, uint32_t iNumInstances, uint32_t iOffset, uint32_t iBaseVertex, uint32_t iNumIndices)
+#endif
+  {
+    AddDraw(Op::DrawIndexedInstanced, iBuffer, iNumIndices, iNumInstances);
+  }
+}
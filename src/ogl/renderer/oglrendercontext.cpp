@@ -14,6 +14,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <ogl/renderer/oglbuffer.hpp>
 #include <ogl/renderer/oglprogram.hpp>
 #include <ogl/renderer/oglframebuffer.hpp>
+#include <ogl/renderer/oglrendercommand.hpp>
 #include <ogl/renderer/oglinclude.hpp>
 #include <ogl/renderer/ogltypesconv.hpp>
 #include <core/type/tupletype.hpp>
@@ -443,7 +444,10 @@ namespace eXl
   OGLRenderContext::~OGLRenderContext()
   {
 #ifdef EXL_WITH_OGL
-    eXl_DELETE m_Impl;
+    if (m_Impl)
+    {
+      eXl_DELETE m_Impl;
+    }
 #endif
   }
 
@@ -489,6 +493,42 @@ namespace eXl
 #endif
   }
 
+  void OGLRenderContext::SetState(OGLDepthCommand const& iCmd)
+  {
+    iCmd.Apply();
+  }
+
+  void OGLRenderContext::SetState(OGLScissorCommand const& iCmd)
+  {
+    iCmd.Apply();
+  }
+
+  void OGLRenderContext::SetState(OGLViewportCommand const& iCmd)
+  {
+    iCmd.Apply();
+  }
+
+  void OGLRenderContext::SetState(OGLBlendCommand const& iCmd)
+  {
+    iCmd.Apply();
+  }
+
+  void OGLRenderContext::ClearBuffers(bool iClearColor, bool iClearDepth, Vec4 const& iColor, float iDepth)
+  {
+#ifdef EXL_WITH_OGL
+    if (iClearColor)
+    {
+      glClearColor(iColor.x, iColor.y, iColor.z, iColor.w);
+      glClear(GL_COLOR_BUFFER_BIT);
+    }
+    if (iClearDepth)
+    {
+      glClearDepthf(iDepth);
+      glClear(GL_DEPTH_BUFFER_BIT);
+    }
+#endif
+  }
+
   void OGLRenderContext::Draw(OGLConnectivity iTopo, uint32_t iFirstVertex, uint32_t iNumVertices)
   {
 #ifdef EXL_WITH_OGL
@@ -499,6 +539,7 @@ namespace eXl
       glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,0);
     }
 
+    ++m_NumDraws;
     glDrawArrays(GetGLConnectivity(iTopo), iFirstVertex, iNumVertices);
 #endif
   }
@@ -518,6 +559,7 @@ namespace eXl
       glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,iBuffer->GetBufferId());
     }
 
+    ++m_NumDraws;
     glDrawElementsBaseVertex(GetGLConnectivity(iTopo), iNumIndices, GL_UNSIGNED_INT, ((uint8_t*)0) + iOffset, iBaseVertex);
 #endif
   }
@@ -534,6 +576,7 @@ namespace eXl
       m_Impl->m_CurrentIndexBuffer = nullptr;
       glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
     }
+    ++m_NumDraws;
 #ifndef __ANDROID__
     glDrawArraysInstancedBaseInstance(GetGLConnectivity(iTopo), iFirstVertex, iNumVertices, iNumInstances, iBaseInstance);
 #else
@@ -560,6 +603,7 @@ namespace eXl
       m_Impl->m_CurrentIndexBuffer = iBuffer;
       glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, iBuffer->GetBufferId());
     }
+    ++m_NumDraws;
 #ifndef __ANDROID__
     glDrawElementsInstancedBaseVertexBaseInstance(GetGLConnectivity(iTopo), iNumIndices, GL_UNSIGNED_INT, ((uint8_t*)0) + iOffset, iNumInstances, iBaseVertex, iBaseinstance);
 #else
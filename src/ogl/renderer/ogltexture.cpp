@@ -13,6 +13,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <ogl/renderer/ogltypesconv.hpp>
 #include <ogl/renderer/oglinclude.hpp>
 #include <ogl/renderer/oglbuffer.hpp>
+#include <ogl/oglutils.hpp>
 
 #include <core/log.hpp>
 
@@ -49,6 +50,10 @@ namespace eXl
   {
 #ifdef EXL_WITH_OGL
     eXl_ASSERT_REPAIR_RET(m_TextureType != OGLTextureType::TEXTURE_BUFFER || m_Buffer != nullptr, void());
+    if (OGLUtils::IsHeadless())
+    {
+      return;
+    }
     
     if (m_TexId != 0)
     {
@@ -49,7 +49,7 @@ namespace eXl
   {
     OGLTexture* res = nullptr;
 #ifdef EXL_WITH_OGL
-    if(iSize.x > 0 && iSize.y > 0)
+    if(iSize.x > 0 && iSize.y > 0 && !OGLUtils::IsHeadless())
     {
       GLuint texId;
       glGenTextures(1, &texId);
@@ -141,6 +141,11 @@ namespace eXl
       res->m_TexId = texId;
     }
 #endif
+    // In headless mode, textures are opaque handles.
+    if (iSize.x > 0 && iSize.y > 0 && OGLUtils::IsHeadless())
+    {
+      res = eXl_NEW OGLTexture(iSize, OGLTextureType::TEXTURE_2D, OGLInternalTextureFormat::RGBA);
+    }
     return res;
   }
 
@@ -235,8 +240,12 @@ namespace eXl
     UpdateFromImage(*iImage, GL_TEXTURE_2D, newTex->GetAPIHandle(), false, -1);
 
     return newTex;
+#else
+    if (iImage == nullptr)
+      return nullptr;
+
+    return eXl_NEW OGLTexture(iImage->GetSize(), OGLTextureType::TEXTURE_2D, OGLInternalTextureFormat::RGBA);
 #endif
-    return nullptr;
   }
 
   OGLTexture* OGLTextureLoader::CreateCubeMap(Image const* const* iImage, bool iGenMipMap)